@@ -30,6 +30,8 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Added the IMAGE_PIXEL_STATISTICS summary, recorded in a private PNG chunk.
 //	*[1] 04/16/2024 by Tom Atwood
 //		Restored calibration data byte packing from 8 to 1.
 //
@@ -120,6 +122,28 @@ typedef struct
 	void					*pVOI_LUTData;				// Pointer to a memory buffer containing the LUT data.
 	} IMAGE_CALIBRATION_INFO;
 
+
+// *[2] This structure summarizes the image pixel values.  BRetriever accumulates it as the image rows
+// are written to the PNG file, and records it in a private ancillary PNG chunk following the image
+// data.  This lets BViewer avoid scanning every pixel when the image is loaded.  PNG readers that
+// don't recognize the chunk skip it.  Files from earlier BRetriever versions don't have this chunk.
+//
+// The chunk data are recorded in network byte order:
+//		Version (2 bytes), PixelBitsSet (2 bytes), nPixelsCounted (4 bytes), MinPixelValue (2 bytes),
+//		MaxPixelValue (2 bytes), and the sum of the pixel values (8 bytes, upper 4 bytes first).
+#define IMAGE_PIXEL_STATISTICS_CHUNK_NAME			"bvSt"
+#define IMAGE_PIXEL_STATISTICS_CHUNK_VERSION		1
+#define IMAGE_PIXEL_STATISTICS_CHUNK_LENGTH			20
+
+typedef struct
+	{
+	unsigned long			nPixelsCounted;			// Zero if no statistics were collected, such as for a color image.
+	unsigned short			MinPixelValue;			// The pixel values are as recorded in the PNG image,
+	unsigned short			MaxPixelValue;			// without any photometric inversion.
+	unsigned short			PixelBitsSet;			// The bitwise OR of all the pixel values.
+	double					MeanPixelValue;
+	} IMAGE_PIXEL_STATISTICS;
+
 #pragma pack(pop)
 
 
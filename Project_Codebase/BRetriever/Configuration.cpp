@@ -28,6 +28,10 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		Added the PACK DICOM IMAGE ARCHIVE and COMPRESS DICOM IMAGE ARCHIVE settings.
+//	*[2] 10/19/2026 by agent
+//		Added the Send Image operation and the Network Dicom Destination endpoint.
 //	*[1] 03/12/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -44,6 +48,7 @@ extern unsigned __stdcall ListenForExamThreadFunction( void *pOperationStruct );
 extern unsigned __stdcall ReceiveDicomThreadFunction( VOID *pOperationStruct );
 extern unsigned __stdcall WatchForExamThreadFunction( VOID *pOperationStruct );
 extern unsigned __stdcall ProcessProductQueueThreadFunction( VOID *pOperationStruct );
+extern unsigned __stdcall SendImagesThreadFunction( void *pOperationStruct );		// *[2]
 
 
 PRODUCT_OPERATION				*pPrimaryOperationList = 0;
@@ -163,6 +168,21 @@ ENDPOINT EndPointImageDeposit =
 	};
 
 
+// *[2] The network destination to which processed images are forwarded.  The directory
+// holds the images waiting to be sent.
+ENDPOINT EndPointNetworkOut =
+	{
+	"Network Dicom Destination",			// Name[ MAX_CFG_STRING_LENGTH ].
+	ENDPOINT_TYPE_NETWORK,					// EndPointType.
+	"",										// NetworkAddress[ MAX_CFG_STRING_LENGTH ].
+	"",										// AE_TITLE[ MAX_CFG_STRING_LENGTH ].
+	"Forwarding Queue",						// Directory[ MAX_CFG_STRING_LENGTH ].
+	TRUE,									// bTrustSpecifiedTransferSyntax.
+	FALSE,									// bApplyManualDicomEdits.
+	0										// *pNextEndPoint.
+	};
+
+
 ENDPOINT	*pEndPointPrototypeArray[] =
 	{
 	&EndPointWatchFolder,
@@ -170,6 +190,7 @@ ENDPOINT	*pEndPointPrototypeArray[] =
 	&EndPointInbox,
 	&EndPointQueue,
 	&EndPointImageDeposit,
+	&EndPointNetworkOut,					// *[2]
 	0
 	};
 
@@ -279,12 +300,40 @@ PRODUCT_OPERATION OperationProcessImage =
 	};
 
 
+// *[2] This operation is disabled unless a destination is configured.
+PRODUCT_OPERATION OperationSendImage =
+	{
+	"Send Image",							// Operation Name[ MAX_FILE_SPEC_LENGTH ].
+	OPERATION_TYPE_SEND_OVER_NETWORK,		// OperationType.
+	10,										// OperationTimeInterval.
+	&EndPointQueue,							// *pInputEndPoint.
+	FALSE,									// bInputDeleteSourceOnCompletion.
+	&EndPointNetworkOut,					// *pOutputEndPoint.
+	FALSE,									// bEnabled.
+	"",										// DependentOperationName[ MAX_CFG_STRING_LENGTH ].
+	0,										// *pDependentOperation.
+	0,										// *pNextOperation.
+		{									// OpnState.
+		OPERATION_STATUS_UNKNOWN,				// StatusCode.
+		0,										// DirectorySearchLevel.
+		0,										// *pProductItem.
+		TRUE,									// bOKtoProcessThisStudy.
+		0,										// hOperationThreadHandle.
+		0,										// OperationThreadID.
+		SendImagesThreadFunction,				// ThreadFunction.
+		0,										// hSleepSemaphore.
+		""										// SleepSemaphoreName[ MAX_CFG_STRING_LENGTH ].
+		}
+	};
+
+
 PRODUCT_OPERATION	*pProductOperationPrototypeArray[] =
 	{
 	&OperationWatch,
 	&OperationListen,
 	&OperationReceive,
 	&OperationProcessImage,
+	&OperationSendImage,					// *[2]
 	0
 	};
 
@@ -623,6 +672,8 @@ void InitConfiguration()
 	ServiceConfiguration.bEnableSurvey = FALSE;
 	ServiceConfiguration.bComposeDicomOutputFile = FALSE;
 	ServiceConfiguration.bApplyManualDicomEdits = FALSE;
+	ServiceConfiguration.bPackDicomImageArchive = FALSE;					// *[3]
+	ServiceConfiguration.bCompressDicomImageArchive = FALSE;				// *[3]
 }
 
 
@@ -744,6 +795,20 @@ BOOL ParseConfigurationLine( char *pTextLine )
 				else
 					ServiceConfiguration.bApplyManualDicomEdits = FALSE;
 				}
+			else if ( _stricmp( pAttributeName, "PACK DICOM IMAGE ARCHIVE" ) == 0 )			// *[3]
+				{
+				if ( _stricmp( pAttributeValue, "YES" ) == 0 )
+					ServiceConfiguration.bPackDicomImageArchive = TRUE;
+				else
+					ServiceConfiguration.bPackDicomImageArchive = FALSE;
+				}
+			else if ( _stricmp( pAttributeName, "COMPRESS DICOM IMAGE ARCHIVE" ) == 0 )		// *[3]
+				{
+				if ( _stricmp( pAttributeValue, "YES" ) == 0 )
+					ServiceConfiguration.bCompressDicomImageArchive = TRUE;
+				else
+					ServiceConfiguration.bCompressDicomImageArchive = FALSE;
+				}
 			else if ( _stricmp( pAttributeName, "ENABLE SURVEY" ) == 0 )
 				{
 				if ( _stricmp( pAttributeValue, "YES" ) == 0 )
@@ -946,7 +1011,8 @@ void EraseProductOperationList()
 		pPrevProductOperation = pProductOperation;
 		pProductOperation = pProductOperation -> pNextOperation;
 		// Don't deallocate the hard-coded operation structures.
-		if ( pPrevProductOperation != &OperationWatch && pPrevProductOperation != &OperationListen && pPrevProductOperation != &OperationReceive )
+		if ( pPrevProductOperation != &OperationWatch && pPrevProductOperation != &OperationListen && pPrevProductOperation != &OperationReceive &&
+					pPrevProductOperation != &OperationSendImage )		// *[2]
 			free( pPrevProductOperation );
 		}
 	pPrimaryOperationList = 0;
@@ -29,6 +29,8 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Added the file reception time to the product queue item.
 //	*[1] 03/29/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -82,6 +84,7 @@ typedef struct
 	void						*pParentProduct;						// Only valid if PRODUCT_STATUS_STUDY is NOT set.
 	time_t						ArrivalTime;
 	time_t						LatestActivityTime;
+	FILETIME					ReceptionTime;							// *[2] When the image file was last written into the watch folder.
 	void						*pProductOperation;
 	void						*pProductInfo;							// Pointer to structure of type EXAM_INFO, DICTATION_INFO, etc.
 	} PRODUCT_QUEUE_ITEM;
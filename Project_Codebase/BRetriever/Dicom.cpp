@@ -29,6 +29,49 @@
 //
 // UPDATE HISTORY:
 //
+//	*[11] 10/19/2026 by agent
+//		The decompressed overlay image of an EDIT_ADD_IMAGE_OVERLAY edit is kept for the next
+//		Dicom output file, and is only read and decompressed again when the overlay image file
+//		specification, modification time or size changes.
+//	*[10] 10/19/2026 by agent
+//		ComposeDicomFileOutput() reallocated a shorter transfer syntax identifier one byte
+//		short of the uncompressed identifier, and copied the new identifier truncated to the
+//		length of the old one.
+//	*[9] 10/19/2026 by agent
+//		The extended image survey records are written to ImageSurvey2.txt, so that an
+//		existing ImageSurvey.txt file keeps a single column layout under its heading line.
+//	*[8] 10/19/2026 by agent
+//		The count of unparsed bytes remaining in the input buffer list is kept with each
+//		buffer, instead of being totaled for every element value.  The element returned by
+//		a failed ParseDicomElement() call is no longer examined, and is freed if it isn't
+//		linked to the element list.  Missing transfer syntax and patient name values are
+//		checked for, a person name is only loaded from a PN element, every converted value
+//		is terminated, and the blank log lines in LogDicomElement() are terminated.
+//	*[7] 10/19/2026 by agent
+//		ComposeDicomFileOutput() uses the compiled edit specifications, which are only
+//		read again when the edit specification file changes.  The edit for each Dicom
+//		element is located through the tag index, and the edited values are applied in
+//		their pre-encoded forms.
+//	*[6] 10/19/2026 by agent
+//		If PACK DICOM IMAGE ARCHIVE is configured, ArchiveDicomImageFile() appends the
+//		Dicom image file to its study's pack file in the archive directory, instead of
+//		copying it to a separate file.
+//	*[5] 10/19/2026 by agent
+//		ComposeDicomFileOutput() now streams the composed elements to the output
+//		file through a single buffered stream.  The pixel data is written directly
+//		from the image buffer instead of first being copied into the output buffer list.
+//	*[4] 10/19/2026 by agent
+//		Hardened the element parser against malformed input:  Element value lengths
+//		are checked against the data remaining in the buffer list before the value
+//		buffer is allocated, numeric values shorter than their value representation
+//		are not converted to text, and the transfer syntax test no longer reads
+//		beyond the end of a short buffer.  Fixed the truncation of the "AutoLoad_"
+//		SOP instance UID prefix.
+//	*[3] 10/19/2026 by agent
+//		Extended the image survey record with the transfer syntax, the parsed element
+//		count and the image data length, so that the survey file can serve as a
+//		record of expected parse results for a reference set of image files.
+//		Guarded against missing image dimension elements.
 //	*[2] 03/04/2024 by Tom Atwood
 //		Fixed security issues.
 //	*[1] 12/15/2022 by Tom Atwood
@@ -37,6 +80,8 @@
 //
 #include "Module.h"
 #include <stddef.h>
+#include <sys/types.h>		// *[11]
+#include <sys/stat.h>		// *[11]
 #include "ReportStatus.h"
 #include "ServiceMain.h"
 #include "Dicom.h"
@@ -47,6 +92,7 @@
 #include "ProductDispatcher.h"
 #include "ExamEdit.h"
 #include "ExamReformat.h"
+#include "DicomArchive.h"		// *[6]
 
 
 //___________________________________________________________________________
@@ -91,7 +137,25 @@ extern CONFIGURATION				ServiceConfiguration;
 
 static TRANSFER_SYNTAX				LocalMemoryByteOrder;
 
+// *[11] The decompressed overlay image, kept from one Dicom output file to the next.
+typedef struct
+	{
+	char					FileSpec[ MAX_CFG_STRING_LENGTH ];
+	unsigned long			nFileBytes;					// The number of bytes the edit specification reads from the file.
+	__time64_t				ModificationTime;
+	__int64					FileSize;
+	unsigned long			ImageWidthInPixels;
+	unsigned long			ImageHeightInPixels;
+	char					*pImageData;
+	} OVERLAY_IMAGE_CACHE;
+
+static OVERLAY_IMAGE_CACHE			CachedOverlayImage = { "", 0, 0, 0, 0, 0, 0 };
+
 static void							SwapBytesFromFile( void *pData, long nValueSize, TRANSFER_SYNTAX TransferSyntax );
+static unsigned long				GetRemainingBufferBytes( LIST_ELEMENT *pBufferListElement );		// *[4]
+static void							CountInputBufferBytes( LIST_ELEMENT *pBufferListElement );			// *[8]
+static BOOL							FlushOutputBuffersToFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputFile );		// *[5]
+static void							DeleteCachedOverlayImage();																// *[11]
 
 // This function must be called before any other function in this module.
 void InitDicomModule()
@@ -104,6 +168,7 @@ void InitDicomModule()
 void CloseDicomModule()
 {
 	DeallocateDicomDictionary();
+	DeleteCachedOverlayImage();			// *[11]
 }
 
 
@@ -271,6 +336,9 @@ BOOL LoadDicomHeaderElement( DICOM_ELEMENT *pDicomElement, DICOM_HEADER_SUMMARY
 
 			DataLoadingType = pDicomElementInfo -> DataLoadingType;
 			DataOffset = pDicomElementInfo -> DataStructureOffset;
+			// A person name is only loaded from a PN element, which is converted to a PERSON_NAME structure.
+			if ( ( DataLoadingType & DATA_LOADING_TYPE_NAME ) != 0 && pDicomElement -> ValueRepresentation != PN )		// *[8]
+				DataLoadingType = 0;																						// *[8]
 			if ( ( DataLoadingType & ( DATA_LOADING_TYPE_TEXT | DATA_LOADING_TYPE_NAME | DATA_LOADING_TYPE_INT | DATA_LOADING_TYPE_FLOAT ) ) != 0 )
 				{
 				// Point to the location in the data structure.
@@ -278,7 +346,7 @@ BOOL LoadDicomHeaderElement( DICOM_ELEMENT *pDicomElement, DICOM_HEADER_SUMMARY
 				// Copy the allocated character string buffer pointer into the data structure.
 				*ppTextDataValue = pDicomElement -> pConvertedValue;
 				}
-			if ( ( DataLoadingType & DATA_LOADING_TYPE_CALIBR ) != 0 )
+			if ( ( DataLoadingType & DATA_LOADING_TYPE_CALIBR ) != 0 && pDicomElement -> pConvertedValue != 0 )	// *[8] Added value check.
 				{
 				LoadImageCalibrationData( pDicomElement, pDicomHeader );
 				}
@@ -330,6 +398,8 @@ void LogDicomElement( DICOM_ELEMENT *pDicomElement, long SequenceNestingLevel )
 
 	memset( TextLine, ' ', MAX_LOGGING_STRING_LENGTH );
 	memset( SummaryTextLine, ' ', MAX_LOGGING_STRING_LENGTH );
+	TextLine[ MAX_LOGGING_STRING_LENGTH - 1 ] = '\0';											// *[8] Terminate the blank lines for the strlen() checks below.
+	SummaryTextLine[ MAX_LOGGING_STRING_LENGTH - 1 ] = '\0';									// *[8]
 	nCharEOL = 0;
 	nCharSummaryEOL = 0;
 		
@@ -606,8 +676,11 @@ BOOL CheckForRequiredDicomElements( DICOM_HEADER_SUMMARY *pDicomHeader )
 			UserNoticeDescriptor.TypeOfUserResponseSupported = USER_RESPONSE_TYPE_ERROR | USER_RESPONSE_TYPE_CONTINUE;
 			UserNoticeDescriptor.UserNotificationCause = USER_NOTIFICATION_CAUSE_PRODUCT_PROCESSING_ERROR;
 			UserNoticeDescriptor.UserResponseCode = 0L;
-			_snprintf_s( UserNoticeDescriptor.NoticeText, MAX_FILE_SPEC_LENGTH, _TRUNCATE,							// *[2] Replaced sprintf() with _snprintf_s.
+			if ( pDicomHeader -> PatientName != 0 )																	// *[8] Added null check.
+				_snprintf_s( UserNoticeDescriptor.NoticeText, MAX_FILE_SPEC_LENGTH, _TRUNCATE,						// *[2] Replaced sprintf() with _snprintf_s.
 							"The image file for \n\n%s, %s\n\ncould not be processed.", pDicomHeader -> PatientName -> pLastName, pDicomHeader -> PatientName -> pFirstName );
+			else
+				_snprintf_s( UserNoticeDescriptor.NoticeText, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "An image file could not be processed." );
 			strncpy_s( UserNoticeDescriptor.SuggestedActionText,
 						MAX_CFG_STRING_LENGTH, "It is missing the required Dicom data element:\n", _TRUNCATE );		// *[2] Replaced strcpy with strncpy_s.
 			strncat_s( UserNoticeDescriptor.SuggestedActionText
@@ -701,10 +774,15 @@ BOOL CopyBytesFromBuffer( char *pDestinationAddress, unsigned long nBytesNeeded,
 	char					*pBufferReadPoint;
 
 	pBufferListElement = *ppBufferListElement;
-	pDicomBuffer = (DICOM_DATA_BUFFER*)pBufferListElement -> pItem;
-	nBufferBytesProcessed = pDicomBuffer -> DataSize - pDicomBuffer -> BytesRemainingToBeProcessed;
-	pBufferReadPoint = pDicomBuffer -> pBeginningOfDicomData + nBufferBytesProcessed;
-	do
+	if ( pBufferListElement == 0 )									// *[4] The end of the buffer list was already reached.
+		bNoError = FALSE;
+	else
+		{
+		pDicomBuffer = (DICOM_DATA_BUFFER*)pBufferListElement -> pItem;
+		nBufferBytesProcessed = pDicomBuffer -> DataSize - pDicomBuffer -> BytesRemainingToBeProcessed;
+		pBufferReadPoint = pDicomBuffer -> pBeginningOfDicomData + nBufferBytesProcessed;
+		}
+	while ( nBytesNeeded > 0 && bNoError )							// *[4] Changed from do-while to while.
 		{
 		// If the remaining bytes to be copied would exceed the remaining destination buffer size...
 		if ( pDicomBuffer -> BytesRemainingToBeProcessed >= nBytesNeeded )
@@ -737,12 +815,62 @@ BOOL CopyBytesFromBuffer( char *pDestinationAddress, unsigned long nBytesNeeded,
 				}
 			}
 		}
-	while ( nBytesNeeded > 0 && bNoError );
 
 	return bNoError;
 }
 
 
+// *[8] Record with each input buffer the number of data bytes in all the buffers following it.
+// The buffers following the current one are never partly parsed, so this count, together
+// with the bytes remaining in the current buffer, gives the unparsed bytes remaining in the list.
+static void CountInputBufferBytes( LIST_ELEMENT *pBufferListElement )
+{
+	DICOM_DATA_BUFFER		*pDicomBuffer;
+	LIST_ELEMENT			*pListElement;
+	unsigned long			nBytesFollowing;
+
+	nBytesFollowing = 0L;
+	pListElement = pBufferListElement;
+	while ( pListElement != 0 )
+		{
+		pDicomBuffer = (DICOM_DATA_BUFFER*)pListElement -> pItem;
+		if ( pDicomBuffer != 0 )
+			nBytesFollowing += pDicomBuffer -> DataSize;
+		pListElement = pListElement -> pNextListElement;
+		}
+	pListElement = pBufferListElement;
+	while ( pListElement != 0 )
+		{
+		pDicomBuffer = (DICOM_DATA_BUFFER*)pListElement -> pItem;
+		if ( pDicomBuffer != 0 )
+			{
+			nBytesFollowing -= pDicomBuffer -> DataSize;
+			pDicomBuffer -> BytesInFollowingBuffers = nBytesFollowing;
+			}
+		pListElement = pListElement -> pNextListElement;
+		}
+}
+
+
+// *[4] Count the bytes not yet parsed in the current buffer and in all the buffers following it.
+// *[8] Use the count recorded by CountInputBufferBytes(), instead of walking the rest of the list.
+static unsigned long GetRemainingBufferBytes( LIST_ELEMENT *pBufferListElement )
+{
+	DICOM_DATA_BUFFER		*pDicomBuffer;
+	unsigned long			nBytesRemaining;
+
+	nBytesRemaining = 0L;
+	if ( pBufferListElement != 0 )
+		{
+		pDicomBuffer = (DICOM_DATA_BUFFER*)pBufferListElement -> pItem;
+		if ( pDicomBuffer != 0 )
+			nBytesRemaining = pDicomBuffer -> BytesRemainingToBeProcessed + pDicomBuffer -> BytesInFollowingBuffers;
+		}
+
+	return nBytesRemaining;
+}
+
+
 void ResetOutputBufferCursors( DICOM_HEADER_SUMMARY *pDicomHeader )
 {
 	DICOM_DATA_BUFFER		*pDicomBuffer;
@@ -824,6 +952,7 @@ BOOL CopyBytesToBuffer( char *pSourceAddress, unsigned long nBytesNeeded, unsign
 				pDicomBuffer -> BufferSize = MAX_DICOM_READ_BUFFER_SIZE;
 				pDicomBuffer -> DataSize = 0L;
 				pDicomBuffer -> BytesRemainingToBeProcessed = MAX_DICOM_READ_BUFFER_SIZE;
+				pDicomBuffer -> BytesInFollowingBuffers = 0L;									// *[8]
 				// Link the new buffer to the list.
 				pNewBufferListElement -> pNextListElement = 0;
 				pNewBufferListElement -> pItem = (void*)pDicomBuffer;
@@ -900,6 +1029,63 @@ void DeallocateInputBuffers( DICOM_HEADER_SUMMARY *pDicomHeader )
 }
 
 
+// *[5] Write the composed contents of the output buffer list to the file, then release
+// all but the first buffer and reset it to receive further composed output.
+static BOOL FlushOutputBuffersToFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputFile )
+{
+	BOOL					bNoError = TRUE;
+	LIST_ELEMENT			*pBufferListElement;
+	LIST_ELEMENT			*pPrevBufferListElement;
+	DICOM_DATA_BUFFER		*pDicomBuffer;
+	size_t					nBytesWritten;
+
+	pBufferListElement = pDicomHeader -> ListOfOutputBuffers;
+	while ( bNoError && pBufferListElement != 0 )
+		{
+		pDicomBuffer = (DICOM_DATA_BUFFER*)pBufferListElement -> pItem;
+		if ( pDicomBuffer != 0 && pDicomBuffer -> pBuffer != 0 && pDicomBuffer -> DataSize > 0 )
+			{
+			nBytesWritten = fwrite( pDicomBuffer -> pBuffer, 1, (size_t)pDicomBuffer -> DataSize, pOutputFile );
+			if ( nBytesWritten != (size_t)pDicomBuffer -> DataSize )
+				{
+				bNoError = FALSE;
+				RespondToError( MODULE_DICOM, DICOM_ERROR_DICOM_STORE_WRITE );
+				}
+			}
+		pBufferListElement = pBufferListElement -> pNextListElement;
+		}
+	pBufferListElement = pDicomHeader -> ListOfOutputBuffers;
+	if ( pBufferListElement != 0 )
+		{
+		// Release the overflow buffers.
+		pBufferListElement = pBufferListElement -> pNextListElement;
+		while ( pBufferListElement != 0 )
+			{
+			pPrevBufferListElement = pBufferListElement;
+			pDicomBuffer = (DICOM_DATA_BUFFER*)pBufferListElement -> pItem;
+			if ( pDicomBuffer != 0 )
+				{
+				if ( pDicomBuffer -> pBuffer != 0 )
+					free( pDicomBuffer -> pBuffer );
+				free( pDicomBuffer );
+				}
+			pBufferListElement = pBufferListElement -> pNextListElement;
+			free( pPrevBufferListElement );
+			}
+		pBufferListElement = pDicomHeader -> ListOfOutputBuffers;
+		pBufferListElement -> pNextListElement = 0;
+		pDicomBuffer = (DICOM_DATA_BUFFER*)pBufferListElement -> pItem;
+		if ( pDicomBuffer != 0 )
+			{
+			pDicomBuffer -> DataSize = 0L;
+			pDicomBuffer -> BytesRemainingToBeProcessed = pDicomBuffer -> BufferSize;
+			}
+		}
+
+	return bNoError;
+}
+
+
 void DeallocateOutputBuffers( DICOM_HEADER_SUMMARY *pDicomHeader )
 {
 	LIST_ELEMENT			*pBufferListElement;
@@ -979,7 +1165,7 @@ void DeallocateListOfDicomElements( DICOM_HEADER_SUMMARY *pDicomHeader )
 				}
 			else if ( pDicomElement -> Tag.Group == 0x7fe0 )
 				{
-				free( pDicomElement );
+				DeallocateDicomElement( pDicomElement );			// *[8] An element in a damaged image group can have a value buffer.
 				pDicomElementListElement -> pItem = 0;
 				}
 			}
@@ -1073,6 +1259,7 @@ BOOL ReadDicomHeaderInfo( char *DicomFileSpecification, EXAM_INFO *pExamInfo, DI
 			pDicomBuffer -> BufferSize = MAX_DICOM_READ_BUFFER_SIZE;
 			pDicomBuffer -> DataSize = (unsigned long)nBytesRead;																// *[2] Cast to eliminate sign type mismatch.
 			pDicomBuffer -> BytesRemainingToBeProcessed = (unsigned long)nBytesRead;											// *[2] Cast to eliminate sign type mismatch.
+			pDicomBuffer -> BytesInFollowingBuffers = 0L;																		// *[8]
 			if ( nBytesRead != MAX_DICOM_READ_BUFFER_SIZE )
 				{
 				if ( feof( pDicomFile ) )
@@ -1181,6 +1368,8 @@ BOOL ParseDicomGroup2Info( LIST_ELEMENT **ppBufferListElement, DICOM_HEADER_SUMM
 	CurrentTransferSyntax = pDicomHeader -> FileDecodingPlan.FileMetadataTransferSyntax;
 	if ( !pDicomHeader -> FileDecodingPlan.bTrustSpecifiedTransferSyntaxFromLocalStorage )
 		CurrentTransferSyntax = GetConsistentTransferSyntax( CurrentTransferSyntax, ppBufferListElement );
+	// The input buffer list is complete.  Record the data remaining after each buffer.
+	CountInputBufferBytes( *ppBufferListElement );															// *[8]
 
 	nBytesParsed = 0;
 	while ( bNoError && bMoreDicomElementsRemainInSequence )
@@ -1189,7 +1378,7 @@ BOOL ParseDicomGroup2Info( LIST_ELEMENT **ppBufferListElement, DICOM_HEADER_SUMM
 		// Allocate a DICOM_ELEMENT structure, append it to the list and read all the info about the next Dicom element except the value.
 		bNoError = ParseDicomElement( ppBufferListElement, &pDicomElement, &nBytesParsed,
 							CurrentTransferSyntax, SequenceNestingLevel, pDicomHeader );
-		if ( pDicomElement -> Tag.Group > 0x0002 )
+		if ( bNoError && pDicomElement -> Tag.Group > 0x0002 )													// *[8] Added error check.
 			bMoreDicomElementsRemainInSequence = FALSE;
 		if ( bNoError && bMoreDicomElementsRemainInSequence )
 			{
@@ -1210,15 +1399,22 @@ BOOL ParseDicomGroup2Info( LIST_ELEMENT **ppBufferListElement, DICOM_HEADER_SUMM
 					}
 				}
 			}
-		else if ( !bMoreDicomElementsRemainInSequence )
-			RestoreBufferCursor( ppBufferListElement, &pSavedBufferListElement, &nSavedBufferBytesRemainingToBeProcessed );
+		else
+			{
+			DeallocateDicomElement( pDicomElement );															// *[8] Free the unlinked element.
+			if ( !bMoreDicomElementsRemainInSequence )
+				RestoreBufferCursor( ppBufferListElement, &pSavedBufferListElement, &nSavedBufferBytesRemainingToBeProcessed );
+			}
 		}			// ...end while group 2 data elements remain to be read.
 
 	if ( bNoError )
 		{
 		// Set up the Dicom file decoding plan:
-		pDicomHeader -> FileDecodingPlan.nTransferSyntaxIndex = GetTransferSyntaxIndex( pDicomHeader -> TransferSyntaxUniqueIdentifier,
+		if ( pDicomHeader -> TransferSyntaxUniqueIdentifier != 0 )												// *[8] Added null check.
+			pDicomHeader -> FileDecodingPlan.nTransferSyntaxIndex = GetTransferSyntaxIndex( pDicomHeader -> TransferSyntaxUniqueIdentifier,
 												(unsigned short)strlen( pDicomHeader -> TransferSyntaxUniqueIdentifier ) );
+		else
+			pDicomHeader -> FileDecodingPlan.nTransferSyntaxIndex = NUMBER_OF_TRANSFER_SYNTAX_IDS;
 		CurrentTransferSyntax = GetTransferSyntaxForDicomElementParsing( (char)pDicomHeader -> FileDecodingPlan.nTransferSyntaxIndex );
 		if ( pDicomHeader -> FileDecodingPlan.bTrustSpecifiedTransferSyntaxFromLocalStorage )
 			{
@@ -1347,22 +1543,27 @@ BOOL ProcessDicomElementSequence( LIST_ELEMENT **ppBufferListElement, unsigned l
 			// Read all the info about the next Dicom element except the value.
 			bNoError = ParseDicomElement( ppBufferListElement, &pDicomElement, &nBytesParsed,
 								CurrentTransferSyntax, (unsigned char)*pNestingLevel, pDicomHeader );
-			
-			// If the group number is odd, this is a private data sequence.
-			bPrivateData = ( ( pDicomElement -> Tag.Group & 0x0001 ) != 0 );
-			if ( !bPrivateData || PrevGroupNumber != pDicomElement -> Tag.Group )
-				{
-				// Arm the flag to be looking for the first private data element in this sequence.
-				bFirstPrivateElementInSequence = TRUE;
-				}
-			if ( pDicomElement -> Tag.Group == 0x7fe0 && pDicomElement -> Tag.Element == 0x0010 && !bSequenceIsPrivateData )
+			if ( bNoError )																						// *[8] Added error check.
 				{
-				LogDicomElement( pDicomElement, *pNestingLevel );
-				bMoreDicomElementsRemainInSequence = FALSE;
-				*pbTerminateSequence = TRUE;
-				pDicomHeader -> pBufferElementWithImageStart = *ppBufferListElement;
-				RestoreBufferCursor( ppBufferListElement, &pSavedBufferListElement, &nSavedBufferBytesRemainingToBeProcessed );
+				// If the group number is odd, this is a private data sequence.
+				bPrivateData = ( ( pDicomElement -> Tag.Group & 0x0001 ) != 0 );
+				if ( !bPrivateData || PrevGroupNumber != pDicomElement -> Tag.Group )
+					{
+					// Arm the flag to be looking for the first private data element in this sequence.
+					bFirstPrivateElementInSequence = TRUE;
+					}
+				if ( pDicomElement -> Tag.Group == 0x7fe0 && pDicomElement -> Tag.Element == 0x0010 && !bSequenceIsPrivateData )
+					{
+					LogDicomElement( pDicomElement, *pNestingLevel );
+					bMoreDicomElementsRemainInSequence = FALSE;
+					*pbTerminateSequence = TRUE;
+					pDicomHeader -> pBufferElementWithImageStart = *ppBufferListElement;
+					RestoreBufferCursor( ppBufferListElement, &pSavedBufferListElement, &nSavedBufferBytesRemainingToBeProcessed );
+					DeallocateDicomElement( pDicomElement );													// *[8] It is parsed again later.
+					}
 				}
+			else
+				DeallocateDicomElement( pDicomElement );														// *[8] Free the unlinked element.
 			}
 		if ( bNoError && bMoreDicomElementsRemainInSequence )
 			{
@@ -1484,8 +1685,8 @@ BOOL ProcessDicomElementSequence( LIST_ELEMENT **ppBufferListElement, unsigned l
 				bMoreDicomElementsRemainInSequence = FALSE;
 				*pbTerminateSequence = TRUE;
 				}
+			PrevGroupNumber = pDicomElement -> Tag.Group;				// *[8] Moved here, where the element is known to be valid.
 			}
-		PrevGroupNumber = pDicomElement -> Tag.Group;
 		}
 	*pnBytesParsed += nBytesParsed;
 
@@ -1519,10 +1720,12 @@ BOOL ProcessDicomImageDataElements( LIST_ELEMENT **ppBufferListElement, DICOM_HE
 							CurrentTransferSyntax, SequenceNestingLevel, pDicomHeader );
 	if ( bNoError )
 		bNoError = AppendToList( &pDicomHeader -> ListOfDicomElements, (void*)pDicomElement );
+	else
+		DeallocateDicomElement( pDicomElement );															// *[8] Free the unlinked element.
 
 	nBytesInImageItem = 0L;
 	nBytesParsed = 0;
-	if ( pDicomElement -> Tag.Group == 0x7fe0 && pDicomElement -> Tag.Element == 0x0010 )
+	if ( bNoError && pDicomElement -> Tag.Group == 0x7fe0 && pDicomElement -> Tag.Element == 0x0010 )		// *[8] Added error check.
 		{
 		// This is the pixel data element.  Commence the isolation of the pixel data stream.
 		if ( pDicomElement -> ValueLength != VALUE_LENGTH_UNDEFINED )
@@ -1532,6 +1735,8 @@ BOOL ProcessDicomImageDataElements( LIST_ELEMENT **ppBufferListElement, DICOM_HE
 			// Read the Basic Offset Table, if any.
 			bNoError = ParseDicomElement( ppBufferListElement, &pDicomElement, &nBytesParsed,
 								CurrentTransferSyntax, SequenceNestingLevel, pDicomHeader );
+			if ( !bNoError )
+				DeallocateDicomElement( pDicomElement );														// *[8] Free the unlinked element.
 			if ( bNoError )
 				{
 				bNoError = AppendToList( &pDicomHeader -> ListOfDicomElements, (void*)pDicomElement );
@@ -1569,6 +1774,8 @@ BOOL ProcessDicomImageDataElements( LIST_ELEMENT **ppBufferListElement, DICOM_HE
 									CurrentTransferSyntax, SequenceNestingLevel, pDicomHeader );
 				if ( bNoError )
 					bNoError = AppendToList( &pDicomHeader -> ListOfDicomElements, (void*)pDicomElement );
+				else
+					DeallocateDicomElement( pDicomElement );													// *[8] Free the unlinked element.
 				if ( bNoError && pDicomElement -> Tag.Group == 0xfffe && pDicomElement -> Tag.Element == 0xe000 )
 					{
 					pDicomElement -> ValueMultiplicity = 1;
@@ -1583,7 +1790,13 @@ BOOL ProcessDicomImageDataElements( LIST_ELEMENT **ppBufferListElement, DICOM_HE
 			}
 		}
 	pDicomHeader -> ImageLengthInBytes = (unsigned long)nBytesInImageItem;
-	if ( pDicomHeader -> ImageLengthInBytes > 0 )
+	if ( bNoError && pDicomHeader -> ImageLengthInBytes > GetRemainingBufferBytes( *ppBufferListElement ) )		// *[4]
+		{
+		bNoError = FALSE;
+		pDicomHeader -> ImageLengthInBytes = 0L;
+		RespondToError( MODULE_DICOM, DICOM_ERROR_PARSING_PAST_END_OF_DATA );
+		}
+	if ( bNoError && pDicomHeader -> ImageLengthInBytes > 0 )															// *[4] Added error check.
 		{
 		pDicomHeader -> pImageData = (char*)malloc( pDicomHeader -> ImageLengthInBytes );
 		if ( pDicomHeader -> pImageData != 0 )
@@ -1651,6 +1864,7 @@ char *AllocateDicomValueBuffer( DICOM_ELEMENT *pDicomElement, DICOM_HEADER_SUMMA
 		if ( pValueBuffer != 0 )
 			{
 			memcpy( pValueBuffer, pValue, nValueSizeInBytes );
+			pValueBuffer[ nValueSizeInBytes ] = '\0';			// *[8] Terminate binary values too, in case a damaged element is read as text.
 			switch( pDicomElement -> ValueRepresentation )
 				{
 				case SS:			// Signed short.
@@ -2048,7 +2262,7 @@ BOOL ParseDicomElement( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT **ppDi
 	if ( !bNoError )
 		RespondToError( MODULE_DICOM, DICOM_ERROR_PARSING_PAST_END_OF_DATA );
 
-	if ( pDicomElement -> Tag.Group == 0x0008 && pDicomElement -> Tag.Element == 0x0008 )
+	if ( pDicomElement != 0 && pDicomElement -> Tag.Group == 0x0008 && pDicomElement -> Tag.Element == 0x0008 )		// *[4] Added null check.
 		bNoError = TRUE;
 	if ( bNoError )
 		{	
@@ -2135,7 +2349,7 @@ BOOL ParseDicomElement( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT **ppDi
 					pDicomElement -> ValueRepresentation = US;
 				break;
 			case ox:
-				if ( *pDicomHeader -> BitsAllocated > 8 )
+				if ( pDicomHeader -> BitsAllocated != 0 && *pDicomHeader -> BitsAllocated > 8 )		// *[4] Added null check.
 					pDicomElement -> ValueRepresentation = OW;
 				else
 					pDicomElement -> ValueRepresentation = OB;
@@ -2178,7 +2392,8 @@ BOOL ParseDicomElement( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT **ppDi
 		if ( ( pDicomElement -> ValueLength & 1 ) != 0 && pDicomElement -> ValueLength != VALUE_LENGTH_UNDEFINED )
 			{
 			// Make an exception for those who don't follow the rules.
-			if ( _strnicmp( pDicomHeader -> ImplementationVersionName, "NovaRad", 7 ) != 0 || ( pDicomHeader -> SourceAE_TITLE != 0 && _strnicmp( pDicomHeader -> SourceAE_TITLE, "novapacs", 7 ) != 0 ) )
+			if ( pDicomHeader -> ImplementationVersionName == 0 || _strnicmp( pDicomHeader -> ImplementationVersionName, "NovaRad", 7 ) != 0 ||		// *[4] Added null check.
+					( pDicomHeader -> SourceAE_TITLE != 0 && _strnicmp( pDicomHeader -> SourceAE_TITLE, "novapacs", 7 ) != 0 ) )
 				{
 				RespondToError( MODULE_DICOM, DICOM_ERROR_UNEVEN_VALUE_LENGTH );
 				_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,				// *[2] Replaced sprintf() with _snprintf_s.
@@ -2209,7 +2424,17 @@ BOOL ParseDicomElementValue( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT *
 	if ( pDicomElement -> ValueRepresentation == UN )
 		pDicomElement -> ValueRepresentation = ValueRepresentationOverride;
 
-	if ( pDicomElement -> ValueRepresentation != SQ &&
+	// *[4] A value length extending beyond the end of the data indicates a corrupted file or data stream.
+	// Catch this before attempting to allocate a value buffer of that size.
+	if ( pDicomElement -> ValueLength != VALUE_LENGTH_UNDEFINED &&
+				pDicomElement -> ValueLength > GetRemainingBufferBytes( *ppBufferListElement ) )
+		{
+		pDicomElement -> Value.UN = 0L;
+		pDicomElement -> ValueLength = 0L;
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOM, DICOM_ERROR_PARSING_PAST_END_OF_DATA );
+		}
+	else if ( pDicomElement -> ValueRepresentation != SQ &&
 			pDicomElement -> ValueLength != VALUE_LENGTH_UNDEFINED )
 		{
 		if ( pDicomElement -> ValueLength == 0 )
@@ -2230,7 +2455,7 @@ BOOL ParseDicomElementValue( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT *
 					{
 					// Prepend the "AutoLoad_" prefix to the SOPInstanceUniqueIdentifier so BViewer will know that
 					// it should process this image as automatically loaded, selected and viewed.
-					strncpy_s( (char*)pDicomElement -> Value.UN, sizeof(void*), "AutoLoad_", _TRUNCATE );		// *[2] Replaced strcpy with strncpy_s.
+					memcpy( (char*)pDicomElement -> Value.UN, "AutoLoad_", 9 );								// *[4] The strncpy_s() size argument truncated the prefix.
 					bNoError = CopyBytesFromBuffer( (char*)pDicomElement -> Value.UN + 9, pDicomElement -> ValueLength, ppBufferListElement );
 					*pnBytesParsed += pDicomElement -> ValueLength;
 					pDicomElement -> ValueLength += 9;
@@ -2305,23 +2530,43 @@ BOOL ParseDicomElementValue( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT *
 						memcpy( pTextLine, (char*)pDicomElement -> Value.UN, CopyLength );
 						pTextLine[ CopyLength ] = '\0';
 						break;
+					// *[4] For the numeric values, don't read past the end of a value that is
+					// shorter than its value representation requires.
 					case SS:			// Signed short.
-						_itoa( (short)*pDicomElement -> Value.SS, pTextLine, 10 );
+						if ( pDicomElement -> ValueLength >= sizeof(short) )
+							_itoa( (short)*pDicomElement -> Value.SS, pTextLine, 10 );
+						else
+							pTextLine[ 0 ] = '\0';
 						break;
 					case US:			// Unsigned short.
-						_itoa( (unsigned short)*pDicomElement -> Value.US, pTextLine, 10 );
+						if ( pDicomElement -> ValueLength >= sizeof(unsigned short) )
+							_itoa( (unsigned short)*pDicomElement -> Value.US, pTextLine, 10 );
+						else
+							pTextLine[ 0 ] = '\0';
 						break;
 					case SL:			// Signed long.
-						_ltoa( (long)*pDicomElement -> Value.SL, pTextLine, 10 );
+						if ( pDicomElement -> ValueLength >= sizeof(long) )
+							_ltoa( (long)*pDicomElement -> Value.SL, pTextLine, 10 );
+						else
+							pTextLine[ 0 ] = '\0';
 						break;
 					case UL:			// Unsigned long.
-						_ultoa( (unsigned long)*pDicomElement -> Value.UL, pTextLine, 10 );
+						if ( pDicomElement -> ValueLength >= sizeof(unsigned long) )
+							_ultoa( (unsigned long)*pDicomElement -> Value.UL, pTextLine, 10 );
+						else
+							pTextLine[ 0 ] = '\0';
 						break;
 					case FL:			// Float (single precision).
-						_gcvt( (float)*pDicomElement -> Value.FL, 16, pTextLine );
+						if ( pDicomElement -> ValueLength >= sizeof(float) )
+							_gcvt( (float)*pDicomElement -> Value.FL, 16, pTextLine );
+						else
+							pTextLine[ 0 ] = '\0';
 						break;
 					case FD:			// Float (double precision).
-						_gcvt( (double)*pDicomElement -> Value.FD, 16, pTextLine );
+						if ( pDicomElement -> ValueLength >= sizeof(double) )
+							_gcvt( (double)*pDicomElement -> Value.FD, 16, pTextLine );
+						else
+							pTextLine[ 0 ] = '\0';
 						break;
 					// The following cases don't have a text representation.
 					case AT:			// Attribute tag.
@@ -2331,7 +2576,7 @@ BOOL ParseDicomElementValue( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT *
 						pTextLine[ 0 ] = '\0';						// *[ 2 ] Eliminate call to strcpy.
 						break;
 					case UN:			// Unsigned long.
-						if ( pDicomElement -> Tag.Group == GROUP_ITEM_DELIMITERS )
+						if ( pDicomElement -> Tag.Group == GROUP_ITEM_DELIMITERS && pDicomElement -> ValueLength >= sizeof(unsigned long) )	// *[4]
 							_ultoa( (unsigned long)*pDicomElement -> Value.UL, pTextLine, 10 );
 						break;
 					}
@@ -2355,7 +2600,8 @@ BOOL ParseDicomElementValue( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT *
 			}
 		}
 
-	SetDicomElementValueMultiplicity( pDicomElement );
+	if ( bNoError )																// *[4] Don't examine a value that failed to load.
+		SetDicomElementValueMultiplicity( pDicomElement );
 
 	return bNoError;
 }
@@ -2991,13 +3237,17 @@ void AddImageToSurvey( DICOM_HEADER_SUMMARY *pDicomHeader, char *DicomFileSpecif
 	char						OutputTextLine[ 2048 ];
 	char						TextValue[ 64 ];
 	DWORD						SurveyFileSize;
+	LIST_ELEMENT				*pDicomElementListElement;											// *[3]
+	unsigned long				nDicomElements;														// *[3]
 
 	SurveyFileSpec[ 0 ] = '\0';																				// *[2]
 	strncat_s( SurveyFileSpec, MAX_FILE_SPEC_LENGTH, ServiceConfiguration.ExportsDirectory, _TRUNCATE );	// *[2] Replaced strncat with strncat_s.
 	LocateOrCreateDirectory( SurveyFileSpec );	// Ensure directory exists.
 	if ( SurveyFileSpec[ strlen( SurveyFileSpec ) - 1 ] != '\\' )
 		strncat_s( SurveyFileSpec, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );									// *[2] Replaced strcat with strncat_s.
-	strncat_s( SurveyFileSpec, MAX_FILE_SPEC_LENGTH, "ImageSurvey.txt", _TRUNCATE );						// *[2] Replaced strncat with strncat_s.
+	// The survey columns were extended by *[3].  Records with the extended layout go to a
+	// separate file, so they aren't appended beneath the column headings of an older survey.
+	strncat_s( SurveyFileSpec, MAX_FILE_SPEC_LENGTH, "ImageSurvey2.txt", _TRUNCATE );						// *[9]
 	SurveyFileSize = GetCompressedFileSize( SurveyFileSpec, NULL );
 	pSurveyFile = fopen( SurveyFileSpec, "at" );
 	if ( pSurveyFile != 0 )
@@ -3032,7 +3282,10 @@ void AddImageToSurvey( DICOM_HEADER_SUMMARY *pDicomHeader, char *DicomFileSpecif
 			strncat_s( OutputTextLine, 2048, "VOI_LUTElementCount,", _TRUNCATE );							// *[2] Replaced strcat with strncat_s.
 			strncat_s( OutputTextLine, 2048, "VOI_LUTThresholdPixelValue,", _TRUNCATE );					// *[2] Replaced strcat with strncat_s.
 			strncat_s( OutputTextLine, 2048, "VOI_LUTBitDepth,", _TRUNCATE );								// *[2] Replaced strcat with strncat_s.
-			strncat_s( OutputTextLine, 2048, "VOI_LUTDataBufferSize", _TRUNCATE );							// *[2] Replaced strcat with strncat_s.
+			strncat_s( OutputTextLine, 2048, "VOI_LUTDataBufferSize,", _TRUNCATE );							// *[3]
+			strncat_s( OutputTextLine, 2048, "TransferSyntaxUID,", _TRUNCATE );								// *[3]
+			strncat_s( OutputTextLine, 2048, "DicomElementCount,", _TRUNCATE );								// *[3]
+			strncat_s( OutputTextLine, 2048, "ImageLengthInBytes", _TRUNCATE );								// *[3]
 			strncat_s( OutputTextLine, 2048, "\n", _TRUNCATE );												// *[2] Replaced strcat with strncat_s.
 			fputs( OutputTextLine, pSurveyFile );
 			}
@@ -3059,20 +3312,35 @@ void AddImageToSurvey( DICOM_HEADER_SUMMARY *pDicomHeader, char *DicomFileSpecif
 			strncat_s( OutputTextLine, 2048, "Yes,", _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
 		else
 			strncat_s( OutputTextLine, 2048, "No,", _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
-		_itoa( *pDicomHeader -> ImageRows, TextValue, 10 );
-		strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
+		if ( pDicomHeader -> ImageRows != 0 )																// *[3]
+			{
+			_itoa( *pDicomHeader -> ImageRows, TextValue, 10 );
+			strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );										// *[2] Replaced strcat with strncat_s.
+			}
 		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[2] Replaced strcat with strncat_s.
-		_itoa( *pDicomHeader -> ImageColumns, TextValue, 10 );
-		strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
+		if ( pDicomHeader -> ImageColumns != 0 )															// *[3]
+			{
+			_itoa( *pDicomHeader -> ImageColumns, TextValue, 10 );
+			strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );										// *[2] Replaced strcat with strncat_s.
+			}
 		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[2] Replaced strcat with strncat_s.
-		_itoa( *pDicomHeader -> BitsAllocated, TextValue, 10 );
-		strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
+		if ( pDicomHeader -> BitsAllocated != 0 )															// *[3]
+			{
+			_itoa( *pDicomHeader -> BitsAllocated, TextValue, 10 );
+			strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );										// *[2] Replaced strcat with strncat_s.
+			}
 		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[2] Replaced strcat with strncat_s.
-		_itoa( *pDicomHeader -> BitsStored, TextValue, 10 );
-		strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
+		if ( pDicomHeader -> BitsStored != 0 )																// *[3]
+			{
+			_itoa( *pDicomHeader -> BitsStored, TextValue, 10 );
+			strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );										// *[2] Replaced strcat with strncat_s.
+			}
 		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[2] Replaced strcat with strncat_s.
-		_itoa( *pDicomHeader -> SamplesPerPixel, TextValue, 10 );
-		strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
+		if ( pDicomHeader -> SamplesPerPixel != 0 )															// *[3]
+			{
+			_itoa( *pDicomHeader -> SamplesPerPixel, TextValue, 10 );
+			strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );										// *[2] Replaced strcat with strncat_s.
+			}
 		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[2] Replaced strcat with strncat_s.
 		strncat_s( OutputTextLine, 2048, "> MODALITY_", _TRUNCATE );										// *[2] Replaced strcat with strncat_s.
 		if ( pDicomHeader -> CalibrationInfo.SpecifiedCalibrationTypes & CALIBRATION_TYPE_MODALITY_RESCALE  )
@@ -3133,6 +3401,23 @@ void AddImageToSurvey( DICOM_HEADER_SUMMARY *pDicomHeader, char *DicomFileSpecif
 		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[2] Replaced strcat with strncat_s.
 		_itoa( pDicomHeader -> CalibrationInfo.VOI_LUTDataBufferSize, TextValue, 10 );
 		strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
+		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[3]
+		if ( pDicomHeader -> TransferSyntaxUniqueIdentifier != 0 )											// *[3]
+			strncat_s( OutputTextLine, 2048, pDicomHeader -> TransferSyntaxUniqueIdentifier, _TRUNCATE );	// *[3]
+		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[3]
+		// Count the Dicom elements parsed from the file.
+		nDicomElements = 0L;																				// *[3]
+		pDicomElementListElement = pDicomHeader -> ListOfDicomElements;										// *[3]
+		while ( pDicomElementListElement != 0 )																// *[3]
+			{
+			nDicomElements++;
+			pDicomElementListElement = pDicomElementListElement -> pNextListElement;
+			}
+		_ultoa( nDicomElements, TextValue, 10 );															// *[3]
+		strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );											// *[3]
+		strncat_s( OutputTextLine, 2048, ",", _TRUNCATE );													// *[3]
+		_ultoa( pDicomHeader -> ImageLengthInBytes, TextValue, 10 );										// *[3]
+		strncat_s( OutputTextLine, 2048, TextValue, _TRUNCATE );											// *[3]
 		strncat_s( OutputTextLine, 2048, "\n", _TRUNCATE );													// *[2] Replaced strcat with strncat_s.
 
 		// Output the text line describing this image.
@@ -3150,7 +3435,7 @@ void CloseDicomFile( FILE *pDicomFile )
 }
 
 
-TRANSFER_SYNTAX GetConsistentTransferSyntaxFromBuffer( TRANSFER_SYNTAX DeclaredTransferSyntax, char *pBufferReadPoint )
+TRANSFER_SYNTAX GetConsistentTransferSyntaxFromBuffer( TRANSFER_SYNTAX DeclaredTransferSyntax, char *pBufferReadPoint, unsigned long nBytesAvailable )
 {
 	TRANSFER_SYNTAX			RealTransferSyntax;
 	DICOM_ELEMENT			DicomElement;
@@ -3165,17 +3450,23 @@ TRANSFER_SYNTAX GetConsistentTransferSyntaxFromBuffer( TRANSFER_SYNTAX DeclaredT
 	// context than the one they are actually using, just rely on testing the data to determine what the actual
 	// formatting is.  (The Dicom "standard" is not very standardized in its application.  Ease of implementation
 	// does not appear to have been a consideration in its design.)
-	DicomElement.Tag.Group = *((unsigned short*)pBufferReadPoint );
-	DicomElement.Tag.Element = *((unsigned short*)pBufferReadPoint + 1 );
-	pDictItem = GetDicomElementFromDictionary( DicomElement.Tag );
-	if ( pDictItem != 0 )
-		bElementWasFoundInDictionary = ( DicomElement.Tag.Group == pDictItem -> Group && DicomElement.Tag.Element == pDictItem -> Element );
-	else
-		bElementWasFoundInDictionary = FALSE;
-	memcpy( ExternalValueRepresentation, pBufferReadPoint + 4, 2 );
+	//
+	// *[4] The test requires a tag and a value representation code:  6 bytes.  If they aren't
+	// available, keep the declared transfer syntax.
+	pDictItem = 0;
+	bElementWasFoundInDictionary = FALSE;
 	*((unsigned long*)( &InternalValueRepresentation )) = 0L;
-	*((unsigned short*)( &InternalValueRepresentation )) = (unsigned short)( ExternalValueRepresentation[ 0 ] << 8 );
-	*((unsigned short*)( &InternalValueRepresentation )) |= (unsigned short)( ExternalValueRepresentation[ 1 ] );
+	if ( pBufferReadPoint != 0 && nBytesAvailable >= 6 )
+		{
+		DicomElement.Tag.Group = *((unsigned short*)pBufferReadPoint );
+		DicomElement.Tag.Element = *((unsigned short*)pBufferReadPoint + 1 );
+		pDictItem = GetDicomElementFromDictionary( DicomElement.Tag );
+		if ( pDictItem != 0 )
+			bElementWasFoundInDictionary = ( DicomElement.Tag.Group == pDictItem -> Group && DicomElement.Tag.Element == pDictItem -> Element );
+		memcpy( ExternalValueRepresentation, pBufferReadPoint + 4, 2 );
+		*((unsigned short*)( &InternalValueRepresentation )) = (unsigned short)( ExternalValueRepresentation[ 0 ] << 8 );
+		*((unsigned short*)( &InternalValueRepresentation )) |= (unsigned short)( ExternalValueRepresentation[ 1 ] );
+		}
 	// Handle declared explicit VR.
 	if ( bElementWasFoundInDictionary && InternalValueRepresentation != pDictItem -> ValueRepresentation &&
 				pDictItem -> ValueRepresentation != UN && ( DeclaredTransferSyntax & EXPLICIT_VR ) != 0 &&
@@ -3204,10 +3495,15 @@ TRANSFER_SYNTAX GetConsistentTransferSyntax( TRANSFER_SYNTAX DeclaredTransferSyn
 	char					*pBufferReadPoint;
 	TRANSFER_SYNTAX			RealTransferSyntax;
 
-	pDicomBuffer = (DICOM_DATA_BUFFER*)(*ppBufferListElement) -> pItem;
-	nBytesProcessed = pDicomBuffer -> DataSize - pDicomBuffer -> BytesRemainingToBeProcessed;
-	pBufferReadPoint = pDicomBuffer -> pBeginningOfDicomData + nBytesProcessed;
-	RealTransferSyntax = GetConsistentTransferSyntaxFromBuffer( DeclaredTransferSyntax, pBufferReadPoint );
+	RealTransferSyntax = DeclaredTransferSyntax;
+	if ( *ppBufferListElement != 0 )																	// *[4] Added null check.
+		{
+		pDicomBuffer = (DICOM_DATA_BUFFER*)(*ppBufferListElement) -> pItem;
+		nBytesProcessed = pDicomBuffer -> DataSize - pDicomBuffer -> BytesRemainingToBeProcessed;
+		pBufferReadPoint = pDicomBuffer -> pBeginningOfDicomData + nBytesProcessed;
+		RealTransferSyntax = GetConsistentTransferSyntaxFromBuffer( DeclaredTransferSyntax, pBufferReadPoint,
+																	pDicomBuffer -> BytesRemainingToBeProcessed );		// *[4]
+		}
 	
 	return RealTransferSyntax;
 }
@@ -3259,13 +3555,14 @@ ASSOCIATED_IMAGE_INFO *CreateAssociatedImageInfo()
 }
 
 
-BOOL ArchiveDicomImageFile( char *pQueuedDicomFileSpec, char *pPNGImageFileName )
+BOOL ArchiveDicomImageFile( char *pQueuedDicomFileSpec, char *pPNGImageFileName, EXAM_INFO *pExamInfo )		// *[6]
 {
 	BOOL						bNoError = TRUE;
 	char						DicomImageFileName[ MAX_FILE_SPEC_LENGTH ];
 	char						DicomImageFileSpec[ MAX_FILE_SPEC_LENGTH ];
 	char						DicomImageArchiveFileSpec[ MAX_FILE_SPEC_LENGTH ];
 	char						*pChar;
+	char						*pStudyInstanceUID;
 	char						Msg[ 1024 ];
 	DWORD						SystemErrorCode;
 
@@ -3278,24 +3575,37 @@ BOOL ArchiveDicomImageFile( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 		// Get the file specification for the current Dicom image file.
 		strncpy_s( DicomImageFileSpec, MAX_FILE_SPEC_LENGTH, pQueuedDicomFileSpec, _TRUNCATE );		// *[2] Replaced strcpy with strncpy_s.
 		
-		// Get the file specification for the destination (archived) Dicom image file.
-		DicomImageArchiveFileSpec[ 0 ] = '\0';	// *[ 2 ] Eliminate call to strcpy.
-		strncat_s( DicomImageArchiveFileSpec, MAX_FILE_SPEC_LENGTH, ServiceConfiguration.DicomImageArchiveDirectory, _TRUNCATE );	// *[2] Replaced strncat with strncat_s.
-		LocateOrCreateDirectory( DicomImageArchiveFileSpec );	// Ensure directory exists.
-		if ( DicomImageFileSpec[ strlen( DicomImageArchiveFileSpec ) - 1 ] != '\\' )
-			strncat_s( DicomImageArchiveFileSpec, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
-		strncat_s( DicomImageArchiveFileSpec, MAX_FILE_SPEC_LENGTH, DicomImageFileName, _TRUNCATE );								// *[2] Replaced strncat with strncat_s.
-		
-		// Copy the current Dicom image file to the archive directory.
-		_snprintf_s( Msg, 1024, _TRUNCATE, "    Copying current Dicom image file:  %s to the archive folder", DicomImageFileSpec );	// *[2] Replaced sprintf() with _snprintf_s.
-		LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
-
-		bNoError = CopyFile( DicomImageFileSpec, DicomImageArchiveFileSpec, FALSE );
-		if ( !bNoError )
+		// *[6] If requested, append the Dicom image file to the pack file for its study.
+		if ( ServiceConfiguration.bPackDicomImageArchive )
+			{
+			pStudyInstanceUID = 0;
+			if ( pExamInfo != 0 && pExamInfo -> pDicomInfo != 0 )
+				pStudyInstanceUID = pExamInfo -> pDicomInfo -> StudyInstanceUID;
+			_snprintf_s( Msg, 1024, _TRUNCATE, "    Adding current Dicom image file:  %s to the archive pack", DicomImageFileSpec );
+			LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
+			bNoError = AppendToArchivePack( ServiceConfiguration.DicomImageArchiveDirectory, pStudyInstanceUID, DicomImageFileName, DicomImageFileSpec );
+			}
+		else
 			{
-			SystemErrorCode = GetLastError();
-			_snprintf_s( Msg, 1024, _TRUNCATE, "   >>> Copy to Dicom image archive system error code %d", SystemErrorCode );		// *[2] Replaced sprintf() with _snprintf_s.
+			// Get the file specification for the destination (archived) Dicom image file.
+			DicomImageArchiveFileSpec[ 0 ] = '\0';	// *[ 2 ] Eliminate call to strcpy.
+			strncat_s( DicomImageArchiveFileSpec, MAX_FILE_SPEC_LENGTH, ServiceConfiguration.DicomImageArchiveDirectory, _TRUNCATE );	// *[2] Replaced strncat with strncat_s.
+			LocateOrCreateDirectory( DicomImageArchiveFileSpec );	// Ensure directory exists.
+			if ( DicomImageFileSpec[ strlen( DicomImageArchiveFileSpec ) - 1 ] != '\\' )
+				strncat_s( DicomImageArchiveFileSpec, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
+			strncat_s( DicomImageArchiveFileSpec, MAX_FILE_SPEC_LENGTH, DicomImageFileName, _TRUNCATE );								// *[2] Replaced strncat with strncat_s.
+		
+			// Copy the current Dicom image file to the archive directory.
+			_snprintf_s( Msg, 1024, _TRUNCATE, "    Copying current Dicom image file:  %s to the archive folder", DicomImageFileSpec );	// *[2] Replaced sprintf() with _snprintf_s.
 			LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
+
+			bNoError = CopyFile( DicomImageFileSpec, DicomImageArchiveFileSpec, FALSE );
+			if ( !bNoError )
+				{
+				SystemErrorCode = GetLastError();
+				_snprintf_s( Msg, 1024, _TRUNCATE, "   >>> Copy to Dicom image archive system error code %d", SystemErrorCode );		// *[2] Replaced sprintf() with _snprintf_s.
+				LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
+				}
 			}
 		}
 
@@ -3322,16 +3632,91 @@ void ExamineDicomElementList( DICOM_HEADER_SUMMARY *pDicomHeader )
 }
 
 
+// *[11]
+static void DeleteCachedOverlayImage()
+{
+	if ( CachedOverlayImage.pImageData != 0 )
+		free( CachedOverlayImage.pImageData );
+	memset( &CachedOverlayImage, 0, sizeof(OVERLAY_IMAGE_CACHE) );
+}
+
+
+// *[11] Provide the decompressed overlay image from the specified JPEG file.  The image is only read
+// and decompressed again if the file specification, the number of bytes to be read, or the file's
+// modification time or size has changed since the last call.  The image belongs to this module, and
+// must not be deallocated by the caller.  If the file can't be opened, no image is returned, and
+// no overlay is written, as before.
+static BOOL GetDecompressedOverlayImage( char *pOverlayImageFileSpec, unsigned long nOverlayImageFileSize, char **ppDecompressedImageData,
+											unsigned long *pImageWidthInPixels, unsigned long *pImageHeightInPixels )
+{
+	BOOL						bNoError = TRUE;
+	struct __stat64				FileStatisticsBuffer;
+	FILE						*pOverlayImageFile;
+	char						*pJPEGOverlayImageBuffer;
+	unsigned long				nBytesRead;
+	unsigned long				DecompressedImageSizeInBytes;
+
+	*ppDecompressedImageData = 0;
+	if ( _stat64( pOverlayImageFileSpec, &FileStatisticsBuffer ) != 0 )
+		{
+		FileStatisticsBuffer.st_mtime = 0;
+		FileStatisticsBuffer.st_size = 0;
+		}
+	if ( CachedOverlayImage.pImageData == 0 || strcmp( pOverlayImageFileSpec, CachedOverlayImage.FileSpec ) != 0 ||
+				nOverlayImageFileSize != CachedOverlayImage.nFileBytes || FileStatisticsBuffer.st_mtime != CachedOverlayImage.ModificationTime ||
+				FileStatisticsBuffer.st_size != CachedOverlayImage.FileSize )
+		{
+		DeleteCachedOverlayImage();
+		pOverlayImageFile = fopen( pOverlayImageFileSpec, "rb" );
+		if ( pOverlayImageFile != 0 )
+			{
+			pJPEGOverlayImageBuffer = (char*)malloc( nOverlayImageFileSize );
+			bNoError = ( pJPEGOverlayImageBuffer != 0 );
+			if ( bNoError )
+				{
+				nBytesRead = (unsigned long)fread_s( pJPEGOverlayImageBuffer, nOverlayImageFileSize, 1, nOverlayImageFileSize, pOverlayImageFile );
+				bNoError = ( nBytesRead == nOverlayImageFileSize );
+				}
+			fclose( pOverlayImageFile );
+			if ( bNoError )
+				{
+				// Convert the JPEG overlay image to an uncompressed image.
+				bNoError = Decompress8BitJpegImage( pJPEGOverlayImageBuffer, nOverlayImageFileSize, &CachedOverlayImage.ImageWidthInPixels,
+														&CachedOverlayImage.ImageHeightInPixels, &CachedOverlayImage.pImageData, &DecompressedImageSizeInBytes );
+				if ( !bNoError )
+					CachedOverlayImage.pImageData = 0;
+				}
+			if ( pJPEGOverlayImageBuffer != 0 )
+				free( pJPEGOverlayImageBuffer );
+			}
+		if ( bNoError && CachedOverlayImage.pImageData != 0 )
+			{
+			strncpy_s( CachedOverlayImage.FileSpec, MAX_CFG_STRING_LENGTH, pOverlayImageFileSpec, _TRUNCATE );
+			CachedOverlayImage.nFileBytes = nOverlayImageFileSize;
+			CachedOverlayImage.ModificationTime = FileStatisticsBuffer.st_mtime;
+			CachedOverlayImage.FileSize = FileStatisticsBuffer.st_size;
+			}
+		}
+	if ( bNoError && CachedOverlayImage.pImageData != 0 )
+		{
+		*ppDecompressedImageData = CachedOverlayImage.pImageData;
+		*pImageWidthInPixels = CachedOverlayImage.ImageWidthInPixels;
+		*pImageHeightInPixels = CachedOverlayImage.ImageHeightInPixels;
+		}
+
+	return bNoError;
+}
+
+
 BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName, EXAM_INFO *pExamInfo )
 {
 	BOOL						bNoError = TRUE;
-	BOOL						bEditSpecsReadOK = FALSE;
 	BOOL						bDicomBuffersAllocatedOK = FALSE;
 	char						DicomImageFileName[ MAX_FILE_SPEC_LENGTH ];
 	char						DicomImageArchiveFileSpec[ MAX_FILE_SPEC_LENGTH ];
 	char						*pChar;
 	char						TransferSyntaxUniqueIdentifier[] = "1.2.840.10008.1.2.1";		// Transfer syntax for uncompressed.
-	DICOM_HEADER_SUMMARY		*pDicomHeader;
+	DICOM_HEADER_SUMMARY		*pDicomHeader = 0;																// *[5]
 	EDIT_SPECIFICATION			*pEditSpecification;
 	char						*pBuffer;
 	DICOM_DATA_BUFFER			*pDicomBuffer;
@@ -3361,22 +3746,17 @@ BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 	char						OverlayImageY0Text[ 32 ];
 	char						OverlayImageFileSizeText[ 32 ];
 	char						OverlayImageFileSpec[ MAX_CFG_STRING_LENGTH ];
-	FILE						*pOverlayImageFile;
-	char						*pJPEGOverlayImageBuffer;
-	unsigned long				nBytesRead;
 	unsigned long				nOverlayImageWidth;
 	unsigned long				nOverlayImageHeight;
 	unsigned long				nOverlayImageX0;
 	unsigned long				nOverlayImageY0;
 	unsigned long				nOverlayImageFileSize;
 	size_t						nBytesComposed;
-	FILE						*pOutputFile;
-	long						nBytesToBeWritten;
-	long						nBytesWritten;
+	FILE						*pOutputFile = 0;																// *[5]
+	size_t						nBytesWritten;																	// *[5]
 	unsigned long				ImageWidthInPixels;
 	unsigned long				ImageHeightInPixels;
 	char						*pDecompressedImageData;
-	unsigned long				DecompressedImageSizeInBytes;
 	long						nAdditionalElementsToDelete;
 	char						Msg[ 1024 ];
 
@@ -3403,16 +3783,16 @@ BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 				{
 				pDicomHeader -> ListOfEditSpecifications = 0;
 				if ( ServiceConfiguration.bApplyManualDicomEdits )
-					bEditSpecsReadOK = ReadExamEditSpecificationFile( &pDicomHeader -> ListOfEditSpecifications );
+					GetCompiledExamEditSpecifications( &pDicomHeader -> ListOfEditSpecifications );				// *[7]
 				// Set the transfer syntax of the output image to be uncompressed.
 				if ( strlen( pDicomHeader -> TransferSyntaxUniqueIdentifier ) < strlen( TransferSyntaxUniqueIdentifier ) )
-					pDicomHeader -> TransferSyntaxUniqueIdentifier = (char*)realloc( pDicomHeader -> TransferSyntaxUniqueIdentifier, strlen( TransferSyntaxUniqueIdentifier + 2 ) );
+					pDicomHeader -> TransferSyntaxUniqueIdentifier = (char*)realloc( pDicomHeader -> TransferSyntaxUniqueIdentifier, strlen( TransferSyntaxUniqueIdentifier ) + 1 );			// *[10] Was one byte short.
 
 				bNoError = ( pDicomHeader -> TransferSyntaxUniqueIdentifier != 0 );
 				if ( bNoError )
 					{
 					strncpy_s( pDicomHeader -> TransferSyntaxUniqueIdentifier,																	// *[2] Replaced strcpy with strncpy_s.
-									strlen( pDicomHeader -> TransferSyntaxUniqueIdentifier ), TransferSyntaxUniqueIdentifier, _TRUNCATE );
+									strlen( TransferSyntaxUniqueIdentifier ) + 1, TransferSyntaxUniqueIdentifier, _TRUNCATE );				// *[10]
 					pDicomHeader -> FileDecodingPlan.nTransferSyntaxIndex = GetTransferSyntaxIndex( pDicomHeader -> TransferSyntaxUniqueIdentifier,
 																			(unsigned short)strlen( pDicomHeader -> TransferSyntaxUniqueIdentifier ) );
 					pDicomHeader -> FileDecodingPlan.ImageDataTransferSyntax = UNCOMPRESSED;
@@ -3442,6 +3822,7 @@ BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 						pDicomBuffer -> BufferSize = MAX_DICOM_READ_BUFFER_SIZE;
 						pDicomBuffer -> DataSize = 0L;
 						pDicomBuffer -> BytesRemainingToBeProcessed = MAX_DICOM_READ_BUFFER_SIZE;
+						pDicomBuffer -> BytesInFollowingBuffers = 0L;							// *[8]
 						// Link the new buffer to the list.
 						bNoError = AppendToList( &pDicomHeader -> ListOfOutputBuffers, (void*)pDicomBuffer );
 						}
@@ -3475,144 +3856,113 @@ BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 				//				}
 			
 							// Check each dicom element for possible edit specifications before packing into the buffer.
-							pEditSpecificationListElement = pDicomHeader -> ListOfEditSpecifications;
-							bEditSpecifiedForThisElement = FALSE;
-							while ( pEditSpecificationListElement != 0 && !bEditSpecifiedForThisElement )
+							// *[7] The edit for the element's tag, if any, is located in the compiled edit index.
+							pEditSpecification = 0;
+							if ( pDicomHeader -> ListOfEditSpecifications != 0 )
+								pEditSpecification = LookUpElementEditSpecification( pDicomElement -> Tag );
+							// If this element from the file matches an edit specification, process the edit.
+							if ( pEditSpecification != 0 )
 								{
-								pEditSpecification = (EDIT_SPECIFICATION*)pEditSpecificationListElement -> pItem;
-								// If this element from the file matches an edit specification, process the edit.
-								if ( pEditSpecification -> DicomFieldIdentifier.Group == pDicomElement -> Tag.Group &&
-											pEditSpecification -> DicomFieldIdentifier.Element == pDicomElement -> Tag.Element &&
-											pEditSpecification -> EditOperation != EDIT_ADD_ELEMENT && pEditSpecification -> EditOperation != EDIT_DELETE_ELEMENT )
+								// If this element contains the image...
+								if ( pDicomElement -> Tag.Group == 0x7FE0 && pDicomElement -> Tag.Element == 0x0010 )
 									{
-									bEditSpecifiedForThisElement = TRUE;
-
-									// If this element contains the image...
-									if ( pDicomElement -> Tag.Group == 0x7FE0 && pDicomElement -> Tag.Element == 0x0010 )
+									strncpy_s( EditedFieldValue, MAX_FILE_SPEC_LENGTH,
+												pEditSpecification -> EditedFieldValue, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.
+									pEditFieldText = strtok( EditedFieldValue, " \n" );
+									strncpy_s( OriginalImageSizeText, 32, pEditFieldText, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.
+									pDicomElement -> ValueLength = atol( OriginalImageSizeText );
+									pEditFieldText = strtok( NULL, " \n" );
+									strncpy_s( OverlayImageWidthText, 32, pEditFieldText, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.
+									nOverlayImageWidth = atol( OverlayImageWidthText );
+									pEditFieldText = strtok( NULL, " \n" );
+									strncpy_s( OverlayImageHeightText, 32, pEditFieldText, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.
+									nOverlayImageHeight = atol( OverlayImageHeightText );
+									pEditFieldText = strtok( NULL, " \n" );
+									strncpy_s( OverlayImageX0Text, 32, pEditFieldText, _TRUNCATE );							// *[2] Replaced strcpy with strncpy_s.
+									nOverlayImageX0 = atol( OverlayImageX0Text );
+									pEditFieldText = strtok( NULL, " \n" );
+									strncpy_s( OverlayImageY0Text, 32, pEditFieldText, _TRUNCATE );							// *[2] Replaced strcpy with strncpy_s.
+									nOverlayImageY0 = atol( OverlayImageY0Text );
+									pEditFieldText = strtok( NULL, " \n" );
+									strncpy_s( OverlayImageFileSizeText, 32, pEditFieldText, _TRUNCATE );					// *[2] Replaced strcpy with strncpy_s.
+									nOverlayImageFileSize = atol( OverlayImageFileSizeText );
+									pEditFieldText = strtok( NULL, " \n" );
+									strncpy_s( OverlayImageFileSpec, MAX_CFG_STRING_LENGTH, pEditFieldText, _TRUNCATE );	// *[2] Replaced strcpy with strncpy_s.
+									if ( pEditSpecification -> EditOperation == EDIT_CROP_IMAGE )
 										{
-										strncpy_s( EditedFieldValue, MAX_FILE_SPEC_LENGTH,
-													pEditSpecification -> EditedFieldValue, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.
-										pEditFieldText = strtok( EditedFieldValue, " \n" );
-										strncpy_s( OriginalImageSizeText, 32, pEditFieldText, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.
-										pDicomElement -> ValueLength = atol( OriginalImageSizeText );
-										pEditFieldText = strtok( NULL, " \n" );
-										strncpy_s( OverlayImageWidthText, 32, pEditFieldText, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.
-										nOverlayImageWidth = atol( OverlayImageWidthText );
-										pEditFieldText = strtok( NULL, " \n" );
-										strncpy_s( OverlayImageHeightText, 32, pEditFieldText, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.
-										nOverlayImageHeight = atol( OverlayImageHeightText );
-										pEditFieldText = strtok( NULL, " \n" );
-										strncpy_s( OverlayImageX0Text, 32, pEditFieldText, _TRUNCATE );							// *[2] Replaced strcpy with strncpy_s.
-										nOverlayImageX0 = atol( OverlayImageX0Text );
-										pEditFieldText = strtok( NULL, " \n" );
-										strncpy_s( OverlayImageY0Text, 32, pEditFieldText, _TRUNCATE );							// *[2] Replaced strcpy with strncpy_s.
-										nOverlayImageY0 = atol( OverlayImageY0Text );
-										pEditFieldText = strtok( NULL, " \n" );
-										strncpy_s( OverlayImageFileSizeText, 32, pEditFieldText, _TRUNCATE );					// *[2] Replaced strcpy with strncpy_s.
-										nOverlayImageFileSize = atol( OverlayImageFileSizeText );
-										pEditFieldText = strtok( NULL, " \n" );
-										strncpy_s( OverlayImageFileSpec, MAX_CFG_STRING_LENGTH, pEditFieldText, _TRUNCATE );	// *[2] Replaced strcpy with strncpy_s.
-										if ( pEditSpecification -> EditOperation == EDIT_CROP_IMAGE )
-											{
-											nCroppedImageWidth = 1900;
-											nCroppedImageHeight = 2048;
-											nCroppedImageX0 = 148;
-											nCroppedImageY0 = 0;
-											bNoError = CropImage( pDicomHeader, nCroppedImageWidth, nCroppedImageHeight, nCroppedImageX0, nCroppedImageY0 );
-											}
-										else if ( pEditSpecification -> EditOperation == EDIT_ADD_IMAGE_OVERLAY )
-											{
-											pOverlayImageFile = fopen( OverlayImageFileSpec, "rb" );
-											if ( pOverlayImageFile != 0 )
-												{
-												pJPEGOverlayImageBuffer = (char*)malloc( nOverlayImageFileSize );
-												bNoError = ( pJPEGOverlayImageBuffer != 0 );									// *[2] Fix error handling and possible memory leak.
-												if ( bNoError)
-													{
-													nBytesRead = fread_s( pJPEGOverlayImageBuffer, nOverlayImageFileSize,
-																1, nOverlayImageFileSize, pOverlayImageFile );					// *[2] Replaced fread with fread_s.
-													bNoError = ( nBytesRead == nOverlayImageFileSize );
-													}
-												fclose( pOverlayImageFile );
-												if ( bNoError )
-													{
-													// Convert the JPEG overlay image to an uncompressed image.
-													bNoError = Decompress8BitJpegImage( pJPEGOverlayImageBuffer, nOverlayImageFileSize,
-														&ImageWidthInPixels, &ImageHeightInPixels,	&pDecompressedImageData, &DecompressedImageSizeInBytes );
-
-													// Enscribe the overlay image over the original image at the specified coordinates.
-													// (This assumes the Dicom image is uncompressed.
-													if ( bNoError )
-														{
-														// For the specific case of labeling the standard reference images, calculate the overlay position
-														// to be at the bottom center of the Dicom image:
-														nOverlayImageX0 = ( (unsigned long)( *pDicomHeader -> ImageColumns ) - ImageWidthInPixels ) / 2;
-														nOverlayImageY0 = (unsigned long)( *pDicomHeader -> ImageRows ) - ImageHeightInPixels;
-														bNoError = EnscribeImageOverlay( pDicomHeader, pDecompressedImageData, ImageWidthInPixels,
-																							ImageHeightInPixels, 1, nOverlayImageX0, nOverlayImageY0 );
-														free( pDecompressedImageData );
-														}
-													}
-												if ( pJPEGOverlayImageBuffer != 0 )												// *[2] Fix error handling and possible memory leak.
-													free( pJPEGOverlayImageBuffer );
-												}
-											}
-										else if ( pEditSpecification -> EditOperation == EDIT_REPLACE_IMAGE )
-											bNoError = ReadRawImageFile( pDicomHeader, OverlayImageFileSpec );					// *[2] Removed allocation of unreferenced buffer.
+										nCroppedImageWidth = 1900;
+										nCroppedImageHeight = 2048;
+										nCroppedImageX0 = 148;
+										nCroppedImageY0 = 0;
+										bNoError = CropImage( pDicomHeader, nCroppedImageWidth, nCroppedImageHeight, nCroppedImageX0, nCroppedImageY0 );
 										}
-									else if ( pDicomElement -> ValueRepresentation == US )
-										*pDicomElement -> Value.US = (unsigned short)atoi( pEditSpecification -> EditedFieldValue );
-									else if ( pDicomElement -> ValueRepresentation == UL )
-										*pDicomElement -> Value.UL = (unsigned long)atol( pEditSpecification -> EditedFieldValue );
-									else if ( pDicomElement -> ValueRepresentation == PN )
+									else if ( pEditSpecification -> EditOperation == EDIT_ADD_IMAGE_OVERLAY )
 										{
-										strncat_s( pEditSpecification -> EditedFieldValue, MAX_FILE_SPEC_LENGTH, " ", _TRUNCATE );	// *[2] Replaced strcat with strncat_s.
-										pDicomElement -> Value.UN = realloc( pDicomElement -> Value.UN, strlen( pEditSpecification -> EditedFieldValue ) + 20 );
-										if ( pDicomElement -> Value.UN == 0 )
-											{
-											bNoError = FALSE;
-											RespondToError( MODULE_DICOM, DICOM_ERROR_ALLOCATE_VALUE );
-											}
-										//strcpy( pDicomElement -> Value.LT, "^" );
-										//strcat( pDicomElement -> Value.LT, pEditSpecification -> EditedFieldValue );
-										strncpy_s( pDicomElement -> Value.LT, pDicomElement -> ValueLength,
-													pEditSpecification -> EditedFieldValue, _TRUNCATE );							// *[2] Replaced strcpy with strncpy_s.
-										pDicomElement -> ValueLength = strlen( pDicomElement -> Value.LT );
-										if ( ( pDicomElement -> ValueLength & 1 ) != 0 )
-											pDicomElement -> ValueLength--;
-										if ( pDicomElement -> pConvertedValue != 0 )
+										// *[11] The overlay image is only read and decompressed again when its file changes.
+										bNoError = GetDecompressedOverlayImage( OverlayImageFileSpec, nOverlayImageFileSize,
+																		&pDecompressedImageData, &ImageWidthInPixels, &ImageHeightInPixels );
+										// Enscribe the overlay image over the original image at the specified coordinates.
+										// (This assumes the Dicom image is uncompressed.
+										if ( bNoError && pDecompressedImageData != 0 )
 											{
-											free( pDicomElement -> pConvertedValue );
-											pDicomElement -> pConvertedValue = 0;
+											// For the specific case of labeling the standard reference images, calculate the overlay position
+											// to be at the bottom center of the Dicom image:
+											nOverlayImageX0 = ( (unsigned long)( *pDicomHeader -> ImageColumns ) - ImageWidthInPixels ) / 2;
+											nOverlayImageY0 = (unsigned long)( *pDicomHeader -> ImageRows ) - ImageHeightInPixels;
+											bNoError = EnscribeImageOverlay( pDicomHeader, pDecompressedImageData, ImageWidthInPixels,
+																				ImageHeightInPixels, 1, nOverlayImageX0, nOverlayImageY0 );
 											}
-										AllocateDicomPersonNameBuffer( pDicomElement );
+										}
+									else if ( pEditSpecification -> EditOperation == EDIT_REPLACE_IMAGE )
+										bNoError = ReadRawImageFile( pDicomHeader, OverlayImageFileSpec );					// *[2] Removed allocation of unreferenced buffer.
+									}
+								else if ( pDicomElement -> ValueRepresentation == US )
+									*pDicomElement -> Value.US = (unsigned short)pEditSpecification -> NumericFieldValue;						// *[7]
+								else if ( pDicomElement -> ValueRepresentation == UL )
+									*pDicomElement -> Value.UL = (unsigned long)pEditSpecification -> NumericFieldValue;						// *[7]
+								else if ( pDicomElement -> ValueRepresentation == PN )
+									{
+									// *[7] The person name value has been padded when the edit specification was compiled.
+									pDicomElement -> Value.UN = realloc( pDicomElement -> Value.UN, strlen( pEditSpecification -> PersonNameFieldValue ) + 20 );
+									if ( pDicomElement -> Value.UN == 0 )
+										{
+										bNoError = FALSE;
+										RespondToError( MODULE_DICOM, DICOM_ERROR_ALLOCATE_VALUE );
+										}
+									//strcpy( pDicomElement -> Value.LT, "^" );
+									//strcat( pDicomElement -> Value.LT, pEditSpecification -> EditedFieldValue );
+									strncpy_s( pDicomElement -> Value.LT, pDicomElement -> ValueLength,
+												pEditSpecification -> PersonNameFieldValue, _TRUNCATE );						// *[2] Replaced strcpy with strncpy_s.  *[7]
+									pDicomElement -> ValueLength = strlen( pDicomElement -> Value.LT );
+									if ( ( pDicomElement -> ValueLength & 1 ) != 0 )
+										pDicomElement -> ValueLength--;
+									if ( pDicomElement -> pConvertedValue != 0 )
+										{
+										free( pDicomElement -> pConvertedValue );
+										pDicomElement -> pConvertedValue = 0;
+										}
+									AllocateDicomPersonNameBuffer( pDicomElement );
+									}
+								else
+									{
+									// *[7] The encoded value has already been padded to an even length.
+									pDicomElement -> ValueLength = (unsigned long)strlen( pEditSpecification -> EncodedFieldValue );
+									pDicomElement -> Value.UN = realloc( pDicomElement -> Value.UN, strlen( pEditSpecification -> EncodedFieldValue ) + 1 );
+									pDicomElement -> pConvertedValue = (char*)realloc( (void*)pDicomElement -> pConvertedValue, strlen( pEditSpecification -> EncodedFieldValue ) + 1 );
+									if ( pDicomElement -> Value.UN == 0 || pDicomElement -> pConvertedValue == 0 )
+										{
+										bNoError = FALSE;
+										RespondToError( MODULE_DICOM, DICOM_ERROR_ALLOCATE_VALUE );
 										}
 									else
 										{
-										pDicomElement -> ValueLength = (unsigned long)strlen( pEditSpecification -> EditedFieldValue );
-										if ( ( pDicomElement -> ValueLength & 1 ) != 0 )
-											{
-											pDicomElement -> ValueLength++;
-											strncat_s( pEditSpecification -> EditedFieldValue, MAX_FILE_SPEC_LENGTH, " ", _TRUNCATE );	// *[2] Replaced strcat with strncat_s.
-											}
-										pDicomElement -> Value.UN = realloc( pDicomElement -> Value.UN, strlen( pEditSpecification -> EditedFieldValue ) + 1 );
-										pDicomElement -> pConvertedValue = (char*)realloc( (void*)pDicomElement -> pConvertedValue, strlen( pEditSpecification -> EditedFieldValue ) + 1 );
-										if ( pDicomElement -> Value.UN == 0 || pDicomElement -> pConvertedValue == 0 )
-											{
-											bNoError = FALSE;
-											RespondToError( MODULE_DICOM, DICOM_ERROR_ALLOCATE_VALUE );
-											}
-										else
-											{
-											// Copy the new value into the Dicom element structure and make sure the length is even.
-											strncpy_s( pDicomElement -> Value.LT, pDicomElement -> ValueLength, pEditSpecification -> EditedFieldValue, _TRUNCATE );		// *[2] Replaced strcpy with strncpy_s.
-											strncpy_s( pDicomElement -> pConvertedValue,
-														strlen( pEditSpecification -> EditedFieldValue ) + 1, pEditSpecification -> EditedFieldValue, _TRUNCATE );			// *[2] Replaced strcpy with strncpy_s.
-											}
+										// Copy the new value into the Dicom element structure and make sure the length is even.
+										strncpy_s( pDicomElement -> Value.LT, pDicomElement -> ValueLength, pEditSpecification -> EncodedFieldValue, _TRUNCATE );		// *[2] Replaced strcpy with strncpy_s.  *[7]
+										strncpy_s( pDicomElement -> pConvertedValue,
+													strlen( pEditSpecification -> EncodedFieldValue ) + 1, pEditSpecification -> EncodedFieldValue, _TRUNCATE );			// *[2] Replaced strcpy with strncpy_s.  *[7]
 										}
-									pEditSpecification -> bEditCompleted = TRUE;
 									}
-								pEditSpecificationListElement = pEditSpecificationListElement -> pNextListElement;
+								pEditSpecification -> bEditCompleted = TRUE;
 								}
 							}
 						pDicomDataListElement = pDicomDataListElement -> pNextListElement;
@@ -3763,7 +4113,7 @@ BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 						pEditSpecification = (EDIT_SPECIFICATION*)pEditSpecificationListElement -> pItem;
 						if ( pEditSpecification != 0 && !pEditSpecification -> bEditCompleted && pEditSpecification -> EditOperation == EDIT_DELETE_ELEMENT )
 							{
-							nAdditionalElementsToDelete = atol( pEditSpecification -> EditedFieldValue );
+							nAdditionalElementsToDelete = pEditSpecification -> NumericFieldValue;										// *[7]
 							bNoError = ( nAdditionalElementsToDelete >= 0 && nAdditionalElementsToDelete < 50 );
 							if ( bNoError )
 								{
@@ -3805,12 +4155,24 @@ BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 						pEditSpecificationListElement = pEditSpecificationListElement -> pNextListElement;
 						}
 					}
-				if ( bEditSpecsReadOK )
-					DeallocateEditSpecifications( &pDicomHeader -> ListOfEditSpecifications );
+				// *[7] The compiled edit specifications are retained by the exam edit module for the next image.
+				pDicomHeader -> ListOfEditSpecifications = 0;
+				}
+			}
+		// *[5] Open the output file first, so that the composed elements can be streamed to it.
+		if ( bNoError && pDicomHeader != 0 )
+			{
+			pOutputFile = OpenDicomFileForOutput( DicomImageArchiveFileSpec );
+			if ( pOutputFile != 0 )
+				setvbuf( pOutputFile, NULL, _IOFBF, MAX_DICOM_READ_BUFFER_SIZE );
+			else
+				{
+				bNoError = FALSE;
+				RespondToError( MODULE_DICOM, DICOM_ERROR_DICOM_STORE_CREATE );
 				}
 			}
 		// Write the list of edited Dicom elements to the output buffers.
-		if ( bNoError )
+		if ( bNoError && pOutputFile != 0 )
 			{
 			// Loop through the Dicom elements.
 			pDicomElement = 0;
@@ -3850,13 +4212,23 @@ BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 						bDicomBuffersAllocatedOK = FALSE;
 					// Compose the data element value.
 					nBytesComposed = 0;
-					if ( pDicomElement -> Tag.Group == 0x7fe0 && pDicomElement -> Tag.Element == 0x0010 )
-
-						//zzz preserve format didn't set image buffer.
-
-						bNoError = CopyBytesToBuffer( (char*)pDicomHeader -> pImageData, pDicomHeader -> ImageLengthInBytes,
-																		(unsigned long*)&nBytesComposed, &pBufferListElement );
-					else
+					if ( bNoError && pDicomElement -> Tag.Group == 0x7fe0 && pDicomElement -> Tag.Element == 0x0010 )
+						{
+						// *[5] Flush the elements composed so far and write the pixel data directly from
+						// the image buffer, rather than copying the whole image into the output buffers.
+						bNoError = FlushOutputBuffersToFile( pDicomHeader, pOutputFile );
+						pBufferListElement = pDicomHeader -> ListOfOutputBuffers;
+						if ( bNoError && pDicomHeader -> pImageData != 0 && pDicomHeader -> ImageLengthInBytes > 0 )
+							{
+							nBytesWritten = fwrite( (char*)pDicomHeader -> pImageData, 1, (size_t)pDicomHeader -> ImageLengthInBytes, pOutputFile );
+							if ( nBytesWritten != (size_t)pDicomHeader -> ImageLengthInBytes )
+								{
+								bNoError = FALSE;
+								RespondToError( MODULE_DICOM, DICOM_ERROR_DICOM_STORE_WRITE );
+								}
+							}
+						}
+					else if ( bNoError )
 						{
 						bNoError = ComposeDicomElementValueForOutput( &pBufferListElement, pDicomElement, &nBytesComposed );
 						nTotalBytesComposed += nBytesComposed;
@@ -3867,38 +4239,15 @@ BOOL ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName
 				pDicomDataListElement = pDicomDataListElement -> pNextListElement;
 				}
 			}
-		if ( bNoError )
+		// *[5] Write out whatever remains in the output buffers.
+		if ( bNoError && pOutputFile != 0 )
+			bNoError = FlushOutputBuffersToFile( pDicomHeader, pOutputFile );
+		if ( pOutputFile != 0 )
 			{
-			pOutputFile = OpenDicomFileForOutput( DicomImageArchiveFileSpec );
-			if ( pOutputFile != 0 )
-				{
-				ResetOutputBufferCursors( pExamInfo -> pDicomInfo );
-				pBufferListElement = pExamInfo -> pDicomInfo -> ListOfOutputBuffers;
-				while ( bNoError && pBufferListElement != 0 )
-					{
-					pDicomBuffer = (DICOM_DATA_BUFFER*)pBufferListElement -> pItem;
-					if ( pDicomBuffer != 0 )
-						{
-						if ( pDicomBuffer -> pBuffer != 0 )
-							{
-							nBytesToBeWritten = pDicomBuffer -> DataSize;
-							nBytesWritten = (long)fwrite( pDicomBuffer -> pBuffer, 1, (long)nBytesToBeWritten, pOutputFile );
-							if ( nBytesWritten != nBytesToBeWritten )
-								{
-								bNoError = FALSE;
-								RespondToError( MODULE_EXAM, DICOM_ERROR_DICOM_STORE_WRITE );
-								}
-							}
-						}
-					pBufferListElement = pBufferListElement -> pNextListElement;
-					}
-				fclose( pOutputFile );
-				}
-			else
-				{
-				bNoError = FALSE;
-				RespondToError( MODULE_EXAM, DICOM_ERROR_DICOM_STORE_CREATE );
-				}
+			fclose( pOutputFile );
+			// Don't leave a partially written file in the archive.
+			if ( !bNoError )
+				remove( DicomImageArchiveFileSpec );
 			}
 		if ( bDicomBuffersAllocatedOK )																			// *[2] Moved deallocation outside of error scope.
 			DeallocateOutputBuffers( pDicomHeader );
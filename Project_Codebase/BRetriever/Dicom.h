@@ -108,6 +108,7 @@ typedef struct
 	unsigned long		BufferSize;
 	unsigned long		DataSize;
 	unsigned long		BytesRemainingToBeProcessed;
+	unsigned long		BytesInFollowingBuffers;		// The data bytes in all the buffers later in the list.
 	} DICOM_DATA_BUFFER;
 
 
@@ -385,9 +386,9 @@ void					CopyImageFileToSortTreeDirectory( DICOM_HEADER_SUMMARY *pDicomHeader, c
 void					AddImageToSurvey( DICOM_HEADER_SUMMARY *pDicomHeader, char *DicomFileSpecification );
 void					CloseDicomFile( FILE *pDicomFile );
 TRANSFER_SYNTAX			GetConsistentTransferSyntax( TRANSFER_SYNTAX DeclaredTransferSyntax, LIST_ELEMENT **ppBufferListElement );
-TRANSFER_SYNTAX			GetConsistentTransferSyntaxFromBuffer( TRANSFER_SYNTAX DeclaredTransferSyntax, char *pBufferReadPoint );
+TRANSFER_SYNTAX			GetConsistentTransferSyntaxFromBuffer( TRANSFER_SYNTAX DeclaredTransferSyntax, char *pBufferReadPoint, unsigned long nBytesAvailable );
 ASSOCIATED_IMAGE_INFO	*CreateAssociatedImageInfo();
-BOOL					ArchiveDicomImageFile( char *pQueuedDicomFileSpec, char *pPNGImageFileName );
+BOOL					ArchiveDicomImageFile( char *pQueuedDicomFileSpec, char *pPNGImageFileName, EXAM_INFO *pExamInfo );
 void					ExamineDicomElementList( DICOM_HEADER_SUMMARY *pDicomHeader );
 BOOL					ComposeDicomFileOutput( char *pQueuedDicomFileSpec, char *pPNGImageFileName, EXAM_INFO *pExamInfo );
 BOOL					ComposeDicomElementForOutput( LIST_ELEMENT **ppBufferListElement, DICOM_ELEMENT *pDicomElement,
@@ -29,6 +29,17 @@
 //
 // UPDATE HISTORY:
 //
+//	*[6] 10/19/2026 by agent
+//		Record the image bytes received over each association in the association size
+//		histogram exported by ProcessingMetrics.cpp.
+//	*[5] 10/19/2026 by agent
+//		The host name cache moved to HostNameCache.cpp.  CloseDicomAcceptorModule() waits
+//		for any host name lookups under way before shutting down Windows sockets.
+//	*[4] 10/19/2026 by agent
+//		Look up the host names of connecting clients on a separate thread, caching the
+//		results, so that connections are no longer held up waiting for DNS.
+//	*[3] 10/19/2026 by agent
+//		Log the reception throughput for each association when it closes.
 //	*[2] 03/11/2024 by Tom Atwood
 //		Convert windows headers byte packing to the Win32 default for compatibility
 //		with Visual Studio 2022.
@@ -56,6 +67,7 @@
 #include "DicomAcceptor.h"
 #include "DicomCommand.h"
 #include "DicomCommunication.h"
+#include "ProcessingMetrics.h"		// *[6]
 
 
 //___________________________________________________________________________
@@ -87,6 +99,7 @@ static ERROR_DICTIONARY_ENTRY	DicomAcceptorErrorCodes[] =
 				{ DICOMACCEPT_ERROR_PARSE_EXPECT_IMPL_VER_NAME		, "During response parsing, the implementation version name was expected but was not found." },
 				{ DICOMACCEPT_ERROR_START_OP_THREAD					, "An error occurred starting a Dicom acceptor operation thread." },
 				{ DICOMACCEPT_ERROR_LISTEN_SOCKET_SHUTDOWN			, "Failure to accept connection request.  Shutting down listening operation." },
+				{ DICOMACCEPT_ERROR_HOST_NAME_CACHE_ACCESS			, "An error occurred waiting for access to the host name cache." },
 				{ 0													, NULL }
 			};
 
@@ -118,6 +131,7 @@ void InitDicomAcceptorModule()
 	bListeningEnabled = FALSE;
 	bListeningTerminated = FALSE;
 	TotalThreadCount = 0L;
+	InitHostNameCache();				// *[5]
 }
 
 
@@ -133,8 +147,11 @@ void CloseDicomAcceptorModule()
 		bNoError = WindowsCloseSocket( ListeningSocket );
 		ListeningSocket = INVALID_SOCKET;
 		bListeningEnabled = FALSE;
-		TerminateWindowsSockets();
 		}
+	// *[5] A host name lookup thread may still be using Windows sockets and the host name cache.
+	CloseHostNameCache();
+	if ( bSocketsEnabled )
+		TerminateWindowsSockets();
 	bSocketsEnabled = FALSE;
 }
 
@@ -333,7 +350,8 @@ BOOL RespondToConnectionRequests( PRODUCT_OPERATION *pListenOperation )
 	int							bDisableNagleAlgorithm;
 	DICOM_ASSOCIATION			*pAssociation;
 	char						ClientIPAddress[ 20 ];
-	struct hostent				*pRemoteHostEntity = NULL;
+	unsigned long				ClientAddress;						// *[4]
+	BOOL						bHostNameIsKnown;					// *[4]
 	BOOL						bTerminateOperation;
 	PRODUCT_OPERATION			*pReceiveOperation;
 	OPERATION_THREAD_FUNCTION	OpnThreadFunction;
@@ -442,13 +460,10 @@ BOOL RespondToConnectionRequests( PRODUCT_OPERATION *pListenOperation )
 				pAssociation -> DicomAssociationSocket = ConnectingSocket;
 				pAssociation -> RemoteIPAddress[ 0 ] = '\0';														// *[1] Eliminate call to strcpy.
 				strncat_s( pAssociation -> RemoteIPAddress, MAX_CFG_STRING_LENGTH, ClientIPAddress, _TRUNCATE );	// *[1] Replaced strncat with strncat_s.
-				// Attempt to use DNS to look up the client Internet URL.
-				bNoError = GetWindowsHostByAddress( &ConnectingAddress.sa_data[2], 4, 2, &pRemoteHostEntity );
-				if ( !bNoError )
-					{
-					bNoError = TRUE;
-					pRemoteHostEntity = 0;
-					}
+				// *[4] Use the client's host name if it is in the cache.  Otherwise, it is looked up on a separate
+				// thread, and the connection proceeds without waiting for it.
+				memcpy( &ClientAddress, &ConnectingAddress.sa_data[2], 4 );
+				bHostNameIsKnown = LookUpCachedHostName( ClientAddress, pAssociation -> RemoteNodeName, TRUE );
 				}
 			else
 				{
@@ -460,16 +475,14 @@ BOOL RespondToConnectionRequests( PRODUCT_OPERATION *pListenOperation )
 			}
 		if ( bNoError )
 			{
-			if ( pRemoteHostEntity == 0 )
+			if ( !bHostNameIsKnown )																					// *[4]
 				{
-				// Reverse DNS lookup disabled or host not found, so use the numerical address.
+				// Host name not yet known, so use the numerical address.
 				pAssociation -> RemoteNodeName[ 0 ] = '\0';					// *[1] Eliminate call to strcpy.
 				strncat_s( pAssociation -> RemoteNodeName, MAX_CFG_STRING_LENGTH, ClientIPAddress, _TRUNCATE );				// *[1] Replaced strncat with strncat_s.
 				}
 			else
 				{
-				pAssociation -> RemoteNodeName[ 0 ] = '\0';					// *[1] Eliminate call to strcpy.
-				strncat_s( pAssociation -> RemoteNodeName, MAX_CFG_STRING_LENGTH, pRemoteHostEntity -> h_name, _TRUNCATE );	// *[1] Replaced strncat with strncat_s.
 				_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
 							"  Preparing to receive from %s.", pAssociation -> RemoteNodeName );							// *[1] Replaced sprintf() with _snprintf_s.
 				LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
@@ -549,6 +562,9 @@ unsigned __stdcall ReceiveDicomThreadFunction( void *pOperationStruct )
 		// The state machine was in control of sequencing the association activities
 		// until this point is reached:
 		pAssociation -> bAssociationClosed = TRUE;
+		LogAssociationReceptionRate( pAssociation );													// *[3]
+		if ( pAssociation -> nImagesReceived > 0 )
+			RecordAssociationBytesReceived( pAssociation -> nImageBytesReceived );						// *[6]
 		if ( bNoError && pReceiveOperation -> pDependentOperation != 0 )
 			{
 			// Enable any dependent operation to cycle.
@@ -579,6 +595,36 @@ unsigned __stdcall ReceiveDicomThreadFunction( void *pOperationStruct )
 }
 
 
+// *[3] Log the number of images received over the association and the rate at which
+// they arrived, measured from the creation of the association to its closure.
+void LogAssociationReceptionRate( DICOM_ASSOCIATION *pAssociation )
+{
+	ULONGLONG				ElapsedMilliseconds;
+	double					ElapsedSeconds;
+	double					ImagesPerSecond;
+	double					MegabytesPerSecond;
+	char					TextString[ MAX_LOGGING_STRING_LENGTH ];
+
+	// *[4] If the client's host name wasn't known when the connection was accepted, it may have been found since.
+	if ( strcmp( pAssociation -> RemoteNodeName, pAssociation -> RemoteIPAddress ) == 0 )
+		LookUpCachedHostName( inet_addr( pAssociation -> RemoteIPAddress ), pAssociation -> RemoteNodeName, FALSE );
+	if ( pAssociation -> nImagesReceived > 0 )
+		{
+		ElapsedMilliseconds = GetTickCount64() - pAssociation -> AssociationStartTime;
+		if ( ElapsedMilliseconds == 0 )
+			ElapsedMilliseconds = 1;
+		ElapsedSeconds = (double)ElapsedMilliseconds / 1000.0;
+		ImagesPerSecond = (double)pAssociation -> nImagesReceived / ElapsedSeconds;
+		MegabytesPerSecond = (double)pAssociation -> nImageBytesReceived / ( 1048576.0 * ElapsedSeconds );
+		_snprintf_s( TextString, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
+						"Association with %s received %d images (%I64u bytes) in %.3f seconds:  %.2f images/sec, %.2f MB/sec.",
+							pAssociation -> RemoteNodeName, pAssociation -> nImagesReceived, pAssociation -> nImageBytesReceived,
+							ElapsedSeconds, ImagesPerSecond, MegabytesPerSecond );
+		LogMessage( TextString, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+}
+
+
 BOOL PrepareCEchoResponseBuffer( DICOM_ASSOCIATION *pAssociation )
 {
 	BOOL							bNoError = TRUE;
@@ -27,6 +27,15 @@
 //	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 //	THE SOFTWARE.
 //
+// UPDATE HISTORY:
+//
+//	*[2] 10/19/2026 by agent
+//		The host name cache moved to HostNameCache.cpp.  The lookup threads are
+//		tracked, so that the module can wait for them when it is closed.
+//	*[1] 10/19/2026 by agent
+//		Added the host name cache for connecting clients.
+//
+//
 #pragma once
 
 #define DICOMACCEPT_ERROR_INSUFFICIENT_MEMORY			1
@@ -44,13 +53,35 @@
 #define DICOMACCEPT_ERROR_PARSE_EXPECT_IMPL_VER_NAME	13
 #define DICOMACCEPT_ERROR_START_OP_THREAD				14
 #define DICOMACCEPT_ERROR_LISTEN_SOCKET_SHUTDOWN		15
+#define DICOMACCEPT_ERROR_HOST_NAME_CACHE_ACCESS		16
 
-#define DICOMACCEPT_ERROR_DICT_LENGTH					15
+#define DICOMACCEPT_ERROR_DICT_LENGTH					16
 
 
 #define	PRV_LISTENBACKLOG		50
 
 
+// *[1] The host names of connecting clients are looked up on a separate thread, so that a slow
+// DNS server doesn't hold up the acceptance of connections.  The results are cached.
+#define MAX_HOST_NAME_CACHE_ENTRIES			64
+#define HOST_NAME_CACHE_LIFETIME			3600000		// Keep a resolved host name for an hour.
+#define HOST_NAME_CACHE_FAILURE_LIFETIME	300000		// Wait five minutes before retrying a failed lookup.
+#define HOST_NAME_CACHE_ACCESS_TIMEOUT		3000
+#define HOST_NAME_LOOKUP_SHUTDOWN_TIMEOUT	20000		// *[2] Longer than a Windows DNS query takes to time out.
+
+typedef struct
+	{
+	unsigned long		IPAddress;								// Network byte order.  Zero if the entry is unused.
+	char				HostName[ MAX_CFG_STRING_LENGTH ];		// Empty if the host name is not known.
+	BOOL				bLookupPending;
+	HANDLE				hLookupThread;							// *[2] The thread of the latest lookup, or zero.
+	ULONGLONG			ExpirationTime;							// System tick count (milliseconds).
+	} HOST_NAME_CACHE_ENTRY;
+
+// *[2] The host name lookups call GetWindowsHostByAddress(), unless a test substitutes a stand-in.
+typedef BOOL (*HOST_NAME_RESOLVER)( char *pAddressBuffer, int AddressLength, int AddressType, struct hostent **ppHostInformation );
+
+
 
 // Function prototypes.
 //
@@ -61,6 +92,12 @@ BOOL				ListenForDicomAssociationRequests( PRODUCT_OPERATION *pProductOperation,
 BOOL				InitializeSocketForListening( char *pNetworkAddress );
 void				TerminateListeningSocket();
 BOOL				RespondToConnectionRequests( PRODUCT_OPERATION *pProductOperation );
+void				LogAssociationReceptionRate( DICOM_ASSOCIATION *pAssociation );
+void				InitHostNameCache();
+void				CloseHostNameCache();
+void				SetHostNameResolver( HOST_NAME_RESOLVER NewHostNameResolver );
+BOOL				LookUpCachedHostName( unsigned long IPAddress, char *pHostName, BOOL bResolveIfMissing );
+unsigned __stdcall	ResolveHostNameThreadFunction( void *pIPAddress );
 BOOL				PrepareCEchoResponseBuffer( DICOM_ASSOCIATION *pAssociation );
 BOOL				PrepareCEchoCommandResponseBuffer( DICOM_ASSOCIATION *pAssociation, char **ppBuffer, unsigned long *pBufferSize );
 BOOL				PrepareCStoreResponseBuffer( DICOM_ASSOCIATION *pAssociation, BOOL bNoError );
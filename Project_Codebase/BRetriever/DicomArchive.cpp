@@ -0,0 +1,814 @@
+// DicomArchive.cpp : Implements the functions that store the archived Dicom image files in
+//  per-study pack files, and that extract and compact them.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include "Module.h"
+#include <io.h>
+#include "ReportStatus.h"
+#include "ServiceMain.h"
+#include "DicomArchive.h"
+#include "zlib.h"
+
+
+//___________________________________________________________________________
+//
+// The module header for this module:
+//
+
+static MODULE_INFO		DicomArchiveModuleInfo = { MODULE_ARCHIVE, "Dicom Archive Module", InitDicomArchiveModule, CloseDicomArchiveModule };
+
+
+static ERROR_DICTIONARY_ENTRY	DicomArchiveErrorCodes[] =
+			{
+				{ ARCHIVE_ERROR_INSUFFICIENT_MEMORY			, "There is not enough memory to allocate a data structure." },
+				{ ARCHIVE_ERROR_PACK_OPEN					, "An error occurred opening an archive pack file." },
+				{ ARCHIVE_ERROR_PACK_READ					, "An error occurred reading an archive pack file." },
+				{ ARCHIVE_ERROR_PACK_WRITE					, "An error occurred writing an archive pack file." },
+				{ ARCHIVE_ERROR_PACK_FORMAT					, "The archive pack file header is invalid." },
+				{ ARCHIVE_ERROR_MEMBER_FORMAT				, "An archive pack member header is invalid." },
+				{ ARCHIVE_ERROR_MEMBER_CRC					, "The contents of an archive pack member are corrupted." },
+				{ ARCHIVE_ERROR_MEMBER_NOT_FOUND			, "The requested file was not found in the archive pack." },
+				{ ARCHIVE_ERROR_COMPRESSION					, "An error occurred compressing or decompressing an archive pack member." },
+				{ ARCHIVE_ERROR_SOURCE_FILE_READ			, "An error occurred reading a file to be archived." },
+				{ ARCHIVE_ERROR_EXTRACT_FILE_WRITE			, "An error occurred writing a file extracted from an archive pack." },
+				{ 0											, NULL }
+			};
+
+
+static ERROR_DICTIONARY_MODULE		DicomArchiveStatusErrorDictionary =
+										{
+										MODULE_ARCHIVE,
+										DicomArchiveErrorCodes,
+										ARCHIVE_ERROR_DICT_LENGTH,
+										0
+										};
+
+
+extern CONFIGURATION			ServiceConfiguration;
+
+// The pack currently open for appending.  It is only accessed by the Process Image operation thread.
+static FILE						*pAppendPackFile = 0;
+static char						AppendPackFileSpec[ MAX_FILE_SPEC_LENGTH ];
+static ARCHIVE_PACK_HEADER		AppendPackHeader;
+static unsigned long			nUnflushedMembers = 0L;
+
+
+
+// This function must be called before any other function in this module.
+void InitDicomArchiveModule()
+{
+	LinkModuleToList( &DicomArchiveModuleInfo );
+	RegisterErrorDictionary( &DicomArchiveStatusErrorDictionary );
+	pAppendPackFile = 0;
+	AppendPackFileSpec[ 0 ] = '\0';
+	nUnflushedMembers = 0L;
+}
+
+
+void CloseDicomArchiveModule()
+{
+	FlushArchivePack();
+}
+
+
+static unsigned long ComputePackHeaderCRC( ARCHIVE_PACK_HEADER *pPackHeader )
+{
+	return crc32( 0L, (Bytef*)pPackHeader, sizeof(ARCHIVE_PACK_HEADER) - sizeof(unsigned long) );
+}
+
+
+static unsigned long ComputeMemberHeaderCRC( ARCHIVE_MEMBER_HEADER *pMemberHeader )
+{
+	return crc32( 0L, (Bytef*)pMemberHeader, sizeof(ARCHIVE_MEMBER_HEADER) - sizeof(unsigned long) );
+}
+
+
+static BOOL WritePackHeader( FILE *pPackFile, ARCHIVE_PACK_HEADER *pPackHeader )
+{
+	BOOL			bNoError = TRUE;
+
+	pPackHeader -> HeaderCRC = ComputePackHeaderCRC( pPackHeader );
+	bNoError = ( _fseeki64( pPackFile, 0, SEEK_SET ) == 0 );
+	if ( bNoError )
+		bNoError = ( fwrite( pPackHeader, 1, sizeof(ARCHIVE_PACK_HEADER), pPackFile ) == sizeof(ARCHIVE_PACK_HEADER) );
+	if ( !bNoError )
+		RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_WRITE );
+
+	return bNoError;
+}
+
+
+static BOOL ReadPackHeader( FILE *pPackFile, ARCHIVE_PACK_HEADER *pPackHeader )
+{
+	BOOL			bNoError = TRUE;
+
+	bNoError = ( _fseeki64( pPackFile, 0, SEEK_SET ) == 0 );
+	if ( bNoError )
+		bNoError = ( fread( pPackHeader, 1, sizeof(ARCHIVE_PACK_HEADER), pPackFile ) == sizeof(ARCHIVE_PACK_HEADER) );
+	if ( !bNoError )
+		RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_READ );
+	else
+		{
+		bNoError = ( pPackHeader -> Signature == ARCHIVE_PACK_SIGNATURE && pPackHeader -> Version == ARCHIVE_PACK_VERSION &&
+						pPackHeader -> HeaderCRC == ComputePackHeaderCRC( pPackHeader ) &&
+						pPackHeader -> CommittedLength >= (__int64)sizeof(ARCHIVE_PACK_HEADER) );
+		if ( !bNoError )
+			RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_FORMAT );
+		}
+
+	return bNoError;
+}
+
+
+static BOOL OpenPackForReading( char *pPackFileSpec, FILE **ppPackFile, ARCHIVE_PACK_HEADER *pPackHeader )
+{
+	BOOL			bNoError = TRUE;
+	FILE			*pPackFile;
+	errno_t			FileError;
+
+	pPackFile = 0;
+	FileError = fopen_s( &pPackFile, pPackFileSpec, "rb" );
+	if ( FileError != 0 || pPackFile == 0 )
+		{
+		bNoError = FALSE;
+		pPackFile = 0;
+		RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_OPEN );
+		}
+	if ( bNoError )
+		{
+		bNoError = ReadPackHeader( pPackFile, pPackHeader );
+		if ( !bNoError )
+			{
+			fclose( pPackFile );
+			pPackFile = 0;
+			}
+		}
+	*ppPackFile = pPackFile;
+
+	return bNoError;
+}
+
+
+// Commit the appended members to the disk, then rewrite the pack header to include them.  The
+// header is committed separately, so it never refers to data that has not reached the disk.
+static BOOL CommitArchivePack( FILE *pPackFile, ARCHIVE_PACK_HEADER *pPackHeader )
+{
+	BOOL			bNoError = TRUE;
+
+	bNoError = ( fflush( pPackFile ) == 0 && _commit( _fileno( pPackFile ) ) == 0 );
+	if ( !bNoError )
+		RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_WRITE );
+	if ( bNoError )
+		bNoError = WritePackHeader( pPackFile, pPackHeader );
+	if ( bNoError )
+		{
+		bNoError = ( fflush( pPackFile ) == 0 && _commit( _fileno( pPackFile ) ) == 0 );
+		if ( !bNoError )
+			RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_WRITE );
+		}
+	nUnflushedMembers = 0L;
+
+	return bNoError;
+}
+
+
+static BOOL MemberHeaderIsValid( ARCHIVE_MEMBER_HEADER *pMemberHeader, __int64 MemberOffset, __int64 PackLength )
+{
+	return ( pMemberHeader -> Signature == ARCHIVE_MEMBER_SIGNATURE &&
+				pMemberHeader -> HeaderCRC == ComputeMemberHeaderCRC( pMemberHeader ) &&
+				MemberOffset + (__int64)sizeof(ARCHIVE_MEMBER_HEADER) + pMemberHeader -> StoredSize <= PackLength );
+}
+
+
+// Read the contents of the member whose header has just been read, and verify them against the CRC.
+// Any error code is returned instead of being reported, so a pack can be checked quietly.
+static unsigned long DecodeMemberContents( FILE *pPackFile, ARCHIVE_MEMBER_HEADER *pMemberHeader, char **ppFileContents )
+{
+	unsigned long	ErrorCode = 0L;
+	char			*pStoredContents;
+	char			*pFileContents;
+	uLongf			InflatedSize;
+
+	pFileContents = 0;
+	pStoredContents = (char*)malloc( pMemberHeader -> StoredSize + 1 );
+	if ( pStoredContents == 0 )
+		ErrorCode = ARCHIVE_ERROR_INSUFFICIENT_MEMORY;
+	else if ( fread( pStoredContents, 1, pMemberHeader -> StoredSize, pPackFile ) != pMemberHeader -> StoredSize )
+		ErrorCode = ARCHIVE_ERROR_PACK_READ;
+	if ( ErrorCode == 0 )
+		{
+		if ( pMemberHeader -> CompressionMethod == ARCHIVE_MEMBER_STORED )
+			{
+			if ( pMemberHeader -> StoredSize != pMemberHeader -> OriginalSize )
+				ErrorCode = ARCHIVE_ERROR_MEMBER_FORMAT;
+			pFileContents = pStoredContents;
+			pStoredContents = 0;
+			}
+		else if ( pMemberHeader -> CompressionMethod == ARCHIVE_MEMBER_DEFLATED )
+			{
+			pFileContents = (char*)malloc( pMemberHeader -> OriginalSize + 1 );
+			if ( pFileContents == 0 )
+				ErrorCode = ARCHIVE_ERROR_INSUFFICIENT_MEMORY;
+			else
+				{
+				InflatedSize = pMemberHeader -> OriginalSize;
+				if ( uncompress( (Bytef*)pFileContents, &InflatedSize, (Bytef*)pStoredContents, pMemberHeader -> StoredSize ) != Z_OK ||
+								InflatedSize != pMemberHeader -> OriginalSize )
+					ErrorCode = ARCHIVE_ERROR_COMPRESSION;
+				}
+			}
+		else
+			ErrorCode = ARCHIVE_ERROR_MEMBER_FORMAT;
+		}
+	if ( ErrorCode == 0 && crc32( 0L, (Bytef*)pFileContents, pMemberHeader -> OriginalSize ) != pMemberHeader -> DataCRC )
+		ErrorCode = ARCHIVE_ERROR_MEMBER_CRC;
+	if ( pStoredContents != 0 )
+		free( pStoredContents );
+	if ( ErrorCode != 0 && pFileContents != 0 )
+		{
+		free( pFileContents );
+		pFileContents = 0;
+		}
+	*ppFileContents = pFileContents;
+
+	return ErrorCode;
+}
+
+
+// Verify the members following the specified offset, up to the end of the file, and add each
+// intact one to the append pack header.  The search stops at the first incomplete or damaged
+// member, since the location of any member following it is unknown.
+static void RecoverArchivePackMembers( FILE *pPackFile, __int64 MemberOffset, __int64 FileSize )
+{
+	BOOL						bMemberIsIntact;
+	ARCHIVE_MEMBER_HEADER		MemberHeader;
+	char						*pFileContents;
+
+	AppendPackHeader.CommittedLength = MemberOffset;
+	bMemberIsIntact = TRUE;
+	while ( bMemberIsIntact && MemberOffset + (__int64)sizeof(ARCHIVE_MEMBER_HEADER) <= FileSize )
+		{
+		bMemberIsIntact = ( _fseeki64( pPackFile, MemberOffset, SEEK_SET ) == 0 &&
+								fread( &MemberHeader, 1, sizeof(ARCHIVE_MEMBER_HEADER), pPackFile ) == sizeof(ARCHIVE_MEMBER_HEADER) &&
+								MemberHeaderIsValid( &MemberHeader, MemberOffset, FileSize ) );
+		if ( bMemberIsIntact )
+			{
+			bMemberIsIntact = ( DecodeMemberContents( pPackFile, &MemberHeader, &pFileContents ) == 0 );
+			if ( pFileContents != 0 )
+				free( pFileContents );
+			}
+		if ( bMemberIsIntact )
+			{
+			MemberOffset += sizeof(ARCHIVE_MEMBER_HEADER) + MemberHeader.StoredSize;
+			AppendPackHeader.nMembers++;
+			AppendPackHeader.CommittedLength = MemberOffset;
+			}
+		}
+}
+
+
+// Open the specified pack for appending, creating it if necessary.  Intact members written after
+// the last commit are kept, and anything following them is discarded.
+static BOOL OpenPackForAppending( char *pPackFileSpec )
+{
+	BOOL			bNoError = TRUE;
+	BOOL			bPackHeaderIsValid;
+	FILE			*pPackFile;
+	errno_t			FileError;
+	__int64			FileSize;
+	__int64			CommittedLength;
+
+	pPackFile = 0;
+	FileSize = GetFileSizeInBytes( pPackFileSpec );
+	if ( FileSize > 0 )
+		FileError = fopen_s( &pPackFile, pPackFileSpec, "r+b" );
+	else
+		FileError = fopen_s( &pPackFile, pPackFileSpec, "w+b" );
+	if ( FileError != 0 || pPackFile == 0 )
+		{
+		bNoError = FALSE;
+		pPackFile = 0;
+		RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_OPEN );
+		}
+	if ( bNoError )
+		{
+		if ( FileSize > 0 )
+			{
+			// A file that doesn't start with a pack signature is not a pack, and is left alone.
+			bNoError = ( FileSize >= (__int64)sizeof(ARCHIVE_PACK_HEADER) && _fseeki64( pPackFile, 0, SEEK_SET ) == 0 &&
+							fread( &AppendPackHeader, 1, sizeof(ARCHIVE_PACK_HEADER), pPackFile ) == sizeof(ARCHIVE_PACK_HEADER) &&
+							AppendPackHeader.Signature == ARCHIVE_PACK_SIGNATURE && AppendPackHeader.Version == ARCHIVE_PACK_VERSION );
+			if ( !bNoError )
+				RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_FORMAT );
+			}
+		if ( bNoError && FileSize > 0 )
+			{
+			CommittedLength = AppendPackHeader.CommittedLength;
+			bPackHeaderIsValid = ( AppendPackHeader.HeaderCRC == ComputePackHeaderCRC( &AppendPackHeader ) &&
+										CommittedLength >= (__int64)sizeof(ARCHIVE_PACK_HEADER) && CommittedLength <= FileSize );
+			if ( bPackHeaderIsValid )
+				RecoverArchivePackMembers( pPackFile, CommittedLength, FileSize );
+			else
+				{
+				LogMessage( "The archive pack header is damaged.  Verifying every archived file in the pack.", MESSAGE_TYPE_SUPPLEMENTARY );
+				AppendPackHeader.nMembers = 0L;
+				RecoverArchivePackMembers( pPackFile, sizeof(ARCHIVE_PACK_HEADER), FileSize );
+				}
+			if ( AppendPackHeader.CommittedLength < FileSize )
+				{
+				LogMessage( "Discarding an incompletely archived file from the end of the archive pack.", MESSAGE_TYPE_SUPPLEMENTARY );
+				bNoError = ( _fseeki64( pPackFile, 0, SEEK_SET ) == 0 &&
+								_chsize_s( _fileno( pPackFile ), AppendPackHeader.CommittedLength ) == 0 );
+				if ( !bNoError )
+					RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_WRITE );
+				}
+			if ( bNoError && ( !bPackHeaderIsValid || AppendPackHeader.CommittedLength != CommittedLength ) )
+				bNoError = CommitArchivePack( pPackFile, &AppendPackHeader );
+			}
+		else if ( bNoError )
+			{
+			memset( &AppendPackHeader, 0, sizeof(ARCHIVE_PACK_HEADER) );
+			AppendPackHeader.Signature = ARCHIVE_PACK_SIGNATURE;
+			AppendPackHeader.Version = ARCHIVE_PACK_VERSION;
+			AppendPackHeader.nMembers = 0L;
+			AppendPackHeader.CommittedLength = sizeof(ARCHIVE_PACK_HEADER);
+			bNoError = CommitArchivePack( pPackFile, &AppendPackHeader );
+			}
+		}
+	if ( bNoError )
+		{
+		pAppendPackFile = pPackFile;
+		strncpy_s( AppendPackFileSpec, MAX_FILE_SPEC_LENGTH, pPackFileSpec, _TRUNCATE );
+		nUnflushedMembers = 0L;
+		}
+	else if ( pPackFile != 0 )
+		fclose( pPackFile );
+
+	return bNoError;
+}
+
+
+// Commit any appended members to the disk and close the pack.
+void FlushArchivePack()
+{
+	if ( pAppendPackFile != 0 )
+		{
+		if ( nUnflushedMembers > 0 )
+			CommitArchivePack( pAppendPackFile, &AppendPackHeader );
+		fclose( pAppendPackFile );
+		pAppendPackFile = 0;
+		AppendPackFileSpec[ 0 ] = '\0';
+		nUnflushedMembers = 0L;
+		}
+}
+
+
+static BOOL ReadSourceFile( char *pSourceFileSpec, char **ppFileContents, unsigned long *pFileSize )
+{
+	BOOL			bNoError = TRUE;
+	FILE			*pSourceFile;
+	errno_t			FileError;
+	__int64			FileSize;
+	char			*pFileContents;
+
+	pFileContents = 0;
+	pSourceFile = 0;
+	FileSize = GetFileSizeInBytes( pSourceFileSpec );
+	bNoError = ( FileSize > 0 && FileSize < 0x7FFFFFFF );
+	if ( bNoError )
+		{
+		FileError = fopen_s( &pSourceFile, pSourceFileSpec, "rb" );
+		bNoError = ( FileError == 0 && pSourceFile != 0 );
+		}
+	if ( bNoError )
+		{
+		pFileContents = (char*)malloc( (size_t)FileSize );
+		if ( pFileContents == 0 )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_INSUFFICIENT_MEMORY );
+			}
+		else
+			bNoError = ( fread( pFileContents, 1, (size_t)FileSize, pSourceFile ) == (size_t)FileSize );
+		}
+	if ( pSourceFile != 0 )
+		fclose( pSourceFile );
+	if ( bNoError )
+		{
+		*ppFileContents = pFileContents;
+		*pFileSize = (unsigned long)FileSize;
+		}
+	else
+		{
+		RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_SOURCE_FILE_READ );
+		if ( pFileContents != 0 )
+			free( pFileContents );
+		*ppFileContents = 0;
+		*pFileSize = 0L;
+		}
+
+	return bNoError;
+}
+
+
+// Append a copy of the source file to the pack for the specified study.  If the pack already
+// contains a member with the same name, the new member supersedes it.
+BOOL AppendToArchivePack( char *pArchiveDirectory, char *pStudyInstanceUID, char *pMemberName, char *pSourceFileSpec )
+{
+	BOOL						bNoError = TRUE;
+	char						PackFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char						*pFileContents;
+	unsigned long				FileSize;
+	unsigned char				*pDeflatedContents;
+	uLongf						DeflatedSize;
+	ARCHIVE_MEMBER_HEADER		MemberHeader;
+	char						*pStoredContents;
+
+	pFileContents = 0;
+	pDeflatedContents = 0;
+	strncpy_s( PackFileSpec, MAX_FILE_SPEC_LENGTH, pArchiveDirectory, _TRUNCATE );
+	LocateOrCreateDirectory( PackFileSpec );	// Ensure directory exists.
+	if ( PackFileSpec[ strlen( PackFileSpec ) - 1 ] != '\\' )
+		strncat_s( PackFileSpec, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );
+	if ( pStudyInstanceUID != 0 && strlen( pStudyInstanceUID ) > 0 )
+		strncat_s( PackFileSpec, MAX_FILE_SPEC_LENGTH, pStudyInstanceUID, _TRUNCATE );
+	else
+		strncat_s( PackFileSpec, MAX_FILE_SPEC_LENGTH, "UnknownStudy", _TRUNCATE );
+	strncat_s( PackFileSpec, MAX_FILE_SPEC_LENGTH, ARCHIVE_PACK_FILE_EXTENSION, _TRUNCATE );
+
+	// Keep the current pack open while images from the same study are being archived.
+	if ( pAppendPackFile != 0 && _stricmp( PackFileSpec, AppendPackFileSpec ) != 0 )
+		FlushArchivePack();
+	if ( pAppendPackFile == 0 )
+		bNoError = OpenPackForAppending( PackFileSpec );
+	if ( bNoError )
+		bNoError = ReadSourceFile( pSourceFileSpec, &pFileContents, &FileSize );
+	if ( bNoError )
+		{
+		memset( &MemberHeader, 0, sizeof(ARCHIVE_MEMBER_HEADER) );
+		MemberHeader.Signature = ARCHIVE_MEMBER_SIGNATURE;
+		strncpy_s( MemberHeader.MemberName, MAX_ARCHIVE_MEMBER_NAME_LENGTH, pMemberName, _TRUNCATE );
+		MemberHeader.OriginalSize = FileSize;
+		MemberHeader.DataCRC = crc32( 0L, (Bytef*)pFileContents, FileSize );
+		MemberHeader.CompressionMethod = ARCHIVE_MEMBER_STORED;
+		MemberHeader.StoredSize = FileSize;
+		pStoredContents = pFileContents;
+		// Members are deflated only if this saves at least 1/16th of their size.  Many archived
+		// images are already JPEG compressed.
+		if ( ServiceConfiguration.bCompressDicomImageArchive )
+			{
+			DeflatedSize = compressBound( FileSize );
+			pDeflatedContents = (unsigned char*)malloc( DeflatedSize );
+			// If compression fails, the member is simply stored.
+			if ( pDeflatedContents != 0 &&
+						compress2( pDeflatedContents, &DeflatedSize, (Bytef*)pFileContents, FileSize, Z_BEST_SPEED ) == Z_OK &&
+						DeflatedSize < FileSize - FileSize / 16 )
+				{
+				MemberHeader.CompressionMethod = ARCHIVE_MEMBER_DEFLATED;
+				MemberHeader.StoredSize = (unsigned long)DeflatedSize;
+				pStoredContents = (char*)pDeflatedContents;
+				}
+			}
+		MemberHeader.HeaderCRC = ComputeMemberHeaderCRC( &MemberHeader );
+		// Write the member following the last one appended.  It is included in the pack header when
+		// the pack is next committed.
+		bNoError = ( _fseeki64( pAppendPackFile, AppendPackHeader.CommittedLength, SEEK_SET ) == 0 );
+		if ( bNoError )
+			bNoError = ( fwrite( &MemberHeader, 1, sizeof(ARCHIVE_MEMBER_HEADER), pAppendPackFile ) == sizeof(ARCHIVE_MEMBER_HEADER) );
+		if ( bNoError )
+			bNoError = ( fwrite( pStoredContents, 1, MemberHeader.StoredSize, pAppendPackFile ) == MemberHeader.StoredSize );
+		if ( bNoError )
+			{
+			AppendPackHeader.nMembers++;
+			AppendPackHeader.CommittedLength += sizeof(ARCHIVE_MEMBER_HEADER) + MemberHeader.StoredSize;
+			}
+		else
+			RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_WRITE );
+		}
+	if ( pFileContents != 0 )
+		free( pFileContents );
+	if ( pDeflatedContents != 0 )
+		free( pDeflatedContents );
+	if ( bNoError )
+		{
+		nUnflushedMembers++;
+		if ( nUnflushedMembers >= MAX_UNFLUSHED_ARCHIVE_MEMBERS )
+			bNoError = CommitArchivePack( pAppendPackFile, &AppendPackHeader );
+		}
+	if ( !bNoError && pAppendPackFile != 0 )
+		{
+		// Close the pack without committing it.  The intact members appended since the last
+		// commit are recovered when it is next opened, and any partial member is discarded.
+		fclose( pAppendPackFile );
+		pAppendPackFile = 0;
+		AppendPackFileSpec[ 0 ] = '\0';
+		}
+
+	return bNoError;
+}
+
+
+static BOOL ReadMemberHeader( FILE *pPackFile, ARCHIVE_MEMBER_HEADER *pMemberHeader, __int64 MemberOffset, __int64 CommittedLength )
+{
+	BOOL			bNoError = TRUE;
+
+	bNoError = ( _fseeki64( pPackFile, MemberOffset, SEEK_SET ) == 0 &&
+					fread( pMemberHeader, 1, sizeof(ARCHIVE_MEMBER_HEADER), pPackFile ) == sizeof(ARCHIVE_MEMBER_HEADER) );
+	if ( !bNoError )
+		RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_READ );
+	else
+		{
+		bNoError = MemberHeaderIsValid( pMemberHeader, MemberOffset, CommittedLength );
+		if ( bNoError )
+			pMemberHeader -> MemberName[ MAX_ARCHIVE_MEMBER_NAME_LENGTH - 1 ] = '\0';
+		else
+			RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_MEMBER_FORMAT );
+		}
+
+	return bNoError;
+}
+
+
+static BOOL ReadMemberContents( FILE *pPackFile, ARCHIVE_MEMBER_HEADER *pMemberHeader, char **ppFileContents )
+{
+	BOOL			bNoError = TRUE;
+	unsigned long	ErrorCode;
+
+	ErrorCode = DecodeMemberContents( pPackFile, pMemberHeader, ppFileContents );
+	if ( ErrorCode != 0 )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_ARCHIVE, ErrorCode );
+		}
+
+	return bNoError;
+}
+
+
+// A member name becomes a file name when it is extracted.  Don't let it specify a different folder.
+static BOOL MemberNameIsSafe( char *pMemberName )
+{
+	return ( strlen( pMemberName ) > 0 && strchr( pMemberName, '\\' ) == 0 && strchr( pMemberName, '/' ) == 0 &&
+				strchr( pMemberName, ':' ) == 0 && strcmp( pMemberName, ".." ) != 0 && strcmp( pMemberName, "." ) != 0 );
+}
+
+
+// Extract every member of the pack into the output directory, verifying each one.  Where a name
+// appears more than once, the most recently archived member is the one left in the directory.
+BOOL ExtractArchivePack( char *pPackFileSpec, char *pOutputDirectory )
+{
+	BOOL						bNoError = TRUE;
+	BOOL						bMemberIsValid;
+	FILE						*pPackFile;
+	FILE						*pOutputFile;
+	errno_t						FileError;
+	ARCHIVE_PACK_HEADER			PackHeader;
+	ARCHIVE_MEMBER_HEADER		MemberHeader;
+	__int64						MemberOffset;
+	unsigned long				nMember;
+	unsigned long				nMembersExtracted;
+	unsigned long				nMembersCorrupted;
+	char						*pFileContents;
+	char						OutputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char						TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	nMembersExtracted = 0L;
+	nMembersCorrupted = 0L;
+	PackHeader.nMembers = 0L;
+	LocateOrCreateDirectory( pOutputDirectory );	// Ensure directory exists.
+	bNoError = OpenPackForReading( pPackFileSpec, &pPackFile, &PackHeader );
+	if ( bNoError )
+		{
+		MemberOffset = sizeof(ARCHIVE_PACK_HEADER);
+		// If a member header is unreadable, the location of the following member is unknown, so stop there.
+		for ( nMember = 0; bNoError && nMember < PackHeader.nMembers; nMember++ )
+			{
+			bNoError = ReadMemberHeader( pPackFile, &MemberHeader, MemberOffset, PackHeader.CommittedLength );
+			if ( bNoError )
+				{
+				bMemberIsValid = MemberNameIsSafe( MemberHeader.MemberName );
+				if ( !bMemberIsValid )
+					RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_MEMBER_FORMAT );
+				else
+					bMemberIsValid = ReadMemberContents( pPackFile, &MemberHeader, &pFileContents );
+				if ( bMemberIsValid )
+					{
+					strncpy_s( OutputFileSpec, MAX_FILE_SPEC_LENGTH, pOutputDirectory, _TRUNCATE );
+					if ( OutputFileSpec[ strlen( OutputFileSpec ) - 1 ] != '\\' )
+						strncat_s( OutputFileSpec, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );
+					strncat_s( OutputFileSpec, MAX_FILE_SPEC_LENGTH, MemberHeader.MemberName, _TRUNCATE );
+					pOutputFile = 0;
+					FileError = fopen_s( &pOutputFile, OutputFileSpec, "wb" );
+					bMemberIsValid = ( FileError == 0 && pOutputFile != 0 );
+					if ( bMemberIsValid )
+						{
+						bMemberIsValid = ( fwrite( pFileContents, 1, MemberHeader.OriginalSize, pOutputFile ) == MemberHeader.OriginalSize );
+						fclose( pOutputFile );
+						}
+					free( pFileContents );
+					if ( bMemberIsValid )
+						nMembersExtracted++;
+					else
+						{
+						bNoError = FALSE;
+						RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_EXTRACT_FILE_WRITE );
+						}
+					}
+				else
+					{
+					nMembersCorrupted++;
+					_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE, "    Archived file %s could not be extracted.", MemberHeader.MemberName );
+					LogMessage( TextLine, MESSAGE_TYPE_ERROR );
+					}
+				MemberOffset += sizeof(ARCHIVE_MEMBER_HEADER) + MemberHeader.StoredSize;
+				}
+			}
+		fclose( pPackFile );
+		}
+	_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE, "Extracted %d of %d archived files from %s.  %d were corrupted.",
+					nMembersExtracted, PackHeader.nMembers, pPackFileSpec, nMembersCorrupted );
+	LogMessage( TextLine, MESSAGE_TYPE_NORMAL_LOG );
+
+	return ( bNoError && nMembersCorrupted == 0 );
+}
+
+
+typedef struct
+	{
+	char				MemberName[ MAX_ARCHIVE_MEMBER_NAME_LENGTH ];
+	__int64				MemberOffset;
+	BOOL				bRetain;
+	} ARCHIVE_MEMBER_LOCATION;
+
+
+// Rewrite the pack, leaving out the members superseded by a later member with the same name and
+// any members whose contents are corrupted.  The stored contents are copied without being
+// recompressed.
+BOOL CompactArchivePack( char *pPackFileSpec )
+{
+	BOOL						bNoError = TRUE;
+	FILE						*pPackFile;
+	FILE						*pCompactedPackFile;
+	errno_t						FileError;
+	ARCHIVE_PACK_HEADER			PackHeader;
+	ARCHIVE_PACK_HEADER			CompactedPackHeader;
+	ARCHIVE_MEMBER_HEADER		MemberHeader;
+	ARCHIVE_MEMBER_LOCATION		*pMemberLocations;
+	unsigned long				nMember;
+	unsigned long				nOtherMember;
+	__int64						MemberOffset;
+	char						*pFileContents;
+	char						*pStoredContents;
+	char						CompactedPackFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char						TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	pPackFile = 0;
+	pCompactedPackFile = 0;
+	pMemberLocations = 0;
+	// A pack being appended to must be committed before it can be compacted.
+	if ( pAppendPackFile != 0 && _stricmp( pPackFileSpec, AppendPackFileSpec ) == 0 )
+		FlushArchivePack();
+	bNoError = OpenPackForReading( pPackFileSpec, &pPackFile, &PackHeader );
+	if ( bNoError )
+		{
+		pMemberLocations = (ARCHIVE_MEMBER_LOCATION*)calloc( PackHeader.nMembers + 1, sizeof(ARCHIVE_MEMBER_LOCATION) );
+		if ( pMemberLocations == 0 )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_INSUFFICIENT_MEMORY );
+			}
+		}
+	// Locate each member and verify its contents.
+	MemberOffset = sizeof(ARCHIVE_PACK_HEADER);
+	for ( nMember = 0; bNoError && nMember < PackHeader.nMembers; nMember++ )
+		{
+		bNoError = ReadMemberHeader( pPackFile, &MemberHeader, MemberOffset, PackHeader.CommittedLength );
+		if ( bNoError )
+			{
+			strncpy_s( pMemberLocations[ nMember ].MemberName, MAX_ARCHIVE_MEMBER_NAME_LENGTH, MemberHeader.MemberName, _TRUNCATE );
+			pMemberLocations[ nMember ].MemberOffset = MemberOffset;
+			pMemberLocations[ nMember ].bRetain = ReadMemberContents( pPackFile, &MemberHeader, &pFileContents );
+			if ( pFileContents != 0 )
+				free( pFileContents );
+			MemberOffset += sizeof(ARCHIVE_MEMBER_HEADER) + MemberHeader.StoredSize;
+			}
+		}
+	// Drop the members superseded by a later valid member.
+	for ( nMember = 0; bNoError && nMember < PackHeader.nMembers; nMember++ )
+		for ( nOtherMember = nMember + 1; pMemberLocations[ nMember ].bRetain && nOtherMember < PackHeader.nMembers; nOtherMember++ )
+			if ( pMemberLocations[ nOtherMember ].bRetain &&
+						_stricmp( pMemberLocations[ nMember ].MemberName, pMemberLocations[ nOtherMember ].MemberName ) == 0 )
+				pMemberLocations[ nMember ].bRetain = FALSE;
+	if ( bNoError )
+		{
+		strncpy_s( CompactedPackFileSpec, MAX_FILE_SPEC_LENGTH, pPackFileSpec, _TRUNCATE );
+		strncat_s( CompactedPackFileSpec, MAX_FILE_SPEC_LENGTH, ".tmp", _TRUNCATE );
+		FileError = fopen_s( &pCompactedPackFile, CompactedPackFileSpec, "w+b" );
+		if ( FileError != 0 || pCompactedPackFile == 0 )
+			{
+			bNoError = FALSE;
+			pCompactedPackFile = 0;
+			RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_OPEN );
+			}
+		}
+	if ( bNoError )
+		{
+		memset( &CompactedPackHeader, 0, sizeof(ARCHIVE_PACK_HEADER) );
+		CompactedPackHeader.Signature = ARCHIVE_PACK_SIGNATURE;
+		CompactedPackHeader.Version = ARCHIVE_PACK_VERSION;
+		CompactedPackHeader.nMembers = 0L;
+		CompactedPackHeader.CommittedLength = sizeof(ARCHIVE_PACK_HEADER);
+		bNoError = WritePackHeader( pCompactedPackFile, &CompactedPackHeader );
+		}
+	for ( nMember = 0; bNoError && nMember < PackHeader.nMembers; nMember++ )
+		{
+		if ( pMemberLocations[ nMember ].bRetain )
+			{
+			bNoError = ReadMemberHeader( pPackFile, &MemberHeader, pMemberLocations[ nMember ].MemberOffset, PackHeader.CommittedLength );
+			if ( bNoError )
+				{
+				pStoredContents = (char*)malloc( MemberHeader.StoredSize + 1 );
+				if ( pStoredContents == 0 )
+					{
+					bNoError = FALSE;
+					RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_INSUFFICIENT_MEMORY );
+					}
+				}
+			if ( bNoError )
+				{
+				bNoError = ( fread( pStoredContents, 1, MemberHeader.StoredSize, pPackFile ) == MemberHeader.StoredSize );
+				if ( !bNoError )
+					RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_READ );
+				if ( bNoError )
+					{
+					bNoError = ( _fseeki64( pCompactedPackFile, CompactedPackHeader.CommittedLength, SEEK_SET ) == 0 &&
+									fwrite( &MemberHeader, 1, sizeof(ARCHIVE_MEMBER_HEADER), pCompactedPackFile ) == sizeof(ARCHIVE_MEMBER_HEADER) &&
+									fwrite( pStoredContents, 1, MemberHeader.StoredSize, pCompactedPackFile ) == MemberHeader.StoredSize );
+					if ( !bNoError )
+						RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_WRITE );
+					}
+				free( pStoredContents );
+				}
+			if ( bNoError )
+				{
+				CompactedPackHeader.nMembers++;
+				CompactedPackHeader.CommittedLength += sizeof(ARCHIVE_MEMBER_HEADER) + MemberHeader.StoredSize;
+				}
+			}
+		}
+	if ( bNoError )
+		bNoError = WritePackHeader( pCompactedPackFile, &CompactedPackHeader );
+	if ( pCompactedPackFile != 0 )
+		{
+		fflush( pCompactedPackFile );
+		_commit( _fileno( pCompactedPackFile ) );
+		fclose( pCompactedPackFile );
+		}
+	if ( pPackFile != 0 )
+		fclose( pPackFile );
+	if ( bNoError )
+		{
+		// Replace the original pack with the compacted one.
+		bNoError = MoveFileEx( CompactedPackFileSpec, pPackFileSpec, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH );
+		if ( !bNoError )
+			RespondToError( MODULE_ARCHIVE, ARCHIVE_ERROR_PACK_WRITE );
+		}
+	if ( !bNoError && pCompactedPackFile != 0 )
+		DeleteFile( CompactedPackFileSpec );
+	if ( bNoError )
+		{
+		_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE, "Compacted %s from %d to %d archived files.",
+						pPackFileSpec, PackHeader.nMembers, CompactedPackHeader.nMembers );
+		LogMessage( TextLine, MESSAGE_TYPE_NORMAL_LOG );
+		}
+	if ( pMemberLocations != 0 )
+		free( pMemberLocations );
+
+	return bNoError;
+}
+
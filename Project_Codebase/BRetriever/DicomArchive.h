@@ -0,0 +1,112 @@
+// DicomArchive.h - Defines the functions and data structures that store the archived
+// Dicom image files in per-study pack files.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#pragma once
+
+#define ARCHIVE_ERROR_INSUFFICIENT_MEMORY			1
+#define ARCHIVE_ERROR_PACK_OPEN						2
+#define ARCHIVE_ERROR_PACK_READ						3
+#define ARCHIVE_ERROR_PACK_WRITE					4
+#define ARCHIVE_ERROR_PACK_FORMAT					5
+#define ARCHIVE_ERROR_MEMBER_FORMAT					6
+#define ARCHIVE_ERROR_MEMBER_CRC					7
+#define ARCHIVE_ERROR_MEMBER_NOT_FOUND				8
+#define ARCHIVE_ERROR_COMPRESSION					9
+#define ARCHIVE_ERROR_SOURCE_FILE_READ				10
+#define ARCHIVE_ERROR_EXTRACT_FILE_WRITE			11
+
+#define ARCHIVE_ERROR_DICT_LENGTH					11
+
+
+// The archived Dicom image files for each study are appended to a single pack file in the
+// Dicom image archive directory, named for the study instance UID.  This avoids creating a
+// separate file for every archived image.  Each member of the pack is preceded by its own
+// header, which gives the member's name, its size and the CRC of its contents.  A member
+// may be stored as is or deflated.
+//
+// The pack header records the length of the file up to the end of the last committed member.
+// The members are committed to the disk before the header is rewritten to include them, so
+// the header never describes data that may not have reached the disk.  When a pack is opened
+// for appending, the members following the committed length are verified against their CRCs.
+// The intact ones are kept, and anything after the last intact member is left from an
+// interrupted write and is discarded.  If the pack header itself is damaged, every member
+// is verified from the start of the pack.
+//
+#define ARCHIVE_PACK_SIGNATURE				0x4B505242		// "BRPK"
+#define ARCHIVE_MEMBER_SIGNATURE			0x424D5242		// "BRMB"
+#define ARCHIVE_PACK_VERSION				1
+#define ARCHIVE_PACK_FILE_EXTENSION			".pak"
+#define MAX_ARCHIVE_MEMBER_NAME_LENGTH		96
+
+// Appended members are committed to the disk together, rather than one at a time.  The
+// pack is committed after this many members, when a different study's pack is opened, or
+// when the product queue has been emptied.
+#define MAX_UNFLUSHED_ARCHIVE_MEMBERS		32
+
+
+#pragma pack(push)
+#pragma pack(1)		// Pack the archive structure members on 1-byte boundaries, to match the file format.
+
+typedef struct
+	{
+	unsigned long			Signature;					// ARCHIVE_PACK_SIGNATURE.
+	unsigned short			Version;
+	unsigned short			Reserved;
+	unsigned long			nMembers;					// The number of members completely written.
+	__int64					CommittedLength;			// The file length through the last completely written member.
+	unsigned long			HeaderCRC;					// The CRC of the preceding header fields.
+	} ARCHIVE_PACK_HEADER;
+
+
+typedef struct
+	{
+	unsigned long			Signature;					// ARCHIVE_MEMBER_SIGNATURE.
+	char					MemberName[ MAX_ARCHIVE_MEMBER_NAME_LENGTH ];
+	unsigned long			CompressionMethod;
+								#define ARCHIVE_MEMBER_STORED				0
+								#define ARCHIVE_MEMBER_DEFLATED				1
+	unsigned long			StoredSize;					// The number of bytes following this header.
+	unsigned long			OriginalSize;
+	unsigned long			DataCRC;					// The CRC of the original (uncompressed) contents.
+	unsigned long			HeaderCRC;					// The CRC of the preceding header fields.
+	} ARCHIVE_MEMBER_HEADER;
+
+#pragma pack(pop)
+
+
+// Function prototypes.
+//
+void				InitDicomArchiveModule();
+void				CloseDicomArchiveModule();
+
+BOOL				AppendToArchivePack( char *pArchiveDirectory, char *pStudyInstanceUID, char *pMemberName, char *pSourceFileSpec );
+void				FlushArchivePack();
+BOOL				ExtractArchivePack( char *pPackFileSpec, char *pOutputDirectory );
+BOOL				CompactArchivePack( char *pPackFileSpec );
+
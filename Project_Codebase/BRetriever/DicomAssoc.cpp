@@ -29,6 +29,17 @@
 //
 // UPDATE HISTORY:
 //
+//	*[6] 10/19/2026 by agent
+//		GetTransferSyntaxIndex() no longer overruns its UID buffer when given a long
+//		transfer syntax UID read from a malformed Dicom file.
+//	*[5] 10/19/2026 by agent
+//		Initialize the negotiated sending limits used when forwarding images.
+//	*[4] 10/19/2026 by agent
+//		Check the received data PDU and presentation data value lengths against the
+//		received buffer before parsing them.
+//	*[3] 10/19/2026 by agent
+//		Count the images and bytes received over each association, so that the
+//		reception throughput can be logged when the association closes.
 //	*[2] 03/11/2024 by Tom Atwood
 //		Convert windows headers byte packing to the Win32 default for compatibility
 //		with Visual Studio 2022.
@@ -76,6 +87,7 @@ static ERROR_DICTIONARY_ENTRY	DicomAssocErrorCodes[] =
 				{ DICOMASSOC_ERROR_TEMP_IMAGE_FILE_OPEN			, "An error occurred opening a new file for storing an incoming Dicom image." },
 				{ DICOMASSOC_ERROR_TEMP_IMAGE_FILE_CLOSED		, "The local image file was found to be closed during new data reception for appending." },
 				{ DICOMASSOC_ERROR_NO_PRES_CONTEXT_FOUND		, "No accepted presentation syntax was available for controlling data formatting." },
+				{ DICOMASSOC_ERROR_MALFORMED_PDU				, "A received data PDU was inconsistent with its declared length." },
 				{ 0												, NULL }
 			};
 
@@ -217,6 +229,11 @@ DICOM_ASSOCIATION *CreateAssociationStructure( PRODUCT_OPERATION *pProductOperat
 		pAssociation -> ProposedPresentationContextList = 0;
 		pAssociation -> AssociatedImageList = 0;
 		pAssociation -> pCurrentAssociatedImageInfo = 0;
+		pAssociation -> AssociationStartTime = GetTickCount64();			// *[3]
+		pAssociation -> nImagesReceived = 0L;								// *[3]
+		pAssociation -> nImageBytesReceived = 0;							// *[3]
+		pAssociation -> MaxSendPDULength = MAX_ASSOCIATION_RECEIVED_BUFFER_SIZE;	// *[5]
+		pAssociation -> MaxOperationsInvoked = 1;							// *[5]
 		if ( strlen( pProductOperation -> pOutputEndPoint -> AE_TITLE ) <= 16 )
 			{
 			memset( pAssociation -> RemoteAE_Title, ' ', 16 );
@@ -861,6 +878,8 @@ BOOL ParseAssociationReceivedDataSetBuffer( DICOM_ASSOCIATION *pAssociation, BOO
 			if ( pAssociation -> pCurrentAssociatedImageInfo -> pImageDataFile != 0 )
 				{
 				nBytesToBeWritten = *pPrevPDUBytesToBeRead;
+				if ( (unsigned long)nBytesToBeWritten > RemainingBufferSize )										// *[4]
+					nBytesToBeWritten = RemainingBufferSize;
 				nBytesWritten = (long)fwrite( pBufferReadPoint, 1,
 							(long)nBytesToBeWritten, pAssociation -> pCurrentAssociatedImageInfo -> pImageDataFile );
 				if ( nBytesWritten != nBytesToBeWritten )
@@ -873,10 +892,22 @@ BOOL ParseAssociationReceivedDataSetBuffer( DICOM_ASSOCIATION *pAssociation, BOO
 				RemainingBufferSize -= nBytesWritten;
 				}
 			}
-		// Read the message packet header.
-		memcpy( (char*)&MessagePacketHeader, pBufferReadPoint, sizeof(DATA_TRANSFER_PDU_HEADER) );
-		pBufferReadPoint += sizeof(DATA_TRANSFER_PDU_HEADER);
-		RemainingBufferSize -= sizeof(DATA_TRANSFER_PDU_HEADER);
+		// *[4] Make sure the message packet and presentation data value headers are present.
+		if ( RemainingBufferSize == 0 )
+			MessagePacketHeader.PDU_Type = 0x00;
+		else if ( RemainingBufferSize < sizeof(DATA_TRANSFER_PDU_HEADER) + sizeof(PRESENTATION_DATA_VALUE_HEADER) )
+			{
+			MessagePacketHeader.PDU_Type = 0x00;
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMASSOC, DICOMASSOC_ERROR_MALFORMED_PDU );
+			}
+		else
+			{
+			// Read the message packet header.
+			memcpy( (char*)&MessagePacketHeader, pBufferReadPoint, sizeof(DATA_TRANSFER_PDU_HEADER) );
+			pBufferReadPoint += sizeof(DATA_TRANSFER_PDU_HEADER);
+			RemainingBufferSize -= sizeof(DATA_TRANSFER_PDU_HEADER);
+			}
 		if ( MessagePacketHeader.PDU_Type == 0x04 )
 			{
 			AssociationSwapBytes( pAssociation, &MessagePacketHeader.PDULength, 4 );
@@ -896,6 +927,12 @@ BOOL ParseAssociationReceivedDataSetBuffer( DICOM_ASSOCIATION *pAssociation, BOO
 			*pbNeedsMoreData = bNeedsMoreBuffer;
 			AssociationSwapBytes( pAssociation, &CommandMessageHeader.PDVItemLength, 4 );
 			RemainingDataSetLength = CommandMessageHeader.PDVItemLength - 2;
+			// *[4] The lengths must be consistent with each other and with the data actually received.
+			if ( CommandMessageHeader.PDVItemLength < 2 || RemainingPDULength < 6 || RemainingDataSetLength > RemainingBufferSize )
+				{
+				bNoError = FALSE;
+				RespondToError( MODULE_DICOMASSOC, DICOMASSOC_ERROR_MALFORMED_PDU );
+				}
 
 			PresentationContextID = CommandMessageHeader.PresentationContextID;
 			_snprintf_s( Message, 1096, _TRUNCATE, "Presentation context:  %02X.", PresentationContextID );		// *[1] Replaced sprintf() with _snprintf_s.
@@ -934,7 +971,7 @@ BOOL ParseAssociationReceivedDataSetBuffer( DICOM_ASSOCIATION *pAssociation, BOO
 						{
 						// Look at the beginning element in the dataset and guestimate its transfer syntax.
 						FileDecodingPlan.DataSetTransferSyntax =
-													GetConsistentTransferSyntaxFromBuffer( LITTLE_ENDIAN | EXPLICIT_VR, pBufferReadPoint );
+													GetConsistentTransferSyntaxFromBuffer( LITTLE_ENDIAN | EXPLICIT_VR, pBufferReadPoint, RemainingBufferSize );		// *[4]
 						}
 					if ( bNoError )
 						{
@@ -1075,6 +1112,8 @@ BOOL ParseAssociationReceivedDataSetBuffer( DICOM_ASSOCIATION *pAssociation, BOO
 					{
 					if ( !bNeedsMoreBuffer )
 						{
+						pAssociation -> nImagesReceived++;																		// *[3]
+						pAssociation -> nImageBytesReceived += _ftelli64( pAssociation -> pCurrentAssociatedImageInfo -> pImageDataFile );	// *[3]
 						fclose( pAssociation -> pCurrentAssociatedImageInfo -> pImageDataFile );
 						pAssociation -> pCurrentAssociatedImageInfo -> pImageDataFile = 0;
 						if ( bNoError )
@@ -1096,7 +1135,7 @@ BOOL ParseAssociationReceivedDataSetBuffer( DICOM_ASSOCIATION *pAssociation, BOO
 					pAssociation -> pCurrentAssociatedImageInfo -> pImageDataFile = 0;
 					}
 				}
-			else
+			else if ( bNoError )																						// *[4]
 				{
 				// Parse the individual Dicom data elements associated with a received Dicom command.
 				bNoError = ParseReceivedDataSetBuffer( pAssociation, pBufferReadPoint, RemainingDataSetLength );
@@ -1106,6 +1145,12 @@ BOOL ParseAssociationReceivedDataSetBuffer( DICOM_ASSOCIATION *pAssociation, BOO
 				pBufferReadPoint += RemainingDataSetLength;
 				}
 			}
+		else if ( bNoError && RemainingBufferSize > 0 )
+			{
+			// *[4] Only data transfer PDUs are expected here.  Don't attempt to interpret anything else.
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMASSOC, DICOMASSOC_ERROR_MALFORMED_PDU );
+			}
 		}			// ... end while unread buffer remains.
 	if ( pAssociation -> pReceivedBuffer != 0 )
 		{
@@ -1373,6 +1418,8 @@ unsigned short GetTransferSyntaxIndex( char *pTransferSyntaxUID, unsigned short
 	unsigned long		nChars;
 	char				TransferSyntaxUIDString[ 256 ];
 
+	if ( Length >= 256 )														// *[6] Prevent buffer overrun.
+		Length = 255;
 	memcpy( TransferSyntaxUIDString,  pTransferSyntaxUID, Length );
 	TransferSyntaxUIDString[ Length ] = '\0';
 	TrimTrailingSpaces( TransferSyntaxUIDString );
@@ -30,6 +30,14 @@
 //
 // UPDATE HISTORY:
 //
+//	*[4] 10/19/2026 by agent
+//		Added a separate, larger length limit for received PDUs other than data PDUs.
+//	*[3] 10/19/2026 by agent
+//		Added the asynchronous operations window user information subitem and the
+//		negotiated sending limits to the association structure, for forwarding images.
+//	*[2] 10/19/2026 by agent
+//		Added reception throughput counters to the association structure.
+//		Added an error code for malformed received data PDUs.
 //	*[1] 04/17/2024 by Tom Atwood
 //		Restored association structure member byte packing from 8 to 1.
 //
@@ -43,11 +51,15 @@
 #define DICOMASSOC_ERROR_TEMP_IMAGE_FILE_OPEN			4
 #define DICOMASSOC_ERROR_TEMP_IMAGE_FILE_CLOSED			5
 #define DICOMASSOC_ERROR_NO_PRES_CONTEXT_FOUND			6
+#define DICOMASSOC_ERROR_MALFORMED_PDU					7
 
-#define DICOMASSOC_ERROR_DICT_LENGTH					6
+#define DICOMASSOC_ERROR_DICT_LENGTH					7
 
 
 #define MAX_ASSOCIATION_RECEIVED_BUFFER_SIZE			0x00010000	// 64K
+// *[4] The negotiated maximum length applies only to P-DATA-TF PDUs.  Association negotiation and
+// release PDUs are limited only to keep a malformed length from causing an excessive allocation.
+#define MAX_ASSOCIATION_CONTROL_PDU_LENGTH				0x00100000	// 1M
 
 #pragma pack(push)
 #pragma pack(1)		// Pack calibration structure members on 1-byte boundaries.
@@ -86,6 +98,7 @@ typedef struct
 							#define BUFTYPE_A_RELEASE_RQ_BUFFER								17
 							#define BUFTYPE_A_RELEASE_RP_BUFFER								18
 							#define BUFTYPE_A_ABORT_BUFFER									19
+							#define BUFTYPE_A_ASYNCHRONOUS_OPERATIONS_WINDOW_BUFFER			20		// *[3]
 	unsigned long		InsertedBufferLength;
 	unsigned long		MaxBufferLength;
 	BOOL				bInsertedLengthIsFinalized;
@@ -222,6 +235,16 @@ typedef struct
 	} A_ROLE_SELECTION_BUFFER;
 
 
+typedef struct																	// *[3]
+	{
+	unsigned char		PDU_Type;					// = 0x53
+	unsigned char		Reserved1;					// = 0x00
+	unsigned short		Length;						// = 0x0004
+	unsigned short		MaxOperationsInvoked;		// The number of operations the requestor may have outstanding at one time.
+	unsigned short		MaxOperationsPerformed;		// The number of operations the requestor may be asked to perform at one time.
+	} A_ASYNCHRONOUS_OPERATIONS_WINDOW_BUFFER;
+
+
 typedef struct
 	{
 	unsigned char		PDU_Type;					// = 0x55
@@ -483,6 +506,15 @@ typedef struct
 	BOOL							bSentMessageExpectsResponse;
 	LIST_HEAD						AssociatedImageList;
 	ASSOCIATED_IMAGE_INFO			*pCurrentAssociatedImageInfo;
+
+	// Reception throughput measurement.										// *[2] Added reception counters.
+	ULONGLONG						AssociationStartTime;		// System tick count (milliseconds) when the association was created.
+	unsigned long					nImagesReceived;			// Number of image files successfully received and stored.
+	unsigned __int64				nImageBytesReceived;		// Total size of the stored image files.
+
+	// Sending limits negotiated when this node requests the association.		// *[3]
+	unsigned long					MaxSendPDULength;			// Maximum P-DATA-TF PDU length accepted by the remote node.
+	unsigned short					MaxOperationsInvoked;		// Number of C-Store requests that may be awaiting responses.
 	} DICOM_ASSOCIATION;
 
 #pragma pack(pop)					// *[1]
@@ -49,6 +49,9 @@
 #define DICOM_CMD_ECHO_RESPONSE						0x8030
 
 
+#pragma pack(push)
+#pragma pack(1)		// Pack the command element structure members on 1-byte boundaries, to match the encoding.
+
 // The command set uses little endian, implicit VR data element encoding.
 // The value consists of ValueLength bytes, always an even number, appended
 // immediately after this header.
@@ -125,6 +128,8 @@ typedef struct
 	unsigned short		Value;
 	} DATA_ELEMENT_STATUS;
 
+#pragma pack(pop)
+
 
 
 
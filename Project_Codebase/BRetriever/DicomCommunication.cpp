@@ -30,6 +30,13 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		Only data PDUs are held to the maximum PDU length offered to the remote node.
+//		Association negotiation PDUs are held to a larger limit.
+//	*[2] 10/19/2026 by agent
+//		Reject received PDUs longer than the negotiated maximum, rather than
+//		receiving them into a buffer sized for the maximum.  Complete partial
+//		PDU header reads and stop on a closed connection.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -64,6 +71,7 @@ static ERROR_DICTIONARY_ENTRY	DicomStateErrorCodes[] =
 				{ DICOMSTATE_ERROR_NO_FSM_ACTION_DEFINED		, "Due to error, further state transitions for this association have been abandoned." },
 				{ DICOMSTATE_ERROR_PARSE_EXPECT_ASSOC_REQUEST	, "During response parsing, an association request was expected but was not found." },
 				{ DICOMSTATE_ERROR_ASSOCIATION_ABORT			, "The association was aborted due to corrupted received data." },
+				{ DICOMSTATE_ERROR_PDU_TOO_LONG					, "A received PDU exceeded the maximum length accepted for its type." },			// *[3]
 				{ 0												, NULL }
 			};
 
@@ -929,44 +937,75 @@ BOOL ReceiveDicomBuffer( DICOM_ASSOCIATION *pAssociation )
 	char				*pBuffer;
 	char				*pBufferInsertPoint;
 	int					nBytesReceived = 0;
+	int					nHeaderBytesReceived;
 	unsigned long		LogicalBufferContentNeeded;
 	unsigned long		BufferSizeToAllocate;
 	char				Msg[ 1096 ];
 
+	pBuffer = 0;
 	LogMessage( "Blocking for command reception.", MESSAGE_TYPE_DETAILS );
-	bNoError = WindowsSocketReceive( pAssociation -> DicomAssociationSocket, (char*)&PDUHeader, (int)sizeof(PDUHeader), 0, &nBytesReceived, TRUE );
+	// *[2] A stream socket may deliver the PDU header in pieces.
+	nHeaderBytesReceived = 0;
+	do
+		{
+		bNoError = WindowsSocketReceive( pAssociation -> DicomAssociationSocket, (char*)&PDUHeader + nHeaderBytesReceived,
+											(int)sizeof(PDUHeader) - nHeaderBytesReceived, 0, &nBytesReceived, TRUE );
+		if ( bNoError && nBytesReceived <= 0 )
+			bNoError = FALSE;
+		if ( bNoError )
+			nHeaderBytesReceived += nBytesReceived;
+		}
+	while ( bNoError && nHeaderBytesReceived < (int)sizeof(PDUHeader) );
 	LogicalBufferContentNeeded = PDUHeader.PDULength;
 	AssociationSwapBytes( pAssociation, &LogicalBufferContentNeeded, 4 );
 
-	_snprintf_s( Msg, 1096, _TRUNCATE,											// *[1] Replaced sprintf() with _snprintf_s.
-						"Dicom bytes received = %d.  Receiving PDU type %02X.  Need %d more.", nBytesReceived, PDUHeader.PDU_Type, LogicalBufferContentNeeded );
-	LogMessage( Msg, MESSAGE_TYPE_DETAILS );
+	if ( bNoError )
+		{
+		_snprintf_s( Msg, 1096, _TRUNCATE,											// *[1] Replaced sprintf() with _snprintf_s.
+							"Dicom bytes received = %d.  Receiving PDU type %02X.  Need %d more.", nHeaderBytesReceived, PDUHeader.PDU_Type, LogicalBufferContentNeeded );
+		LogMessage( Msg, MESSAGE_TYPE_DETAILS );
+		// *[2] The maximum PDU length offered to the remote node is MAX_ASSOCIATION_RECEIVED_BUFFER_SIZE.
+		// A longer PDU is a protocol violation that would otherwise overrun the received data buffer.
+		// *[3] The offered maximum applies only to P-DATA-TF PDUs.  The other PDUs aren't limited by the
+		// negotiation, and an association request with many presentation contexts may exceed it.
+		if ( ( PDUHeader.PDU_Type == 0x04 && LogicalBufferContentNeeded > MAX_ASSOCIATION_RECEIVED_BUFFER_SIZE ) ||		// P-DATA-TF
+					LogicalBufferContentNeeded > MAX_ASSOCIATION_CONTROL_PDU_LENGTH )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMSTATE, DICOMSTATE_ERROR_PDU_TOO_LONG );
+			}
+		}
 
 	BufferSizeToAllocate = LogicalBufferContentNeeded + (unsigned long)sizeof( PDUHeader );
-	if ( BufferSizeToAllocate > MAX_ASSOCIATION_RECEIVED_BUFFER_SIZE + (unsigned long)sizeof( PDUHeader ) )
-		BufferSizeToAllocate = MAX_ASSOCIATION_RECEIVED_BUFFER_SIZE + (unsigned long)sizeof( PDUHeader );
 
-	pBuffer = (char*)malloc( (size_t)BufferSizeToAllocate );					// *[1] Cast the buffer size as type size_t.
-	if ( pBuffer != 0 )
+	if ( bNoError )																// *[2]
+		{
+		pBuffer = (char*)malloc( (size_t)BufferSizeToAllocate );				// *[1] Cast the buffer size as type size_t.
+		if ( pBuffer == 0 )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMSTATE, DICOMSTATE_ERROR_INSUFFICIENT_MEMORY );
+			}
+		}
+	if ( bNoError )
 		{
 		memcpy( pBuffer, (char*)&PDUHeader, sizeof( PDUHeader ) );
 		pBufferInsertPoint = pBuffer + sizeof( PDUHeader );
-		do
+		while ( bNoError && LogicalBufferContentNeeded > 0L )					// *[2] Don't attempt a zero-length read.
 			{
 			LogMessage( "Blocking for command reception.", MESSAGE_TYPE_DETAILS );
 			bNoError = WindowsSocketReceive( pAssociation -> DicomAssociationSocket, pBufferInsertPoint,
 																(int)LogicalBufferContentNeeded, 0, &nBytesReceived, TRUE );
 			_snprintf_s( Msg, 1096, _TRUNCATE, "Dicom bytes received = %d", nBytesReceived );		// *[1] Replaced sprintf() with _snprintf_s.
 			LogMessage( Msg, MESSAGE_TYPE_DETAILS );
-			LogicalBufferContentNeeded -= nBytesReceived;
-			pBufferInsertPoint += nBytesReceived;
+			if ( bNoError && ( nBytesReceived <= 0 || (unsigned long)nBytesReceived > LogicalBufferContentNeeded ) )	// *[2]
+				bNoError = FALSE;
+			if ( bNoError )
+				{
+				LogicalBufferContentNeeded -= nBytesReceived;
+				pBufferInsertPoint += nBytesReceived;
+				}
 			}
-		while ( bNoError && LogicalBufferContentNeeded > 0L );
-		}
-	else
-		{
-		bNoError = FALSE;
-		RespondToError( MODULE_DICOMSTATE, DICOMSTATE_ERROR_INSUFFICIENT_MEMORY );
 		}
 	if ( bNoError )
 		{
@@ -36,8 +36,9 @@
 #define DICOMSTATE_ERROR_NO_FSM_ACTION_DEFINED			4
 #define DICOMSTATE_ERROR_PARSE_EXPECT_ASSOC_REQUEST		5
 #define DICOMSTATE_ERROR_ASSOCIATION_ABORT				6
+#define DICOMSTATE_ERROR_PDU_TOO_LONG					7
 
-#define DICOMSTATE_ERROR_DICT_LENGTH					6
+#define DICOMSTATE_ERROR_DICT_LENGTH					7
 
 
 #define DEFAULT_DICOM_PORT_NUMBER						204
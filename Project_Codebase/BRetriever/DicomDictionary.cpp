@@ -30,6 +30,10 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Read the dictionary files through a larger stream buffer.  Index the standard
+//		dictionary entries that specify a single tag, so that they can be located by a
+//		binary search instead of by scanning the entire dictionary for every element.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -86,7 +90,80 @@ static LIST_HEAD					ListOfPrivateDictionaries = 0;
 char								ActivePrivateDictionaryName[ 64 ];	// The name of the private dictionary to be used for this Dicom image file.
 unsigned short						ActivePrivateDataElementPrefix;
 
+// *[2] The standard dictionary index.  Entries for a single tag are listed in tag order.  Entries
+// that specify a range of tags are listed in dictionary order.  Each index entry is the location of
+// the item in the pDicomDictionary array.
+static long							*pSingleTagItemIndex = 0;
+static long							nSingleTagItems = 0;
+static long							*pTagRangeItemIndex = 0;
+static long							nTagRangeItems = 0;
 
+#define DICTIONARY_FILE_BUFFER_SIZE		0x10000
+
+
+// *[2] Erase the standard dictionary index.
+static void DeleteDictionaryIndex()
+{
+	if ( pSingleTagItemIndex != 0 )
+		free( pSingleTagItemIndex );
+	pSingleTagItemIndex = 0;
+	nSingleTagItems = 0;
+	if ( pTagRangeItemIndex != 0 )
+		free( pTagRangeItemIndex );
+	pTagRangeItemIndex = 0;
+	nTagRangeItems = 0;
+}
+
+
+// *[2] Order the single tag index by tag and, for duplicate tags, by dictionary order.
+static int CompareSingleTagItems( const void *pIndexEntry1, const void *pIndexEntry2 )
+{
+	DICOM_DICTIONARY_ITEM		*pDictItem1;
+	DICOM_DICTIONARY_ITEM		*pDictItem2;
+	int							ComparisonResult;
+
+	pDictItem1 = &pDicomDictionary[ *(long*)pIndexEntry1 ];
+	pDictItem2 = &pDicomDictionary[ *(long*)pIndexEntry2 ];
+	if ( pDictItem1 -> Group != pDictItem2 -> Group )
+		ComparisonResult = ( pDictItem1 -> Group < pDictItem2 -> Group ) ? -1 : 1;
+	else if ( pDictItem1 -> Element != pDictItem2 -> Element )
+		ComparisonResult = ( pDictItem1 -> Element < pDictItem2 -> Element ) ? -1 : 1;
+	else
+		ComparisonResult = ( *(long*)pIndexEntry1 < *(long*)pIndexEntry2 ) ? -1 : 1;
+
+	return ComparisonResult;
+}
+
+
+// *[2] Create the index for the standard dictionary.  If there isn't enough memory for it, the
+// dictionary is searched sequentially, as before.
+static void IndexDicomDictionary()
+{
+	long						nDictionaryItem;
+	DICOM_DICTIONARY_ITEM		*pDictItem;
+
+	DeleteDictionaryIndex();
+	if ( pDicomDictionary != 0 && nTotalDictionaryItemCount > 0 )
+		{
+		pSingleTagItemIndex = (long*)malloc( nTotalDictionaryItemCount * sizeof(long) );
+		pTagRangeItemIndex = (long*)malloc( nTotalDictionaryItemCount * sizeof(long) );
+		if ( pSingleTagItemIndex != 0 && pTagRangeItemIndex != 0 )
+			{
+			for ( nDictionaryItem = 0; nDictionaryItem < nTotalDictionaryItemCount; nDictionaryItem++ )
+				{
+				pDictItem = &pDicomDictionary[ nDictionaryItem ];
+				if ( pDictItem -> EndOfGroupRange == pDictItem -> Group && pDictItem -> EndOfElementRange == pDictItem -> Element &&
+							pDictItem -> GroupConstraint == MATCH_ANY && pDictItem -> ElementConstraint == MATCH_ANY )
+					pSingleTagItemIndex[ nSingleTagItems++ ] = nDictionaryItem;
+				else
+					pTagRangeItemIndex[ nTagRangeItems++ ] = nDictionaryItem;
+				}
+			qsort( pSingleTagItemIndex, nSingleTagItems, sizeof(long), CompareSingleTagItems );
+			}
+		else
+			DeleteDictionaryIndex();
+		}
+}
 
 
 BOOL ReadDictionaryFiles( char *DicomDictionaryFileSpec, char *PrivateDicomDictionaryFileSpec )
@@ -128,6 +205,7 @@ BOOL ReadDictionaryFile( char *DicomDictionaryFileSpec, BOOL bIsPrivateDictionar
 	pDictFile = fopen( DicomDictionaryFileSpec, "rt" );
 	if ( pDictFile != 0 )
 		{
+		setvbuf( pDictFile, NULL, _IOFBF, DICTIONARY_FILE_BUFFER_SIZE );		// *[2]
 		nDictionaryItems = 0L;
 		// Count the number of items in the dictionary.
 		do
@@ -158,6 +236,7 @@ BOOL ReadDictionaryFile( char *DicomDictionaryFileSpec, BOOL bIsPrivateDictionar
 				{
 				pDictionaryArray = pDicomDictionary;
 				pnDictionaryItemCount = &nTotalDictionaryItemCount;
+				DeleteDictionaryIndex();										// *[2]
 				}
 			if ( pDictionaryArray != 0 )
 				{
@@ -222,6 +301,8 @@ BOOL ReadDictionaryFile( char *DicomDictionaryFileSpec, BOOL bIsPrivateDictionar
 					}
 				while ( FileStatus == FILE_STATUS_OK );
 				*pnDictionaryItemCount = nDictionaryItem;
+				if ( !bIsPrivateDictionary )
+					IndexDicomDictionary();										// *[2]
 
 				if ( FileStatus & FILE_STATUS_READ_ERROR )
 					{
@@ -505,6 +586,53 @@ static DICOM_DICTIONARY_ITEM *SearchDictionary( TAG DicomElementTag,  DICOM_DICT
 }
 
 
+// *[2] Locate the first standard dictionary entry matching the tag, using the dictionary index.
+// This produces the same result as a sequential search of the dictionary.
+static DICOM_DICTIONARY_ITEM *SearchIndexedDictionary( TAG DicomElementTag )
+{
+	DICOM_DICTIONARY_ITEM		*pDictItem;
+	DICOM_DICTIONARY_ITEM		*pIndexedItem;
+	long						nLowIndex;
+	long						nHighIndex;
+	long						nMiddleIndex;
+	long						nMatchingItem;
+	long						nRangeItem;
+
+	// Find the first single tag entry that matches the tag.
+	nMatchingItem = nTotalDictionaryItemCount;
+	nLowIndex = 0;
+	nHighIndex = nSingleTagItems;
+	while ( nLowIndex < nHighIndex )
+		{
+		nMiddleIndex = ( nLowIndex + nHighIndex ) / 2;
+		pIndexedItem = &pDicomDictionary[ pSingleTagItemIndex[ nMiddleIndex ] ];
+		if ( pIndexedItem -> Group < DicomElementTag.Group ||
+					( pIndexedItem -> Group == DicomElementTag.Group && pIndexedItem -> Element < DicomElementTag.Element ) )
+			nLowIndex = nMiddleIndex + 1;
+		else
+			nHighIndex = nMiddleIndex;
+		}
+	if ( nLowIndex < nSingleTagItems )
+		{
+		pIndexedItem = &pDicomDictionary[ pSingleTagItemIndex[ nLowIndex ] ];
+		if ( pIndexedItem -> Group == DicomElementTag.Group && pIndexedItem -> Element == DicomElementTag.Element )
+			nMatchingItem = pSingleTagItemIndex[ nLowIndex ];
+		}
+	// An entry for a range of tags takes precedence if it appears earlier in the dictionary.
+	for ( nRangeItem = 0; nRangeItem < nTagRangeItems && pTagRangeItemIndex[ nRangeItem ] < nMatchingItem; nRangeItem++ )
+		{
+		if ( SearchDictionary( DicomElementTag, &pDicomDictionary[ pTagRangeItemIndex[ nRangeItem ] ], 1 ) != 0 )
+			nMatchingItem = pTagRangeItemIndex[ nRangeItem ];
+		}
+	if ( nMatchingItem < nTotalDictionaryItemCount )
+		pDictItem = &pDicomDictionary[ nMatchingItem ];
+	else
+		pDictItem = 0;
+
+	return pDictItem;
+}
+
+
 DICOM_DICTIONARY_ITEM *GetDicomElementFromDictionary( TAG DicomElementTag )
 {
 	DICOM_DICTIONARY_ITEM		*pFirstDictItem;
@@ -519,8 +647,13 @@ DICOM_DICTIONARY_ITEM *GetDicomElementFromDictionary( TAG DicomElementTag )
 	// Read the value representation and the value length.
 	if ( !bPrivateData )
 		{
-		pFirstDictItem = &pDicomDictionary[ 0 ];
-		pDictItem = SearchDictionary( DicomElementTag,  pFirstDictItem, nTotalDictionaryItemCount );
+		if ( pSingleTagItemIndex != 0 )																// *[2]
+			pDictItem = SearchIndexedDictionary( DicomElementTag );
+		else
+			{
+			pFirstDictItem = &pDicomDictionary[ 0 ];
+			pDictItem = SearchDictionary( DicomElementTag,  pFirstDictItem, nTotalDictionaryItemCount );
+			}
 		}
 	else			// This is a private data element.
 		{
@@ -565,6 +698,7 @@ void DeallocateDicomDictionary()
 		free( pDicomDictionary );
 		pDicomDictionary = 0;
 		}
+	DeleteDictionaryIndex();			// *[2]
 
 	if ( pPrivateDicomDictionary != 0 )
 		{
@@ -29,10 +29,19 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Added the Send Image operation, which forwards each processed image to a
+//		network Dicom destination.  The association with the destination is held
+//		open while images are queued, and C-Store requests are pipelined up to the
+//		negotiated asynchronous operations window.  Failed images are retried with
+//		an increasing delay.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
 //
+#pragma pack(push, 8)		// *[2] Pack structure members on 8-byte boundaries.
+#include <winsock2.h>
+#pragma pack(pop)
 #include "Module.h"
 #include "ReportStatus.h"
 #include "Dicom.h"
@@ -40,6 +49,8 @@
 #include "Operation.h"
 #include "WinSocketsAPI.h"
 #include "DicomAssoc.h"
+#include "DicomCommand.h"
+#include "DicomCommunication.h"
 #include "DicomInitiator.h"
 
 
@@ -47,6 +58,8 @@
 //
 // The module header for this module:
 //
+extern ENDPOINT					EndPointNetworkIn;
+extern PRODUCT_OPERATION		OperationSendImage;
 
 static MODULE_INFO		DicomInitiatorModuleInfo = { MODULE_DICOMINITIATE, "Dicom Association Initiation Module", InitDicomInitiatorModule, CloseDicomInitiatorModule };
 
@@ -54,6 +67,19 @@ static MODULE_INFO		DicomInitiatorModuleInfo = { MODULE_DICOMINITIATE, "Dicom As
 static ERROR_DICTIONARY_ENTRY	DicomInitiatorErrorCodes[] =
 			{
 				{ DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY			, "There is not enough memory to allocate a data structure." },
+				{ DICOMINITIATE_ERROR_CREATE_QUEUE_SEMAPHORE		, "An error occurred creating the forwarding queue semaphore." },
+				{ DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_TIMEOUT		, "A timeout occurred waiting for access to the forwarding queue." },
+				{ DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_WAIT			, "An error occurred waiting for access to the forwarding queue." },
+				{ DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_RELEASE		, "An error occurred releasing the forwarding queue semaphore." },
+				{ DICOMINITIATE_ERROR_FILE_META_INFO				, "The Dicom file meta information of an image to be forwarded could not be read." },
+				{ DICOMINITIATE_ERROR_FILE_OPEN						, "An image file to be forwarded could not be opened." },
+				{ DICOMINITIATE_ERROR_NO_DESTINATION_ADDRESS		, "No network address is configured for the forwarding destination." },
+				{ DICOMINITIATE_ERROR_CONNECT						, "An error occurred connecting to the forwarding destination." },
+				{ DICOMINITIATE_ERROR_ASSOCIATION_REJECTED			, "The forwarding destination rejected the association request." },
+				{ DICOMINITIATE_ERROR_UNEXPECTED_PDU				, "An unexpected or malformed PDU was received from the forwarding destination." },
+				{ DICOMINITIATE_ERROR_STORE_FAILED					, "The forwarding destination did not store an image." },
+				{ DICOMINITIATE_ERROR_IMAGE_ABANDONED				, "An image could not be forwarded and will not be retried." },
+				{ DICOMINITIATE_ERROR_PDU_LENGTH_TOO_SMALL			, "The forwarding destination's maximum PDU length is too small to send images." },
 				{ 0													, NULL }
 			};
 
@@ -66,6 +92,29 @@ static ERROR_DICTIONARY_MODULE		DicomInitiatorStatusErrorDictionary =
 										0
 										};
 
+// The forwarding queue is filled by the Process Image operation and emptied by the Send Image operation.
+static LIST_HEAD						ForwardingQueue = 0;
+static HANDLE							hForwardingQueueSemaphore = 0;
+static char								*pForwardingSemaphoreName = "BRetrieverForwardingQueueSemaphore";
+static BOOL								bSocketsEnabled = FALSE;
+
+// The following are only referenced from the Send Image operation thread.
+static DICOM_ASSOCIATION				*pForwardingAssociation = 0;
+static FORWARDING_PRESENTATION_CONTEXT	ForwardingPresentationContexts[ MAX_FORWARDING_PRESENTATION_CONTEXTS ];
+static int								nForwardingPresentationContexts = 0;
+static unsigned short					nOutstandingStoreRequests = 0;
+static unsigned short					LastMessageIDSent = 0;
+static char								*pReceivedCommandBuffer = 0;		// Command fragments accumulated from P-Data PDUs.
+static unsigned long					ReceivedCommandLength = 0L;
+static ULONGLONG						LastForwardingActivityTime = 0;
+static ULONGLONG						NextAssociationAttemptTime = 0;
+static unsigned long					nFailedAssociationAttempts = 0L;
+static unsigned long					nImagesForwarded = 0L;
+static unsigned __int64					nImageBytesForwarded = 0;
+static ULONGLONG						RetryBaseInterval = FORWARDING_RETRY_BASE_INTERVAL;
+static ULONGLONG						RetryMaxInterval = FORWARDING_RETRY_MAX_INTERVAL;
+static ULONGLONG						AssociationIdleTimeout = FORWARDING_ASSOCIATION_IDLE_TIMEOUT;
+
 
 
 // This function must be called before any other function in this module.
@@ -73,11 +122,31 @@ void InitDicomInitiatorModule()
 {
 	LinkModuleToList( &DicomInitiatorModuleInfo );
 	RegisterErrorDictionary( &DicomInitiatorStatusErrorDictionary );
+	ForwardingQueue = 0;
+	// Create a semaphore for controlling access to the forwarding queue from
+	// different (competing) threads.
+	hForwardingQueueSemaphore = CreateSemaphore( NULL, 1L, 1L, pForwardingSemaphoreName );
+	if ( hForwardingQueueSemaphore == NULL )
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_CREATE_QUEUE_SEMAPHORE );
 }
 
 
 void CloseDicomInitiatorModule()
 {
+	// The image file copies remain in the forwarding directory, to be queued again the next time
+	// the Send Image operation starts.
+	EraseList( &ForwardingQueue );
+	if ( pReceivedCommandBuffer != 0 )
+		{
+		free( pReceivedCommandBuffer );
+		pReceivedCommandBuffer = 0;
+		}
+	if ( hForwardingQueueSemaphore != 0 )
+		CloseHandle( hForwardingQueueSemaphore );
+	hForwardingQueueSemaphore = 0;
+	if ( bSocketsEnabled )
+		TerminateWindowsSockets();
+	bSocketsEnabled = FALSE;
 }
 
 
@@ -144,5 +213,1621 @@ BOOL ParseAssociationReleaseReplyBuffer( DICOM_ASSOCIATION *pAssociation )
 
 
 
+//____________________________________________________________________________________________________________________________________________________________
+// *[2] Forwarding queue functions.
+//
+
+static BOOL LockForwardingQueue()
+{
+	BOOL				bNoError = TRUE;
+	DWORD				WaitResponse;
+
+	WaitResponse = WaitForSingleObject( hForwardingQueueSemaphore, FORWARDING_QUEUE_ACCESS_TIMEOUT );
+	if ( WaitResponse == WAIT_TIMEOUT )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_TIMEOUT );
+		}
+	else if ( WaitResponse != WAIT_OBJECT_0 )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_WAIT );
+		}
+
+	return bNoError;
+}
+
+
+static void UnlockForwardingQueue()
+{
+	if ( ReleaseSemaphore( hForwardingQueueSemaphore, 1L, NULL ) == FALSE )
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_RELEASE );
+}
+
+
+// Return the delay, in milliseconds, before the next attempt following the specified number of
+// consecutive failures.  The delay doubles with each failure, up to a maximum.
+static ULONGLONG ComputeRetryDelay( unsigned long nFailures )
+{
+	ULONGLONG			RetryDelay;
+	unsigned long		nFailure;
+
+	RetryDelay = RetryBaseInterval;
+	for ( nFailure = 1; nFailure < nFailures && RetryDelay < RetryMaxInterval; nFailure++ )
+		RetryDelay *= 2;
+	if ( RetryDelay > RetryMaxInterval )
+		RetryDelay = RetryMaxInterval;
+
+	return RetryDelay;
+}
+
+
+// The forwarding tests shorten the retry and idle intervals, which would otherwise keep them
+// waiting for minutes.  The service always uses the defaults set above.
+void SetForwardingIntervals( ULONGLONG NewRetryBaseInterval, ULONGLONG NewRetryMaxInterval, ULONGLONG NewAssociationIdleTimeout )
+{
+	RetryBaseInterval = NewRetryBaseInterval;
+	RetryMaxInterval = NewRetryMaxInterval;
+	AssociationIdleTimeout = NewAssociationIdleTimeout;
+}
+
+
+static void CopyUIDValue( char *pDestination, char *pValue, unsigned long ValueLength )
+{
+	// Remove the padding from the end of the UID value.
+	while ( ValueLength > 0 && ( pValue[ ValueLength - 1 ] == ' ' || pValue[ ValueLength - 1 ] == '\0' ) )
+		ValueLength--;
+	memcpy( pDestination, pValue, ValueLength );
+	pDestination[ ValueLength ] = '\0';
+}
+
+
+// Read the file meta information group from the image file to be forwarded.  This supplies the
+// SOP class and instance UIDs for the C-Store request and the transfer syntax of the data set,
+// and locates the data set following the group, which is sent unaltered.  The file meta
+// information is always encoded as explicit VR little endian.
+static BOOL ReadForwardedImageFileMetaInformation( FORWARDED_IMAGE *pForwardedImage )
+{
+	BOOL								bNoError = TRUE;
+	FILE								*pImageFile;
+	errno_t								FileError;
+	char								Preamble[ 132 ];
+	FILE_META_INFO_HEADER_EXPLICIT_VR	ElementHeader;
+	unsigned long						ValueLength;
+	char								Value[ 68 ];
+	char								*pUIDDestination;
+	BOOL								bEndOfGroup;
+	__int64								FileSize;
+	long								ElementPosition;
+
+	pImageFile = 0;
+	FileError = fopen_s( &pImageFile, pForwardedImage -> ImageFileSpec, "rb" );
+	if ( FileError != 0 || pImageFile == 0 )
+		{
+		bNoError = FALSE;
+		pImageFile = 0;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_FILE_OPEN );
+		}
+	if ( bNoError )
+		{
+		// A Dicom file begins with a 128-byte preamble followed by the characters "DICM".
+		bNoError = ( fread( Preamble, 1, 132, pImageFile ) == 132 && strncmp( &Preamble[ 128 ], "DICM", 4 ) == 0 );
+		}
+	bEndOfGroup = FALSE;
+	ElementPosition = 132;
+	while ( bNoError && !bEndOfGroup )
+		{
+		ElementPosition = ftell( pImageFile );
+		bNoError = ( fread( &ElementHeader, 1, sizeof(FILE_META_INFO_HEADER_EXPLICIT_VR), pImageFile ) == sizeof(FILE_META_INFO_HEADER_EXPLICIT_VR) );
+		if ( bNoError )
+			bEndOfGroup = ( ElementHeader.Group != 0x0002 );
+		if ( bNoError && !bEndOfGroup )
+			{
+			// For these value representations, the 2-byte length field is reserved and a 4-byte length follows.
+			if ( strncmp( ElementHeader.ValueRepresentation, "OB", 2 ) == 0 || strncmp( ElementHeader.ValueRepresentation, "OW", 2 ) == 0 ||
+						strncmp( ElementHeader.ValueRepresentation, "SQ", 2 ) == 0 || strncmp( ElementHeader.ValueRepresentation, "UN", 2 ) == 0 ||
+						strncmp( ElementHeader.ValueRepresentation, "UT", 2 ) == 0 )
+				bNoError = ( fread( &ValueLength, 1, 4, pImageFile ) == 4 && ValueLength != 0xFFFFFFFF );
+			else
+				ValueLength = ElementHeader.ValueLength;
+			}
+		if ( bNoError && !bEndOfGroup )
+			{
+			switch ( ElementHeader.Element )
+				{
+				case 0x0002:
+					pUIDDestination = pForwardedImage -> SOPClassUID;
+					break;
+				case 0x0003:
+					pUIDDestination = pForwardedImage -> SOPInstanceUID;
+					break;
+				case 0x0010:
+					pUIDDestination = pForwardedImage -> TransferSyntaxUID;
+					break;
+				default:
+					pUIDDestination = 0;
+					break;
+				}
+			if ( pUIDDestination != 0 && ValueLength <= 64 )
+				{
+				bNoError = ( fread( Value, 1, ValueLength, pImageFile ) == ValueLength );
+				if ( bNoError )
+					CopyUIDValue( pUIDDestination, Value, ValueLength );
+				}
+			else
+				bNoError = ( fseek( pImageFile, (long)ValueLength, SEEK_CUR ) == 0 );
+			}
+		}
+	if ( pImageFile != 0 )
+		fclose( pImageFile );
+	if ( bNoError )
+		{
+		FileSize = GetFileSizeInBytes( pForwardedImage -> ImageFileSpec );
+		pForwardedImage -> DataSetOffset = (unsigned long)ElementPosition;
+		if ( FileSize > (__int64)ElementPosition )
+			pForwardedImage -> DataSetSize = (unsigned long)( FileSize - (__int64)ElementPosition );
+		else
+			pForwardedImage -> DataSetSize = 0L;
+		bNoError = ( strlen( pForwardedImage -> SOPClassUID ) > 0 && strlen( pForwardedImage -> SOPInstanceUID ) > 0 &&
+						strlen( pForwardedImage -> TransferSyntaxUID ) > 0 && pForwardedImage -> DataSetSize > 0 );
+		}
+	if ( !bNoError && pImageFile != 0 )
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_FILE_META_INFO );
+
+	return bNoError;
+}
+
+
+static BOOL QueueForwardedImageFile( char *pImageFileSpec )
+{
+	BOOL					bNoError = TRUE;
+	FORWARDED_IMAGE			*pForwardedImage;
+	char					TextLine[ MAX_FILE_SPEC_LENGTH ];
+
+	pForwardedImage = (FORWARDED_IMAGE*)malloc( sizeof(FORWARDED_IMAGE) );
+	if ( pForwardedImage == 0 )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+		}
+	else
+		{
+		memset( (char*)pForwardedImage, '\0', sizeof(FORWARDED_IMAGE) );
+		strncpy_s( pForwardedImage -> ImageFileSpec, MAX_FILE_SPEC_LENGTH, pImageFileSpec, _TRUNCATE );
+		bNoError = ReadForwardedImageFileMetaInformation( pForwardedImage );
+		}
+	if ( bNoError )
+		{
+		bNoError = LockForwardingQueue();
+		if ( bNoError )
+			{
+			bNoError = AppendToList( &ForwardingQueue, (void*)pForwardedImage );
+			UnlockForwardingQueue();
+			}
+		}
+	if ( bNoError )
+		{
+		_snprintf_s( TextLine, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "Queued for forwarding:  %s", pImageFileSpec );
+		LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+	else if ( pForwardedImage != 0 )
+		free( pForwardedImage );
+
+	return bNoError;
+}
+
+
+// Called by the Process Image operation once an image has been processed.  If the Send Image
+// operation is enabled, a copy of the Dicom image file is placed in the forwarding directory
+// and queued for sending.  The copy is deleted when the destination has stored the image.
+BOOL QueueImageForForwarding( char *pQueuedDicomFileSpec, char *pPNGImageFileName )
+{
+	BOOL						bNoError = TRUE;
+	ENDPOINT					*pForwardingEndPoint;
+	char						ForwardedFileName[ MAX_FILE_SPEC_LENGTH ];
+	char						ForwardedFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char						*pChar;
+	char						Msg[ 1024 ];
+	DWORD						SystemErrorCode;
+
+	pForwardingEndPoint = OperationSendImage.pOutputEndPoint;
+	if ( OperationSendImage.bEnabled && pForwardingEndPoint != 0 && strlen( pForwardingEndPoint -> Directory ) > 0 )
+		{
+		strncpy_s( ForwardedFileName, MAX_FILE_SPEC_LENGTH, pPNGImageFileName, _TRUNCATE );
+		pChar = strstr( ForwardedFileName, ".png" );
+		if ( pChar != 0 )
+			strncpy_s( pChar, 5, ".dcm", _TRUNCATE );
+		ForwardedFileSpec[ 0 ] = '\0';
+		strncat_s( ForwardedFileSpec, MAX_FILE_SPEC_LENGTH, pForwardingEndPoint -> Directory, _TRUNCATE );
+		LocateOrCreateDirectory( ForwardedFileSpec );	// Ensure directory exists.
+		if ( ForwardedFileSpec[ strlen( ForwardedFileSpec ) - 1 ] != '\\' )
+			strncat_s( ForwardedFileSpec, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );
+		strncat_s( ForwardedFileSpec, MAX_FILE_SPEC_LENGTH, ForwardedFileName, _TRUNCATE );
+
+		bNoError = CopyFile( pQueuedDicomFileSpec, ForwardedFileSpec, FALSE );
+		if ( !bNoError )
+			{
+			SystemErrorCode = GetLastError();
+			_snprintf_s( Msg, 1024, _TRUNCATE, "   >>> Copy to forwarding folder system error code %d", SystemErrorCode );
+			LogMessage( Msg, MESSAGE_TYPE_ERROR );
+			}
+		if ( bNoError )
+			{
+			bNoError = QueueForwardedImageFile( ForwardedFileSpec );
+			if ( bNoError )
+				WakeOperationsOfType( OPERATION_TYPE_SEND_OVER_NETWORK );
+			else
+				DeleteFile( ForwardedFileSpec );
+			}
+		}
+
+	return bNoError;
+}
+
+
+// Queue any image files left in the forwarding directory when BRetriever last stopped.
+static void QueueUnsentImageFiles( PRODUCT_OPERATION *pSendOperation )
+{
+	char						ForwardingDirectory[ MAX_FILE_SPEC_LENGTH ];
+	char						SearchFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char						FoundFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	WIN32_FIND_DATA				FindFileInfo;
+	HANDLE						hFindFile;
+	BOOL						bFileFound;
+
+	if ( ForwardingQueue == 0 && pSendOperation -> pOutputEndPoint != 0 && strlen( pSendOperation -> pOutputEndPoint -> Directory ) > 0 )
+		{
+		strncpy_s( ForwardingDirectory, MAX_FILE_SPEC_LENGTH, pSendOperation -> pOutputEndPoint -> Directory, _TRUNCATE );
+		if ( ForwardingDirectory[ strlen( ForwardingDirectory ) - 1 ] != '\\' )
+			strncat_s( ForwardingDirectory, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );
+		strncpy_s( SearchFileSpec, MAX_FILE_SPEC_LENGTH, ForwardingDirectory, _TRUNCATE );
+		strncat_s( SearchFileSpec, MAX_FILE_SPEC_LENGTH, "*.dcm", _TRUNCATE );
+		hFindFile = FindFirstFile( SearchFileSpec, &FindFileInfo );
+		bFileFound = ( hFindFile != INVALID_HANDLE_VALUE );
+		while ( bFileFound )
+			{
+			if ( ( FindFileInfo.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) == 0 )
+				{
+				strncpy_s( FoundFileSpec, MAX_FILE_SPEC_LENGTH, ForwardingDirectory, _TRUNCATE );
+				strncat_s( FoundFileSpec, MAX_FILE_SPEC_LENGTH, FindFileInfo.cFileName, _TRUNCATE );
+				QueueForwardedImageFile( FoundFileSpec );
+				}
+			// Look for another file in the forwarding directory.
+			bFileFound = FindNextFile( hFindFile, &FindFileInfo );
+			}
+		if ( hFindFile != INVALID_HANDLE_VALUE )
+			FindClose( hFindFile );
+		}
+}
+
+
+// Return the first queued image that is neither awaiting a C-Store response nor waiting
+// for its retry time.
+static FORWARDED_IMAGE *GetNextImageReadyForForwarding()
+{
+	LIST_ELEMENT			*pListElement;
+	FORWARDED_IMAGE			*pForwardedImage;
+	FORWARDED_IMAGE			*pReadyImage;
+	ULONGLONG				CurrentTime;
+
+	pReadyImage = 0;
+	CurrentTime = GetTickCount64();
+	if ( LockForwardingQueue() )
+		{
+		pListElement = ForwardingQueue;
+		while ( pListElement != 0 && pReadyImage == 0 )
+			{
+			pForwardedImage = (FORWARDED_IMAGE*)pListElement -> pItem;
+			if ( pForwardedImage -> MessageID == 0 && pForwardedImage -> NextAttemptTime <= CurrentTime )
+				pReadyImage = pForwardedImage;
+			pListElement = pListElement -> pNextListElement;
+			}
+		UnlockForwardingQueue();
+		}
+
+	return pReadyImage;
+}
+
+
+// Return the queued image awaiting a response to the specified C-Store request message.
+// A MessageID of zero matches any image that is awaiting a response.
+static FORWARDED_IMAGE *GetOutstandingForwardedImage( unsigned short MessageID )
+{
+	LIST_ELEMENT			*pListElement;
+	FORWARDED_IMAGE			*pForwardedImage;
+	FORWARDED_IMAGE			*pMatchingImage;
+
+	pMatchingImage = 0;
+	if ( LockForwardingQueue() )
+		{
+		pListElement = ForwardingQueue;
+		while ( pListElement != 0 && pMatchingImage == 0 )
+			{
+			pForwardedImage = (FORWARDED_IMAGE*)pListElement -> pItem;
+			if ( pForwardedImage -> MessageID != 0 && ( MessageID == 0 || pForwardedImage -> MessageID == MessageID ) )
+				pMatchingImage = pForwardedImage;
+			pListElement = pListElement -> pNextListElement;
+			}
+		UnlockForwardingQueue();
+		}
+
+	return pMatchingImage;
+}
+
+
+static void RemoveForwardedImage( FORWARDED_IMAGE *pForwardedImage )
+{
+	if ( LockForwardingQueue() )
+		{
+		RemoveFromList( &ForwardingQueue, (void*)pForwardedImage );
+		UnlockForwardingQueue();
+		free( pForwardedImage );
+		}
+}
+
+
+// The destination has stored the image, so the forwarding copy is no longer needed.
+static void CompleteForwardedImage( FORWARDED_IMAGE *pForwardedImage, unsigned short Status )
+{
+	char					TextLine[ MAX_FILE_SPEC_LENGTH ];
+
+	if ( Status != 0x0000 )
+		{
+		_snprintf_s( TextLine, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "Forwarded image stored with warning status %04X:  %s",
+						Status, pForwardedImage -> ImageFileSpec );
+		LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+	nImagesForwarded++;
+	nImageBytesForwarded += pForwardedImage -> DataSetSize;
+	DeleteFile( pForwardedImage -> ImageFileSpec );
+	RemoveForwardedImage( pForwardedImage );
+}
+
+
+// Schedule another attempt to send the image, or give up on it after too many failures.  An image that
+// is given up on is renamed, so that it remains available but is not queued again.
+static void RecordForwardingFailure( FORWARDED_IMAGE *pForwardedImage )
+{
+	ULONGLONG				RetryDelay;
+	char					UnsentFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					TextLine[ MAX_FILE_SPEC_LENGTH ];
+
+	pForwardedImage -> MessageID = 0;
+	pForwardedImage -> nAttempts++;
+	if ( pForwardedImage -> nAttempts >= MAX_FORWARDING_ATTEMPTS )
+		{
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_IMAGE_ABANDONED );
+		strncpy_s( UnsentFileSpec, MAX_FILE_SPEC_LENGTH, pForwardedImage -> ImageFileSpec, _TRUNCATE );
+		strncat_s( UnsentFileSpec, MAX_FILE_SPEC_LENGTH, ".unsent", _TRUNCATE );
+		MoveFileEx( pForwardedImage -> ImageFileSpec, UnsentFileSpec, MOVEFILE_REPLACE_EXISTING );
+		_snprintf_s( TextLine, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "    Forwarding abandoned after %d attempts:  %s",
+						pForwardedImage -> nAttempts, UnsentFileSpec );
+		LogMessage( TextLine, MESSAGE_TYPE_ERROR );
+		RemoveForwardedImage( pForwardedImage );
+		}
+	else
+		{
+		RetryDelay = ComputeRetryDelay( pForwardedImage -> nAttempts );
+		pForwardedImage -> NextAttemptTime = GetTickCount64() + RetryDelay;
+		_snprintf_s( TextLine, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "Forwarding attempt %d failed.  Retrying in %d seconds:  %s",
+						pForwardedImage -> nAttempts, (int)( RetryDelay / 1000 ), pForwardedImage -> ImageFileSpec );
+		LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+}
+
+
+
+//____________________________________________________________________________________________________________________________________________________________
+// *[2] Association request functions.
+//
+
+static FORWARDING_PRESENTATION_CONTEXT *FindForwardingPresentationContext( char *pSOPClassUID, char *pTransferSyntaxUID )
+{
+	FORWARDING_PRESENTATION_CONTEXT		*pPresentationContext;
+	int									nContext;
+
+	pPresentationContext = 0;
+	for ( nContext = 0; nContext < nForwardingPresentationContexts && pPresentationContext == 0; nContext++ )
+		if ( strcmp( ForwardingPresentationContexts[ nContext ].SOPClassUID, pSOPClassUID ) == 0 &&
+					strcmp( ForwardingPresentationContexts[ nContext ].TransferSyntaxUID, pTransferSyntaxUID ) == 0 )
+			pPresentationContext = &ForwardingPresentationContexts[ nContext ];
+
+	return pPresentationContext;
+}
+
+
+static void AddForwardingPresentationContext( char *pSOPClassUID, char *pTransferSyntaxUID )
+{
+	FORWARDING_PRESENTATION_CONTEXT		*pPresentationContext;
+
+	if ( nForwardingPresentationContexts < MAX_FORWARDING_PRESENTATION_CONTEXTS &&
+				FindForwardingPresentationContext( pSOPClassUID, pTransferSyntaxUID ) == 0 )
+		{
+		pPresentationContext = &ForwardingPresentationContexts[ nForwardingPresentationContexts ];
+		// Presentation context ID values shall be odd integers between 1 and 255.
+		pPresentationContext -> PresentationContextID = (unsigned char)( 2 * nForwardingPresentationContexts + 1 );
+		strncpy_s( pPresentationContext -> SOPClassUID, 68, pSOPClassUID, _TRUNCATE );
+		strncpy_s( pPresentationContext -> TransferSyntaxUID, 68, pTransferSyntaxUID, _TRUNCATE );
+		pPresentationContext -> bAccepted = FALSE;
+		nForwardingPresentationContexts++;
+		}
+}
+
+
+// Propose a presentation context for each combination of SOP class and transfer syntax among the
+// queued images, so that a single association can carry all of them.  The first image's combination
+// is always included.  Each data set is sent in the transfer syntax in which it was received.
+static void RegisterForwardingPresentationContexts( FORWARDED_IMAGE *pFirstForwardedImage )
+{
+	LIST_ELEMENT			*pListElement;
+	FORWARDED_IMAGE			*pForwardedImage;
+
+	nForwardingPresentationContexts = 0;
+	AddForwardingPresentationContext( pFirstForwardedImage -> SOPClassUID, pFirstForwardedImage -> TransferSyntaxUID );
+	if ( LockForwardingQueue() )
+		{
+		pListElement = ForwardingQueue;
+		while ( pListElement != 0 )
+			{
+			pForwardedImage = (FORWARDED_IMAGE*)pListElement -> pItem;
+			AddForwardingPresentationContext( pForwardedImage -> SOPClassUID, pForwardedImage -> TransferSyntaxUID );
+			pListElement = pListElement -> pNextListElement;
+			}
+		UnlockForwardingQueue();
+		}
+}
+
+
+static BOOL ConnectToForwardingDestination( DICOM_ASSOCIATION *pAssociation, ENDPOINT *pDestinationEndPoint )
+{
+	BOOL						bNoError = TRUE;
+#pragma pack(push, 8)
+	struct linger				LingerRequirement;
+	struct sockaddr_in			DestinationAddr;
+	SOCKET						ConnectingSocket;
+#pragma pack(pop)
+	struct hostent				*pRemoteHostEntity = NULL;
+	char						HostName[ MAX_CFG_STRING_LENGTH ];
+	char						*pPortSpecification;
+	unsigned short				nPortNumber;
+	unsigned long				HostAddress;
+	int							TimeoutInMilliseconds = 30000;		// Set the send and receive timeouts to 30 seconds.
+	int							SocketBufferSize;
+	int							bDisableNagleAlgorithm;
+	char						TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	ConnectingSocket = INVALID_SOCKET;
+	// The network address is specified as "host:port".  If the port is omitted, the default Dicom port is used.
+	strncpy_s( HostName, MAX_CFG_STRING_LENGTH, pDestinationEndPoint -> NetworkAddress, _TRUNCATE );
+	pPortSpecification = strchr( HostName, ':' );
+	if ( pPortSpecification != 0 )
+		{
+		*pPortSpecification = '\0';
+		nPortNumber = (unsigned short)atoi( pPortSpecification + 1 );
+		}
+	else
+		nPortNumber = DEFAULT_DICOM_PORT_NUMBER;
+	if ( strlen( HostName ) == 0 )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_NO_DESTINATION_ADDRESS );
+		}
+	if ( bNoError )
+		{
+		memset( &DestinationAddr, 0, sizeof(DestinationAddr) );
+		DestinationAddr.sin_family = AF_INET;
+		DestinationAddr.sin_port = htons( nPortNumber );
+		HostAddress = inet_addr( HostName );
+		if ( HostAddress == INADDR_NONE )
+			{
+			// The address isn't in dotted decimal form, so look up the host name.
+			bNoError = GetWindowsHostByName( HostName, &pRemoteHostEntity );
+			if ( bNoError )
+				bNoError = ( pRemoteHostEntity -> h_length == 4 && pRemoteHostEntity -> h_addr_list[ 0 ] != 0 );
+			if ( bNoError )
+				memcpy( &HostAddress, pRemoteHostEntity -> h_addr_list[ 0 ], 4 );
+			}
+		DestinationAddr.sin_addr.s_addr = HostAddress;
+		}
+	if ( bNoError )
+		{
+		ConnectingSocket = CreateWindowsSocket();
+		bNoError = ( ConnectingSocket != INVALID_SOCKET );
+		}
+	if ( bNoError )
+		{
+		memset( &LingerRequirement, 0, sizeof(LingerRequirement) );
+		LingerRequirement.l_onoff = 0;		// Disable lingering after a close request.
+		bNoError = WindowsSetSocketOptions( ConnectingSocket, SOL_SOCKET, SO_LINGER, (char*)&LingerRequirement, sizeof(LingerRequirement) );
+		}
+	if ( bNoError )
+		{
+		// Use a 64K default socket buffer length.
+		SocketBufferSize = 0x10000;
+		bNoError = WindowsSetSocketOptions( ConnectingSocket, SOL_SOCKET, SO_SNDBUF, (char*)&SocketBufferSize, sizeof(SocketBufferSize) );
+		if ( bNoError )
+			bNoError = WindowsSetSocketOptions( ConnectingSocket, SOL_SOCKET, SO_RCVBUF, (char*)&SocketBufferSize, sizeof(SocketBufferSize) );
+		}
+	if ( bNoError )
+		{
+		// Set a 30-second timeout for the blocking send and receive operations.
+		bNoError = WindowsSetSocketOptions( ConnectingSocket, SOL_SOCKET, SO_RCVTIMEO, (char*)&TimeoutInMilliseconds, sizeof(TimeoutInMilliseconds) );
+		if ( bNoError )
+			bNoError = WindowsSetSocketOptions( ConnectingSocket, SOL_SOCKET, SO_SNDTIMEO, (char*)&TimeoutInMilliseconds, sizeof(TimeoutInMilliseconds) );
+		}
+	if ( bNoError )
+		{
+		// Improve performance by disabling the Nagle algorithm.
+		bDisableNagleAlgorithm = 1;
+		bNoError = WindowsSetSocketOptions( ConnectingSocket, IPPROTO_TCP, TCP_NODELAY,
+											(char*)&bDisableNagleAlgorithm, sizeof(bDisableNagleAlgorithm) );
+		}
+	if ( bNoError )
+		bNoError = WindowsSocketConnect( ConnectingSocket, (struct sockaddr*)&DestinationAddr );
+	if ( bNoError )
+		{
+		pAssociation -> DicomAssociationSocket = ConnectingSocket;
+		pAssociation -> nRemotePortNumber = nPortNumber;
+		strncpy_s( pAssociation -> RemoteNodeName, MAX_CFG_STRING_LENGTH, HostName, _TRUNCATE );
+		_snprintf_s( pAssociation -> RemoteIPAddress, MAX_CFG_STRING_LENGTH, _TRUNCATE, "%-d.%-d.%-d.%-d",
+						( (int)DestinationAddr.sin_addr.s_addr ) & 0xff, ( (int)DestinationAddr.sin_addr.s_addr >> 8 ) & 0xff,
+						( (int)DestinationAddr.sin_addr.s_addr >> 16 ) & 0xff, ( (int)DestinationAddr.sin_addr.s_addr >> 24 ) & 0xff );
+		_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE, "  Connected to forwarding destination %s (%s) port %d.",
+						pAssociation -> RemoteNodeName, pAssociation -> RemoteIPAddress, nPortNumber );
+		LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+	else
+		{
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_CONNECT );
+		if ( ConnectingSocket != INVALID_SOCKET )
+			WindowsCloseSocket( ConnectingSocket );
+		}
+
+	return bNoError;
+}
+
+
+static BOOL PreparePresentationContextRequestBuffer( DICOM_ASSOCIATION *pAssociation, FORWARDING_PRESENTATION_CONTEXT *pPresentationContext )
+{
+	BOOL									bNoError = TRUE;
+	BUFFER_LIST_ELEMENT						*pBufferDescriptor;
+	char									*pBufferElement;
+	A_PRESENTATION_CONTEXT_HEADER_BUFFER	PresentationContextHeader;
+	A_ABSTRACT_SYNTAX_BUFFER				AbstractSyntaxItem;
+	A_TRANSFER_SYNTAX_BUFFER				TransferSyntaxItem;
+	unsigned short							AbstractSyntaxLength;
+	unsigned short							TransferSyntaxLength;
+	unsigned long							ItemLength;
+
+	pBufferElement = 0;
+	AbstractSyntaxLength = (unsigned short)strlen( pPresentationContext -> SOPClassUID );
+	TransferSyntaxLength = (unsigned short)strlen( pPresentationContext -> TransferSyntaxUID );
+	// The presentation context item contains one abstract syntax subitem and one transfer syntax subitem.
+	ItemLength = sizeof(A_PRESENTATION_CONTEXT_HEADER_BUFFER) + 4 + AbstractSyntaxLength + 4 + TransferSyntaxLength;
+	pBufferDescriptor = (BUFFER_LIST_ELEMENT*)malloc( sizeof(BUFFER_LIST_ELEMENT) );
+	if ( pBufferDescriptor == 0 )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+		}
+	if ( bNoError )
+		{
+		pBufferElement = (char*)malloc( ItemLength );
+		if ( pBufferElement == 0 )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+			free( pBufferDescriptor );
+			}
+		}
+	if ( bNoError )
+		{
+		memset( (char*)&PresentationContextHeader, '\0', sizeof(A_PRESENTATION_CONTEXT_HEADER_BUFFER) );
+		PresentationContextHeader.PDU_Type = 0x20;
+		PresentationContextHeader.Length = (unsigned short)( ItemLength - 4 );
+		AssociationSwapBytes( pAssociation, &PresentationContextHeader.Length, 2 );
+		PresentationContextHeader.PresentationContextID = pPresentationContext -> PresentationContextID;
+		memcpy( pBufferElement, (char*)&PresentationContextHeader, sizeof(A_PRESENTATION_CONTEXT_HEADER_BUFFER) );
+
+		AbstractSyntaxItem.PDU_Type = 0x30;
+		AbstractSyntaxItem.Reserved1 = 0x00;
+		AbstractSyntaxItem.Length = AbstractSyntaxLength;
+		AssociationSwapBytes( pAssociation, &AbstractSyntaxItem.Length, 2 );
+		memcpy( AbstractSyntaxItem.AbstractSyntaxName, pPresentationContext -> SOPClassUID, AbstractSyntaxLength );
+		memcpy( pBufferElement + sizeof(A_PRESENTATION_CONTEXT_HEADER_BUFFER), (char*)&AbstractSyntaxItem, 4 + AbstractSyntaxLength );
+
+		TransferSyntaxItem.PDU_Type = 0x40;
+		TransferSyntaxItem.Reserved1 = 0x00;
+		TransferSyntaxItem.Length = TransferSyntaxLength;
+		AssociationSwapBytes( pAssociation, &TransferSyntaxItem.Length, 2 );
+		memcpy( TransferSyntaxItem.TransferSyntaxName, pPresentationContext -> TransferSyntaxUID, TransferSyntaxLength );
+		memcpy( pBufferElement + sizeof(A_PRESENTATION_CONTEXT_HEADER_BUFFER) + 4 + AbstractSyntaxLength,
+					(char*)&TransferSyntaxItem, 4 + TransferSyntaxLength );
+
+		pBufferDescriptor -> BufferType = BUFTYPE_A_PRESENTATION_CONTEXT_HEADER_BUFFER;
+		pBufferDescriptor -> MaxBufferLength = ItemLength;
+		pBufferDescriptor -> InsertedBufferLength = ItemLength;
+		pBufferDescriptor -> bInsertedLengthIsFinalized = TRUE;
+		pBufferDescriptor -> pBuffer = (void*)pBufferElement;
+		bNoError = PrefixToList( &pAssociation -> AssociationBufferList, (void*)pBufferDescriptor );
+		}
+
+	return bNoError;
+}
+
+
+static BOOL PrepareAsynchronousOperationsWindowBuffer( DICOM_ASSOCIATION *pAssociation )
+{
+	BOOL									bNoError = TRUE;
+	BUFFER_LIST_ELEMENT						*pBufferDescriptor;
+	A_ASYNCHRONOUS_OPERATIONS_WINDOW_BUFFER	*pBufferElement;
+
+	pBufferDescriptor = (BUFFER_LIST_ELEMENT*)malloc( sizeof(BUFFER_LIST_ELEMENT) );
+	if ( pBufferDescriptor == 0 )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+		}
+	if ( bNoError )
+		{
+		pBufferElement = (A_ASYNCHRONOUS_OPERATIONS_WINDOW_BUFFER*)malloc( sizeof(A_ASYNCHRONOUS_OPERATIONS_WINDOW_BUFFER) );
+		if ( pBufferElement == 0 )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+			free( pBufferDescriptor );
+			}
+		else
+			{
+			memset( (char*)pBufferElement, '\0', sizeof(A_ASYNCHRONOUS_OPERATIONS_WINDOW_BUFFER) );
+			pBufferElement -> PDU_Type = 0x53;
+			pBufferElement -> Reserved1 = 0x00;
+			pBufferElement -> Length = 0x0004;
+			}
+		}
+	if ( bNoError )
+		{
+		// Request that several C-Store requests may be awaiting responses at once.  This node
+		// performs no operations for the destination.
+		pBufferElement -> MaxOperationsInvoked = MAX_OUTSTANDING_STORE_REQUESTS;
+		pBufferElement -> MaxOperationsPerformed = 1;
+		AssociationSwapBytes( pAssociation, &pBufferElement -> MaxOperationsInvoked, 2 );
+		AssociationSwapBytes( pAssociation, &pBufferElement -> MaxOperationsPerformed, 2 );
+
+		pBufferDescriptor -> BufferType = BUFTYPE_A_ASYNCHRONOUS_OPERATIONS_WINDOW_BUFFER;
+		pBufferDescriptor -> MaxBufferLength = sizeof(A_ASYNCHRONOUS_OPERATIONS_WINDOW_BUFFER);
+		pBufferDescriptor -> InsertedBufferLength = pBufferElement -> Length + 4;
+		pBufferDescriptor -> bInsertedLengthIsFinalized = TRUE;
+		pBufferDescriptor -> pBuffer = (void*)pBufferElement;
+
+		AssociationSwapBytes( pAssociation, &pBufferElement -> Length, 2 );
+		bNoError = PrefixToList( &pAssociation -> AssociationBufferList, (void*)pBufferDescriptor );
+		}
+
+	return bNoError;
+}
+
+
+// The user information item of the association request differs from the one in the
+// acceptor's reply by including the asynchronous operations window.
+static BOOL PrepareRequestUserInformationBuffer( DICOM_ASSOCIATION *pAssociation )
+{
+	BOOL							bNoError = TRUE;
+	BUFFER_LIST_ELEMENT				*pBufferDescriptor;
+	A_USER_INFO_ITEM_HEADER_BUFFER	*pBufferElement;
+
+	pBufferDescriptor = (BUFFER_LIST_ELEMENT*)malloc( sizeof(BUFFER_LIST_ELEMENT) );
+	if ( pBufferDescriptor == 0 )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+		}
+	if ( bNoError )
+		{
+		pBufferElement = (A_USER_INFO_ITEM_HEADER_BUFFER*)malloc( sizeof(A_USER_INFO_ITEM_HEADER_BUFFER) );
+		if ( pBufferElement == 0 )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+			free( pBufferDescriptor );
+			}
+		else
+			{
+			memset( (char*)pBufferElement, '\0', sizeof(A_USER_INFO_ITEM_HEADER_BUFFER) );
+			pBufferElement -> PDU_Type = 0x50;
+			pBufferElement -> Reserved1 = 0x00;
+			}
+		}
+	if ( bNoError )
+		{
+		pBufferElement -> Length = 0L;
+		pBufferDescriptor -> BufferType = BUFTYPE_A_USER_INFO_ITEM_HEADER_BUFFER;
+		pBufferDescriptor -> MaxBufferLength = sizeof(A_USER_INFO_ITEM_HEADER_BUFFER);
+		pBufferDescriptor -> InsertedBufferLength = 4;
+		pBufferDescriptor -> bInsertedLengthIsFinalized = FALSE;
+		pBufferDescriptor -> pBuffer = (void*)pBufferElement;
+
+		bNoError = PrefixToList( &pAssociation -> AssociationBufferList, pBufferDescriptor );
+		if ( !bNoError )
+			{
+			free( pBufferElement );
+			free( pBufferDescriptor );
+			}
+		}
+	// Prepare each subitem buffer and append it to this buffer.
+	if ( bNoError )
+		bNoError = PrepareMaximumLengthBuffer( pAssociation );
+	if ( bNoError )
+		bNoError = AppendSubitemBuffer( pAssociation, pBufferDescriptor );
+	if ( bNoError )
+		bNoError = PrepareImplementationClassUIDBuffer( pAssociation );
+	if ( bNoError )
+		bNoError = AppendSubitemBuffer( pAssociation, pBufferDescriptor );
+	if ( bNoError )
+		bNoError = PrepareAsynchronousOperationsWindowBuffer( pAssociation );
+	if ( bNoError )
+		bNoError = AppendSubitemBuffer( pAssociation, pBufferDescriptor );
+	if ( bNoError )
+		bNoError = PrepareImplementationVersionNameBuffer( pAssociation );
+	if ( bNoError )
+		bNoError = AppendSubitemBuffer( pAssociation, pBufferDescriptor );
+	if ( bNoError )
+		{
+		pBufferElement = (A_USER_INFO_ITEM_HEADER_BUFFER*)pBufferDescriptor -> pBuffer;
+		pBufferElement -> Length = (unsigned short)( pBufferDescriptor -> InsertedBufferLength - 4 );
+		AssociationSwapBytes( pAssociation, &pBufferElement -> Length, 2 );
+		pBufferDescriptor -> bInsertedLengthIsFinalized = TRUE;
+		}
+
+	return bNoError;
+}
+
+
+static BOOL PrepareAssociationRequestBuffer( DICOM_ASSOCIATION *pAssociation )
+{
+	BOOL							bNoError = TRUE;
+	LIST_ELEMENT					*pListElement;
+	BUFFER_LIST_ELEMENT				*pBufferDescriptor;
+	A_ASSOCIATE_RQ_HEADER_BUFFER	*pBufferElement;
+	int								nContext;
+
+	pBufferDescriptor = (BUFFER_LIST_ELEMENT*)malloc( sizeof(BUFFER_LIST_ELEMENT) );
+	if ( pBufferDescriptor == 0 )
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+		}
+	if ( bNoError )
+		{
+		pBufferElement = (A_ASSOCIATE_RQ_HEADER_BUFFER*)malloc( sizeof(A_ASSOCIATE_RQ_HEADER_BUFFER) );
+		if ( pBufferElement == 0 )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+			free( pBufferDescriptor );
+			}
+		else
+			{
+			memset( (char*)pBufferElement, '\0', sizeof(A_ASSOCIATE_RQ_HEADER_BUFFER) );
+			pBufferElement -> PDU_Type = 0x01;
+			pBufferElement -> Reserved1 = 0x00;
+			pBufferElement -> ProtocolVersion = 0x0001;
+			AssociationSwapBytes( pAssociation, &pBufferElement -> ProtocolVersion, 2 );
+			pBufferElement -> Reserved2 = 0x0000;
+			}
+		}
+	if ( bNoError )
+		{
+		pBufferDescriptor -> BufferType = BUFTYPE_A_ASSOCIATE_RQ_HEADER_BUFFER;
+		pBufferDescriptor -> MaxBufferLength = sizeof(A_ASSOCIATE_RQ_HEADER_BUFFER);
+		pBufferDescriptor -> InsertedBufferLength = sizeof(A_ASSOCIATE_RQ_HEADER_BUFFER);
+		pBufferDescriptor -> bInsertedLengthIsFinalized = FALSE;
+		pBufferDescriptor -> pBuffer = (void*)pBufferElement;
+		// The AE_TITLEs should be padded with spaces, without a null terminator.
+		memcpy( pBufferElement -> CalledAETitle, pAssociation -> RemoteAE_Title, 16 );
+		memcpy( pBufferElement -> CallingAETitle, pAssociation -> LocalAE_Title, 16 );
+
+		bNoError = PrefixToList( &pAssociation -> AssociationBufferList, (void*)pBufferDescriptor );
+		}
+	// Following this header, the buffer shall contain the following items:
+	// one Application Context Item, one or more Presentation Context Items and one User Information Item.
+	if ( bNoError )
+		bNoError = PrepareApplicationContextBuffer( pAssociation );
+	if ( bNoError )
+		bNoError = AppendSubitemBuffer( pAssociation, pBufferDescriptor );
+	for ( nContext = 0; bNoError && nContext < nForwardingPresentationContexts; nContext++ )
+		{
+		bNoError = PreparePresentationContextRequestBuffer( pAssociation, &ForwardingPresentationContexts[ nContext ] );
+		if ( bNoError )
+			bNoError = AppendSubitemBuffer( pAssociation, pBufferDescriptor );
+		}
+	if ( bNoError )
+		bNoError = PrepareRequestUserInformationBuffer( pAssociation );
+	if ( bNoError )
+		bNoError = AppendSubitemBuffer( pAssociation, pBufferDescriptor );
+	if ( bNoError )
+		{
+		// The association buffer list now begins with the consolidated buffer, ready for the
+		// transport layer to send.  Take it off the list.
+		pBufferElement = (A_ASSOCIATE_RQ_HEADER_BUFFER*)pBufferDescriptor -> pBuffer;
+		pAssociation -> SendBufferLength = pBufferDescriptor -> InsertedBufferLength;
+		pBufferElement -> PDULength = pBufferDescriptor -> InsertedBufferLength - 6;
+		AssociationSwapBytes( pAssociation, &pBufferElement -> PDULength, 4 );
+		pAssociation -> pSendBuffer = (char*)pBufferElement;
+		pListElement = pAssociation -> AssociationBufferList;
+		pAssociation -> AssociationBufferList = pListElement -> pNextListElement;
+		free( pListElement );
+		free( pBufferDescriptor );
+		}
+
+	return bNoError;
+}
+
+
+// Parse the destination's reply to the association request.  For an acceptance, record which
+// presentation contexts were accepted, the maximum PDU length for sending and the number of
+// C-Store requests that may be outstanding.
+static BOOL ParseAssociationRequestReplyBuffer( DICOM_ASSOCIATION *pAssociation )
+{
+	BOOL								bNoError = TRUE;
+	unsigned char						*pBuffer;
+	unsigned char						*pEndOfBuffer;
+	unsigned char						*pItem;
+	unsigned char						*pEndOfItem;
+	unsigned char						*pSubitem;
+	unsigned short						ItemLength;
+	unsigned short						SubitemLength;
+	unsigned long						MaxLengthReceivable;
+	unsigned short						MaxOperationsInvoked;
+	BOOL								bAsyncOperationsWindowReturned;
+	A_ASSOCIATE_RJ_BUFFER				*pRejectionBuffer;
+	FORWARDING_PRESENTATION_CONTEXT		*pPresentationContext;
+	int									nContext;
+	char								TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	pBuffer = (unsigned char*)pAssociation -> pReceivedBuffer;
+	pEndOfBuffer = pBuffer + pAssociation -> ReceivedBufferLength;
+	pAssociation -> bAssociationAccepted = FALSE;
+	MaxLengthReceivable = MAX_ASSOCIATION_RECEIVED_BUFFER_SIZE;
+	MaxOperationsInvoked = 1;
+	bAsyncOperationsWindowReturned = FALSE;
+	switch ( pBuffer[ 0 ] )
+		{
+		case 0x02:			// A-ASSOCIATE-AC
+			bNoError = ( pAssociation -> ReceivedBufferLength >= sizeof(A_ASSOCIATE_AC_HEADER_BUFFER) );
+			pItem = pBuffer + sizeof(A_ASSOCIATE_AC_HEADER_BUFFER);
+			while ( bNoError && pItem + 4 <= pEndOfBuffer )
+				{
+				memcpy( &ItemLength, pItem + 2, 2 );
+				AssociationSwapBytes( pAssociation, &ItemLength, 2 );
+				pEndOfItem = pItem + 4 + ItemLength;
+				bNoError = ( pEndOfItem <= pEndOfBuffer );
+				if ( bNoError && pItem[ 0 ] == 0x21 && ItemLength >= 4 )
+					{
+					// Presentation context reply:  ID, reserved, result, reserved, then the selected transfer syntax.
+					for ( nContext = 0; nContext < nForwardingPresentationContexts; nContext++ )
+						{
+						pPresentationContext = &ForwardingPresentationContexts[ nContext ];
+						if ( pPresentationContext -> PresentationContextID == pItem[ 4 ] )
+							pPresentationContext -> bAccepted = ( pItem[ 6 ] == PRES_CONTEXT_RESULT_ACCEPTED );
+						}
+					}
+				else if ( bNoError && pItem[ 0 ] == 0x50 )
+					{
+					pSubitem = pItem + 4;
+					while ( bNoError && pSubitem + 4 <= pEndOfItem )
+						{
+						memcpy( &SubitemLength, pSubitem + 2, 2 );
+						AssociationSwapBytes( pAssociation, &SubitemLength, 2 );
+						bNoError = ( pSubitem + 4 + SubitemLength <= pEndOfItem );
+						if ( bNoError && pSubitem[ 0 ] == 0x51 && SubitemLength == 4 )
+							{
+							memcpy( &MaxLengthReceivable, pSubitem + 4, 4 );
+							AssociationSwapBytes( pAssociation, &MaxLengthReceivable, 4 );
+							}
+						else if ( bNoError && pSubitem[ 0 ] == 0x53 && SubitemLength == 4 )
+							{
+							memcpy( &MaxOperationsInvoked, pSubitem + 4, 2 );
+							AssociationSwapBytes( pAssociation, &MaxOperationsInvoked, 2 );
+							bAsyncOperationsWindowReturned = TRUE;
+							}
+						pSubitem += 4 + SubitemLength;
+						}
+					}
+				pItem = pEndOfItem;
+				}
+			// A maximum length of zero means no maximum was specified.  A very small maximum leaves
+			// no room for the data in each PDU, so the association is not used.
+			if ( bNoError && MaxLengthReceivable != 0 && MaxLengthReceivable < MIN_FORWARDING_SEND_PDU_LENGTH )
+				{
+				_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
+								"    The forwarding destination accepts a maximum PDU length of only %d bytes.", MaxLengthReceivable );
+				LogMessage( TextLine, MESSAGE_TYPE_ERROR );
+				RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_PDU_LENGTH_TOO_SMALL );
+				bNoError = FALSE;
+				}
+			else if ( bNoError )
+				{
+				pAssociation -> bAssociationAccepted = TRUE;
+				if ( MaxLengthReceivable == 0 || MaxLengthReceivable > MAX_FORWARDING_SEND_PDU_LENGTH )
+					MaxLengthReceivable = MAX_FORWARDING_SEND_PDU_LENGTH;
+				pAssociation -> MaxSendPDULength = MaxLengthReceivable;
+				// Without an asynchronous operations window, only one operation may be outstanding.  A
+				// returned value of zero means the number of operations is unlimited.
+				if ( !bAsyncOperationsWindowReturned )
+					pAssociation -> MaxOperationsInvoked = 1;
+				else if ( MaxOperationsInvoked == 0 || MaxOperationsInvoked > MAX_OUTSTANDING_STORE_REQUESTS )
+					pAssociation -> MaxOperationsInvoked = MAX_OUTSTANDING_STORE_REQUESTS;
+				else
+					pAssociation -> MaxOperationsInvoked = MaxOperationsInvoked;
+				}
+			else
+				RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_UNEXPECTED_PDU );
+			break;
+		case 0x03:			// A-ASSOCIATE-RJ
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_ASSOCIATION_REJECTED );
+			if ( pAssociation -> ReceivedBufferLength >= sizeof(A_ASSOCIATE_RJ_BUFFER) )
+				{
+				pRejectionBuffer = (A_ASSOCIATE_RJ_BUFFER*)pBuffer;
+				pAssociation -> bRejectionIsTransient = ( pRejectionBuffer -> Result == ASSOC_REJECTION_RESULT_TRANSIENT );
+				pAssociation -> RejectionSource = pRejectionBuffer -> Source;
+				pAssociation -> RejectionReason = pRejectionBuffer -> Reason;
+				_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE, "    Rejection result = %d, source = %d, reason = %d.",
+								pRejectionBuffer -> Result, pRejectionBuffer -> Source, pRejectionBuffer -> Reason );
+				LogMessage( TextLine, MESSAGE_TYPE_ERROR );
+				}
+			break;
+		case 0x07:			// A-ABORT
+			bNoError = FALSE;
+			LogMessage( "The forwarding destination aborted the association request.", MESSAGE_TYPE_ERROR );
+			break;
+		default:
+			bNoError = FALSE;
+			RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_UNEXPECTED_PDU );
+			break;
+		}
+	free( pAssociation -> pReceivedBuffer );
+	pAssociation -> pReceivedBuffer = 0;
+	pAssociation -> ReceivedBufferLength = 0L;
+
+	return bNoError;
+}
+
+
+static BOOL OpenForwardingAssociation( PRODUCT_OPERATION *pSendOperation, FORWARDED_IMAGE *pFirstForwardedImage )
+{
+	BOOL					bNoError = TRUE;
+	DICOM_ASSOCIATION		*pAssociation;
+	ULONGLONG				RetryDelay;
+	char					TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	pAssociation = CreateAssociationStructure( pSendOperation );
+	bNoError = ( pAssociation != 0 );
+	if ( bNoError )
+		{
+		// This node calls using the AE title by which it receives images.
+		if ( strlen( EndPointNetworkIn.AE_TITLE ) <= 16 )
+			memcpy( pAssociation -> LocalAE_Title, EndPointNetworkIn.AE_TITLE, strlen( EndPointNetworkIn.AE_TITLE ) );
+		pAssociation -> bAssociationSyntaxIsBigEndian = TRUE;
+		bNoError = ConnectToForwardingDestination( pAssociation, pSendOperation -> pOutputEndPoint );
+		}
+	if ( bNoError )
+		{
+		RegisterForwardingPresentationContexts( pFirstForwardedImage );
+		bNoError = PrepareAssociationRequestBuffer( pAssociation );
+		}
+	if ( bNoError )
+		bNoError = SendDicomBuffer( pAssociation, TRUE );
+	if ( bNoError )
+		bNoError = ReceiveDicomBuffer( pAssociation );
+	if ( bNoError )
+		bNoError = ParseAssociationRequestReplyBuffer( pAssociation );
+	if ( bNoError )
+		{
+		pAssociation -> bAssociationIsActive = TRUE;
+		pAssociation -> AssociationStartTime = GetTickCount64();
+		pForwardingAssociation = pAssociation;
+		nOutstandingStoreRequests = 0;
+		nImagesForwarded = 0L;
+		nImageBytesForwarded = 0;
+		nFailedAssociationAttempts = 0L;
+		NextAssociationAttemptTime = 0;
+		LastForwardingActivityTime = GetTickCount64();
+		_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
+						"Forwarding association accepted by %s:  maximum PDU length %d, up to %d outstanding C-Store requests.",
+						pAssociation -> RemoteNodeName, pAssociation -> MaxSendPDULength, pAssociation -> MaxOperationsInvoked );
+		LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+	else
+		{
+		if ( pAssociation != 0 )
+			{
+			if ( pAssociation -> DicomAssociationSocket != INVALID_SOCKET )
+				CloseConnection( pAssociation -> DicomAssociationSocket );
+			DeleteAssociationStructure( pAssociation );
+			}
+		nFailedAssociationAttempts++;
+		RetryDelay = ComputeRetryDelay( nFailedAssociationAttempts );
+		NextAssociationAttemptTime = GetTickCount64() + RetryDelay;
+		_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
+						"Unable to open a forwarding association.  Retrying in %d seconds.", (int)( RetryDelay / 1000 ) );
+		LogMessage( TextLine, MESSAGE_TYPE_ERROR );
+		}
+
+	return bNoError;
+}
+
+
+static void LogAssociationForwardingRate( DICOM_ASSOCIATION *pAssociation )
+{
+	ULONGLONG				ElapsedMilliseconds;
+	double					ElapsedSeconds;
+	double					ImagesPerSecond;
+	double					MegabytesPerSecond;
+	char					TextString[ MAX_LOGGING_STRING_LENGTH ];
+
+	if ( nImagesForwarded > 0 )
+		{
+		ElapsedMilliseconds = GetTickCount64() - pAssociation -> AssociationStartTime;
+		if ( ElapsedMilliseconds == 0 )
+			ElapsedMilliseconds = 1;
+		ElapsedSeconds = (double)ElapsedMilliseconds / 1000.0;
+		ImagesPerSecond = (double)nImagesForwarded / ElapsedSeconds;
+		MegabytesPerSecond = (double)nImageBytesForwarded / ( 1048576.0 * ElapsedSeconds );
+		_snprintf_s( TextString, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
+						"Association with %s forwarded %d images (%I64u bytes) in %.3f seconds:  %.2f images/sec, %.2f MB/sec.",
+							pAssociation -> RemoteNodeName, nImagesForwarded, nImageBytesForwarded,
+							ElapsedSeconds, ImagesPerSecond, MegabytesPerSecond );
+		LogMessage( TextString, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+}
+
+
+// Close the connection after a failure.  Every C-Store request still awaiting a response
+// is treated as having failed.
+static void AbortForwardingAssociation()
+{
+	FORWARDED_IMAGE			*pForwardedImage;
+	ULONGLONG				RetryDelay;
+
+	LogMessage( "The forwarding association was lost.", MESSAGE_TYPE_ERROR );
+	pForwardedImage = GetOutstandingForwardedImage( 0 );
+	while ( pForwardedImage != 0 )
+		{
+		RecordForwardingFailure( pForwardedImage );
+		pForwardedImage = GetOutstandingForwardedImage( 0 );
+		}
+	nOutstandingStoreRequests = 0;
+	if ( pReceivedCommandBuffer != 0 )
+		{
+		free( pReceivedCommandBuffer );
+		pReceivedCommandBuffer = 0;
+		}
+	ReceivedCommandLength = 0L;
+	CloseConnection( pForwardingAssociation -> DicomAssociationSocket );
+	LogAssociationForwardingRate( pForwardingAssociation );
+	DeleteAssociationStructure( pForwardingAssociation );
+	pForwardingAssociation = 0;
+	nFailedAssociationAttempts++;
+	RetryDelay = ComputeRetryDelay( nFailedAssociationAttempts );
+	NextAssociationAttemptTime = GetTickCount64() + RetryDelay;
+}
+
+
+
+//____________________________________________________________________________________________________________________________________________________________
+// *[2] C-Store request functions.
+//
+
+static BOOL PrepareCStoreCommandRequestBuffer( FORWARDED_IMAGE *pForwardedImage, unsigned short MessageID,
+													char **ppBuffer, unsigned long *pBufferSize )
+{
+	BOOL							bNoError = TRUE;
+	DATA_ELEMENT_GROUP_LENGTH		GroupLengthElement;
+	DATA_ELEMENT_HEADER_IMPLICIT_VR	BufferElement;
+	DATA_ELEMENT_COMMAND_FIELD		CommandFieldElement;
+	DATA_ELEMENT_MESSAGE_ID			MessageIDElement;
+	DATA_ELEMENT_PRIORITY			PriorityElement;
+	DATA_ELEMENT_DATASET_TYPE		DataSetTypeElement;
+	char							*pBuffer;
+	char							*pBufferInsertPoint;
+	unsigned long					SOPClassValueLength;
+	unsigned long					SOPInstanceValueLength;
+	unsigned long					TotalBufferSize;
+	BOOL							bSOPClassUIDLengthIsOdd;
+	BOOL							bSOPInstanceUIDLengthIsOdd;
+
+	// Determine the overall buffer length.  The only variable parts are the affected SOP class and instance UID elements.
+	SOPClassValueLength = (unsigned long)strlen( pForwardedImage -> SOPClassUID );
+	bSOPClassUIDLengthIsOdd = ( ( SOPClassValueLength & 0x00000001 ) != 0 );
+	if ( bSOPClassUIDLengthIsOdd )
+		SOPClassValueLength++;					// Make the value length an even number of bytes.
+	SOPInstanceValueLength = (unsigned long)strlen( pForwardedImage -> SOPInstanceUID );
+	bSOPInstanceUIDLengthIsOdd = ( ( SOPInstanceValueLength & 0x00000001 ) != 0 );
+	if ( bSOPInstanceUIDLengthIsOdd )
+		SOPInstanceValueLength++;				// Make the value length an even number of bytes.
+	TotalBufferSize = sizeof(DATA_ELEMENT_GROUP_LENGTH) + sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR) + SOPClassValueLength +
+						sizeof(DATA_ELEMENT_COMMAND_FIELD) + sizeof(DATA_ELEMENT_MESSAGE_ID) + sizeof(DATA_ELEMENT_PRIORITY) +
+						sizeof(DATA_ELEMENT_DATASET_TYPE) + sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR) + SOPInstanceValueLength;
+	// Allocate and fill the message buffer.
+	pBuffer = (char*)malloc( TotalBufferSize );
+	if ( pBuffer != 0 )
+		{
+		pBufferInsertPoint = pBuffer;
+		// Insert the Group Length dicom element into the buffer.
+		GroupLengthElement.Group = 0x0000;
+		GroupLengthElement.Element = 0x0000;
+		GroupLengthElement.ValueLength = 4L;
+		GroupLengthElement.Value = TotalBufferSize - sizeof(DATA_ELEMENT_GROUP_LENGTH);
+		memcpy( pBufferInsertPoint, (char*)&GroupLengthElement, sizeof(DATA_ELEMENT_GROUP_LENGTH) );
+		pBufferInsertPoint += sizeof(DATA_ELEMENT_GROUP_LENGTH);
+		// Insert the affected SOP class dicom element into the buffer.
+		BufferElement.Group = 0x0000;
+		BufferElement.Element = 0x0002;
+		BufferElement.ValueLength = SOPClassValueLength;
+		memcpy( pBufferInsertPoint, (char*)&BufferElement, sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR) );
+		pBufferInsertPoint += sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR);
+		memcpy( pBufferInsertPoint, pForwardedImage -> SOPClassUID, SOPClassValueLength );
+		if ( bSOPClassUIDLengthIsOdd )
+			*( pBufferInsertPoint + SOPClassValueLength - 1 ) = '\0';	// Pad the UID value with a null.
+		pBufferInsertPoint += SOPClassValueLength;
+		// Insert the Command Field dicom element into the buffer.
+		CommandFieldElement.Group = 0x0000;
+		CommandFieldElement.Element = 0x0100;
+		CommandFieldElement.ValueLength = 2L;
+		CommandFieldElement.Value = DICOM_CMD_STORE;					// Designates the C-Store request command.
+		memcpy( pBufferInsertPoint, (char*)&CommandFieldElement, sizeof(DATA_ELEMENT_COMMAND_FIELD) );
+		pBufferInsertPoint += sizeof(DATA_ELEMENT_COMMAND_FIELD);
+		// Insert the Message ID dicom element into the buffer.
+		MessageIDElement.Group = 0x0000;
+		MessageIDElement.Element = 0x0110;
+		MessageIDElement.ValueLength = 2L;
+		MessageIDElement.Value = MessageID;
+		memcpy( pBufferInsertPoint, (char*)&MessageIDElement, sizeof(DATA_ELEMENT_MESSAGE_ID) );
+		pBufferInsertPoint += sizeof(DATA_ELEMENT_MESSAGE_ID);
+		// Insert the Priority dicom element into the buffer.
+		PriorityElement.Group = 0x0000;
+		PriorityElement.Element = 0x0700;
+		PriorityElement.ValueLength = 2L;
+		PriorityElement.Value = DATA_ELEMENT_PRIORITY_MEDIUM;
+		memcpy( pBufferInsertPoint, (char*)&PriorityElement, sizeof(DATA_ELEMENT_PRIORITY) );
+		pBufferInsertPoint += sizeof(DATA_ELEMENT_PRIORITY);
+		// Insert the Data Set Type dicom element into the buffer.
+		DataSetTypeElement.Group = 0x0000;
+		DataSetTypeElement.Element = 0x0800;
+		DataSetTypeElement.ValueLength = 2L;
+		DataSetTypeElement.Value = 0x0000;								// Indicate a data set follows.
+		memcpy( pBufferInsertPoint, (char*)&DataSetTypeElement, sizeof(DATA_ELEMENT_DATASET_TYPE) );
+		pBufferInsertPoint += sizeof(DATA_ELEMENT_DATASET_TYPE);
+		// Insert the affected SOP instance dicom element into the buffer.
+		BufferElement.Group = 0x0000;
+		BufferElement.Element = 0x1000;
+		BufferElement.ValueLength = SOPInstanceValueLength;
+		memcpy( pBufferInsertPoint, (char*)&BufferElement, sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR) );
+		pBufferInsertPoint += sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR);
+		memcpy( pBufferInsertPoint, pForwardedImage -> SOPInstanceUID, SOPInstanceValueLength );
+		if ( bSOPInstanceUIDLengthIsOdd )
+			*( pBufferInsertPoint + SOPInstanceValueLength - 1 ) = '\0';	// Pad the UID value with a null.
+		pBufferInsertPoint += SOPInstanceValueLength;
+		}
+	else
+		{
+		bNoError = FALSE;
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+		}
+	if ( bNoError )
+		{
+		*ppBuffer = pBuffer;
+		*pBufferSize = TotalBufferSize;
+		}
+	else
+		{
+		*ppBuffer = 0;
+		*pBufferSize = 0L;
+		}
+
+	return bNoError;
+}
+
+
+// Send a P-Data PDU containing a single message fragment.  The fragment has already been placed in the
+// buffer, following space reserved for the PDU and PDV headers.
+static BOOL SendMessageFragment( DICOM_ASSOCIATION *pAssociation, char *pBuffer, unsigned char PresentationContextID,
+									unsigned char MessageControlHeader, unsigned long FragmentLength )
+{
+	BOOL							bNoError = TRUE;
+	DATA_TRANSFER_PDU_HEADER		MessagePacketHeader;
+	PRESENTATION_DATA_VALUE_HEADER	MessageFragmentHeader;
+	unsigned long					TotalBufferSize;
+
+	TotalBufferSize = sizeof(DATA_TRANSFER_PDU_HEADER) + sizeof(PRESENTATION_DATA_VALUE_HEADER) + FragmentLength;
+	// Insert the message packet header.
+	MessagePacketHeader.PDU_Type = 0x04;
+	MessagePacketHeader.Reserved1 = 0x00;
+	MessagePacketHeader.PDULength = TotalBufferSize - sizeof(DATA_TRANSFER_PDU_HEADER);
+	AssociationSwapBytes( pAssociation, &MessagePacketHeader.PDULength, 4 );
+	memcpy( pBuffer, (char*)&MessagePacketHeader, sizeof(DATA_TRANSFER_PDU_HEADER) );
+	// Insert the presentation data value item header.
+	MessageFragmentHeader.PDVItemLength = FragmentLength + 2;
+	AssociationSwapBytes( pAssociation, &MessageFragmentHeader.PDVItemLength, 4 );
+	MessageFragmentHeader.PresentationContextID = PresentationContextID;
+	MessageFragmentHeader.MessageControlHeader = MessageControlHeader;
+	memcpy( pBuffer + sizeof(DATA_TRANSFER_PDU_HEADER), (char*)&MessageFragmentHeader, sizeof(PRESENTATION_DATA_VALUE_HEADER) );
+
+	pAssociation -> pSendBuffer = pBuffer;
+	pAssociation -> SendBufferLength = TotalBufferSize;
+	bNoError = SendDicomBuffer( pAssociation, FALSE );
+	pAssociation -> pSendBuffer = 0;
+	pAssociation -> SendBufferLength = 0L;
+
+	return bNoError;
+}
+
+
+// Send the C-Store request command, followed by the image data set read from the file in fragments
+// no longer than the destination will accept.  The response is collected later, so that other
+// requests can be sent while this one is being processed.  Returns FALSE if the association
+// can no longer be used.
+static BOOL SendCStoreRequest( FORWARDED_IMAGE *pForwardedImage, FORWARDING_PRESENTATION_CONTEXT *pPresentationContext )
+{
+	BOOL							bNoError = TRUE;
+	DICOM_ASSOCIATION				*pAssociation;
+	FILE							*pImageFile;
+	errno_t							FileError;
+	char							*pCommandBuffer;
+	unsigned long					CommandBufferSize;
+	char							*pBuffer;
+	char							*pFragment;
+	unsigned long					MaxFragmentLength;
+	unsigned long					FragmentLength;
+	unsigned long					RemainingDataSetLength;
+	unsigned short					MessageID;
+	unsigned char					MessageControlHeader;
+
+	pAssociation = pForwardingAssociation;
+	pCommandBuffer = 0;
+	pBuffer = 0;
+	// Open the image file before anything is sent, so that a file problem doesn't disrupt the association.
+	pImageFile = 0;
+	FileError = fopen_s( &pImageFile, pForwardedImage -> ImageFileSpec, "rb" );
+	if ( FileError != 0 || pImageFile == 0 || fseek( pImageFile, (long)pForwardedImage -> DataSetOffset, SEEK_SET ) != 0 )
+		{
+		RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_FILE_OPEN );
+		if ( pImageFile != 0 )
+			fclose( pImageFile );
+		RecordForwardingFailure( pForwardedImage );
+		}
+	else
+		{
+		LastMessageIDSent++;
+		if ( LastMessageIDSent == 0 )
+			LastMessageIDSent++;
+		MessageID = LastMessageIDSent;
+		// Each fragment's presentation data value item header occupies 6 bytes of the PDU.
+		MaxFragmentLength = pAssociation -> MaxSendPDULength - sizeof(PRESENTATION_DATA_VALUE_HEADER);
+		bNoError = PrepareCStoreCommandRequestBuffer( pForwardedImage, MessageID, &pCommandBuffer, &CommandBufferSize );
+		if ( bNoError )
+			{
+			if ( CommandBufferSize > MaxFragmentLength )
+				MaxFragmentLength = CommandBufferSize;
+			pBuffer = (char*)malloc( sizeof(DATA_TRANSFER_PDU_HEADER) + sizeof(PRESENTATION_DATA_VALUE_HEADER) + MaxFragmentLength );
+			if ( pBuffer == 0 )
+				{
+				bNoError = FALSE;
+				RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+				}
+			}
+		if ( bNoError )
+			{
+			pFragment = pBuffer + sizeof(DATA_TRANSFER_PDU_HEADER) + sizeof(PRESENTATION_DATA_VALUE_HEADER);
+			memcpy( pFragment, pCommandBuffer, CommandBufferSize );
+			bNoError = SendMessageFragment( pAssociation, pBuffer, pPresentationContext -> PresentationContextID,
+												CONTAINS_COMMAND_MESSAGE | LAST_MESSAGE_FRAGMENT, CommandBufferSize );
+			}
+		if ( bNoError )
+			{
+			// From here on, any failure is resolved when the association is aborted.
+			pForwardedImage -> MessageID = MessageID;
+			nOutstandingStoreRequests++;
+			}
+		RemainingDataSetLength = pForwardedImage -> DataSetSize;
+		while ( bNoError && RemainingDataSetLength > 0 )
+			{
+			FragmentLength = RemainingDataSetLength;
+			if ( FragmentLength > MaxFragmentLength )
+				FragmentLength = MaxFragmentLength;
+			bNoError = ( fread( pFragment, 1, FragmentLength, pImageFile ) == FragmentLength );
+			if ( bNoError )
+				{
+				RemainingDataSetLength -= FragmentLength;
+				if ( RemainingDataSetLength == 0 )
+					MessageControlHeader = LAST_MESSAGE_FRAGMENT;
+				else
+					MessageControlHeader = 0x00;
+				bNoError = SendMessageFragment( pAssociation, pBuffer, pPresentationContext -> PresentationContextID,
+													MessageControlHeader, FragmentLength );
+				}
+			}
+		fclose( pImageFile );
+		if ( pCommandBuffer != 0 )
+			free( pCommandBuffer );
+		if ( pBuffer != 0 )
+			free( pBuffer );
+		LastForwardingActivityTime = GetTickCount64();
+		}
+
+	return bNoError;
+}
+
+
+static void ProcessCStoreResponse( char *pCommandSet, unsigned long CommandSetLength )
+{
+	DATA_ELEMENT_HEADER_IMPLICIT_VR	ElementHeader;
+	unsigned long					nOffset;
+	unsigned short					CommandField;
+	unsigned short					MessageIDBeingRespondedTo;
+	unsigned short					Status;
+	FORWARDED_IMAGE					*pForwardedImage;
+	char							TextLine[ MAX_FILE_SPEC_LENGTH ];
+
+	CommandField = DICOM_CMD_UNSPECIFIED;
+	MessageIDBeingRespondedTo = 0;
+	Status = 0xFFFF;
+	// The command set uses little endian, implicit VR data element encoding.
+	nOffset = 0L;
+	while ( nOffset + sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR) <= CommandSetLength )
+		{
+		memcpy( &ElementHeader, pCommandSet + nOffset, sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR) );
+		nOffset += sizeof(DATA_ELEMENT_HEADER_IMPLICIT_VR);
+		if ( ElementHeader.ValueLength > CommandSetLength - nOffset )
+			nOffset = CommandSetLength;
+		else
+			{
+			if ( ElementHeader.Group == 0x0000 && ElementHeader.ValueLength == 2 )
+				{
+				if ( ElementHeader.Element == 0x0100 )
+					memcpy( &CommandField, pCommandSet + nOffset, 2 );
+				else if ( ElementHeader.Element == 0x0120 )
+					memcpy( &MessageIDBeingRespondedTo, pCommandSet + nOffset, 2 );
+				else if ( ElementHeader.Element == 0x0900 )
+					memcpy( &Status, pCommandSet + nOffset, 2 );
+				}
+			nOffset += ElementHeader.ValueLength;
+			}
+		}
+	pForwardedImage = 0;
+	if ( CommandField == DICOM_CMD_STORE_RESPONSE && MessageIDBeingRespondedTo != 0 )
+		pForwardedImage = GetOutstandingForwardedImage( MessageIDBeingRespondedTo );
+	if ( pForwardedImage == 0 )
+		{
+		_snprintf_s( TextLine, MAX_FILE_SPEC_LENGTH, _TRUNCATE,
+						"Ignored a response (command %04X, message ID %d) matching no outstanding C-Store request.",
+						CommandField, MessageIDBeingRespondedTo );
+		LogMessage( TextLine, MESSAGE_TYPE_ERROR );
+		}
+	else
+		{
+		nOutstandingStoreRequests--;
+		pForwardedImage -> MessageID = 0;
+		// Warning statuses (Bxxx) indicate the image was stored.
+		if ( Status == 0x0000 || ( Status & 0xF000 ) == 0xB000 )
+			CompleteForwardedImage( pForwardedImage, Status );
+		else
+			{
+			RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_STORE_FAILED );
+			_snprintf_s( TextLine, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "    C-Store status %04X for %s",
+							Status, pForwardedImage -> ImageFileSpec );
+			LogMessage( TextLine, MESSAGE_TYPE_ERROR );
+			RecordForwardingFailure( pForwardedImage );
+			}
+		}
+}
+
+
+// Receive one PDU from the forwarding destination and process any C-Store responses it completes.
+// Returns FALSE if the association can no longer be used.
+static BOOL ReceiveCStoreResponse()
+{
+	BOOL							bNoError = TRUE;
+	DICOM_ASSOCIATION				*pAssociation;
+	char							*pPDVItem;
+	char							*pEndOfBuffer;
+	PRESENTATION_DATA_VALUE_HEADER	MessageFragmentHeader;
+	unsigned long					FragmentLength;
+	char							*pExpandedCommandBuffer;
+
+	pAssociation = pForwardingAssociation;
+	bNoError = ReceiveDicomBuffer( pAssociation );
+	if ( bNoError )
+		{
+		switch ( (unsigned char)pAssociation -> pReceivedBuffer[ 0 ] )
+			{
+			case 0x04:			// P-DATA-TF
+				pPDVItem = pAssociation -> pReceivedBuffer + sizeof(DATA_TRANSFER_PDU_HEADER);
+				pEndOfBuffer = pAssociation -> pReceivedBuffer + pAssociation -> ReceivedBufferLength;
+				while ( bNoError && pPDVItem + sizeof(PRESENTATION_DATA_VALUE_HEADER) <= pEndOfBuffer )
+					{
+					memcpy( &MessageFragmentHeader, pPDVItem, sizeof(PRESENTATION_DATA_VALUE_HEADER) );
+					AssociationSwapBytes( pAssociation, &MessageFragmentHeader.PDVItemLength, 4 );
+					bNoError = ( MessageFragmentHeader.PDVItemLength >= 2 &&
+									MessageFragmentHeader.PDVItemLength <= (unsigned long)( pEndOfBuffer - pPDVItem ) - 4 );
+					if ( bNoError && ( MessageFragmentHeader.MessageControlHeader & CONTAINS_COMMAND_MESSAGE ) != 0 )
+						{
+						// Command sets may arrive in several fragments.  Collect them until the last one arrives.
+						FragmentLength = MessageFragmentHeader.PDVItemLength - 2;
+						pExpandedCommandBuffer = (char*)realloc( pReceivedCommandBuffer, ReceivedCommandLength + FragmentLength + 1 );
+						if ( pExpandedCommandBuffer == 0 )
+							{
+							bNoError = FALSE;
+							RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY );
+							}
+						else
+							{
+							pReceivedCommandBuffer = pExpandedCommandBuffer;
+							memcpy( pReceivedCommandBuffer + ReceivedCommandLength, pPDVItem + sizeof(PRESENTATION_DATA_VALUE_HEADER), FragmentLength );
+							ReceivedCommandLength += FragmentLength;
+							if ( ( MessageFragmentHeader.MessageControlHeader & LAST_MESSAGE_FRAGMENT ) != 0 )
+								{
+								ProcessCStoreResponse( pReceivedCommandBuffer, ReceivedCommandLength );
+								free( pReceivedCommandBuffer );
+								pReceivedCommandBuffer = 0;
+								ReceivedCommandLength = 0L;
+								}
+							}
+						}
+					if ( bNoError )
+						pPDVItem += 4 + MessageFragmentHeader.PDVItemLength;
+					else
+						RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_UNEXPECTED_PDU );
+					}
+				break;
+			case 0x07:			// A-ABORT
+				bNoError = FALSE;
+				LogMessage( "The forwarding destination aborted the association.", MESSAGE_TYPE_ERROR );
+				break;
+			default:
+				bNoError = FALSE;
+				RespondToError( MODULE_DICOMINITIATE, DICOMINITIATE_ERROR_UNEXPECTED_PDU );
+				break;
+			}
+		free( pAssociation -> pReceivedBuffer );
+		pAssociation -> pReceivedBuffer = 0;
+		pAssociation -> ReceivedBufferLength = 0L;
+		}
+	if ( bNoError )
+		LastForwardingActivityTime = GetTickCount64();
+
+	return bNoError;
+}
+
+
+// Collect the outstanding C-Store responses, then release the association.
+static void ReleaseForwardingAssociation()
+{
+	BOOL					bNoError = TRUE;
+	DICOM_ASSOCIATION		*pAssociation;
+
+	pAssociation = pForwardingAssociation;
+	while ( bNoError && nOutstandingStoreRequests > 0 )
+		bNoError = ReceiveCStoreResponse();
+	if ( !bNoError )
+		AbortForwardingAssociation();
+	else
+		{
+		bNoError = PrepareAssociationReleaseRequestBuffer( pAssociation );
+		if ( bNoError )
+			bNoError = SendDicomBuffer( pAssociation, TRUE );
+		if ( bNoError )
+			bNoError = ReceiveDicomBuffer( pAssociation );
+		if ( bNoError )
+			{
+			if ( (unsigned char)pAssociation -> pReceivedBuffer[ 0 ] == 0x06 )
+				ParseAssociationReleaseReplyBuffer( pAssociation );
+			else
+				{
+				LogMessage( "An unexpected reply was received to the forwarding association release request.", MESSAGE_TYPE_SUPPLEMENTARY );
+				free( pAssociation -> pReceivedBuffer );
+				pAssociation -> pReceivedBuffer = 0;
+				pAssociation -> ReceivedBufferLength = 0L;
+				}
+			}
+		CloseConnection( pAssociation -> DicomAssociationSocket );
+		LogMessage( "Released the forwarding association.", MESSAGE_TYPE_SUPPLEMENTARY );
+		LogAssociationForwardingRate( pAssociation );
+		DeleteAssociationStructure( pAssociation );
+		pForwardingAssociation = 0;
+		}
+}
 
 
+// Send every queued image that is ready to be sent, over a single association if possible.  Up to
+// the negotiated number of C-Store requests are sent before waiting for their responses.  Return
+// when nothing more can be sent for now and no responses are outstanding.
+static void ForwardQueuedImages( PRODUCT_OPERATION *pSendOperation )
+{
+	BOOL								bAssociationIsUsable;
+	BOOL								bAwaitingRetryTime;
+	BOOL								bTerminateOperation;
+	FORWARDED_IMAGE						*pForwardedImage;
+	FORWARDING_PRESENTATION_CONTEXT		*pPresentationContext;
+
+	bAwaitingRetryTime = FALSE;
+	do
+		{
+		pForwardedImage = GetNextImageReadyForForwarding();
+		if ( pForwardedImage == 0 )
+			{
+			if ( nOutstandingStoreRequests > 0 && !ReceiveCStoreResponse() )
+				AbortForwardingAssociation();
+			}
+		else
+			{
+			pPresentationContext = 0;
+			if ( pForwardingAssociation != 0 )
+				{
+				pPresentationContext = FindForwardingPresentationContext( pForwardedImage -> SOPClassUID, pForwardedImage -> TransferSyntaxUID );
+				// If the image needs a presentation context that wasn't proposed, start a new association.
+				if ( pPresentationContext == 0 )
+					ReleaseForwardingAssociation();
+				}
+			if ( pForwardingAssociation == 0 )
+				{
+				bAwaitingRetryTime = ( GetTickCount64() < NextAssociationAttemptTime );
+				if ( !bAwaitingRetryTime && OpenForwardingAssociation( pSendOperation, pForwardedImage ) )
+					pPresentationContext = FindForwardingPresentationContext( pForwardedImage -> SOPClassUID, pForwardedImage -> TransferSyntaxUID );
+				}
+			if ( pForwardingAssociation != 0 && pPresentationContext != 0 )
+				{
+				if ( !pPresentationContext -> bAccepted )
+					{
+					LogMessage( "The forwarding destination did not accept the image's SOP class and transfer syntax.", MESSAGE_TYPE_ERROR );
+					RecordForwardingFailure( pForwardedImage );
+					}
+				else
+					{
+					// Wait for room in the asynchronous operations window.
+					bAssociationIsUsable = TRUE;
+					while ( bAssociationIsUsable && nOutstandingStoreRequests >= pForwardingAssociation -> MaxOperationsInvoked )
+						bAssociationIsUsable = ReceiveCStoreResponse();
+					if ( bAssociationIsUsable )
+						bAssociationIsUsable = SendCStoreRequest( pForwardedImage, pPresentationContext );
+					if ( !bAssociationIsUsable )
+						AbortForwardingAssociation();
+					}
+				}
+			}
+		bTerminateOperation = CheckForOperationTerminationRequest( pSendOperation );
+		}
+	while ( !bTerminateOperation && !bAwaitingRetryTime && ( pForwardedImage != 0 || nOutstandingStoreRequests > 0 ) );
+}
+
+
+// The Send Image operation thread forwards queued images to the operation's output endpoint.  The
+// association is kept open between bursts of images and released once it has been idle for a while.
+unsigned __stdcall SendImagesThreadFunction( void *pOperationStruct )
+{
+	BOOL						bTerminateOperation = FALSE;
+	PRODUCT_OPERATION			*pSendOperation;
+	char						TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	pSendOperation = (PRODUCT_OPERATION*)pOperationStruct;
+	_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE, "    Operation Thread: %s", pSendOperation -> OperationName );
+	LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+	if ( !bSocketsEnabled )
+		bSocketsEnabled = InitWindowsSockets();
+	QueueUnsentImageFiles( pSendOperation );
+	while ( !bTerminateOperation )
+		{
+		if ( bSocketsEnabled )
+			ForwardQueuedImages( pSendOperation );
+		if ( pForwardingAssociation != 0 && GetTickCount64() - LastForwardingActivityTime >= AssociationIdleTimeout )
+			ReleaseForwardingAssociation();
+		EnterOperationCycleWaitInterval( pSendOperation, FALSE, &bTerminateOperation );
+		}
+	if ( pForwardingAssociation != 0 )
+		ReleaseForwardingAssociation();
+	CloseOperation( pSendOperation );
+
+	return 0;
+}
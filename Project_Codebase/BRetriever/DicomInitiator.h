@@ -27,11 +27,65 @@
 //	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 //	THE SOFTWARE.
 //
+// UPDATE HISTORY:
+//
+//	*[1] 10/19/2026 by agent
+//		Added the forwarding queue and the C-Store requests for sending processed
+//		images to a network Dicom destination.
+//
+//
 #pragma once
 
 #define DICOMINITIATE_ERROR_INSUFFICIENT_MEMORY				1
+#define DICOMINITIATE_ERROR_CREATE_QUEUE_SEMAPHORE			2
+#define DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_TIMEOUT			3
+#define DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_WAIT			4
+#define DICOMINITIATE_ERROR_QUEUE_SEMAPHORE_RELEASE			5
+#define DICOMINITIATE_ERROR_FILE_META_INFO					6
+#define DICOMINITIATE_ERROR_FILE_OPEN						7
+#define DICOMINITIATE_ERROR_NO_DESTINATION_ADDRESS			8
+#define DICOMINITIATE_ERROR_CONNECT							9
+#define DICOMINITIATE_ERROR_ASSOCIATION_REJECTED			10
+#define DICOMINITIATE_ERROR_UNEXPECTED_PDU					11
+#define DICOMINITIATE_ERROR_STORE_FAILED					12
+#define DICOMINITIATE_ERROR_IMAGE_ABANDONED					13
+#define DICOMINITIATE_ERROR_PDU_LENGTH_TOO_SMALL			14
+
+#define DICOMINITIATE_ERROR_DICT_LENGTH						14
+
 
-#define DICOMINITIATE_ERROR_DICT_LENGTH						1
+#define MAX_OUTSTANDING_STORE_REQUESTS						16			// Asynchronous operations window proposed to the destination.
+#define MAX_FORWARDING_PRESENTATION_CONTEXTS				64
+#define MAX_FORWARDING_ATTEMPTS								8
+#define FORWARDING_RETRY_BASE_INTERVAL						5000		// Milliseconds before the first retry.  Doubled for each retry.
+#define FORWARDING_RETRY_MAX_INTERVAL						600000		// Ten minutes.
+#define FORWARDING_ASSOCIATION_IDLE_TIMEOUT					20000		// Release an idle association after 20 seconds.
+#define MAX_FORWARDING_SEND_PDU_LENGTH						0x00040000	// 256K, used if the destination specifies no maximum.
+#define MIN_FORWARDING_SEND_PDU_LENGTH						0x00001000	// 4K, the smallest maximum PDU length accepted from a destination.
+#define FORWARDING_QUEUE_ACCESS_TIMEOUT						3000		// Milliseconds.
+
+
+typedef struct
+	{
+	char				ImageFileSpec[ MAX_FILE_SPEC_LENGTH ];	// The copy of the Dicom image file waiting to be sent.
+	char				SOPClassUID[ 68 ];
+	char				SOPInstanceUID[ 68 ];
+	char				TransferSyntaxUID[ 68 ];
+	unsigned long		DataSetOffset;				// File position following the file meta information.
+	unsigned long		DataSetSize;
+	unsigned long		nAttempts;
+	ULONGLONG			NextAttemptTime;			// System tick count (milliseconds) before which no retry is made.
+	unsigned short		MessageID;					// Nonzero while a C-Store request is awaiting its response.
+	} FORWARDED_IMAGE;
+
+
+typedef struct
+	{
+	unsigned char		PresentationContextID;
+	char				SOPClassUID[ 68 ];
+	char				TransferSyntaxUID[ 68 ];
+	BOOL				bAccepted;
+	} FORWARDING_PRESENTATION_CONTEXT;
 
 
 
@@ -43,3 +97,7 @@ void				CloseDicomInitiatorModule();
 
 BOOL				PrepareAssociationReleaseRequestBuffer( DICOM_ASSOCIATION *pAssociation );
 BOOL				ParseAssociationReleaseReplyBuffer( DICOM_ASSOCIATION *pAssociation );
+
+void				SetForwardingIntervals( ULONGLONG NewRetryBaseInterval, ULONGLONG NewRetryMaxInterval, ULONGLONG NewAssociationIdleTimeout );
+BOOL				QueueImageForForwarding( char *pQueuedDicomFileSpec, char *pPNGImageFileName );
+unsigned __stdcall	SendImagesThreadFunction( void *pOperationStruct );
@@ -27,6 +27,14 @@
 //	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 //	THE SOFTWARE.
 //
+//	*[5] 10/19/2026 by agent
+//		Record the time taken to read and parse the Dicom header of each queued image
+//		in the header parse latency histogram.
+//	*[4] 10/19/2026 by agent
+//		Shortened the pause after queuing each image file from the watch folder, since
+//		the Process Image operation is now woken as each image is queued.
+//	*[3] 10/19/2026 by agent
+//		Record the reception time of each queued image file, for latency logging.
 //	*[2] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //	*[1] 02/07/2024 by Tom Atwood
@@ -45,6 +53,7 @@
 #include "Exam.h"
 #include "ProductDispatcher.h"
 #include "ExamReformat.h"
+#include "ProcessingMetrics.h"	// *[5]
 
 extern TRANSFER_SERVICE				TransferService;
 extern CONFIGURATION				ServiceConfiguration;
@@ -562,6 +571,7 @@ BOOL QueueImage( PRODUCT_OPERATION *pProductOperation, char *pFileSpec, WIN32_FI
 	char					TextLine[ 1096 ];
 	int						ResultCode;
 	DICOM_HEADER_SUMMARY	*pDicomHeader;
+	LARGE_INTEGER			ParseStartTime;					// *[5]
 	char					*pFileName;
 	time_t					CurrentSystemTime;
 
@@ -594,6 +604,8 @@ BOOL QueueImage( PRODUCT_OPERATION *pProductOperation, char *pFileSpec, WIN32_FI
 			pFileName++;
 			pProductItem -> SourceFileName[ 0 ] = '\0';													// *[2] Eliminate call to strcpy.
 			strncat_s( pProductItem -> SourceFileName, MAX_FILE_SPEC_LENGTH, pFileName, _TRUNCATE );	// *[2] Replaced strncat with strncat_s.
+			if ( pFindFileInfo != 0 )
+				pProductItem -> ReceptionTime = pFindFileInfo -> ftLastWriteTime;						// *[3]
 
 			// Move the file out of the watch folder, into the queued files folder.  If an
 			// error occurs, the product source specification is unchanged.
@@ -616,7 +628,9 @@ BOOL QueueImage( PRODUCT_OPERATION *pProductOperation, char *pFileSpec, WIN32_FI
 			// generate the abstract information output for this image.  The Dicom file contents
 			// are retained in a series of memory buffers in the list, pDicomHeader -> ListOfInputBuffers.
 			// The copied image buffer is at pDicomHeader -> pImageData.
+			QueryPerformanceCounter( &ParseStartTime );													// *[5]
 			bNoError = ReadDicomHeaderInfo( pProductItem -> SourceFileSpec, pExamInfo, &pDicomHeader, TRUE );
+			RecordProcessingStageTime( STAGE_HEADER_PARSE, &ParseStartTime );							// *[5]
 //			if ( ServiceConfiguration.bEnableSurvey )
 //				{
 //				CopyImageFileToSortTreeDirectory( pDicomHeader, pProductItem -> SourceFileSpec, pDicomHeader -> Manufacturer, pDicomHeader -> Modality );
@@ -720,7 +734,7 @@ BOOL QueueImage( PRODUCT_OPERATION *pProductOperation, char *pFileSpec, WIN32_FI
 	if ( ( BRetrieverStatus & BRETRIEVER_STATUS_PROCESSING ) == 0 )
 		UpdateBRetrieverStatus( BRETRIEVER_STATUS_ACTIVE );
 
-	Sleep( 3000 );		// Allow other programs to run.
+	Sleep( 100 );		// Allow other programs to run.  *[4] Reduced from 3 seconds.
 
 	return bNoError;
 }
@@ -30,11 +30,21 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		The edit specification file is compiled once, and only read again when it
+//		changes.  The edited values are encoded in advance, and the edits for existing
+//		Dicom elements are indexed by tag.
+//	*[2] 10/19/2026 by agent
+//		EnscribeImageOverlay() now decides the photometric inversion once per image
+//		instead of once per pixel, copies uninverted 8-bit overlay rows as a block, and
+//		clips the overlay to the Dicom image boundaries.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
 //
 #include "Module.h"
+#include <sys/types.h>
+#include <sys/stat.h>
 #include "ReportStatus.h"
 #include "ServiceMain.h"
 #include "Dicom.h"
@@ -44,7 +54,24 @@
 #include "ExamEdit.h"
 
 
-LIST_HEAD							ExamEditSpecificationList = 0;
+LIST_HEAD							ExamEditSpecificationList = 0;		// *[3] Now holds the compiled edit specifications.
+
+// *[3] The index of the edits to be applied to existing Dicom elements, ordered by tag.
+typedef struct
+	{
+	unsigned long			TagKey;					// The group number in the upper 16 bits, the element number in the lower.
+	long					nEditSpecification;		// The position of the edit in the specification file.
+	EDIT_SPECIFICATION		*pEditSpecification;
+	} ELEMENT_EDIT_INDEX_ENTRY;
+
+static ELEMENT_EDIT_INDEX_ENTRY		*pElementEditIndex = 0;
+static long							nElementEditIndexEntries = 0;
+static BOOL							bExamEditsCompiled = FALSE;
+static char							CompiledExamEditFileSpec[ MAX_FILE_SPEC_LENGTH ] = "";
+static __time64_t					ExamEditFileModificationTime = 0;
+static __int64						ExamEditFileSize = 0;
+
+static void							DeleteCompiledExamEditSpecifications();
 
 //___________________________________________________________________________
 //
@@ -87,6 +114,7 @@ void InitExamEditModule()
 
 void CloseExamEditModule()
 {
+	DeleteCompiledExamEditSpecifications();		// *[3]
 }
 
 
@@ -297,6 +325,193 @@ void DeallocateEditSpecifications( LIST_HEAD *pEditSpecificationList )
 }
 
 
+// *[3] Release the compiled edit specifications and their index.
+static void DeleteCompiledExamEditSpecifications()
+{
+	DeallocateEditSpecifications( &ExamEditSpecificationList );
+	if ( pElementEditIndex != 0 )
+		free( pElementEditIndex );
+	pElementEditIndex = 0;
+	nElementEditIndexEntries = 0;
+	bExamEditsCompiled = FALSE;
+}
+
+
+// *[3] Order the element edit index by tag and, for duplicate tags, by the order of the edits in the file.
+static int CompareElementEditIndexEntries( const void *pIndexEntry1, const void *pIndexEntry2 )
+{
+	ELEMENT_EDIT_INDEX_ENTRY	*pEntry1;
+	ELEMENT_EDIT_INDEX_ENTRY	*pEntry2;
+	int							ComparisonResult;
+
+	pEntry1 = (ELEMENT_EDIT_INDEX_ENTRY*)pIndexEntry1;
+	pEntry2 = (ELEMENT_EDIT_INDEX_ENTRY*)pIndexEntry2;
+	if ( pEntry1 -> TagKey != pEntry2 -> TagKey )
+		ComparisonResult = ( pEntry1 -> TagKey < pEntry2 -> TagKey ) ? -1 : 1;
+	else if ( pEntry1 -> nEditSpecification != pEntry2 -> nEditSpecification )
+		ComparisonResult = ( pEntry1 -> nEditSpecification < pEntry2 -> nEditSpecification ) ? -1 : 1;
+	else
+		ComparisonResult = 0;
+
+	return ComparisonResult;
+}
+
+
+// *[3] Encode the edited value in each of the forms in which it is written into a Dicom element,
+// so that this doesn't have to be repeated for every image.
+static void EncodeEditedFieldValue( EDIT_SPECIFICATION *pEditSpecification )
+{
+	strncpy_s( pEditSpecification -> EncodedFieldValue, MAX_FILE_SPEC_LENGTH, pEditSpecification -> EditedFieldValue, _TRUNCATE );
+	if ( ( strlen( pEditSpecification -> EncodedFieldValue ) & 1 ) != 0 )
+		strncat_s( pEditSpecification -> EncodedFieldValue, MAX_FILE_SPEC_LENGTH, " ", _TRUNCATE );
+	strncpy_s( pEditSpecification -> PersonNameFieldValue, MAX_FILE_SPEC_LENGTH, pEditSpecification -> EditedFieldValue, _TRUNCATE );
+	strncat_s( pEditSpecification -> PersonNameFieldValue, MAX_FILE_SPEC_LENGTH, " ", _TRUNCATE );
+	pEditSpecification -> NumericFieldValue = atol( pEditSpecification -> EditedFieldValue );
+}
+
+
+// *[3] Encode the values of the edit specifications that have been read, and index the edits that
+// apply to existing elements by tag.  Only the first such edit for each tag is indexed, since it is
+// the only one that would be applied.
+static BOOL CompileExamEditSpecifications()
+{
+	BOOL						bNoError = TRUE;
+	LIST_ELEMENT				*pEditSpecificationListElement;
+	EDIT_SPECIFICATION			*pEditSpecification;
+	long						nEditSpecifications;
+	long						nEditSpecification;
+	long						nIndexEntry;
+	long						nRetainedIndexEntries;
+
+	nEditSpecifications = 0;
+	pEditSpecificationListElement = ExamEditSpecificationList;
+	while ( pEditSpecificationListElement != 0 )
+		{
+		nEditSpecifications++;
+		pEditSpecificationListElement = pEditSpecificationListElement -> pNextListElement;
+		}
+	if ( nEditSpecifications > 0 )
+		{
+		pElementEditIndex = (ELEMENT_EDIT_INDEX_ENTRY*)malloc( nEditSpecifications * sizeof(ELEMENT_EDIT_INDEX_ENTRY) );
+		bNoError = ( pElementEditIndex != 0 );
+		if ( !bNoError )
+			RespondToError( MODULE_EDIT_EXAM, EDIT_EXAM_ERROR_INSUFFICIENT_MEMORY );
+		}
+	if ( bNoError )
+		{
+		nEditSpecification = 0;
+		pEditSpecificationListElement = ExamEditSpecificationList;
+		while ( pEditSpecificationListElement != 0 )
+			{
+			pEditSpecification = (EDIT_SPECIFICATION*)pEditSpecificationListElement -> pItem;
+			if ( pEditSpecification != 0 )
+				{
+				EncodeEditedFieldValue( pEditSpecification );
+				if ( pEditSpecification -> EditOperation != EDIT_ADD_ELEMENT && pEditSpecification -> EditOperation != EDIT_DELETE_ELEMENT )
+					{
+					pElementEditIndex[ nElementEditIndexEntries ].TagKey = ( (unsigned long)pEditSpecification -> DicomFieldIdentifier.Group << 16 ) |
+																					pEditSpecification -> DicomFieldIdentifier.Element;
+					pElementEditIndex[ nElementEditIndexEntries ].nEditSpecification = nEditSpecification;
+					pElementEditIndex[ nElementEditIndexEntries ].pEditSpecification = pEditSpecification;
+					nElementEditIndexEntries++;
+					}
+				}
+			nEditSpecification++;
+			pEditSpecificationListElement = pEditSpecificationListElement -> pNextListElement;
+			}
+		qsort( pElementEditIndex, nElementEditIndexEntries, sizeof(ELEMENT_EDIT_INDEX_ENTRY), CompareElementEditIndexEntries );
+		// Drop the later edits for each tag.
+		nRetainedIndexEntries = 0;
+		for ( nIndexEntry = 0; nIndexEntry < nElementEditIndexEntries; nIndexEntry++ )
+			if ( nRetainedIndexEntries == 0 || pElementEditIndex[ nIndexEntry ].TagKey != pElementEditIndex[ nRetainedIndexEntries - 1 ].TagKey )
+				pElementEditIndex[ nRetainedIndexEntries++ ] = pElementEditIndex[ nIndexEntry ];
+		nElementEditIndexEntries = nRetainedIndexEntries;
+		}
+
+	return bNoError;
+}
+
+
+// *[3] Provide the list of edit specifications to be applied to the next Dicom output file.  The
+// edit specification file is only read and compiled again if it has been changed, or if the
+// configuration directory now names a different file.  The list belongs
+// to this module, and must not be deallocated by the caller.
+BOOL GetCompiledExamEditSpecifications( LIST_HEAD *pEditSpecificationList )
+{
+	BOOL						bNoError = TRUE;
+	char						EditFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	struct __stat64				FileStatisticsBuffer;
+	LIST_ELEMENT				*pEditSpecificationListElement;
+	EDIT_SPECIFICATION			*pEditSpecification;
+
+	EditFileSpec[ 0 ] = '\0';
+	strncat_s( EditFileSpec, MAX_FILE_SPEC_LENGTH, TransferService.ConfigDirectory, _TRUNCATE );
+	if ( strlen( EditFileSpec ) > 0 && EditFileSpec[ strlen( EditFileSpec ) - 1 ] != '\\' )
+		strncat_s( EditFileSpec, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );
+	strncat_s( EditFileSpec, MAX_FILE_SPEC_LENGTH, "DicomEdits.cfg", _TRUNCATE );
+	if ( _stat64( EditFileSpec, &FileStatisticsBuffer ) != 0 )
+		{
+		// If there is no file, there are no edits.  Check again for the next image.
+		FileStatisticsBuffer.st_mtime = 0;
+		FileStatisticsBuffer.st_size = 0;
+		}
+	if ( !bExamEditsCompiled || strcmp( EditFileSpec, CompiledExamEditFileSpec ) != 0 ||
+				FileStatisticsBuffer.st_mtime != ExamEditFileModificationTime || FileStatisticsBuffer.st_size != ExamEditFileSize )
+		{
+		DeleteCompiledExamEditSpecifications();
+		bNoError = ReadExamEditSpecificationFile( &ExamEditSpecificationList );
+		// If the file could not be read completely, apply the edits that were read, but read it again next time.
+		if ( CompileExamEditSpecifications() && bNoError )
+			{
+			bExamEditsCompiled = TRUE;
+			strncpy_s( CompiledExamEditFileSpec, MAX_FILE_SPEC_LENGTH, EditFileSpec, _TRUNCATE );
+			ExamEditFileModificationTime = FileStatisticsBuffer.st_mtime;
+			ExamEditFileSize = FileStatisticsBuffer.st_size;
+			}
+		}
+	// Prepare the edits to be applied to a new image.
+	pEditSpecificationListElement = ExamEditSpecificationList;
+	while ( pEditSpecificationListElement != 0 )
+		{
+		pEditSpecification = (EDIT_SPECIFICATION*)pEditSpecificationListElement -> pItem;
+		if ( pEditSpecification != 0 )
+			pEditSpecification -> bEditCompleted = FALSE;
+		pEditSpecificationListElement = pEditSpecificationListElement -> pNextListElement;
+		}
+	*pEditSpecificationList = ExamEditSpecificationList;
+
+	return bNoError;
+}
+
+
+// *[3] Locate the edit, if any, to be applied to an existing Dicom element with the specified tag.
+EDIT_SPECIFICATION *LookUpElementEditSpecification( TAG DicomElementTag )
+{
+	EDIT_SPECIFICATION			*pEditSpecification;
+	unsigned long				TagKey;
+	long						nLowerEntry;
+	long						nUpperEntry;
+	long						nMiddleEntry;
+
+	pEditSpecification = 0;
+	TagKey = ( (unsigned long)DicomElementTag.Group << 16 ) | DicomElementTag.Element;
+	nLowerEntry = 0;
+	nUpperEntry = nElementEditIndexEntries - 1;
+	while ( pEditSpecification == 0 && nLowerEntry <= nUpperEntry )
+		{
+		nMiddleEntry = ( nLowerEntry + nUpperEntry ) / 2;
+		if ( pElementEditIndex[ nMiddleEntry ].TagKey < TagKey )
+			nLowerEntry = nMiddleEntry + 1;
+		else if ( pElementEditIndex[ nMiddleEntry ].TagKey > TagKey )
+			nUpperEntry = nMiddleEntry - 1;
+		else
+			pEditSpecification = pElementEditIndex[ nMiddleEntry ].pEditSpecification;
+		}
+
+	return pEditSpecification;
+}
+
+
 BOOL ReadRawImageFile( DICOM_HEADER_SUMMARY *pDicomHeader, char *pFileSpec )
 {
 	BOOL					bNoError = TRUE;
@@ -410,9 +625,10 @@ BOOL EnscribeImageOverlay( DICOM_HEADER_SUMMARY *pDicomHeader, char *pDecompress
 	long					nOverlayImagePixelsPerRow;
 	long					nOverlayImageBytesPerRow;
 	long					nOverlayImageRows;
+	long					nOverlayPixelsToCopy;											// *[2]
+	BOOL					bInvertOverlay;													// *[2]
 	char					*pInputReadPoint;
 	char					*pOutputWritePoint;
-	long					nOverlayRow;
 	char					InputPixelValue;
 	long					nOutputRow;
 	unsigned short			OutputPixelValue;
@@ -429,12 +645,19 @@ BOOL EnscribeImageOverlay( DICOM_HEADER_SUMMARY *pDicomHeader, char *pDecompress
 		else if ( nImageBitsAllocatedPerPixel > 8 )
 			nDicomImageBytesPerPixel = 2;
 		nDicomImageBytesPerRow = nDicomImagePixelsPerRow * nDicomImageBytesPerPixel;
-		nDicomImageRows = (long)pDicomHeader -> ImageRows;
+		nDicomImageRows = (long)( *pDicomHeader -> ImageRows );											// *[2] Dereference the row count.
 		// Load Overlay image parameters.
 		nOverlayImagePixelsPerRow = ImageWidthInPixels;
 		nOverlayImageBytesPerRow = ImageWidthInPixels * BytesPerPixel;
 		nOverlayImageRows = ImageHeightInPixels;
 		nImageRowsRemaining = nOverlayImageRows;
+		// *[2] Don't write past the right edge of the Dicom image.
+		nOverlayPixelsToCopy = nOverlayImagePixelsPerRow;
+		if ( nOverlayPixelsToCopy > nDicomImagePixelsPerRow - (long)nOverlayImageX0 )
+			nOverlayPixelsToCopy = nDicomImagePixelsPerRow - (long)nOverlayImageX0;
+		// *[2] The photometric interpretation is the same for every pixel, so only test it once.
+		bInvertOverlay = ( pDicomHeader -> PhotometricInterpretation != 0 &&
+								_stricmp( pDicomHeader -> PhotometricInterpretation, "MONOCHROME1" ) == 0 );
 
 		pInputReadPoint = pDecompressedImageData + ( nOverlayImageRows - 1 ) * nOverlayImageBytesPerRow;
 		nOutputRow = nOverlayImageY0;
@@ -442,29 +665,31 @@ BOOL EnscribeImageOverlay( DICOM_HEADER_SUMMARY *pDicomHeader, char *pDecompress
 		if ( nImageRowsRemaining > nDicomImageRows - nOutputRow )
 			nImageRowsRemaining = nDicomImageRows - nOutputRow;
 		pOutputWritePoint = pDicomImageData + ( nOutputRow * nDicomImageBytesPerRow ) + ( nOverlayImageX0 * nDicomImageBytesPerPixel );
-		while ( bNoError && nImageRowsRemaining > 0L )
+		while ( bNoError && nImageRowsRemaining > 0L && nOverlayPixelsToCopy > 0L )							// *[2]
 			{
-			for ( nOverlayRow = 0; nOverlayRow < nOverlayImageRows; nOverlayRow++ )
+			// Process the row in the output buffer.
+			if ( nDicomImageBytesPerPixel == 1 && !bInvertOverlay )
+				memcpy( pOutputWritePoint, pInputReadPoint, nOverlayPixelsToCopy );
+			else if ( nDicomImageBytesPerPixel == 1 )
 				{
-				// Process the row in the output buffer.
-				for ( nPixel = 0; nPixel < nOverlayImagePixelsPerRow; nPixel++ )
+				for ( nPixel = 0; nPixel < nOverlayPixelsToCopy; nPixel++ )
+					pOutputWritePoint[ nPixel ] = ~pInputReadPoint[ nPixel ];
+				}
+			else
+				{
+				for ( nPixel = 0; nPixel < nOverlayPixelsToCopy; nPixel++ )
 					{
 					InputPixelValue = pInputReadPoint[ nPixel ];
-					if ( _stricmp( pDicomHeader -> PhotometricInterpretation, "MONOCHROME1" ) == 0 )
+					if ( bInvertOverlay )
 						InputPixelValue = ~InputPixelValue;
 					// Copy the overlay value to the Dicom image.
-					if ( nDicomImageBytesPerPixel == 2 )
-						{
-						OutputPixelValue = (unsigned short)InputPixelValue;
-						( (unsigned short*)pOutputWritePoint )[ nPixel ] = OutputPixelValue;
-						}
-					else
-						pOutputWritePoint[ nPixel ] = InputPixelValue;
-				}
-				pInputReadPoint -= nOverlayImageBytesPerRow;
-				pOutputWritePoint += nDicomImageBytesPerRow;
-				nImageRowsRemaining--;
+					OutputPixelValue = (unsigned short)InputPixelValue;
+					( (unsigned short*)pOutputWritePoint )[ nPixel ] = OutputPixelValue;
+					}
 				}
+			pInputReadPoint -= nOverlayImageBytesPerRow;
+			pOutputWritePoint += nDicomImageBytesPerRow;
+			nImageRowsRemaining--;
 			}			// ... end while more image data remains to be written.
 		}
 
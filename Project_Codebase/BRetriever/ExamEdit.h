@@ -52,6 +52,10 @@ typedef struct
 						#define EDIT_REPLACE_IMAGE		5
 						#define EDIT_CROP_IMAGE			6
 	BOOL			bEditCompleted;
+	// The following are encoded from EditedFieldValue when the edit specification file is compiled.
+	char			EncodedFieldValue[ MAX_FILE_SPEC_LENGTH ];		// Padded to an even length.
+	char			PersonNameFieldValue[ MAX_FILE_SPEC_LENGTH ];	// Padded for a person name.
+	long			NumericFieldValue;
 	} EDIT_SPECIFICATION;
 
 
@@ -61,6 +65,8 @@ void					InitExamEditModule();
 void					CloseExamEditModule();
 
 BOOL					ReadExamEditSpecificationFile( LIST_HEAD *pEditSpecificationList );
+BOOL					GetCompiledExamEditSpecifications( LIST_HEAD *pEditSpecificationList );
+EDIT_SPECIFICATION		*LookUpElementEditSpecification( TAG DicomElementTag );
 FILE_STATUS				ReadExamEditItem( FILE *pEditSpecificationFile, char *TextLine, long nMaxBytes );
 BOOL					ReadRawImageFile( DICOM_HEADER_SUMMARY *pDicomHeader, char *pFileSpec );
 BOOL					ParseExamEditItem( char EditSpecificationLine[], EDIT_SPECIFICATION *pEditSpecification );
@@ -30,11 +30,24 @@
 //
 // UPDATE HISTORY:
 //
+//	*[5] 10/19/2026 by agent
+//		If the lossless JPEG decoder fails, discard its output and convert the image with
+//		the 12- or 16-bit JPEG library, as before.
+//	*[4] 10/19/2026 by agent
+//		Accumulate the image pixel statistics while the PNG rows are written, and record
+//		them for BViewer in a private PNG chunk following the image data.
+//	*[3] 10/19/2026 by agent
+//		Decode reversible JPEG 2000 images with the decoder in ReformatJpeg2000.cpp.  Only
+//		the images using unsupported JPEG 2000 coding options are still rejected.
+//	*[2] 10/19/2026 by agent
+//		Decode the common lossless JPEG images (first order prediction) with the dedicated
+//		decoder in ReformatJpegLossless.cpp instead of the 12- and 16-bit JPEG libraries.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
 //
 #include "Module.h"
+#include <io.h>							// *[5]
 #include "ReportStatus.h"
 #include "ServiceMain.h"
 #include "Dicom.h"
@@ -44,6 +57,16 @@
 #include "ExamReformat.h"
 #include "Exam.h"
 
+#pragma pack(push)
+#pragma pack(8)		// Pack structure members on 8-byte boundaries for faster access.
+
+extern "C"
+{
+#include "png.h"		// *[4]
+}
+
+#pragma pack(pop)
+
 
 extern TRANSFER_SERVICE				TransferService;
 
@@ -60,7 +83,7 @@ static ERROR_DICTIONARY_ENTRY	ExamReformatErrorCodes[] =
 			{
 				{ REFORMAT_ERROR_INSUFFICIENT_MEMORY		, "An error occurred allocating a memory block for data storage."					},
 				{ REFORMAT_ERROR_EXTRACTION					, "An error occurred while extracting the image from the Dicom file."				},
-				{ REFORMAT_ERROR_JPEG_2000					, "A JPEG-2000 image was received.  JPEG-2000 is not currently supported."			},
+				{ REFORMAT_ERROR_JPEG_2000					, "A JPEG-2000 image was received that uses unsupported coding options."			},		// *[3]
 				{ REFORMAT_ERROR_JPEG_CORRUPTION			, "A potentially corrupt JPEG image was received.  An error occurred decoding it."	},
 				{ REFORMAT_ERROR_IMAGE_CONVERT_SEEK			, "The pixel data for the image to be converted could not be located." },
 				{ REFORMAT_ERROR_PNG_WRITE					, "An error occurred writing image data to the Dicom file." },
@@ -122,7 +145,7 @@ void NotifyUserOfImageExtractionError( unsigned long ErrorCode, PRODUCT_QUEUE_IT
 			break;
 		case REFORMAT_ERROR_JPEG_2000:
 			strncat_s( UserNoticeDescriptor.NoticeText,
-						MAX_FILE_SPEC_LENGTH, "JPEG-2000 image decoding is not\ncurrently supported.", _TRUNCATE );		// *[1] Replaced strcat with strncat_s. );
+						MAX_FILE_SPEC_LENGTH, "This JPEG-2000 image uses coding\noptions that are not supported.", _TRUNCATE );	// *[3]
 			strncpy_s( UserNoticeDescriptor.SuggestedActionText,
 						MAX_CFG_STRING_LENGTH, "Ask the source to send it uncompressed.", _TRUNCATE );					// *[1] Replaced strcpy with strncpy_s.
 			break;
@@ -160,7 +183,8 @@ BOOL PerformLocalFileReformat( PRODUCT_QUEUE_ITEM *pProductItem, PRODUCT_OPERATI
 	if ( pDicomHeader != 0 )
 		{
 		pTransferSyntaxUID = pDicomHeader -> TransferSyntaxUniqueIdentifier;
-		if ( strcmp( pTransferSyntaxUID, "1.2.840.10008.1.2.4.90" ) == 0 )
+		if ( ( strcmp( pTransferSyntaxUID, "1.2.840.10008.1.2.4.90" ) == 0 || strcmp( pTransferSyntaxUID, "1.2.840.10008.1.2.4.91" ) == 0 ) &&
+					!Jpeg2000ImageCanBeDecoded( pDicomHeader ) )													// *[3]
 			{
 			bNoError = FALSE;
 			pProductItem -> ModuleWhereErrorOccurred = MODULE_REFORMAT;
@@ -191,6 +215,142 @@ BOOL PerformLocalFileReformat( PRODUCT_QUEUE_ITEM *pProductItem, PRODUCT_OPERATI
 
 static BOOL			bAppendCalibrationData = TRUE;
 
+
+// *[4] The pixel statistics for the image being converted are accumulated here, one
+// row at a time, as libpng writes the rows to the PNG file.
+typedef struct
+	{
+	BOOL					bStatisticsAreValid;
+	BOOL					bPixelBytesAreSwapped;		// 16-bit rows are supplied in the little-endian byte order.
+	unsigned long			nPixelsCounted;
+	unsigned short			MinPixelValue;
+	unsigned short			MaxPixelValue;
+	unsigned short			PixelBitsSet;
+	unsigned __int64		PixelValueSum;
+	} PIXEL_STATISTICS_ACCUMULATOR;
+
+static PIXEL_STATISTICS_ACCUMULATOR		PixelStatisticsAccumulator;
+
+
+// *[4] This function is called by libpng for each image row, before the row is byte swapped
+// and compressed.  The row pixel data are preceded by the PNG filter byte, so the 16-bit
+// values are not necessarily aligned and are assembled from their bytes.  The loops are kept
+// simple so that the compiler can vectorize them.  Only grayscale images are summarized.
+static void PNGAPI AccumulateImagePixelStatistics( png_structp pPngConfig, png_row_infop pRowInfo, png_bytep pRowData )
+{
+	PIXEL_STATISTICS_ACCUMULATOR	*pAccumulator;
+	unsigned long					nPixel;
+	unsigned long					nPixelsInRow;
+	unsigned short					PixelValue;
+	unsigned short					RowMinPixelValue;
+	unsigned short					RowMaxPixelValue;
+	unsigned short					RowPixelBitsSet;
+	unsigned __int64				RowPixelValueSum;
+	unsigned char					*pPixelBytes;
+
+	pAccumulator = (PIXEL_STATISTICS_ACCUMULATOR*)png_get_user_transform_ptr( pPngConfig );
+	if ( pAccumulator != 0 && pAccumulator -> bStatisticsAreValid )
+		{
+		if ( pRowInfo -> channels != 1 || ( pRowInfo -> bit_depth != 8 && pRowInfo -> bit_depth != 16 ) )
+			pAccumulator -> bStatisticsAreValid = FALSE;
+		else
+			{
+			nPixelsInRow = (unsigned long)pRowInfo -> width;
+			pPixelBytes = (unsigned char*)pRowData;
+			RowMinPixelValue = 0xffff;
+			RowMaxPixelValue = 0;
+			RowPixelBitsSet = 0;
+			RowPixelValueSum = 0;
+			if ( pRowInfo -> bit_depth == 8 )
+				{
+				for ( nPixel = 0; nPixel < nPixelsInRow; nPixel++ )
+					{
+					PixelValue = (unsigned short)pPixelBytes[ nPixel ];
+					if ( PixelValue < RowMinPixelValue )
+						RowMinPixelValue = PixelValue;
+					if ( PixelValue > RowMaxPixelValue )
+						RowMaxPixelValue = PixelValue;
+					RowPixelBitsSet |= PixelValue;
+					RowPixelValueSum += PixelValue;
+					}
+				}
+			else if ( pAccumulator -> bPixelBytesAreSwapped )
+				{
+				for ( nPixel = 0; nPixel < nPixelsInRow; nPixel++ )
+					{
+					PixelValue = (unsigned short)( pPixelBytes[ 2 * nPixel ] | ( pPixelBytes[ 2 * nPixel + 1 ] << 8 ) );
+					if ( PixelValue < RowMinPixelValue )
+						RowMinPixelValue = PixelValue;
+					if ( PixelValue > RowMaxPixelValue )
+						RowMaxPixelValue = PixelValue;
+					RowPixelBitsSet |= PixelValue;
+					RowPixelValueSum += PixelValue;
+					}
+				}
+			else
+				{
+				for ( nPixel = 0; nPixel < nPixelsInRow; nPixel++ )
+					{
+					PixelValue = (unsigned short)( ( pPixelBytes[ 2 * nPixel ] << 8 ) | pPixelBytes[ 2 * nPixel + 1 ] );
+					if ( PixelValue < RowMinPixelValue )
+						RowMinPixelValue = PixelValue;
+					if ( PixelValue > RowMaxPixelValue )
+						RowMaxPixelValue = PixelValue;
+					RowPixelBitsSet |= PixelValue;
+					RowPixelValueSum += PixelValue;
+					}
+				}
+			if ( RowMinPixelValue < pAccumulator -> MinPixelValue )
+				pAccumulator -> MinPixelValue = RowMinPixelValue;
+			if ( RowMaxPixelValue > pAccumulator -> MaxPixelValue )
+				pAccumulator -> MaxPixelValue = RowMaxPixelValue;
+			pAccumulator -> PixelBitsSet |= RowPixelBitsSet;
+			pAccumulator -> PixelValueSum += RowPixelValueSum;
+			pAccumulator -> nPixelsCounted += nPixelsInRow;
+			}
+		}
+}
+
+
+// *[4] The image converters call this function after setting up the PNG output, to have
+// the pixel statistics accumulated as the image rows are written.
+void CollectImagePixelStatistics( void *pPngWriteStructure, BOOL bPixelBytesAreSwapped )
+{
+	memset( &PixelStatisticsAccumulator, 0, sizeof(PIXEL_STATISTICS_ACCUMULATOR) );
+	PixelStatisticsAccumulator.bStatisticsAreValid = TRUE;
+	PixelStatisticsAccumulator.MinPixelValue = 0xffff;
+	PixelStatisticsAccumulator.bPixelBytesAreSwapped = bPixelBytesAreSwapped;
+	png_set_user_transform_info( (png_structp)pPngWriteStructure, &PixelStatisticsAccumulator, 0, 0 );
+	png_set_write_user_transform_fn( (png_structp)pPngWriteStructure, AccumulateImagePixelStatistics );
+}
+
+
+// *[4] The image converters call this function after the image rows have been written and
+// before png_write_end().  If the statistics cover the whole image, they are recorded in a
+// private ancillary chunk, which follows the image data and is skipped by other PNG readers.
+// Otherwise no chunk is written, and BViewer will examine the pixels itself.
+void WriteImagePixelStatisticsChunk( void *pPngWriteStructure )
+{
+	png_byte				ChunkData[ IMAGE_PIXEL_STATISTICS_CHUNK_LENGTH ];
+	unsigned __int64		PixelValueSum;
+
+	if ( PixelStatisticsAccumulator.bStatisticsAreValid && PixelStatisticsAccumulator.nPixelsCounted > 0 )
+		{
+		PixelValueSum = PixelStatisticsAccumulator.PixelValueSum;
+		png_save_uint_16( &ChunkData[ 0 ], IMAGE_PIXEL_STATISTICS_CHUNK_VERSION );
+		png_save_uint_16( &ChunkData[ 2 ], PixelStatisticsAccumulator.PixelBitsSet );
+		png_save_uint_32( &ChunkData[ 4 ], (png_uint_32)PixelStatisticsAccumulator.nPixelsCounted );
+		png_save_uint_16( &ChunkData[ 8 ], PixelStatisticsAccumulator.MinPixelValue );
+		png_save_uint_16( &ChunkData[ 10 ], PixelStatisticsAccumulator.MaxPixelValue );
+		png_save_uint_32( &ChunkData[ 12 ], (png_uint_32)( PixelValueSum >> 32 ) );
+		png_save_uint_32( &ChunkData[ 16 ], (png_uint_32)( PixelValueSum & 0xffffffff ) );
+		png_write_chunk( (png_structp)pPngWriteStructure, (png_bytep)IMAGE_PIXEL_STATISTICS_CHUNK_NAME,
+							ChunkData, IMAGE_PIXEL_STATISTICS_CHUNK_LENGTH );
+		}
+	PixelStatisticsAccumulator.bStatisticsAreValid = FALSE;
+}
+
+
 // Before calling this function, the Dicom Header structure must be loaded with the buffer address
 // of the beginning of the pixel data, which is the address of element (7fe0, 10).
 BOOL OutputPNGImage( char* pDestFileSpec, DICOM_HEADER_SUMMARY *pDicomHeader )
@@ -202,6 +362,8 @@ BOOL OutputPNGImage( char* pDestFileSpec, DICOM_HEADER_SUMMARY *pDicomHeader )
 	unsigned short			nImageBitDepth;
 	char					*IndentationString = "";
 	long					nBytesWritten;
+	long					PNGImageOffset;					// *[5]
+	BOOL					bUseJpegLibrary;				// *[5]
 
 	#define MAX_READ_BUFFER_SIZE		0x10000
 
@@ -274,6 +436,12 @@ BOOL OutputPNGImage( char* pDestFileSpec, DICOM_HEADER_SUMMARY *pDicomHeader )
 				LogMessage( "Converting uncompressed image.", MESSAGE_TYPE_SUPPLEMENTARY );
 				bNoError = ConvertUncompressedImageToPNGFile( pDicomHeader, pOutputImageFile, bAppendCalibrationData );
 				}
+			else if ( pDicomHeader -> FileDecodingPlan.nTransferSyntaxIndex == JPEG2000_LOSSLESS_ONLY_TRANSFER_SYNTAX ||
+						pDicomHeader -> FileDecodingPlan.nTransferSyntaxIndex == JPEG2000_TRANSFER_SYNTAX )		// *[3]
+				{
+				LogMessage( "Decoding JPEG 2000 image.", MESSAGE_TYPE_SUPPLEMENTARY );
+				bNoError = ConvertJpeg2000ImageToPNGFile( pDicomHeader, pOutputImageFile, bAppendCalibrationData );
+				}
 			else
 				{
 				LogMessage( "Converting default JPEG image.", MESSAGE_TYPE_SUPPLEMENTARY );
@@ -282,10 +450,38 @@ BOOL OutputPNGImage( char* pDestFileSpec, DICOM_HEADER_SUMMARY *pDicomHeader )
 					{
 					if ( nImageBitDepth <= 8 )
 						bNoError = Convert8BitJpegImageToPNGFile( pDicomHeader, pOutputImageFile );
-					else if ( nImageBitDepth <= 12 )
-						bNoError = Convert12BitJpegImageToPNGFile( pDicomHeader, pOutputImageFile );
-					else if ( nImageBitDepth <= 16 )
-						bNoError = Convert16BitJpegImageToPNGFile( pDicomHeader, pOutputImageFile );
+					else
+						{
+						bUseJpegLibrary = TRUE;
+						if ( LosslessJpegImageCanBeDecoded( pDicomHeader ) )									// *[2]
+							{
+							LogMessage( "Decoding lossless JPEG image.", MESSAGE_TYPE_SUPPLEMENTARY );
+							// *[5] Note where the PNG image begins, so a failed attempt can be discarded.
+							PNGImageOffset = ftell( pOutputImageFile );
+							bNoError = ConvertLosslessJpegImageToPNGFile( pDicomHeader, pOutputImageFile );
+							if ( bNoError )
+								bUseJpegLibrary = FALSE;
+							else
+								{
+								// *[5] Fall back to the JPEG libraries, which decode a wider range of
+								// lossless images, after discarding anything written by the failed attempt.
+								LogMessage( "The lossless JPEG decoder failed.  Retrying with the JPEG library.", MESSAGE_TYPE_SUPPLEMENTARY );
+								if ( PNGImageOffset < 0 || fseek( pOutputImageFile, PNGImageOffset, SEEK_SET ) != 0 ||
+											_chsize_s( _fileno( pOutputImageFile ), PNGImageOffset ) != 0 )
+									{
+									RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_PNG_WRITE );
+									bUseJpegLibrary = FALSE;
+									}
+								}
+							}
+						if ( bUseJpegLibrary )
+							{
+							if ( nImageBitDepth <= 12 )
+								bNoError = Convert12BitJpegImageToPNGFile( pDicomHeader, pOutputImageFile );
+							else
+								bNoError = Convert16BitJpegImageToPNGFile( pDicomHeader, pOutputImageFile );
+							}
+						}
 					}
 				}
 			}
@@ -49,10 +49,16 @@ void					CloseExamReformatModule();
 
 BOOL					PerformLocalFileReformat( PRODUCT_QUEUE_ITEM *pProductItem, PRODUCT_OPERATION *pProductOperation );
 BOOL					OutputPNGImage( char* pDestFileSpec, DICOM_HEADER_SUMMARY *pDicomHeader );
+void					CollectImagePixelStatistics( void *pPngWriteStructure, BOOL bPixelBytesAreSwapped );
+void					WriteImagePixelStatisticsChunk( void *pPngWriteStructure );
 BOOL					ConvertUncompressedImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile, BOOL bIncludesCalibrationData );
 BOOL					Convert8BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile );
 BOOL					Convert12BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile );
 BOOL					Convert16BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile );
+BOOL					LosslessJpegImageCanBeDecoded( DICOM_HEADER_SUMMARY *pDicomHeader );
+BOOL					ConvertLosslessJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile );
+BOOL					Jpeg2000ImageCanBeDecoded( DICOM_HEADER_SUMMARY *pDicomHeader );
+BOOL					ConvertJpeg2000ImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile, BOOL bIncludesCalibrationData );
 BOOL					Decompress8BitJpegImage( char *pJpegSourceImageBuffer, unsigned long JpegSourceImageSizeInBytes,
 													unsigned long *pImageWidthInPixels, unsigned long *pImageHeightInPixels,
 													char **ppDecompressedImageData, unsigned long *pDecompressedImageSizeInBytes );
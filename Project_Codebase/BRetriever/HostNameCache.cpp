@@ -0,0 +1,225 @@
+// HostNameCache.cpp : Implements the cache of client host names used by the Dicom acceptor,
+//	and the threads that look them up.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include <process.h>
+#pragma pack(push, 8)		// Pack structure members on 8-byte boundaries.
+#include <winsock2.h>
+#pragma pack(pop)
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "WinSocketsAPI.h"
+#include "DicomAssoc.h"
+#include "DicomAcceptor.h"
+
+
+// The host names of connecting clients are looked up on separate threads, so that a slow DNS
+// server doesn't hold up the listening thread.  The cache is shared by the listening thread and
+// the lookup threads.  Each lookup thread's handle is kept in its cache entry, so that the
+// module can wait for the lookups still under way before Windows sockets are shut down.
+static HOST_NAME_CACHE_ENTRY	HostNameCache[ MAX_HOST_NAME_CACHE_ENTRIES ];
+static HANDLE					hHostNameCacheSemaphore = 0;
+static char						*pHostNameCacheSemaphoreName = "BRetrieverHostNameCacheSemaphore";
+static HOST_NAME_RESOLVER		ResolveHostAddress = GetWindowsHostByAddress;
+
+
+void InitHostNameCache()
+{
+	memset( (char*)HostNameCache, '\0', sizeof(HostNameCache) );
+	hHostNameCacheSemaphore = CreateSemaphore( NULL, 1L, 1L, pHostNameCacheSemaphoreName );
+}
+
+
+// The host name cache test substitutes a stand-in for a slow DNS server.
+void SetHostNameResolver( HOST_NAME_RESOLVER NewHostNameResolver )
+{
+	ResolveHostAddress = NewHostNameResolver;
+}
+
+
+// Wait for any host name lookups still under way, then release the cache.  If a lookup doesn't
+// finish in time, the semaphore is left open for its thread, since the service is ending anyway.
+void CloseHostNameCache()
+{
+	HANDLE					hPendingThreads[ MAX_HOST_NAME_CACHE_ENTRIES ];
+	DWORD					nPendingThreads;
+	BOOL					bLookupsFinished;
+	int						nEntry;
+
+	nPendingThreads = 0;
+	bLookupsFinished = TRUE;
+	if ( hHostNameCacheSemaphore != 0 &&
+				WaitForSingleObject( hHostNameCacheSemaphore, HOST_NAME_CACHE_ACCESS_TIMEOUT ) == WAIT_OBJECT_0 )
+		{
+		for ( nEntry = 0; nEntry < MAX_HOST_NAME_CACHE_ENTRIES; nEntry++ )
+			if ( HostNameCache[ nEntry ].bLookupPending && HostNameCache[ nEntry ].hLookupThread != 0 )
+				hPendingThreads[ nPendingThreads++ ] = HostNameCache[ nEntry ].hLookupThread;
+		ReleaseSemaphore( hHostNameCacheSemaphore, 1L, NULL );
+		}
+	if ( nPendingThreads > 0 )
+		{
+		LogMessage( "Wait for the client host name lookups to finish.", MESSAGE_TYPE_SUPPLEMENTARY );
+		bLookupsFinished = ( WaitForMultipleObjects( nPendingThreads, hPendingThreads, TRUE, HOST_NAME_LOOKUP_SHUTDOWN_TIMEOUT ) != WAIT_TIMEOUT );
+		}
+	if ( bLookupsFinished )
+		{
+		for ( nEntry = 0; nEntry < MAX_HOST_NAME_CACHE_ENTRIES; nEntry++ )
+			{
+			if ( HostNameCache[ nEntry ].hLookupThread != 0 )
+				CloseHandle( HostNameCache[ nEntry ].hLookupThread );
+			HostNameCache[ nEntry ].hLookupThread = 0;
+			}
+		if ( hHostNameCacheSemaphore != 0 )
+			CloseHandle( hHostNameCacheSemaphore );
+		hHostNameCacheSemaphore = 0;
+		}
+	else
+		LogMessage( "A client host name lookup did not finish.", MESSAGE_TYPE_SUPPLEMENTARY );
+}
+
+
+// Copy the cached host name for the specified client address into pHostName, if it is known.
+// Otherwise, if requested, start a lookup on a separate thread unless one is already under way.
+// The caller is not held up by the lookup.
+BOOL LookUpCachedHostName( unsigned long IPAddress, char *pHostName, BOOL bResolveIfMissing )
+{
+	BOOL					bHostNameIsKnown = FALSE;
+	HOST_NAME_CACHE_ENTRY	*pCacheEntry;
+	HOST_NAME_CACHE_ENTRY	*pReplaceableEntry;
+	ULONGLONG				CurrentTime;
+	int						nEntry;
+	HANDLE					hLookupThread;
+	unsigned int			LookupThreadID;
+
+	pCacheEntry = 0;
+	pReplaceableEntry = 0;
+	CurrentTime = GetTickCount64();
+	if ( WaitForSingleObject( hHostNameCacheSemaphore, HOST_NAME_CACHE_ACCESS_TIMEOUT ) != WAIT_OBJECT_0 )
+		RespondToError( MODULE_DICOMACCEPT, DICOMACCEPT_ERROR_HOST_NAME_CACHE_ACCESS );
+	else
+		{
+		for ( nEntry = 0; nEntry < MAX_HOST_NAME_CACHE_ENTRIES && pCacheEntry == 0; nEntry++ )
+			{
+			if ( HostNameCache[ nEntry ].IPAddress == IPAddress )
+				pCacheEntry = &HostNameCache[ nEntry ];
+			// If the address isn't cached, replace the entry that expires soonest.
+			else if ( !HostNameCache[ nEntry ].bLookupPending && ( pReplaceableEntry == 0 ||
+							HostNameCache[ nEntry ].ExpirationTime < pReplaceableEntry -> ExpirationTime ) )
+				pReplaceableEntry = &HostNameCache[ nEntry ];
+			}
+		if ( pCacheEntry != 0 && !pCacheEntry -> bLookupPending && pCacheEntry -> ExpirationTime > CurrentTime )
+			{
+			bHostNameIsKnown = ( strlen( pCacheEntry -> HostName ) > 0 );
+			if ( bHostNameIsKnown )
+				strncpy_s( pHostName, MAX_CFG_STRING_LENGTH, pCacheEntry -> HostName, _TRUNCATE );
+			}
+		else if ( bResolveIfMissing )
+			{
+			if ( pCacheEntry == 0 )
+				pCacheEntry = pReplaceableEntry;
+			if ( pCacheEntry != 0 && !pCacheEntry -> bLookupPending )
+				{
+				// The thread of the previous lookup for this entry has finished with the cache.
+				if ( pCacheEntry -> hLookupThread != 0 )
+					CloseHandle( pCacheEntry -> hLookupThread );
+				pCacheEntry -> hLookupThread = 0;
+				pCacheEntry -> IPAddress = IPAddress;
+				pCacheEntry -> HostName[ 0 ] = '\0';
+				// The thread is started while the cache is held, so that it is recorded before
+				// CloseHostNameCache() can look for it.
+				hLookupThread = (HANDLE)_beginthreadex(	NULL,						// No security issues for child processes.
+														0,							// Use same stack size as parent process.
+														ResolveHostNameThreadFunction,
+														(void*)(size_t)IPAddress,	// Argument for thread function.
+														0,							// Initialize thread state as running.
+														&LookupThreadID );
+				if ( hLookupThread != 0 )
+					{
+					pCacheEntry -> hLookupThread = hLookupThread;
+					pCacheEntry -> bLookupPending = TRUE;
+					}
+				else
+					{
+					RespondToError( MODULE_DICOMACCEPT, DICOMACCEPT_ERROR_START_OP_THREAD );
+					pCacheEntry -> ExpirationTime = CurrentTime + HOST_NAME_CACHE_FAILURE_LIFETIME;
+					}
+				}
+			}
+		ReleaseSemaphore( hHostNameCacheSemaphore, 1L, NULL );
+		}
+
+	return bHostNameIsKnown;
+}
+
+
+// Use DNS to look up the host name for a client address, and record the result in the host name cache.
+// A failed lookup is also recorded, so that it isn't repeated for every connection from the client.
+unsigned __stdcall ResolveHostNameThreadFunction( void *pIPAddress )
+{
+	BOOL					bNoError = TRUE;
+	unsigned long			IPAddress;
+	struct hostent			*pRemoteHostEntity = NULL;
+	char					HostName[ MAX_CFG_STRING_LENGTH ];
+	int						nEntry;
+	char					TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	IPAddress = (unsigned long)(size_t)pIPAddress;
+	HostName[ 0 ] = '\0';
+	bNoError = ResolveHostAddress( (char*)&IPAddress, 4, AF_INET, &pRemoteHostEntity );
+	if ( bNoError && pRemoteHostEntity != 0 && pRemoteHostEntity -> h_name != 0 )
+		strncpy_s( HostName, MAX_CFG_STRING_LENGTH, pRemoteHostEntity -> h_name, _TRUNCATE );
+	if ( strlen( HostName ) > 0 )
+		{
+		_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE, "  Client address %d.%d.%d.%d is host %s.",
+						IPAddress & 0xff, ( IPAddress >> 8 ) & 0xff, ( IPAddress >> 16 ) & 0xff, ( IPAddress >> 24 ) & 0xff, HostName );
+		LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+	// Record the result last.  Once the lookup is no longer pending, CloseHostNameCache() doesn't wait for this thread.
+	if ( WaitForSingleObject( hHostNameCacheSemaphore, HOST_NAME_CACHE_ACCESS_TIMEOUT ) != WAIT_OBJECT_0 )
+		RespondToError( MODULE_DICOMACCEPT, DICOMACCEPT_ERROR_HOST_NAME_CACHE_ACCESS );
+	else
+		{
+		for ( nEntry = 0; nEntry < MAX_HOST_NAME_CACHE_ENTRIES; nEntry++ )
+			if ( HostNameCache[ nEntry ].IPAddress == IPAddress && HostNameCache[ nEntry ].bLookupPending )
+				{
+				strncpy_s( HostNameCache[ nEntry ].HostName, MAX_CFG_STRING_LENGTH, HostName, _TRUNCATE );
+				HostNameCache[ nEntry ].bLookupPending = FALSE;
+				if ( strlen( HostName ) > 0 )
+					HostNameCache[ nEntry ].ExpirationTime = GetTickCount64() + HOST_NAME_CACHE_LIFETIME;
+				else
+					HostNameCache[ nEntry ].ExpirationTime = GetTickCount64() + HOST_NAME_CACHE_FAILURE_LIFETIME;
+				}
+		ReleaseSemaphore( hHostNameCacheSemaphore, 1L, NULL );
+		}
+
+	return 0;
+}
+
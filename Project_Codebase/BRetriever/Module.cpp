@@ -30,6 +30,8 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Added the Dicom archive module.
 //	*[1] 03/22/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -54,6 +56,7 @@
 #include "ExamReformat.h"
 #include "Calibration.h"
 #include "ExamEdit.h"
+#include "DicomArchive.h"		// *[2]
 
 
 MODULE_INFO				*pModuleInfoList = 0;
@@ -78,6 +81,7 @@ MODULE_INIT_FUNCTION	ModuleInitializationFunctions[] =
 								InitImageCalibrateModule,
 								InitExamReformatModule,
 								InitExamEditModule,
+								InitDicomArchiveModule,				// *[2]
 								0
 								};
 
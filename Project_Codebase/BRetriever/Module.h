@@ -29,6 +29,8 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Added the Dicom archive module.
 //	*[1] 03/11/2024 by Tom Atwood
 //		Convert windows headers byte packing to the Win32 default for compatibility
 //		with Visual Studio 2022.
@@ -97,6 +99,7 @@ typedef struct _Module_Info
 #define MODULE_CALIBRATE			17
 #define MODULE_EDIT_EXAM			18
 #define MODULE_MODULE				19
+#define MODULE_ARCHIVE				20		// *[2]
 
 
 typedef struct ListElement
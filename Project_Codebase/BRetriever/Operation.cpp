@@ -30,6 +30,9 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Added WakeOperationsOfType(), so that an operation can be signaled when work
+//		is queued for it, instead of waiting out its full cycle interval.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -300,6 +303,25 @@ void EnterOperationCycleWaitInterval( PRODUCT_OPERATION *pProductOperation, BOOL
 }
 
 
+// *[2] Cut short the cycle wait interval of any running operation of the specified type.  Since
+// each sleep semaphore has a maximum count of one, any number of signals received during a cycle
+// results in a single wakeup.  The cycle interval remains in effect as a fallback.
+void WakeOperationsOfType( unsigned short OperationType )
+{
+	PRODUCT_OPERATION	*pProductOperation;
+
+	pProductOperation = pPrimaryOperationList;
+	while ( pProductOperation != 0 )
+		{
+		if ( pProductOperation -> OperationType == OperationType &&
+					( pProductOperation -> OpnState.StatusCode & OPERATION_STATUS_RUNNING ) != 0 &&
+					pProductOperation -> OpnState.hSleepSemaphore != 0 )
+			ReleaseSemaphore( pProductOperation -> OpnState.hSleepSemaphore, 1L, NULL );
+		pProductOperation = pProductOperation -> pNextOperation;
+		}
+}
+
+
 BOOL CheckForOperationTerminationRequest( PRODUCT_OPERATION *pProductOperation )
 {
 	BOOL			bTerminationRequested;
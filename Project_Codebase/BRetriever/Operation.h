@@ -53,6 +53,7 @@ BOOL						LaunchOperation( PRODUCT_OPERATION *pProductOperation );
 void						EnterOperationCycleWaitInterval( PRODUCT_OPERATION *pProductOperation,
 																BOOL bEnableDependentOperations, BOOL *pbTerminateOperation );
 BOOL						CheckForOperationTerminationRequest( PRODUCT_OPERATION *pProductOperation );
+void						WakeOperationsOfType( unsigned short OperationType );
 void						CloseOperation( PRODUCT_OPERATION *pProductOperation );
 void						TerminateAllOperations();
 
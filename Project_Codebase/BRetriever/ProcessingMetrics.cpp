@@ -0,0 +1,358 @@
+// ProcessingMetrics.cpp : Implements the latency and size histograms kept for the BRetriever
+//	processing stages and associations, and their export to a metrics file.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Configuration.h"
+#include "ProcessingMetrics.h"
+
+
+typedef struct
+	{
+	unsigned long			StatusFlag;
+	char					*pLabel;
+	} QUEUE_STATUS_METRIC;
+
+static QUEUE_STATUS_METRIC		QueueStatusMetrics[ NUMBER_OF_QUEUE_STATUS_METRICS ] =
+	{
+		{ PRODUCT_STATUS_ITEM_QUEUED,				"item_queued" },
+		{ PRODUCT_STATUS_ITEM_BEING_PROCESSED,		"item_being_processed" },
+		{ PRODUCT_STATUS_EXTRACTION_COMPLETED,		"extraction_completed" },
+		{ PRODUCT_STATUS_SOURCE_DELETABLE,			"source_deletable" },
+		{ PRODUCT_STATUS_STUDY,						"study" },
+		{ PRODUCT_STATUS_RECEIVE_ERROR,				"receive_error" },
+		{ PRODUCT_STATUS_IMAGE_EXTRACTION_ERROR,	"image_extraction_error" }
+	};
+
+static METRIC_HISTOGRAM			ProcessingStageTimes[ NUMBER_OF_PROCESSING_STAGES ] =
+	{
+		{ "header_parse",			"Header parse" },
+		{ "image_reformat",			"Image reformat" },
+		{ "abstract_output",		"Abstract output" },
+		{ "image_archive",			"Image archive" },
+		{ "dicom_composition",		"Dicom composition" },
+		{ "image_forwarding",		"Forwarding queue" },
+		{ "source_deletion",		"Source deletion" }
+	};
+
+static METRIC_HISTOGRAM			AssociationBytesReceived = { "association", "Association bytes received" };
+static LARGE_INTEGER			CounterFrequency;
+
+
+static void ClearMetricHistogram( METRIC_HISTOGRAM *pHistogram )
+{
+	char					*pLabel;
+	char					*pDescription;
+
+	pLabel = pHistogram -> pLabel;
+	pDescription = pHistogram -> pDescription;
+	memset( (void*)pHistogram, 0, sizeof(METRIC_HISTOGRAM) );
+	pHistogram -> pLabel = pLabel;
+	pHistogram -> pDescription = pDescription;
+}
+
+
+// This function must be called before any of the histograms are updated.
+void InitProcessingMetrics()
+{
+	int						nStage;
+
+	for ( nStage = 0; nStage < NUMBER_OF_PROCESSING_STAGES; nStage++ )
+		ClearMetricHistogram( &ProcessingStageTimes[ nStage ] );
+	ClearMetricHistogram( &AssociationBytesReceived );
+	if ( !QueryPerformanceFrequency( &CounterFrequency ) )
+		CounterFrequency.QuadPart = 0;
+}
+
+
+// Values below METRIC_HISTOGRAM_SUBBUCKETS have a bucket each.  Above that, the leading two
+// bits after the most significant one select among the buckets for its power of two.
+static int GetMetricBucketIndex( ULONGLONG Value )
+{
+	int						nBucket;
+	int						nExponent;
+
+	if ( Value < METRIC_HISTOGRAM_SUBBUCKETS )
+		nBucket = (int)Value;
+	else
+		{
+		nExponent = 2;
+		while ( nExponent < 63 && ( Value >> ( nExponent + 1 ) ) != 0 )
+			nExponent++;
+		nBucket = METRIC_HISTOGRAM_SUBBUCKETS * ( nExponent - 1 ) + (int)( ( Value >> ( nExponent - 2 ) ) & ( METRIC_HISTOGRAM_SUBBUCKETS - 1 ) );
+		if ( nBucket >= METRIC_HISTOGRAM_BUCKETS )
+			nBucket = METRIC_HISTOGRAM_BUCKETS - 1;
+		}
+
+	return nBucket;
+}
+
+
+// Every value in the bucket is less than this bound.
+static ULONGLONG GetMetricBucketUpperBound( int nBucket )
+{
+	ULONGLONG				UpperBound;
+	int						nExponent;
+
+	if ( nBucket < METRIC_HISTOGRAM_SUBBUCKETS )
+		UpperBound = (ULONGLONG)nBucket + 1;
+	else
+		{
+		nExponent = nBucket / METRIC_HISTOGRAM_SUBBUCKETS + 1;
+		UpperBound = (ULONGLONG)( METRIC_HISTOGRAM_SUBBUCKETS + nBucket % METRIC_HISTOGRAM_SUBBUCKETS + 1 ) << ( nExponent - 2 );
+		}
+
+	return UpperBound;
+}
+
+
+void RecordMetricValue( METRIC_HISTOGRAM *pHistogram, ULONGLONG Value )
+{
+	LONGLONG				PreviousMaxValue;
+
+	InterlockedIncrement( &pHistogram -> BucketCounts[ GetMetricBucketIndex( Value ) ] );
+	InterlockedIncrement64( &pHistogram -> nSamples );
+	InterlockedExchangeAdd64( &pHistogram -> Total, (LONGLONG)Value );
+	PreviousMaxValue = pHistogram -> MaxValue;
+	while ( (LONGLONG)Value > PreviousMaxValue &&
+				InterlockedCompareExchange64( &pHistogram -> MaxValue, (LONGLONG)Value, PreviousMaxValue ) != PreviousMaxValue )
+		PreviousMaxValue = pHistogram -> MaxValue;
+}
+
+
+// Return the upper bound of the bucket holding the specified percentile of the counted values.
+// No value is larger than MaxValue, which also bounds the last bucket.
+static ULONGLONG GetBucketPercentile( LONG *pBucketCounts, LONGLONG nSamples, double Percentile, ULONGLONG MaxValue )
+{
+	ULONGLONG				PercentileValue;
+	LONGLONG				nSamplesCounted;
+	LONGLONG				nSamplesBelowPercentile;
+	int						nBucket;
+
+	nSamplesBelowPercentile = (LONGLONG)( Percentile * (double)nSamples / 100.0 );
+	if ( nSamplesBelowPercentile >= nSamples )
+		nSamplesBelowPercentile = nSamples - 1;
+	nSamplesCounted = 0;
+	nBucket = 0;
+	while ( nBucket < METRIC_HISTOGRAM_BUCKETS - 1 && nSamplesCounted + pBucketCounts[ nBucket ] <= nSamplesBelowPercentile )
+		nSamplesCounted += pBucketCounts[ nBucket++ ];
+	PercentileValue = GetMetricBucketUpperBound( nBucket );
+	if ( PercentileValue > MaxValue || nBucket == METRIC_HISTOGRAM_BUCKETS - 1 )
+		PercentileValue = MaxValue;
+
+	return PercentileValue;
+}
+
+
+ULONGLONG GetMetricPercentile( METRIC_HISTOGRAM *pHistogram, double Percentile )
+{
+	LONG					BucketCounts[ METRIC_HISTOGRAM_BUCKETS ];
+	LONGLONG				nSamples;
+	ULONGLONG				PercentileValue;
+	int						nBucket;
+
+	nSamples = 0;
+	for ( nBucket = 0; nBucket < METRIC_HISTOGRAM_BUCKETS; nBucket++ )
+		{
+		BucketCounts[ nBucket ] = pHistogram -> BucketCounts[ nBucket ];
+		nSamples += BucketCounts[ nBucket ];
+		}
+	PercentileValue = 0;
+	if ( nSamples > 0 )
+		PercentileValue = GetBucketPercentile( BucketCounts, nSamples, Percentile, (ULONGLONG)pHistogram -> MaxValue );
+
+	return PercentileValue;
+}
+
+
+// Add the time elapsed since *pStageStartTime to the specified stage, and start timing the next stage.
+void RecordProcessingStageTime( int nStage, LARGE_INTEGER *pStageStartTime )
+{
+	LARGE_INTEGER			StageEndTime;
+	ULONGLONG				ElapsedCounts;
+	ULONGLONG				ElapsedMicroseconds;
+
+	QueryPerformanceCounter( &StageEndTime );
+	if ( CounterFrequency.QuadPart > 0 && StageEndTime.QuadPart >= pStageStartTime -> QuadPart )
+		{
+		ElapsedCounts = (ULONGLONG)( StageEndTime.QuadPart - pStageStartTime -> QuadPart );
+		ElapsedMicroseconds = ( ElapsedCounts / CounterFrequency.QuadPart ) * 1000000 +
+								( ( ElapsedCounts % CounterFrequency.QuadPart ) * 1000000 ) / CounterFrequency.QuadPart;
+		RecordMetricValue( &ProcessingStageTimes[ nStage ], ElapsedMicroseconds );
+		}
+	*pStageStartTime = StageEndTime;
+}
+
+
+void RecordAssociationBytesReceived( unsigned __int64 nBytesReceived )
+{
+	RecordMetricValue( &AssociationBytesReceived, nBytesReceived );
+}
+
+
+// Log the stage times recorded since they were last logged.  The histograms themselves keep
+// accumulating for the metrics file.
+void LogProcessingStageTimes()
+{
+	METRIC_HISTOGRAM		*pHistogram;
+	LONG					BucketCounts[ METRIC_HISTOGRAM_BUCKETS ];
+	LONG					NewBucketCounts[ METRIC_HISTOGRAM_BUCKETS ];
+	LONGLONG				nNewSamples;
+	LONGLONG				Total;
+	double					TotalMilliseconds;
+	int						nStage;
+	int						nBucket;
+	char					TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	for ( nStage = 0; nStage < NUMBER_OF_PROCESSING_STAGES; nStage++ )
+		{
+		pHistogram = &ProcessingStageTimes[ nStage ];
+		nNewSamples = 0;
+		for ( nBucket = 0; nBucket < METRIC_HISTOGRAM_BUCKETS; nBucket++ )
+			{
+			BucketCounts[ nBucket ] = pHistogram -> BucketCounts[ nBucket ];
+			NewBucketCounts[ nBucket ] = BucketCounts[ nBucket ] - pHistogram -> LoggedBucketCounts[ nBucket ];
+			nNewSamples += NewBucketCounts[ nBucket ];
+			}
+		Total = pHistogram -> Total;
+		if ( nNewSamples > 0 )
+			{
+			TotalMilliseconds = (double)( Total - pHistogram -> LoggedTotal ) / 1000.0;
+			_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
+							"    %-20s %6d images, median %9.3f ms, 99th percentile %9.3f ms, average %9.3f ms, total %9.3f s",
+							pHistogram -> pDescription, (int)nNewSamples,
+							(double)GetBucketPercentile( NewBucketCounts, nNewSamples, 50.0, (ULONGLONG)pHistogram -> MaxValue ) / 1000.0,
+							(double)GetBucketPercentile( NewBucketCounts, nNewSamples, 99.0, (ULONGLONG)pHistogram -> MaxValue ) / 1000.0,
+							TotalMilliseconds / (double)nNewSamples, TotalMilliseconds / 1000.0 );
+			LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+			}
+		memcpy( pHistogram -> LoggedBucketCounts, BucketCounts, sizeof(BucketCounts) );
+		pHistogram -> LoggedTotal = Total;
+		}
+}
+
+
+void TallyProductQueueStatus( unsigned long ProcessingStatus, unsigned long *pQueueDepths )
+{
+	int						nStatusMetric;
+
+	for ( nStatusMetric = 0; nStatusMetric < NUMBER_OF_QUEUE_STATUS_METRICS; nStatusMetric++ )
+		if ( ( ProcessingStatus & QueueStatusMetrics[ nStatusMetric ].StatusFlag ) != 0 )
+			pQueueDepths[ nStatusMetric ]++;
+}
+
+
+// Write the histogram in the Prometheus text format.  The buckets from the first to the last
+// one used are listed, each with its cumulative count.  The count is taken from the buckets,
+// rather than from nSamples, so that it agrees with them while values are being recorded.
+static void WriteMetricHistogram( FILE *pMetricsFile, char *pMetricName, char *pLabelName, METRIC_HISTOGRAM *pHistogram, double UnitScale )
+{
+	LONG					BucketCounts[ METRIC_HISTOGRAM_BUCKETS ];
+	ULONGLONG				nCumulativeCount;
+	int						nFirstBucket;
+	int						nLastBucket;
+	int						nBucket;
+	char					Labels[ 64 ];
+	char					LabelPrefix[ 64 ];
+
+	Labels[ 0 ] = '\0';
+	LabelPrefix[ 0 ] = '\0';
+	if ( pLabelName != 0 )
+		{
+		_snprintf_s( Labels, sizeof(Labels), _TRUNCATE, "{%s=\"%s\"}", pLabelName, pHistogram -> pLabel );
+		_snprintf_s( LabelPrefix, sizeof(LabelPrefix), _TRUNCATE, "%s=\"%s\",", pLabelName, pHistogram -> pLabel );
+		}
+	nFirstBucket = METRIC_HISTOGRAM_BUCKETS;
+	nLastBucket = -1;
+	for ( nBucket = 0; nBucket < METRIC_HISTOGRAM_BUCKETS; nBucket++ )
+		{
+		BucketCounts[ nBucket ] = pHistogram -> BucketCounts[ nBucket ];
+		if ( BucketCounts[ nBucket ] != 0 )
+			{
+			if ( nFirstBucket == METRIC_HISTOGRAM_BUCKETS )
+				nFirstBucket = nBucket;
+			nLastBucket = nBucket;
+			}
+		}
+	nCumulativeCount = 0;
+	for ( nBucket = 0; nBucket <= nLastBucket; nBucket++ )
+		{
+		nCumulativeCount += BucketCounts[ nBucket ];
+		if ( nBucket >= nFirstBucket )
+			fprintf( pMetricsFile, "%s_bucket{%sle=\"%.9g\"} %llu\n", pMetricName, LabelPrefix,
+							(double)GetMetricBucketUpperBound( nBucket ) * UnitScale, nCumulativeCount );
+		}
+	fprintf( pMetricsFile, "%s_bucket{%sle=\"+Inf\"} %llu\n", pMetricName, LabelPrefix, nCumulativeCount );
+	fprintf( pMetricsFile, "%s_sum%s %.9g\n", pMetricName, Labels, (double)pHistogram -> Total * UnitScale );
+	fprintf( pMetricsFile, "%s_count%s %llu\n", pMetricName, Labels, nCumulativeCount );
+}
+
+
+// Write the metrics to a temporary file, then move it over the previous metrics file, so that
+// a reader never sees a partly written file.
+BOOL WriteProcessingMetricsFile( char *pMetricsFileSpec, unsigned long *pQueueDepths )
+{
+	BOOL					bNoError = TRUE;
+	char					TemporaryFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	FILE					*pMetricsFile;
+	int						nStage;
+	int						nStatusMetric;
+
+	_snprintf_s( TemporaryFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s.tmp", pMetricsFileSpec );
+	pMetricsFile = 0;
+	bNoError = ( fopen_s( &pMetricsFile, TemporaryFileSpec, "wb" ) == 0 && pMetricsFile != 0 );
+	if ( bNoError )
+		{
+		fprintf( pMetricsFile, "# HELP bretriever_stage_duration_seconds Time spent in each image processing stage.\n" );
+		fprintf( pMetricsFile, "# TYPE bretriever_stage_duration_seconds histogram\n" );
+		for ( nStage = 0; nStage < NUMBER_OF_PROCESSING_STAGES; nStage++ )
+			WriteMetricHistogram( pMetricsFile, "bretriever_stage_duration_seconds", "stage", &ProcessingStageTimes[ nStage ], 0.000001 );
+		fprintf( pMetricsFile, "# HELP bretriever_association_received_bytes Image file bytes received over each Dicom association.\n" );
+		fprintf( pMetricsFile, "# TYPE bretriever_association_received_bytes histogram\n" );
+		WriteMetricHistogram( pMetricsFile, "bretriever_association_received_bytes", 0, &AssociationBytesReceived, 1.0 );
+		fprintf( pMetricsFile, "# HELP bretriever_product_queue_items Products in the queue with each processing status flag set.\n" );
+		fprintf( pMetricsFile, "# TYPE bretriever_product_queue_items gauge\n" );
+		for ( nStatusMetric = 0; nStatusMetric < NUMBER_OF_QUEUE_STATUS_METRICS; nStatusMetric++ )
+			fprintf( pMetricsFile, "bretriever_product_queue_items{status=\"%s\"} %lu\n",
+							QueueStatusMetrics[ nStatusMetric ].pLabel, pQueueDepths[ nStatusMetric ] );
+		bNoError = ( ferror( pMetricsFile ) == 0 );
+		if ( fclose( pMetricsFile ) != 0 )
+			bNoError = FALSE;
+		}
+	if ( bNoError )
+		bNoError = MoveFileEx( TemporaryFileSpec, pMetricsFileSpec, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH );
+	if ( !bNoError )
+		{
+		DeleteFile( TemporaryFileSpec );
+		LogMessage( "An error occurred writing the processing metrics file.", MESSAGE_TYPE_ERROR );
+		}
+
+	return bNoError;
+}
+
@@ -0,0 +1,90 @@
+// ProcessingMetrics.h - Defines the latency and size histograms kept for the BRetriever
+// processing stages and associations, and their export to a metrics file.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#pragma once
+
+
+// Each histogram divides its range into buckets, four for each power of two, so that any
+// recorded value lies within 25 percent of its bucket's upper bound.  Stage times are recorded
+// in microseconds and association sizes in bytes.  The last bucket also holds anything larger
+// than 2^40 units, which is more than 12 days or a terabyte.
+//
+// The histograms are updated with interlocked operations, without a semaphore, since the
+// header parsing stage is timed on the watch folder operation's thread, the other stages on
+// the Process Image operation's thread, and the association sizes on the receiving threads.
+#define METRIC_HISTOGRAM_SUBBUCKETS			4
+#define METRIC_HISTOGRAM_BUCKETS			( 40 * METRIC_HISTOGRAM_SUBBUCKETS )
+
+typedef struct
+	{
+	char					*pLabel;				// The Prometheus label value naming this histogram.
+	char					*pDescription;			// The name used in the log.
+	volatile LONGLONG		nSamples;
+	volatile LONGLONG		Total;
+	volatile LONGLONG		MaxValue;
+	volatile LONG			BucketCounts[ METRIC_HISTOGRAM_BUCKETS ];
+	// The counts when the histogram was last logged.  Only the logging thread uses these.
+	LONGLONG				LoggedTotal;
+	LONG					LoggedBucketCounts[ METRIC_HISTOGRAM_BUCKETS ];
+	} METRIC_HISTOGRAM;
+
+
+#define STAGE_HEADER_PARSE					0
+#define STAGE_IMAGE_REFORMAT				1
+#define STAGE_ABSTRACT_OUTPUT				2
+#define STAGE_IMAGE_ARCHIVE					3
+#define STAGE_DICOM_COMPOSITION				4
+#define STAGE_IMAGE_FORWARDING				5
+#define STAGE_SOURCE_DELETION				6
+#define NUMBER_OF_PROCESSING_STAGES			7
+
+
+// The product queue depth is counted for each of these ProcessingStatus flags.
+#define NUMBER_OF_QUEUE_STATUS_METRICS		7
+
+
+// The metrics file is rewritten at this interval while the Process Image operation is running,
+// in the Prometheus text format, beside the BRetrieverStatus.dat file.
+#define METRICS_EXPORT_INTERVAL				10000		// Milliseconds.
+#define METRICS_FILE_NAME					"BRetrieverMetrics.prom"
+
+
+
+// Function prototypes.
+//
+void				InitProcessingMetrics();
+
+void				RecordMetricValue( METRIC_HISTOGRAM *pHistogram, ULONGLONG Value );
+ULONGLONG			GetMetricPercentile( METRIC_HISTOGRAM *pHistogram, double Percentile );
+void				RecordProcessingStageTime( int nStage, LARGE_INTEGER *pStageStartTime );
+void				RecordAssociationBytesReceived( unsigned __int64 nBytesReceived );
+void				LogProcessingStageTimes();
+void				TallyProductQueueStatus( unsigned long ProcessingStatus, unsigned long *pQueueDepths );
+BOOL				WriteProcessingMetricsFile( char *pMetricsFileSpec, unsigned long *pQueueDepths );
+
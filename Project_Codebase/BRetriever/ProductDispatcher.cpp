@@ -29,6 +29,25 @@
 //
 // UPDATE HISTORY:
 //
+//	*[7] 10/19/2026 by agent
+//		The stage timing moved to ProcessingMetrics.cpp, which keeps a latency histogram
+//		for each stage.  Export the histograms and the queue depth by processing status
+//		to a metrics file every METRICS_EXPORT_INTERVAL.
+//	*[6] 10/19/2026 by agent
+//		Pass the exam information to ArchiveDicomImageFile(), so the archived image
+//		can be stored in its study's pack file.  Commit the open pack file to the disk
+//		whenever the product queue has been emptied.
+//	*[5] 10/19/2026 by agent
+//		Queue each processed image for forwarding by the Send Image operation.
+//	*[4] 10/19/2026 by agent
+//		Accumulate the time spent in each image processing stage, and log a summary
+//		whenever the product queue has been emptied.
+//	*[3] 10/19/2026 by agent
+//		Wake the Process Image operation as soon as a product is queued, and have it
+//		process queued images back to back instead of one per cycle interval.
+//	*[2] 10/19/2026 by agent
+//		Log the latency from image file reception to the appearance of its
+//		.png and .axt output files.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -42,6 +61,8 @@
 #include "Exam.h"
 #include "ProductDispatcher.h"
 #include "ExamReformat.h"
+#include "DicomArchive.h"		// *[6]
+#include "ProcessingMetrics.h"	// *[7]
 
 
 //___________________________________________________________________________
@@ -71,6 +92,7 @@ static ERROR_DICTIONARY_MODULE			ProductDispatcherStatusErrorDictionary =
 											};
 
 extern TRANSFER_SERVICE					TransferService;
+extern BOOL								QueueImageForForwarding( char *pQueuedDicomFileSpec, char *pPNGImageFileName );		// *[5]
 
 LIST_HEAD								ProductQueue;
 HANDLE									hProductQueueSemaphore = 0;
@@ -91,6 +113,7 @@ void InitProductDispatcherModule()
 	if ( hProductQueueSemaphore == NULL )
 		RespondToError( MODULE_DISPATCH, DISPATCH_ERROR_CREATE_PRODUCT_SEMAPHORE );
 	CreateProductDeletionOperation();
+	InitProcessingMetrics();									// *[7]
 }
 
 
@@ -117,6 +140,8 @@ void InitProductInfoStructure( PRODUCT_QUEUE_ITEM *pProductItem )
 	pProductItem -> pParentProduct = 0;
 	pProductItem -> ArrivalTime = 0L;
 	pProductItem -> LatestActivityTime = 0L;
+	pProductItem -> ReceptionTime.dwLowDateTime = 0;				// *[2]
+	pProductItem -> ReceptionTime.dwHighDateTime = 0;				// *[2]
 	pProductItem -> pProductOperation = 0;
 	pProductItem -> pProductInfo = 0;
 }
@@ -261,6 +286,7 @@ BOOL QueueProductForTransfer( PRODUCT_OPERATION *pProductOperation, PRODUCT_QUEU
 	PRODUCT_QUEUE_ITEM	*pProductItem;
 	PRODUCT_QUEUE_ITEM	*pDuplicateProductItem;
 	char				TextLine[ MAX_FILE_SPEC_LENGTH ];
+	BOOL				bProductWasQueued = FALSE;			// *[3]
 
 	pProductItem = *ppProductItem;
 	time( &CurrentSystemTime );
@@ -280,6 +306,7 @@ BOOL QueueProductForTransfer( PRODUCT_OPERATION *pProductOperation, PRODUCT_QUEU
 			pProductItem -> LocalProductIndex = LocalProductID;
 			pProductItem -> ProcessingStatus |= PRODUCT_STATUS_ITEM_QUEUED;
 			bNoError = AppendToList( &ProductQueue, (void*)pProductItem );
+			bProductWasQueued = bNoError;																		// *[3]
 			if ( pProductItem != 0 )
 				{
 				_snprintf_s( TextLine, MAX_FILE_SPEC_LENGTH, _TRUNCATE,											// *[1] Replaced sprintf() with _snprintf_s.
@@ -311,6 +338,9 @@ BOOL QueueProductForTransfer( PRODUCT_OPERATION *pProductOperation, PRODUCT_QUEU
 		bNoError = FALSE;
 		RespondToError( MODULE_DISPATCH, DISPATCH_ERROR_PRODUCT_SEMAPHORE_RELEASE );
 		}
+	// *[3] Don't leave the new product waiting for the end of the Process Image operation's cycle.
+	if ( bProductWasQueued )
+		WakeOperationsOfType( OPERATION_TYPE_DISPATCH_FROM_QUEUE );
 		
 	return bNoError;
 }
@@ -460,6 +490,69 @@ void NotifyUserOfProductError( PRODUCT_QUEUE_ITEM *pProductItem )
 }
 
 
+// *[2] Log the elapsed time from the reception of the image file until the specified
+// output file was produced.  The reception time is the time the file was last written
+// into the watch folder by the Dicom receiver or by whatever program deposited it.
+void LogProductLatency( PRODUCT_QUEUE_ITEM *pProductItem, char *pOutputDescription )
+{
+	FILETIME				CurrentFileTime;
+	ULARGE_INTEGER			ReceptionTicks;
+	ULARGE_INTEGER			CurrentTicks;
+	double					LatencyInSeconds;
+	char					TextLine[ MAX_LOGGING_STRING_LENGTH ];
+
+	if ( pProductItem -> ReceptionTime.dwLowDateTime != 0 || pProductItem -> ReceptionTime.dwHighDateTime != 0 )
+		{
+		GetSystemTimeAsFileTime( &CurrentFileTime );
+		ReceptionTicks.LowPart = pProductItem -> ReceptionTime.dwLowDateTime;
+		ReceptionTicks.HighPart = pProductItem -> ReceptionTime.dwHighDateTime;
+		CurrentTicks.LowPart = CurrentFileTime.dwLowDateTime;
+		CurrentTicks.HighPart = CurrentFileTime.dwHighDateTime;
+		// File times are expressed in 100-nanosecond intervals.
+		if ( CurrentTicks.QuadPart >= ReceptionTicks.QuadPart )
+			{
+			LatencyInSeconds = (double)( CurrentTicks.QuadPart - ReceptionTicks.QuadPart ) / 10000000.0;
+			_snprintf_s( TextLine, MAX_LOGGING_STRING_LENGTH, _TRUNCATE, "    %s latency:  %.3f seconds after reception of %s",
+							pOutputDescription, LatencyInSeconds, pProductItem -> SourceFileName );
+			LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+			}
+		}
+}
+
+
+// *[7] Count the queued products by their processing status, and write the processing metrics file
+// beside the BRetrieverStatus.dat file.
+static void ExportProcessingMetrics()
+{
+	DWORD					WaitResponse;
+	LIST_ELEMENT			*pListElement;
+	PRODUCT_QUEUE_ITEM		*pProductItem;
+	unsigned long			QueueDepths[ NUMBER_OF_QUEUE_STATUS_METRICS ];
+	char					MetricsFileSpec[ MAX_FILE_SPEC_LENGTH ];
+
+	memset( QueueDepths, 0, sizeof(QueueDepths) );
+	WaitResponse = WaitForSingleObject( hProductQueueSemaphore, PRODUCT_QUEUE_ACCESS_TIMEOUT );
+	if ( WaitResponse == WAIT_OBJECT_0 )
+		{
+		for ( pListElement = ProductQueue; pListElement != 0; pListElement = pListElement -> pNextListElement )
+			{
+			pProductItem = (PRODUCT_QUEUE_ITEM*)pListElement -> pItem;
+			if ( pProductItem != 0 )
+				TallyProductQueueStatus( pProductItem -> ProcessingStatus, QueueDepths );
+			}
+		ReleaseSemaphore( hProductQueueSemaphore, 1L, NULL );
+		}
+	strncpy_s( MetricsFileSpec, MAX_FILE_SPEC_LENGTH, TransferService.ServiceDirectory, _TRUNCATE );
+	if ( LocateOrCreateDirectory( MetricsFileSpec ) )
+		{
+		if ( MetricsFileSpec[ strlen( MetricsFileSpec ) - 1 ] != '\\' )
+			strncat_s( MetricsFileSpec, MAX_FILE_SPEC_LENGTH, "\\", _TRUNCATE );
+		strncat_s( MetricsFileSpec, MAX_FILE_SPEC_LENGTH, METRICS_FILE_NAME, _TRUNCATE );
+		WriteProcessingMetricsFile( MetricsFileSpec, QueueDepths );
+		}
+}
+
+
 unsigned __stdcall ProcessProductQueueThreadFunction( VOID *pOperationStruct )
 {
 	BOOL						bNoError = TRUE;
@@ -469,11 +562,16 @@ unsigned __stdcall ProcessProductQueueThreadFunction( VOID *pOperationStruct )
 	EXAM_INFO					*pExamInfo;
 	ABSTRACT_RECORD_TEXT_LINE	*pAbstractLineList;
 	char						TextLine[ 1096 ];
+	BOOL						bProductWasProcessed;			// *[3]
+	BOOL						bStageTimesNeedLogging = FALSE;	// *[4]
+	LARGE_INTEGER				StageStartTime;					// *[4]
+	ULONGLONG					LastMetricsExportTime;			// *[7]
 
 	pProductOperation = (PRODUCT_OPERATION*)pOperationStruct;
 
 	_snprintf_s( TextLine, 1096, _TRUNCATE, "    Operation Thread: %s", pProductOperation -> OperationName );		// *[1] Replaced sprintf() with _snprintf_s.
 	LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
+	LastMetricsExportTime = GetTickCount64();												// *[7]
 	while ( !bTerminateOperation )
 		{
 		pProductOperation -> OpnState.DirectorySearchLevel = 0;
@@ -482,6 +580,7 @@ unsigned __stdcall ProcessProductQueueThreadFunction( VOID *pOperationStruct )
 		// For the time being, just process the images one at a time as they
 		// are encountered in the queue.
 		pProductItem = GetFirstQueuedProductByStatus( PRODUCT_STATUS_ITEM_QUEUED, PRODUCT_STATUS_ITEM_BEING_PROCESSED | PRODUCT_STATUS_STUDY );
+		bProductWasProcessed = ( pProductItem != 0 );			// *[3]
 		if ( pProductItem != 0 )
 			{
 			UpdateBRetrieverStatus( BRETRIEVER_STATUS_PROCESSING );
@@ -490,7 +589,11 @@ unsigned __stdcall ProcessProductQueueThreadFunction( VOID *pOperationStruct )
 			LogMessage( TextLine, MESSAGE_TYPE_SUPPLEMENTARY );
 			// Extract and reformat the Dicom image contained in the file, so that BViewer
 			// can read it.
+			QueryPerformanceCounter( &StageStartTime );												// *[4]
 			bNoError = PerformLocalFileReformat( pProductItem, pProductOperation );
+			RecordProcessingStageTime( STAGE_IMAGE_REFORMAT, &StageStartTime );						// *[4]
+			if ( bNoError )
+				LogProductLatency( pProductItem, "PNG" );												// *[2]
 			if ( !bNoError )
 				pProductItem -> ProcessingStatus |= PRODUCT_STATUS_IMAGE_EXTRACTION_ERROR;
 			if ( ( pProductItem -> ProcessingStatus & PRODUCT_STATUS_IMAGE_EXTRACTION_ERROR ) == 0 )
@@ -500,22 +603,55 @@ unsigned __stdcall ProcessProductQueueThreadFunction( VOID *pOperationStruct )
 				{
 				pAbstractLineList = pExamInfo -> pDicomInfo -> pAbstractDataLineList;
 				bNoError = OutputAbstractRecords( pProductItem -> DestinationFileName, pAbstractLineList );
+				RecordProcessingStageTime( STAGE_ABSTRACT_OUTPUT, &StageStartTime );				// *[4]
+				if ( bNoError )
+					LogProductLatency( pProductItem, "AXT" );											// *[2]
 				if ( bNoError )
 					{
 					// If image file archiving is requested from the configuration file, name the archived file
 					// the same as the corresponding .PNG and .AXT files.
-					bNoError = ArchiveDicomImageFile( pProductItem -> SourceFileSpec, pProductItem -> DestinationFileName );
+					bNoError = ArchiveDicomImageFile( pProductItem -> SourceFileSpec, pProductItem -> DestinationFileName, pExamInfo );		// *[6]
+					RecordProcessingStageTime( STAGE_IMAGE_ARCHIVE, &StageStartTime );				// *[4]
 					}
 				if ( bNoError )
 					{
 					// If Dicom image output file composition is enabled, compose and save a Dicom output file.
 					bNoError = ComposeDicomFileOutput( pProductItem -> SourceFileSpec, pProductItem -> DestinationFileName, pExamInfo );
+					RecordProcessingStageTime( STAGE_DICOM_COMPOSITION, &StageStartTime );			// *[4]
+					}
+				if ( bNoError )
+					{
+					// *[5] If the Send Image operation is enabled, queue a copy of the image file for forwarding.
+					bNoError = QueueImageForForwarding( pProductItem -> SourceFileSpec, pProductItem -> DestinationFileName );
+					RecordProcessingStageTime( STAGE_IMAGE_FORWARDING, &StageStartTime );
 					}
 				}
+			QueryPerformanceCounter( &StageStartTime );												// *[4]
 			bNoError = DeleteSourceProduct( pProductOperation, &pProductItem );
+			RecordProcessingStageTime( STAGE_SOURCE_DELETION, &StageStartTime );					// *[4]
+			bStageTimesNeedLogging = TRUE;															// *[4]
 			}
 		UpdateBRetrieverStatus( BRETRIEVER_STATUS_ACTIVE );
-		EnterOperationCycleWaitInterval( pProductOperation, TRUE, &bTerminateOperation );
+		if ( GetTickCount64() - LastMetricsExportTime >= METRICS_EXPORT_INTERVAL )				// *[7]
+			{
+			ExportProcessingMetrics();
+			LastMetricsExportTime = GetTickCount64();
+			}
+		// *[3] While there are queued images, go straight on to the next one.  Only wait for the cycle
+		// interval, or for a new product to be queued, once the queue has been emptied.
+		if ( bProductWasProcessed )
+			bTerminateOperation = CheckForOperationTerminationRequest( pProductOperation );
+		else
+			{
+			FlushArchivePack();																		// *[6]
+			if ( bStageTimesNeedLogging )															// *[4]
+				{
+				LogMessage( "Image processing stage times since the product queue was last emptied:", MESSAGE_TYPE_SUPPLEMENTARY );
+				LogProcessingStageTimes();
+				bStageTimesNeedLogging = FALSE;
+				}
+			EnterOperationCycleWaitInterval( pProductOperation, TRUE, &bTerminateOperation );
+			}
 		}			// ...end while not bTerminateOperation.
 	CloseOperation( pProductOperation );
 
@@ -57,5 +57,6 @@ BOOL					QueueProductForTransfer( PRODUCT_OPERATION *pProductOperation, PRODUCT_
 PRODUCT_QUEUE_ITEM		*GetMatchingProductEntry( unsigned long LocalProductIndex );
 void					RemoveProductFromQueue( unsigned long LocalProductIndex );
 void					NotifyUserOfProductError( PRODUCT_QUEUE_ITEM *pProductItem );
+void					LogProductLatency( PRODUCT_QUEUE_ITEM *pProductItem, char *pOutputDescription );
 void					ProcessProductQueueItems();
 BOOL					DeleteSourceProduct( PRODUCT_OPERATION *pProductOperation, PRODUCT_QUEUE_ITEM **ppProductItem );
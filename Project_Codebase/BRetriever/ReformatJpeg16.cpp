@@ -30,6 +30,12 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		Don't free the decoding buffers twice, or end the PNG file, after a JPEG
+//		library error.
+//	*[2] 10/19/2026 by agent
+//		Register the pixel statistics collection for the PNG output, and record the
+//		statistics in a private chunk before ending the PNG file.
 //	*[1] 03/25/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -133,10 +139,7 @@ BOOL Convert16BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *p
 			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_CORRUPTION );
 			jpeg_destroy_decompress( &JpegDecompressInfo );
 			bNoError = FALSE;
-			if ( pRows != 0 )						// *[1] Clean up before error exit.
-				free( pRows );
-			if ( pBuffer != 0 )
-				free( pBuffer );
+			// *[3] The buffers are freed below.
 			}
 		}
 	if ( bNoError )
@@ -249,6 +252,8 @@ BOOL Convert16BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *p
 
 		if ( _stricmp( pDicomHeader -> Modality, "NM" ) != 0 )	// ...for NM, do nothing.
 			png_set_swap( pPngConfig );
+		// Accumulate the pixel statistics as the image rows are written.
+		CollectImagePixelStatistics( pPngConfig, ( _stricmp( pDicomHeader -> Modality, "NM" ) != 0 ) );		// *[2]
 		}
 	if ( bNoError )
 		{
@@ -288,7 +293,12 @@ BOOL Convert16BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *p
 		}
 	if ( pOutputImageFile != 0 && pPngConfig != 0 && pPngImageInfo != 0 )
 		{
-		png_write_end( pPngConfig, pPngImageInfo );
+		// *[3] An incomplete image is abandoned, rather than ended.
+		if ( bNoError )
+			{
+			WriteImagePixelStatisticsChunk( pPngConfig );													// *[2]
+			png_write_end( pPngConfig, pPngImageInfo );
+			}
 		png_destroy_write_struct( &pPngConfig, &pPngImageInfo );
 		}
 
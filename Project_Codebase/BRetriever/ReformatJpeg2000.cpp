@@ -0,0 +1,2030 @@
+// ReformatJpeg2000.cpp : Implements the data structures and functions related to
+//	the conversion of an image from a reversible (lossless) JPEG 2000 grayscale format
+//  into the PNG format readable by BViewer.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "ProductDispatcher.h"
+#include "ExamReformat.h"
+
+
+// The JPEG 2000 images received from radiography equipment are grayscale images compressed
+// losslessly, using the reversible 5/3 wavelet transform.  The decoder below handles that
+// case:  a single component image with up to 16 bits per sample, any tiling, any number of
+// quality layers, and one precinct per resolution level.  The code-block coding options
+// that reset, terminate predictably, use vertically causal contexts or insert segmentation
+// symbols are supported.  Irreversible (9/7 wavelet) compression, the arithmetic coder bypass
+// and termination on every coding pass, regions of interest, progression order changes and
+// packed packet headers are not.
+//
+// References are to the JPEG 2000 standard, ITU-T T.800.
+
+#define J2K_MARKER_SOC					0xFF4F		// Start of codestream.
+#define J2K_MARKER_CAP					0xFF50		// Extended capabilities.
+#define J2K_MARKER_SIZ					0xFF51		// Image and tile size.
+#define J2K_MARKER_COD					0xFF52		// Coding style default.
+#define J2K_MARKER_COC					0xFF53		// Coding style component.
+#define J2K_MARKER_TLM					0xFF55		// Tile-part lengths.
+#define J2K_MARKER_PLM					0xFF57		// Packet length, main header.
+#define J2K_MARKER_PLT					0xFF58		// Packet length, tile-part header.
+#define J2K_MARKER_QCD					0xFF5C		// Quantization default.
+#define J2K_MARKER_QCC					0xFF5D		// Quantization component.
+#define J2K_MARKER_CRG					0xFF63		// Component registration.
+#define J2K_MARKER_COM					0xFF64		// Comment.
+#define J2K_MARKER_SOT					0xFF90		// Start of tile-part.
+#define J2K_MARKER_SOP					0xFF91		// Start of packet.
+#define J2K_MARKER_EPH					0xFF92		// End of packet header.
+#define J2K_MARKER_SOD					0xFF93		// Start of data.
+#define J2K_MARKER_EOC					0xFFD9		// End of codestream.
+
+#define J2K_MAX_DECOMPOSITION_LEVELS	15
+#define J2K_MAX_SUBBANDS				( 1 + 3 * J2K_MAX_DECOMPOSITION_LEVELS )
+#define J2K_MAX_MAGNITUDE_BIT_PLANES	30
+#define J2K_MAX_IMAGE_DIMENSION			0xFFFF		// The Dicom Rows and Columns are 16-bit values.
+#define J2K_MAX_DECODED_IMAGE_SIZE		0x20000000	// The largest buffer allocated for decoded samples, in bytes.
+
+#define J2K_PROGRESSION_LRCP			0			// Layer-resolution-component-position.
+
+#define J2K_CODE_BLOCK_BYPASS			0x01
+#define J2K_CODE_BLOCK_RESET			0x02
+#define J2K_CODE_BLOCK_TERMINATE_ALL	0x04
+#define J2K_CODE_BLOCK_VERTICAL_CAUSAL	0x08
+#define J2K_CODE_BLOCK_PREDICTABLE_TERM	0x10
+#define J2K_CODE_BLOCK_SEGMENT_SYMBOLS	0x20
+
+#define J2K_WAVELET_5_3_REVERSIBLE		1
+
+#define J2K_ORIENTATION_LL				0
+#define J2K_ORIENTATION_HL				1			// Horizontally high-pass.
+#define J2K_ORIENTATION_LH				2			// Vertically high-pass.
+#define J2K_ORIENTATION_HH				3
+
+// Arithmetic decoder contexts, Annex D.
+#define J2K_CONTEXT_ZERO_CODING			0			// Contexts 0 - 8.
+#define J2K_CONTEXT_SIGN_CODING			9			// Contexts 9 - 13.
+#define J2K_CONTEXT_MAGNITUDE			14			// Contexts 14 - 16.
+#define J2K_CONTEXT_RUN_LENGTH			17
+#define J2K_CONTEXT_UNIFORM				18
+#define J2K_CONTEXT_COUNT				19
+
+// Code-block coefficient state flags.
+#define COEFFICIENT_SIGNIFICANT			0x01
+#define COEFFICIENT_NEGATIVE			0x02
+#define COEFFICIENT_VISITED				0x04		// Coded in the significance propagation pass of this bit plane.
+#define COEFFICIENT_REFINED				0x08		// Has had at least one magnitude refinement.
+
+// The contribution of a neighboring coefficient to the sign coding context, Table D.2.
+#define SIGN_CONTRIBUTION( Flags )		( ( (Flags) & COEFFICIENT_SIGNIFICANT ) ? ( ( (Flags) & COEFFICIENT_NEGATIVE ) ? -1 : 1 ) : 0 )
+
+
+#pragma pack(push)
+#pragma pack(8)		// Pack structure members on 8-byte boundaries for faster access.
+
+typedef struct
+	{
+	long					nDecompositionLevels;
+	long					nLayers;
+	long					ProgressionOrder;
+	long					CodeBlockWidthExponent;
+	long					CodeBlockHeightExponent;
+	long					CodeBlockStyle;
+	long					WaveletTransform;
+	BOOL					bSOPMarkersUsed;
+	BOOL					bEPHMarkersUsed;
+	long					PrecinctWidthExponent[ J2K_MAX_DECOMPOSITION_LEVELS + 1 ];
+	long					PrecinctHeightExponent[ J2K_MAX_DECOMPOSITION_LEVELS + 1 ];
+	long					QuantizationStyle;
+	long					nGuardBits;
+	long					nSubbandExponents;
+	long					SubbandExponent[ J2K_MAX_SUBBANDS ];
+	} J2K_CODING_PARAMETERS;
+
+
+// The coding and quantization marker segments found in the main header or in the first
+// tile-part header of a tile.  They are applied in order of increasing precedence.
+typedef struct
+	{
+	unsigned char			*pCOD;
+	long					CODLength;
+	unsigned char			*pCOC;
+	long					COCLength;
+	unsigned char			*pQCD;
+	long					QCDLength;
+	unsigned char			*pQCC;
+	long					QCCLength;
+	} J2K_HEADER_SEGMENTS;
+
+
+typedef struct
+	{
+	long					ImageX0;
+	long					ImageY0;
+	long					ImageX1;
+	long					ImageY1;
+	long					TileWidth;
+	long					TileHeight;
+	long					TileX0;
+	long					TileY0;
+	long					nTilesWide;
+	long					nTilesHigh;
+	long					BitDepth;
+	BOOL					bSamplesAreSigned;
+	J2K_CODING_PARAMETERS	CodingParameters;
+	unsigned char			*pFirstTilePart;
+	unsigned char			*pEndOfCodestream;
+	} J2K_IMAGE;
+
+
+// The packet data accumulated for a tile from all of its tile-parts.
+typedef struct
+	{
+	unsigned char			*pPacketData;
+	long					PacketDataLength;
+	J2K_HEADER_SEGMENTS		HeaderSegments;
+	} J2K_TILE_DATA;
+
+
+typedef struct
+	{
+	long					Value;
+	long					LowerBound;
+	long					nParentNode;
+	} J2K_TAG_TREE_NODE;
+
+
+typedef struct
+	{
+	long					nNodes;
+	J2K_TAG_TREE_NODE		*pNodes;				// The leaves come first, in raster order.
+	} J2K_TAG_TREE;
+
+
+typedef struct
+	{
+	long					X0;						// Subband coordinates.
+	long					Y0;
+	long					X1;
+	long					Y1;
+	BOOL					bHasBeenIncluded;
+	long					nZeroBitPlanes;
+	long					nCodingPasses;
+	long					LengthBitCount;			// Lblock, B.10.7.1.
+	unsigned char			*pCodedData;
+	long					CodedDataLength;
+	long					CodedDataBufferSize;
+	} J2K_CODE_BLOCK;
+
+
+typedef struct
+	{
+	long					Orientation;
+	long					X0;						// Subband coordinates.
+	long					Y0;
+	long					X1;
+	long					Y1;
+	long					TileBufferX;			// Location of the subband coefficients in the tile buffer.
+	long					TileBufferY;
+	long					nMagnitudeBitPlanes;	// Mb, E.1.
+	long					nCodeBlocksWide;
+	long					nCodeBlocksHigh;
+	J2K_CODE_BLOCK			*pCodeBlocks;
+	J2K_TAG_TREE			InclusionTree;
+	J2K_TAG_TREE			ZeroBitPlaneTree;
+	} J2K_SUBBAND;
+
+
+typedef struct
+	{
+	long					X0;						// Tile-component coordinates at this resolution.
+	long					Y0;
+	long					X1;
+	long					Y1;
+	long					nSubbands;
+	J2K_SUBBAND				Subband[ 3 ];
+	} J2K_RESOLUTION;
+
+
+typedef struct
+	{
+	unsigned char			*pNextByte;
+	unsigned char			*pEndOfData;
+	unsigned long			CurrentByte;
+	long					nBitsRemaining;
+	BOOL					bDataExhausted;
+	} J2K_PACKET_HEADER_READER;
+
+
+typedef struct
+	{
+	unsigned char			StateIndex;
+	unsigned char			MostProbableSymbol;
+	} J2K_ARITHMETIC_CONTEXT;
+
+
+typedef struct
+	{
+	unsigned char			*pNextByte;
+	unsigned int			C;
+	unsigned int			A;
+	long					CT;
+	J2K_ARITHMETIC_CONTEXT	Context[ J2K_CONTEXT_COUNT ];
+	} J2K_ARITHMETIC_DECODER;
+
+
+typedef struct
+	{
+	long					Width;
+	long					Height;
+	long					FlagRowLength;			// The flags array has a border of one coefficient on each side.
+	unsigned char			*pFlags;
+	long					*pMagnitude;
+	long					Orientation;
+	BOOL					bVerticallyCausal;
+	J2K_ARITHMETIC_DECODER	ArithmeticDecoder;
+	} J2K_CODE_BLOCK_DECODER;
+
+
+typedef struct
+	{
+	unsigned short			Qe;
+	unsigned char			NextIndexMPS;
+	unsigned char			NextIndexLPS;
+	unsigned char			bSwitchMPS;
+	} J2K_PROBABILITY_STATE;
+
+#pragma pack(pop)
+
+
+// The arithmetic decoder probability estimation table, Table C.2.
+static J2K_PROBABILITY_STATE	ProbabilityStateTable[ 47 ] =
+	{
+	{ 0x5601,  1,  1, 1 }, { 0x3401,  2,  6, 0 }, { 0x1801,  3,  9, 0 }, { 0x0AC1,  4, 12, 0 },
+	{ 0x0521,  5, 29, 0 }, { 0x0221, 38, 33, 0 }, { 0x5601,  7,  6, 1 }, { 0x5401,  8, 14, 0 },
+	{ 0x4801,  9, 14, 0 }, { 0x3801, 10, 14, 0 }, { 0x3001, 11, 17, 0 }, { 0x2401, 12, 18, 0 },
+	{ 0x1C01, 13, 20, 0 }, { 0x1601, 29, 21, 0 }, { 0x5601, 15, 14, 1 }, { 0x5401, 16, 14, 0 },
+	{ 0x5101, 17, 15, 0 }, { 0x4801, 18, 16, 0 }, { 0x3801, 19, 17, 0 }, { 0x3401, 20, 18, 0 },
+	{ 0x3001, 21, 19, 0 }, { 0x2801, 22, 19, 0 }, { 0x2401, 23, 20, 0 }, { 0x2201, 24, 21, 0 },
+	{ 0x1C01, 25, 22, 0 }, { 0x1801, 26, 23, 0 }, { 0x1601, 27, 24, 0 }, { 0x1401, 28, 25, 0 },
+	{ 0x1201, 29, 26, 0 }, { 0x1101, 30, 27, 0 }, { 0x0AC1, 31, 28, 0 }, { 0x09C1, 32, 29, 0 },
+	{ 0x08A1, 33, 30, 0 }, { 0x0521, 34, 31, 0 }, { 0x0441, 35, 32, 0 }, { 0x02A1, 36, 33, 0 },
+	{ 0x0221, 37, 34, 0 }, { 0x0141, 38, 35, 0 }, { 0x0111, 39, 36, 0 }, { 0x0085, 40, 37, 0 },
+	{ 0x0049, 41, 38, 0 }, { 0x0025, 42, 39, 0 }, { 0x0015, 43, 40, 0 }, { 0x0009, 44, 41, 0 },
+	{ 0x0005, 45, 42, 0 }, { 0x0001, 45, 43, 0 }, { 0x5601, 46, 46, 0 }
+	};
+
+
+static long CeilingOfQuotient( long Dividend, long Divisor )
+{
+	return ( Dividend + Divisor - 1 ) / Divisor;
+}
+
+
+static long ReadTwoBytes( unsigned char *pData )
+{
+	return ( (long)pData[ 0 ] << 8 ) | (long)pData[ 1 ];
+}
+
+
+static long ReadFourBytes( unsigned char *pData )
+{
+	return (long)( ( (unsigned long)pData[ 0 ] << 24 ) | ( (unsigned long)pData[ 1 ] << 16 ) |
+					( (unsigned long)pData[ 2 ] << 8 ) | (unsigned long)pData[ 3 ] );
+}
+
+
+//___________________________________________________________________________
+//
+// Codestream marker segments.
+//
+
+static BOOL ParseImageAndTileSize( unsigned char *pSegment, long SegmentLength, J2K_IMAGE *pImage )
+{
+	BOOL				bIsSupported;
+
+	// Only a single component, without subsampling, is supported.
+	bIsSupported = ( SegmentLength == 39 && ReadTwoBytes( &pSegment[ 34 ] ) == 1 && pSegment[ 37 ] == 1 && pSegment[ 38 ] == 1 );
+	if ( bIsSupported )
+		{
+		pImage -> ImageX1 = ReadFourBytes( &pSegment[ 2 ] );
+		pImage -> ImageY1 = ReadFourBytes( &pSegment[ 6 ] );
+		pImage -> ImageX0 = ReadFourBytes( &pSegment[ 10 ] );
+		pImage -> ImageY0 = ReadFourBytes( &pSegment[ 14 ] );
+		pImage -> TileWidth = ReadFourBytes( &pSegment[ 18 ] );
+		pImage -> TileHeight = ReadFourBytes( &pSegment[ 22 ] );
+		pImage -> TileX0 = ReadFourBytes( &pSegment[ 26 ] );
+		pImage -> TileY0 = ReadFourBytes( &pSegment[ 30 ] );
+		pImage -> bSamplesAreSigned = ( ( pSegment[ 36 ] & 0x80 ) != 0 );
+		pImage -> BitDepth = (long)( pSegment[ 36 ] & 0x7F ) + 1;
+		bIsSupported = ( pImage -> BitDepth <= 16 &&
+							pImage -> ImageX0 >= 0 && pImage -> ImageX1 > pImage -> ImageX0 &&
+							pImage -> ImageY0 >= 0 && pImage -> ImageY1 > pImage -> ImageY0 &&
+							pImage -> ImageX1 - pImage -> ImageX0 <= J2K_MAX_IMAGE_DIMENSION &&
+							pImage -> ImageY1 - pImage -> ImageY0 <= J2K_MAX_IMAGE_DIMENSION &&
+							pImage -> TileWidth > 0 && pImage -> TileHeight > 0 &&
+							pImage -> TileX0 >= 0 && pImage -> TileX0 <= pImage -> ImageX0 &&
+							pImage -> TileY0 >= 0 && pImage -> TileY0 <= pImage -> ImageY0 &&
+							pImage -> TileX0 + pImage -> TileWidth > pImage -> ImageX0 &&
+							pImage -> TileY0 + pImage -> TileHeight > pImage -> ImageY0 );
+		}
+	if ( bIsSupported )
+		{
+		pImage -> nTilesWide = CeilingOfQuotient( pImage -> ImageX1 - pImage -> TileX0, pImage -> TileWidth );
+		pImage -> nTilesHigh = CeilingOfQuotient( pImage -> ImageY1 - pImage -> TileY0, pImage -> TileHeight );
+		bIsSupported = ( pImage -> nTilesWide <= 65535 && pImage -> nTilesHigh <= 65535 &&
+							pImage -> nTilesWide * pImage -> nTilesHigh <= 65535 );
+		}
+
+	return bIsSupported;
+}
+
+
+// Read the decomposition and code-block parameters shared by the COD and COC marker segments.
+static BOOL ParseCodingStyleParameters( unsigned char *pParameters, long ParameterLength, BOOL bPrecinctsAreSpecified,
+											J2K_CODING_PARAMETERS *pCodingParameters )
+{
+	BOOL				bIsSupported;
+	long				nResolution;
+
+	bIsSupported = ( ParameterLength >= 5 );
+	if ( bIsSupported )
+		{
+		pCodingParameters -> nDecompositionLevels = (long)pParameters[ 0 ];
+		pCodingParameters -> CodeBlockWidthExponent = (long)pParameters[ 1 ] + 2;
+		pCodingParameters -> CodeBlockHeightExponent = (long)pParameters[ 2 ] + 2;
+		pCodingParameters -> CodeBlockStyle = (long)pParameters[ 3 ];
+		pCodingParameters -> WaveletTransform = (long)pParameters[ 4 ];
+		bIsSupported = ( pCodingParameters -> nDecompositionLevels <= J2K_MAX_DECOMPOSITION_LEVELS &&
+							pCodingParameters -> CodeBlockWidthExponent <= 10 &&
+							pCodingParameters -> CodeBlockHeightExponent <= 10 &&
+							pCodingParameters -> CodeBlockWidthExponent + pCodingParameters -> CodeBlockHeightExponent <= 12 );
+		}
+	if ( bIsSupported )
+		{
+		for ( nResolution = 0; nResolution <= pCodingParameters -> nDecompositionLevels; nResolution++ )
+			{
+			if ( bPrecinctsAreSpecified && 5 + nResolution < ParameterLength )
+				{
+				pCodingParameters -> PrecinctWidthExponent[ nResolution ] = (long)( pParameters[ 5 + nResolution ] & 0x0F );
+				pCodingParameters -> PrecinctHeightExponent[ nResolution ] = (long)( pParameters[ 5 + nResolution ] >> 4 );
+				}
+			else
+				{
+				pCodingParameters -> PrecinctWidthExponent[ nResolution ] = 15;
+				pCodingParameters -> PrecinctHeightExponent[ nResolution ] = 15;
+				}
+			}
+		if ( bPrecinctsAreSpecified )
+			bIsSupported = ( ParameterLength == 6 + pCodingParameters -> nDecompositionLevels );
+		}
+
+	return bIsSupported;
+}
+
+
+static BOOL ParseQuantizationParameters( unsigned char *pParameters, long ParameterLength, J2K_CODING_PARAMETERS *pCodingParameters )
+{
+	BOOL				bIsSupported;
+	long				nSubband;
+
+	bIsSupported = ( ParameterLength >= 2 );
+	if ( bIsSupported )
+		{
+		pCodingParameters -> QuantizationStyle = (long)( pParameters[ 0 ] & 0x1F );
+		pCodingParameters -> nGuardBits = (long)( pParameters[ 0 ] >> 5 );
+		// Reversible compression uses no quantization, with one exponent byte per subband.
+		bIsSupported = ( pCodingParameters -> QuantizationStyle == 0 && ParameterLength - 1 <= J2K_MAX_SUBBANDS );
+		}
+	if ( bIsSupported )
+		{
+		pCodingParameters -> nSubbandExponents = ParameterLength - 1;
+		for ( nSubband = 0; nSubband < pCodingParameters -> nSubbandExponents; nSubband++ )
+			pCodingParameters -> SubbandExponent[ nSubband ] = (long)( pParameters[ 1 + nSubband ] >> 3 );
+		}
+
+	return bIsSupported;
+}
+
+
+// Apply the coding and quantization marker segments from a header, in order of increasing precedence.
+static BOOL ApplyHeaderSegments( J2K_HEADER_SEGMENTS *pHeaderSegments, J2K_CODING_PARAMETERS *pCodingParameters )
+{
+	BOOL				bIsSupported = TRUE;
+	unsigned char		*pSegment;
+
+	if ( pHeaderSegments -> pCOD != 0 )
+		{
+		pSegment = pHeaderSegments -> pCOD;
+		bIsSupported = ( pHeaderSegments -> CODLength >= 10 );
+		if ( bIsSupported )
+			{
+			pCodingParameters -> bSOPMarkersUsed = ( ( pSegment[ 0 ] & 0x02 ) != 0 );
+			pCodingParameters -> bEPHMarkersUsed = ( ( pSegment[ 0 ] & 0x04 ) != 0 );
+			pCodingParameters -> ProgressionOrder = (long)pSegment[ 1 ];
+			pCodingParameters -> nLayers = ReadTwoBytes( &pSegment[ 2 ] );
+			bIsSupported = ( pCodingParameters -> ProgressionOrder <= 4 && pCodingParameters -> nLayers > 0 &&
+								ParseCodingStyleParameters( &pSegment[ 5 ], pHeaderSegments -> CODLength - 5,
+																( pSegment[ 0 ] & 0x01 ) != 0, pCodingParameters ) );
+			}
+		}
+	if ( bIsSupported && pHeaderSegments -> pCOC != 0 )
+		{
+		pSegment = pHeaderSegments -> pCOC;
+		bIsSupported = ( pHeaderSegments -> COCLength >= 7 && pSegment[ 0 ] == 0 &&
+								ParseCodingStyleParameters( &pSegment[ 2 ], pHeaderSegments -> COCLength - 2,
+																( pSegment[ 1 ] & 0x01 ) != 0, pCodingParameters ) );
+		}
+	if ( bIsSupported && pHeaderSegments -> pQCD != 0 )
+		bIsSupported = ParseQuantizationParameters( pHeaderSegments -> pQCD, pHeaderSegments -> QCDLength, pCodingParameters );
+	if ( bIsSupported && pHeaderSegments -> pQCC != 0 )
+		bIsSupported = ( pHeaderSegments -> QCCLength >= 3 && pHeaderSegments -> pQCC[ 0 ] == 0 &&
+							ParseQuantizationParameters( &pHeaderSegments -> pQCC[ 1 ], pHeaderSegments -> QCCLength - 1, pCodingParameters ) );
+
+	return bIsSupported;
+}
+
+
+// Check that the coding parameters describe a reversible image that can be decoded here.
+static BOOL CodingParametersAreSupported( J2K_CODING_PARAMETERS *pCodingParameters )
+{
+	return ( pCodingParameters -> WaveletTransform == J2K_WAVELET_5_3_REVERSIBLE &&
+				pCodingParameters -> QuantizationStyle == 0 &&
+				pCodingParameters -> nSubbandExponents >= 1 + 3 * pCodingParameters -> nDecompositionLevels &&
+				( pCodingParameters -> CodeBlockStyle & ( J2K_CODE_BLOCK_BYPASS | J2K_CODE_BLOCK_TERMINATE_ALL | 0xC0 ) ) == 0 );
+}
+
+
+// Store the location and length of a marker segment that may be overridden later.
+static BOOL RecordHeaderSegment( unsigned short Marker, unsigned char *pSegment, long SegmentLength, J2K_HEADER_SEGMENTS *pHeaderSegments )
+{
+	BOOL				bIsSupported = TRUE;
+
+	switch ( Marker )
+		{
+		case J2K_MARKER_COD:
+			pHeaderSegments -> pCOD = pSegment;
+			pHeaderSegments -> CODLength = SegmentLength;
+			break;
+		case J2K_MARKER_COC:
+			pHeaderSegments -> pCOC = pSegment;
+			pHeaderSegments -> COCLength = SegmentLength;
+			break;
+		case J2K_MARKER_QCD:
+			pHeaderSegments -> pQCD = pSegment;
+			pHeaderSegments -> QCDLength = SegmentLength;
+			break;
+		case J2K_MARKER_QCC:
+			pHeaderSegments -> pQCC = pSegment;
+			pHeaderSegments -> QCCLength = SegmentLength;
+			break;
+		case J2K_MARKER_CAP:
+		case J2K_MARKER_TLM:
+		case J2K_MARKER_PLM:
+		case J2K_MARKER_PLT:
+		case J2K_MARKER_CRG:
+		case J2K_MARKER_COM:
+			// These segments have no effect on the decoding.
+			break;
+		default:
+			// The other marker segments (RGN, POC, PPM, PPT, etc.) indicate options that aren't supported.
+			bIsSupported = FALSE;
+			break;
+		}
+
+	return bIsSupported;
+}
+
+
+// Read the main header of the codestream, up to the first tile-part.  Return FALSE if the
+// image is not one that can be handled by this decoder.
+static BOOL ParseJpeg2000MainHeader( unsigned char *pCodestream, unsigned long CodestreamLength, J2K_IMAGE *pImage )
+{
+	BOOL					bIsSupported = TRUE;
+	BOOL					bImageSizeFound = FALSE;
+	BOOL					bFirstTilePartFound = FALSE;
+	unsigned char			*pNextByte;
+	unsigned char			*pEndOfCodestream;
+	unsigned short			Marker;
+	long					SegmentLength;
+	J2K_HEADER_SEGMENTS		MainHeaderSegments;
+
+	memset( pImage, 0, sizeof(J2K_IMAGE) );
+	memset( &MainHeaderSegments, 0, sizeof(J2K_HEADER_SEGMENTS) );
+	pNextByte = pCodestream;
+	pEndOfCodestream = pCodestream + CodestreamLength;
+	if ( pCodestream == 0 || CodestreamLength < 4 || ReadTwoBytes( pNextByte ) != J2K_MARKER_SOC )
+		bIsSupported = FALSE;
+	else
+		pNextByte += 2;
+	while ( bIsSupported && !bFirstTilePartFound )
+		{
+		bIsSupported = ( pNextByte + 4 <= pEndOfCodestream );
+		if ( bIsSupported )
+			{
+			Marker = (unsigned short)ReadTwoBytes( pNextByte );
+			SegmentLength = ReadTwoBytes( pNextByte + 2 );
+			bIsSupported = ( SegmentLength >= 2 && pNextByte + 2 + SegmentLength <= pEndOfCodestream );
+			}
+		if ( bIsSupported )
+			{
+			if ( Marker == J2K_MARKER_SOT )
+				{
+				bFirstTilePartFound = TRUE;
+				pImage -> pFirstTilePart = pNextByte;
+				}
+			else if ( Marker == J2K_MARKER_SIZ )
+				{
+				bIsSupported = ParseImageAndTileSize( pNextByte + 4, SegmentLength - 2, pImage );
+				bImageSizeFound = TRUE;
+				}
+			else
+				bIsSupported = RecordHeaderSegment( Marker, pNextByte + 4, SegmentLength - 2, &MainHeaderSegments );
+			if ( !bFirstTilePartFound )
+				pNextByte += 2 + SegmentLength;
+			}
+		}
+	if ( bIsSupported )
+		{
+		bIsSupported = ( bImageSizeFound && MainHeaderSegments.pCOD != 0 && MainHeaderSegments.pQCD != 0 &&
+							ApplyHeaderSegments( &MainHeaderSegments, &pImage -> CodingParameters ) &&
+							CodingParametersAreSupported( &pImage -> CodingParameters ) );
+		pImage -> pEndOfCodestream = pEndOfCodestream;
+		}
+
+	return bIsSupported;
+}
+
+
+// Gather the packet data of each tile from its tile-parts.
+static BOOL ReadJpeg2000TileParts( J2K_IMAGE *pImage, J2K_TILE_DATA *pTileData, BOOL *pbIsSupported )
+{
+	BOOL					bNoError = TRUE;
+	BOOL					bEndOfCodestream = FALSE;
+	unsigned char			*pNextByte;
+	unsigned char			*pTilePart;
+	unsigned char			*pEndOfTilePart;
+	unsigned char			*pNewPacketData;
+	unsigned short			Marker;
+	long					SegmentLength;
+	long					nTile;
+	long					TilePartLength;
+	long					nTilePart;
+	long					PacketDataLength;
+
+	*pbIsSupported = TRUE;
+	pNextByte = pImage -> pFirstTilePart;
+	while ( bNoError && *pbIsSupported && !bEndOfCodestream )
+		{
+		if ( pNextByte + 2 > pImage -> pEndOfCodestream || ReadTwoBytes( pNextByte ) == J2K_MARKER_EOC )
+			bEndOfCodestream = TRUE;
+		else
+			{
+			// Read the SOT marker segment.
+			pTilePart = pNextByte;
+			bNoError = ( pTilePart + 14 <= pImage -> pEndOfCodestream && ReadTwoBytes( pTilePart ) == J2K_MARKER_SOT &&
+								ReadTwoBytes( pTilePart + 2 ) == 10 );
+			if ( bNoError )
+				{
+				nTile = ReadTwoBytes( pTilePart + 4 );
+				TilePartLength = ReadFourBytes( pTilePart + 6 );
+				nTilePart = (long)pTilePart[ 10 ];
+				if ( TilePartLength == 0 )
+					{
+					// This tile-part extends to the end of the codestream.
+					pEndOfTilePart = pImage -> pEndOfCodestream;
+					if ( pEndOfTilePart - 2 >= pTilePart && ReadTwoBytes( pEndOfTilePart - 2 ) == J2K_MARKER_EOC )
+						pEndOfTilePart -= 2;
+					}
+				else
+					pEndOfTilePart = pTilePart + TilePartLength;
+				bNoError = ( nTile < pImage -> nTilesWide * pImage -> nTilesHigh && TilePartLength >= 0 &&
+									pEndOfTilePart >= pTilePart + 14 && pEndOfTilePart <= pImage -> pEndOfCodestream );
+				pNextByte = pTilePart + 12;
+				}
+			// Read the tile-part header, up to the SOD marker.
+			Marker = 0;
+			while ( bNoError && *pbIsSupported && Marker != J2K_MARKER_SOD )
+				{
+				bNoError = ( pNextByte + 2 <= pEndOfTilePart );
+				if ( bNoError )
+					{
+					Marker = (unsigned short)ReadTwoBytes( pNextByte );
+					pNextByte += 2;
+					}
+				if ( bNoError && Marker != J2K_MARKER_SOD )
+					{
+					bNoError = ( pNextByte + 2 <= pEndOfTilePart );
+					if ( bNoError )
+						{
+						SegmentLength = ReadTwoBytes( pNextByte );
+						bNoError = ( SegmentLength >= 2 && pNextByte + SegmentLength <= pEndOfTilePart );
+						}
+					if ( bNoError )
+						{
+						// Coding parameter overrides are only permitted in the first tile-part of a tile.
+						if ( nTilePart == 0 )
+							*pbIsSupported = RecordHeaderSegment( Marker, pNextByte + 2, SegmentLength - 2, &pTileData[ nTile ].HeaderSegments );
+						else
+							*pbIsSupported = ( Marker == J2K_MARKER_PLT || Marker == J2K_MARKER_COM );
+						pNextByte += SegmentLength;
+						}
+					}
+				}
+			// Append the packet data of the tile-part to that of the tile.
+			if ( bNoError && *pbIsSupported )
+				{
+				PacketDataLength = (long)( pEndOfTilePart - pNextByte );
+				pNewPacketData = (unsigned char*)realloc( pTileData[ nTile ].pPacketData, pTileData[ nTile ].PacketDataLength + PacketDataLength + 1 );
+				if ( pNewPacketData == 0 )
+					{
+					RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+					bNoError = FALSE;
+					}
+				else
+					{
+					pTileData[ nTile ].pPacketData = pNewPacketData;
+					memcpy( &pNewPacketData[ pTileData[ nTile ].PacketDataLength ], pNextByte, PacketDataLength );
+					pTileData[ nTile ].PacketDataLength += PacketDataLength;
+					pNextByte = pEndOfTilePart;
+					}
+				}
+			}
+		}
+
+	return bNoError;
+}
+
+
+//___________________________________________________________________________
+//
+// Tier 2:  packet header decoding, Annex B.
+//
+
+static BOOL CreateTagTree( J2K_TAG_TREE *pTagTree, long nLeavesWide, long nLeavesHigh )
+{
+	BOOL				bNoError = TRUE;
+	long				nLevelWidth[ 32 ];
+	long				nLevelHeight[ 32 ];
+	long				nLevelFirstNode[ 32 ];
+	long				nLevels;
+	long				nLevel;
+	long				nNodes;
+	long				nNode;
+	long				nColumn;
+	long				nRow;
+
+	// Count the nodes at each level of the tree, from the leaves up to the root.
+	nLevels = 0;
+	nNodes = 0;
+	nLevelWidth[ 0 ] = nLeavesWide;
+	nLevelHeight[ 0 ] = nLeavesHigh;
+	do
+		{
+		if ( nLevels > 0 )
+			{
+			nLevelWidth[ nLevels ] = ( nLevelWidth[ nLevels - 1 ] + 1 ) / 2;
+			nLevelHeight[ nLevels ] = ( nLevelHeight[ nLevels - 1 ] + 1 ) / 2;
+			}
+		nLevelFirstNode[ nLevels ] = nNodes;
+		nNodes += nLevelWidth[ nLevels ] * nLevelHeight[ nLevels ];
+		nLevels++;
+		}
+	while ( nLevelWidth[ nLevels - 1 ] * nLevelHeight[ nLevels - 1 ] > 1 && nLevels < 32 );
+	pTagTree -> nNodes = nNodes;
+	pTagTree -> pNodes = (J2K_TAG_TREE_NODE*)malloc( nNodes * sizeof(J2K_TAG_TREE_NODE) );
+	if ( pTagTree -> pNodes == 0 )
+		{
+		RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+		bNoError = FALSE;
+		}
+	else
+		{
+		for ( nLevel = 0; nLevel < nLevels; nLevel++ )
+			for ( nRow = 0; nRow < nLevelHeight[ nLevel ]; nRow++ )
+				for ( nColumn = 0; nColumn < nLevelWidth[ nLevel ]; nColumn++ )
+					{
+					nNode = nLevelFirstNode[ nLevel ] + nRow * nLevelWidth[ nLevel ] + nColumn;
+					pTagTree -> pNodes[ nNode ].Value = 0x7FFFFFFF;
+					pTagTree -> pNodes[ nNode ].LowerBound = 0;
+					if ( nLevel + 1 < nLevels )
+						pTagTree -> pNodes[ nNode ].nParentNode = nLevelFirstNode[ nLevel + 1 ] +
+																	( nRow / 2 ) * nLevelWidth[ nLevel + 1 ] + nColumn / 2;
+					else
+						pTagTree -> pNodes[ nNode ].nParentNode = -1;
+					}
+		}
+
+	return bNoError;
+}
+
+
+static unsigned long ReadPacketHeaderBit( J2K_PACKET_HEADER_READER *pReader )
+{
+	if ( pReader -> nBitsRemaining == 0 )
+		{
+		// A bit is stuffed following each 0xFF byte, B.10.1.
+		pReader -> nBitsRemaining = ( pReader -> CurrentByte == 0xFF ) ? 7 : 8;
+		if ( pReader -> pNextByte < pReader -> pEndOfData )
+			pReader -> CurrentByte = (unsigned long)*pReader -> pNextByte++;
+		else
+			{
+			pReader -> CurrentByte = 0;
+			pReader -> bDataExhausted = TRUE;
+			}
+		}
+	pReader -> nBitsRemaining--;
+
+	return ( pReader -> CurrentByte >> pReader -> nBitsRemaining ) & 1;
+}
+
+
+static unsigned long ReadPacketHeaderBits( J2K_PACKET_HEADER_READER *pReader, long nBits )
+{
+	unsigned long		Value = 0;
+
+	while ( nBits-- > 0 )
+		Value = ( Value << 1 ) | ReadPacketHeaderBit( pReader );
+
+	return Value;
+}
+
+
+// Decode the tag tree information for a leaf, up to the threshold, B.10.2.  Return TRUE if the
+// leaf value is less than the threshold.
+static BOOL DecodeTagTree( J2K_TAG_TREE *pTagTree, long nLeaf, long Threshold, J2K_PACKET_HEADER_READER *pReader )
+{
+	long					PathToRoot[ 32 ];
+	long					nPathNodes;
+	long					nNode;
+	long					LowerBound;
+	J2K_TAG_TREE_NODE		*pNode;
+
+	nPathNodes = 0;
+	nNode = nLeaf;
+	while ( nNode >= 0 && nPathNodes < 32 )
+		{
+		PathToRoot[ nPathNodes++ ] = nNode;
+		nNode = pTagTree -> pNodes[ nNode ].nParentNode;
+		}
+	LowerBound = 0;
+	while ( nPathNodes > 0 )
+		{
+		pNode = &pTagTree -> pNodes[ PathToRoot[ --nPathNodes ] ];
+		if ( LowerBound > pNode -> LowerBound )
+			pNode -> LowerBound = LowerBound;
+		else
+			LowerBound = pNode -> LowerBound;
+		while ( LowerBound < Threshold && LowerBound < pNode -> Value )
+			{
+			if ( ReadPacketHeaderBit( pReader ) )
+				pNode -> Value = LowerBound;
+			else
+				LowerBound++;
+			}
+		pNode -> LowerBound = LowerBound;
+		}
+
+	return ( pTagTree -> pNodes[ nLeaf ].Value < Threshold );
+}
+
+
+// Decode the number of coding passes included in the packet, Table B.4.
+static long ReadCodingPassCount( J2K_PACKET_HEADER_READER *pReader )
+{
+	long				nCodingPasses;
+
+	if ( ReadPacketHeaderBit( pReader ) == 0 )
+		nCodingPasses = 1;
+	else if ( ReadPacketHeaderBit( pReader ) == 0 )
+		nCodingPasses = 2;
+	else
+		{
+		nCodingPasses = (long)ReadPacketHeaderBits( pReader, 2 );
+		if ( nCodingPasses < 3 )
+			nCodingPasses += 3;
+		else
+			{
+			nCodingPasses = (long)ReadPacketHeaderBits( pReader, 5 );
+			if ( nCodingPasses < 31 )
+				nCodingPasses += 6;
+			else
+				nCodingPasses = (long)ReadPacketHeaderBits( pReader, 7 ) + 37;
+			}
+		}
+
+	return nCodingPasses;
+}
+
+
+// Decode one packet, which contains the contributions of a quality layer to the code-blocks
+// of a resolution level.  The code-block contributions are appended to each code-block's
+// coded data.
+static BOOL DecodePacket( J2K_RESOLUTION *pResolution, long nLayer, J2K_CODING_PARAMETERS *pCodingParameters,
+							unsigned char **ppNextByte, unsigned char *pEndOfData )
+{
+	BOOL						bNoError = TRUE;
+	J2K_PACKET_HEADER_READER	Reader;
+	J2K_SUBBAND					*pSubband;
+	J2K_CODE_BLOCK				*pCodeBlock;
+	unsigned char				*pNewCodedData;
+	long						nSubband;
+	long						nCodeBlock;
+	long						nCodeBlocks;
+	long						nNewCodingPasses;
+	long						nLengthBits;
+	long						nPasses;
+	long						*pContributionLength;
+	long						nContribution;
+	long						nContributions;
+
+	// Skip a start of packet marker segment.
+	if ( pCodingParameters -> bSOPMarkersUsed && *ppNextByte + 6 <= pEndOfData && ReadTwoBytes( *ppNextByte ) == J2K_MARKER_SOP )
+		*ppNextByte += 6;
+	nContributions = 0;
+	for ( nSubband = 0; nSubband < pResolution -> nSubbands; nSubband++ )
+		nContributions += pResolution -> Subband[ nSubband ].nCodeBlocksWide * pResolution -> Subband[ nSubband ].nCodeBlocksHigh;
+	pContributionLength = (long*)calloc( nContributions + 1, sizeof(long) );
+	if ( pContributionLength == 0 )
+		{
+		RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+		bNoError = FALSE;
+		}
+	if ( bNoError )
+		{
+		Reader.pNextByte = *ppNextByte;
+		Reader.pEndOfData = pEndOfData;
+		Reader.CurrentByte = 0;
+		Reader.nBitsRemaining = 0;
+		Reader.bDataExhausted = FALSE;
+		// A zero bit indicates an empty packet.
+		if ( ReadPacketHeaderBit( &Reader ) != 0 )
+			{
+			nContribution = 0;
+			for ( nSubband = 0; nSubband < pResolution -> nSubbands; nSubband++ )
+				{
+				pSubband = &pResolution -> Subband[ nSubband ];
+				nCodeBlocks = pSubband -> nCodeBlocksWide * pSubband -> nCodeBlocksHigh;
+				for ( nCodeBlock = 0; nCodeBlock < nCodeBlocks && !Reader.bDataExhausted; nCodeBlock++, nContribution++ )
+					{
+					pCodeBlock = &pSubband -> pCodeBlocks[ nCodeBlock ];
+					// Determine whether this code-block is included in this layer.
+					if ( !pCodeBlock -> bHasBeenIncluded )
+						{
+						if ( DecodeTagTree( &pSubband -> InclusionTree, nCodeBlock, nLayer + 1, &Reader ) )
+							{
+							// On first inclusion, decode the number of missing most significant bit planes.
+							nPasses = 1;
+							while ( !DecodeTagTree( &pSubband -> ZeroBitPlaneTree, nCodeBlock, nPasses, &Reader ) &&
+																!Reader.bDataExhausted && nPasses <= J2K_MAX_MAGNITUDE_BIT_PLANES )
+								nPasses++;
+							pCodeBlock -> nZeroBitPlanes = nPasses - 1;
+							pCodeBlock -> bHasBeenIncluded = TRUE;
+							pContributionLength[ nContribution ] = -1;
+							}
+						}
+					else if ( ReadPacketHeaderBit( &Reader ) )
+						pContributionLength[ nContribution ] = -1;
+					if ( pContributionLength[ nContribution ] != 0 )
+						{
+						nNewCodingPasses = ReadCodingPassCount( &Reader );
+						// Update the number of bits used to signal the codeword length.
+						while ( ReadPacketHeaderBit( &Reader ) && !Reader.bDataExhausted )
+							pCodeBlock -> LengthBitCount++;
+						nLengthBits = pCodeBlock -> LengthBitCount;
+						for ( nPasses = nNewCodingPasses; nPasses > 1; nPasses >>= 1 )
+							nLengthBits++;
+						pContributionLength[ nContribution ] = (long)ReadPacketHeaderBits( &Reader, nLengthBits );
+						pCodeBlock -> nCodingPasses += nNewCodingPasses;
+						}
+					}
+				}
+			}
+		// The packet header ends on a byte boundary, with a stuffed byte following a final 0xFF.
+		if ( Reader.CurrentByte == 0xFF && Reader.pNextByte < pEndOfData )
+			Reader.pNextByte++;
+		bNoError = !Reader.bDataExhausted;
+		*ppNextByte = Reader.pNextByte;
+		if ( pCodingParameters -> bEPHMarkersUsed && *ppNextByte + 2 <= pEndOfData && ReadTwoBytes( *ppNextByte ) == J2K_MARKER_EPH )
+			*ppNextByte += 2;
+		}
+	// Append each code-block contribution from the packet body.
+	if ( bNoError )
+		{
+		nContribution = 0;
+		for ( nSubband = 0; nSubband < pResolution -> nSubbands && bNoError; nSubband++ )
+			{
+			pSubband = &pResolution -> Subband[ nSubband ];
+			nCodeBlocks = pSubband -> nCodeBlocksWide * pSubband -> nCodeBlocksHigh;
+			for ( nCodeBlock = 0; nCodeBlock < nCodeBlocks && bNoError; nCodeBlock++, nContribution++ )
+				{
+				pCodeBlock = &pSubband -> pCodeBlocks[ nCodeBlock ];
+				if ( pContributionLength[ nContribution ] > 0 )
+					{
+					bNoError = ( pContributionLength[ nContribution ] <= (long)( pEndOfData - *ppNextByte ) );
+					if ( bNoError && pCodeBlock -> CodedDataLength + pContributionLength[ nContribution ] + 2 > pCodeBlock -> CodedDataBufferSize )
+						{
+						// Leave room for the two 0xFF bytes appended for the arithmetic decoder.
+						pNewCodedData = (unsigned char*)realloc( pCodeBlock -> pCodedData, pCodeBlock -> CodedDataLength + pContributionLength[ nContribution ] + 2 );
+						if ( pNewCodedData == 0 )
+							{
+							RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+							bNoError = FALSE;
+							}
+						else
+							{
+							pCodeBlock -> pCodedData = pNewCodedData;
+							pCodeBlock -> CodedDataBufferSize = pCodeBlock -> CodedDataLength + pContributionLength[ nContribution ] + 2;
+							}
+						}
+					if ( bNoError )
+						{
+						memcpy( &pCodeBlock -> pCodedData[ pCodeBlock -> CodedDataLength ], *ppNextByte, pContributionLength[ nContribution ] );
+						pCodeBlock -> CodedDataLength += pContributionLength[ nContribution ];
+						*ppNextByte += pContributionLength[ nContribution ];
+						}
+					}
+				}
+			}
+		}
+	if ( pContributionLength != 0 )
+		free( pContributionLength );
+
+	return bNoError;
+}
+
+
+//___________________________________________________________________________
+//
+// Tier 1:  code-block decoding, Annexes C and D.
+//
+
+static void ResetArithmeticContexts( J2K_ARITHMETIC_DECODER *pDecoder )
+{
+	long				nContext;
+
+	for ( nContext = 0; nContext < J2K_CONTEXT_COUNT; nContext++ )
+		{
+		pDecoder -> Context[ nContext ].StateIndex = 0;
+		pDecoder -> Context[ nContext ].MostProbableSymbol = 0;
+		}
+	pDecoder -> Context[ J2K_CONTEXT_ZERO_CODING ].StateIndex = 4;
+	pDecoder -> Context[ J2K_CONTEXT_RUN_LENGTH ].StateIndex = 3;
+	pDecoder -> Context[ J2K_CONTEXT_UNIFORM ].StateIndex = 46;
+}
+
+
+// Read the next byte of coded data into the C register, C.3.4.  The coded data is terminated
+// by two 0xFF bytes, so the decoder never reads past them.
+static void ReadArithmeticDecoderByte( J2K_ARITHMETIC_DECODER *pDecoder )
+{
+	if ( pDecoder -> pNextByte[ 0 ] == 0xFF )
+		{
+		if ( pDecoder -> pNextByte[ 1 ] > 0x8F )
+			{
+			pDecoder -> C += 0xFF00;
+			pDecoder -> CT = 8;
+			}
+		else
+			{
+			pDecoder -> pNextByte++;
+			pDecoder -> C += (unsigned int)pDecoder -> pNextByte[ 0 ] << 9;
+			pDecoder -> CT = 7;
+			}
+		}
+	else
+		{
+		pDecoder -> pNextByte++;
+		pDecoder -> C += (unsigned int)pDecoder -> pNextByte[ 0 ] << 8;
+		pDecoder -> CT = 8;
+		}
+}
+
+
+static void InitializeArithmeticDecoder( J2K_ARITHMETIC_DECODER *pDecoder, unsigned char *pCodedData )
+{
+	pDecoder -> pNextByte = pCodedData;
+	pDecoder -> C = (unsigned int)pCodedData[ 0 ] << 16;
+	ReadArithmeticDecoderByte( pDecoder );
+	pDecoder -> C <<= 7;
+	pDecoder -> CT -= 7;
+	pDecoder -> A = 0x8000;
+}
+
+
+static void RenormalizeArithmeticDecoder( J2K_ARITHMETIC_DECODER *pDecoder )
+{
+	do
+		{
+		if ( pDecoder -> CT == 0 )
+			ReadArithmeticDecoderByte( pDecoder );
+		pDecoder -> A <<= 1;
+		pDecoder -> C <<= 1;
+		pDecoder -> CT--;
+		}
+	while ( ( pDecoder -> A & 0x8000 ) == 0 );
+}
+
+
+// Decode a binary decision in the specified context, C.3.2.
+static unsigned long DecodeArithmeticDecision( J2K_ARITHMETIC_DECODER *pDecoder, long nContext )
+{
+	J2K_ARITHMETIC_CONTEXT	*pContext;
+	J2K_PROBABILITY_STATE	*pState;
+	unsigned long			Decision;
+
+	pContext = &pDecoder -> Context[ nContext ];
+	pState = &ProbabilityStateTable[ pContext -> StateIndex ];
+	pDecoder -> A -= pState -> Qe;
+	// The less probable symbol occupies the lower part of the interval.
+	if ( ( pDecoder -> C >> 16 ) < pState -> Qe )
+		{
+		// Conditional LPS exchange.
+		if ( pDecoder -> A < pState -> Qe )
+			{
+			Decision = pContext -> MostProbableSymbol;
+			pContext -> StateIndex = pState -> NextIndexMPS;
+			}
+		else
+			{
+			Decision = 1 - pContext -> MostProbableSymbol;
+			if ( pState -> bSwitchMPS )
+				pContext -> MostProbableSymbol = (unsigned char)( 1 - pContext -> MostProbableSymbol );
+			pContext -> StateIndex = pState -> NextIndexLPS;
+			}
+		pDecoder -> A = pState -> Qe;
+		RenormalizeArithmeticDecoder( pDecoder );
+		}
+	else
+		{
+		pDecoder -> C -= (unsigned int)pState -> Qe << 16;
+		if ( ( pDecoder -> A & 0x8000 ) != 0 )
+			Decision = pContext -> MostProbableSymbol;
+		else
+			{
+			// Conditional MPS exchange.
+			if ( pDecoder -> A < pState -> Qe )
+				{
+				Decision = 1 - pContext -> MostProbableSymbol;
+				if ( pState -> bSwitchMPS )
+					pContext -> MostProbableSymbol = (unsigned char)( 1 - pContext -> MostProbableSymbol );
+				pContext -> StateIndex = pState -> NextIndexLPS;
+				}
+			else
+				{
+				Decision = pContext -> MostProbableSymbol;
+				pContext -> StateIndex = pState -> NextIndexMPS;
+				}
+			RenormalizeArithmeticDecoder( pDecoder );
+			}
+		}
+
+	return Decision;
+}
+
+
+// Count the significant neighbors of a coefficient.  In vertically causal mode, the row
+// below the last row of a stripe is ignored.
+static void CountSignificantNeighbors( J2K_CODE_BLOCK_DECODER *pBlockDecoder, long x, long y,
+										long *pnHorizontal, long *pnVertical, long *pnDiagonal )
+{
+	unsigned char		*pFlags;
+	long				RowLength;
+	BOOL				bIgnoreRowBelow;
+
+	RowLength = pBlockDecoder -> FlagRowLength;
+	pFlags = &pBlockDecoder -> pFlags[ ( y + 1 ) * RowLength + x + 1 ];
+	bIgnoreRowBelow = ( pBlockDecoder -> bVerticallyCausal && ( y & 3 ) == 3 );
+	*pnHorizontal = ( pFlags[ -1 ] & COEFFICIENT_SIGNIFICANT ) + ( pFlags[ 1 ] & COEFFICIENT_SIGNIFICANT );
+	*pnVertical = ( pFlags[ -RowLength ] & COEFFICIENT_SIGNIFICANT );
+	*pnDiagonal = ( pFlags[ -RowLength - 1 ] & COEFFICIENT_SIGNIFICANT ) + ( pFlags[ -RowLength + 1 ] & COEFFICIENT_SIGNIFICANT );
+	if ( !bIgnoreRowBelow )
+		{
+		*pnVertical += ( pFlags[ RowLength ] & COEFFICIENT_SIGNIFICANT );
+		*pnDiagonal += ( pFlags[ RowLength - 1 ] & COEFFICIENT_SIGNIFICANT ) + ( pFlags[ RowLength + 1 ] & COEFFICIENT_SIGNIFICANT );
+		}
+}
+
+
+// Select the zero coding context from the significance of the neighbors, Table D.1.
+static long ZeroCodingContext( J2K_CODE_BLOCK_DECODER *pBlockDecoder, long x, long y )
+{
+	long				nHorizontal;
+	long				nVertical;
+	long				nDiagonal;
+	long				nSwap;
+	long				nContext;
+
+	CountSignificantNeighbors( pBlockDecoder, x, y, &nHorizontal, &nVertical, &nDiagonal );
+	if ( pBlockDecoder -> Orientation == J2K_ORIENTATION_HL )
+		{
+		nSwap = nHorizontal;
+		nHorizontal = nVertical;
+		nVertical = nSwap;
+		}
+	if ( pBlockDecoder -> Orientation == J2K_ORIENTATION_HH )
+		{
+		nHorizontal += nVertical;
+		if ( nDiagonal >= 3 )
+			nContext = 8;
+		else if ( nDiagonal == 2 )
+			nContext = ( nHorizontal >= 1 ) ? 7 : 6;
+		else if ( nDiagonal == 1 )
+			nContext = ( nHorizontal >= 2 ) ? 5 : ( ( nHorizontal == 1 ) ? 4 : 3 );
+		else
+			nContext = ( nHorizontal >= 2 ) ? 2 : nHorizontal;
+		}
+	else
+		{
+		if ( nHorizontal == 2 )
+			nContext = 8;
+		else if ( nHorizontal == 1 )
+			nContext = ( nVertical >= 1 ) ? 7 : ( ( nDiagonal >= 1 ) ? 6 : 5 );
+		else if ( nVertical > 0 )
+			nContext = 2 + nVertical;
+		else
+			nContext = ( nDiagonal >= 2 ) ? 2 : nDiagonal;
+		}
+
+	return J2K_CONTEXT_ZERO_CODING + nContext;
+}
+
+
+// Decode the sign of a newly significant coefficient, Tables D.2 and D.3.
+static void DecodeCoefficientSign( J2K_CODE_BLOCK_DECODER *pBlockDecoder, long x, long y )
+{
+	unsigned char		*pFlags;
+	long				RowLength;
+	long				HorizontalContribution;
+	long				VerticalContribution;
+	long				nContext;
+	unsigned long		XORBit;
+	unsigned long		SignBit;
+
+	RowLength = pBlockDecoder -> FlagRowLength;
+	pFlags = &pBlockDecoder -> pFlags[ ( y + 1 ) * RowLength + x + 1 ];
+	HorizontalContribution = SIGN_CONTRIBUTION( pFlags[ -1 ] ) + SIGN_CONTRIBUTION( pFlags[ 1 ] );
+	VerticalContribution = SIGN_CONTRIBUTION( pFlags[ -RowLength ] );
+	if ( !( pBlockDecoder -> bVerticallyCausal && ( y & 3 ) == 3 ) )
+		VerticalContribution += SIGN_CONTRIBUTION( pFlags[ RowLength ] );
+	HorizontalContribution = ( HorizontalContribution > 1 ) ? 1 : ( ( HorizontalContribution < -1 ) ? -1 : HorizontalContribution );
+	VerticalContribution = ( VerticalContribution > 1 ) ? 1 : ( ( VerticalContribution < -1 ) ? -1 : VerticalContribution );
+	XORBit = 0;
+	if ( HorizontalContribution < 0 || ( HorizontalContribution == 0 && VerticalContribution < 0 ) )
+		{
+		XORBit = 1;
+		HorizontalContribution = -HorizontalContribution;
+		VerticalContribution = -VerticalContribution;
+		}
+	if ( HorizontalContribution == 0 )
+		nContext = ( VerticalContribution == 0 ) ? 0 : 1;
+	else
+		nContext = 3 + VerticalContribution;
+	SignBit = DecodeArithmeticDecision( &pBlockDecoder -> ArithmeticDecoder, J2K_CONTEXT_SIGN_CODING + nContext ) ^ XORBit;
+	pFlags[ 0 ] |= COEFFICIENT_SIGNIFICANT;
+	if ( SignBit )
+		pFlags[ 0 ] |= COEFFICIENT_NEGATIVE;
+}
+
+
+static void SignificancePropagationPass( J2K_CODE_BLOCK_DECODER *pBlockDecoder, long BitPlane )
+{
+	unsigned char		*pFlags;
+	long				x;
+	long				y;
+	long				nStripeRow;
+	long				nHorizontal;
+	long				nVertical;
+	long				nDiagonal;
+
+	for ( nStripeRow = 0; nStripeRow < pBlockDecoder -> Height; nStripeRow += 4 )
+		for ( x = 0; x < pBlockDecoder -> Width; x++ )
+			for ( y = nStripeRow; y < nStripeRow + 4 && y < pBlockDecoder -> Height; y++ )
+				{
+				pFlags = &pBlockDecoder -> pFlags[ ( y + 1 ) * pBlockDecoder -> FlagRowLength + x + 1 ];
+				if ( ( *pFlags & COEFFICIENT_SIGNIFICANT ) == 0 )
+					{
+					CountSignificantNeighbors( pBlockDecoder, x, y, &nHorizontal, &nVertical, &nDiagonal );
+					if ( nHorizontal + nVertical + nDiagonal > 0 )
+						{
+						if ( DecodeArithmeticDecision( &pBlockDecoder -> ArithmeticDecoder, ZeroCodingContext( pBlockDecoder, x, y ) ) )
+							{
+							DecodeCoefficientSign( pBlockDecoder, x, y );
+							pBlockDecoder -> pMagnitude[ y * pBlockDecoder -> Width + x ] |= 1L << BitPlane;
+							}
+						*pFlags |= COEFFICIENT_VISITED;
+						}
+					}
+				}
+}
+
+
+static void MagnitudeRefinementPass( J2K_CODE_BLOCK_DECODER *pBlockDecoder, long BitPlane )
+{
+	unsigned char		*pFlags;
+	long				x;
+	long				y;
+	long				nStripeRow;
+	long				nHorizontal;
+	long				nVertical;
+	long				nDiagonal;
+	long				nContext;
+
+	for ( nStripeRow = 0; nStripeRow < pBlockDecoder -> Height; nStripeRow += 4 )
+		for ( x = 0; x < pBlockDecoder -> Width; x++ )
+			for ( y = nStripeRow; y < nStripeRow + 4 && y < pBlockDecoder -> Height; y++ )
+				{
+				pFlags = &pBlockDecoder -> pFlags[ ( y + 1 ) * pBlockDecoder -> FlagRowLength + x + 1 ];
+				if ( ( *pFlags & ( COEFFICIENT_SIGNIFICANT | COEFFICIENT_VISITED ) ) == COEFFICIENT_SIGNIFICANT )
+					{
+					if ( *pFlags & COEFFICIENT_REFINED )
+						nContext = J2K_CONTEXT_MAGNITUDE + 2;
+					else
+						{
+						CountSignificantNeighbors( pBlockDecoder, x, y, &nHorizontal, &nVertical, &nDiagonal );
+						nContext = J2K_CONTEXT_MAGNITUDE + ( ( nHorizontal + nVertical + nDiagonal > 0 ) ? 1 : 0 );
+						}
+					if ( DecodeArithmeticDecision( &pBlockDecoder -> ArithmeticDecoder, nContext ) )
+						pBlockDecoder -> pMagnitude[ y * pBlockDecoder -> Width + x ] |= 1L << BitPlane;
+					*pFlags |= COEFFICIENT_REFINED;
+					}
+				}
+}
+
+
+static void CleanupPass( J2K_CODE_BLOCK_DECODER *pBlockDecoder, long BitPlane, BOOL bSegmentationSymbolsUsed )
+{
+	J2K_ARITHMETIC_DECODER	*pDecoder;
+	unsigned char			*pFlags;
+	long					x;
+	long					y;
+	long					nStripeRow;
+	long					nHorizontal;
+	long					nVertical;
+	long					nDiagonal;
+	BOOL					bRunLengthCoding;
+	BOOL					bCodeNextCoefficient;
+
+	pDecoder = &pBlockDecoder -> ArithmeticDecoder;
+	for ( nStripeRow = 0; nStripeRow < pBlockDecoder -> Height; nStripeRow += 4 )
+		for ( x = 0; x < pBlockDecoder -> Width; x++ )
+			{
+			// Run-length coding is used for a full stripe column of insignificant coefficients,
+			// none of which has a significant neighbor.
+			bRunLengthCoding = ( nStripeRow + 4 <= pBlockDecoder -> Height );
+			for ( y = nStripeRow; y < nStripeRow + 4 && bRunLengthCoding; y++ )
+				{
+				pFlags = &pBlockDecoder -> pFlags[ ( y + 1 ) * pBlockDecoder -> FlagRowLength + x + 1 ];
+				CountSignificantNeighbors( pBlockDecoder, x, y, &nHorizontal, &nVertical, &nDiagonal );
+				bRunLengthCoding = ( ( *pFlags & ( COEFFICIENT_SIGNIFICANT | COEFFICIENT_VISITED ) ) == 0 &&
+										nHorizontal + nVertical + nDiagonal == 0 );
+				}
+			y = nStripeRow;
+			bCodeNextCoefficient = TRUE;
+			if ( bRunLengthCoding )
+				{
+				if ( DecodeArithmeticDecision( pDecoder, J2K_CONTEXT_RUN_LENGTH ) == 0 )
+					bCodeNextCoefficient = FALSE;
+				else
+					{
+					// The position of the first significant coefficient in the column follows.
+					y += (long)DecodeArithmeticDecision( pDecoder, J2K_CONTEXT_UNIFORM ) << 1;
+					y += (long)DecodeArithmeticDecision( pDecoder, J2K_CONTEXT_UNIFORM );
+					DecodeCoefficientSign( pBlockDecoder, x, y );
+					pBlockDecoder -> pMagnitude[ y * pBlockDecoder -> Width + x ] |= 1L << BitPlane;
+					y++;
+					}
+				}
+			for ( ; bCodeNextCoefficient && y < nStripeRow + 4 && y < pBlockDecoder -> Height; y++ )
+				{
+				pFlags = &pBlockDecoder -> pFlags[ ( y + 1 ) * pBlockDecoder -> FlagRowLength + x + 1 ];
+				if ( ( *pFlags & ( COEFFICIENT_SIGNIFICANT | COEFFICIENT_VISITED ) ) == 0 )
+					{
+					if ( DecodeArithmeticDecision( pDecoder, ZeroCodingContext( pBlockDecoder, x, y ) ) )
+						{
+						DecodeCoefficientSign( pBlockDecoder, x, y );
+						pBlockDecoder -> pMagnitude[ y * pBlockDecoder -> Width + x ] |= 1L << BitPlane;
+						}
+					}
+				}
+			}
+	// Clear the visited flags for the next bit plane.
+	for ( y = 0; y < pBlockDecoder -> Height; y++ )
+		for ( x = 0; x < pBlockDecoder -> Width; x++ )
+			pBlockDecoder -> pFlags[ ( y + 1 ) * pBlockDecoder -> FlagRowLength + x + 1 ] &= ~COEFFICIENT_VISITED;
+	// The segmentation symbol is 1010, decoded in the uniform context.
+	if ( bSegmentationSymbolsUsed )
+		{
+		DecodeArithmeticDecision( pDecoder, J2K_CONTEXT_UNIFORM );
+		DecodeArithmeticDecision( pDecoder, J2K_CONTEXT_UNIFORM );
+		DecodeArithmeticDecision( pDecoder, J2K_CONTEXT_UNIFORM );
+		DecodeArithmeticDecision( pDecoder, J2K_CONTEXT_UNIFORM );
+		}
+}
+
+
+// Decode the coding passes of a code-block and store the coefficients into the tile buffer.
+static BOOL DecodeCodeBlock( J2K_CODE_BLOCK *pCodeBlock, J2K_SUBBAND *pSubband, long CodeBlockStyle,
+								long *pTileBuffer, long TileBufferWidth )
+{
+	BOOL						bNoError = TRUE;
+	J2K_CODE_BLOCK_DECODER		BlockDecoder;
+	unsigned char				EmptyCodedData[ 2 ];
+	long						nCodedBitPlanes;
+	long						BitPlane;
+	long						nPass;
+	long						PassType;
+	long						x;
+	long						y;
+	long						*pCoefficient;
+	long						Magnitude;
+	long						ReconstructionOffset;
+
+	ReconstructionOffset = 0;
+	BlockDecoder.Width = pCodeBlock -> X1 - pCodeBlock -> X0;
+	BlockDecoder.Height = pCodeBlock -> Y1 - pCodeBlock -> Y0;
+	BlockDecoder.FlagRowLength = BlockDecoder.Width + 2;
+	BlockDecoder.Orientation = pSubband -> Orientation;
+	BlockDecoder.bVerticallyCausal = ( ( CodeBlockStyle & J2K_CODE_BLOCK_VERTICAL_CAUSAL ) != 0 );
+	BlockDecoder.pFlags = (unsigned char*)calloc( BlockDecoder.FlagRowLength * ( BlockDecoder.Height + 2 ), 1 );
+	BlockDecoder.pMagnitude = (long*)calloc( BlockDecoder.Width * BlockDecoder.Height, sizeof(long) );
+	if ( BlockDecoder.pFlags == 0 || BlockDecoder.pMagnitude == 0 )
+		{
+		RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+		bNoError = FALSE;
+		}
+	if ( bNoError && pCodeBlock -> nCodingPasses > 0 )
+		{
+		nCodedBitPlanes = pSubband -> nMagnitudeBitPlanes - pCodeBlock -> nZeroBitPlanes;
+		bNoError = ( nCodedBitPlanes > 0 && nCodedBitPlanes <= J2K_MAX_MAGNITUDE_BIT_PLANES &&
+						pCodeBlock -> nCodingPasses <= 3 * nCodedBitPlanes - 2 );
+		if ( bNoError )
+			{
+			if ( pCodeBlock -> pCodedData != 0 )
+				{
+				pCodeBlock -> pCodedData[ pCodeBlock -> CodedDataLength ] = 0xFF;
+				pCodeBlock -> pCodedData[ pCodeBlock -> CodedDataLength + 1 ] = 0xFF;
+				InitializeArithmeticDecoder( &BlockDecoder.ArithmeticDecoder, pCodeBlock -> pCodedData );
+				}
+			else
+				{
+				EmptyCodedData[ 0 ] = 0xFF;
+				EmptyCodedData[ 1 ] = 0xFF;
+				InitializeArithmeticDecoder( &BlockDecoder.ArithmeticDecoder, EmptyCodedData );
+				}
+			ResetArithmeticContexts( &BlockDecoder.ArithmeticDecoder );
+			// The first pass is a cleanup pass.  Each following bit plane has significance
+			// propagation, magnitude refinement and cleanup passes.
+			BitPlane = nCodedBitPlanes - 1;
+			PassType = 2;
+			for ( nPass = 0; nPass < pCodeBlock -> nCodingPasses; nPass++ )
+				{
+				if ( PassType == 0 )
+					SignificancePropagationPass( &BlockDecoder, BitPlane );
+				else if ( PassType == 1 )
+					MagnitudeRefinementPass( &BlockDecoder, BitPlane );
+				else
+					CleanupPass( &BlockDecoder, BitPlane, ( CodeBlockStyle & J2K_CODE_BLOCK_SEGMENT_SYMBOLS ) != 0 );
+				if ( CodeBlockStyle & J2K_CODE_BLOCK_RESET )
+					ResetArithmeticContexts( &BlockDecoder.ArithmeticDecoder );
+				if ( ++PassType == 3 )
+					{
+					PassType = 0;
+					BitPlane--;
+					}
+				}
+			// If the code-block was truncated before its least significant bit plane, as in a
+			// lossy image, reconstruct the significant coefficients at the middle of the
+			// remaining uncertainty interval.
+			if ( BitPlane >= 0 )
+				ReconstructionOffset = 1L << BitPlane;
+			}
+		else
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_CORRUPTION );
+		}
+	if ( bNoError )
+		{
+		for ( y = 0; y < BlockDecoder.Height; y++ )
+			{
+			pCoefficient = &pTileBuffer[ ( pSubband -> TileBufferY + pCodeBlock -> Y0 - pSubband -> Y0 + y ) * TileBufferWidth +
+											pSubband -> TileBufferX + pCodeBlock -> X0 - pSubband -> X0 ];
+			for ( x = 0; x < BlockDecoder.Width; x++ )
+				{
+				Magnitude = BlockDecoder.pMagnitude[ y * BlockDecoder.Width + x ];
+				if ( Magnitude != 0 )
+					Magnitude += ReconstructionOffset;
+				if ( BlockDecoder.pFlags[ ( y + 1 ) * BlockDecoder.FlagRowLength + x + 1 ] & COEFFICIENT_NEGATIVE )
+					pCoefficient[ x ] = -Magnitude;
+				else
+					pCoefficient[ x ] = Magnitude;
+				}
+			}
+		}
+	if ( BlockDecoder.pFlags != 0 )
+		free( BlockDecoder.pFlags );
+	if ( BlockDecoder.pMagnitude != 0 )
+		free( BlockDecoder.pMagnitude );
+
+	return bNoError;
+}
+
+
+//___________________________________________________________________________
+//
+// Inverse discrete wavelet transform, Annex F.
+//
+
+// Perform the reversible 5/3 inverse lifting on one row or column.  The low-pass coefficients
+// are followed by the high-pass coefficients in pSamples.  FirstIndex is the tile-component
+// coordinate of the first sample, whose parity determines the interleaving.
+static void InverseReversibleLifting( long *pSamples, long nSamples, long SampleSpacing, long FirstIndex, long *pWorkBuffer )
+{
+	long				*pX;
+	long				nLowPass;
+	long				nSample;
+	long				nLow;
+	long				nHigh;
+	long				nFirstOdd;
+
+	if ( nSamples == 1 )
+		{
+		// A single high-pass sample was doubled by the forward transform.
+		if ( FirstIndex & 1 )
+			pSamples[ 0 ] /= 2;
+		}
+	else if ( nSamples > 1 )
+		{
+		// Interleave the low- and high-pass samples, leaving room for the symmetric extension.
+		pX = pWorkBuffer + 2;
+		nFirstOdd = FirstIndex & 1;
+		nLowPass = ( nSamples + 1 - nFirstOdd ) / 2;
+		nLow = 0;
+		nHigh = nLowPass;
+		for ( nSample = 0; nSample < nSamples; nSample++ )
+			{
+			if ( ( ( nSample + nFirstOdd ) & 1 ) == 0 )
+				pX[ nSample ] = pSamples[ ( nLow++ ) * SampleSpacing ];
+			else
+				pX[ nSample ] = pSamples[ ( nHigh++ ) * SampleSpacing ];
+			}
+		pX[ -1 ] = pX[ 1 ];
+		pX[ -2 ] = pX[ ( nSamples > 2 ) ? 2 : 0 ];
+		pX[ nSamples ] = pX[ nSamples - 2 ];
+		pX[ nSamples + 1 ] = pX[ ( nSamples > 2 ) ? nSamples - 3 : nSamples - 1 ];
+		// Update the even samples, then predict the odd samples, F.3.8.2.
+		for ( nSample = ( nFirstOdd ? -1 : 0 ); nSample <= nSamples; nSample += 2 )
+			pX[ nSample ] -= ( pX[ nSample - 1 ] + pX[ nSample + 1 ] + 2 ) >> 2;
+		for ( nSample = ( nFirstOdd ? 0 : 1 ); nSample < nSamples; nSample += 2 )
+			pX[ nSample ] += ( pX[ nSample - 1 ] + pX[ nSample + 1 ] ) >> 1;
+		for ( nSample = 0; nSample < nSamples; nSample++ )
+			pSamples[ nSample * SampleSpacing ] = pX[ nSample ];
+		}
+}
+
+
+static BOOL InverseWaveletTransform( J2K_RESOLUTION *pResolutions, long nDecompositionLevels, long *pTileBuffer, long TileBufferWidth )
+{
+	BOOL				bNoError = TRUE;
+	long				*pWorkBuffer;
+	long				nResolution;
+	long				Width;
+	long				Height;
+	long				nRow;
+	long				nColumn;
+
+	pWorkBuffer = (long*)malloc( ( J2K_MAX_IMAGE_DIMENSION + 4 ) * sizeof(long) );
+	if ( pWorkBuffer == 0 )
+		{
+		RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+		bNoError = FALSE;
+		}
+	for ( nResolution = 1; nResolution <= nDecompositionLevels && bNoError; nResolution++ )
+		{
+		Width = pResolutions[ nResolution ].X1 - pResolutions[ nResolution ].X0;
+		Height = pResolutions[ nResolution ].Y1 - pResolutions[ nResolution ].Y0;
+		// Horizontal, then vertical, synthesis.
+		for ( nRow = 0; nRow < Height; nRow++ )
+			InverseReversibleLifting( &pTileBuffer[ nRow * TileBufferWidth ], Width, 1, pResolutions[ nResolution ].X0, pWorkBuffer );
+		for ( nColumn = 0; nColumn < Width; nColumn++ )
+			InverseReversibleLifting( &pTileBuffer[ nColumn ], Height, TileBufferWidth, pResolutions[ nResolution ].Y0, pWorkBuffer );
+		}
+	if ( pWorkBuffer != 0 )
+		free( pWorkBuffer );
+
+	return bNoError;
+}
+
+
+//___________________________________________________________________________
+//
+// Tile decoding.
+//
+
+static void DeleteTileStructure( J2K_RESOLUTION *pResolutions, long nResolutions )
+{
+	J2K_SUBBAND			*pSubband;
+	long				nResolution;
+	long				nSubband;
+	long				nCodeBlock;
+
+	for ( nResolution = 0; nResolution < nResolutions; nResolution++ )
+		for ( nSubband = 0; nSubband < pResolutions[ nResolution ].nSubbands; nSubband++ )
+			{
+			pSubband = &pResolutions[ nResolution ].Subband[ nSubband ];
+			if ( pSubband -> pCodeBlocks != 0 )
+				{
+				for ( nCodeBlock = 0; nCodeBlock < pSubband -> nCodeBlocksWide * pSubband -> nCodeBlocksHigh; nCodeBlock++ )
+					if ( pSubband -> pCodeBlocks[ nCodeBlock ].pCodedData != 0 )
+						free( pSubband -> pCodeBlocks[ nCodeBlock ].pCodedData );
+				free( pSubband -> pCodeBlocks );
+				}
+			if ( pSubband -> InclusionTree.pNodes != 0 )
+				free( pSubband -> InclusionTree.pNodes );
+			if ( pSubband -> ZeroBitPlaneTree.pNodes != 0 )
+				free( pSubband -> ZeroBitPlaneTree.pNodes );
+			}
+}
+
+
+// Lay out the resolution levels, subbands and code-blocks of a tile, B.5 - B.7.
+static BOOL CreateTileStructure( long TileX0, long TileY0, long TileX1, long TileY1, J2K_CODING_PARAMETERS *pCodingParameters,
+									long nGuardBits, J2K_RESOLUTION *pResolutions, BOOL *pbIsSupported )
+{
+	BOOL				bNoError = TRUE;
+	J2K_RESOLUTION		*pResolution;
+	J2K_SUBBAND			*pSubband;
+	J2K_CODE_BLOCK		*pCodeBlock;
+	long				nDecompositionLevels;
+	long				nResolution;
+	long				nSubband;
+	long				nLevel;
+	long				Scale;
+	long				XOffset;
+	long				YOffset;
+	long				CodeBlockWidthExponent;
+	long				CodeBlockHeightExponent;
+	long				PrecinctWidth;
+	long				PrecinctHeight;
+	long				FirstBlockColumn;
+	long				FirstBlockRow;
+	long				nCodeBlockColumn;
+	long				nCodeBlockRow;
+
+	*pbIsSupported = TRUE;
+	nDecompositionLevels = pCodingParameters -> nDecompositionLevels;
+	for ( nResolution = 0; nResolution <= nDecompositionLevels && bNoError && *pbIsSupported; nResolution++ )
+		{
+		pResolution = &pResolutions[ nResolution ];
+		Scale = 1L << ( nDecompositionLevels - nResolution );
+		pResolution -> X0 = CeilingOfQuotient( TileX0, Scale );
+		pResolution -> Y0 = CeilingOfQuotient( TileY0, Scale );
+		pResolution -> X1 = CeilingOfQuotient( TileX1, Scale );
+		pResolution -> Y1 = CeilingOfQuotient( TileY1, Scale );
+		// Only one precinct per resolution level is supported.
+		PrecinctWidth = 1L << pCodingParameters -> PrecinctWidthExponent[ nResolution ];
+		PrecinctHeight = 1L << pCodingParameters -> PrecinctHeightExponent[ nResolution ];
+		if ( pResolution -> X1 > pResolution -> X0 && pResolution -> Y1 > pResolution -> Y0 )
+			*pbIsSupported = ( ( pResolution -> X1 - 1 ) / PrecinctWidth == pResolution -> X0 / PrecinctWidth &&
+								( pResolution -> Y1 - 1 ) / PrecinctHeight == pResolution -> Y0 / PrecinctHeight );
+		// The code-blocks may not be larger than the precincts.
+		CodeBlockWidthExponent = pCodingParameters -> CodeBlockWidthExponent;
+		CodeBlockHeightExponent = pCodingParameters -> CodeBlockHeightExponent;
+		if ( nResolution > 0 )
+			{
+			if ( CodeBlockWidthExponent > pCodingParameters -> PrecinctWidthExponent[ nResolution ] - 1 )
+				CodeBlockWidthExponent = pCodingParameters -> PrecinctWidthExponent[ nResolution ] - 1;
+			if ( CodeBlockHeightExponent > pCodingParameters -> PrecinctHeightExponent[ nResolution ] - 1 )
+				CodeBlockHeightExponent = pCodingParameters -> PrecinctHeightExponent[ nResolution ] - 1;
+			}
+		else
+			{
+			if ( CodeBlockWidthExponent > pCodingParameters -> PrecinctWidthExponent[ 0 ] )
+				CodeBlockWidthExponent = pCodingParameters -> PrecinctWidthExponent[ 0 ];
+			if ( CodeBlockHeightExponent > pCodingParameters -> PrecinctHeightExponent[ 0 ] )
+				CodeBlockHeightExponent = pCodingParameters -> PrecinctHeightExponent[ 0 ];
+			}
+		if ( CodeBlockWidthExponent < 0 || CodeBlockHeightExponent < 0 )
+			*pbIsSupported = FALSE;
+		pResolution -> nSubbands = ( nResolution == 0 ) ? 1 : 3;
+		for ( nSubband = 0; nSubband < pResolution -> nSubbands && bNoError && *pbIsSupported; nSubband++ )
+			{
+			pSubband = &pResolution -> Subband[ nSubband ];
+			if ( nResolution == 0 )
+				{
+				pSubband -> Orientation = J2K_ORIENTATION_LL;
+				nLevel = nDecompositionLevels;
+				pSubband -> X0 = pResolution -> X0;
+				pSubband -> Y0 = pResolution -> Y0;
+				pSubband -> X1 = pResolution -> X1;
+				pSubband -> Y1 = pResolution -> Y1;
+				pSubband -> TileBufferX = 0;
+				pSubband -> TileBufferY = 0;
+				pSubband -> nMagnitudeBitPlanes = nGuardBits + pCodingParameters -> SubbandExponent[ 0 ] - 1;
+				}
+			else
+				{
+				pSubband -> Orientation = J2K_ORIENTATION_HL + nSubband;
+				nLevel = nDecompositionLevels - nResolution + 1;
+				Scale = 1L << nLevel;
+				XOffset = ( pSubband -> Orientation == J2K_ORIENTATION_LH ) ? 0 : Scale / 2;
+				YOffset = ( pSubband -> Orientation == J2K_ORIENTATION_HL ) ? 0 : Scale / 2;
+				pSubband -> X0 = CeilingOfQuotient( TileX0 - XOffset, Scale );
+				pSubband -> Y0 = CeilingOfQuotient( TileY0 - YOffset, Scale );
+				pSubband -> X1 = CeilingOfQuotient( TileX1 - XOffset, Scale );
+				pSubband -> Y1 = CeilingOfQuotient( TileY1 - YOffset, Scale );
+				// In the tile buffer, the high-pass coefficients follow the low-pass coefficients
+				// of the next lower resolution level.
+				pSubband -> TileBufferX = ( XOffset == 0 ) ? 0 : pResolutions[ nResolution - 1 ].X1 - pResolutions[ nResolution - 1 ].X0;
+				pSubband -> TileBufferY = ( YOffset == 0 ) ? 0 : pResolutions[ nResolution - 1 ].Y1 - pResolutions[ nResolution - 1 ].Y0;
+				// Reversible transform subbands gain one bit for HL and LH, and two bits for HH, E.1.1.
+				pSubband -> nMagnitudeBitPlanes = nGuardBits + pCodingParameters -> SubbandExponent[ 1 + 3 * ( nResolution - 1 ) + nSubband ] - 1;
+				}
+			if ( pSubband -> X1 > pSubband -> X0 && pSubband -> Y1 > pSubband -> Y0 )
+				{
+				FirstBlockColumn = pSubband -> X0 >> CodeBlockWidthExponent;
+				FirstBlockRow = pSubband -> Y0 >> CodeBlockHeightExponent;
+				pSubband -> nCodeBlocksWide = CeilingOfQuotient( pSubband -> X1, 1L << CodeBlockWidthExponent ) - FirstBlockColumn;
+				pSubband -> nCodeBlocksHigh = CeilingOfQuotient( pSubband -> Y1, 1L << CodeBlockHeightExponent ) - FirstBlockRow;
+				pSubband -> pCodeBlocks = (J2K_CODE_BLOCK*)calloc( pSubband -> nCodeBlocksWide * pSubband -> nCodeBlocksHigh, sizeof(J2K_CODE_BLOCK) );
+				if ( pSubband -> pCodeBlocks == 0 )
+					{
+					RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+					bNoError = FALSE;
+					}
+				else
+					{
+					for ( nCodeBlockRow = 0; nCodeBlockRow < pSubband -> nCodeBlocksHigh; nCodeBlockRow++ )
+						for ( nCodeBlockColumn = 0; nCodeBlockColumn < pSubband -> nCodeBlocksWide; nCodeBlockColumn++ )
+							{
+							pCodeBlock = &pSubband -> pCodeBlocks[ nCodeBlockRow * pSubband -> nCodeBlocksWide + nCodeBlockColumn ];
+							pCodeBlock -> X0 = ( FirstBlockColumn + nCodeBlockColumn ) << CodeBlockWidthExponent;
+							pCodeBlock -> Y0 = ( FirstBlockRow + nCodeBlockRow ) << CodeBlockHeightExponent;
+							pCodeBlock -> X1 = pCodeBlock -> X0 + ( 1L << CodeBlockWidthExponent );
+							pCodeBlock -> Y1 = pCodeBlock -> Y0 + ( 1L << CodeBlockHeightExponent );
+							if ( pCodeBlock -> X0 < pSubband -> X0 )
+								pCodeBlock -> X0 = pSubband -> X0;
+							if ( pCodeBlock -> Y0 < pSubband -> Y0 )
+								pCodeBlock -> Y0 = pSubband -> Y0;
+							if ( pCodeBlock -> X1 > pSubband -> X1 )
+								pCodeBlock -> X1 = pSubband -> X1;
+							if ( pCodeBlock -> Y1 > pSubband -> Y1 )
+								pCodeBlock -> Y1 = pSubband -> Y1;
+							pCodeBlock -> LengthBitCount = 3;
+							}
+					bNoError = CreateTagTree( &pSubband -> InclusionTree, pSubband -> nCodeBlocksWide, pSubband -> nCodeBlocksHigh ) &&
+								CreateTagTree( &pSubband -> ZeroBitPlaneTree, pSubband -> nCodeBlocksWide, pSubband -> nCodeBlocksHigh );
+					}
+				}
+			}
+		}
+
+	return bNoError;
+}
+
+
+// Decode a tile and copy its samples into the output image buffer.
+static BOOL DecodeJpeg2000Tile( J2K_IMAGE *pImage, long nTile, J2K_TILE_DATA *pTileData,
+									unsigned char *pOutputImage, long BytesPerSample, BOOL *pbIsSupported )
+{
+	BOOL					bNoError = TRUE;
+	J2K_CODING_PARAMETERS	CodingParameters;
+	J2K_RESOLUTION			Resolutions[ J2K_MAX_DECOMPOSITION_LEVELS + 1 ];
+	J2K_RESOLUTION			*pResolution;
+	J2K_SUBBAND				*pSubband;
+	unsigned char			*pNextByte;
+	unsigned char			*pEndOfData;
+	long					*pTileBuffer;
+	long					TileX0;
+	long					TileY0;
+	long					TileX1;
+	long					TileY1;
+	long					TileBufferWidth;
+	unsigned __int64		TileBufferSize;
+	long					nResolutions;
+	long					nResolution;
+	long					nLayer;
+	long					nSubband;
+	long					nCodeBlock;
+	long					nOuterLoop;
+	long					nInnerLoop;
+	long					ImageWidth;
+	long					x;
+	long					y;
+	long					Sample;
+	long					MaxSampleValue;
+	long					MinSampleValue;
+	long					DCLevelShift;
+	long					OutputIndex;
+
+	*pbIsSupported = TRUE;
+	pTileBuffer = 0;
+	memset( Resolutions, 0, sizeof(Resolutions) );
+	// Apply any coding parameters specified for this tile.
+	memcpy( &CodingParameters, &pImage -> CodingParameters, sizeof(J2K_CODING_PARAMETERS) );
+	*pbIsSupported = ApplyHeaderSegments( &pTileData -> HeaderSegments, &CodingParameters ) && CodingParametersAreSupported( &CodingParameters );
+	nResolutions = CodingParameters.nDecompositionLevels + 1;
+	TileX0 = pImage -> TileX0 + ( nTile % pImage -> nTilesWide ) * pImage -> TileWidth;
+	TileY0 = pImage -> TileY0 + ( nTile / pImage -> nTilesWide ) * pImage -> TileHeight;
+	TileX1 = TileX0 + pImage -> TileWidth;
+	TileY1 = TileY0 + pImage -> TileHeight;
+	if ( TileX0 < pImage -> ImageX0 )
+		TileX0 = pImage -> ImageX0;
+	if ( TileY0 < pImage -> ImageY0 )
+		TileY0 = pImage -> ImageY0;
+	if ( TileX1 > pImage -> ImageX1 )
+		TileX1 = pImage -> ImageX1;
+	if ( TileY1 > pImage -> ImageY1 )
+		TileY1 = pImage -> ImageY1;
+	if ( *pbIsSupported )
+		bNoError = CreateTileStructure( TileX0, TileY0, TileX1, TileY1, &CodingParameters, CodingParameters.nGuardBits, Resolutions, pbIsSupported );
+	if ( bNoError && *pbIsSupported )
+		{
+		TileBufferWidth = TileX1 - TileX0;
+		TileBufferSize = (unsigned __int64)TileBufferWidth * (unsigned __int64)( TileY1 - TileY0 ) * sizeof(long);
+		if ( TileBufferSize > J2K_MAX_DECODED_IMAGE_SIZE )
+			*pbIsSupported = FALSE;
+		else
+			pTileBuffer = (long*)calloc( (size_t)TileBufferSize, 1 );
+		if ( *pbIsSupported && pTileBuffer == 0 )
+			{
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+			bNoError = FALSE;
+			}
+		}
+	if ( bNoError && *pbIsSupported )
+		{
+		// Decode the packets.  With a single component and a single precinct per resolution level,
+		// the layer-resolution order is the only one in which the layer varies slowest.  The other
+		// progression orders all place the resolution level outermost.
+		pNextByte = pTileData -> pPacketData;
+		pEndOfData = pTileData -> pPacketData + pTileData -> PacketDataLength;
+		for ( nOuterLoop = 0; nOuterLoop < ( ( CodingParameters.ProgressionOrder == J2K_PROGRESSION_LRCP ) ?
+																CodingParameters.nLayers : nResolutions ) && bNoError; nOuterLoop++ )
+			for ( nInnerLoop = 0; nInnerLoop < ( ( CodingParameters.ProgressionOrder == J2K_PROGRESSION_LRCP ) ?
+																nResolutions : CodingParameters.nLayers ) && bNoError; nInnerLoop++ )
+				{
+				if ( CodingParameters.ProgressionOrder == J2K_PROGRESSION_LRCP )
+					{
+					nLayer = nOuterLoop;
+					nResolution = nInnerLoop;
+					}
+				else
+					{
+					nResolution = nOuterLoop;
+					nLayer = nInnerLoop;
+					}
+				pResolution = &Resolutions[ nResolution ];
+				// An empty resolution level has no precincts, and therefore no packets.
+				if ( pResolution -> X1 > pResolution -> X0 && pResolution -> Y1 > pResolution -> Y0 && pNextByte < pEndOfData )
+					{
+					bNoError = DecodePacket( pResolution, nLayer, &CodingParameters, &pNextByte, pEndOfData );
+					if ( !bNoError )
+						RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_CORRUPTION );
+					}
+				}
+		}
+	// Decode the code-blocks.
+	for ( nResolution = 0; nResolution < nResolutions && bNoError && *pbIsSupported; nResolution++ )
+		for ( nSubband = 0; nSubband < Resolutions[ nResolution ].nSubbands && bNoError; nSubband++ )
+			{
+			pSubband = &Resolutions[ nResolution ].Subband[ nSubband ];
+			for ( nCodeBlock = 0; nCodeBlock < pSubband -> nCodeBlocksWide * pSubband -> nCodeBlocksHigh && bNoError; nCodeBlock++ )
+				bNoError = DecodeCodeBlock( &pSubband -> pCodeBlocks[ nCodeBlock ], pSubband, CodingParameters.CodeBlockStyle,
+												pTileBuffer, TileBufferWidth );
+			}
+	if ( bNoError && *pbIsSupported )
+		bNoError = InverseWaveletTransform( Resolutions, CodingParameters.nDecompositionLevels, pTileBuffer, TileBufferWidth );
+	// Undo the DC level shift and copy the tile samples into the output image.
+	if ( bNoError && *pbIsSupported )
+		{
+		if ( pImage -> bSamplesAreSigned )
+			{
+			DCLevelShift = 0;
+			MinSampleValue = -( 1L << ( pImage -> BitDepth - 1 ) );
+			MaxSampleValue = ( 1L << ( pImage -> BitDepth - 1 ) ) - 1;
+			}
+		else
+			{
+			DCLevelShift = 1L << ( pImage -> BitDepth - 1 );
+			MinSampleValue = 0;
+			MaxSampleValue = ( 1L << pImage -> BitDepth ) - 1;
+			}
+		ImageWidth = pImage -> ImageX1 - pImage -> ImageX0;
+		for ( y = TileY0; y < TileY1; y++ )
+			for ( x = TileX0; x < TileX1; x++ )
+				{
+				Sample = pTileBuffer[ ( y - TileY0 ) * TileBufferWidth + x - TileX0 ] + DCLevelShift;
+				if ( Sample < MinSampleValue )
+					Sample = MinSampleValue;
+				else if ( Sample > MaxSampleValue )
+					Sample = MaxSampleValue;
+				OutputIndex = ( y - pImage -> ImageY0 ) * ImageWidth + x - pImage -> ImageX0;
+				if ( BytesPerSample == 1 )
+					pOutputImage[ OutputIndex ] = (unsigned char)Sample;
+				else
+					( (unsigned short*)pOutputImage )[ OutputIndex ] = (unsigned short)Sample;
+				}
+		}
+	DeleteTileStructure( Resolutions, nResolutions );
+	if ( pTileBuffer != 0 )
+		free( pTileBuffer );
+
+	return bNoError;
+}
+
+
+// Locate the JPEG 2000 codestream in the Dicom pixel data.  The codestream may be wrapped in
+// a JP2 file format, although Dicom calls for the bare codestream.
+static unsigned char *LocateJpeg2000Codestream( DICOM_HEADER_SUMMARY *pDicomHeader, unsigned long *pCodestreamLength )
+{
+	unsigned char		*pCodestream;
+	unsigned char		*pBox;
+	unsigned char		*pEndOfData;
+	unsigned long		BoxLength;
+
+	pCodestream = (unsigned char*)pDicomHeader -> pImageData;
+	*pCodestreamLength = pDicomHeader -> ImageLengthInBytes;
+	if ( pCodestream != 0 && *pCodestreamLength >= 12 && memcmp( &pCodestream[ 4 ], "jP  ", 4 ) == 0 )
+		{
+		pBox = pCodestream;
+		pEndOfData = pCodestream + *pCodestreamLength;
+		pCodestream = 0;
+		while ( pCodestream == 0 && pBox + 8 <= pEndOfData )
+			{
+			BoxLength = (unsigned long)ReadFourBytes( pBox );
+			if ( memcmp( &pBox[ 4 ], "jp2c", 4 ) == 0 )
+				{
+				pCodestream = pBox + 8;
+				if ( BoxLength >= 8 && BoxLength <= (unsigned long)( pEndOfData - pBox ) )
+					*pCodestreamLength = BoxLength - 8;
+				else
+					*pCodestreamLength = (unsigned long)( pEndOfData - pCodestream );
+				}
+			else if ( BoxLength < 8 )
+				pBox = pEndOfData;
+			else
+				pBox += BoxLength;
+			}
+		if ( pCodestream == 0 )
+			*pCodestreamLength = 0;
+		}
+
+	return pCodestream;
+}
+
+
+// The decoded image must have the dimensions declared by the Dicom Rows and Columns, and fit a
+// buffer of reasonable size.  The size is computed in 64 bits, since the product of the JPEG 2000
+// image dimensions can overflow an unsigned long.
+static BOOL Jpeg2000ImageMatchesDicomHeader( J2K_IMAGE *pImage, DICOM_HEADER_SUMMARY *pDicomHeader, unsigned long *pDecodedImageSize )
+{
+	BOOL				bMatches;
+	unsigned __int64	DecodedImageSize;
+	long				BytesPerSample;
+
+	*pDecodedImageSize = 0;
+	bMatches = ( pDicomHeader -> ImageColumns != 0 && pDicomHeader -> ImageRows != 0 && pDicomHeader -> BitsAllocated != 0 );
+	if ( bMatches )
+		bMatches = ( pImage -> ImageX1 - pImage -> ImageX0 == (long)*pDicomHeader -> ImageColumns &&
+						pImage -> ImageY1 - pImage -> ImageY0 == (long)*pDicomHeader -> ImageRows );
+	if ( bMatches )
+		{
+		BytesPerSample = ( *pDicomHeader -> BitsAllocated <= 8 ) ? 1 : 2;
+		DecodedImageSize = (unsigned __int64)( pImage -> ImageX1 - pImage -> ImageX0 ) *
+							(unsigned __int64)( pImage -> ImageY1 - pImage -> ImageY0 ) * (unsigned __int64)BytesPerSample;
+		bMatches = ( DecodedImageSize <= J2K_MAX_DECODED_IMAGE_SIZE );
+		if ( bMatches )
+			*pDecodedImageSize = (unsigned long)DecodedImageSize;
+		}
+	if ( !bMatches )
+		LogMessage( "The JPEG 2000 image dimensions don't match the Dicom image rows and columns.", MESSAGE_TYPE_ERROR );
+
+	return bMatches;
+}
+
+
+// Return TRUE if the JPEG 2000 image in the Dicom pixel data can be decoded here.
+BOOL Jpeg2000ImageCanBeDecoded( DICOM_HEADER_SUMMARY *pDicomHeader )
+{
+	BOOL				bIsSupported;
+	J2K_IMAGE			Image;
+	unsigned char		*pCodestream;
+	unsigned long		CodestreamLength;
+	unsigned long		DecodedImageSize;
+
+	pCodestream = LocateJpeg2000Codestream( pDicomHeader, &CodestreamLength );
+	bIsSupported = ParseJpeg2000MainHeader( pCodestream, CodestreamLength, &Image );
+	if ( bIsSupported )
+		bIsSupported = Jpeg2000ImageMatchesDicomHeader( &Image, pDicomHeader, &DecodedImageSize );
+
+	return bIsSupported;
+}
+
+
+// Decode the JPEG 2000 image into the uncompressed pixel layout, with 8- or 16-bit samples,
+// as allocated in the Dicom header, and convert that to the PNG file.
+BOOL ConvertJpeg2000ImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile, BOOL bIncludesCalibrationData )
+{
+	BOOL				bNoError = TRUE;
+	BOOL				bIsSupported = TRUE;
+	J2K_IMAGE			Image;
+	J2K_TILE_DATA		*pTileData;
+	unsigned char		*pCodestream;
+	unsigned long		CodestreamLength;
+	unsigned char		*pDecodedImage;
+	unsigned long		DecodedImageSize;
+	long				BytesPerSample;
+	long				nTile;
+	long				nTiles;
+	char				*pCompressedImageData;
+	unsigned long		CompressedImageLength;
+
+	pTileData = 0;
+	pDecodedImage = 0;
+	nTiles = 0;
+	pCodestream = LocateJpeg2000Codestream( pDicomHeader, &CodestreamLength );
+	bIsSupported = ParseJpeg2000MainHeader( pCodestream, CodestreamLength, &Image );
+	if ( bIsSupported )
+		bIsSupported = Jpeg2000ImageMatchesDicomHeader( &Image, pDicomHeader, &DecodedImageSize );
+	if ( bIsSupported )
+		{
+		// The decoded samples must fit the pixel cells allocated in the Dicom header.
+		BytesPerSample = ( *pDicomHeader -> BitsAllocated <= 8 ) ? 1 : 2;
+		bIsSupported = ( Image.BitDepth <= 8 * BytesPerSample );
+		}
+	if ( bIsSupported )
+		{
+		nTiles = Image.nTilesWide * Image.nTilesHigh;
+		pTileData = (J2K_TILE_DATA*)calloc( nTiles, sizeof(J2K_TILE_DATA) );
+		pDecodedImage = (unsigned char*)calloc( DecodedImageSize, 1 );
+		if ( pTileData == 0 || pDecodedImage == 0 )
+			{
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+			bNoError = FALSE;
+			}
+		}
+	if ( bNoError && bIsSupported )
+		{
+		bNoError = ReadJpeg2000TileParts( &Image, pTileData, &bIsSupported );
+		if ( !bNoError )
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_CORRUPTION );
+		}
+	for ( nTile = 0; nTile < nTiles && bNoError && bIsSupported; nTile++ )
+		bNoError = DecodeJpeg2000Tile( &Image, nTile, &pTileData[ nTile ], pDecodedImage, BytesPerSample, &bIsSupported );
+	if ( !bIsSupported )
+		{
+		RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_2000 );
+		bNoError = FALSE;
+		}
+	if ( bNoError )
+		{
+		// Convert the decoded image as if it had been received uncompressed.  The Dicom Rows and
+		// Columns already match the decoded image dimensions.
+		pCompressedImageData = pDicomHeader -> pImageData;
+		CompressedImageLength = pDicomHeader -> ImageLengthInBytes;
+		pDicomHeader -> pImageData = (char*)pDecodedImage;
+		pDicomHeader -> ImageLengthInBytes = DecodedImageSize;
+		bNoError = ConvertUncompressedImageToPNGFile( pDicomHeader, pOutputImageFile, bIncludesCalibrationData );
+		pDicomHeader -> pImageData = pCompressedImageData;
+		pDicomHeader -> ImageLengthInBytes = CompressedImageLength;
+		}
+	if ( pTileData != 0 )
+		{
+		for ( nTile = 0; nTile < nTiles; nTile++ )
+			if ( pTileData[ nTile ].pPacketData != 0 )
+				free( pTileData[ nTile ].pPacketData );
+		free( pTileData );
+		}
+	if ( pDecodedImage != 0 )
+		free( pDecodedImage );
+
+	return bNoError;
+}
+
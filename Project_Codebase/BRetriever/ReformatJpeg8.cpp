@@ -30,6 +30,15 @@
 //
 // UPDATE HISTORY:
 //
+//	*[4] 10/19/2026 by agent
+//		Decompress8BitJpegImage() freed the decompressed image it had just returned to
+//		the caller.  It is now only freed on an error.
+//	*[3] 10/19/2026 by agent
+//		Don't free the decoding buffers twice, or end the PNG file, after a JPEG
+//		library error.
+//	*[2] 10/19/2026 by agent
+//		Register the pixel statistics collection for the PNG output, and record the
+//		statistics in a private chunk before ending the PNG file.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -136,10 +145,7 @@ BOOL Convert8BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pO
 			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_CORRUPTION );
 			jpeg_destroy_decompress( &JpegDecompressInfo );
 			bNoError = FALSE;
-			if ( pRows != 0 )						// *[1] Clean up before error exit.
-				free( pRows );
-			if ( pBuffer != 0 )
-				free( pBuffer );
+			// *[3] The buffers are freed below.
 			}
 		}
 	if ( bNoError )
@@ -280,6 +286,8 @@ BOOL Convert8BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pO
 
 		// Create an output chunk to indicate the original image grayscale bit depth.
 		png_set_sBIT( pPngConfig, pPngImageInfo, &PngSignificantBits );
+		// Accumulate the pixel statistics as the image rows are written.
+		CollectImagePixelStatistics( pPngConfig, FALSE );											// *[2]
 		}
 	if ( bNoError )
 		{
@@ -319,7 +327,12 @@ BOOL Convert8BitJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pO
 		}
 	if ( pOutputImageFile != 0 && pPngConfig != 0 && pPngImageInfo != 0 )
 		{
-		png_write_end( pPngConfig, pPngImageInfo );
+		// *[3] An incomplete image is abandoned, rather than ended.
+		if ( bNoError )
+			{
+			WriteImagePixelStatisticsChunk( pPngConfig );													// *[2]
+			png_write_end( pPngConfig, pPngImageInfo );
+			}
 		png_destroy_write_struct( &pPngConfig, &pPngImageInfo );
 		}
 
@@ -481,7 +494,7 @@ BOOL Decompress8BitJpegImage( char *pJpegSourceImageBuffer, unsigned long JpegSo
 						"JPEG image was decompressed successfully:  Width = %d,  Height = %d,  Image Size (bytes) = %d", nImagePixelsPerRow, nImageRows, *pDecompressedImageSizeInBytes );
 		LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
 		}
-	if ( pBuffer != 0 )																			// *[1] Removed the else condition on this deallocation.
+	if ( !bNoError && pBuffer != 0 )															// *[4] The decompressed image belongs to the caller.
 		free( pBuffer );
 
 	if ( pRows != 0 )
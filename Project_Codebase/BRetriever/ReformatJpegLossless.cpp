@@ -0,0 +1,652 @@
+// ReformatJpegLossless.cpp : Implements the data structures and functions related to
+//	the conversion of an image from a lossless (process 14, first order prediction) JPEG
+//  grayscale format into the PNG format readable by BViewer.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//	*[1] 10/19/2026 by agent
+//		Register the pixel statistics collection for the PNG output, and record the
+//		statistics in a private chunk before ending the PNG file.
+//
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "ProductDispatcher.h"
+#include "ExamReformat.h"
+
+#pragma pack(push)
+#pragma pack(8)		// Pack structure members on 8-byte boundaries for faster access.
+
+extern "C"
+{
+#include "png.h"
+}
+
+#pragma pack(pop)
+
+
+// Most of the lossless JPEG images received are 12- or 16-bit CR and DX images encoded
+// with the first order (selection value 1) predictor.  The general purpose JPEG libraries
+// decode their Huffman codes a bit at a time, which dominates the image reformatting time.
+// The decoder below handles only this common case:  a single component, Huffman coded,
+// selection value 1 image with 9 to 16 bits per sample.  Anything else is left to the
+// JPEG libraries.
+
+#define LOOKAHEAD_BITS				12
+#define LOOKAHEAD_TABLE_SIZE		( 1 << LOOKAHEAD_BITS )
+#define MAX_LOSSLESS_IMAGE_DIMENSION	20000
+
+#define JPEG_MARKER_SOF3			0xC3		// Start of frame, lossless Huffman coding.
+#define JPEG_MARKER_DHT				0xC4		// Define Huffman tables.
+#define JPEG_MARKER_SOI				0xD8		// Start of image.
+#define JPEG_MARKER_SOS				0xDA		// Start of scan.
+#define JPEG_MARKER_DRI				0xDD		// Define restart interval.
+
+
+// Each lookahead table entry is indexed by the next LOOKAHEAD_BITS bits of the entropy coded
+// data.  If both the Huffman code and the difference bits that follow it fit within the
+// lookahead bits, the entry contains the decoded difference.  Otherwise, if the Huffman code
+// fits, the entry gives the code length and the number of difference bits to be read.
+// Otherwise, the code is decoded from the table of maximum code values for each code length.
+typedef struct
+	{
+	short				Difference;				// The decoded sample difference, if nTotalBits is not zero.
+	unsigned char		nCodeBits;				// The Huffman code length, or zero if longer than the lookahead.
+	unsigned char		nTotalBits;				// The length of the code plus its difference bits, or zero if too long.
+	unsigned char		DifferenceCategory;		// The number of difference bits following the code.
+	} HUFFMAN_LOOKAHEAD_ENTRY;
+
+
+typedef struct
+	{
+	BOOL				bIsDefined;
+	unsigned char		CodeCount[ 17 ];		// The number of Huffman codes of each length, 1 - 16.
+	unsigned char		Symbol[ 256 ];			// The coded symbols, in order of increasing code length.
+	} HUFFMAN_TABLE_SPECIFICATION;
+
+
+typedef struct
+	{
+	long						MaxCode[ 17 ];			// The largest code of each length, or -1 if none.
+	long						SymbolOffset[ 17 ];		// Add to a code of each length to get its symbol index.
+	unsigned char				Symbol[ 256 ];
+	HUFFMAN_LOOKAHEAD_ENTRY		Lookahead[ LOOKAHEAD_TABLE_SIZE ];
+	} HUFFMAN_DECODING_TABLE;
+
+
+typedef struct
+	{
+	long						SamplePrecision;
+	long						nImageRows;
+	long						nImageColumns;
+	long						RestartInterval;		// The number of samples in each restart interval, or zero.
+	long						PointTransform;
+	unsigned char				ComponentID;
+	unsigned char				*pEntropyCodedData;
+	unsigned char				*pEndOfData;
+	HUFFMAN_TABLE_SPECIFICATION	HuffmanTable[ 4 ];
+	HUFFMAN_TABLE_SPECIFICATION	*pScanHuffmanTable;
+	} LOSSLESS_JPEG_FRAME;
+
+
+// The bit reservoir holds the unread bits of the entropy coded data, left justified.
+typedef struct
+	{
+	unsigned char				*pNextByte;
+	unsigned char				*pEndOfData;
+	unsigned __int64			BitReservoir;
+	long						nBitsInReservoir;
+	BOOL						bMarkerReached;
+	} ENTROPY_CODED_DATA_READER;
+
+
+static BOOL ParseLosslessJpegFrameHeader( unsigned char *pSegment, long SegmentLength, LOSSLESS_JPEG_FRAME *pFrame )
+{
+	BOOL				bIsSupported;
+
+	// Only single component (grayscale) frames are supported.
+	bIsSupported = ( SegmentLength == 9 && pSegment[ 5 ] == 1 );
+	if ( bIsSupported )
+		{
+		pFrame -> SamplePrecision = (long)pSegment[ 0 ];
+		pFrame -> nImageRows = ( (long)pSegment[ 1 ] << 8 ) | (long)pSegment[ 2 ];
+		pFrame -> nImageColumns = ( (long)pSegment[ 3 ] << 8 ) | (long)pSegment[ 4 ];
+		pFrame -> ComponentID = pSegment[ 6 ];
+		// Eight-bit images are handled by the 8-bit JPEG library.  A zero image height would require
+		// support for the DNL marker.
+		bIsSupported = ( pFrame -> SamplePrecision > 8 && pFrame -> SamplePrecision <= 16 &&
+							pFrame -> nImageRows > 0 && pFrame -> nImageRows <= MAX_LOSSLESS_IMAGE_DIMENSION &&
+							pFrame -> nImageColumns > 0 && pFrame -> nImageColumns <= MAX_LOSSLESS_IMAGE_DIMENSION );
+		}
+
+	return bIsSupported;
+}
+
+
+static BOOL ParseHuffmanTableSegment( unsigned char *pSegment, long SegmentLength, LOSSLESS_JPEG_FRAME *pFrame )
+{
+	BOOL							bIsSupported = TRUE;
+	long							nByte;
+	long							nCodeLength;
+	long							nSymbols;
+	unsigned char					TableClass;
+	unsigned char					TableID;
+	HUFFMAN_TABLE_SPECIFICATION		*pTableSpecification;
+
+	nByte = 0;
+	while ( bIsSupported && nByte < SegmentLength )
+		{
+		bIsSupported = ( nByte + 17 <= SegmentLength );
+		if ( bIsSupported )
+			{
+			TableClass = pSegment[ nByte ] >> 4;
+			TableID = pSegment[ nByte ] & 0x0F;
+			nByte++;
+			bIsSupported = ( TableClass == 0 && TableID < 4 );
+			}
+		if ( bIsSupported )
+			{
+			pTableSpecification = &pFrame -> HuffmanTable[ TableID ];
+			pTableSpecification -> CodeCount[ 0 ] = 0;
+			nSymbols = 0;
+			for ( nCodeLength = 1; nCodeLength <= 16; nCodeLength++ )
+				{
+				pTableSpecification -> CodeCount[ nCodeLength ] = pSegment[ nByte++ ];
+				nSymbols += (long)pTableSpecification -> CodeCount[ nCodeLength ];
+				}
+			bIsSupported = ( nSymbols <= 256 && nByte + nSymbols <= SegmentLength );
+			}
+		if ( bIsSupported )
+			{
+			memcpy( pTableSpecification -> Symbol, &pSegment[ nByte ], nSymbols );
+			pTableSpecification -> bIsDefined = TRUE;
+			nByte += nSymbols;
+			}
+		}
+
+	return bIsSupported;
+}
+
+
+static BOOL ParseLosslessJpegScanHeader( unsigned char *pSegment, long SegmentLength, LOSSLESS_JPEG_FRAME *pFrame )
+{
+	BOOL				bIsSupported;
+	unsigned char		TableID;
+
+	// Only a single component scan using the first order predictor (selection value 1) is supported.
+	bIsSupported = ( SegmentLength == 6 && pSegment[ 0 ] == 1 && pSegment[ 1 ] == pFrame -> ComponentID && pSegment[ 3 ] == 1 );
+	if ( bIsSupported )
+		{
+		TableID = pSegment[ 2 ] >> 4;
+		pFrame -> PointTransform = (long)( pSegment[ 5 ] & 0x0F );
+		bIsSupported = ( TableID < 4 && pFrame -> HuffmanTable[ TableID ].bIsDefined &&
+							pFrame -> PointTransform < pFrame -> SamplePrecision );
+		if ( bIsSupported )
+			pFrame -> pScanHuffmanTable = &pFrame -> HuffmanTable[ TableID ];
+		}
+	// Restart markers are only expected at the end of an image row.
+	if ( bIsSupported && pFrame -> RestartInterval > 0 )
+		bIsSupported = ( pFrame -> RestartInterval % pFrame -> nImageColumns == 0 );
+
+	return bIsSupported;
+}
+
+
+// Read the JPEG marker segments preceding the entropy coded image data.  Return FALSE if the
+// image is not one that can be handled by the lossless decoder.
+static BOOL ParseLosslessJpegHeader( unsigned char *pJpegData, unsigned long JpegDataLength, LOSSLESS_JPEG_FRAME *pFrame )
+{
+	BOOL				bIsSupported = TRUE;
+	BOOL				bFrameHeaderFound = FALSE;
+	BOOL				bScanHeaderFound = FALSE;
+	unsigned char		*pNextByte;
+	unsigned char		*pEndOfData;
+	unsigned char		Marker;
+	long				SegmentLength;
+
+	memset( pFrame, 0, sizeof(LOSSLESS_JPEG_FRAME) );
+	pNextByte = pJpegData;
+	pEndOfData = pJpegData + JpegDataLength;
+	if ( pJpegData == 0 || JpegDataLength < 4 || pNextByte[ 0 ] != 0xFF || pNextByte[ 1 ] != JPEG_MARKER_SOI )
+		bIsSupported = FALSE;
+	else
+		pNextByte += 2;
+	while ( bIsSupported && !bScanHeaderFound )
+		{
+		bIsSupported = ( pNextByte < pEndOfData && *pNextByte == 0xFF );
+		if ( bIsSupported )
+			{
+			// Skip the marker prefix and any fill bytes.
+			while ( pNextByte < pEndOfData && *pNextByte == 0xFF )
+				pNextByte++;
+			bIsSupported = ( pNextByte + 3 <= pEndOfData );
+			}
+		if ( bIsSupported )
+			{
+			Marker = *pNextByte++;
+			SegmentLength = ( (long)pNextByte[ 0 ] << 8 ) | (long)pNextByte[ 1 ];
+			// Stand-alone markers (TEM, RSTn, SOI, EOI) are not expected here.
+			bIsSupported = ( Marker != 0x01 && ( Marker < 0xD0 || Marker > 0xD9 ) &&
+								SegmentLength >= 2 && pNextByte + SegmentLength <= pEndOfData );
+			}
+		if ( bIsSupported )
+			{
+			switch ( Marker )
+				{
+				case JPEG_MARKER_SOF3:
+					bIsSupported = !bFrameHeaderFound && ParseLosslessJpegFrameHeader( pNextByte + 2, SegmentLength - 2, pFrame );
+					bFrameHeaderFound = TRUE;
+					break;
+				case JPEG_MARKER_DHT:
+					bIsSupported = ParseHuffmanTableSegment( pNextByte + 2, SegmentLength - 2, pFrame );
+					break;
+				case JPEG_MARKER_DRI:
+					bIsSupported = ( SegmentLength == 4 );
+					if ( bIsSupported )
+						pFrame -> RestartInterval = ( (long)pNextByte[ 2 ] << 8 ) | (long)pNextByte[ 3 ];
+					break;
+				case JPEG_MARKER_SOS:
+					bIsSupported = bFrameHeaderFound && ParseLosslessJpegScanHeader( pNextByte + 2, SegmentLength - 2, pFrame );
+					bScanHeaderFound = TRUE;
+					break;
+				default:
+					// Any other start of frame marker indicates an encoding that isn't handled here.
+					// The remaining segments (APPn, COM, etc.) are skipped.
+					if ( Marker >= 0xC0 && Marker <= 0xCF && Marker != 0xC8 && Marker != 0xCC )
+						bIsSupported = FALSE;
+					break;
+				}
+			pNextByte += SegmentLength;
+			}
+		}
+	if ( bIsSupported )
+		{
+		pFrame -> pEntropyCodedData = pNextByte;
+		pFrame -> pEndOfData = pEndOfData;
+		}
+
+	return bIsSupported;
+}
+
+
+// Convert difference bits to a signed sample difference, as described in the JPEG standard, F.2.2.1,
+// without branching on the sign.
+static inline long ExtendDifference( long DifferenceBits, long DifferenceCategory )
+{
+	return DifferenceBits + ( ( ( DifferenceBits >> ( DifferenceCategory - 1 ) ) - 1 ) & ( 1 - ( 1L << DifferenceCategory ) ) );
+}
+
+
+static BOOL CreateHuffmanDecodingTable( HUFFMAN_TABLE_SPECIFICATION *pTableSpecification, HUFFMAN_DECODING_TABLE *pDecodingTable )
+{
+	BOOL						bIsSupported = TRUE;
+	long						Code;
+	long						nCodeLength;
+	long						nCode;
+	long						nSymbol;
+	long						nEntry;
+	long						nFirstEntry;
+	long						nEntries;
+	long						DifferenceCategory;
+	HUFFMAN_LOOKAHEAD_ENTRY		*pLookaheadEntry;
+
+	memset( pDecodingTable, 0, sizeof(HUFFMAN_DECODING_TABLE) );
+	memcpy( pDecodingTable -> Symbol, pTableSpecification -> Symbol, 256 );
+	Code = 0;
+	nSymbol = 0;
+	pDecodingTable -> MaxCode[ 0 ] = -1;
+	for ( nCodeLength = 1; nCodeLength <= 16 && bIsSupported; nCodeLength++ )
+		{
+		pDecodingTable -> SymbolOffset[ nCodeLength ] = nSymbol - Code;
+		for ( nCode = 0; nCode < (long)pTableSpecification -> CodeCount[ nCodeLength ] && bIsSupported; nCode++ )
+			{
+			DifferenceCategory = (long)pTableSpecification -> Symbol[ nSymbol ];
+			bIsSupported = ( DifferenceCategory <= 16 );
+			if ( bIsSupported && nCodeLength <= LOOKAHEAD_BITS )
+				{
+				// Fill in every lookahead entry that begins with this code.
+				nFirstEntry = Code << ( LOOKAHEAD_BITS - nCodeLength );
+				nEntries = 1L << ( LOOKAHEAD_BITS - nCodeLength );
+				for ( nEntry = 0; nEntry < nEntries; nEntry++ )
+					{
+					pLookaheadEntry = &pDecodingTable -> Lookahead[ nFirstEntry + nEntry ];
+					pLookaheadEntry -> nCodeBits = (unsigned char)nCodeLength;
+					pLookaheadEntry -> DifferenceCategory = (unsigned char)DifferenceCategory;
+					if ( DifferenceCategory == 0 )
+						{
+						pLookaheadEntry -> Difference = 0;
+						pLookaheadEntry -> nTotalBits = (unsigned char)nCodeLength;
+						}
+					else if ( nCodeLength + DifferenceCategory <= LOOKAHEAD_BITS )
+						{
+						pLookaheadEntry -> Difference = (short)ExtendDifference( nEntry >> ( LOOKAHEAD_BITS - nCodeLength - DifferenceCategory ),
+																					DifferenceCategory );
+						pLookaheadEntry -> nTotalBits = (unsigned char)( nCodeLength + DifferenceCategory );
+						}
+					}
+				}
+			nSymbol++;
+			Code++;
+			}
+		pDecodingTable -> MaxCode[ nCodeLength ] = ( pTableSpecification -> CodeCount[ nCodeLength ] > 0 ) ? Code - 1 : -1;
+		// The all-ones code of each length is reserved.
+		if ( Code >= ( 1L << nCodeLength ) )
+			bIsSupported = FALSE;
+		Code <<= 1;
+		}
+
+	return bIsSupported;
+}
+
+
+// Keep at least 57 unread bits in the reservoir.  When a marker is reached, zero bits are supplied,
+// the same as the JPEG libraries do.
+static void FillBitReservoir( ENTROPY_CODED_DATA_READER *pReader )
+{
+	unsigned long			NextByte;
+
+	while ( pReader -> nBitsInReservoir <= 56 )
+		{
+		NextByte = 0;
+		if ( !pReader -> bMarkerReached && pReader -> pNextByte < pReader -> pEndOfData )
+			{
+			NextByte = (unsigned long)*pReader -> pNextByte;
+			if ( NextByte != 0xFF )
+				pReader -> pNextByte++;
+			else if ( pReader -> pNextByte + 1 < pReader -> pEndOfData && pReader -> pNextByte[ 1 ] == 0x00 )
+				pReader -> pNextByte += 2;			// Skip the stuffed zero byte.
+			else
+				{
+				pReader -> bMarkerReached = TRUE;
+				NextByte = 0;
+				}
+			}
+		pReader -> BitReservoir |= (unsigned __int64)NextByte << ( 56 - pReader -> nBitsInReservoir );
+		pReader -> nBitsInReservoir += 8;
+		}
+}
+
+
+// Discard any unused bits at the end of a restart interval and skip past the RSTn marker.
+static BOOL ProcessRestartMarker( ENTROPY_CODED_DATA_READER *pReader )
+{
+	BOOL				bMarkerFound = FALSE;
+
+	pReader -> BitReservoir = 0;
+	pReader -> nBitsInReservoir = 0;
+	pReader -> bMarkerReached = FALSE;
+	while ( !bMarkerFound && pReader -> pNextByte + 1 < pReader -> pEndOfData )
+		{
+		if ( pReader -> pNextByte[ 0 ] == 0xFF && pReader -> pNextByte[ 1 ] >= 0xD0 && pReader -> pNextByte[ 1 ] <= 0xD7 )
+			bMarkerFound = TRUE;
+		pReader -> pNextByte++;
+		}
+	if ( bMarkerFound )
+		pReader -> pNextByte++;
+
+	return bMarkerFound;
+}
+
+
+// Decode the entropy coded data into unsigned 16-bit samples, one row after another.
+static BOOL DecodeLosslessJpegImage( LOSSLESS_JPEG_FRAME *pFrame, HUFFMAN_DECODING_TABLE *pDecodingTable, unsigned short *pImagePixels )
+{
+	BOOL						bNoError = TRUE;
+	ENTROPY_CODED_DATA_READER	Reader;
+	HUFFMAN_LOOKAHEAD_ENTRY		*pLookaheadEntry;
+	unsigned short				*pRow;
+	long						nImageColumns;
+	long						nRow;
+	long						nColumn;
+	long						nRowsPerRestartInterval;
+	long						nRowsUntilRestart;
+	long						DefaultPrediction;
+	long						Sample;
+	long						Difference;
+	long						DifferenceCategory;
+	long						Code;
+	long						nCodeBits;
+	long						nBitsUsed;
+	BOOL						bFirstRowOfInterval;
+
+	Reader.pNextByte = pFrame -> pEntropyCodedData;
+	Reader.pEndOfData = pFrame -> pEndOfData;
+	Reader.BitReservoir = 0;
+	Reader.nBitsInReservoir = 0;
+	Reader.bMarkerReached = FALSE;
+	nImageColumns = pFrame -> nImageColumns;
+	nRowsPerRestartInterval = pFrame -> RestartInterval / nImageColumns;
+	nRowsUntilRestart = nRowsPerRestartInterval;
+	DefaultPrediction = 1L << ( pFrame -> SamplePrecision - pFrame -> PointTransform - 1 );
+	bFirstRowOfInterval = TRUE;
+	for ( nRow = 0; nRow < pFrame -> nImageRows && bNoError; nRow++ )
+		{
+		if ( nRowsPerRestartInterval > 0 && nRowsUntilRestart == 0 )
+			{
+			bNoError = ProcessRestartMarker( &Reader );
+			nRowsUntilRestart = nRowsPerRestartInterval;
+			bFirstRowOfInterval = TRUE;
+			}
+		pRow = &pImagePixels[ nRow * nImageColumns ];
+		// The first sample of each row is predicted from the sample above it, except for the
+		// first row of each restart interval.  Each remaining sample is predicted from the
+		// sample to its left.
+		if ( bFirstRowOfInterval )
+			Sample = DefaultPrediction;
+		else
+			Sample = (long)pRow[ -nImageColumns ];
+		for ( nColumn = 0; nColumn < nImageColumns && bNoError; nColumn++ )
+			{
+			if ( Reader.nBitsInReservoir < 32 )
+				FillBitReservoir( &Reader );
+			pLookaheadEntry = &pDecodingTable -> Lookahead[ (long)( Reader.BitReservoir >> ( 64 - LOOKAHEAD_BITS ) ) ];
+			if ( pLookaheadEntry -> nTotalBits != 0 )
+				{
+				Difference = (long)pLookaheadEntry -> Difference;
+				nBitsUsed = (long)pLookaheadEntry -> nTotalBits;
+				}
+			else
+				{
+				if ( pLookaheadEntry -> nCodeBits != 0 )
+					{
+					nCodeBits = (long)pLookaheadEntry -> nCodeBits;
+					DifferenceCategory = (long)pLookaheadEntry -> DifferenceCategory;
+					}
+				else
+					{
+					// The code is longer than the lookahead.
+					nCodeBits = LOOKAHEAD_BITS + 1;
+					Code = (long)( Reader.BitReservoir >> ( 64 - nCodeBits ) );
+					while ( nCodeBits <= 16 && Code > pDecodingTable -> MaxCode[ nCodeBits ] )
+						{
+						nCodeBits++;
+						Code = (long)( Reader.BitReservoir >> ( 64 - nCodeBits ) );
+						}
+					if ( nCodeBits > 16 )
+						{
+						bNoError = FALSE;
+						DifferenceCategory = 0;
+						}
+					else
+						DifferenceCategory = (long)pDecodingTable -> Symbol[ Code + pDecodingTable -> SymbolOffset[ nCodeBits ] ];
+					}
+				if ( DifferenceCategory == 0 )
+					{
+					Difference = 0;
+					nBitsUsed = nCodeBits;
+					}
+				else if ( DifferenceCategory == 16 )
+					{
+					Difference = 32768;
+					nBitsUsed = nCodeBits;
+					}
+				else
+					{
+					Difference = ExtendDifference( (long)( ( Reader.BitReservoir << nCodeBits ) >> ( 64 - DifferenceCategory ) ), DifferenceCategory );
+					nBitsUsed = nCodeBits + DifferenceCategory;
+					}
+				}
+			Reader.BitReservoir <<= nBitsUsed;
+			Reader.nBitsInReservoir -= nBitsUsed;
+			Sample = ( Sample + Difference ) & 0xFFFF;
+			pRow[ nColumn ] = (unsigned short)Sample;
+			}
+		bFirstRowOfInterval = FALSE;
+		nRowsUntilRestart--;
+		}
+	// Restore the point transform.
+	if ( bNoError && pFrame -> PointTransform > 0 )
+		{
+		for ( nColumn = 0; nColumn < pFrame -> nImageRows * nImageColumns; nColumn++ )
+			pImagePixels[ nColumn ] = (unsigned short)( pImagePixels[ nColumn ] << pFrame -> PointTransform );
+		}
+	if ( !bNoError )
+		RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_CORRUPTION );
+
+	return bNoError;
+}
+
+
+// Return TRUE if the lossless decoder can handle the JPEG image in the Dicom pixel data.
+BOOL LosslessJpegImageCanBeDecoded( DICOM_HEADER_SUMMARY *pDicomHeader )
+{
+	LOSSLESS_JPEG_FRAME			JpegFrame;
+
+	return ParseLosslessJpegHeader( (unsigned char*)pDicomHeader -> pImageData, pDicomHeader -> ImageLengthInBytes, &JpegFrame );
+}
+
+
+BOOL ConvertLosslessJpegImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile )
+{
+	BOOL						bNoError = TRUE;
+	LOSSLESS_JPEG_FRAME			JpegFrame;
+	HUFFMAN_DECODING_TABLE		*pDecodingTable;
+	unsigned short				*pImagePixels;
+	long						nRow;
+	png_struct					*pPngConfig;				// Interface to the PNG library.
+	png_info					*pPngImageInfo;				// Interface to the PNG library.
+	png_color_8					PngSignificantBits;			// Significant bits in each available channel;
+
+	pPngConfig = 0;
+	pPngImageInfo = 0;
+	pImagePixels = 0;
+	pDecodingTable = 0;
+	bNoError = ParseLosslessJpegHeader( (unsigned char*)pDicomHeader -> pImageData, pDicomHeader -> ImageLengthInBytes, &JpegFrame );
+	if ( !bNoError )
+		RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_CORRUPTION );
+	if ( bNoError )
+		{
+		pDecodingTable = (HUFFMAN_DECODING_TABLE*)malloc( sizeof(HUFFMAN_DECODING_TABLE) );
+		pImagePixels = (unsigned short*)malloc( JpegFrame.nImageRows * JpegFrame.nImageColumns * sizeof(unsigned short) );
+		if ( pDecodingTable == 0 || pImagePixels == 0 )
+			{
+			bNoError = FALSE;
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_INSUFFICIENT_MEMORY );
+			}
+		}
+	if ( bNoError )
+		{
+		bNoError = CreateHuffmanDecodingTable( JpegFrame.pScanHuffmanTable, pDecodingTable );
+		if ( !bNoError )
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_JPEG_CORRUPTION );
+		}
+	if ( bNoError )
+		bNoError = DecodeLosslessJpegImage( &JpegFrame, pDecodingTable, pImagePixels );
+	if ( bNoError )
+		{
+		*pDicomHeader -> ImageRows = (unsigned short)JpegFrame.nImageRows;
+		*pDicomHeader -> ImageColumns = (unsigned short)JpegFrame.nImageColumns;
+		// Create and initialize the png_struct with the default error handler functions.
+		pPngConfig = png_create_write_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+		if ( pPngConfig == NULL )
+			{
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_PNG_WRITE );
+			bNoError = FALSE;
+			}
+		}
+	if ( bNoError )
+		{
+		// Allocate/initialize the image information data.
+		pPngImageInfo = png_create_info_struct( pPngConfig );
+		if ( pPngImageInfo == NULL )
+			{
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_PNG_WRITE );
+			png_destroy_write_struct( &pPngConfig,  png_infopp_NULL );
+			pPngConfig = 0;
+			bNoError = FALSE;
+			}
+		}
+	if ( bNoError )
+		{
+		if ( setjmp( png_jmpbuf( pPngConfig ) ) )
+			{
+			// If we get here, we had a problem writing the file.
+			RespondToError( MODULE_REFORMAT, REFORMAT_ERROR_PNG_WRITE );
+			png_destroy_write_struct( &pPngConfig, &pPngImageInfo );
+			pPngConfig = 0;
+			pPngImageInfo = 0;
+			bNoError = FALSE;
+			}
+		}
+	if ( bNoError )
+		{
+		// Set up the output control for using standard C streams.
+		png_init_io( pPngConfig, pOutputImageFile );
+		png_set_IHDR( pPngConfig, pPngImageInfo, JpegFrame.nImageColumns, JpegFrame.nImageRows, 16,
+						PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE );
+		// The JPEG libraries report a gamma of 1.0 for these images.
+		png_set_gAMA( pPngConfig, pPngImageInfo, 1.0 );
+		png_write_info( pPngConfig, pPngImageInfo );
+
+		PngSignificantBits.alpha = 0;
+		PngSignificantBits.blue = 0;
+		PngSignificantBits.green = 0;
+		PngSignificantBits.red = 0;
+		PngSignificantBits.gray = (png_byte)( *pDicomHeader -> BitsStored );
+		// Create an output chunk to indicate the original image grayscale bit depth.
+		png_set_sBIT( pPngConfig, pPngImageInfo, &PngSignificantBits );
+
+		if ( _stricmp( pDicomHeader -> Modality, "NM" ) != 0 )	// ...for NM, do nothing.
+			png_set_swap( pPngConfig );
+		// Accumulate the pixel statistics as the image rows are written.
+		CollectImagePixelStatistics( pPngConfig, ( _stricmp( pDicomHeader -> Modality, "NM" ) != 0 ) );		// *[1]
+		for ( nRow = 0; nRow < JpegFrame.nImageRows; nRow++ )
+			png_write_row( pPngConfig, (png_bytep)&pImagePixels[ nRow * JpegFrame.nImageColumns ] );
+		WriteImagePixelStatisticsChunk( pPngConfig );																// *[1]
+		png_write_end( pPngConfig, pPngImageInfo );
+		png_destroy_write_struct( &pPngConfig, &pPngImageInfo );
+		}
+
+	if ( pImagePixels != 0 )
+		free( pImagePixels );
+	if ( pDecodingTable != 0 )
+		free( pDecodingTable );
+
+	return bNoError;
+}
+
@@ -30,6 +30,9 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Register the pixel statistics collection for the PNG output, and record the
+//		statistics in a private chunk before ending the PNG file.
 //	*[1] 03/25/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -75,6 +78,7 @@ BOOL ConvertUncompressedImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE
 	long					nImageRowsRemaining;
 	int						PNGColorType;
 	long					nSamplesPerPixel;
+	BOOL					bPixelBytesAreSwapped;			// *[2]
 
 	png_struct				*pPngConfig;
 	png_info				*pPngImageInfo;
@@ -202,12 +206,18 @@ BOOL ConvertUncompressedImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE
 		// Create an output chunk to indicate the original image grayscale bit depth.
 		png_set_sBIT( pPngConfig, pPngImageInfo, &PngSignificantBits );
 
+		bPixelBytesAreSwapped = FALSE;																	// *[2]
 		if ( nImageBitsAllocatedPerPixel > 8 )
 			{
 			if ( ( pDicomHeader -> FileDecodingPlan.nTransferSyntaxIndex != BIG_ENDIAN_EXPLICIT_TRANSFER_SYNTAX ) &&
 						_stricmp( pDicomHeader -> Modality, "NM" ) != 0 )
+				{
 				png_set_swap( pPngConfig );
+				bPixelBytesAreSwapped = TRUE;																// *[2]
+				}
 			}
+		// Accumulate the pixel statistics as the image rows are written.
+		CollectImagePixelStatistics( pPngConfig, bPixelBytesAreSwapped );									// *[2]
 		}
 
 	if ( bNoError && !bEndOfFile )
@@ -229,7 +239,11 @@ BOOL ConvertUncompressedImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE
 			}
 		}			// ... end while more image data remains to be written.
 	if ( pOutputImageFile != 0 )
+		{
+		if ( bNoError )
+			WriteImagePixelStatisticsChunk( pPngConfig );													// *[2]
 		png_write_end( pPngConfig, pPngImageInfo );
+		}
 	png_destroy_write_struct( &pPngConfig, &pPngImageInfo );
 
 	if ( pRows != 0 )
@@ -29,6 +29,9 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Added the -extract and -compact command line options for maintaining the
+//		Dicom image archive pack files.
 //	*[1] 03/07/2024 by Tom Atwood
 //		Fixed security issues.
 //
@@ -41,6 +44,7 @@
 #include "Configuration.h"
 #include "Operation.h"
 #include "ProductDispatcher.h"
+#include "DicomArchive.h"		// *[2]
 
 
 // NOTE:  "SCM" refers to the Microsoft Windows "Service Control Manager" program,
@@ -360,6 +364,23 @@ int main( int argc, char *argv[] )
 			{
 			RemoveService();
 			}
+		// *[2] "BRetriever -extract <pack file> [<output folder>]" restores the archived Dicom image files from a pack.
+		else if ( argc > 2 && strcmp( argv[1], "-extract" ) == 0 )
+			{
+			TransferService.bPrintToConsole = TRUE;
+			if ( argc > 3 )
+				ExtractArchivePack( argv[2], argv[3] );
+			else
+				ExtractArchivePack( argv[2], "." );
+			CloseSoftwareModules();
+			}
+		// *[2] "BRetriever -compact <pack file>" removes the superseded and corrupted files from a pack.
+		else if ( argc > 2 && strcmp( argv[1], "-compact" ) == 0 )
+			{
+			TransferService.bPrintToConsole = TRUE;
+			CompactArchivePack( argv[2] );
+			CloseSoftwareModules();
+			}
 		else if ( argc == 1 )
 			{
 			// Notify the SCM about the location of the ServiceTable.
@@ -28,6 +28,9 @@
 //
 // UPDATE HISTORY:
 //
+//	*[2] 10/19/2026 by agent
+//		Added the configuration settings for storing the archived Dicom image files
+//		in per-study pack files.
 //	*[1] 03/11/2024 by Tom Atwood
 //		Convert windows headers byte packing to the Win32 default for compatibility
 //		with Visual Studio 2022.
@@ -94,6 +97,8 @@ typedef struct
 	BOOL					bEnableSurvey;
 	BOOL					bComposeDicomOutputFile;
 	BOOL					bApplyManualDicomEdits;
+	BOOL					bPackDicomImageArchive;						// *[2] Added.
+	BOOL					bCompressDicomImageArchive;					// *[2] Added.
 	} CONFIGURATION;
 
 
@@ -30,6 +30,9 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		Added host name lookup and connection functions for associations requested
+//		by this node.
 //	*[2] 03/11/2024 by Tom Atwood
 //		Convert windows headers byte packing to the Win32 default for compatibility
 //		with Visual Studio 2022.
@@ -118,6 +121,8 @@ static ERROR_DICTIONARY_ENTRY	WinSockAPIErrorCodes[] =
 				{ WINSOCKAPI_ERROR_REMOTE_HOST_UNREACHABLE		, "The remote host cannot be reached from this host at this time." },
 				{ WINSOCKAPI_ERROR_MUST_LISTEN_BEFORE_ACCEPT	, "The listen function was not invoked prior to the accept function." },
 				{ WINSOCKAPI_ERROR_RECEIVE_TIMEOUT				, "A socket timed out while waiting to receive data." },
+				{ WINSOCKAPI_ERROR_CONNECTION_REFUSED			, "The attempt to connect was rejected by the remote host." },
+				{ WINSOCKAPI_ERROR_CONNECTION_IN_PROGRESS		, "A connection attempt is already in progress on this socket." },
 				{ 0												, NULL }
 			};
 
@@ -405,6 +410,81 @@ BOOL GetWindowsHostByAddress( char *pAddressBuffer, int AddressLength, int Addre
 }
 
 
+// *[3] Added this function.
+BOOL GetWindowsHostByName( char *pHostName, hostent **ppHostInformation )
+{
+	// The gethostbyname function retrieves host information corresponding to a host name from a host database.
+	//		struct hostent* FAR	   gethostbyname(
+	//											const char* name	// [in] Pointer to the null-terminated name of the host
+	//																//		to resolve.
+	//											);
+	//
+	// Return Values:  If no error occurs, gethostbyname() returns a pointer to the hostent structure described
+	//					above for gethostbyaddr().  Otherwise, it returns a null pointer, and a specific error
+	//					number can be retrieved by calling WSAGetLastError().
+	//
+	// Only one copy of the hostent structure is allocated per thread, so the caller should copy the
+	// address it needs before issuing any other Windows Sockets API calls.
+	//
+	struct hostent			*pHostEnt;
+	BOOL					bNoError = TRUE;
+	int						WinSockErrorCode;
+
+	pHostEnt = gethostbyname( pHostName );
+	if ( pHostEnt == 0 )
+		{
+		bNoError = FALSE;
+		WinSockErrorCode = WSAGetLastError();
+		switch ( WinSockErrorCode )
+			{
+			case WSANOTINITIALISED:
+				// A successful WSAStartup call must occur before using this function.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_NO_WSASTARTUP );
+				break;
+			case WSAENETDOWN:
+				// The network subsystem has failed.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_NETWORK_FAILED );
+				break; 
+			case WSAHOST_NOT_FOUND:
+				// Authoritative answer host not found. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_AUTH_HOST_NOT_FOUND );
+				break;
+			case WSATRY_AGAIN:
+				// Nonauthoritative host not found, or server failure. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_NONAUTH_HOST_NOT_FOUND );
+				break;
+			case WSANO_RECOVERY:
+				// A nonrecoverable error occurred. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_NONRECOVERABLE_ERROR );
+				break;
+			case WSANO_DATA:
+				// Valid name, no data record of requested type. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_VALID_HOST_NAME_NO_DATA );
+				break;
+			case WSAEINPROGRESS:
+				// A blocking Windows Sockets 1.1 call is in progress, or the service provider is still processing a callback function.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_CALLBACK_IN_PROGRESS );
+				break;
+			case WSAEINTR:
+				// The (blocking) Windows Socket 1.1 call was canceled through WSACancelBlockingCall.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_SOCKET_ALREADY_CANCELLED );
+				break;
+			case WSAEFAULT:
+				// The name parameter is not a valid part of the user address space. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_INVALID_SOCKETS_NAME_FIELD );
+				break;
+			default:
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_UNKNOWN );
+				break;
+			}
+		*ppHostInformation = 0;
+		}
+	else
+		*ppHostInformation = pHostEnt;
+	return bNoError;
+}
+
+
 BOOL WindowsSelect( fd_set *readfds, fd_set *writefds, fd_set *exceptfds, const struct timeval *timeout, int *pReadySocketCount )
 {
 	// The select function determines the status of one or more sockets, waiting if necessary, to perform synchronous I/O.
@@ -786,6 +866,108 @@ BOOL WindowsSocketBind( SOCKET SocketDescriptor, struct sockaddr *pInternetAddr
 }
 
 
+// *[3] Added this function.
+BOOL WindowsSocketConnect( SOCKET SocketDescriptor, struct sockaddr *pInternetAddr )
+{
+	// The connect function establishes a connection to a specified socket.
+	//
+	//		int connect(
+	//				SOCKET					s,			// [in] Descriptor identifying an unconnected socket.
+	//				const struct sockaddr*	name,		// [in] Name of the socket in the SOCKADDR structure to which the
+	//													//		connection should be established.
+	//				int						namelen		// [in] Length of name, in bytes.
+	//				);
+	//
+	// Return Value:  If no error occurs, connect() returns zero. Otherwise, it returns SOCKET_ERROR, and a specific error code
+	//					can be retrieved by calling WSAGetLastError().
+	//
+	// For a blocking socket, the return value indicates success or failure of the connection attempt.
+	//
+	BOOL			bNoError = TRUE;
+	int				WinSockErrorCode;
+
+	if ( connect( SocketDescriptor, pInternetAddr, sizeof(*pInternetAddr) ) == SOCKET_ERROR )
+		{
+		bNoError = FALSE;
+		WinSockErrorCode = WSAGetLastError();
+		switch ( WinSockErrorCode )
+			{
+			case WSANOTINITIALISED:
+				// A successful WSAStartup call must occur before using this function. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_NO_WSASTARTUP );
+				break;
+			case WSAENETDOWN:
+				// The network subsystem has failed. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_NETWORK_FAILED );
+				break;
+			case WSAEADDRINUSE:
+				// The socket's local address is already in use and the socket was not marked to allow address reuse with
+				// SO_REUSEADDR.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_SOCKET_IN_USE );
+				break;
+			case WSAEINTR:
+				// The blocking Windows Socket 1.1 call was canceled through WSACancelBlockingCall. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_SOCKET_ALREADY_CANCELLED );
+				break;
+			case WSAEINPROGRESS:
+				// A blocking Windows Sockets 1.1 call is in progress, or the service provider is still processing a callback function. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_CALLBACK_IN_PROGRESS );
+				break;
+			case WSAEALREADY:
+				// A nonblocking connect call is in progress on the specified socket.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_CONNECTION_IN_PROGRESS );
+				break;
+			case WSAEADDRNOTAVAIL:
+				// The remote address is not a valid address (such as INADDR_ANY).
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_INVALID_IPADDRESS );
+				break;
+			case WSAEAFNOSUPPORT:
+				// Addresses in the specified family cannot be used with this socket.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_UNSUPPORTED_ADDRESS_FAMILY );
+				break;
+			case WSAECONNREFUSED:
+				// The attempt to connect was forcefully rejected.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_CONNECTION_REFUSED );
+				break;
+			case WSAEFAULT:
+				// The name or the namelen parameter is not a valid part of the user address space, the namelen parameter is
+				// too small, or the name parameter contains incorrect address format for the associated address family.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_INVALID_SOCKETS_NAME_FIELD );
+				break;
+			case WSAEINVAL:
+				// The parameter s is a listening socket.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_INVALID_PARAMETER );
+				break;
+			case WSAEISCONN:
+				// The socket is already connected (connection-oriented sockets only).
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_ALREADY_CONNECTED );
+				break;
+			case WSAENETUNREACH:
+			case WSAEHOSTUNREACH:
+				// The network or the remote host cannot be reached from this host at this time.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_REMOTE_HOST_UNREACHABLE );
+				break;
+			case WSAENOBUFS:
+				// No buffer space is available. The socket cannot be connected.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_CANNOT_CREATE_SOCKET );
+				break;
+			case WSAENOTSOCK:
+				// The descriptor is not a socket. 
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_INVALID_SOCKET_DESCRIPTOR );
+				break;
+			case WSAETIMEDOUT:
+				// An attempt to connect timed out without establishing a connection.
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_CONNECTION_TIMEOUT );
+				break;
+			default:
+				RespondToError( MODULE_WINSOCKAPI, WINSOCKAPI_ERROR_UNKNOWN );
+				break;
+			}
+		}
+	return bNoError;
+}
+
+
 BOOL WindowsGetSocketName( SOCKET SocketDescriptor, struct sockaddr *pInternetAddr )
 {
 	// The getsockname() function retrieves the local name for a socket.
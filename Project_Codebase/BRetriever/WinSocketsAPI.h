@@ -85,8 +85,10 @@
 #define WINSOCKAPI_ERROR_REMOTE_HOST_UNREACHABLE		54
 #define WINSOCKAPI_ERROR_MUST_LISTEN_BEFORE_ACCEPT		55
 #define WINSOCKAPI_ERROR_RECEIVE_TIMEOUT				56
+#define WINSOCKAPI_ERROR_CONNECTION_REFUSED				57
+#define WINSOCKAPI_ERROR_CONNECTION_IN_PROGRESS			58
 
-#define WINSOCKAPI_ERROR_DICT_LENGTH					56
+#define WINSOCKAPI_ERROR_DICT_LENGTH					58
 
 
 
@@ -104,6 +106,8 @@ BOOL		WindowsGetSocketName( SOCKET SocketDescriptor, struct sockaddr *pInternetA
 BOOL		WindowsSocketListen( SOCKET SocketDescriptor, int nMaxPendingConnectionBacklog );
 BOOL		WindowsSocketAccept( SOCKET ListeningSocket, SOCKET *pConnectingSocket, struct sockaddr *pInternetAddr );
 BOOL		GetWindowsHostByAddress( char *pAddressBuffer, int AddressLength, int AddressType, hostent **ppHostInformation );
+BOOL		GetWindowsHostByName( char *pHostName, hostent **ppHostInformation );
+BOOL		WindowsSocketConnect( SOCKET SocketDescriptor, struct sockaddr *pInternetAddr );
 BOOL		WindowsSocketReceive( SOCKET SocketDescriptor, char *pDataBuffer, int BufferLength, int Flags, int *pnBytesRead, BOOL bErrorOnDisconnect );
 BOOL		WindowsSocketSend( SOCKET SocketDescriptor, char *pDataBuffer, int BufferLength, int Flags, int *pnBytesSent );
 BOOL		WindowsSocketShutdown( SOCKET SocketDescriptor, int TypeOfShutdown );
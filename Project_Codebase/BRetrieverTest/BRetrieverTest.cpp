@@ -0,0 +1,152 @@
+// BRetrieverTest.cpp : Implements the test program for the BRetriever modules that can
+//	be exercised without a remote Dicom node or the Windows service environment.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "BRetrieverTest.h"
+
+
+static char					TestDataDirectory[ MAX_FILE_SPEC_LENGTH ] = DEFAULT_TEST_DATA_DIRECTORY;
+static long					nTestsPassed = 0;
+static long					nTestsFailed = 0;
+
+
+// Record and report the outcome of a single test check.
+void CheckTestResult( BOOL bTestPassed, char *pTestDescription )
+{
+	if ( bTestPassed )
+		{
+		nTestsPassed++;
+		printf( "    Passed:  %s\n", pTestDescription );
+		}
+	else
+		{
+		nTestsFailed++;
+		printf( "*** FAILED:  %s\n", pTestDescription );
+		}
+}
+
+
+void GetTestDataFileSpec( char *pRelativeFileSpec, char *pFileSpec, size_t nBufferSize )
+{
+	strncpy_s( pFileSpec, nBufferSize, TestDataDirectory, _TRUNCATE );
+	strncat_s( pFileSpec, nBufferSize, pRelativeFileSpec, _TRUNCATE );
+}
+
+
+// Read an entire file into a newly allocated buffer, which the caller frees.
+BOOL ReadFileContents( char *pFileSpec, char **ppFileData, unsigned long *pFileSize )
+{
+	BOOL			bNoError = TRUE;
+	FILE			*pDataFile;
+	long			FileSize;
+
+	*ppFileData = 0;
+	*pFileSize = 0;
+	pDataFile = fopen( pFileSpec, "rb" );
+	bNoError = ( pDataFile != 0 );
+	if ( bNoError )
+		{
+		bNoError = ( fseek( pDataFile, 0, SEEK_END ) == 0 );
+		FileSize = ftell( pDataFile );
+		bNoError = ( bNoError && FileSize >= 0 && fseek( pDataFile, 0, SEEK_SET ) == 0 );
+		}
+	if ( bNoError )
+		{
+		*ppFileData = (char*)malloc( FileSize + 1 );
+		bNoError = ( *ppFileData != 0 );
+		}
+	if ( bNoError )
+		{
+		bNoError = ( fread( *ppFileData, 1, FileSize, pDataFile ) == (size_t)FileSize );
+		( *ppFileData )[ FileSize ] = '\0';
+		*pFileSize = (unsigned long)FileSize;
+		}
+	if ( pDataFile != 0 )
+		fclose( pDataFile );
+	if ( !bNoError )
+		{
+		if ( *ppFileData != 0 )
+			free( *ppFileData );
+		*ppFileData = 0;
+		}
+
+	return bNoError;
+}
+
+
+BOOL ReadTestDataFile( char *pRelativeFileSpec, char **ppFileData, unsigned long *pFileSize )
+{
+	BOOL			bNoError = TRUE;
+	char			FileSpec[ MAX_FILE_SPEC_LENGTH ];
+
+	GetTestDataFileSpec( pRelativeFileSpec, FileSpec, MAX_FILE_SPEC_LENGTH );
+	bNoError = ReadFileContents( FileSpec, ppFileData, pFileSize );
+	if ( !bNoError )
+		printf( "Unable to read the test data file %s\n", FileSpec );
+
+	return bNoError;
+}
+
+
+// BRetrieverTest exercises the BRetriever modules that do their work without the Dicom
+// network or the service environment:  the image decoders, the pixel statistics, the Dicom
+// archive packs, the Dicom dictionary, the Dicom element parser, the composition of Dicom
+// output files and the client host name cache.  The service functions these modules call are
+// replaced by the stand-ins in TestStubs.cpp, and DNS by the stub resolver in TestHostNameCache.cpp.  Run the program from the BRetrieverTest
+// folder, or name the test data folder (ending in a backslash) on the command line.  The
+// exit code is the number of failed checks.
+int main( int argc, char *argv[] )
+{
+	if ( argc > 1 )
+		strncpy_s( TestDataDirectory, MAX_FILE_SPEC_LENGTH, argv[ 1 ], _TRUNCATE );
+
+	printf( "JPEG 2000 decoder:\n" );
+	TestJpeg2000Decoder();
+	printf( "\nLossless JPEG decoder:\n" );
+	TestLosslessJpegDecoder();
+	printf( "\nPixel statistics:\n" );
+	TestPixelStatistics();
+	printf( "\nDicom archive packs:\n" );
+	TestDicomArchive();
+	printf( "\nDicom dictionary:\n" );
+	TestDicomDictionary();
+	printf( "\nDicom element parser:\n" );
+	TestDicomParser();
+	printf( "\nDicom output composition:\n" );
+	TestDicomOutput();
+	printf( "\nClient host name cache:\n" );
+	TestHostNameCache();
+	printf( "\nOperation wakeups:\n" );
+	TestOperationWakeup();
+	printf( "\nDicom forwarding:\n" );
+	TestDicomForwarding();
+	printf( "\nProcessing metrics:\n" );
+	TestProcessingMetrics();
+
+	printf( "\n%ld checks passed, %ld failed.\n", nTestsPassed, nTestsFailed );
+
+	return (int)nTestsFailed;
+}
+
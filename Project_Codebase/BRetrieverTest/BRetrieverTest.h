@@ -0,0 +1,71 @@
+// BRetrieverTest.h : Defines the functions shared by the BRetriever module tests.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#pragma once
+
+
+// The test data files are read from this directory, unless another is named on the
+// command line.
+#define DEFAULT_TEST_DATA_DIRECTORY			".\\TestData\\"
+
+// Image files produced by the modules under test are written here and then deleted.
+#define TEST_OUTPUT_FILE_SPEC				".\\BRetrieverTest.png"
+
+// Archive packs are written to, and extracted into, these directories, which are then removed.
+#define TEST_ARCHIVE_DIRECTORY				".\\BRetrieverTestArchive"
+#define TEST_EXTRACT_DIRECTORY				".\\BRetrieverTestExtract"
+
+// Composed Dicom output files, and the edit specification files for them, are written here and
+// then removed.
+#define TEST_DICOM_OUTPUT_DIRECTORY			".\\BRetrieverTestDicomOutput"
+
+// Images forwarded to the stand-in Dicom destination are written here and then removed.
+#define TEST_FORWARDING_DIRECTORY			".\\BRetrieverTestForwarding"
+
+// The processing metrics file is written here and then deleted.
+#define TEST_METRICS_FILE_SPEC				".\\BRetrieverTestMetrics.prom"
+
+
+// Function prototypes.
+//
+void			CheckTestResult( BOOL bTestPassed, char *pTestDescription );
+void			GetTestDataFileSpec( char *pRelativeFileSpec, char *pFileSpec, size_t nBufferSize );
+BOOL			ReadFileContents( char *pFileSpec, char **ppFileData, unsigned long *pFileSize );
+BOOL			ReadTestDataFile( char *pRelativeFileSpec, char **ppFileData, unsigned long *pFileSize );
+
+void			ClearConvertedImage();
+BOOL			GetConvertedImage( char **ppImageData, unsigned long *pImageLength );
+
+void			TestJpeg2000Decoder();
+void			TestLosslessJpegDecoder();
+void			TestPixelStatistics();
+void			TestDicomArchive();
+void			TestDicomDictionary();
+void			TestDicomParser();
+void			TestDicomOutput();
+void			TestHostNameCache();
+void			TestOperationWakeup();
+void			TestDicomForwarding();
+void			TestProcessingMetrics();
+
@@ -0,0 +1,176 @@
+// FuzzDicomParser.cpp : Implements the parsing of Dicom file data held in memory, for the tests
+//	in TestDicomParser.cpp and for a libFuzzer entry point.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Exam.h"
+#include "BRetrieverTest.h"
+#include "FuzzDicomParser.h"
+
+
+// The Dicom data are divided among buffers of the size ReadDicomHeaderInfo() reads from a file.
+// Each buffer is allocated to the exact length of its data, so that a debug heap or address
+// sanitizer can detect a parser read beyond the end of the data.
+static BOOL LoadDicomDataBuffers( char *pDicomData, unsigned long nDataBytes, DICOM_HEADER_SUMMARY *pDicomHeader )
+{
+	BOOL					bNoError = TRUE;
+	DICOM_DATA_BUFFER		*pDicomBuffer;
+	char					*pBuffer;
+	unsigned long			nBufferBytes;
+
+	while ( bNoError && nDataBytes > 0 )
+		{
+		nBufferBytes = nDataBytes;
+		if ( nBufferBytes > MAX_DICOM_READ_BUFFER_SIZE )
+			nBufferBytes = MAX_DICOM_READ_BUFFER_SIZE;
+		pBuffer = (char*)malloc( nBufferBytes );
+		pDicomBuffer = (DICOM_DATA_BUFFER*)calloc( 1, sizeof(DICOM_DATA_BUFFER) );
+		bNoError = ( pBuffer != 0 && pDicomBuffer != 0 );
+		if ( bNoError )
+			{
+			memcpy( pBuffer, pDicomData, nBufferBytes );
+			pDicomBuffer -> pBuffer = pBuffer;
+			pDicomBuffer -> pBeginningOfDicomData = pBuffer;
+			pDicomBuffer -> BufferSize = nBufferBytes;
+			pDicomBuffer -> DataSize = nBufferBytes;
+			pDicomBuffer -> BytesRemainingToBeProcessed = nBufferBytes;
+			bNoError = AppendToList( &pDicomHeader -> ListOfInputBuffers, (void*)pDicomBuffer );
+			}
+		if ( bNoError )
+			{
+			pDicomData += nBufferBytes;
+			nDataBytes -= nBufferBytes;
+			}
+		else
+			{
+			if ( pBuffer != 0 )
+				free( pBuffer );
+			if ( pDicomBuffer != 0 )
+				free( pDicomBuffer );
+			}
+		}
+
+	return bNoError;
+}
+
+
+// Parse Dicom file data held in memory, following the steps of ReadDicomHeaderInfo() from the
+// Dicom file signature through the location of the image data.  The Dicom header summary is
+// returned even if the parse fails, and is released by FreeParsedDicomData().
+BOOL ParseDicomData( char *pDicomData, unsigned long nDataBytes, EXAM_INFO *pExamInfo, DICOM_HEADER_SUMMARY **ppDicomHeader )
+{
+	BOOL					bNoError = TRUE;
+	DICOM_HEADER_SUMMARY	*pDicomHeader;
+	LIST_ELEMENT			*pBufferListElement;
+	size_t					nBytesParsed;
+
+	InitSpecialDicomElements();
+	memset( pExamInfo, 0, sizeof(EXAM_INFO) );
+	pDicomHeader = (DICOM_HEADER_SUMMARY*)calloc( 1, sizeof(DICOM_HEADER_SUMMARY) );
+	*ppDicomHeader = pDicomHeader;
+	bNoError = ( pDicomHeader != 0 );
+	if ( bNoError )
+		{
+		InitDicomHeaderSummary( pDicomHeader );
+		// The file must begin with the 128-byte preamble and the Dicom signature.
+		bNoError = ( nDataBytes >= 132 && strncmp( pDicomData + 128, "DICM", 4 ) == 0 );
+		}
+	if ( bNoError )
+		bNoError = LoadDicomDataBuffers( pDicomData + 132, nDataBytes - 132, pDicomHeader );
+	pBufferListElement = 0;
+	if ( bNoError )
+		{
+		pBufferListElement = pDicomHeader -> ListOfInputBuffers;
+		bNoError = ( pBufferListElement != 0 );
+		}
+	if ( bNoError )
+		bNoError = ParseDicomGroup2Info( &pBufferListElement, pDicomHeader, FALSE );
+	if ( bNoError )
+		bNoError = ParseDicomHeaderInfo( &pBufferListElement, pExamInfo, pDicomHeader, FALSE );
+	if ( bNoError )
+		{
+		nBytesParsed = 0;
+		bNoError = ProcessDicomImageDataElements( &pBufferListElement, pDicomHeader, &nBytesParsed, FALSE );
+		}
+
+	return bNoError;
+}
+
+
+// Release everything allocated by ParseDicomData(), as the product dispatcher does when it
+// has finished with an image.
+void FreeParsedDicomData( EXAM_INFO *pExamInfo, DICOM_HEADER_SUMMARY *pDicomHeader )
+{
+	if ( pDicomHeader != 0 )
+		{
+		if ( pDicomHeader -> pImageData != 0 )
+			free( pDicomHeader -> pImageData );
+		if ( pDicomHeader -> CalibrationInfo.pModalityLUTData != 0 )
+			free( pDicomHeader -> CalibrationInfo.pModalityLUTData );
+		if ( pDicomHeader -> CalibrationInfo.pVOI_LUTData != 0 )
+			free( pDicomHeader -> CalibrationInfo.pVOI_LUTData );
+		DeallocateInputBuffers( pDicomHeader );
+		DeallocateListOfDicomElements( pDicomHeader );
+		free( pDicomHeader );
+		}
+	pExamInfo -> pDicomInfo = 0;
+	DeallocateExamInfoAttributes( pExamInfo );
+}
+
+
+// The libFuzzer entry point.  The Fuzz configuration of BRetrieverTest.vcxproj builds the fuzz
+// target from this file, TestStubs.cpp and the BRetriever sources, with /fsanitize=address and
+// /fsanitize=fuzzer, leaving out BRetrieverTest.cpp and the Test*.cpp files.  Run it from the
+// BRetrieverTest folder, with TestData\DicomParser as the seed corpus:
+//
+//		Fuzz\FuzzDicomParser.exe FuzzCorpus TestData\DicomParser
+//
+// The ASan configuration builds the test program itself with /fsanitize=address, so that the
+// parser tests and the stored fuzz corpus run under the address sanitizer.  Both need the
+// sanitizer runtime DLLs of the Visual C++ tools on the PATH, as when run from Visual Studio.
+//
+// The Dicom dictionary used is TestData\DicomParser\ParserDictionary.txt.
+extern "C" int LLVMFuzzerTestOneInput( const unsigned char *pData, size_t nDataBytes )
+{
+	static BOOL				bDictionaryIsLoaded = FALSE;
+	char					DictionaryFileSpec[ MAX_FILE_SPEC_LENGTH ] = DEFAULT_TEST_DATA_DIRECTORY "DicomParser\\ParserDictionary.txt";
+	EXAM_INFO				ExamInfo;
+	DICOM_HEADER_SUMMARY	*pDicomHeader;
+
+	if ( !bDictionaryIsLoaded )
+		{
+		InitDictionaryModule();
+		bDictionaryIsLoaded = ReadDictionaryFile( DictionaryFileSpec, FALSE );
+		}
+	if ( nDataBytes <= 0x7FFFFFFF )
+		{
+		ParseDicomData( (char*)pData, (unsigned long)nDataBytes, &ExamInfo, &pDicomHeader );
+		FreeParsedDicomData( &ExamInfo, pDicomHeader );
+		}
+
+	return 0;
+}
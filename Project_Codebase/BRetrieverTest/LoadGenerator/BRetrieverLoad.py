@@ -0,0 +1,518 @@
+# BRetrieverLoad.py : A headless load generator and benchmark for the BRetriever Dicom acceptor.
+#
+#	Synthetic computed radiography images are sent to BRetriever as C-STORE requests, over one
+#	or more concurrent associations, at an optional fixed rate.  The images are generated here,
+#	in memory, so no image corpus is needed.  Each image gets a new SOP Instance UID.
+#
+#	The tool reports:
+#
+#		Throughput		Images and megabytes per second, from the first association request
+#						to the last release.
+#		Store latency	The time from the start of each C-STORE request to the arrival of its
+#						C-STORE response (p50, p99 and maximum).
+#		Output latency	If --png-folder is given, the time from the start of each C-STORE
+#						request until BRetriever writes <SOP Instance UID>.png into that folder
+#						(p50, p99 and maximum).  If --axt-folder is given, the same for the
+#						abstract (.axt) files, which are matched by count.
+#
+#	Only the Python standard library is used, so the tool runs on any machine that can reach
+#	the BRetriever Dicom port, including Linux loopback setups.  The exit code is zero only if
+#	every image was stored with a success status (and appeared in the output folders, if given).
+#
+#	Usage:  python BRetrieverLoad.py --host 127.0.0.1 --port 105 --called-ae BRETRIEVER
+#				--images 200 --associations 4 --rate 50 --max-pdu 16384 --png-folder <folder>
+#
+#			python BRetrieverLoad.py --echo      (C-ECHO only, to check the connection)
+#
+import argparse
+import os
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+import uuid
+
+
+APPLICATION_CONTEXT_UID = '1.2.840.10008.3.1.1.1'
+VERIFICATION_SOP_CLASS_UID = '1.2.840.10008.1.1'
+CR_IMAGE_STORAGE_SOP_CLASS_UID = '1.2.840.10008.5.1.4.1.1.1'
+IMPLICIT_LITTLE_ENDIAN = '1.2.840.10008.1.2'
+IMPLEMENTATION_CLASS_UID = '2.25.173820540417336245623813287004566731019'
+IMPLEMENTATION_VERSION_NAME = 'BRETRIEVERLOAD'
+
+PRESENTATION_CONTEXT_VERIFICATION = 1
+PRESENTATION_CONTEXT_STORAGE = 3
+
+PDU_ASSOCIATE_RQ = 0x01
+PDU_ASSOCIATE_AC = 0x02
+PDU_ASSOCIATE_RJ = 0x03
+PDU_DATA_TF = 0x04
+PDU_RELEASE_RQ = 0x05
+PDU_RELEASE_RP = 0x06
+PDU_ABORT = 0x07
+
+COMMAND_C_STORE_RQ = 0x0001
+COMMAND_C_ECHO_RQ = 0x0030
+DATA_SET_PRESENT = 0x0000
+NO_DATA_SET = 0x0101
+
+STATUS_SUCCESS = 0x0000
+
+
+class AssociationError( Exception ):
+	pass
+
+
+# -------------------------------------------------------------------------------------------------
+#	Dicom encoding, implicit VR little endian.
+# -------------------------------------------------------------------------------------------------
+
+def PadText( Value, PadByte = b' ' ):
+	if isinstance( Value, str ):
+		Value = Value.encode( 'ascii' )
+	if len( Value ) % 2 != 0:
+		Value += PadByte
+	return Value
+
+
+def ImplicitElement( Group, ElementNumber, Value ):
+	return struct.pack( '<HHI', Group, ElementNumber, len( Value ) ) + Value
+
+
+def UIDValue( UID ):
+	return PadText( UID, b'\x00' )
+
+
+def UnsignedShortValue( Value ):
+	return struct.pack( '<H', Value )
+
+
+def EncodeCommand( Elements ):
+	# The command group length, (0000,0000), precedes the other command elements.
+	Body = b''.join( ImplicitElement( 0x0000, ElementNumber, Value ) for ElementNumber, Value in sorted( Elements ) )
+	return ImplicitElement( 0x0000, 0x0000, struct.pack( '<I', len( Body ) ) ) + Body
+
+
+def MakeCStoreRequest( MessageID, SOPClassUID, SOPInstanceUID ):
+	return EncodeCommand( [ ( 0x0002, UIDValue( SOPClassUID ) ),
+							( 0x0100, UnsignedShortValue( COMMAND_C_STORE_RQ ) ),
+							( 0x0110, UnsignedShortValue( MessageID ) ),
+							( 0x0700, UnsignedShortValue( 0 ) ),
+							( 0x0800, UnsignedShortValue( DATA_SET_PRESENT ) ),
+							( 0x1000, UIDValue( SOPInstanceUID ) ) ] )
+
+
+def MakeCEchoRequest( MessageID ):
+	return EncodeCommand( [ ( 0x0002, UIDValue( VERIFICATION_SOP_CLASS_UID ) ),
+							( 0x0100, UnsignedShortValue( COMMAND_C_ECHO_RQ ) ),
+							( 0x0110, UnsignedShortValue( MessageID ) ),
+							( 0x0800, UnsignedShortValue( NO_DATA_SET ) ) ] )
+
+
+def ReadCommandStatus( Command ):
+	# Return the (0000,0900) status of a response command, or None if it is missing.
+	Offset = 0
+	while Offset + 8 <= len( Command ):
+		Group, ElementNumber, Length = struct.unpack_from( '<HHI', Command, Offset )
+		Offset += 8
+		if Group == 0x0000 and ElementNumber == 0x0900 and Length == 2:
+			return struct.unpack_from( '<H', Command, Offset )[ 0 ]
+		Offset += Length
+	return None
+
+
+def NewUID():
+	# A UID derived from a random UUID, under the 2.25 root, which needs no registration.
+	return '2.25.%d' % uuid.uuid4().int
+
+
+class ImageGenerator:
+	# Synthetic 12-bit CR images.  The pixel data is generated once per size; the identifying
+	# elements differ per image, so that each image is a new instance to BRetriever.
+	def __init__( self, Columns, Rows, Seed ):
+		self.Columns = Columns
+		self.Rows = Rows
+		self.Random = random.Random( Seed )
+		self.Lock = threading.Lock()
+		self.PatientID = 'LOAD%06d' % self.Random.randint( 0, 999999 )
+		self.nImages = 0
+		Pixels = bytearray()
+		for y in range( Rows ):
+			# A horizontal gradient, shifted by a random amount on each row.
+			Shift = self.Random.randint( 0, 255 )
+			for x in range( Columns ):
+				Pixels += struct.pack( '<H', ( ( x + Shift ) * 4095 // max( 1, Columns - 1 ) ) % 4096 )
+		self.PixelData = bytes( Pixels )
+		self.StudyInstanceUID = NewUID()
+		self.SeriesInstanceUID = NewUID()
+
+	def MakeImage( self ):
+		# Return ( SOP Instance UID, data set ).
+		with self.Lock:
+			self.nImages += 1
+			nImage = self.nImages
+		SOPInstanceUID = NewUID()
+		Elements = [
+			( 0x0008, 0x0016, UIDValue( CR_IMAGE_STORAGE_SOP_CLASS_UID ) ),
+			( 0x0008, 0x0018, UIDValue( SOPInstanceUID ) ),
+			( 0x0008, 0x0020, PadText( time.strftime( '%Y%m%d' ) ) ),
+			( 0x0008, 0x0030, PadText( time.strftime( '%H%M%S' ) ) ),
+			( 0x0008, 0x0060, PadText( 'CR' ) ),
+			( 0x0008, 0x0070, PadText( 'BRetrieverLoad' ) ),
+			( 0x0010, 0x0010, PadText( 'LOAD^TEST' ) ),
+			( 0x0010, 0x0020, PadText( self.PatientID ) ),
+			( 0x0018, 0x0015, PadText( 'CHEST' ) ),
+			( 0x0020, 0x000D, UIDValue( self.StudyInstanceUID ) ),
+			( 0x0020, 0x000E, UIDValue( self.SeriesInstanceUID ) ),
+			( 0x0020, 0x0013, PadText( str( nImage ) ) ),
+			( 0x0028, 0x0002, UnsignedShortValue( 1 ) ),
+			( 0x0028, 0x0004, PadText( 'MONOCHROME2' ) ),
+			( 0x0028, 0x0010, UnsignedShortValue( self.Rows ) ),
+			( 0x0028, 0x0011, UnsignedShortValue( self.Columns ) ),
+			( 0x0028, 0x0100, UnsignedShortValue( 16 ) ),
+			( 0x0028, 0x0101, UnsignedShortValue( 12 ) ),
+			( 0x0028, 0x0102, UnsignedShortValue( 11 ) ),
+			( 0x0028, 0x0103, UnsignedShortValue( 0 ) ),
+			( 0x7FE0, 0x0010, self.PixelData ) ]
+		DataSet = b''.join( ImplicitElement( Group, ElementNumber, Value ) for Group, ElementNumber, Value in Elements )
+		return SOPInstanceUID, DataSet
+
+
+# -------------------------------------------------------------------------------------------------
+#	Dicom upper layer protocol.
+# -------------------------------------------------------------------------------------------------
+
+def Item( ItemType, Payload ):
+	return struct.pack( '>BBH', ItemType, 0, len( Payload ) ) + Payload
+
+
+def PresentationContextItem( PresentationContextID, AbstractSyntaxUID ):
+	Payload = struct.pack( '>BBBB', PresentationContextID, 0, 0, 0 )
+	Payload += Item( 0x30, AbstractSyntaxUID.encode( 'ascii' ) )
+	Payload += Item( 0x40, IMPLICIT_LITTLE_ENDIAN.encode( 'ascii' ) )
+	return Item( 0x20, Payload )
+
+
+def MakeAssociateRequest( CalledAE, CallingAE, MaxPDULength ):
+	Payload = struct.pack( '>HH', 1, 0 )
+	Payload += CalledAE.encode( 'ascii' )[ :16 ].ljust( 16 )
+	Payload += CallingAE.encode( 'ascii' )[ :16 ].ljust( 16 )
+	Payload += bytes( 32 )
+	Payload += Item( 0x10, APPLICATION_CONTEXT_UID.encode( 'ascii' ) )
+	Payload += PresentationContextItem( PRESENTATION_CONTEXT_VERIFICATION, VERIFICATION_SOP_CLASS_UID )
+	Payload += PresentationContextItem( PRESENTATION_CONTEXT_STORAGE, CR_IMAGE_STORAGE_SOP_CLASS_UID )
+	UserInformation = Item( 0x51, struct.pack( '>I', MaxPDULength ) )
+	UserInformation += Item( 0x52, IMPLEMENTATION_CLASS_UID.encode( 'ascii' ) )
+	UserInformation += Item( 0x55, IMPLEMENTATION_VERSION_NAME.encode( 'ascii' ) )
+	Payload += Item( 0x50, UserInformation )
+	return struct.pack( '>BBI', PDU_ASSOCIATE_RQ, 0, len( Payload ) ) + Payload
+
+
+class Association:
+	def __init__( self, Host, Port, CalledAE, CallingAE, MaxPDULength, TimeoutInSeconds ):
+		self.Socket = socket.create_connection( ( Host, Port ), timeout = TimeoutInSeconds )
+		self.Socket.setsockopt( socket.IPPROTO_TCP, socket.TCP_NODELAY, 1 )
+		self.MaxPDULength = MaxPDULength
+		self.AcceptedContexts = set()
+		self.nMessageID = 0
+		self.Socket.sendall( MakeAssociateRequest( CalledAE, CallingAE, MaxPDULength ) )
+		PDUType, Payload = self.ReceivePDU()
+		if PDUType == PDU_ASSOCIATE_RJ:
+			raise AssociationError( 'Association rejected:  result %d, source %d, reason %d' % tuple( Payload[ 1:4 ] ) )
+		if PDUType != PDU_ASSOCIATE_AC:
+			raise AssociationError( 'Unexpected PDU type %d in reply to the association request' % PDUType )
+		self.ParseAssociateAccept( Payload )
+
+	def ParseAssociateAccept( self, Payload ):
+		Offset = 68
+		while Offset + 4 <= len( Payload ):
+			ItemType, Length = struct.unpack_from( '>BxH', Payload, Offset )
+			ItemPayload = Payload[ Offset + 4 : Offset + 4 + Length ]
+			if ItemType == 0x21 and len( ItemPayload ) >= 4 and ItemPayload[ 2 ] == 0:
+				self.AcceptedContexts.add( ItemPayload[ 0 ] )
+			elif ItemType == 0x50:
+				nSubitemOffset = 0
+				while nSubitemOffset + 4 <= len( ItemPayload ):
+					SubitemType, SubitemLength = struct.unpack_from( '>BxH', ItemPayload, nSubitemOffset )
+					if SubitemType == 0x51 and SubitemLength == 4:
+						AcceptorMaxPDULength = struct.unpack_from( '>I', ItemPayload, nSubitemOffset + 4 )[ 0 ]
+						# Zero means the acceptor set no limit.
+						if AcceptorMaxPDULength != 0:
+							self.MaxPDULength = min( self.MaxPDULength, AcceptorMaxPDULength )
+					nSubitemOffset += 4 + SubitemLength
+			Offset += 4 + Length
+
+	def ReceiveBytes( self, nBytes ):
+		Chunks = []
+		while nBytes > 0:
+			Chunk = self.Socket.recv( min( nBytes, 1 << 20 ) )
+			if not Chunk:
+				raise AssociationError( 'The connection was closed by BRetriever' )
+			Chunks.append( Chunk )
+			nBytes -= len( Chunk )
+		return b''.join( Chunks )
+
+	def ReceivePDU( self ):
+		PDUType, PDULength = struct.unpack( '>BxI', self.ReceiveBytes( 6 ) )
+		Payload = self.ReceiveBytes( PDULength )
+		if PDUType == PDU_ABORT:
+			raise AssociationError( 'Association aborted:  source %d, reason %d' % ( Payload[ 2 ], Payload[ 3 ] ) )
+		return PDUType, Payload
+
+	def SendMessage( self, PresentationContextID, Message, bCommand ):
+		# Fragment the message into P-DATA-TF PDUs of one presentation data value each, within
+		# the negotiated maximum PDU length (which counts the 6-byte PDV header).
+		nMaxFragment = max( 2, self.MaxPDULength - 6 )
+		Offset = 0
+		while True:
+			Fragment = Message[ Offset : Offset + nMaxFragment ]
+			Offset += len( Fragment )
+			ControlHeader = ( 0x01 if bCommand else 0x00 ) | ( 0x02 if Offset >= len( Message ) else 0x00 )
+			PDV = struct.pack( '>IBB', len( Fragment ) + 2, PresentationContextID, ControlHeader ) + Fragment
+			self.Socket.sendall( struct.pack( '>BBI', PDU_DATA_TF, 0, len( PDV ) ) + PDV )
+			if Offset >= len( Message ):
+				break
+
+	def ReceiveResponseStatus( self ):
+		Command = b''
+		while True:
+			PDUType, Payload = self.ReceivePDU()
+			if PDUType != PDU_DATA_TF:
+				raise AssociationError( 'Unexpected PDU type %d while waiting for a response' % PDUType )
+			Offset = 0
+			while Offset + 6 <= len( Payload ):
+				PDVLength, PresentationContextID, ControlHeader = struct.unpack_from( '>IBB', Payload, Offset )
+				Command += Payload[ Offset + 6 : Offset + 4 + PDVLength ]
+				Offset += 4 + PDVLength
+				if ( ControlHeader & 0x03 ) == 0x03:
+					return ReadCommandStatus( Command )
+
+	def NextMessageID( self ):
+		self.nMessageID = ( self.nMessageID % 0xFFFF ) + 1
+		return self.nMessageID
+
+	def Echo( self ):
+		if PRESENTATION_CONTEXT_VERIFICATION not in self.AcceptedContexts:
+			raise AssociationError( 'BRetriever did not accept the verification presentation context' )
+		self.SendMessage( PRESENTATION_CONTEXT_VERIFICATION, MakeCEchoRequest( self.NextMessageID() ), True )
+		return self.ReceiveResponseStatus()
+
+	def Store( self, SOPInstanceUID, DataSet ):
+		if PRESENTATION_CONTEXT_STORAGE not in self.AcceptedContexts:
+			raise AssociationError( 'BRetriever did not accept the CR image storage presentation context' )
+		Command = MakeCStoreRequest( self.NextMessageID(), CR_IMAGE_STORAGE_SOP_CLASS_UID, SOPInstanceUID )
+		self.SendMessage( PRESENTATION_CONTEXT_STORAGE, Command, True )
+		self.SendMessage( PRESENTATION_CONTEXT_STORAGE, DataSet, False )
+		return self.ReceiveResponseStatus()
+
+	def Release( self ):
+		try:
+			self.Socket.sendall( struct.pack( '>BBIxxxx', PDU_RELEASE_RQ, 0, 4 ) )
+			PDUType, Payload = self.ReceivePDU()
+			if PDUType != PDU_RELEASE_RP:
+				raise AssociationError( 'Unexpected PDU type %d in reply to the release request' % PDUType )
+		finally:
+			self.Socket.close()
+
+
+# -------------------------------------------------------------------------------------------------
+#	Load generation.
+# -------------------------------------------------------------------------------------------------
+
+class LoadRun:
+	def __init__( self, Arguments ):
+		self.Arguments = Arguments
+		self.Images = ImageGenerator( Arguments.columns, Arguments.rows, Arguments.seed )
+		self.Lock = threading.Lock()
+		self.nNextImage = 0
+		self.StoreLatencies = []
+		self.SendTimes = {}
+		self.SendOrder = []
+		self.nBytesSent = 0
+		self.Failures = []
+		self.StartTime = 0.0
+		self.bSendingComplete = False
+		self.PNGLatencies = []
+		self.AXTLatencies = []
+		self.nMissingPNG = 0
+		self.nMissingAXT = 0
+
+	def ClaimImage( self ):
+		# Return the index of the next image to send, or None when all are claimed.  With a
+		# fixed rate, wait for the image's scheduled send time.
+		with self.Lock:
+			if self.nNextImage >= self.Arguments.images:
+				return None
+			nImage = self.nNextImage
+			self.nNextImage += 1
+		if self.Arguments.rate > 0:
+			Delay = self.StartTime + nImage / self.Arguments.rate - time.monotonic()
+			if Delay > 0:
+				time.sleep( Delay )
+		return nImage
+
+	def AssociationThread( self ):
+		try:
+			TheAssociation = Association( self.Arguments.host, self.Arguments.port, self.Arguments.called_ae,
+											self.Arguments.calling_ae, self.Arguments.max_pdu, self.Arguments.timeout )
+			try:
+				while True:
+					nImage = self.ClaimImage()
+					if nImage is None:
+						break
+					SOPInstanceUID, DataSet = self.Images.MakeImage()
+					SendTime = time.monotonic()
+					# Record the send time first, since the outputs may appear before the response.
+					with self.Lock:
+						self.SendTimes[ SOPInstanceUID ] = SendTime
+						self.SendOrder.append( SOPInstanceUID )
+					Status = TheAssociation.Store( SOPInstanceUID, DataSet )
+					StoreLatency = time.monotonic() - SendTime
+					with self.Lock:
+						if Status == STATUS_SUCCESS:
+							self.StoreLatencies.append( StoreLatency )
+							self.nBytesSent += len( DataSet )
+						else:
+							# No outputs are expected for an image that was not stored.
+							del self.SendTimes[ SOPInstanceUID ]
+							self.SendOrder.remove( SOPInstanceUID )
+							self.Failures.append( 'C-STORE status %s for %s' % ( 'missing' if Status is None else '0x%04X' % Status, SOPInstanceUID ) )
+			finally:
+				TheAssociation.Release()
+		except ( AssociationError, OSError ) as Error:
+			with self.Lock:
+				self.Failures.append( str( Error ) )
+
+	def WatchOutputFolders( self ):
+		# Poll the output folders while the images are sent, and afterward until every image
+		# has produced its outputs or the output timeout expires.
+		Arguments = self.Arguments
+		KnownAXTFiles = set( os.listdir( Arguments.axt_folder ) ) if Arguments.axt_folder else set()
+		FoundPNG = set()
+		Deadline = None
+		while True:
+			Now = time.monotonic()
+			with self.Lock:
+				bSendingComplete = self.bSendingComplete
+				SendTimes = dict( self.SendTimes )
+				SendOrder = list( self.SendOrder )
+			if Arguments.png_folder:
+				PresentFiles = set( os.listdir( Arguments.png_folder ) )
+				for SOPInstanceUID in SendOrder:
+					if SOPInstanceUID not in FoundPNG and SOPInstanceUID + '.png' in PresentFiles:
+						FoundPNG.add( SOPInstanceUID )
+						self.PNGLatencies.append( Now - SendTimes[ SOPInstanceUID ] )
+			if Arguments.axt_folder:
+				# The abstract files are not named by SOP instance, so they are matched to the
+				# images in order of appearance.
+				for FileName in sorted( os.listdir( Arguments.axt_folder ) ):
+					if FileName.lower().endswith( '.axt' ) and FileName not in KnownAXTFiles and len( self.AXTLatencies ) < len( SendOrder ):
+						KnownAXTFiles.add( FileName )
+						self.AXTLatencies.append( Now - SendTimes[ SendOrder[ len( self.AXTLatencies ) ] ] )
+			self.nMissingPNG = len( SendOrder ) - len( FoundPNG ) if Arguments.png_folder else 0
+			self.nMissingAXT = len( SendOrder ) - len( self.AXTLatencies ) if Arguments.axt_folder else 0
+			if bSendingComplete:
+				if Deadline is None:
+					Deadline = Now + Arguments.output_timeout
+				if ( self.nMissingPNG == 0 and self.nMissingAXT == 0 ) or Now >= Deadline:
+					break
+			time.sleep( Arguments.poll_interval )
+
+	def Run( self ):
+		self.StartTime = time.monotonic()
+		Threads = [ threading.Thread( target = self.AssociationThread ) for n in range( max( 1, self.Arguments.associations ) ) ]
+		if self.Arguments.png_folder or self.Arguments.axt_folder:
+			Watcher = threading.Thread( target = self.WatchOutputFolders )
+			Watcher.start()
+		else:
+			Watcher = None
+		for TheThread in Threads:
+			TheThread.start()
+		for TheThread in Threads:
+			TheThread.join()
+		self.ElapsedTime = time.monotonic() - self.StartTime
+		with self.Lock:
+			self.bSendingComplete = True
+		if Watcher is not None:
+			Watcher.join()
+
+
+def Percentile( Values, Fraction ):
+	# The nearest-rank percentile.
+	if not Values:
+		return 0.0
+	Ordered = sorted( Values )
+	nRank = max( 1, int( Fraction * len( Ordered ) + 0.999999 ) )
+	return Ordered[ min( nRank, len( Ordered ) ) - 1 ]
+
+
+def ReportLatencies( Description, Latencies ):
+	if Latencies:
+		print( '%-16s p50 %8.1f ms   p99 %8.1f ms   max %8.1f ms   (%d images)' % ( Description,
+				1000.0 * Percentile( Latencies, 0.50 ), 1000.0 * Percentile( Latencies, 0.99 ), 1000.0 * max( Latencies ), len( Latencies ) ) )
+
+
+def ParseArguments( ArgumentList ):
+	Parser = argparse.ArgumentParser( description = 'Send synthetic C-STORE load to BRetriever and report throughput and latency.' )
+	Parser.add_argument( '--host', default = '127.0.0.1' )
+	Parser.add_argument( '--port', type = int, default = 105 )
+	Parser.add_argument( '--called-ae', default = 'BRETRIEVER' )
+	Parser.add_argument( '--calling-ae', default = 'BRETRIEVERLOAD' )
+	Parser.add_argument( '--images', type = int, default = 100, help = 'Number of images to send.' )
+	Parser.add_argument( '--associations', type = int, default = 1, help = 'Number of concurrent associations.' )
+	Parser.add_argument( '--rate', type = float, default = 0.0, help = 'Images per second over all associations; 0 sends as fast as possible.' )
+	Parser.add_argument( '--max-pdu', type = int, default = 16384, help = 'Maximum PDU length proposed to BRetriever.' )
+	Parser.add_argument( '--columns', type = int, default = 512 )
+	Parser.add_argument( '--rows', type = int, default = 512 )
+	Parser.add_argument( '--seed', type = int, default = 1 )
+	Parser.add_argument( '--timeout', type = float, default = 60.0, help = 'Socket timeout, in seconds.' )
+	Parser.add_argument( '--png-folder', help = 'Folder where BRetriever writes its .png images.' )
+	Parser.add_argument( '--axt-folder', help = 'Folder where BRetriever writes its .axt abstracts.' )
+	Parser.add_argument( '--output-timeout', type = float, default = 120.0, help = 'Seconds to wait for the output files.' )
+	Parser.add_argument( '--poll-interval', type = float, default = 0.05 )
+	Parser.add_argument( '--echo', action = 'store_true', help = 'Send a C-ECHO and exit.' )
+	Arguments = Parser.parse_args( ArgumentList )
+	if Arguments.max_pdu < 8:
+		Parser.error( '--max-pdu must be at least 8' )
+	return Arguments
+
+
+def main( ArgumentList ):
+	Arguments = ParseArguments( ArgumentList )
+	if Arguments.echo:
+		try:
+			TheAssociation = Association( Arguments.host, Arguments.port, Arguments.called_ae,
+											Arguments.calling_ae, Arguments.max_pdu, Arguments.timeout )
+			try:
+				Status = TheAssociation.Echo()
+			finally:
+				TheAssociation.Release()
+		except ( AssociationError, OSError ) as Error:
+			print( 'C-ECHO failed:  %s' % Error )
+			return 1
+		print( 'C-ECHO status 0x%04X' % ( 0xFFFF if Status is None else Status ) )
+		return 0 if Status == STATUS_SUCCESS else 1
+	TheRun = LoadRun( Arguments )
+	TheRun.Run()
+	nStored = len( TheRun.StoreLatencies )
+	print( 'Stored %d of %d images over %d association(s) in %.3f seconds, %d x %d pixels, maximum PDU %d' %
+			( nStored, Arguments.images, max( 1, Arguments.associations ), TheRun.ElapsedTime, Arguments.columns, Arguments.rows, Arguments.max_pdu ) )
+	if TheRun.ElapsedTime > 0:
+		print( 'Throughput       %.1f images/sec   %.2f MB/sec' % ( nStored / TheRun.ElapsedTime, TheRun.nBytesSent / ( 1048576.0 * TheRun.ElapsedTime ) ) )
+	ReportLatencies( 'Store latency', TheRun.StoreLatencies )
+	ReportLatencies( 'PNG latency', TheRun.PNGLatencies )
+	ReportLatencies( 'AXT latency', TheRun.AXTLatencies )
+	nMissingOutputs = TheRun.nMissingPNG + TheRun.nMissingAXT
+	if nMissingOutputs > 0:
+		print( 'Missing outputs after %.0f seconds:  %d .png, %d .axt' % ( Arguments.output_timeout, TheRun.nMissingPNG, TheRun.nMissingAXT ) )
+	for Failure in TheRun.Failures[ :20 ]:
+		print( 'Failure:  %s' % Failure )
+	if len( TheRun.Failures ) > 20:
+		print( '... and %d more failures' % ( len( TheRun.Failures ) - 20 ) )
+	return 0 if nStored == Arguments.images and nMissingOutputs == 0 else 1
+
+
+if __name__ == '__main__':
+	sys.exit( main( sys.argv[ 1: ] ) )
@@ -0,0 +1,564 @@
+# MakeDicomCorpus.py : Generates a synthetic Dicom image corpus for benchmarks and regression checks.
+#
+#	The files are chest-radiograph-sized images with no patient information, written the same
+#	way on every run for a given seed.  They cover the transfer syntaxes BRetriever reads:
+#
+#		Implicit VR little endian, explicit VR little endian and explicit VR big endian.
+#		JPEG baseline (8 bit) and JPEG extended (12 bit), decoded by the Jpeg8 and Jpeg12 libraries.
+#		JPEG lossless, process 14 and process 14 selection 1, at 8, 12 and 16 bits.
+#
+#	and the calibration and encoding details the parser must handle:  modality rescaling, modality
+#	and VOI lookup table sequences, window settings, private elements, and values of odd length.
+#	The parser accepts odd value lengths only from NovaRad implementations, so one odd-length
+#	file names NovaRad as its implementation and is parsed, and the other is rejected.
+#
+#	The files are listed in DicomCorpus.txt, in the format of DicomParser\DicomParserSeeds.txt,
+#	with the image columns, rows and bits allocated, and the length and file offset of the image
+#	data expected from the parse, followed by the transfer syntax UID.  A file expected to be
+#	rejected is listed with zeros.  For encapsulated images
+#	the image data is the first (only) fragment.  BRetrieverTest checks the parse of each listed
+#	file when the corpus has been generated.  The elements used by the files are listed in
+#	CorpusDictionary.txt.
+#
+#	The generated files are not kept in the repository.  At the full size, generation takes a
+#	few minutes, most of it in the lossy JPEG encoder.
+#
+#	Usage:  python MakeDicomCorpus.py [--seed N] [--columns N] [--rows N]      (run in this directory)
+#
+import argparse
+import array
+import hashlib
+import math
+import random
+import struct
+import sys
+
+
+IMPLICIT_LITTLE_ENDIAN = '1.2.840.10008.1.2'
+EXPLICIT_LITTLE_ENDIAN = '1.2.840.10008.1.2.1'
+EXPLICIT_BIG_ENDIAN = '1.2.840.10008.1.2.2'
+JPEG_BASELINE = '1.2.840.10008.1.2.4.50'
+JPEG_EXTENDED = '1.2.840.10008.1.2.4.51'
+JPEG_LOSSLESS_PROCESS_14 = '1.2.840.10008.1.2.4.57'
+JPEG_LOSSLESS = '1.2.840.10008.1.2.4.70'
+CR_IMAGE_STORAGE = '1.2.840.10008.5.1.4.1.1.1'
+UNDEFINED_LENGTH = 0xFFFFFFFF
+
+LONG_LENGTH_VRS = ( 'OB', 'OW', 'SQ', 'UN', 'UT' )
+
+
+# -------------------------------------------------------------------------------------------------
+#	Dicom encoding.
+# -------------------------------------------------------------------------------------------------
+
+class Encoding:
+	def __init__( self, TransferSyntax ):
+		self.TransferSyntax = TransferSyntax
+		self.bExplicitVR = ( TransferSyntax != IMPLICIT_LITTLE_ENDIAN )
+		self.ByteOrder = '>' if TransferSyntax == EXPLICIT_BIG_ENDIAN else '<'
+
+
+META_ENCODING = Encoding( EXPLICIT_LITTLE_ENDIAN )
+
+
+def CorpusUID( Seed, Description ):
+	# A UUID-derived UID under the 2.25 root, the same on every run for a given seed.
+	return '2.25.%d' % int( hashlib.md5( ( 'DicomCorpus %d %s' % ( Seed, Description ) ).encode( 'ascii' ) ).hexdigest(), 16 )
+
+
+def Pad( Value, VR, bPad = True ):
+	# Values are padded to an even length, UIDs with a null and text with a space, unless an
+	# odd-length value is wanted.
+	if isinstance( Value, str ):
+		Value = Value.encode( 'ascii' )
+	if bPad and len( Value ) % 2 != 0:
+		Value += b'\x00' if VR in ( 'UI', 'OB', 'UN' ) else b' '
+	return Value
+
+
+def Element( TheEncoding, Group, ElementNumber, VR, Value, Length = None ):
+	# Value is text, bytes already in the transfer syntax byte order, or a list of unsigned shorts.
+	# A value given with its length is written as it is.
+	if isinstance( Value, list ):
+		Value = struct.pack( '%s%dH' % ( TheEncoding.ByteOrder, len( Value ) ), *Value )
+	if Length is None:
+		Value = Pad( Value, VR )
+		Length = len( Value )
+	Order = TheEncoding.ByteOrder
+	Tag = struct.pack( Order + 'HH', Group, ElementNumber )
+	if Group == 0xFFFE or not TheEncoding.bExplicitVR:
+		return Tag + struct.pack( Order + 'L', Length ) + Value
+	if VR in LONG_LENGTH_VRS:
+		return Tag + VR.encode( 'ascii' ) + b'\x00\x00' + struct.pack( Order + 'L', Length ) + Value
+	return Tag + VR.encode( 'ascii' ) + struct.pack( Order + 'H', Length ) + Value
+
+
+def OddElement( TheEncoding, Group, ElementNumber, VR, Text ):
+	# An element whose value has an odd length, as some modalities write them.
+	Value = Pad( Text, VR, False )
+	assert len( Value ) % 2 == 1
+	return Element( TheEncoding, Group, ElementNumber, VR, Value, Length = len( Value ) )
+
+
+def Item( TheEncoding, Contents ):
+	return Element( TheEncoding, 0xFFFE, 0xE000, '', Contents )
+
+
+def MetaInformation( TransferSyntax, SOPInstanceUID, ImplementationVersionName ):
+	Elements = Element( META_ENCODING, 0x0002, 0x0001, 'OB', b'\x00\x01' )
+	Elements += Element( META_ENCODING, 0x0002, 0x0002, 'UI', CR_IMAGE_STORAGE )
+	Elements += Element( META_ENCODING, 0x0002, 0x0003, 'UI', SOPInstanceUID )
+	Elements += Element( META_ENCODING, 0x0002, 0x0010, 'UI', TransferSyntax )
+	Elements += Element( META_ENCODING, 0x0002, 0x0012, 'UI', CorpusUID( 0, 'Implementation' ) )
+	Elements += Element( META_ENCODING, 0x0002, 0x0013, 'SH', ImplementationVersionName )
+	return b'\x00' * 128 + b'DICM' + Element( META_ENCODING, 0x0002, 0x0000, 'UL', struct.pack( '<L', len( Elements ) ) ) + Elements
+
+
+def LookupTableItem( TheEncoding, nEntries, FirstMappedValue, OutputBits, Table, ExplanationTag, Explanation ):
+	Contents = Element( TheEncoding, 0x0028, 0x3002, 'US', [ nEntries % 65536, FirstMappedValue, OutputBits ] )
+	Contents += Element( TheEncoding, 0x0028, ExplanationTag, 'LO', Explanation )
+	Contents += Element( TheEncoding, 0x0028, 0x3006, 'OW', Table )
+	return Item( TheEncoding, Contents )
+
+
+def ModalityLUTSequence( TheEncoding, BitsStored ):
+	# A linear modality LUT to 16-bit output values.
+	nEntries = 1 << BitsStored
+	Table = [ ( nValue * 65535 ) // ( nEntries - 1 ) for nValue in range( nEntries ) ]
+	return Element( TheEncoding, 0x0028, 0x3000, 'SQ',
+					LookupTableItem( TheEncoding, nEntries, 0, 16, Table, 0x3004, 'US' ) )
+
+
+def VOILUTSequence( TheEncoding, BitsStored ):
+	# A sigmoid VOI LUT to 12-bit output values.
+	nEntries = 1 << BitsStored
+	Center = nEntries / 2.0
+	Width = nEntries / 4.0
+	Table = [ int( 4095.0 / ( 1.0 + math.exp( -4.0 * ( nValue - Center ) / Width ) ) ) for nValue in range( nEntries ) ]
+	return Element( TheEncoding, 0x0028, 0x3010, 'SQ',
+					LookupTableItem( TheEncoding, nEntries, 0, 12, Table, 0x3003, 'SIGMOID' ) )
+
+
+def PrivateElements( TheEncoding, bOddLength ):
+	Elements = Element( TheEncoding, 0x0009, 0x0010, 'LO', 'DICOM CORPUS PRIVATE' )
+	if bOddLength:
+		Elements += OddElement( TheEncoding, 0x0009, 0x1001, 'LO', 'Odd private' )
+		Elements += Element( TheEncoding, 0x0009, 0x1002, 'UN', bytes( range( 33 ) ), Length = 33 )
+	else:
+		Elements += Element( TheEncoding, 0x0009, 0x1001, 'LO', 'Even private' )
+		Elements += Element( TheEncoding, 0x0009, 0x1002, 'UN', bytes( range( 32 ) ) )
+	return Elements
+
+
+def DataSet( TheEncoding, Image, Seed, SOPInstanceUID, nImage, Calibration, bPrivate, bOddLength ):
+	# The elements ahead of the pixel data, in tag order.
+	def Text( Group, ElementNumber, VR, Value ):
+		if bOddLength and len( Value ) % 2 == 1:
+			return OddElement( TheEncoding, Group, ElementNumber, VR, Value )
+		return Element( TheEncoding, Group, ElementNumber, VR, Value )
+	Elements = Element( TheEncoding, 0x0008, 0x0008, 'CS', 'ORIGINAL\\PRIMARY' )
+	Elements += Element( TheEncoding, 0x0008, 0x0016, 'UI', CR_IMAGE_STORAGE )
+	Elements += Element( TheEncoding, 0x0008, 0x0018, 'UI', SOPInstanceUID )
+	Elements += Element( TheEncoding, 0x0008, 0x0020, 'DA', '20260101' )
+	Elements += Element( TheEncoding, 0x0008, 0x0030, 'TM', '120000' )
+	Elements += Element( TheEncoding, 0x0008, 0x0060, 'CS', 'CR' )
+	Elements += Text( 0x0008, 0x0070, 'LO', 'CORPUS' if not bOddLength else 'CORPUSX' )
+	Elements += Text( 0x0008, 0x1090, 'LO', 'Synthetic Chest' )
+	if bPrivate:
+		Elements += PrivateElements( TheEncoding, bOddLength )
+	Elements += Text( 0x0010, 0x0010, 'PN', 'CORPUS^SYNTHETIC' if not bOddLength else 'CORPUS^ODD' )
+	Elements += Element( TheEncoding, 0x0010, 0x0020, 'LO', 'CORPUS%04d' % nImage )
+	Elements += Element( TheEncoding, 0x0018, 0x0015, 'CS', 'CHEST' )
+	Elements += Element( TheEncoding, 0x0020, 0x000D, 'UI', CorpusUID( Seed, 'Study %d' % nImage ) )
+	Elements += Element( TheEncoding, 0x0020, 0x000E, 'UI', CorpusUID( Seed, 'Series %d' % nImage ) )
+	Elements += Element( TheEncoding, 0x0020, 0x0013, 'IS', '1' )
+	Elements += Element( TheEncoding, 0x0028, 0x0002, 'US', [ 1 ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0004, 'CS', 'MONOCHROME2' )
+	Elements += Element( TheEncoding, 0x0028, 0x0010, 'US', [ Image.Rows ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0011, 'US', [ Image.Columns ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0100, 'US', [ Image.BitsAllocated ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0101, 'US', [ Image.BitsStored ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0102, 'US', [ Image.BitsStored - 1 ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0103, 'US', [ 0 ] )
+	MaxValue = ( 1 << Image.BitsStored ) - 1
+	if 'WINDOW' in Calibration:
+		Elements += Element( TheEncoding, 0x0028, 0x1050, 'DS', '%d' % ( ( MaxValue + 1 ) // 2 ) )
+		Elements += Element( TheEncoding, 0x0028, 0x1051, 'DS', '%d' % ( MaxValue + 1 ) )
+	if 'RESCALE' in Calibration:
+		Elements += Element( TheEncoding, 0x0028, 0x1052, 'DS', '-1024' )
+		Elements += Element( TheEncoding, 0x0028, 0x1053, 'DS', '1.5' )
+		Elements += Element( TheEncoding, 0x0028, 0x1054, 'LO', 'US' )
+	if 'MODALITY_LUT' in Calibration:
+		Elements += ModalityLUTSequence( TheEncoding, Image.BitsStored )
+	if 'VOI_LUT' in Calibration:
+		Elements += VOILUTSequence( TheEncoding, Image.BitsStored )
+	return Elements
+
+
+# -------------------------------------------------------------------------------------------------
+#	Synthetic chest images.
+# -------------------------------------------------------------------------------------------------
+
+class SyntheticImage:
+	def __init__( self, Columns, Rows, BitsAllocated, BitsStored, Samples ):
+		self.Columns = Columns
+		self.Rows = Rows
+		self.BitsAllocated = BitsAllocated
+		self.BitsStored = BitsStored
+		self.Samples = Samples			# A list of Columns * Rows values, row by row.
+
+	def PixelBytes( self, ByteOrder ):
+		if self.BitsAllocated == 8:
+			return bytes( self.Samples )
+		Values = array.array( 'H', self.Samples )
+		if ( ByteOrder == '>' ) != ( sys.byteorder == 'big' ):
+			Values.byteswap()
+		return Values.tobytes()
+
+
+def MakeChestSamples( Columns, Rows, Seed ):
+	# A 16-bit radiograph-like image:  a bright body outline with two darker lung fields, rib
+	# shadows across the lungs, and noise.
+	Generator = random.Random( Seed )
+	Samples = [ 0 ] * ( Columns * Rows )
+	CenterX = Columns / 2.0
+	for y in range( Rows ):
+		v = ( y - 0.55 * Rows ) / ( 0.5 * Rows )
+		Rib = 0.5 + 0.5 * math.sin( y * 2.0 * math.pi / max( 8.0, Rows / 14.0 ) )
+		nRowStart = y * Columns
+		for x in range( Columns ):
+			u = ( x - CenterX ) / ( 0.45 * Columns )
+			Value = 9000.0
+			if u * u + v * v < 1.0:
+				Value = 42000.0
+				LungU = abs( u ) - 0.42
+				LungV = ( y - 0.42 * Rows ) / ( 0.3 * Rows )
+				if LungU * LungU / 0.09 + LungV * LungV < 1.0:
+					Value = 20000.0 + 6000.0 * Rib
+			Value += 3000.0 * ( x / Columns ) + Generator.gauss( 0.0, 600.0 )
+			Samples[ nRowStart + x ] = min( 65535, max( 0, int( Value ) ) )
+	return Samples
+
+
+def ReduceSamples( Samples, BitsStored ):
+	Shift = 16 - BitsStored
+	return [ Value >> Shift for Value in Samples ]
+
+
+# -------------------------------------------------------------------------------------------------
+#	JPEG encoding.
+# -------------------------------------------------------------------------------------------------
+
+class BitWriter:
+	def __init__( self ):
+		self.Bytes = bytearray()
+		self.Accumulator = 0
+		self.nBits = 0
+
+	def Write( self, Value, nBits ):
+		self.Accumulator = ( self.Accumulator << nBits ) | ( Value & ( ( 1 << nBits ) - 1 ) )
+		self.nBits += nBits
+		while self.nBits >= 8:
+			self.nBits -= 8
+			Byte = ( self.Accumulator >> self.nBits ) & 0xFF
+			self.Bytes.append( Byte )
+			if Byte == 0xFF:
+				self.Bytes.append( 0x00 )
+		self.Accumulator &= ( 1 << self.nBits ) - 1
+
+	def Flush( self ):
+		# Pad the final byte with one bits.
+		if self.nBits > 0:
+			self.Write( 0x7F, 8 - self.nBits )
+
+
+def Segment( Marker, Payload ):
+	return struct.pack( '>BBH', 0xFF, Marker, len( Payload ) + 2 ) + bytes( Payload )
+
+
+def Category( Value ):
+	return abs( Value ).bit_length()
+
+
+def EncodedBits( Value, nCategory ):
+	# JPEG standard, F.1.2.1:  negative values are coded as the value minus one, in nCategory bits.
+	if Value < 0:
+		Value += ( 1 << nCategory ) - 1
+	return Value & ( ( 1 << nCategory ) - 1 )
+
+
+def OptimalHuffmanTable( Frequencies ):
+	# JPEG standard, K.2:  Huffman code lengths, limited to 16 bits, with a reserved symbol keeping
+	# any code from consisting of all ones.  Return the BITS and HUFFVAL lists and the codes.
+	Frequency = list( Frequencies ) + [ 1 ]
+	CodeSize = [ 0 ] * len( Frequency )
+	Others = [ -1 ] * len( Frequency )
+	while True:
+		Candidates = [ i for i in range( len( Frequency ) ) if Frequency[ i ] > 0 ]
+		if len( Candidates ) < 2:
+			break
+		Candidates.sort( key = lambda i: ( Frequency[ i ], -i ) )
+		V1, V2 = Candidates[ 0 ], Candidates[ 1 ]
+		Frequency[ V1 ] += Frequency[ V2 ]
+		Frequency[ V2 ] = 0
+		CodeSize[ V1 ] += 1
+		while Others[ V1 ] >= 0:
+			V1 = Others[ V1 ]
+			CodeSize[ V1 ] += 1
+		Others[ V1 ] = V2
+		CodeSize[ V2 ] += 1
+		while Others[ V2 ] >= 0:
+			V2 = Others[ V2 ]
+			CodeSize[ V2 ] += 1
+	Bits = [ 0 ] * 33
+	for Size in CodeSize:
+		if Size > 0:
+			Bits[ Size ] += 1
+	for i in range( 32, 16, -1 ):
+		while Bits[ i ] > 0:
+			j = i - 2
+			while Bits[ j ] == 0:
+				j -= 1
+			Bits[ i ] -= 2
+			Bits[ i - 1 ] += 1
+			Bits[ j + 1 ] += 2
+			Bits[ j ] -= 1
+	i = 16
+	while Bits[ i ] == 0:
+		i -= 1
+	Bits[ i ] -= 1			# Remove the reserved symbol.
+	Symbols = sorted( [ s for s in range( len( Frequencies ) ) if Frequencies[ s ] > 0 ], key = lambda s: ( -Frequencies[ s ], s ) )
+	# Assign the canonical codes, JPEG standard, C.2.
+	Codes = {}
+	Code = 0
+	nSymbol = 0
+	for nLength in range( 1, 17 ):
+		for n in range( Bits[ nLength ] ):
+			Codes[ Symbols[ nSymbol ] ] = ( Code, nLength )
+			Code += 1
+			nSymbol += 1
+		Code <<= 1
+	return Bits[ 1:17 ], Symbols, Codes
+
+
+def HuffmanTableSegment( TableClass, TableID, Bits, Symbols ):
+	return Segment( 0xC4, bytes( [ ( TableClass << 4 ) | TableID ] ) + bytes( Bits ) + bytes( Symbols ) )
+
+
+def EncodeLosslessJpeg( Image ):
+	# Process 14, first-order prediction (selection value 1), no restart intervals.
+	Columns = Image.Columns
+	Samples = Image.Samples
+	Precision = Image.BitsStored
+	Differences = []
+	for nIndex in range( len( Samples ) ):
+		if nIndex == 0:
+			Prediction = 1 << ( Precision - 1 )
+		elif nIndex < Columns:
+			Prediction = Samples[ nIndex - 1 ]
+		elif nIndex % Columns == 0:
+			Prediction = Samples[ nIndex - Columns ]
+		else:
+			Prediction = Samples[ nIndex - 1 ]
+		Difference = ( Samples[ nIndex ] - Prediction ) & 0xFFFF
+		if Difference >= 0x8000:
+			Difference -= 0x10000
+		Differences.append( Difference )
+	Frequencies = [ 0 ] * 17
+	for Difference in Differences:
+		Frequencies[ 16 if Difference == -0x8000 else Category( Difference ) ] += 1
+	Bits, Symbols, Codes = OptimalHuffmanTable( Frequencies )
+	Output = bytearray( b'\xFF\xD8' )
+	Output += HuffmanTableSegment( 0, 0, Bits, Symbols )
+	Output += Segment( 0xC3, struct.pack( '>BHHBBBB', Precision, Image.Rows, Columns, 1, 1, 0x11, 0 ) )
+	Output += Segment( 0xDA, bytes( [ 1, 1, 0x00, 1, 0, 0 ] ) )
+	Writer = BitWriter()
+	for Difference in Differences:
+		nCategory = 16 if Difference == -0x8000 else Category( Difference )
+		Code, nLength = Codes[ nCategory ]
+		Writer.Write( Code, nLength )
+		if 0 < nCategory < 16:
+			Writer.Write( EncodedBits( Difference, nCategory ), nCategory )
+	Writer.Flush()
+	Output += Writer.Bytes
+	Output += b'\xFF\xD9'
+	return bytes( Output )
+
+
+# JPEG standard, table K.1, and the zigzag order of the coefficients.
+LUMINANCE_QUANTIZATION = [
+	16, 11, 10, 16, 24, 40, 51, 61,		12, 12, 14, 19, 26, 58, 60, 55,
+	14, 13, 16, 24, 40, 57, 69, 56,		14, 17, 22, 29, 51, 87, 80, 62,
+	18, 22, 37, 56, 68, 109, 103, 77,	24, 35, 55, 64, 81, 104, 113, 92,
+	49, 64, 78, 87, 103, 121, 120, 101,	72, 92, 95, 98, 112, 100, 103, 99 ]
+ZIGZAG = [
+	0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+	12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63 ]
+DCT_MATRIX = [ [ ( math.sqrt( 0.125 ) if u == 0 else 0.5 ) * math.cos( ( 2 * x + 1 ) * u * math.pi / 16.0 ) for x in range( 8 ) ] for u in range( 8 ) ]
+
+
+def QuantizedBlocks( Image, Quantization ):
+	# Yield the quantized DCT coefficients of each 8 x 8 block, in zigzag order.  The edge
+	# blocks are filled out by repeating the last column and row.
+	Columns = Image.Columns
+	Rows = Image.Rows
+	Samples = Image.Samples
+	LevelShift = 1 << ( Image.BitsStored - 1 )
+	ZigzagQuantization = [ Quantization[ nPosition ] for nPosition in ZIGZAG ]
+	for BlockY in range( 0, Rows, 8 ):
+		RowStarts = [ min( BlockY + y, Rows - 1 ) * Columns for y in range( 8 ) ]
+		for BlockX in range( 0, Columns, 8 ):
+			Xs = [ min( BlockX + x, Columns - 1 ) for x in range( 8 ) ]
+			# Transform the rows, then the columns.
+			RowTransforms = []
+			for nRowStart in RowStarts:
+				Row = [ Samples[ nRowStart + x ] - LevelShift for x in Xs ]
+				RowTransforms.append( [ sum( Coefficient * Value for Coefficient, Value in zip( Basis, Row ) ) for Basis in DCT_MATRIX ] )
+			Block = [ 0.0 ] * 64
+			for u in range( 8 ):
+				Column = [ RowTransform[ u ] for RowTransform in RowTransforms ]
+				for v in range( 8 ):
+					Block[ v * 8 + u ] = sum( Coefficient * Value for Coefficient, Value in zip( DCT_MATRIX[ v ], Column ) )
+			yield [ int( round( Block[ nPosition ] / ZigzagQuantization[ n ] ) ) for n, nPosition in enumerate( ZIGZAG ) ]
+
+
+def EncodeDCTJpeg( Image ):
+	# Baseline (8 bit, SOF0) or extended (12 bit, SOF1) sequential DCT, with Huffman tables
+	# optimized for the image.
+	Quantization = [ max( 1, ( Value * 20 + 50 ) // 100 ) for Value in LUMINANCE_QUANTIZATION ]
+	Blocks = list( QuantizedBlocks( Image, Quantization ) )
+	# Count the DC and AC symbols.
+	DCFrequencies = [ 0 ] * 16
+	ACFrequencies = [ 0 ] * 256
+	Symbols = []
+	PreviousDC = 0
+	for Block in Blocks:
+		BlockSymbols = []
+		Difference = Block[ 0 ] - PreviousDC
+		PreviousDC = Block[ 0 ]
+		nCategory = Category( Difference )
+		DCFrequencies[ nCategory ] += 1
+		BlockSymbols.append( ( nCategory, Difference ) )
+		nRun = 0
+		for Coefficient in Block[ 1: ]:
+			if Coefficient == 0:
+				nRun += 1
+				continue
+			while nRun > 15:
+				ACFrequencies[ 0xF0 ] += 1
+				BlockSymbols.append( ( 0xF0, 0 ) )
+				nRun -= 16
+			nCategory = Category( Coefficient )
+			Symbol = ( nRun << 4 ) | nCategory
+			ACFrequencies[ Symbol ] += 1
+			BlockSymbols.append( ( Symbol, Coefficient ) )
+			nRun = 0
+		if nRun > 0:
+			ACFrequencies[ 0x00 ] += 1
+			BlockSymbols.append( ( 0x00, 0 ) )
+		Symbols.append( BlockSymbols )
+	DCBits, DCSymbols, DCCodes = OptimalHuffmanTable( DCFrequencies )
+	ACBits, ACSymbols, ACCodes = OptimalHuffmanTable( ACFrequencies )
+	Writer = BitWriter()
+	for BlockSymbols in Symbols:
+		nCategory, Difference = BlockSymbols[ 0 ]
+		Code, nLength = DCCodes[ nCategory ]
+		Writer.Write( Code, nLength )
+		if nCategory > 0:
+			Writer.Write( EncodedBits( Difference, nCategory ), nCategory )
+		for Symbol, Coefficient in BlockSymbols[ 1: ]:
+			Code, nLength = ACCodes[ Symbol ]
+			Writer.Write( Code, nLength )
+			nCategory = Symbol & 0x0F
+			if nCategory > 0:
+				Writer.Write( EncodedBits( Coefficient, nCategory ), nCategory )
+	Writer.Flush()
+	StartOfFrame = 0xC0 if Image.BitsStored == 8 else 0xC1
+	Output = bytearray( b'\xFF\xD8' )
+	Output += Segment( 0xDB, bytes( [ 0x00 ] ) + bytes( Quantization[ nPosition ] for nPosition in ZIGZAG ) )
+	Output += Segment( StartOfFrame, struct.pack( '>BHHBBBB', Image.BitsStored, Image.Rows, Image.Columns, 1, 1, 0x11, 0 ) )
+	Output += HuffmanTableSegment( 0, 0, DCBits, DCSymbols )
+	Output += HuffmanTableSegment( 1, 0, ACBits, ACSymbols )
+	Output += Segment( 0xDA, bytes( [ 1, 1, 0x00, 0, 63, 0 ] ) )
+	Output += Writer.Bytes
+	Output += b'\xFF\xD9'
+	return bytes( Output )
+
+
+# -------------------------------------------------------------------------------------------------
+#	The corpus.
+# -------------------------------------------------------------------------------------------------
+
+def WriteCorpusFile( Manifest, Seed, Name, nImage, Image, TransferSyntax, Calibration = (), bPrivate = False,
+						bOddLength = False, ImplementationVersionName = 'DICOMCORPUS', bRejected = False ):
+	TheEncoding = Encoding( TransferSyntax )
+	SOPInstanceUID = CorpusUID( Seed, 'Instance %d' % nImage )
+	Data = MetaInformation( TransferSyntax, SOPInstanceUID, ImplementationVersionName )
+	Data += DataSet( TheEncoding, Image, Seed, SOPInstanceUID, nImage, Calibration, bPrivate, bOddLength )
+	if TransferSyntax in ( JPEG_BASELINE, JPEG_EXTENDED, JPEG_LOSSLESS_PROCESS_14, JPEG_LOSSLESS ):
+		if TransferSyntax in ( JPEG_BASELINE, JPEG_EXTENDED ):
+			ImageData = EncodeDCTJpeg( Image )
+		else:
+			ImageData = EncodeLosslessJpeg( Image )
+		if len( ImageData ) % 2 != 0:
+			ImageData += b'\x00'
+		# Encapsulated pixel data:  an empty basic offset table, then one fragment.
+		Data += Element( TheEncoding, 0x7FE0, 0x0010, 'OB', b'', Length = UNDEFINED_LENGTH )
+		Data += Item( TheEncoding, b'' )
+		Data += Element( TheEncoding, 0xFFFE, 0xE000, '', b'', Length = len( ImageData ) )
+	else:
+		ImageData = Image.PixelBytes( TheEncoding.ByteOrder )
+		if len( ImageData ) % 2 != 0:
+			ImageData += b'\x00'
+		Data += Element( TheEncoding, 0x7FE0, 0x0010, 'OW' if Image.BitsAllocated > 8 else 'OB', b'', Length = len( ImageData ) )
+	ImageOffset = len( Data )
+	Data += ImageData
+	if TransferSyntax in ( JPEG_BASELINE, JPEG_EXTENDED, JPEG_LOSSLESS_PROCESS_14, JPEG_LOSSLESS ):
+		Data += Element( TheEncoding, 0xFFFE, 0xE0DD, '', b'' )
+	with open( Name, 'wb' ) as OutputFile:
+		OutputFile.write( Data )
+	if bRejected:
+		Manifest.write( '%-28s %5d %5d %4d %9d %8d   %s\n' % ( Name, 0, 0, 0, 0, 0, TransferSyntax ) )
+	else:
+		Manifest.write( '%-28s %5d %5d %4d %9d %8d   %s\n' % ( Name, Image.Columns, Image.Rows, Image.BitsAllocated,
+							len( ImageData ), ImageOffset, TransferSyntax ) )
+	Manifest.flush()
+	print( 'Wrote %s' % Name )
+
+
+def main( ArgumentList ):
+	Parser = argparse.ArgumentParser( description = 'Generate the synthetic Dicom image corpus.' )
+	Parser.add_argument( '--seed', type = int, default = 1 )
+	Parser.add_argument( '--columns', type = int, default = 2048 )
+	Parser.add_argument( '--rows', type = int, default = 2500 )
+	Arguments = Parser.parse_args( ArgumentList )
+	Seed = Arguments.seed
+	Columns = Arguments.columns
+	Rows = Arguments.rows
+	Samples = MakeChestSamples( Columns, Rows, Seed )
+	Image8 = SyntheticImage( Columns, Rows, 8, 8, ReduceSamples( Samples, 8 ) )
+	Image12 = SyntheticImage( Columns, Rows, 16, 12, ReduceSamples( Samples, 12 ) )
+	Image16 = SyntheticImage( Columns, Rows, 16, 16, Samples )
+	with open( 'DicomCorpus.txt', 'w' ) as Manifest:
+		Manifest.write( '# File                     Columns  Rows Bits    Length   Offset   TransferSyntax\n' )
+		WriteCorpusFile( Manifest, Seed, 'ImplicitLittle12.dcm', 1, Image12, IMPLICIT_LITTLE_ENDIAN, ( 'RESCALE', 'WINDOW' ) )
+		WriteCorpusFile( Manifest, Seed, 'ExplicitLittle12.dcm', 2, Image12, EXPLICIT_LITTLE_ENDIAN, ( 'MODALITY_LUT', 'VOI_LUT' ) )
+		WriteCorpusFile( Manifest, Seed, 'ExplicitBig12.dcm', 3, Image12, EXPLICIT_BIG_ENDIAN, ( 'RESCALE', 'WINDOW' ) )
+		WriteCorpusFile( Manifest, Seed, 'ExplicitLittle8.dcm', 4, Image8, EXPLICIT_LITTLE_ENDIAN, ( 'WINDOW', ) )
+		WriteCorpusFile( Manifest, Seed, 'ExplicitLittle16.dcm', 5, Image16, EXPLICIT_LITTLE_ENDIAN, ( 'VOI_LUT', ) )
+		WriteCorpusFile( Manifest, Seed, 'ExplicitOddLength.dcm', 6, Image12, EXPLICIT_LITTLE_ENDIAN, ( 'WINDOW', ), True, True, 'NOVARAD CORPUS' )
+		WriteCorpusFile( Manifest, Seed, 'ImplicitOddLength.dcm', 7, Image12, IMPLICIT_LITTLE_ENDIAN, ( 'RESCALE', ), True, True, bRejected = True )
+		WriteCorpusFile( Manifest, Seed, 'ExplicitBigPrivate.dcm', 8, Image12, EXPLICIT_BIG_ENDIAN, ( 'MODALITY_LUT', ), True, False )
+		WriteCorpusFile( Manifest, Seed, 'JpegLossless8.dcm', 9, Image8, JPEG_LOSSLESS, ( 'WINDOW', ) )
+		WriteCorpusFile( Manifest, Seed, 'JpegLossless12.dcm', 10, Image12, JPEG_LOSSLESS, ( 'RESCALE', 'VOI_LUT' ) )
+		WriteCorpusFile( Manifest, Seed, 'JpegLossless16.dcm', 11, Image16, JPEG_LOSSLESS, ( 'WINDOW', ), True, False )
+		WriteCorpusFile( Manifest, Seed, 'JpegProcess14_12.dcm', 12, Image12, JPEG_LOSSLESS_PROCESS_14, ( 'MODALITY_LUT', ) )
+		WriteCorpusFile( Manifest, Seed, 'JpegBaseline8.dcm', 13, Image8, JPEG_BASELINE, ( 'WINDOW', ) )
+		WriteCorpusFile( Manifest, Seed, 'JpegExtended12.dcm', 14, Image12, JPEG_EXTENDED, ( 'RESCALE', 'WINDOW' ) )
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit( main( sys.argv[ 1: ] ) )
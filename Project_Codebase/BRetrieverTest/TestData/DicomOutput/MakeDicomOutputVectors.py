@@ -0,0 +1,242 @@
+# MakeDicomOutputVectors.py : Generates the Dicom files and edit specifications used by
+#	BRetrieverTest to test the composition of the Dicom output file in Dicom.cpp.
+#
+#	The input images are small synthetic radiographs, 8 and 16 bits, MONOCHROME1 and MONOCHROME2,
+#	in implicit and explicit VR little endian, with sequences and private elements.  One of them
+#	is large enough for its image data to span several of the 64K buffers the file is read into.
+#	The edit specification sets, each written to DicomEdits.cfg by the test in turn, are:
+#
+#		Values.cfg		Value edits of text, person name and numeric elements, including an
+#						odd-length value, a tag occurring in two sequence items and two
+#						edits for the same tag, with added elements and deletions of one
+#						and of several successive elements.  The composition keeps the lengths
+#						of the defined-length sequence and its items, which the shorter values
+#						in them no longer fill, so that it can't be read again.
+#		Elements.cfg	The added and deleted elements of Values.cfg alone, to be read again.
+#		Rules200.cfg	200 edits, most of them for tags the images don't have, with the
+#						edits of Values.cfg among them and repeated later in the file.
+#		Overlay8.cfg	The Overlay.jpg label written into the bottom center of an 8-bit image,
+#		Overlay16.cfg	of a 16-bit image,
+#		Overlay16B.cfg	and of a 16-bit image from the smaller OverlayB.jpg label.
+#
+#	The "<TestData>" in an overlay file specification is replaced by the test data directory.
+#	OverlayC.jpg is the OverlayB.jpg label padded with a comment to the size of Overlay.jpg, so that
+#	the test can replace one with the other without changing the overlay edit.
+#
+#	The files are listed in DicomOutputVectors.txt, one line per composition, with the input file,
+#	the edit specification set ("-" for none) and the expected output file.  The expected output
+#	files were composed by ComposeDicomFileOutput() as it was before its output was streamed
+#	(commit d931ecc), with ExamEdit.cpp as it was before the edits were compiled (1649c91) and
+#	the overlay loop restructured (fc1705b), so that the test checks that the output has not
+#	changed byte for byte.  This includes its quirks:  an edited value is truncated by one
+#	character, and a person name is cut to the length of the value it replaces.  The older code
+#	was built with the two fixes the test found, neither of which changes the output:  the transfer
+#	syntax identifier of an implicit VR input is reallocated large enough for the uncompressed
+#	one, and Decompress8BitJpegImage() no longer frees the overlay image it returns.  Rerunning
+#	this script rewrites the same inputs, but not the expected files.
+#
+#	Usage:  python MakeDicomOutputVectors.py      (run in this directory)
+#
+import os
+import struct
+import sys
+
+sys.path.insert( 0, os.path.join( '..', 'DicomCorpus' ) )
+from MakeDicomCorpus import ( Encoding, Element, Item, MetaInformation, SyntheticImage, MakeChestSamples, ReduceSamples,
+								EncodeDCTJpeg, CorpusUID, EXPLICIT_LITTLE_ENDIAN, IMPLICIT_LITTLE_ENDIAN, CR_IMAGE_STORAGE,
+								UNDEFINED_LENGTH )
+
+
+SEED = 29
+
+
+def ReferencedImageSequence( TheEncoding ):
+	# A defined-length sequence of two items, each referencing an image by the same UID tags.
+	Items = b''
+	for nItem in range( 2 ):
+		Contents = Element( TheEncoding, 0x0008, 0x1150, 'UI', CR_IMAGE_STORAGE )
+		Contents += Element( TheEncoding, 0x0008, 0x1155, 'UI', CorpusUID( SEED, 'Referenced %d' % nItem ) )
+		Items += Item( TheEncoding, Contents )
+	return Element( TheEncoding, 0x0008, 0x1140, 'SQ', Items )
+
+
+def ProcedureCodeSequence( TheEncoding ):
+	# An undefined-length sequence holding an undefined-length item.
+	Contents = Element( TheEncoding, 0x0008, 0x0100, 'SH', 'CHEST1' ) + Element( TheEncoding, 0x0008, 0x0104, 'LO', 'Chest PA' )
+	Elements = Element( TheEncoding, 0x0008, 0x1032, 'SQ', b'', Length = UNDEFINED_LENGTH )
+	Elements += Element( TheEncoding, 0xFFFE, 0xE000, '', Contents, Length = UNDEFINED_LENGTH ) + Element( TheEncoding, 0xFFFE, 0xE00D, '', b'' )
+	Elements += Element( TheEncoding, 0xFFFE, 0xE0DD, '', b'' )
+	return Elements
+
+
+def DataSet( TheEncoding, Image, PhotometricInterpretation, nImage ):
+	Elements = Element( TheEncoding, 0x0008, 0x0008, 'CS', 'ORIGINAL\\PRIMARY' )
+	Elements += Element( TheEncoding, 0x0008, 0x0016, 'UI', CR_IMAGE_STORAGE )
+	Elements += Element( TheEncoding, 0x0008, 0x0018, 'UI', CorpusUID( SEED, 'Instance %d' % nImage ) )
+	Elements += Element( TheEncoding, 0x0008, 0x0020, 'DA', '20260101' )
+	Elements += Element( TheEncoding, 0x0008, 0x0030, 'TM', '120000' )
+	Elements += Element( TheEncoding, 0x0008, 0x0060, 'CS', 'CR' )
+	Elements += Element( TheEncoding, 0x0008, 0x0070, 'LO', 'OUTPUT TEST' )
+	Elements += Element( TheEncoding, 0x0008, 0x1030, 'LO', 'Chest' )
+	Elements += ProcedureCodeSequence( TheEncoding )
+	Elements += Element( TheEncoding, 0x0008, 0x1090, 'LO', 'Synthetic' )
+	Elements += ReferencedImageSequence( TheEncoding )
+	Elements += Element( TheEncoding, 0x0009, 0x0010, 'LO', 'OUTPUT TEST PRIVATE' )
+	Elements += Element( TheEncoding, 0x0009, 0x1001, 'LO', 'Private value' )
+	Elements += Element( TheEncoding, 0x0009, 0x1002, 'UN', bytes( range( 32 ) ) )
+	Elements += Element( TheEncoding, 0x0010, 0x0010, 'PN', 'OUTPUT^TEST^PATIENT' )
+	Elements += Element( TheEncoding, 0x0010, 0x0020, 'LO', 'OUTPUT%04d' % nImage )
+	Elements += Element( TheEncoding, 0x0018, 0x0015, 'CS', 'CHEST' )
+	Elements += Element( TheEncoding, 0x0018, 0x1000, 'LO', 'SN-0001' )
+	Elements += Element( TheEncoding, 0x0020, 0x000D, 'UI', CorpusUID( SEED, 'Study %d' % nImage ) )
+	Elements += Element( TheEncoding, 0x0020, 0x000E, 'UI', CorpusUID( SEED, 'Series %d' % nImage ) )
+	Elements += Element( TheEncoding, 0x0020, 0x0013, 'IS', '1' )
+	Elements += Element( TheEncoding, 0x0028, 0x0002, 'US', [ 1 ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0004, 'CS', PhotometricInterpretation )
+	Elements += Element( TheEncoding, 0x0028, 0x0010, 'US', [ Image.Rows ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0011, 'US', [ Image.Columns ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0100, 'US', [ Image.BitsAllocated ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0101, 'US', [ Image.BitsStored ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0102, 'US', [ Image.BitsStored - 1 ] )
+	Elements += Element( TheEncoding, 0x0028, 0x0103, 'US', [ 0 ] )
+	return Elements
+
+
+def WriteInputFile( Name, nImage, Image, TransferSyntax, PhotometricInterpretation ):
+	TheEncoding = Encoding( TransferSyntax )
+	Data = MetaInformation( TransferSyntax, CorpusUID( SEED, 'Instance %d' % nImage ), 'OUTPUTTEST' )
+	Data += DataSet( TheEncoding, Image, PhotometricInterpretation, nImage )
+	ImageData = Image.PixelBytes( TheEncoding.ByteOrder )
+	Data += Element( TheEncoding, 0x7FE0, 0x0010, 'OW' if Image.BitsAllocated > 8 else 'OB', ImageData )
+	with open( Name, 'wb' ) as OutputFile:
+		OutputFile.write( Data )
+	print( 'Wrote %s' % Name )
+	return len( ImageData )
+
+
+def LabelImage( Columns, Rows, Seed ):
+	# A light label with dark block letters and a gradient background, which the overlay
+	# code writes into the image as it is.
+	Samples = []
+	for y in range( Rows ):
+		for x in range( Columns ):
+			Value = 200 + ( x * 40 ) // Columns
+			if 3 <= y < Rows - 3 and ( ( x // 4 + Seed ) % 3 ) != 0 and ( x % 4 ) != 3:
+				Value = 30 + ( y * 8 )
+			Samples.append( min( 255, Value ) )
+	return SyntheticImage( Columns, Rows, 8, 8, Samples )
+
+
+def WriteOverlayFile( Name, Image ):
+	Data = EncodeDCTJpeg( Image )
+	with open( Name, 'wb' ) as OutputFile:
+		OutputFile.write( Data )
+	print( 'Wrote %s' % Name )
+	return len( Data )
+
+
+def WritePaddedOverlayFile( Name, SourceName, FileSize ):
+	# Insert a comment segment after the start of image marker.
+	with open( SourceName, 'rb' ) as SourceFile:
+		Data = SourceFile.read()
+	nPadding = FileSize - len( Data ) - 4
+	Data = Data[ : 2 ] + b'\xFF\xFE' + struct.pack( '>H', nPadding + 2 ) + b' ' * nPadding + Data[ 2 : ]
+	with open( Name, 'wb' ) as OutputFile:
+		OutputFile.write( Data )
+	print( 'Wrote %s' % Name )
+
+
+def WriteEditFile( Name, Description, Lines ):
+	with open( Name, 'w', newline = '\r\n' ) as EditFile:
+		EditFile.write( '# %s : %s\n' % ( Name, Description ) )
+		for Line in Lines:
+			EditFile.write( Line + '\n' )
+	print( 'Wrote %s' % Name )
+
+
+VALUE_EDITS = [
+	'(0010,0010),EDITED^NAME',						# Person name, shorter than the original.
+	'(0008,0070),Odd Maker',						# Odd length.
+	'(0008,0060),DX',								# The first of two edits for the same tag is applied.
+	'(0008,0060),MG',
+	'(0008,1155),1.2.840.99999.77',					# A tag in both items of a sequence.
+	'(0028,0103),0',								# Unsigned short.
+	'(0020,0013),42',								# Integer string.
+	'+(0008,0080),EDITED HOSPITAL',					# Added elements.
+	'+(0010,0030),19600101',
+	'+(0010,0040),O',
+	'-(0018,0015),0',								# Delete one element,
+	'-(0009,0010),2',								# and an element with the two following it.
+	]
+
+
+def Rules200():
+	# The value edits above, then edits for tags the images don't have, with the value edits
+	# repeated among them, which must not be applied.
+	Lines = list( VALUE_EDITS )
+	nAbsentTag = 0
+	while len( Lines ) < 200:
+		if len( Lines ) % 40 == 0:
+			Lines.append( '(0008,0060),CT' )
+		elif len( Lines ) % 40 == 20:
+			Lines.append( '(0010,0010),LATER^NAME' )
+		else:
+			Lines.append( '(%04X,%04X),Unused value %d' % ( 0x0019 + 2 * ( nAbsentTag % 7 ), 0x1000 + nAbsentTag, nAbsentTag ) )
+			nAbsentTag += 1
+	return Lines
+
+
+def main():
+	Samples = MakeChestSamples( 96, 64, SEED )
+	Image8 = SyntheticImage( 96, 64, 8, 8, ReduceSamples( Samples, 8 ) )
+	Image16 = SyntheticImage( 96, 64, 16, 12, ReduceSamples( Samples, 12 ) )
+	LargeImage16 = SyntheticImage( 300, 250, 16, 16, MakeChestSamples( 300, 250, SEED ) )
+	Length8 = WriteInputFile( 'Mono2Explicit8.dcm', 1, Image8, EXPLICIT_LITTLE_ENDIAN, 'MONOCHROME2' )
+	WriteInputFile( 'Mono1Explicit8.dcm', 2, Image8, EXPLICIT_LITTLE_ENDIAN, 'MONOCHROME1' )
+	Length16 = WriteInputFile( 'Mono2Explicit16.dcm', 3, Image16, EXPLICIT_LITTLE_ENDIAN, 'MONOCHROME2' )
+	WriteInputFile( 'Mono1Implicit16.dcm', 4, Image16, IMPLICIT_LITTLE_ENDIAN, 'MONOCHROME1' )
+	WriteInputFile( 'MultipleBuffers16.dcm', 5, LargeImage16, EXPLICIT_LITTLE_ENDIAN, 'MONOCHROME2' )
+	OverlayFileSize = WriteOverlayFile( 'Overlay.jpg', LabelImage( 48, 16, 0 ) )
+	OverlayBFileSize = WriteOverlayFile( 'OverlayB.jpg', LabelImage( 32, 8, 1 ) )
+	WritePaddedOverlayFile( 'OverlayC.jpg', 'OverlayB.jpg', OverlayFileSize )
+	WriteEditFile( 'Values.cfg', 'Value edits, added and deleted elements.', VALUE_EDITS )
+	WriteEditFile( 'Elements.cfg', 'Added and deleted elements.', [ Line for Line in VALUE_EDITS if Line[ 0 ] in '+-' ] )
+	WriteEditFile( 'Rules200.cfg', '200 edits, most for tags the images don\'t have.', Rules200() )
+	OverlayFileSpec = '<TestData>DicomOutput\\Overlay.jpg'
+	OverlayBFileSpec = '<TestData>DicomOutput\\OverlayB.jpg'
+	WriteEditFile( 'Overlay8.cfg', 'Label an 8-bit image.',
+					[ 'O(7FE0,0010),%d 48 16 0 0 %d %s' % ( Length8, OverlayFileSize, OverlayFileSpec ) ] )
+	WriteEditFile( 'Overlay16.cfg', 'Label a 16-bit image.',
+					[ 'O(7FE0,0010),%d 48 16 0 0 %d %s' % ( Length16, OverlayFileSize, OverlayFileSpec ) ] )
+	WriteEditFile( 'Overlay16B.cfg', 'Label a 16-bit image with the smaller label.',
+					[ 'O(7FE0,0010),%d 32 8 0 0 %d %s' % ( Length16, OverlayBFileSize, OverlayBFileSpec ) ] )
+	Compositions = [
+		( 'Mono2Explicit16.dcm', '-' ),
+		( 'Mono1Implicit16.dcm', '-' ),
+		( 'Mono2Explicit8.dcm', '-' ),
+		( 'MultipleBuffers16.dcm', '-' ),
+		( 'Mono2Explicit16.dcm', 'Values' ),
+		( 'Mono1Implicit16.dcm', 'Values' ),
+		( 'Mono1Explicit8.dcm', 'Values' ),
+		( 'MultipleBuffers16.dcm', 'Values' ),
+		( 'Mono2Explicit16.dcm', 'Rules200' ),
+		( 'Mono1Implicit16.dcm', 'Rules200' ),
+		( 'MultipleBuffers16.dcm', 'Rules200' ),
+		( 'Mono2Explicit8.dcm', 'Overlay8' ),
+		( 'Mono1Explicit8.dcm', 'Overlay8' ),
+		( 'Mono2Explicit16.dcm', 'Overlay16' ),
+		( 'Mono1Implicit16.dcm', 'Overlay16' ),
+		( 'Mono2Explicit16.dcm', 'Overlay16B' ),
+		( 'Mono1Implicit16.dcm', 'Overlay16B' ),
+		]
+	with open( 'DicomOutputVectors.txt', 'w' ) as Manifest:
+		Manifest.write( '# Input                  Edits        Expected output\n' )
+		for InputName, EditSet in Compositions:
+			ExpectedName = 'Expected%s%s' % ( EditSet if EditSet != '-' else 'None', InputName )
+			Manifest.write( '%-24s %-12s %s\n' % ( InputName, EditSet, ExpectedName ) )
+	print( 'Wrote DicomOutputVectors.txt' )
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit( main() )
@@ -0,0 +1,141 @@
+# MakeDicomParserSeeds.py : Generates the Dicom files used by BRetrieverTest to test the element
+#	parser in Dicom.cpp.  The files also serve as the seed corpus for the fuzz target in
+#	FuzzDicomParser.cpp.
+#
+#	The files are listed in DicomParserSeeds.txt with the image columns, rows and bits allocated,
+#	and the length and file offset of the image data, expected from the parse.  A file expected
+#	to be rejected is listed with zeros.  The elements used by the files are listed in ParserDictionary.txt.
+#
+#	Usage:  python MakeDicomParserSeeds.py      (run in this directory)
+#
+import struct
+
+
+EXPLICIT_LITTLE_ENDIAN = '1.2.840.10008.1.2.1'
+IMPLICIT_LITTLE_ENDIAN = '1.2.840.10008.1.2'
+JPEG_LOSSLESS = '1.2.840.10008.1.2.4.70'
+UNDEFINED_LENGTH = 0xFFFFFFFF
+
+
+def Pad( Value, VR ):
+	# Values are padded to an even length, UIDs with a null and text with a space.
+	if len( Value ) % 2 != 0:
+		Value += b'\x00' if VR in ( 'UI', 'OB' ) else b' '
+	return Value
+
+
+def Element( Group, ElementNumber, VR, Value, bExplicitVR = True, Length = None ):
+	if isinstance( Value, str ):
+		Value = Pad( Value.encode( 'ascii' ), VR )
+	if Length is None:
+		Length = len( Value )
+	Tag = struct.pack( '<HH', Group, ElementNumber )
+	if Group == 0xFFFE or not bExplicitVR:
+		return Tag + struct.pack( '<L', Length ) + Value
+	if VR in ( 'OB', 'OW', 'SQ', 'UN', 'UT' ):
+		return Tag + VR.encode( 'ascii' ) + b'\x00\x00' + struct.pack( '<L', Length ) + Value
+	return Tag + VR.encode( 'ascii' ) + struct.pack( '<H', Length ) + Value
+
+
+def UnsignedShort( Value ):
+	return struct.pack( '<H', Value )
+
+
+def MetaInformation( TransferSyntax ):
+	Elements = Element( 0x0002, 0x0001, 'OB', b'\x00\x01' )
+	Elements += Element( 0x0002, 0x0002, 'UI', '1.2.840.10008.5.1.4.1.1.1.1' )
+	Elements += Element( 0x0002, 0x0003, 'UI', '1.2.840.99999.2.1' )
+	Elements += Element( 0x0002, 0x0010, 'UI', TransferSyntax )
+	Elements += Element( 0x0002, 0x0012, 'UI', '1.2.840.99999.3' )
+	Elements += Element( 0x0002, 0x0013, 'SH', 'TEST' )
+	return b'\x00' * 128 + b'DICM' + Element( 0x0002, 0x0000, 'UL', struct.pack( '<L', len( Elements ) ) ) + Elements
+
+
+def DataSet( Columns, Rows, BitsAllocated, bExplicitVR = True, Sequences = b'' ):
+	Elements = Element( 0x0008, 0x0016, 'UI', '1.2.840.10008.5.1.4.1.1.1.1', bExplicitVR )
+	Elements += Element( 0x0008, 0x0018, 'UI', '1.2.840.99999.2.1', bExplicitVR )
+	Elements += Element( 0x0008, 0x0020, 'DA', '20260101', bExplicitVR )
+	Elements += Element( 0x0008, 0x0060, 'CS', 'DX', bExplicitVR )
+	Elements += Element( 0x0010, 0x0010, 'PN', 'Test^Patient', bExplicitVR )
+	Elements += Element( 0x0010, 0x0020, 'LO', 'TEST0001', bExplicitVR )
+	Elements += Sequences
+	Elements += Element( 0x0020, 0x000D, 'UI', '1.2.840.99999.4.1', bExplicitVR )
+	Elements += Element( 0x0020, 0x000E, 'UI', '1.2.840.99999.5.1', bExplicitVR )
+	Elements += Element( 0x0028, 0x0002, 'US', UnsignedShort( 1 ), bExplicitVR )
+	Elements += Element( 0x0028, 0x0004, 'CS', 'MONOCHROME2', bExplicitVR )
+	Elements += Element( 0x0028, 0x0010, 'US', UnsignedShort( Rows ), bExplicitVR )
+	Elements += Element( 0x0028, 0x0011, 'US', UnsignedShort( Columns ), bExplicitVR )
+	Elements += Element( 0x0028, 0x0100, 'US', UnsignedShort( BitsAllocated ), bExplicitVR )
+	Elements += Element( 0x0028, 0x0101, 'US', UnsignedShort( BitsAllocated ), bExplicitVR )
+	Elements += Element( 0x0028, 0x0102, 'US', UnsignedShort( BitsAllocated - 1 ), bExplicitVR )
+	Elements += Element( 0x0028, 0x0103, 'US', UnsignedShort( 0 ), bExplicitVR )
+	return Elements
+
+
+def Pixels( Columns, Rows, BitsAllocated ):
+	MaxValue = ( 1 << BitsAllocated ) - 1
+	Values = [ ( x * 7 + y * 13 ) & MaxValue for y in range( Rows ) for x in range( Columns ) ]
+	return struct.pack( ( '<%dB' if BitsAllocated == 8 else '<%dH' ) % len( Values ), *Values )
+
+
+def Item( Contents, bDefinedLength ):
+	if bDefinedLength:
+		return Element( 0xFFFE, 0xE000, '', Contents )
+	return Element( 0xFFFE, 0xE000, '', Contents, Length = UNDEFINED_LENGTH ) + Element( 0xFFFE, 0xE00D, '', b'' )
+
+
+def Sequences():
+	# A sequence of undefined length holding an item of undefined length, which holds a nested
+	# sequence of defined length, followed by a private group.
+	NestedItem = Item( Element( 0x0008, 0x0100, 'SH', 'CODE1' ) + Element( 0x0008, 0x0104, 'LO', 'Nested code' ), True )
+	NestedSequence = Element( 0x0008, 0x1032, 'SQ', NestedItem )
+	OuterItem = Item( Element( 0x0008, 0x0100, 'SH', 'CODE2' ) + NestedSequence, False )
+	Elements = Element( 0x0008, 0x1110, 'SQ', OuterItem, Length = UNDEFINED_LENGTH ) + Element( 0xFFFE, 0xE0DD, '', b'' )
+	Elements += Element( 0x0009, 0x0010, 'LO', 'TEST PRIVATE' )
+	Elements += Element( 0x0009, 0x1001, 'LO', 'Private value' )
+	return Elements
+
+
+def WriteSeed( Manifest, Name, Data, Columns, Rows, BitsAllocated, ImageLength, ImageOffset ):
+	with open( Name, 'wb' ) as OutputFile:
+		OutputFile.write( Data )
+	Manifest.write( '%-24s %5d %5d %4d %8d %8d\n' % ( Name, Columns, Rows, BitsAllocated, ImageLength, ImageOffset ) )
+
+
+def UncompressedImage( Columns, Rows, BitsAllocated, TransferSyntax = EXPLICIT_LITTLE_ENDIAN, Sequences = b'' ):
+	bExplicitVR = ( TransferSyntax != IMPLICIT_LITTLE_ENDIAN )
+	ImageData = Pixels( Columns, Rows, BitsAllocated )
+	Data = MetaInformation( TransferSyntax ) + DataSet( Columns, Rows, BitsAllocated, bExplicitVR, Sequences )
+	Data += Element( 0x7FE0, 0x0010, 'OW' if BitsAllocated > 8 else 'OB', ImageData, bExplicitVR )
+	return Data, len( ImageData ), len( Data ) - len( ImageData )
+
+
+with open( 'DicomParserSeeds.txt', 'w' ) as Manifest:
+	Manifest.write( '# File                 Columns  Rows Bits   Length   Offset\n' )
+	Data, ImageLength, ImageOffset = UncompressedImage( 32, 24, 16 )
+	WriteSeed( Manifest, 'ExplicitLittle.dcm', Data, 32, 24, 16, ImageLength, ImageOffset )
+	Data, ImageLength, ImageOffset = UncompressedImage( 32, 17, 8, IMPLICIT_LITTLE_ENDIAN )
+	WriteSeed( Manifest, 'ImplicitLittle.dcm', Data, 32, 17, 8, ImageLength, ImageOffset )
+	Data, ImageLength, ImageOffset = UncompressedImage( 16, 16, 16, Sequences = Sequences() )
+	WriteSeed( Manifest, 'Sequences.dcm', Data, 16, 16, 16, ImageLength, ImageOffset )
+	# The image data spans several of the 64K buffers the file is read into.
+	Data, ImageLength, ImageOffset = UncompressedImage( 300, 250, 16 )
+	WriteSeed( Manifest, 'MultipleBuffers.dcm', Data, 300, 250, 16, ImageLength, ImageOffset )
+	# Encapsulated pixel data:  an empty basic offset table, then one fragment.
+	Fragment = b'\xFF\xD8' + bytes( range( 60 ) ) + b'\xFF\xD9'
+	Data = MetaInformation( JPEG_LOSSLESS ) + DataSet( 8, 8, 16 )
+	Data += Element( 0x7FE0, 0x0010, 'OB', b'', Length = UNDEFINED_LENGTH )
+	Data += Element( 0xFFFE, 0xE000, '', b'' ) + Element( 0xFFFE, 0xE000, '', Fragment )
+	ImageOffset = len( Data ) - len( Fragment )
+	Data += Element( 0xFFFE, 0xE0DD, '', b'' )
+	WriteSeed( Manifest, 'Encapsulated.dcm', Data, 8, 8, 16, len( Fragment ), ImageOffset )
+	# The pixel data element declares more data than the file holds.
+	Data, ImageLength, ImageOffset = UncompressedImage( 32, 24, 16 )
+	WriteSeed( Manifest, 'TruncatedImage.dcm', Data[ : -100 ], 0, 0, 0, 0, 0 )
+	# An element value length extends beyond the end of the file.
+	Data = MetaInformation( EXPLICIT_LITTLE_ENDIAN ) + DataSet( 8, 8, 16 )
+	Data += Element( 0x0020, 0x4000, 'LT', b'', Length = 0xFFF0 )
+	WriteSeed( Manifest, 'ValueTooLong.dcm', Data, 0, 0, 0, 0, 0 )
+	# The required modality element is missing, as is the patient name.
+	Data = MetaInformation( EXPLICIT_LITTLE_ENDIAN ) + Element( 0x0028, 0x0010, 'US', UnsignedShort( 8 ) )
+	WriteSeed( Manifest, 'MissingModality.dcm', Data, 0, 0, 0, 0, 0 )
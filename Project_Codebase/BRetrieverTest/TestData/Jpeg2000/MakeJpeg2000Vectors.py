@@ -0,0 +1,78 @@
+# MakeJpeg2000Vectors.py : Generates the JPEG 2000 conformance vectors used by BRetrieverTest.
+#
+#	Each vector is a codestream (.j2k) or JP2 file (.jp2) encoded by OpenJPEG through Pillow,
+#	together with the pixel values OpenJPEG decodes from it (.raw, little-endian samples of the
+#	Dicom bits allocated).  The reference values are taken from the decoder rather than from the
+#	encoder input, because OpenJPEG through Pillow doesn't encode tiled 16-bit images faithfully.  The vectors are listed in Jpeg2000Vectors.txt with the dimensions
+#	the Dicom header would declare and whether BRetriever is expected to decode or reject them.
+#	The rejected vectors have no .raw file.
+#
+#	Usage:  python MakeJpeg2000Vectors.py      (run in this directory; requires Pillow)
+#
+import io
+import random
+import struct
+
+from PIL import Image
+
+
+def MakePixels( Columns, Rows, BitsStored, Seed ):
+	# A gradient with noise, so that every wavelet subband carries data.
+	Generator = random.Random( Seed )
+	MaxValue = ( 1 << BitsStored ) - 1
+	Pixels = []
+	for y in range( Rows ):
+		for x in range( Columns ):
+			Value = ( x * MaxValue ) // ( 2 * max( 1, Columns - 1 ) ) + ( y * MaxValue ) // ( 4 * max( 1, Rows - 1 ) )
+			Value += Generator.randint( 0, MaxValue // 4 )
+			Pixels.append( min( MaxValue, Value ) )
+	# Include the extreme values.
+	Pixels[ 0 ] = 0
+	Pixels[ -1 ] = MaxValue
+	return Pixels
+
+
+def MakeImage( Columns, Rows, BitsAllocated, Pixels ):
+	Mode = 'L' if BitsAllocated == 8 else 'I;16'
+	Picture = Image.new( Mode, ( Columns, Rows ) )
+	Picture.putdata( Pixels )
+	return Picture
+
+
+def WriteVector( Manifest, Name, Columns, Rows, BitsAllocated, BitsStored, Expectation, Seed, DeclaredSize = None, **EncodingOptions ):
+	Pixels = MakePixels( Columns, Rows, BitsStored, Seed )
+	Picture = MakeImage( Columns, Rows, BitsAllocated, Pixels )
+	Suffix = '.jp2' if not EncodingOptions.get( 'no_jp2', False ) else '.j2k'
+	EncodedImage = io.BytesIO()
+	Picture.save( EncodedImage, 'JPEG2000', **EncodingOptions )
+	with open( Name + Suffix, 'wb' ) as OutputFile:
+		OutputFile.write( EncodedImage.getvalue() )
+	if Expectation == 'DECODE':
+		Pixels = list( Image.open( io.BytesIO( EncodedImage.getvalue() ) ).get_flattened_data() )
+		SampleFormat = '<%dB' if BitsAllocated == 8 else '<%dH'
+		with open( Name + '.raw', 'wb' ) as OutputFile:
+			OutputFile.write( struct.pack( SampleFormat % len( Pixels ), *Pixels ) )
+	if DeclaredSize is not None:
+		Columns, Rows = DeclaredSize
+	Manifest.write( '%-28s %5d %5d %3d  %s\n' % ( Name + Suffix, Columns, Rows, BitsAllocated, Expectation ) )
+
+
+with open( 'Jpeg2000Vectors.txt', 'w' ) as Manifest:
+	Manifest.write( '# File                      Columns Rows Bits  Expected result\n' )
+	Reversible = dict( irreversible = False, no_jp2 = True )
+	WriteVector( Manifest, 'Gray8',                61, 47,  8,  8, 'DECODE', 1, **Reversible )
+	WriteVector( Manifest, 'Gray16',               67, 45, 16, 16, 'DECODE', 2, **Reversible )
+	WriteVector( Manifest, 'Gray12',               67, 45, 16, 12, 'DECODE', 3, **Reversible )
+	WriteVector( Manifest, 'Gray12OneResolution',  67, 45, 16, 12, 'DECODE', 4, num_resolutions = 1, **Reversible )
+	WriteVector( Manifest, 'Gray12SixResolutions', 130, 97, 16, 12, 'DECODE', 5, num_resolutions = 6, **Reversible )
+	WriteVector( Manifest, 'Gray12Tiles',          67, 45, 16, 12, 'DECODE', 6, tile_size = ( 32, 32 ), **Reversible )
+	WriteVector( Manifest, 'Gray12ImageOffset',    67, 45, 16, 12, 'DECODE', 7, offset = ( 5, 3 ), tile_size = ( 32, 32 ), **Reversible )
+	WriteVector( Manifest, 'Gray12SmallBlocks',    67, 45, 16, 12, 'DECODE', 8, cblk_size = ( 16, 16 ), **Reversible )
+	WriteVector( Manifest, 'Gray12Layers',         67, 45, 16, 12, 'DECODE', 9, quality_mode = 'rates', quality_layers = [ 40, 10, 0 ], **Reversible )
+	for Progression in ( 'RLCP', 'RPCL', 'PCRL', 'CPRL' ):
+		WriteVector( Manifest, 'Gray12Layers' + Progression, 67, 45, 16, 12, 'DECODE', 10, progression = Progression,
+						quality_mode = 'rates', quality_layers = [ 40, 10, 0 ], **Reversible )
+	WriteVector( Manifest, 'Gray12FileFormat',     67, 45, 16, 12, 'DECODE', 11, irreversible = False )
+	WriteVector( Manifest, 'Gray12Irreversible',   67, 45, 16, 12, 'REJECT', 12, irreversible = True, no_jp2 = True )
+	# The Dicom rows and columns disagree with the codestream.
+	WriteVector( Manifest, 'Gray12WrongSize',      67, 45, 16, 12, 'REJECT', 13, DeclaredSize = ( 45, 67 ), **Reversible )
@@ -0,0 +1,241 @@
+# MakeLosslessJpegVectors.py : Generates the lossless JPEG test vectors used by BRetrieverTest.
+#
+#	Each vector is a lossless (process 14, SOF3) JPEG image, written by the encoder below,
+#	together with the pixel values it decodes to (.raw, little-endian samples of 8 or 16 bits).
+#	The vectors are listed in LosslessJpegVectors.txt with the Dicom columns, rows and bits
+#	stored, and the decoder expected to handle them:
+#
+#		FAST		The lossless decoder in ReformatJpegLossless.cpp.
+#		LIBRARY		The JPEG libraries.  The lossless decoder declines the image.
+#		FALLBACK	The lossless decoder accepts the image but fails, and the JPEG libraries
+#					are used instead.  The image is damaged, so only its size is checked.
+#		NONE		Neither decoder accepts the image.
+#
+#	Usage:  python MakeLosslessJpegVectors.py      (run in this directory)
+#
+import random
+import struct
+
+
+def MakePixels( Columns, Rows, BitsStored, Seed ):
+	# A gradient with noise, including the extreme values and the largest possible difference.
+	Generator = random.Random( Seed )
+	MaxValue = ( 1 << BitsStored ) - 1
+	Pixels = []
+	for y in range( Rows ):
+		for x in range( Columns ):
+			Value = ( x * MaxValue ) // ( 2 * max( 1, Columns - 1 ) ) + ( y * MaxValue ) // ( 4 * max( 1, Rows - 1 ) )
+			Value += Generator.randint( 0, MaxValue // 4 )
+			Pixels.append( min( MaxValue, Value ) )
+	Pixels[ 0 ] = 0
+	Pixels[ 1 ] = ( MaxValue + 1 ) // 2
+	Pixels[ -1 ] = MaxValue
+	return Pixels
+
+
+def Predict( Selection, Ra, Rb, Rc ):
+	# JPEG standard, table H.1.  The arithmetic is done in 32 bits and the shifts are arithmetic.
+	if Selection == 1:
+		return Ra
+	if Selection == 2:
+		return Rb
+	if Selection == 3:
+		return Rc
+	if Selection == 4:
+		return Ra + Rb - Rc
+	if Selection == 5:
+		return Ra + ( ( Rb - Rc ) >> 1 )
+	if Selection == 6:
+		return Rb + ( ( Ra - Rc ) >> 1 )
+	return ( Ra + Rb ) >> 1
+
+
+def ComputeDifferences( Pixels, Columns, Rows, Precision, Selection, PointTransform, RestartInterval ):
+	# Return the sample differences, each tagged with the restart interval it belongs to.
+	# JPEG standard, H.1.2.1:  the first sample of a scan or restart interval is predicted from
+	# the default value, the rest of its first row from the sample to the left, and the first
+	# sample of each later row from the sample above.
+	Samples = [ Value >> PointTransform for Value in Pixels ]
+	Differences = []
+	for Index in range( Columns * Rows ):
+		nInterval = Index // RestartInterval if RestartInterval > 0 else 0
+		nSampleInInterval = Index - nInterval * RestartInterval
+		if nSampleInInterval == 0:
+			Prediction = 1 << ( Precision - PointTransform - 1 )
+		elif nSampleInInterval < Columns:
+			Prediction = Samples[ Index - 1 ]
+		elif Index % Columns == 0:
+			Prediction = Samples[ Index - Columns ]
+		else:
+			Prediction = Predict( Selection, Samples[ Index - 1 ], Samples[ Index - Columns ], Samples[ Index - Columns - 1 ] )
+		Difference = ( Samples[ Index ] - Prediction ) & 0xFFFF
+		if Difference >= 0x8000:
+			Difference -= 0x10000
+		Differences.append( ( nInterval, Difference ) )
+	return Differences
+
+
+def DifferenceCategory( Difference ):
+	if Difference == -0x8000:
+		return 16
+	return abs( Difference ).bit_length()
+
+
+def OptimalCodeLengths( Frequencies ):
+	# JPEG standard, K.2:  Huffman code lengths, limited to 16 bits, with a reserved
+	# symbol keeping any code from consisting of all ones.
+	Frequency = list( Frequencies ) + [ 1 ]
+	CodeSize = [ 0 ] * len( Frequency )
+	Others = [ -1 ] * len( Frequency )
+	while True:
+		Candidates = [ i for i in range( len( Frequency ) ) if Frequency[ i ] > 0 ]
+		if len( Candidates ) < 2:
+			break
+		Candidates.sort( key = lambda i: ( Frequency[ i ], -i ) )
+		V1, V2 = Candidates[ 0 ], Candidates[ 1 ]
+		Frequency[ V1 ] += Frequency[ V2 ]
+		Frequency[ V2 ] = 0
+		CodeSize[ V1 ] += 1
+		while Others[ V1 ] >= 0:
+			V1 = Others[ V1 ]
+			CodeSize[ V1 ] += 1
+		Others[ V1 ] = V2
+		CodeSize[ V2 ] += 1
+		while Others[ V2 ] >= 0:
+			V2 = Others[ V2 ]
+			CodeSize[ V2 ] += 1
+	Bits = [ 0 ] * 33
+	for Size in CodeSize:
+		if Size > 0:
+			Bits[ Size ] += 1
+	for i in range( 32, 16, -1 ):
+		while Bits[ i ] > 0:
+			j = i - 2
+			while Bits[ j ] == 0:
+				j -= 1
+			Bits[ i ] -= 2
+			Bits[ i - 1 ] += 1
+			Bits[ j + 1 ] += 2
+			Bits[ j ] -= 1
+	i = 16
+	while Bits[ i ] == 0:
+		i -= 1
+	Bits[ i ] -= 1			# Remove the reserved symbol.
+	# Assign the lengths to the symbols in order of decreasing frequency.
+	Symbols = sorted( [ s for s in range( len( Frequencies ) ) if Frequencies[ s ] > 0 ], key = lambda s: ( -Frequencies[ s ], s ) )
+	return Bits[ 1:17 ], Symbols
+
+
+def LongCodeLengths( Frequencies ):
+	# Give the symbols codes of increasing length in category order, so that the common
+	# categories are coded with more than 12 bits.
+	Symbols = list( range( 17 ) )
+	Bits = [ 0 ] * 16
+	for nSymbol in range( 17 ):
+		Bits[ min( nSymbol + 2, 16 ) - 1 ] += 1
+	return Bits, Symbols
+
+
+class BitWriter:
+	def __init__( self ):
+		self.Bytes = bytearray()
+		self.Accumulator = 0
+		self.nBits = 0
+
+	def Write( self, Value, nBits ):
+		for nBit in range( nBits - 1, -1, -1 ):
+			self.Accumulator = ( self.Accumulator << 1 ) | ( ( Value >> nBit ) & 1 )
+			self.nBits += 1
+			if self.nBits == 8:
+				self.Bytes.append( self.Accumulator )
+				if self.Accumulator == 0xFF:
+					self.Bytes.append( 0x00 )
+				self.Accumulator = 0
+				self.nBits = 0
+
+	def Flush( self ):
+		# Pad the final byte with one bits.
+		while self.nBits != 0:
+			self.Write( 1, 1 )
+
+
+def Segment( Marker, Payload ):
+	return struct.pack( '>BBH', 0xFF, Marker, len( Payload ) + 2 ) + bytes( Payload )
+
+
+def EncodeLosslessJpeg( Pixels, Columns, Rows, Precision, Selection = 1, PointTransform = 0, RestartInterval = 0,
+							bLongCodes = False, BadCodeSample = None ):
+	Differences = ComputeDifferences( Pixels, Columns, Rows, Precision, Selection, PointTransform, RestartInterval )
+	Frequencies = [ 0 ] * 17
+	for nInterval, Difference in Differences:
+		Frequencies[ DifferenceCategory( Difference ) ] += 1
+	if bLongCodes:
+		Bits, Symbols = LongCodeLengths( Frequencies )
+	else:
+		Bits, Symbols = OptimalCodeLengths( Frequencies )
+	# Assign the canonical codes, JPEG standard, C.2.
+	Codes = {}
+	Code = 0
+	nSymbol = 0
+	for nLength in range( 1, 17 ):
+		for n in range( Bits[ nLength - 1 ] ):
+			Codes[ Symbols[ nSymbol ] ] = ( Code, nLength )
+			Code += 1
+			nSymbol += 1
+		Code <<= 1
+	Output = bytearray( b'\xFF\xD8' )
+	Output += Segment( 0xC4, bytes( [ 0x00 ] ) + bytes( Bits ) + bytes( Symbols ) )
+	Output += Segment( 0xC3, struct.pack( '>BHHBBBB', Precision, Rows, Columns, 1, 1, 0x11, 0 ) )
+	if RestartInterval > 0:
+		Output += Segment( 0xDD, struct.pack( '>H', RestartInterval ) )
+	Output += Segment( 0xDA, bytes( [ 1, 1, 0x00, Selection, 0, PointTransform ] ) )
+	Writer = BitWriter()
+	CurrentInterval = 0
+	for nSample, ( nInterval, Difference ) in enumerate( Differences ):
+		if nInterval != CurrentInterval:
+			Writer.Flush()
+			Writer.Bytes += bytes( [ 0xFF, 0xD0 + CurrentInterval % 8 ] )
+			CurrentInterval = nInterval
+		if nSample == BadCodeSample:
+			Writer.Write( 0xFFFF, 16 )		# Not a Huffman code.
+		Category = DifferenceCategory( Difference )
+		Code, nLength = Codes[ Category ]
+		Writer.Write( Code, nLength )
+		if 0 < Category < 16:
+			if Difference < 0:
+				Difference += ( 1 << Category ) - 1
+			Writer.Write( Difference & ( ( 1 << Category ) - 1 ), Category )
+	Writer.Flush()
+	Output += Writer.Bytes
+	Output += b'\xFF\xD9'
+	return bytes( Output )
+
+
+def WriteVector( Manifest, Name, Columns, Rows, Precision, Decoder, Seed, **EncodingOptions ):
+	Pixels = MakePixels( Columns, Rows, Precision, Seed )
+	with open( Name + '.jpg', 'wb' ) as OutputFile:
+		OutputFile.write( EncodeLosslessJpeg( Pixels, Columns, Rows, Precision, **EncodingOptions ) )
+	if Decoder in ( 'FAST', 'LIBRARY' ):
+		PointTransform = EncodingOptions.get( 'PointTransform', 0 )
+		Pixels = [ ( Value >> PointTransform ) << PointTransform for Value in Pixels ]
+		SampleFormat = '<%dB' if Precision <= 8 else '<%dH'
+		with open( Name + '.raw', 'wb' ) as OutputFile:
+			OutputFile.write( struct.pack( SampleFormat % len( Pixels ), *Pixels ) )
+	Manifest.write( '%-28s %5d %5d %3d  %s\n' % ( Name + '.jpg', Columns, Rows, Precision, Decoder ) )
+
+
+with open( 'LosslessJpegVectors.txt', 'w' ) as Manifest:
+	Manifest.write( '# File                      Columns Rows Bits  Decoder\n' )
+	WriteVector( Manifest, 'Gray12',                67, 45, 12, 'FAST', 1 )
+	WriteVector( Manifest, 'Gray16',                67, 45, 16, 'FAST', 2 )
+	WriteVector( Manifest, 'Gray10',                61, 47, 10, 'FAST', 3 )
+	WriteVector( Manifest, 'Gray12Restart',         67, 45, 12, 'FAST', 4, RestartInterval = 3 * 67 )
+	WriteVector( Manifest, 'Gray12PointTransform',  67, 45, 12, 'FAST', 5, PointTransform = 2 )
+	WriteVector( Manifest, 'Gray12LongCodes',       67, 45, 12, 'FAST', 6, bLongCodes = True )
+	WriteVector( Manifest, 'Gray16LongCodes',       67, 45, 16, 'FAST', 7, bLongCodes = True )
+	for Selection in range( 2, 8 ):
+		WriteVector( Manifest, 'Gray12Predictor%d' % Selection, 67, 45, 12, 'LIBRARY', 10 + Selection, Selection = Selection )
+	WriteVector( Manifest, 'Gray16Predictor6',      67, 45, 16, 'LIBRARY', 20, Selection = 6 )
+	WriteVector( Manifest, 'Gray12RestartMidRow',   67, 45, 12, 'NONE', 21, RestartInterval = 50 )
+	WriteVector( Manifest, 'Gray8',                 61, 47,  8, 'LIBRARY', 22 )
+	WriteVector( Manifest, 'Gray16BadCode',         67, 45, 16, 'FALLBACK', 23, BadCodeSample = 1000 )
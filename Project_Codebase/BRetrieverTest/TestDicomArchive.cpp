@@ -0,0 +1,415 @@
+// TestDicomArchive.cpp : Implements the tests of the Dicom archive packs written by DicomArchive.cpp,
+//	including the recovery of a pack left incomplete by an interruption.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "ServiceMain.h"
+#include "DicomArchive.h"
+#include "BRetrieverTest.h"
+
+
+extern CONFIGURATION			ServiceConfiguration;
+
+
+#define TEST_STUDY_INSTANCE_UID			"1.2.840.99999.1.1"
+#define TEST_PACK_FILE_SPEC				TEST_ARCHIVE_DIRECTORY "\\" TEST_STUDY_INSTANCE_UID ARCHIVE_PACK_FILE_EXTENSION
+#define MAX_TEST_PACK_MEMBERS			16
+#define MAX_TEST_MEMBER_NUMBER			6
+
+
+// The layout of a pack file, as found by walking its member headers to the end of the file.
+typedef struct
+	{
+	ARCHIVE_PACK_HEADER		PackHeader;
+	long					nMembers;
+	__int64					MemberOffset[ MAX_TEST_PACK_MEMBERS ];
+	ARCHIVE_MEMBER_HEADER	MemberHeader[ MAX_TEST_PACK_MEMBERS ];
+	__int64					FileSize;
+	} TEST_PACK_LAYOUT;
+
+
+static BOOL ReadTestPackFile( char **ppPackData, unsigned long *pPackLength )
+{
+	return ReadFileContents( TEST_PACK_FILE_SPEC, ppPackData, pPackLength );
+}
+
+
+static BOOL WriteTestPackFile( char *pPackData, unsigned long PackLength )
+{
+	BOOL			bNoError = TRUE;
+	FILE			*pPackFile;
+
+	pPackFile = fopen( TEST_PACK_FILE_SPEC, "wb" );
+	bNoError = ( pPackFile != 0 );
+	if ( bNoError )
+		{
+		bNoError = ( fwrite( pPackData, 1, PackLength, pPackFile ) == PackLength );
+		fclose( pPackFile );
+		}
+
+	return bNoError;
+}
+
+
+static BOOL ReadTestPackLayout( TEST_PACK_LAYOUT *pPackLayout )
+{
+	BOOL					bNoError = TRUE;
+	char					*pPackData;
+	unsigned long			PackLength;
+	__int64					MemberOffset;
+	ARCHIVE_MEMBER_HEADER	*pMemberHeader;
+
+	memset( pPackLayout, 0, sizeof(TEST_PACK_LAYOUT) );
+	bNoError = ReadTestPackFile( &pPackData, &PackLength );
+	if ( bNoError )
+		{
+		bNoError = ( PackLength >= sizeof(ARCHIVE_PACK_HEADER) );
+		if ( bNoError )
+			{
+			memcpy( &pPackLayout -> PackHeader, pPackData, sizeof(ARCHIVE_PACK_HEADER) );
+			pPackLayout -> FileSize = PackLength;
+			MemberOffset = sizeof(ARCHIVE_PACK_HEADER);
+			while ( bNoError && MemberOffset < (__int64)PackLength )
+				{
+				pMemberHeader = (ARCHIVE_MEMBER_HEADER*)&pPackData[ MemberOffset ];
+				bNoError = ( pPackLayout -> nMembers < MAX_TEST_PACK_MEMBERS &&
+								MemberOffset + (__int64)sizeof(ARCHIVE_MEMBER_HEADER) <= (__int64)PackLength &&
+								pMemberHeader -> Signature == ARCHIVE_MEMBER_SIGNATURE );
+				if ( bNoError )
+					{
+					pPackLayout -> MemberOffset[ pPackLayout -> nMembers ] = MemberOffset;
+					memcpy( &pPackLayout -> MemberHeader[ pPackLayout -> nMembers ], pMemberHeader, sizeof(ARCHIVE_MEMBER_HEADER) );
+					pPackLayout -> nMembers++;
+					MemberOffset += sizeof(ARCHIVE_MEMBER_HEADER) + pMemberHeader -> StoredSize;
+					}
+				}
+			bNoError = ( bNoError && MemberOffset == (__int64)PackLength );
+			}
+		free( pPackData );
+		}
+
+	return bNoError;
+}
+
+
+// Check that the pack is committed in full, and that its members have the expected names and
+// compression methods.  Each member is described by its name followed by a 'D' if it is
+// deflated or an 'S' if it is stored, e.g., "Image1D Image2S".
+static BOOL TestPackHasMembers( char *pExpectedMembers )
+{
+	BOOL					bNoError = TRUE;
+	TEST_PACK_LAYOUT		PackLayout;
+	char					PackMembers[ 256 ];
+	char					MemberDescription[ 128 ];
+	long					nMember;
+
+	PackMembers[ 0 ] = '\0';
+	bNoError = ReadTestPackLayout( &PackLayout );
+	if ( bNoError )
+		bNoError = ( PackLayout.PackHeader.Signature == ARCHIVE_PACK_SIGNATURE &&
+						PackLayout.PackHeader.Version == ARCHIVE_PACK_VERSION &&
+						PackLayout.PackHeader.nMembers == (unsigned long)PackLayout.nMembers &&
+						PackLayout.PackHeader.CommittedLength == PackLayout.FileSize );
+	for ( nMember = 0; bNoError && nMember < PackLayout.nMembers; nMember++ )
+		{
+		_snprintf_s( MemberDescription, 128, _TRUNCATE, "%s%s%c", ( nMember > 0 ) ? " " : "",
+						PackLayout.MemberHeader[ nMember ].MemberName,
+						( PackLayout.MemberHeader[ nMember ].CompressionMethod == ARCHIVE_MEMBER_DEFLATED ) ? 'D' : 'S' );
+		strncat_s( PackMembers, 256, MemberDescription, _TRUNCATE );
+		}
+	if ( bNoError )
+		bNoError = ( strcmp( PackMembers, pExpectedMembers ) == 0 );
+	if ( !bNoError )
+		printf( "    The archive pack contains \"%s\", rather than \"%s\".\n", PackMembers, pExpectedMembers );
+
+	return bNoError;
+}
+
+
+static void GetExtractedFileSpec( char *pMemberName, char *pFileSpec )
+{
+	_snprintf_s( pFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\%s", TEST_EXTRACT_DIRECTORY, pMemberName );
+}
+
+
+static void DeleteExtractedFiles()
+{
+	char			MemberName[ 64 ];
+	char			FileSpec[ MAX_FILE_SPEC_LENGTH ];
+	long			nMember;
+
+	for ( nMember = 1; nMember <= MAX_TEST_MEMBER_NUMBER; nMember++ )
+		{
+		_snprintf_s( MemberName, 64, _TRUNCATE, "Image%d", nMember );
+		GetExtractedFileSpec( MemberName, FileSpec );
+		DeleteFile( FileSpec );
+		}
+}
+
+
+// Check that the member was extracted with the contents of the specified test data file, or,
+// if no test data file is specified, that it was not extracted.
+static BOOL ExtractedFileMatches( char *pMemberName, char *pRelativeSourceFileSpec )
+{
+	BOOL			bNoError = TRUE;
+	char			FileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char			*pSourceData;
+	unsigned long	SourceLength;
+	char			*pExtractedData;
+	unsigned long	ExtractedLength;
+	FILE			*pExtractedFile;
+
+	pSourceData = 0;
+	pExtractedData = 0;
+	GetExtractedFileSpec( pMemberName, FileSpec );
+	if ( pRelativeSourceFileSpec == 0 )
+		{
+		pExtractedFile = fopen( FileSpec, "rb" );
+		bNoError = ( pExtractedFile == 0 );
+		if ( pExtractedFile != 0 )
+			fclose( pExtractedFile );
+		}
+	else
+		{
+		bNoError = ReadTestDataFile( pRelativeSourceFileSpec, &pSourceData, &SourceLength );
+		if ( bNoError )
+			bNoError = ReadFileContents( FileSpec, &pExtractedData, &ExtractedLength );
+		if ( bNoError )
+			bNoError = ( ExtractedLength == SourceLength && memcmp( pExtractedData, pSourceData, SourceLength ) == 0 );
+		}
+	if ( pSourceData != 0 )
+		free( pSourceData );
+	if ( pExtractedData != 0 )
+		free( pExtractedData );
+
+	return bNoError;
+}
+
+
+static BOOL AppendTestDataFile( char *pMemberName, char *pRelativeSourceFileSpec, BOOL bCompress )
+{
+	char			SourceFileSpec[ MAX_FILE_SPEC_LENGTH ];
+
+	GetTestDataFileSpec( pRelativeSourceFileSpec, SourceFileSpec, MAX_FILE_SPEC_LENGTH );
+	ServiceConfiguration.bCompressDicomImageArchive = bCompress;
+
+	return AppendToArchivePack( TEST_ARCHIVE_DIRECTORY, TEST_STUDY_INSTANCE_UID, pMemberName, SourceFileSpec );
+}
+
+
+// The source files for the archived images.  The raw pixel values of up to 12 bits compress
+// well, and the 16-bit values and the lossless JPEG image don't.
+static char		*pImage1Source = "JpegLossless\\Gray12.raw";
+static char		*pImage1ReplacementSource = "Jpeg2000\\Gray12.raw";
+static char		*pImage2Source = "JpegLossless\\Gray16.jpg";
+static char		*pImage3Source = "Jpeg2000\\Gray8.raw";
+static char		*pImage4Source = "JpegLossless\\Gray10.raw";
+static char		*pImage5Source = "Jpeg2000\\Gray16.raw";
+static char		*pImage6Source = "JpegLossless\\Gray8.raw";
+
+
+static BOOL ExtractedPackMatches( BOOL bImage2IsIntact, BOOL bImage4IsIntact, BOOL bImage5IsIntact, BOOL bImage6IsIntact )
+{
+	BOOL			bNoError = TRUE;
+
+	bNoError = ( ExtractedFileMatches( "Image1", pImage1ReplacementSource ) &&
+					ExtractedFileMatches( "Image2", bImage2IsIntact ? pImage2Source : 0 ) &&
+					ExtractedFileMatches( "Image3", pImage3Source ) &&
+					ExtractedFileMatches( "Image4", bImage4IsIntact ? pImage4Source : 0 ) &&
+					ExtractedFileMatches( "Image5", bImage5IsIntact ? pImage5Source : 0 ) &&
+					ExtractedFileMatches( "Image6", bImage6IsIntact ? pImage6Source : 0 ) );
+	DeleteExtractedFiles();
+
+	return bNoError;
+}
+
+
+// Archive a few images, one of them twice, then extract and compact the pack.
+static void TestArchivePackAppending()
+{
+	BOOL			bNoError = TRUE;
+
+	DeleteFile( TEST_PACK_FILE_SPEC );
+	DeleteExtractedFiles();
+	bNoError = ( AppendTestDataFile( "Image1", pImage1Source, TRUE ) &&
+					AppendTestDataFile( "Image2", pImage2Source, TRUE ) &&
+					AppendTestDataFile( "Image1", pImage1ReplacementSource, TRUE ) &&
+					AppendTestDataFile( "Image3", pImage3Source, FALSE ) );
+	FlushArchivePack();
+	CheckTestResult( bNoError && TestPackHasMembers( "Image1D Image2S Image1D Image3S" ),
+						"Archived files are appended to the pack, and deflated where it helps." );
+
+	bNoError = ExtractArchivePack( TEST_PACK_FILE_SPEC, TEST_EXTRACT_DIRECTORY );
+	CheckTestResult( bNoError && ExtractedPackMatches( TRUE, FALSE, FALSE, FALSE ),
+						"The latest version of each archived file is extracted." );
+
+	bNoError = CompactArchivePack( TEST_PACK_FILE_SPEC );
+	CheckTestResult( bNoError && TestPackHasMembers( "Image2S Image1D Image3S" ), "Superseded files are compacted out of the pack." );
+	bNoError = ExtractArchivePack( TEST_PACK_FILE_SPEC, TEST_EXTRACT_DIRECTORY );
+	CheckTestResult( bNoError && ExtractedPackMatches( TRUE, FALSE, FALSE, FALSE ), "The compacted pack is extracted intact." );
+}
+
+
+// Build the pack that an interruption would leave behind:  the committed pack header, followed
+// by every member written before the interruption.
+static BOOL WriteInterruptedPack( char *pCommittedPackData, char *pPackData, unsigned long PackLength )
+{
+	BOOL			bNoError = TRUE;
+	char			*pInterruptedPackData;
+
+	pInterruptedPackData = (char*)malloc( PackLength + 1 );
+	bNoError = ( pInterruptedPackData != 0 );
+	if ( bNoError )
+		{
+		memcpy( pInterruptedPackData, pPackData, PackLength );
+		memcpy( pInterruptedPackData, pCommittedPackData, sizeof(ARCHIVE_PACK_HEADER) );
+		bNoError = WriteTestPackFile( pInterruptedPackData, PackLength );
+		free( pInterruptedPackData );
+		}
+
+	return bNoError;
+}
+
+
+// Reopening the pack for appending recovers the intact members written since the last
+// commit, and discards an incomplete member.  If the pack header is damaged, every member is
+// verified.
+static void TestArchivePackRecovery()
+{
+	BOOL				bNoError = TRUE;
+	char				*pCommittedPackData;
+	unsigned long		CommittedPackLength;
+	char				*pPackData;
+	unsigned long		PackLength;
+	TEST_PACK_LAYOUT	PackLayout;
+	ARCHIVE_PACK_HEADER	*pPackHeader;
+
+	pCommittedPackData = 0;
+	pPackData = 0;
+	// Save the pack as committed, then append two more images.
+	bNoError = ReadTestPackFile( &pCommittedPackData, &CommittedPackLength );
+	if ( bNoError )
+		bNoError = ( AppendTestDataFile( "Image4", pImage4Source, TRUE ) && AppendTestDataFile( "Image5", pImage5Source, TRUE ) );
+	FlushArchivePack();
+	if ( bNoError )
+		bNoError = ( ReadTestPackFile( &pPackData, &PackLength ) && ReadTestPackLayout( &PackLayout ) && PackLayout.nMembers == 5 );
+	CheckTestResult( bNoError, "The recovery test pack is prepared." );
+	if ( bNoError )
+		{
+		// The last member was only partly written.
+		bNoError = ( WriteInterruptedPack( pCommittedPackData, pPackData, PackLength - 10 ) &&
+						AppendTestDataFile( "Image6", pImage6Source, FALSE ) );
+		FlushArchivePack();
+		CheckTestResult( bNoError && TestPackHasMembers( "Image2S Image1D Image3S Image4D Image6S" ),
+							"Intact uncommitted files are recovered, and a partly written file is discarded." );
+		bNoError = ExtractArchivePack( TEST_PACK_FILE_SPEC, TEST_EXTRACT_DIRECTORY );
+		CheckTestResult( bNoError && ExtractedPackMatches( TRUE, TRUE, FALSE, TRUE ), "The recovered pack is extracted intact." );
+
+		// The contents of the first uncommitted member are corrupted, so the location of the
+		// second is unknown.
+		pPackData[ PackLayout.MemberOffset[ 3 ] + sizeof(ARCHIVE_MEMBER_HEADER) + 5 ] ^= 0x55;
+		bNoError = ( WriteInterruptedPack( pCommittedPackData, pPackData, PackLength ) &&
+						AppendTestDataFile( "Image6", pImage6Source, FALSE ) );
+		FlushArchivePack();
+		CheckTestResult( bNoError && TestPackHasMembers( "Image2S Image1D Image3S Image6S" ),
+							"Uncommitted files following a corrupted file are discarded." );
+		pPackData[ PackLayout.MemberOffset[ 3 ] + sizeof(ARCHIVE_MEMBER_HEADER) + 5 ] ^= 0x55;
+
+		// The pack header is damaged.
+		pPackHeader = (ARCHIVE_PACK_HEADER*)pPackData;
+		pPackHeader -> nMembers = 1;
+		bNoError = ( WriteTestPackFile( pPackData, PackLength ) && AppendTestDataFile( "Image6", pImage6Source, FALSE ) );
+		FlushArchivePack();
+		CheckTestResult( bNoError && TestPackHasMembers( "Image2S Image1D Image3S Image4D Image5S Image6S" ),
+							"Every intact file is recovered when the pack header is damaged." );
+		bNoError = ExtractArchivePack( TEST_PACK_FILE_SPEC, TEST_EXTRACT_DIRECTORY );
+		CheckTestResult( bNoError && ExtractedPackMatches( TRUE, TRUE, TRUE, TRUE ), "The pack with a repaired header is extracted intact." );
+		pPackHeader -> nMembers = 5;
+		}
+	if ( pCommittedPackData != 0 )
+		free( pCommittedPackData );
+	if ( pPackData != 0 )
+		free( pPackData );
+}
+
+
+// A corrupted member is reported and skipped, without losing the others.  A file that isn't a
+// pack is never appended to.
+static void TestDamagedArchivePacks()
+{
+	BOOL				bNoError = TRUE;
+	char				*pPackData;
+	unsigned long		PackLength;
+	char				*pNotAPack = "This is not an archive pack, and must not be changed.";
+	TEST_PACK_LAYOUT	PackLayout;
+
+	pPackData = 0;
+	bNoError = ( ReadTestPackLayout( &PackLayout ) && PackLayout.nMembers == 6 && ReadTestPackFile( &pPackData, &PackLength ) );
+	if ( bNoError )
+		{
+		// Corrupt the contents of Image2.
+		pPackData[ PackLayout.MemberOffset[ 0 ] + sizeof(ARCHIVE_MEMBER_HEADER) + 100 ] ^= 0x01;
+		bNoError = WriteTestPackFile( pPackData, PackLength );
+		}
+	if ( bNoError )
+		bNoError = !ExtractArchivePack( TEST_PACK_FILE_SPEC, TEST_EXTRACT_DIRECTORY );
+	CheckTestResult( bNoError && ExtractedPackMatches( FALSE, TRUE, TRUE, TRUE ),
+						"A corrupted file is reported, and the others in the pack are extracted." );
+	bNoError = CompactArchivePack( TEST_PACK_FILE_SPEC );
+	CheckTestResult( bNoError && TestPackHasMembers( "Image1D Image3S Image4D Image5S Image6S" ),
+						"A corrupted file is compacted out of the pack." );
+
+	bNoError = WriteTestPackFile( pNotAPack, (unsigned long)strlen( pNotAPack ) );
+	if ( bNoError )
+		bNoError = !AppendTestDataFile( "Image1", pImage1Source, FALSE );
+	FlushArchivePack();
+	if ( pPackData != 0 )
+		free( pPackData );
+	if ( bNoError )
+		bNoError = ReadTestPackFile( &pPackData, &PackLength );
+	if ( bNoError )
+		{
+		bNoError = ( PackLength == strlen( pNotAPack ) && memcmp( pPackData, pNotAPack, PackLength ) == 0 );
+		free( pPackData );
+		}
+	CheckTestResult( bNoError, "A file that is not an archive pack is left unchanged." );
+}
+
+
+void TestDicomArchive()
+{
+	InitDicomArchiveModule();
+	TestArchivePackAppending();
+	TestArchivePackRecovery();
+	TestDamagedArchivePacks();
+	CloseDicomArchiveModule();
+
+	DeleteFile( TEST_PACK_FILE_SPEC );
+	DeleteFile( TEST_PACK_FILE_SPEC ".tmp" );
+	DeleteExtractedFiles();
+	RemoveDirectory( TEST_ARCHIVE_DIRECTORY );
+	RemoveDirectory( TEST_EXTRACT_DIRECTORY );
+}
+
@@ -0,0 +1,120 @@
+// TestDicomDictionary.cpp : Implements the tests of the Dicom dictionary index in DicomDictionary.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "BRetrieverTest.h"
+
+
+typedef struct
+	{
+	unsigned short		Group;
+	unsigned short		Element;
+	char				*pExpectedDescription;		// Null if no dictionary entry should match.
+	} DICTIONARY_LOOKUP;
+
+
+// The lookups expected from TestData\Dictionary\TestDictionary.txt.  The first matching entry
+// in the dictionary is found, whether it specifies a single tag or a range of tags.
+static DICTIONARY_LOOKUP		ExpectedDictionaryLookups[] =
+	{
+		{ 0x0008, 0x0005, "SpecificCharacterSet" },
+		{ 0x0008, 0x0016, "SOPClassUID" },
+		{ 0x0008, 0x0017, 0 },
+		{ 0x0008, 0x0018, "SOPInstanceUID" },
+		{ 0x0010, 0x0010, "PatientName" },
+		{ 0x0020, 0x3100, "SourceImageIDs" },
+		{ 0x0020, 0x3102, "SourceImageIDs" },
+		{ 0x0020, 0x3103, "OddSourceImageID" },
+		{ 0x0020, 0x31FE, "SourceImageIDs" },
+		{ 0x0020, 0x31FF, 0 },
+		{ 0x0020, 0x3200, 0 },
+		{ 0x0028, 0x0010, "Rows" },
+		{ 0x0028, 0x0011, "Columns" },
+		{ 0x0028, 0x0012, "ImagePixelRange" },
+		{ 0x0028, 0x00FF, "ImagePixelRange" },
+		{ 0x0028, 0x0100, 0 },
+		{ 0x0028, 0x1050, "WindowCenter" },
+		{ 0x6000, 0x0010, "OverlayRows" },
+		{ 0x6002, 0x0010, "OverlayRows" },
+		{ 0x60FE, 0x0010, "OverlayRows" },
+		{ 0x6100, 0x0010, 0 },
+		{ 0x7FE0, 0x0010, "PixelData" },
+		{ 0x7FE0, 0x0011, 0 },
+		{ 0x0000, 0x0000, 0 },
+		{ 0xFFFE, 0xE000, 0 }
+	};
+
+#define NUMBER_OF_DICTIONARY_LOOKUPS		( sizeof(ExpectedDictionaryLookups) / sizeof(DICTIONARY_LOOKUP) )
+
+
+static BOOL DictionaryLookupsMatch()
+{
+	BOOL					bNoError = TRUE;
+	DICTIONARY_LOOKUP		*pLookup;
+	size_t					nLookup;
+	DICOM_DICTIONARY_ITEM	*pDictItem;
+	TAG						DicomElementTag;
+	BOOL					bLookupMatches;
+
+	for ( nLookup = 0; nLookup < NUMBER_OF_DICTIONARY_LOOKUPS; nLookup++ )
+		{
+		pLookup = &ExpectedDictionaryLookups[ nLookup ];
+		DicomElementTag.Group = pLookup -> Group;
+		DicomElementTag.Element = pLookup -> Element;
+		pDictItem = GetDicomElementFromDictionary( DicomElementTag );
+		if ( pLookup -> pExpectedDescription == 0 )
+			bLookupMatches = ( pDictItem == 0 );
+		else
+			bLookupMatches = ( pDictItem != 0 && pDictItem -> Description != 0 &&
+									strcmp( pDictItem -> Description, pLookup -> pExpectedDescription ) == 0 );
+		if ( !bLookupMatches )
+			{
+			printf( "    (%04X,%04X) matched %s, rather than %s.\n", pLookup -> Group, pLookup -> Element,
+						( pDictItem != 0 && pDictItem -> Description != 0 ) ? pDictItem -> Description : "no entry",
+						( pLookup -> pExpectedDescription != 0 ) ? pLookup -> pExpectedDescription : "no entry" );
+			bNoError = FALSE;
+			}
+		}
+
+	return bNoError;
+}
+
+
+void TestDicomDictionary()
+{
+	BOOL				bNoError = TRUE;
+	char				DictionaryFileSpec[ MAX_FILE_SPEC_LENGTH ];
+
+	InitDictionaryModule();
+	GetTestDataFileSpec( "Dictionary\\TestDictionary.txt", DictionaryFileSpec, MAX_FILE_SPEC_LENGTH );
+	bNoError = ReadDictionaryFile( DictionaryFileSpec, FALSE );
+	CheckTestResult( bNoError && DictionaryLookupsMatch(), "The indexed dictionary finds the first matching entry for each tag." );
+	// Reading the dictionary again replaces the index.
+	bNoError = ReadDictionaryFile( DictionaryFileSpec, FALSE );
+	CheckTestResult( bNoError && DictionaryLookupsMatch(), "The dictionary index is rebuilt when the dictionary is read again." );
+	CloseDictionaryModule();
+}
+
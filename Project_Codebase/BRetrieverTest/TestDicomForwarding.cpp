@@ -0,0 +1,1015 @@
+// TestDicomForwarding.cpp : Implements the tests of the Send Image operation in DicomInitiator.cpp,
+//	which forward images over a loopback connection to a stand-in Dicom destination.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#pragma pack(push, 8)		// Pack structure members on 8-byte boundaries, as BRetriever does.
+#include <winsock2.h>
+#pragma pack(pop)
+#include <process.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "WinSocketsAPI.h"
+#include "DicomAssoc.h"
+#include "DicomCommand.h"
+#include "DicomInitiator.h"
+#include "BRetrieverTest.h"
+
+
+// The stand-in destination listens on a loopback port and answers the Send Image operation the
+// way a Dicom storage node would.  It offers the smallest maximum PDU length the operation
+// accepts, so that every data set is divided among several P-Data PDUs, and an asynchronous
+// operations window of STAND_IN_WINDOW requests.  It records what it receives, for the tests
+// to check.
+//
+// Each forwarded image is a copy of SOURCE_IMAGE_FILE with the last three digits of its SOP
+// instance UID replaced by the image number, so that the stand-in can tell the images apart.
+#define SOURCE_IMAGE_FILE					"DicomOutput\\Mono2Explicit16.dcm"
+#define SOURCE_SOP_INSTANCE_UID				"2.25.65394770264603669002061047758352458600"
+#define FORWARDING_QUEUE_DIRECTORY			TEST_FORWARDING_DIRECTORY "\\Queue"
+#define MAX_TEST_IMAGES						200
+#define STAND_IN_MAX_PDU_LENGTH				4096
+#define STAND_IN_WINDOW						8
+#define MAX_STAND_IN_PENDING_RESPONSES		64
+#define MAX_STAND_IN_DATA_SET_LENGTH		0x00100000
+#define STAND_IN_FLUSH_INTERVAL				200			// Milliseconds without a request before held responses are sent.
+#define PIPELINED_IMAGE_COUNT				40
+#define THROUGHPUT_IMAGE_COUNT				40
+#define STAND_IN_STORAGE_DELAY				5			// Milliseconds from a request to its response, in the throughput test.
+#define RETRY_BASE_INTERVAL					20			// Milliseconds, in place of FORWARDING_RETRY_BASE_INTERVAL.
+#define RETRY_MAX_INTERVAL					5000
+#define FORWARDING_TIMEOUT					20000
+
+extern PRODUCT_OPERATION		*pPrimaryOperationList;
+extern PRODUCT_OPERATION		OperationSendImage;
+extern ENDPOINT					EndPointNetworkIn;
+
+typedef struct
+	{
+	unsigned short		MessageID;
+	unsigned char		PresentationContextID;
+	unsigned short		Status;
+	char				SOPClassUID[ 68 ];
+	char				SOPInstanceUID[ 68 ];
+	ULONGLONG			DueTime;				// Zero while the response is held.
+	} STAND_IN_RESPONSE;
+
+static ENDPOINT					StandInEndPoint;
+static SOCKET					StandInListeningSocket = INVALID_SOCKET;
+static unsigned short			StandInPortNumber = 0;
+static HANDLE					hStandInThread = 0;
+static volatile BOOL			bStandInStopRequested = FALSE;
+static char						*pTestImageData[ MAX_TEST_IMAGES ];
+static unsigned long			TestImageSize = 0L;
+
+// The behavior of the stand-in, set by each test before it queues its images.
+static BOOL						bStandInHoldsResponses = FALSE;		// Answer a full window at once, newest first.
+static DWORD					StandInStorageDelay = 0;
+static int						nStandInFailingImage = -1;
+static int						nStandInFailuresRemaining = 0;		// Negative to fail every attempt.
+
+// What the stand-in observed.
+static volatile LONG			nStandInAssociations = 0;
+static volatile LONG			nStandInImagesStored = 0;
+static int						nStandInAttempts[ MAX_TEST_IMAGES ];
+static ULONGLONG				FailingImageAttemptTimes[ MAX_FORWARDING_ATTEMPTS + 4 ];
+static int						nFailingImageAttempts = 0;
+static unsigned long			MaxPDULengthReceived = 0L;
+static int						MaxOutstandingRequests = 0;
+static BOOL						bFragmentLengthsAreCorrect = TRUE;
+static BOOL						bDataSetsAreIntact = TRUE;
+static BOOL						bResponsesWereReordered = FALSE;
+
+
+static unsigned long GetBigEndian32( unsigned char *pBytes )
+{
+	return ( (unsigned long)pBytes[ 0 ] << 24 ) | ( (unsigned long)pBytes[ 1 ] << 16 ) | ( (unsigned long)pBytes[ 2 ] << 8 ) | pBytes[ 3 ];
+}
+
+
+static void PutBigEndian16( unsigned char *pBytes, unsigned long Value )
+{
+	pBytes[ 0 ] = (unsigned char)( Value >> 8 );
+	pBytes[ 1 ] = (unsigned char)Value;
+}
+
+
+static void PutBigEndian32( unsigned char *pBytes, unsigned long Value )
+{
+	PutBigEndian16( pBytes, Value >> 16 );
+	PutBigEndian16( pBytes + 2, Value );
+}
+
+
+static void PutLittleEndian16( unsigned char *pBytes, unsigned long Value )
+{
+	pBytes[ 0 ] = (unsigned char)Value;
+	pBytes[ 1 ] = (unsigned char)( Value >> 8 );
+}
+
+
+static void PutLittleEndian32( unsigned char *pBytes, unsigned long Value )
+{
+	PutLittleEndian16( pBytes, Value );
+	PutLittleEndian16( pBytes + 2, Value >> 16 );
+}
+
+
+static BOOL ReceiveStandInBytes( SOCKET StandInSocket, unsigned char *pBuffer, unsigned long nBytes )
+{
+	BOOL			bNoError = TRUE;
+	int				nBytesReceived;
+
+	while ( bNoError && nBytes > 0 )
+		{
+		bNoError = WindowsSocketReceive( StandInSocket, (char*)pBuffer, (int)nBytes, 0, &nBytesReceived, FALSE );
+		if ( bNoError && nBytesReceived <= 0 )
+			bNoError = FALSE;
+		if ( bNoError )
+			{
+			pBuffer += nBytesReceived;
+			nBytes -= nBytesReceived;
+			}
+		}
+
+	return bNoError;
+}
+
+
+static BOOL SendStandInBytes( SOCKET StandInSocket, unsigned char *pBuffer, unsigned long nBytes )
+{
+	BOOL			bNoError = TRUE;
+	int				nBytesSent;
+
+	while ( bNoError && nBytes > 0 )
+		{
+		bNoError = WindowsSocketSend( StandInSocket, (char*)pBuffer, (int)nBytes, 0, &nBytesSent );
+		if ( bNoError && nBytesSent <= 0 )
+			bNoError = FALSE;
+		if ( bNoError )
+			{
+			pBuffer += nBytesSent;
+			nBytes -= nBytesSent;
+			}
+		}
+
+	return bNoError;
+}
+
+
+// Append an item or subitem header and value to an association PDU under construction.
+static unsigned char *AppendStandInItem( unsigned char *pInsertPoint, unsigned char ItemType, char *pValue, unsigned long ValueLength )
+{
+	pInsertPoint[ 0 ] = ItemType;
+	pInsertPoint[ 1 ] = 0x00;
+	PutBigEndian16( pInsertPoint + 2, ValueLength );
+	memcpy( pInsertPoint + 4, pValue, ValueLength );
+
+	return pInsertPoint + 4 + ValueLength;
+}
+
+
+// Accept every presentation context of the association request, with the transfer syntax
+// proposed for it.
+static BOOL AcceptStandInAssociation( SOCKET StandInSocket, unsigned char *pRequest, unsigned long RequestLength )
+{
+	unsigned char		Reply[ 8192 ];
+	unsigned char		*pInsertPoint;
+	unsigned char		*pItem;
+	unsigned char		*pEndOfItem;
+	unsigned char		*pSubitem;
+	unsigned char		*pEndOfRequest;
+	unsigned char		ContextItem[ 72 ];
+	unsigned char		UserInfoItem[ 64 ];
+	unsigned char		*pUserInfoInsertPoint;
+	unsigned char		Value[ 4 ];
+	unsigned long		ItemLength;
+	unsigned long		SubitemLength;
+
+	memset( Reply, 0, 74 );
+	Reply[ 0 ] = 0x02;							// A-ASSOCIATE-AC
+	memcpy( Reply + 6, pRequest + 6, 68 );		// The protocol version and AE titles are returned as received.
+	pInsertPoint = AppendStandInItem( Reply + 74, 0x10, "1.2.840.10008.3.1.1.1", 21 );
+	pEndOfRequest = pRequest + RequestLength;
+	pItem = pRequest + 74;
+	while ( pItem + 4 <= pEndOfRequest )
+		{
+		ItemLength = ( pItem[ 2 ] << 8 ) | pItem[ 3 ];
+		pEndOfItem = pItem + 4 + ItemLength;
+		if ( pEndOfItem > pEndOfRequest )
+			pEndOfItem = pEndOfRequest;
+		if ( pItem[ 0 ] == 0x20 && pInsertPoint + 80 < Reply + sizeof(Reply) )
+			{
+			pSubitem = pItem + 8;
+			while ( pSubitem + 4 <= pEndOfItem )
+				{
+				SubitemLength = ( pSubitem[ 2 ] << 8 ) | pSubitem[ 3 ];
+				if ( pSubitem[ 0 ] == 0x40 && SubitemLength <= 64 )
+					{
+					// Presentation context ID, reserved, result (acceptance), reserved, then the transfer syntax.
+					ContextItem[ 0 ] = pItem[ 4 ];
+					ContextItem[ 1 ] = 0x00;
+					ContextItem[ 2 ] = 0x00;
+					ContextItem[ 3 ] = 0x00;
+					AppendStandInItem( ContextItem + 4, 0x40, (char*)pSubitem + 4, SubitemLength );
+					pInsertPoint = AppendStandInItem( pInsertPoint, 0x21, (char*)ContextItem, 8 + SubitemLength );
+					}
+				pSubitem += 4 + SubitemLength;
+				}
+			}
+		pItem = pEndOfItem;
+		}
+	PutBigEndian32( Value, STAND_IN_MAX_PDU_LENGTH );
+	pUserInfoInsertPoint = AppendStandInItem( UserInfoItem, 0x51, (char*)Value, 4 );
+	pUserInfoInsertPoint = AppendStandInItem( pUserInfoInsertPoint, 0x52, "1.2.3.4.5", 9 );
+	PutBigEndian16( Value, STAND_IN_WINDOW );
+	PutBigEndian16( Value + 2, 1 );
+	pUserInfoInsertPoint = AppendStandInItem( pUserInfoInsertPoint, 0x53, (char*)Value, 4 );
+	pInsertPoint = AppendStandInItem( pInsertPoint, 0x50, (char*)UserInfoItem, (unsigned long)( pUserInfoInsertPoint - UserInfoItem ) );
+	PutBigEndian32( Reply + 2, (unsigned long)( pInsertPoint - Reply ) - 6 );
+
+	return SendStandInBytes( StandInSocket, Reply, (unsigned long)( pInsertPoint - Reply ) );
+}
+
+
+static unsigned char *AppendResponseElement( unsigned char *pInsertPoint, unsigned short Element, char *pValue, unsigned long ValueLength )
+{
+	PutLittleEndian16( pInsertPoint, 0x0000 );
+	PutLittleEndian16( pInsertPoint + 2, Element );
+	PutLittleEndian32( pInsertPoint + 4, ValueLength );
+	memcpy( pInsertPoint + 8, pValue, ValueLength );
+
+	return pInsertPoint + 8 + ValueLength;
+}
+
+
+static unsigned char *AppendResponseUID( unsigned char *pInsertPoint, unsigned short Element, char *pUID )
+{
+	char				PaddedUID[ 68 ];
+	unsigned long		ValueLength;
+
+	memset( PaddedUID, 0, sizeof(PaddedUID) );
+	strncpy_s( PaddedUID, sizeof(PaddedUID), pUID, _TRUNCATE );
+	ValueLength = (unsigned long)strlen( PaddedUID );
+	ValueLength += ( ValueLength & 1 );			// The value is padded with a null to an even length.
+
+	return AppendResponseElement( pInsertPoint, Element, PaddedUID, ValueLength );
+}
+
+
+// Send the C-Store response in a single P-Data PDU.  The command set is implicit VR little endian.
+static BOOL SendStandInResponse( SOCKET StandInSocket, STAND_IN_RESPONSE *pResponse )
+{
+	unsigned char		Response[ 512 ];
+	unsigned char		*pCommandSet;
+	unsigned char		*pInsertPoint;
+	unsigned char		Value[ 4 ];
+	unsigned long		CommandSetLength;
+
+	pCommandSet = Response + 12;
+	pInsertPoint = pCommandSet + 12;			// Leave room for the group length element.
+	pInsertPoint = AppendResponseUID( pInsertPoint, 0x0002, pResponse -> SOPClassUID );
+	PutLittleEndian16( Value, DICOM_CMD_STORE_RESPONSE );
+	pInsertPoint = AppendResponseElement( pInsertPoint, 0x0100, (char*)Value, 2 );
+	PutLittleEndian16( Value, pResponse -> MessageID );
+	pInsertPoint = AppendResponseElement( pInsertPoint, 0x0120, (char*)Value, 2 );
+	PutLittleEndian16( Value, 0x0101 );			// No data set follows.
+	pInsertPoint = AppendResponseElement( pInsertPoint, 0x0800, (char*)Value, 2 );
+	PutLittleEndian16( Value, pResponse -> Status );
+	pInsertPoint = AppendResponseElement( pInsertPoint, 0x0900, (char*)Value, 2 );
+	pInsertPoint = AppendResponseUID( pInsertPoint, 0x1000, pResponse -> SOPInstanceUID );
+	CommandSetLength = (unsigned long)( pInsertPoint - pCommandSet );
+	PutLittleEndian32( Value, CommandSetLength - 12 );
+	AppendResponseElement( pCommandSet, 0x0000, (char*)Value, 4 );
+
+	Response[ 0 ] = 0x04;						// P-DATA-TF
+	Response[ 1 ] = 0x00;
+	PutBigEndian32( Response + 2, CommandSetLength + 6 );
+	PutBigEndian32( Response + 6, CommandSetLength + 2 );
+	Response[ 10 ] = pResponse -> PresentationContextID;
+	Response[ 11 ] = 0x03;						// The last fragment of a command.
+	if ( pResponse -> Status == 0x0000 )
+		InterlockedIncrement( &nStandInImagesStored );
+
+	return SendStandInBytes( StandInSocket, Response, CommandSetLength + 12 );
+}
+
+
+// Send the responses that are due.  Held responses are sent newest first, so that the operation
+// must match each one to its request by the message ID.
+static BOOL SendDueStandInResponses( SOCKET StandInSocket, STAND_IN_RESPONSE *pPendingResponses, int *pnPendingResponses )
+{
+	BOOL				bNoError = TRUE;
+	ULONGLONG			CurrentTime;
+	int					nResponse;
+	int					nRemainingResponses;
+
+	CurrentTime = GetTickCount64();
+	nRemainingResponses = 0;
+	if ( bStandInHoldsResponses )
+		{
+		for ( nResponse = *pnPendingResponses - 1; bNoError && nResponse >= 0; nResponse-- )
+			if ( pPendingResponses[ nResponse ].DueTime != 0 )
+				{
+				if ( nResponse > 0 )
+					bResponsesWereReordered = TRUE;
+				bNoError = SendStandInResponse( StandInSocket, &pPendingResponses[ nResponse ] );
+				}
+		}
+	for ( nResponse = 0; bNoError && nResponse < *pnPendingResponses; nResponse++ )
+		{
+		if ( pPendingResponses[ nResponse ].DueTime != 0 && pPendingResponses[ nResponse ].DueTime <= CurrentTime )
+			{
+			if ( !bStandInHoldsResponses )
+				bNoError = SendStandInResponse( StandInSocket, &pPendingResponses[ nResponse ] );
+			}
+		else
+			pPendingResponses[ nRemainingResponses++ ] = pPendingResponses[ nResponse ];
+		}
+	*pnPendingResponses = nRemainingResponses;
+
+	return bNoError;
+}
+
+
+// The data set must be the one in the image file, following the file meta information.
+static void RecordStandInRequest( STAND_IN_RESPONSE *pResponse, unsigned char *pDataSet, unsigned long DataSetLength )
+{
+	int					nImage;
+	size_t				UIDLength;
+
+	pResponse -> Status = 0x0000;
+	UIDLength = strlen( pResponse -> SOPInstanceUID );
+	nImage = ( UIDLength > 3 ) ? atoi( pResponse -> SOPInstanceUID + UIDLength - 3 ) : -1;
+	if ( nImage < 0 || nImage >= MAX_TEST_IMAGES || pTestImageData[ nImage ] == 0 ||
+				DataSetLength == 0 || DataSetLength >= TestImageSize ||
+				memcmp( pDataSet, pTestImageData[ nImage ] + TestImageSize - DataSetLength, DataSetLength ) != 0 )
+		{
+		bDataSetsAreIntact = FALSE;
+		pResponse -> Status = 0xA900;			// The data set does not match the SOP class.
+		}
+	else
+		{
+		nStandInAttempts[ nImage ]++;
+		if ( nImage == nStandInFailingImage )
+			{
+			if ( nFailingImageAttempts < MAX_FORWARDING_ATTEMPTS + 4 )
+				FailingImageAttemptTimes[ nFailingImageAttempts++ ] = GetTickCount64();
+			if ( nStandInFailuresRemaining != 0 )
+				{
+				pResponse -> Status = 0xA700;	// Out of resources.
+				if ( nStandInFailuresRemaining > 0 )
+					nStandInFailuresRemaining--;
+				}
+			}
+		}
+}
+
+
+// Read the element values the stand-in needs from a C-Store request command set.
+static void ParseStandInCommand( unsigned char *pCommandSet, unsigned long CommandSetLength, STAND_IN_RESPONSE *pResponse )
+{
+	unsigned long		nOffset;
+	unsigned short		Element;
+	unsigned long		ValueLength;
+	char				*pUIDDestination;
+
+	nOffset = 0L;
+	while ( nOffset + 8 <= CommandSetLength )
+		{
+		Element = pCommandSet[ nOffset + 2 ] | ( pCommandSet[ nOffset + 3 ] << 8 );
+		ValueLength = pCommandSet[ nOffset + 4 ] | ( pCommandSet[ nOffset + 5 ] << 8 ) |
+						( pCommandSet[ nOffset + 6 ] << 16 ) | ( (unsigned long)pCommandSet[ nOffset + 7 ] << 24 );
+		nOffset += 8;
+		if ( ValueLength > CommandSetLength - nOffset )
+			ValueLength = CommandSetLength - nOffset;
+		pUIDDestination = 0;
+		if ( Element == 0x0002 )
+			pUIDDestination = pResponse -> SOPClassUID;
+		else if ( Element == 0x1000 )
+			pUIDDestination = pResponse -> SOPInstanceUID;
+		else if ( Element == 0x0110 && ValueLength == 2 )
+			pResponse -> MessageID = pCommandSet[ nOffset ] | ( pCommandSet[ nOffset + 1 ] << 8 );
+		if ( pUIDDestination != 0 && ValueLength < 68 )
+			{
+			memcpy( pUIDDestination, pCommandSet + nOffset, ValueLength );
+			pUIDDestination[ ValueLength ] = '\0';
+			}
+		nOffset += ValueLength;
+		}
+}
+
+
+// Serve one association, from the association request to the release or the loss of the connection.
+static void ServeStandInAssociation( SOCKET StandInSocket )
+{
+	BOOL				bNoError = TRUE;
+	BOOL				bAssociationIsReleased;
+	unsigned char		PDUHeader[ 6 ];
+	unsigned char		*pPDU;
+	unsigned long		PDULength;
+	unsigned char		*pPDVItem;
+	unsigned long		PDVItemLength;
+	unsigned char		MessageControlHeader;
+	unsigned char		CommandSet[ 1024 ];
+	unsigned long		CommandSetLength;
+	unsigned char		*pDataSet;
+	unsigned long		DataSetLength;
+	STAND_IN_RESPONSE	Request;
+	STAND_IN_RESPONSE	PendingResponses[ MAX_STAND_IN_PENDING_RESPONSES ];
+	int					nPendingResponses;
+	int					nResponse;
+	fd_set				ReadSockets;
+	struct timeval		Timeout;
+	ULONGLONG			WaitTime;
+	ULONGLONG			CurrentTime;
+	int					nReadySockets;
+	unsigned char		ReleaseReply[ 10 ] = { 0x06, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00 };
+
+	InterlockedIncrement( &nStandInAssociations );
+	pDataSet = (unsigned char*)malloc( MAX_STAND_IN_DATA_SET_LENGTH );
+	bNoError = ( pDataSet != 0 );
+	pPDU = 0;
+	CommandSetLength = 0L;
+	DataSetLength = 0L;
+	memset( &Request, 0, sizeof(Request) );
+	nPendingResponses = 0;
+	bAssociationIsReleased = FALSE;
+	while ( bNoError && !bAssociationIsReleased && !bStandInStopRequested )
+		{
+		// Wait for the next PDU, or until a response is due.
+		CurrentTime = GetTickCount64();
+		WaitTime = 100;
+		for ( nResponse = 0; nResponse < nPendingResponses; nResponse++ )
+			if ( PendingResponses[ nResponse ].DueTime != 0 )
+				WaitTime = ( PendingResponses[ nResponse ].DueTime > CurrentTime ) ? PendingResponses[ nResponse ].DueTime - CurrentTime : 0;
+		if ( bStandInHoldsResponses && nPendingResponses > 0 )
+			WaitTime = STAND_IN_FLUSH_INTERVAL;
+		FD_ZERO( &ReadSockets );
+		FD_SET( StandInSocket, &ReadSockets );
+		Timeout.tv_sec = (long)( WaitTime / 1000 );
+		Timeout.tv_usec = (long)( ( WaitTime % 1000 ) * 1000 );
+		bNoError = WindowsSelect( &ReadSockets, 0, 0, &Timeout, &nReadySockets );
+		if ( bNoError && nReadySockets == 0 && bStandInHoldsResponses )
+			{
+			// The operation has nothing more to send for now.  Release the held responses.
+			for ( nResponse = 0; nResponse < nPendingResponses; nResponse++ )
+				PendingResponses[ nResponse ].DueTime = CurrentTime;
+			}
+		if ( bNoError && nReadySockets > 0 )
+			{
+			bNoError = ReceiveStandInBytes( StandInSocket, PDUHeader, 6 );
+			if ( bNoError )
+				{
+				PDULength = GetBigEndian32( PDUHeader + 2 );
+				pPDU = (unsigned char*)malloc( PDULength + 6 );
+				bNoError = ( pPDU != 0 && PDULength < MAX_STAND_IN_DATA_SET_LENGTH );
+				}
+			if ( bNoError )
+				{
+				memcpy( pPDU, PDUHeader, 6 );
+				bNoError = ReceiveStandInBytes( StandInSocket, pPDU + 6, PDULength );
+				}
+			if ( bNoError )
+				{
+				switch ( pPDU[ 0 ] )
+					{
+					case 0x01:			// A-ASSOCIATE-RQ
+						bNoError = ( PDULength + 6 >= 74 && AcceptStandInAssociation( StandInSocket, pPDU, PDULength + 6 ) );
+						break;
+					case 0x04:			// P-DATA-TF
+						if ( PDULength > MaxPDULengthReceived )
+							MaxPDULengthReceived = PDULength;
+						if ( PDULength > STAND_IN_MAX_PDU_LENGTH )
+							bFragmentLengthsAreCorrect = FALSE;
+						pPDVItem = pPDU + 6;
+						while ( bNoError && pPDVItem + 6 <= pPDU + 6 + PDULength )
+							{
+							PDVItemLength = GetBigEndian32( pPDVItem );
+							bNoError = ( PDVItemLength >= 2 && pPDVItem + 4 + PDVItemLength <= pPDU + 6 + PDULength );
+							if ( bNoError )
+								{
+								MessageControlHeader = pPDVItem[ 5 ];
+								if ( ( MessageControlHeader & 0x01 ) != 0 )
+									{
+									bNoError = ( CommandSetLength + PDVItemLength - 2 <= sizeof(CommandSet) );
+									if ( bNoError )
+										{
+										memcpy( CommandSet + CommandSetLength, pPDVItem + 6, PDVItemLength - 2 );
+										CommandSetLength += PDVItemLength - 2;
+										}
+									if ( bNoError && ( MessageControlHeader & 0x02 ) != 0 )
+										{
+										memset( &Request, 0, sizeof(Request) );
+										Request.PresentationContextID = pPDVItem[ 4 ];
+										ParseStandInCommand( CommandSet, CommandSetLength, &Request );
+										CommandSetLength = 0L;
+										DataSetLength = 0L;
+										}
+									}
+								else
+									{
+									// Every data set fragment but the last must fill a PDU of the negotiated maximum length.
+									if ( ( MessageControlHeader & 0x02 ) == 0 && PDULength != STAND_IN_MAX_PDU_LENGTH )
+										bFragmentLengthsAreCorrect = FALSE;
+									bNoError = ( DataSetLength + PDVItemLength - 2 <= MAX_STAND_IN_DATA_SET_LENGTH );
+									if ( bNoError )
+										{
+										memcpy( pDataSet + DataSetLength, pPDVItem + 6, PDVItemLength - 2 );
+										DataSetLength += PDVItemLength - 2;
+										}
+									if ( bNoError && ( MessageControlHeader & 0x02 ) != 0 )
+										{
+										RecordStandInRequest( &Request, pDataSet, DataSetLength );
+										Request.DueTime = bStandInHoldsResponses ? 0 : GetTickCount64() + StandInStorageDelay;
+										bNoError = ( nPendingResponses < MAX_STAND_IN_PENDING_RESPONSES );
+										if ( bNoError )
+											PendingResponses[ nPendingResponses++ ] = Request;
+										if ( nPendingResponses > MaxOutstandingRequests )
+											MaxOutstandingRequests = nPendingResponses;
+										if ( bStandInHoldsResponses && nPendingResponses >= STAND_IN_WINDOW )
+											for ( nResponse = 0; nResponse < nPendingResponses; nResponse++ )
+												PendingResponses[ nResponse ].DueTime = GetTickCount64();
+										DataSetLength = 0L;
+										}
+									}
+								pPDVItem += 4 + PDVItemLength;
+								}
+							}
+						break;
+					case 0x05:			// A-RELEASE-RQ
+						for ( nResponse = 0; nResponse < nPendingResponses; nResponse++ )
+							PendingResponses[ nResponse ].DueTime = GetTickCount64();
+						bNoError = SendDueStandInResponses( StandInSocket, PendingResponses, &nPendingResponses );
+						if ( bNoError )
+							bNoError = SendStandInBytes( StandInSocket, ReleaseReply, sizeof(ReleaseReply) );
+						bAssociationIsReleased = TRUE;
+						break;
+					default:
+						bNoError = FALSE;
+						break;
+					}
+				}
+			if ( pPDU != 0 )
+				free( pPDU );
+			pPDU = 0;
+			}
+		if ( bNoError && !bAssociationIsReleased )
+			bNoError = SendDueStandInResponses( StandInSocket, PendingResponses, &nPendingResponses );
+		}
+	if ( pDataSet != 0 )
+		free( pDataSet );
+	CloseConnection( StandInSocket );
+}
+
+
+static unsigned __stdcall StandInDestinationThreadFunction( void *pParameter )
+{
+	BOOL				bNoError = TRUE;
+	fd_set				ReadSockets;
+	struct timeval		Timeout;
+	int					nReadySockets;
+	SOCKET				StandInSocket;
+#pragma pack(push, 8)
+	struct sockaddr_in	ClientAddr;
+#pragma pack(pop)
+
+	while ( bNoError && !bStandInStopRequested )
+		{
+		FD_ZERO( &ReadSockets );
+		FD_SET( StandInListeningSocket, &ReadSockets );
+		Timeout.tv_sec = 0;
+		Timeout.tv_usec = 100000;
+		bNoError = WindowsSelect( &ReadSockets, 0, 0, &Timeout, &nReadySockets );
+		if ( bNoError && nReadySockets > 0 )
+			{
+			bNoError = WindowsSocketAccept( StandInListeningSocket, &StandInSocket, (struct sockaddr*)&ClientAddr );
+			if ( bNoError )
+				ServeStandInAssociation( StandInSocket );
+			}
+		}
+
+	return 0;
+}
+
+
+// Listen on a port of the loopback address chosen by the system.
+static BOOL StartStandInDestination()
+{
+	BOOL				bNoError = TRUE;
+#pragma pack(push, 8)
+	struct sockaddr_in	InternetAddr;
+#pragma pack(pop)
+	unsigned			ThreadID;
+
+	bStandInStopRequested = FALSE;
+	StandInListeningSocket = CreateWindowsSocket();
+	bNoError = ( StandInListeningSocket != INVALID_SOCKET );
+	if ( bNoError )
+		{
+		memset( &InternetAddr, 0, sizeof(InternetAddr) );
+		InternetAddr.sin_family = AF_INET;
+		InternetAddr.sin_addr.s_addr = inet_addr( "127.0.0.1" );
+		InternetAddr.sin_port = 0;
+		bNoError = WindowsSocketBind( StandInListeningSocket, (struct sockaddr*)&InternetAddr );
+		}
+	if ( bNoError )
+		bNoError = WindowsGetSocketName( StandInListeningSocket, (struct sockaddr*)&InternetAddr );
+	if ( bNoError )
+		{
+		StandInPortNumber = ntohs( InternetAddr.sin_port );
+		bNoError = WindowsSocketListen( StandInListeningSocket, 4 );
+		}
+	if ( bNoError )
+		{
+		hStandInThread = (HANDLE)_beginthreadex( NULL, 0, StandInDestinationThreadFunction, 0, 0, &ThreadID );
+		bNoError = ( hStandInThread != 0 );
+		}
+
+	return bNoError;
+}
+
+
+static void StopStandInDestination()
+{
+	bStandInStopRequested = TRUE;
+	if ( hStandInThread != 0 )
+		{
+		WaitForSingleObject( hStandInThread, 5000 );
+		CloseHandle( hStandInThread );
+		}
+	hStandInThread = 0;
+	if ( StandInListeningSocket != INVALID_SOCKET )
+		WindowsCloseSocket( StandInListeningSocket );
+	StandInListeningSocket = INVALID_SOCKET;
+}
+
+
+static void ResetStandInObservations()
+{
+	nStandInImagesStored = 0;
+	memset( nStandInAttempts, 0, sizeof(nStandInAttempts) );
+	nFailingImageAttempts = 0;
+	MaxPDULengthReceived = 0L;
+	MaxOutstandingRequests = 0;
+	bFragmentLengthsAreCorrect = TRUE;
+	bDataSetsAreIntact = TRUE;
+	bResponsesWereReordered = FALSE;
+}
+
+
+static void GetTestImageFileSpec( int nImage, char *pFileSpec )
+{
+	_snprintf_s( pFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\Image%03d.dcm", TEST_FORWARDING_DIRECTORY, nImage );
+}
+
+
+static void GetQueuedImageFileSpec( int nImage, char *pFileSpec )
+{
+	_snprintf_s( pFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\Image%03d.dcm", FORWARDING_QUEUE_DIRECTORY, nImage );
+}
+
+
+static BOOL TestFileExists( char *pFileSpec )
+{
+	struct __stat64			FileStatisticsBuffer;
+
+	return ( _stat64( pFileSpec, &FileStatisticsBuffer ) == 0 );
+}
+
+
+// Write the test images, each with its own SOP instance UID.
+static BOOL WriteTestImages()
+{
+	BOOL				bNoError = TRUE;
+	char				*pSourceImageData;
+	char				*pImageData;
+	char				*pUID;
+	char				UIDSuffix[ 4 ];
+	char				FileSpec[ MAX_FILE_SPEC_LENGTH ];
+	size_t				UIDLength;
+	FILE				*pImageFile;
+	int					nImage;
+
+	pSourceImageData = 0;
+	UIDLength = strlen( SOURCE_SOP_INSTANCE_UID );
+	bNoError = ReadTestDataFile( SOURCE_IMAGE_FILE, &pSourceImageData, &TestImageSize );
+	for ( nImage = 0; bNoError && nImage < MAX_TEST_IMAGES; nImage++ )
+		{
+		pImageData = (char*)malloc( TestImageSize );
+		bNoError = ( pImageData != 0 );
+		if ( bNoError )
+			{
+			pTestImageData[ nImage ] = pImageData;
+			memcpy( pImageData, pSourceImageData, TestImageSize );
+			_snprintf_s( UIDSuffix, sizeof(UIDSuffix), _TRUNCATE, "%03d", nImage );
+			for ( pUID = pImageData; pUID + UIDLength <= pImageData + TestImageSize; pUID++ )
+				if ( memcmp( pUID, SOURCE_SOP_INSTANCE_UID, UIDLength ) == 0 )
+					memcpy( pUID + UIDLength - 3, UIDSuffix, 3 );
+			GetTestImageFileSpec( nImage, FileSpec );
+			bNoError = ( fopen_s( &pImageFile, FileSpec, "wb" ) == 0 && pImageFile != 0 );
+			}
+		if ( bNoError )
+			{
+			bNoError = ( fwrite( pImageData, 1, TestImageSize, pImageFile ) == TestImageSize );
+			fclose( pImageFile );
+			}
+		}
+	if ( pSourceImageData != 0 )
+		free( pSourceImageData );
+
+	return bNoError;
+}
+
+
+static void RemoveTestImages()
+{
+	char				FileSpec[ MAX_FILE_SPEC_LENGTH ];
+	int					nImage;
+
+	for ( nImage = 0; nImage < MAX_TEST_IMAGES; nImage++ )
+		{
+		GetTestImageFileSpec( nImage, FileSpec );
+		DeleteFile( FileSpec );
+		GetQueuedImageFileSpec( nImage, FileSpec );
+		DeleteFile( FileSpec );
+		strncat_s( FileSpec, MAX_FILE_SPEC_LENGTH, ".unsent", _TRUNCATE );
+		DeleteFile( FileSpec );
+		if ( pTestImageData[ nImage ] != 0 )
+			free( pTestImageData[ nImage ] );
+		pTestImageData[ nImage ] = 0;
+		}
+	RemoveDirectory( FORWARDING_QUEUE_DIRECTORY );
+	RemoveDirectory( TEST_FORWARDING_DIRECTORY );
+}
+
+
+// Hand an image to the Send Image operation, as the Process Image operation does.
+static BOOL QueueTestImage( int nImage )
+{
+	char				FileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				PNGFileName[ MAX_FILE_SPEC_LENGTH ];
+
+	GetTestImageFileSpec( nImage, FileSpec );
+	_snprintf_s( PNGFileName, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "Image%03d.png", nImage );
+
+	return QueueImageForForwarding( FileSpec, PNGFileName );
+}
+
+
+// An image has been stored when its copy in the forwarding queue directory is deleted.
+static BOOL WaitForImagesToBeForwarded( int nFirstImage, int nImages, DWORD Timeout )
+{
+	BOOL				bImagesRemain = TRUE;
+	char				FileSpec[ MAX_FILE_SPEC_LENGTH ];
+	ULONGLONG			StartTime;
+	int					nImage;
+
+	StartTime = GetTickCount64();
+	do
+		{
+		bImagesRemain = FALSE;
+		for ( nImage = nFirstImage; nImage < nFirstImage + nImages && !bImagesRemain; nImage++ )
+			{
+			GetQueuedImageFileSpec( nImage, FileSpec );
+			bImagesRemain = TestFileExists( FileSpec );
+			}
+		if ( bImagesRemain )
+			Sleep( 1 );
+		}
+	while ( bImagesRemain && GetTickCount64() - StartTime < Timeout );
+
+	return !bImagesRemain;
+}
+
+
+static BOOL LaunchSendImageOperation()
+{
+	memset( &StandInEndPoint, 0, sizeof(ENDPOINT) );
+	strncpy_s( StandInEndPoint.Name, MAX_CFG_STRING_LENGTH, "Stand-in Destination", _TRUNCATE );
+	StandInEndPoint.EndPointType = ENDPOINT_TYPE_NETWORK;
+	_snprintf_s( StandInEndPoint.NetworkAddress, MAX_CFG_STRING_LENGTH, _TRUNCATE, "127.0.0.1:%d", StandInPortNumber );
+	strncpy_s( StandInEndPoint.AE_TITLE, MAX_CFG_STRING_LENGTH, "STANDIN", _TRUNCATE );
+	strncpy_s( StandInEndPoint.Directory, MAX_CFG_STRING_LENGTH, FORWARDING_QUEUE_DIRECTORY, _TRUNCATE );
+	strncpy_s( EndPointNetworkIn.AE_TITLE, MAX_CFG_STRING_LENGTH, "BRETRIEVERTEST", _TRUNCATE );
+
+	memset( &OperationSendImage, 0, sizeof(PRODUCT_OPERATION) );
+	strncpy_s( OperationSendImage.OperationName, MAX_CFG_STRING_LENGTH, "Send Image", _TRUNCATE );
+	OperationSendImage.OperationType = OPERATION_TYPE_SEND_OVER_NETWORK;
+	OperationSendImage.OperationTimeInterval = 1;
+	OperationSendImage.pOutputEndPoint = &StandInEndPoint;
+	OperationSendImage.bEnabled = TRUE;
+	OperationSendImage.OpnState.StatusCode = OPERATION_STATUS_UNKNOWN;
+	OperationSendImage.OpnState.SocketDescriptor = INVALID_SOCKET;
+	OperationSendImage.OpnState.ThreadFunction = SendImagesThreadFunction;
+	pPrimaryOperationList = &OperationSendImage;
+
+	return LaunchOperation( &OperationSendImage );
+}
+
+
+// A full window of C-Store requests is sent before any response arrives, and the responses are
+// matched to the requests by message ID when they arrive in reverse order.  The first attempt to
+// store one of the images fails, and only that image is sent again.
+static void TestPipelinedForwarding()
+{
+	BOOL			bNoError = TRUE;
+	BOOL			bAttemptsAreCorrect;
+	LONG			nAssociationsBefore;
+	int				nImage;
+
+	ResetStandInObservations();
+	bStandInHoldsResponses = TRUE;
+	StandInStorageDelay = 0;
+	nStandInFailingImage = 5;
+	nStandInFailuresRemaining = 1;
+	nAssociationsBefore = nStandInAssociations;
+	for ( nImage = 0; bNoError && nImage < PIPELINED_IMAGE_COUNT; nImage++ )
+		bNoError = QueueTestImage( nImage );
+	if ( bNoError )
+		bNoError = WaitForImagesToBeForwarded( 0, PIPELINED_IMAGE_COUNT, FORWARDING_TIMEOUT );
+	bAttemptsAreCorrect = TRUE;
+	for ( nImage = 0; nImage < PIPELINED_IMAGE_COUNT; nImage++ )
+		if ( nStandInAttempts[ nImage ] != ( nImage == nStandInFailingImage ? 2 : 1 ) )
+			bAttemptsAreCorrect = FALSE;
+	printf( "    %d images were sent with up to %d C-Store requests outstanding, in PDUs of up to %lu bytes.\n",
+				PIPELINED_IMAGE_COUNT, MaxOutstandingRequests, MaxPDULengthReceived );
+	CheckTestResult( bNoError && nStandInImagesStored == PIPELINED_IMAGE_COUNT && bDataSetsAreIntact,
+						"Every queued image is stored by the destination, with its data set intact." );
+	CheckTestResult( MaxOutstandingRequests == STAND_IN_WINDOW, "C-Store requests are pipelined up to the negotiated window." );
+	CheckTestResult( bResponsesWereReordered && bAttemptsAreCorrect,
+						"Responses arriving out of order are matched to their requests by message ID." );
+	CheckTestResult( MaxPDULengthReceived == STAND_IN_MAX_PDU_LENGTH && bFragmentLengthsAreCorrect,
+						"Data sets are divided among PDUs of the negotiated maximum length." );
+	CheckTestResult( nStandInAssociations - nAssociationsBefore == 1, "The images are sent over a single association." );
+}
+
+
+// An image the destination fails to store is sent again after a delay that doubles with each
+// failure, and is renamed after MAX_FORWARDING_ATTEMPTS attempts.
+static void TestForwardingRetries()
+{
+	BOOL			bNoError = TRUE;
+	BOOL			bDelaysAreCorrect;
+	char			FileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char			UnsentFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	ULONGLONG		StartTime;
+	ULONGLONG		RetryDelay;
+	int				nAttempt;
+
+	ResetStandInObservations();
+	bStandInHoldsResponses = FALSE;
+	StandInStorageDelay = 0;
+	nStandInFailingImage = PIPELINED_IMAGE_COUNT;
+	nStandInFailuresRemaining = -1;
+	GetQueuedImageFileSpec( nStandInFailingImage, FileSpec );
+	strncpy_s( UnsentFileSpec, MAX_FILE_SPEC_LENGTH, FileSpec, _TRUNCATE );
+	strncat_s( UnsentFileSpec, MAX_FILE_SPEC_LENGTH, ".unsent", _TRUNCATE );
+	bNoError = QueueTestImage( nStandInFailingImage );
+	// Wake the operation often, so that each retry is made as soon as its delay has passed.
+	StartTime = GetTickCount64();
+	while ( bNoError && !TestFileExists( UnsentFileSpec ) && GetTickCount64() - StartTime < FORWARDING_TIMEOUT )
+		{
+		WakeOperationsOfType( OPERATION_TYPE_SEND_OVER_NETWORK );
+		Sleep( 10 );
+		}
+	Sleep( 200 );
+	bDelaysAreCorrect = ( nFailingImageAttempts == MAX_FORWARDING_ATTEMPTS );
+	RetryDelay = RETRY_BASE_INTERVAL;
+	printf( "    Retries followed failures by" );
+	for ( nAttempt = 1; nAttempt < nFailingImageAttempts; nAttempt++ )
+		{
+		printf( " %lu", (unsigned long)( FailingImageAttemptTimes[ nAttempt ] - FailingImageAttemptTimes[ nAttempt - 1 ] ) );
+		if ( FailingImageAttemptTimes[ nAttempt ] - FailingImageAttemptTimes[ nAttempt - 1 ] < RetryDelay )
+			bDelaysAreCorrect = FALSE;
+		RetryDelay *= 2;
+		if ( RetryDelay > RETRY_MAX_INTERVAL )
+			RetryDelay = RETRY_MAX_INTERVAL;
+		}
+	printf( " ms, with a %d ms initial retry delay.\n", RETRY_BASE_INTERVAL );
+	CheckTestResult( bNoError && bDelaysAreCorrect, "A failed image is retried after a delay that doubles with each failure." );
+	CheckTestResult( TestFileExists( UnsentFileSpec ) && !TestFileExists( FileSpec ),
+						"An image is renamed .unsent after the last attempt fails." );
+	nStandInFailingImage = -1;
+}
+
+
+// The time to forward images over one association with pipelined requests, compared with the
+// time to forward them with an association for each image.  The stand-in takes a little time to
+// store each image, as a real destination would.
+static void TestForwardingThroughput()
+{
+	BOOL			bNoError = TRUE;
+	LONG			nAssociationsBefore;
+	LONG			nPipelinedAssociations;
+	LONG			nBaselineAssociations;
+	ULONGLONG		StartTime;
+	ULONGLONG		PipelinedTime;
+	ULONGLONG		BaselineTime;
+	double			PipelinedImagesPerSecond;
+	double			BaselineImagesPerSecond;
+	int				nFirstImage;
+	int				nImage;
+
+	ResetStandInObservations();
+	bStandInHoldsResponses = FALSE;
+	StandInStorageDelay = STAND_IN_STORAGE_DELAY;
+	nFirstImage = PIPELINED_IMAGE_COUNT + 1;
+	nAssociationsBefore = nStandInAssociations;
+	StartTime = GetTickCount64();
+	for ( nImage = nFirstImage; bNoError && nImage < nFirstImage + THROUGHPUT_IMAGE_COUNT; nImage++ )
+		bNoError = QueueTestImage( nImage );
+	if ( bNoError )
+		bNoError = WaitForImagesToBeForwarded( nFirstImage, THROUGHPUT_IMAGE_COUNT, FORWARDING_TIMEOUT );
+	PipelinedTime = GetTickCount64() - StartTime;
+	nPipelinedAssociations = nStandInAssociations - nAssociationsBefore;
+
+	// Release each association as soon as its image has been stored, and queue the next image
+	// only then.
+	SetForwardingIntervals( RETRY_BASE_INTERVAL, RETRY_MAX_INTERVAL, 0 );
+	WakeOperationsOfType( OPERATION_TYPE_SEND_OVER_NETWORK );
+	Sleep( 100 );
+	nFirstImage += THROUGHPUT_IMAGE_COUNT;
+	nAssociationsBefore = nStandInAssociations;
+	StartTime = GetTickCount64();
+	for ( nImage = nFirstImage; bNoError && nImage < nFirstImage + THROUGHPUT_IMAGE_COUNT; nImage++ )
+		{
+		bNoError = QueueTestImage( nImage );
+		if ( bNoError )
+			bNoError = WaitForImagesToBeForwarded( nImage, 1, FORWARDING_TIMEOUT );
+		}
+	BaselineTime = GetTickCount64() - StartTime;
+	nBaselineAssociations = nStandInAssociations - nAssociationsBefore;
+	SetForwardingIntervals( RETRY_BASE_INTERVAL, RETRY_MAX_INTERVAL, FORWARDING_ASSOCIATION_IDLE_TIMEOUT );
+
+	PipelinedImagesPerSecond = 1000.0 * THROUGHPUT_IMAGE_COUNT / (double)( PipelinedTime > 0 ? PipelinedTime : 1 );
+	BaselineImagesPerSecond = 1000.0 * THROUGHPUT_IMAGE_COUNT / (double)( BaselineTime > 0 ? BaselineTime : 1 );
+	printf( "    %d images of %lu bytes, with a %d ms storage delay:  %.0f images/sec pipelined over one association,\n",
+				THROUGHPUT_IMAGE_COUNT, TestImageSize, STAND_IN_STORAGE_DELAY, PipelinedImagesPerSecond );
+	printf( "    and %.0f images/sec with an association for each image.\n", BaselineImagesPerSecond );
+	CheckTestResult( bNoError && nStandInImagesStored == 2 * THROUGHPUT_IMAGE_COUNT && bDataSetsAreIntact &&
+						nPipelinedAssociations <= 1 && nBaselineAssociations == THROUGHPUT_IMAGE_COUNT,
+						"Images are forwarded over one association, or one association for each image." );
+	CheckTestResult( PipelinedImagesPerSecond > BaselineImagesPerSecond,
+						"Pipelining over one association forwards images faster than an association for each image." );
+}
+
+
+void TestDicomForwarding()
+{
+	BOOL				bNoError = TRUE;
+
+	memset( pTestImageData, 0, sizeof(pTestImageData) );
+	InitProductOperationsModule();
+	InitDicomInitiatorModule();
+	SetForwardingIntervals( RETRY_BASE_INTERVAL, RETRY_MAX_INTERVAL, FORWARDING_ASSOCIATION_IDLE_TIMEOUT );
+	bNoError = InitWindowsSockets();
+	if ( bNoError )
+		bNoError = ( LocateOrCreateDirectory( TEST_FORWARDING_DIRECTORY ) && LocateOrCreateDirectory( FORWARDING_QUEUE_DIRECTORY ) );
+	if ( bNoError )
+		bNoError = WriteTestImages();
+	if ( bNoError )
+		bNoError = StartStandInDestination();
+	if ( bNoError )
+		bNoError = LaunchSendImageOperation();
+	CheckTestResult( bNoError, "The Send Image operation is launched with a stand-in destination." );
+	if ( bNoError )
+		{
+		TestPipelinedForwarding();
+		TestForwardingRetries();
+		TestForwardingThroughput();
+		TerminateAllOperations();
+		}
+	pPrimaryOperationList = 0;
+	StopStandInDestination();
+	RemoveTestImages();
+	SetForwardingIntervals( FORWARDING_RETRY_BASE_INTERVAL, FORWARDING_RETRY_MAX_INTERVAL, FORWARDING_ASSOCIATION_IDLE_TIMEOUT );
+	CloseDicomInitiatorModule();
+	TerminateWindowsSockets();
+	CloseProductOperationsModule();
+}
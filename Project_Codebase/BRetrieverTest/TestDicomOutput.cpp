@@ -0,0 +1,907 @@
+// TestDicomOutput.cpp : Implements the tests of the composition of Dicom output files by
+//	ComposeDicomFileOutput() in Dicom.cpp, using the test files in TestData\DicomOutput.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include <sys/types.h>
+#include <sys/utime.h>
+#include "ReportStatus.h"
+#include "ServiceMain.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Exam.h"
+#include "ExamEdit.h"
+#include "ExamReformat.h"
+#include "BRetrieverTest.h"
+#include "FuzzDicomParser.h"
+
+
+extern CONFIGURATION			ServiceConfiguration;
+extern TRANSFER_SERVICE			TransferService;
+
+
+// The compositions are listed in TestData\DicomOutput\DicomOutputVectors.txt, which is written by
+// MakeDicomOutputVectors.py along with the input files and the edit specification sets.  Each line
+// names an input file, the edit specification set applied to it ("-" for none), and the file the
+// composition is expected to match byte for byte.  Each edit specification set is written to
+// DicomEdits.cfg in a configuration directory of its own, as BRetriever reads it.
+
+// Write the edit specification set to its configuration directory, with "<TestData>" replaced by
+// the test data directory, unless it has already been written.
+static BOOL PrepareEditSpecificationSet( char *pEditSetName, char *pConfigDirectory )
+{
+	BOOL			bNoError = TRUE;
+	char			RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char			EditFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char			TestDataDirectory[ MAX_FILE_SPEC_LENGTH ];
+	char			*pEditData;
+	unsigned long	nEditDataBytes;
+	char			*pToken;
+	char			*pText;
+	FILE			*pEditFile;
+
+	_snprintf_s( pConfigDirectory, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\%s", TEST_DICOM_OUTPUT_DIRECTORY, pEditSetName );
+	_snprintf_s( EditFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\DicomEdits.cfg", pConfigDirectory );
+	pEditFile = fopen( EditFileSpec, "rt" );
+	if ( pEditFile != 0 )
+		fclose( pEditFile );
+	else
+		{
+		_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "DicomOutput\\%s.cfg", pEditSetName );
+		bNoError = ReadTestDataFile( RelativeFileSpec, &pEditData, &nEditDataBytes );
+		if ( bNoError )
+			{
+			bNoError = LocateOrCreateDirectory( pConfigDirectory );
+			if ( bNoError )
+				{
+				pEditFile = fopen( EditFileSpec, "wb" );
+				bNoError = ( pEditFile != 0 );
+				}
+			if ( bNoError )
+				{
+				GetTestDataFileSpec( "", TestDataDirectory, MAX_FILE_SPEC_LENGTH );
+				pText = pEditData;
+				while ( ( pToken = strstr( pText, "<TestData>" ) ) != 0 )
+					{
+					fwrite( pText, 1, pToken - pText, pEditFile );
+					fputs( TestDataDirectory, pEditFile );
+					pText = pToken + strlen( "<TestData>" );
+					}
+				fputs( pText, pEditFile );
+				bNoError = ( fclose( pEditFile ) == 0 );
+				}
+			free( pEditData );
+			}
+		}
+
+	return bNoError;
+}
+
+
+// Compose the Dicom output file for an input file as the product dispatcher does, after the input
+// file has been read.  The output file is named after the expected file, in the test output directory.
+static BOOL ComposeTestOutputFile( char *pInputFileName, char *pEditSetName, char *pExpectedFileName, char *pOutputFileSpec )
+{
+	BOOL					bNoError = TRUE;
+	char					InputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					ConfigDirectory[ MAX_FILE_SPEC_LENGTH ];
+	char					PNGImageFileName[ MAX_FILE_SPEC_LENGTH ];
+	char					*pExtension;
+	EXAM_INFO				ExamInfo;
+	DICOM_HEADER_SUMMARY	*pDicomHeader;
+
+	ServiceConfiguration.bComposeDicomOutputFile = TRUE;
+	ServiceConfiguration.bApplyManualDicomEdits = ( strcmp( pEditSetName, "-" ) != 0 );
+	strncpy_s( ServiceConfiguration.DicomImageArchiveDirectory, MAX_CFG_STRING_LENGTH, TEST_DICOM_OUTPUT_DIRECTORY, _TRUNCATE );
+	if ( ServiceConfiguration.bApplyManualDicomEdits )
+		{
+		bNoError = PrepareEditSpecificationSet( pEditSetName, ConfigDirectory );
+		strncpy_s( TransferService.ConfigDirectory, MAX_CFG_STRING_LENGTH, ConfigDirectory, _TRUNCATE );
+		}
+	// The output file name is the name of the PNG image file, with the .png replaced by .dcm.
+	strncpy_s( PNGImageFileName, MAX_FILE_SPEC_LENGTH, pExpectedFileName, _TRUNCATE );
+	pExtension = strstr( PNGImageFileName, ".dcm" );
+	if ( pExtension != 0 )
+		strncpy_s( pExtension, 5, ".png", _TRUNCATE );
+	_snprintf_s( pOutputFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\%s", TEST_DICOM_OUTPUT_DIRECTORY, pExpectedFileName );
+	remove( pOutputFileSpec );
+	if ( bNoError )
+		{
+		_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "DicomOutput\\%s", pInputFileName );
+		GetTestDataFileSpec( RelativeFileSpec, InputFileSpec, MAX_FILE_SPEC_LENGTH );
+		memset( &ExamInfo, 0, sizeof(EXAM_INFO) );
+		pDicomHeader = 0;
+		bNoError = ReadDicomHeaderInfo( InputFileSpec, &ExamInfo, &pDicomHeader, FALSE );
+		if ( bNoError )
+			{
+			ExamInfo.pDicomInfo = pDicomHeader;
+			bNoError = ComposeDicomFileOutput( InputFileSpec, PNGImageFileName, &ExamInfo );
+			}
+		FreeParsedDicomData( &ExamInfo, pDicomHeader );
+		}
+
+	return bNoError;
+}
+
+
+static BOOL OutputFileMatchesExpectedFile( char *pOutputFileSpec, char *pExpectedFileName )
+{
+	BOOL			bNoError = TRUE;
+	char			RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char			*pOutputData;
+	unsigned long	nOutputBytes;
+	char			*pExpectedData;
+	unsigned long	nExpectedBytes;
+	unsigned long	nByte;
+
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "DicomOutput\\%s", pExpectedFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pExpectedData, &nExpectedBytes );
+	if ( bNoError )
+		{
+		bNoError = ReadFileContents( pOutputFileSpec, &pOutputData, &nOutputBytes );
+		if ( bNoError )
+			{
+			bNoError = ( nOutputBytes == nExpectedBytes && memcmp( pOutputData, pExpectedData, nOutputBytes ) == 0 );
+			if ( !bNoError )
+				{
+				for ( nByte = 0; nByte < nOutputBytes && nByte < nExpectedBytes && pOutputData[ nByte ] == pExpectedData[ nByte ]; nByte++ )
+					;
+				printf( "    The output is %lu bytes long, the expected file %lu.  They first differ at byte %lu.\n",
+							nOutputBytes, nExpectedBytes, nByte );
+				}
+			free( pOutputData );
+			}
+		free( pExpectedData );
+		}
+
+	return bNoError;
+}
+
+
+static void TestDicomOutputVectors()
+{
+	BOOL				bNoError = TRUE;
+	BOOL				bComposedOK;
+	FILE				*pManifestFile;
+	char				ManifestFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				TextLine[ 256 ];
+	char				InputFileName[ 64 ];
+	char				EditSetName[ 64 ];
+	char				ExpectedFileName[ 64 ];
+	char				OutputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				TestDescription[ MAX_FILE_SPEC_LENGTH ];
+	long				nVectors;
+
+	nVectors = 0;
+	GetTestDataFileSpec( "DicomOutput\\DicomOutputVectors.txt", ManifestFileSpec, MAX_FILE_SPEC_LENGTH );
+	pManifestFile = fopen( ManifestFileSpec, "rt" );
+	bNoError = ( pManifestFile != 0 );
+	while ( bNoError && fgets( TextLine, 256, pManifestFile ) != 0 )
+		{
+		if ( TextLine[ 0 ] != '#' && sscanf( TextLine, "%63s %63s %63s", InputFileName, EditSetName, ExpectedFileName ) == 3 )
+			{
+			bComposedOK = ComposeTestOutputFile( InputFileName, EditSetName, ExpectedFileName, OutputFileSpec );
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s, with %s edits, is composed as %s byte for byte.",
+							InputFileName, ( strcmp( EditSetName, "-" ) == 0 ) ? "no" : EditSetName, ExpectedFileName );
+			CheckTestResult( bComposedOK && OutputFileMatchesExpectedFile( OutputFileSpec, ExpectedFileName ), TestDescription );
+			remove( OutputFileSpec );
+			nVectors++;
+			}
+		}
+	if ( pManifestFile != 0 )
+		fclose( pManifestFile );
+	CheckTestResult( bNoError && nVectors > 0, "The Dicom output test compositions are listed." );
+}
+
+
+// The edit the composition applied to an element before the edits were indexed by tag:  the first
+// edit in the file for the element's tag, other than an addition or a deletion.
+static EDIT_SPECIFICATION *ScanForElementEditSpecification( LIST_ELEMENT *pEditSpecificationListElement, TAG DicomElementTag )
+{
+	EDIT_SPECIFICATION		*pEditSpecification;
+	EDIT_SPECIFICATION		*pMatchingEditSpecification;
+
+	pMatchingEditSpecification = 0;
+	while ( pEditSpecificationListElement != 0 && pMatchingEditSpecification == 0 )
+		{
+		pEditSpecification = (EDIT_SPECIFICATION*)pEditSpecificationListElement -> pItem;
+		if ( pEditSpecification -> DicomFieldIdentifier.Group == DicomElementTag.Group &&
+					pEditSpecification -> DicomFieldIdentifier.Element == DicomElementTag.Element &&
+					pEditSpecification -> EditOperation != EDIT_ADD_ELEMENT && pEditSpecification -> EditOperation != EDIT_DELETE_ELEMENT )
+			pMatchingEditSpecification = pEditSpecification;
+		pEditSpecificationListElement = pEditSpecificationListElement -> pNextListElement;
+		}
+
+	return pMatchingEditSpecification;
+}
+
+
+// Compile an edit specification set, as ComposeDicomFileOutput() does for each image.
+static BOOL CompileEditSpecificationSet( char *pEditSetName, LIST_HEAD *pEditSpecificationList )
+{
+	BOOL			bNoError = TRUE;
+	char			ConfigDirectory[ MAX_FILE_SPEC_LENGTH ];
+
+	*pEditSpecificationList = 0;
+	bNoError = PrepareEditSpecificationSet( pEditSetName, ConfigDirectory );
+	if ( bNoError )
+		{
+		strncpy_s( TransferService.ConfigDirectory, MAX_CFG_STRING_LENGTH, ConfigDirectory, _TRUNCATE );
+		bNoError = GetCompiledExamEditSpecifications( pEditSpecificationList );
+		}
+
+	return bNoError && *pEditSpecificationList != 0;
+}
+
+
+// Read the tags of the Dicom elements in a file, in the order of its element list.
+static BOOL ReadDicomElementTags( char *pFileSpec, TAG *pTags, long nMaxTags, long *pnTags )
+{
+	BOOL					bNoError = TRUE;
+	EXAM_INFO				ExamInfo;
+	DICOM_HEADER_SUMMARY	*pDicomHeader;
+	LIST_ELEMENT			*pDicomElementListElement;
+	DICOM_ELEMENT			*pDicomElement;
+
+	*pnTags = 0;
+	memset( &ExamInfo, 0, sizeof(EXAM_INFO) );
+	pDicomHeader = 0;
+	bNoError = ReadDicomHeaderInfo( pFileSpec, &ExamInfo, &pDicomHeader, FALSE );
+	if ( bNoError )
+		{
+		pDicomElementListElement = pDicomHeader -> ListOfDicomElements;
+		while ( pDicomElementListElement != 0 && *pnTags < nMaxTags )
+			{
+			pDicomElement = (DICOM_ELEMENT*)pDicomElementListElement -> pItem;
+			if ( pDicomElement != 0 )
+				pTags[ (*pnTags)++ ] = pDicomElement -> Tag;
+			pDicomElementListElement = pDicomElementListElement -> pNextListElement;
+			}
+		}
+	FreeParsedDicomData( &ExamInfo, pDicomHeader );
+
+	return bNoError;
+}
+
+
+static BOOL TagIsListed( TAG *pTags, long nTags, unsigned short Group, unsigned short Element )
+{
+	BOOL			bTagIsListed;
+	long			nTag;
+
+	bTagIsListed = FALSE;
+	for ( nTag = 0; nTag < nTags && !bTagIsListed; nTag++ )
+		bTagIsListed = ( pTags[ nTag ].Group == Group && pTags[ nTag ].Element == Element );
+
+	return bTagIsListed;
+}
+
+
+// Check that the tag index finds the same edit as a scan of the edit list, for the tags named in the
+// edit set, their neighbours, and a pseudo-random selection of tags in the same groups.
+static long CountEditLookUpDifferences( LIST_HEAD EditSpecificationList, long *pnTagsLookedUp )
+{
+	LIST_ELEMENT			*pEditSpecificationListElement;
+	EDIT_SPECIFICATION		*pEditSpecification;
+	TAG						DicomElementTag;
+	unsigned short			EditedGroups[ 256 ];
+	long					nEditedGroups;
+	long					nNeighbour;
+	long					nRandomTag;
+	unsigned long			RandomNumber;
+	long					nDifferences;
+
+	nDifferences = 0;
+	*pnTagsLookedUp = 0;
+	nEditedGroups = 0;
+	pEditSpecificationListElement = EditSpecificationList;
+	while ( pEditSpecificationListElement != 0 )
+		{
+		pEditSpecification = (EDIT_SPECIFICATION*)pEditSpecificationListElement -> pItem;
+		for ( nNeighbour = -1; nNeighbour <= 1; nNeighbour++ )
+			{
+			DicomElementTag.Group = pEditSpecification -> DicomFieldIdentifier.Group;
+			DicomElementTag.Element = (unsigned short)( pEditSpecification -> DicomFieldIdentifier.Element + nNeighbour );
+			if ( LookUpElementEditSpecification( DicomElementTag ) != ScanForElementEditSpecification( EditSpecificationList, DicomElementTag ) )
+				nDifferences++;
+			(*pnTagsLookedUp)++;
+			}
+		if ( nEditedGroups < 256 )
+			EditedGroups[ nEditedGroups++ ] = pEditSpecification -> DicomFieldIdentifier.Group;
+		pEditSpecificationListElement = pEditSpecificationListElement -> pNextListElement;
+		}
+	RandomNumber = 29;
+	for ( nRandomTag = 0; nRandomTag < 20000 && nEditedGroups > 0; nRandomTag++ )
+		{
+		RandomNumber = RandomNumber * 1103515245 + 12345;
+		DicomElementTag.Group = EditedGroups[ ( RandomNumber >> 16 ) % nEditedGroups ];
+		RandomNumber = RandomNumber * 1103515245 + 12345;
+		DicomElementTag.Element = (unsigned short)( ( RandomNumber >> 16 ) & 0x11FF );
+		if ( LookUpElementEditSpecification( DicomElementTag ) != ScanForElementEditSpecification( EditSpecificationList, DicomElementTag ) )
+			nDifferences++;
+		(*pnTagsLookedUp)++;
+		}
+
+	return nDifferences;
+}
+
+
+static BOOL EditIsLookedUp( unsigned short Group, unsigned short Element, char *pEditedFieldValue )
+{
+	TAG						DicomElementTag;
+	EDIT_SPECIFICATION		*pEditSpecification;
+
+	DicomElementTag.Group = Group;
+	DicomElementTag.Element = Element;
+	pEditSpecification = LookUpElementEditSpecification( DicomElementTag );
+
+	return ( pEditSpecification != 0 && strcmp( pEditSpecification -> EditedFieldValue, pEditedFieldValue ) == 0 );
+}
+
+
+static EDIT_SPECIFICATION *FindEditSpecification( LIST_HEAD EditSpecificationList, unsigned short EditOperation,
+																unsigned short Group, unsigned short Element )
+{
+	LIST_ELEMENT			*pEditSpecificationListElement;
+	EDIT_SPECIFICATION		*pEditSpecification;
+	EDIT_SPECIFICATION		*pMatchingEditSpecification;
+
+	pMatchingEditSpecification = 0;
+	pEditSpecificationListElement = EditSpecificationList;
+	while ( pEditSpecificationListElement != 0 && pMatchingEditSpecification == 0 )
+		{
+		pEditSpecification = (EDIT_SPECIFICATION*)pEditSpecificationListElement -> pItem;
+		if ( pEditSpecification -> EditOperation == EditOperation &&
+					pEditSpecification -> DicomFieldIdentifier.Group == Group && pEditSpecification -> DicomFieldIdentifier.Element == Element )
+			pMatchingEditSpecification = pEditSpecification;
+		pEditSpecificationListElement = pEditSpecificationListElement -> pNextListElement;
+		}
+
+	return pMatchingEditSpecification;
+}
+
+
+// Compare the compiled edit specifications with the per-element scan of the edit list that
+// ComposeDicomFileOutput() did before the edits were indexed.
+static void TestEditSpecificationLookUp()
+{
+	BOOL					bNoError = TRUE;
+	char					*pEditSetNames[] = { "Values", "Rules200" };
+	size_t					nEditSet;
+	LIST_HEAD				EditSpecificationList;
+	EDIT_SPECIFICATION		*pEditSpecification;
+	long					nTagsLookedUp;
+	long					nDifferences;
+	char					TestDescription[ MAX_FILE_SPEC_LENGTH ];
+
+	for ( nEditSet = 0; nEditSet < sizeof(pEditSetNames) / sizeof(char*); nEditSet++ )
+		{
+		bNoError = CompileEditSpecificationSet( pEditSetNames[ nEditSet ], &EditSpecificationList );
+		nDifferences = 0;
+		nTagsLookedUp = 0;
+		if ( bNoError )
+			nDifferences = CountEditLookUpDifferences( EditSpecificationList, &nTagsLookedUp );
+		_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE,
+						"The %s edit index finds the edit a scan of the edit list finds, for %ld tags.", pEditSetNames[ nEditSet ], nTagsLookedUp );
+		CheckTestResult( bNoError && nDifferences == 0, TestDescription );
+		if ( nDifferences != 0 )
+			printf( "    %ld tags were looked up differently.\n", nDifferences );
+		// The later edits for a tag, repeated among the Rules200 edits, are not applied.
+		_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "The first %s edit for a tag is applied.", pEditSetNames[ nEditSet ] );
+		CheckTestResult( bNoError && EditIsLookedUp( 0x0008, 0x0060, "DX" ) && EditIsLookedUp( 0x0010, 0x0010, "EDITED^NAME" ), TestDescription );
+		}
+	bNoError = CompileEditSpecificationSet( "Values", &EditSpecificationList );
+	pEditSpecification = 0;
+	if ( bNoError )
+		pEditSpecification = FindEditSpecification( EditSpecificationList, EDIT_VALUE, 0x0008, 0x0070 );
+	CheckTestResult( pEditSpecification != 0 && strcmp( pEditSpecification -> EncodedFieldValue, "Odd Maker " ) == 0,
+						"An odd-length edited value is padded to an even length." );
+	pEditSpecification = 0;
+	if ( bNoError )
+		pEditSpecification = FindEditSpecification( EditSpecificationList, EDIT_VALUE, 0x0010, 0x0010 );
+	CheckTestResult( pEditSpecification != 0 && strcmp( pEditSpecification -> PersonNameFieldValue, "EDITED^NAME " ) == 0,
+						"An edited person name is padded with a space." );
+	pEditSpecification = 0;
+	if ( bNoError )
+		pEditSpecification = FindEditSpecification( EditSpecificationList, EDIT_DELETE_ELEMENT, 0x0009, 0x0010 );
+	CheckTestResult( pEditSpecification != 0 && pEditSpecification -> NumericFieldValue == 2,
+						"A deletion edit counts the elements following the deleted element." );
+	CheckTestResult( bNoError && !EditIsLookedUp( 0x0008, 0x0080, "EDITED HOSPITAL" ) && !EditIsLookedUp( 0x0018, 0x0015, "0" ),
+						"Additions and deletions are not looked up as edits of existing elements." );
+}
+
+
+// Check the elements of a composition against those of its input, with the added and deleted
+// elements of the Values edits.  Four elements are deleted, by a single deletion and by one of a
+// deleted element and the two following it, and three are added.
+static void TestDeletedAndAddedElements()
+{
+	BOOL				bNoError = TRUE;
+	char				InputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				OutputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	TAG					InputTags[ 256 ];
+	long				nInputTags;
+	TAG					OutputTags[ 256 ];
+	long				nOutputTags;
+
+	nInputTags = 0;
+	nOutputTags = 0;
+	GetTestDataFileSpec( "DicomOutput\\Mono2Explicit16.dcm", InputFileSpec, MAX_FILE_SPEC_LENGTH );
+	bNoError = ReadDicomElementTags( InputFileSpec, InputTags, 256, &nInputTags );
+	if ( bNoError )
+		bNoError = ComposeTestOutputFile( "Mono2Explicit16.dcm", "Elements", "ElementsMono2Explicit16.dcm", OutputFileSpec );
+	if ( bNoError )
+		{
+		bNoError = ReadDicomElementTags( OutputFileSpec, OutputTags, 256, &nOutputTags );
+		remove( OutputFileSpec );
+		}
+	CheckTestResult( bNoError && nOutputTags == nInputTags - 4 + 3, "The composition has four elements deleted and three added." );
+	CheckTestResult( bNoError && !TagIsListed( OutputTags, nOutputTags, 0x0009, 0x0010 ) && !TagIsListed( OutputTags, nOutputTags, 0x0009, 0x1001 ) &&
+						!TagIsListed( OutputTags, nOutputTags, 0x0009, 0x1002 ) && !TagIsListed( OutputTags, nOutputTags, 0x0018, 0x0015 ),
+						"The deleted elements are not composed." );
+	CheckTestResult( bNoError && TagIsListed( OutputTags, nOutputTags, 0x0010, 0x0010 ) && TagIsListed( OutputTags, nOutputTags, 0x0018, 0x1000 ) &&
+						TagIsListed( OutputTags, nOutputTags, 0x0008, 0x1090 ) && TagIsListed( OutputTags, nOutputTags, 0x0010, 0x0020 ),
+						"The elements around the deleted elements are composed." );
+	CheckTestResult( bNoError && TagIsListed( OutputTags, nOutputTags, 0x0008, 0x0080 ) && TagIsListed( OutputTags, nOutputTags, 0x0010, 0x0030 ) &&
+						TagIsListed( OutputTags, nOutputTags, 0x0010, 0x0040 ), "The added elements are composed." );
+}
+
+
+// Time the edit look-ups for the elements of an image against the Rules200 edits, by the tag index
+// and by a scan of the edit list, and the composition of an image with those edits.
+static void BenchmarkEditSpecificationLookUp()
+{
+	BOOL				bNoError = TRUE;
+	LIST_HEAD			EditSpecificationList;
+	char				InputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				OutputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	TAG					InputTags[ 256 ];
+	long				nInputTags;
+	long				nPass;
+	long				nTag;
+	long				nLookUps;
+	long				nEditsFound;
+	long				nCompositions;
+	ULONGLONG			StartTime;
+	ULONGLONG			IndexTime;
+	ULONGLONG			ScanTime;
+	ULONGLONG			CompositionTime;
+
+	bNoError = CompileEditSpecificationSet( "Rules200", &EditSpecificationList );
+	nInputTags = 0;
+	if ( bNoError )
+		{
+		GetTestDataFileSpec( "DicomOutput\\MultipleBuffers16.dcm", InputFileSpec, MAX_FILE_SPEC_LENGTH );
+		bNoError = ReadDicomElementTags( InputFileSpec, InputTags, 256, &nInputTags );
+		}
+	if ( bNoError && nInputTags > 0 )
+		{
+		nLookUps = 0;
+		nEditsFound = 0;
+		StartTime = GetTickCount64();
+		for ( nPass = 0; nPass < 20000; nPass++ )
+			for ( nTag = 0; nTag < nInputTags; nTag++, nLookUps++ )
+				if ( LookUpElementEditSpecification( InputTags[ nTag ] ) != 0 )
+					nEditsFound++;
+		IndexTime = GetTickCount64() - StartTime;
+		StartTime = GetTickCount64();
+		for ( nPass = 0; nPass < 20000; nPass++ )
+			for ( nTag = 0; nTag < nInputTags; nTag++ )
+				if ( ScanForElementEditSpecification( EditSpecificationList, InputTags[ nTag ] ) != 0 )
+					nEditsFound--;
+		ScanTime = GetTickCount64() - StartTime;
+		printf( "    %ld look-ups among 200 edits took %lu ms by the tag index, and %lu ms by scanning the edit list.\n",
+					nLookUps, (unsigned long)IndexTime, (unsigned long)ScanTime );
+		CheckTestResult( nEditsFound == 0, "The tag index and the edit list scan find edits for the same image elements." );
+		nCompositions = 0;
+		StartTime = GetTickCount64();
+		while ( bNoError && nCompositions < 20 )
+			{
+			bNoError = ComposeTestOutputFile( "MultipleBuffers16.dcm", "Rules200", "BenchmarkMultipleBuffers16.dcm", OutputFileSpec );
+			nCompositions++;
+			}
+		CompositionTime = GetTickCount64() - StartTime;
+		remove( OutputFileSpec );
+		printf( "    %ld images of 300 x 250 pixels were composed with 200 edits, at %.1f ms per image.\n",
+					nCompositions, (double)CompositionTime / (double)nCompositions );
+		}
+	CheckTestResult( bNoError && nInputTags > 0, "An image can be composed repeatedly with 200 edits." );
+}
+
+
+// The image data of a Dicom file or an overlay image, with the parameters needed to locate the overlay.
+typedef struct
+	{
+	char				*pImageData;
+	unsigned long		nImageBytes;
+	long				nRows;
+	long				nColumns;
+	long				nBytesPerPixel;
+	BOOL				bMonochrome1;
+	} TEST_IMAGE;
+
+
+static BOOL ReadTestImage( char *pFileSpec, TEST_IMAGE *pImage )
+{
+	BOOL					bNoError = TRUE;
+	EXAM_INFO				ExamInfo;
+	DICOM_HEADER_SUMMARY	*pDicomHeader;
+
+	memset( pImage, 0, sizeof(TEST_IMAGE) );
+	memset( &ExamInfo, 0, sizeof(EXAM_INFO) );
+	pDicomHeader = 0;
+	bNoError = ReadDicomHeaderInfo( pFileSpec, &ExamInfo, &pDicomHeader, FALSE );
+	if ( bNoError )
+		bNoError = ( pDicomHeader -> pImageData != 0 && pDicomHeader -> ImageRows != 0 &&
+						pDicomHeader -> ImageColumns != 0 && pDicomHeader -> BitsAllocated != 0 );
+	if ( bNoError )
+		{
+		pImage -> nRows = (long)*pDicomHeader -> ImageRows;
+		pImage -> nColumns = (long)*pDicomHeader -> ImageColumns;
+		pImage -> nBytesPerPixel = ( *pDicomHeader -> BitsAllocated > 8 ) ? 2 : 1;
+		pImage -> bMonochrome1 = ( pDicomHeader -> PhotometricInterpretation != 0 &&
+										_stricmp( pDicomHeader -> PhotometricInterpretation, "MONOCHROME1" ) == 0 );
+		pImage -> nImageBytes = pImage -> nRows * pImage -> nColumns * pImage -> nBytesPerPixel;
+		bNoError = ( pDicomHeader -> ImageLengthInBytes >= pImage -> nImageBytes );
+		}
+	if ( bNoError )
+		{
+		pImage -> pImageData = (char*)malloc( pImage -> nImageBytes );
+		bNoError = ( pImage -> pImageData != 0 );
+		}
+	if ( bNoError )
+		memcpy( pImage -> pImageData, pDicomHeader -> pImageData, pImage -> nImageBytes );
+	FreeParsedDicomData( &ExamInfo, pDicomHeader );
+
+	return bNoError;
+}
+
+
+// Decompress an overlay image from the test data, as ComposeDicomFileOutput() does.
+static BOOL ReadOverlayImage( char *pOverlayFileName, TEST_IMAGE *pOverlay )
+{
+	BOOL				bNoError = TRUE;
+	char				RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				*pJpegData;
+	unsigned long		nJpegBytes;
+	unsigned long		ImageWidthInPixels;
+	unsigned long		ImageHeightInPixels;
+
+	memset( pOverlay, 0, sizeof(TEST_IMAGE) );
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "DicomOutput\\%s", pOverlayFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pJpegData, &nJpegBytes );
+	if ( bNoError )
+		{
+		bNoError = Decompress8BitJpegImage( pJpegData, nJpegBytes, &ImageWidthInPixels, &ImageHeightInPixels,
+												&pOverlay -> pImageData, &pOverlay -> nImageBytes );
+		free( pJpegData );
+		}
+	if ( bNoError )
+		{
+		pOverlay -> nRows = (long)ImageHeightInPixels;
+		pOverlay -> nColumns = (long)ImageWidthInPixels;
+		pOverlay -> nBytesPerPixel = 1;
+		}
+
+	return bNoError;
+}
+
+
+static void FreeTestImage( TEST_IMAGE *pImage )
+{
+	if ( pImage -> pImageData != 0 )
+		free( pImage -> pImageData );
+	pImage -> pImageData = 0;
+}
+
+
+// Count the pixels of a composed image that differ from the input image with the overlay written
+// into it.  The overlay is written into the bottom center of the image, with its last row at the top,
+// inverted for a MONOCHROME1 image.  A 16-bit pixel receives the overlay value as a signed char, so
+// that the values above 127 are sign-extended.
+static long CountOverlayPixelDifferences( TEST_IMAGE *pInputImage, TEST_IMAGE *pOutputImage, TEST_IMAGE *pOverlay )
+{
+	long				nDifferences;
+	long				nOverlayX0;
+	long				nOverlayY0;
+	long				nRow;
+	long				nColumn;
+	long				nPixel;
+	char				OverlayValue;
+	unsigned short		ExpectedValue;
+	unsigned short		OutputValue;
+
+	if ( pOutputImage -> nRows != pInputImage -> nRows || pOutputImage -> nColumns != pInputImage -> nColumns ||
+				pOutputImage -> nBytesPerPixel != pInputImage -> nBytesPerPixel )
+		nDifferences = pInputImage -> nRows * pInputImage -> nColumns;
+	else
+		{
+		nDifferences = 0;
+		nOverlayX0 = ( pInputImage -> nColumns - pOverlay -> nColumns ) / 2;
+		nOverlayY0 = pInputImage -> nRows - pOverlay -> nRows;
+		for ( nRow = 0; nRow < pInputImage -> nRows; nRow++ )
+			for ( nColumn = 0; nColumn < pInputImage -> nColumns; nColumn++ )
+				{
+				nPixel = nRow * pInputImage -> nColumns + nColumn;
+				if ( nRow >= nOverlayY0 && nColumn >= nOverlayX0 && nColumn < nOverlayX0 + pOverlay -> nColumns )
+					{
+					OverlayValue = pOverlay -> pImageData[ ( pOverlay -> nRows - 1 - ( nRow - nOverlayY0 ) ) * pOverlay -> nColumns + nColumn - nOverlayX0 ];
+					if ( pInputImage -> bMonochrome1 )
+						OverlayValue = ~OverlayValue;
+					if ( pInputImage -> nBytesPerPixel == 1 )
+						ExpectedValue = (unsigned char)OverlayValue;
+					else
+						ExpectedValue = (unsigned short)(signed char)OverlayValue;
+					}
+				else if ( pInputImage -> nBytesPerPixel == 1 )
+					ExpectedValue = (unsigned char)pInputImage -> pImageData[ nPixel ];
+				else
+					ExpectedValue = ( (unsigned short*)pInputImage -> pImageData )[ nPixel ];
+				if ( pOutputImage -> nBytesPerPixel == 1 )
+					OutputValue = (unsigned char)pOutputImage -> pImageData[ nPixel ];
+				else
+					OutputValue = ( (unsigned short*)pOutputImage -> pImageData )[ nPixel ];
+				if ( OutputValue != ExpectedValue )
+					nDifferences++;
+				}
+		}
+
+	return nDifferences;
+}
+
+
+// Compose an input file with an overlay edit set, and compare the composed image with the input
+// image and the overlay image.
+static BOOL ComposeOverlayImage( char *pInputFileName, char *pEditSetName, char *pOverlayFileName, long *pnDifferences )
+{
+	BOOL				bNoError = TRUE;
+	char				RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				InputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				OutputFileName[ MAX_FILE_SPEC_LENGTH ];
+	char				OutputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	TEST_IMAGE			InputImage;
+	TEST_IMAGE			OutputImage;
+	TEST_IMAGE			Overlay;
+
+	memset( &OutputImage, 0, sizeof(TEST_IMAGE) );
+	memset( &Overlay, 0, sizeof(TEST_IMAGE) );
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "DicomOutput\\%s", pInputFileName );
+	GetTestDataFileSpec( RelativeFileSpec, InputFileSpec, MAX_FILE_SPEC_LENGTH );
+	bNoError = ReadTestImage( InputFileSpec, &InputImage );
+	if ( bNoError )
+		{
+		_snprintf_s( OutputFileName, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "Pixels%s%s", pEditSetName, pInputFileName );
+		bNoError = ComposeTestOutputFile( pInputFileName, pEditSetName, OutputFileName, OutputFileSpec );
+		}
+	if ( bNoError )
+		{
+		bNoError = ReadTestImage( OutputFileSpec, &OutputImage );
+		remove( OutputFileSpec );
+		}
+	if ( bNoError )
+		bNoError = ReadOverlayImage( pOverlayFileName, &Overlay );
+	if ( bNoError )
+		*pnDifferences = CountOverlayPixelDifferences( &InputImage, &OutputImage, &Overlay );
+	FreeTestImage( &InputImage );
+	FreeTestImage( &OutputImage );
+	FreeTestImage( &Overlay );
+
+	return bNoError;
+}
+
+
+typedef struct
+	{
+	char				*pInputFileName;
+	char				*pEditSetName;
+	char				*pOverlayFileName;
+	} OVERLAY_COMPOSITION;
+
+
+static void TestOverlayPixels()
+{
+	BOOL					bNoError = TRUE;
+	OVERLAY_COMPOSITION		OverlayCompositions[] =
+								{
+									{ "Mono2Explicit8.dcm", "Overlay8", "Overlay.jpg" },
+									{ "Mono1Explicit8.dcm", "Overlay8", "Overlay.jpg" },
+									{ "Mono2Explicit16.dcm", "Overlay16", "Overlay.jpg" },
+									{ "Mono1Implicit16.dcm", "Overlay16", "Overlay.jpg" },
+									{ "Mono2Explicit16.dcm", "Overlay16B", "OverlayB.jpg" },
+									{ "Mono1Implicit16.dcm", "Overlay16B", "OverlayB.jpg" }
+								};
+	OVERLAY_COMPOSITION		*pComposition;
+	size_t					nComposition;
+	long					nDifferences;
+	char					TestDescription[ MAX_FILE_SPEC_LENGTH ];
+
+	for ( nComposition = 0; nComposition < sizeof(OverlayCompositions) / sizeof(OVERLAY_COMPOSITION); nComposition++ )
+		{
+		pComposition = &OverlayCompositions[ nComposition ];
+		nDifferences = 0;
+		bNoError = ComposeOverlayImage( pComposition -> pInputFileName, pComposition -> pEditSetName, pComposition -> pOverlayFileName, &nDifferences );
+		_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "The %s label is written into %s pixel for pixel.",
+						pComposition -> pOverlayFileName, pComposition -> pInputFileName );
+		CheckTestResult( bNoError && nDifferences == 0, TestDescription );
+		if ( nDifferences != 0 )
+			printf( "    %ld pixels differ.\n", nDifferences );
+		}
+}
+
+
+// Copy an overlay image from the test data to the label file of the Label edit set, and give it the
+// specified modification time.
+static BOOL WriteLabelFile( char *pOverlayFileName, __time64_t ModificationTime, unsigned long *pnFileBytes )
+{
+	BOOL					bNoError = TRUE;
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					LabelFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					*pJpegData;
+	FILE					*pLabelFile;
+	struct __utimbuf64		FileTimes;
+
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "DicomOutput\\%s", pOverlayFileName );
+	_snprintf_s( LabelFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\Label.jpg", TEST_DICOM_OUTPUT_DIRECTORY );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pJpegData, pnFileBytes );
+	if ( bNoError )
+		{
+		pLabelFile = fopen( LabelFileSpec, "wb" );
+		bNoError = ( pLabelFile != 0 );
+		if ( bNoError )
+			{
+			bNoError = ( fwrite( pJpegData, 1, *pnFileBytes, pLabelFile ) == *pnFileBytes );
+			if ( fclose( pLabelFile ) != 0 )
+				bNoError = FALSE;
+			}
+		free( pJpegData );
+		}
+	if ( bNoError )
+		{
+		FileTimes.actime = ModificationTime;
+		FileTimes.modtime = ModificationTime;
+		bNoError = ( _utime64( LabelFileSpec, &FileTimes ) == 0 );
+		}
+
+	return bNoError;
+}
+
+
+// Write the Label edit set, which overlays the label file on Mono2Explicit16.dcm.
+static BOOL WriteLabelEditSpecificationSet( unsigned long nLabelFileBytes )
+{
+	BOOL					bNoError = TRUE;
+	char					InputFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					ConfigDirectory[ MAX_FILE_SPEC_LENGTH ];
+	char					EditFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	TEST_IMAGE				InputImage;
+	FILE					*pEditFile;
+
+	GetTestDataFileSpec( "DicomOutput\\Mono2Explicit16.dcm", InputFileSpec, MAX_FILE_SPEC_LENGTH );
+	bNoError = ReadTestImage( InputFileSpec, &InputImage );
+	if ( bNoError )
+		{
+		_snprintf_s( ConfigDirectory, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\Label", TEST_DICOM_OUTPUT_DIRECTORY );
+		_snprintf_s( EditFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\DicomEdits.cfg", ConfigDirectory );
+		bNoError = LocateOrCreateDirectory( ConfigDirectory );
+		}
+	if ( bNoError )
+		{
+		pEditFile = fopen( EditFileSpec, "wt" );
+		bNoError = ( pEditFile != 0 );
+		}
+	if ( bNoError )
+		{
+		fprintf( pEditFile, "O(7FE0,0010),%lu 48 16 0 0 %lu %s\\Label.jpg\n", InputImage.nImageBytes, nLabelFileBytes, TEST_DICOM_OUTPUT_DIRECTORY );
+		bNoError = ( fclose( pEditFile ) == 0 );
+		}
+	FreeTestImage( &InputImage );
+
+	return bNoError;
+}
+
+
+// The decompressed overlay image is kept for the next composition, until the overlay file's
+// specification, modification time or size changes.  OverlayC.jpg is the same size as Overlay.jpg,
+// so that replacing one with the other only changes the modification time.
+static void TestOverlayImageCache()
+{
+	BOOL				bNoError = TRUE;
+	__time64_t			FirstModificationTime = 1700000000;
+	unsigned long		nLabelFileBytes;
+	unsigned long		nReplacementFileBytes;
+	long				nDifferences;
+
+	nDifferences = -1;
+	bNoError = WriteLabelFile( "Overlay.jpg", FirstModificationTime, &nLabelFileBytes );
+	if ( bNoError )
+		bNoError = WriteLabelEditSpecificationSet( nLabelFileBytes );
+	if ( bNoError )
+		bNoError = ComposeOverlayImage( "Mono2Explicit16.dcm", "Label", "Overlay.jpg", &nDifferences );
+	CheckTestResult( bNoError && nDifferences == 0, "The label file is written into the composed image." );
+	nDifferences = -1;
+	if ( bNoError )
+		bNoError = WriteLabelFile( "OverlayC.jpg", FirstModificationTime, &nReplacementFileBytes );
+	if ( bNoError )
+		bNoError = ( nReplacementFileBytes == nLabelFileBytes );
+	if ( bNoError )
+		bNoError = ComposeOverlayImage( "Mono2Explicit16.dcm", "Label", "Overlay.jpg", &nDifferences );
+	CheckTestResult( bNoError && nDifferences == 0, "The decompressed label is reused while the label file's time and size are unchanged." );
+	nDifferences = -1;
+	if ( bNoError )
+		bNoError = WriteLabelFile( "OverlayC.jpg", FirstModificationTime + 60, &nReplacementFileBytes );
+	if ( bNoError )
+		bNoError = ComposeOverlayImage( "Mono2Explicit16.dcm", "Label", "OverlayC.jpg", &nDifferences );
+	CheckTestResult( bNoError && nDifferences == 0, "The label is read again when the label file's modification time changes." );
+}
+
+
+// Remove the edit specification files and directories written by the tests.
+static void RemoveTestConfigDirectories()
+{
+	char				*pEditSetNames[] = { "Values", "Elements", "Rules200", "Overlay8", "Overlay16", "Overlay16B", "Label" };
+	char				ConfigDirectory[ MAX_FILE_SPEC_LENGTH ];
+	char				EditFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				LabelFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	size_t				nEditSet;
+
+	for ( nEditSet = 0; nEditSet < sizeof(pEditSetNames) / sizeof(char*); nEditSet++ )
+		{
+		_snprintf_s( ConfigDirectory, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\%s", TEST_DICOM_OUTPUT_DIRECTORY, pEditSetNames[ nEditSet ] );
+		_snprintf_s( EditFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\DicomEdits.cfg", ConfigDirectory );
+		DeleteFile( EditFileSpec );
+		RemoveDirectory( ConfigDirectory );
+		}
+	_snprintf_s( LabelFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\Label.jpg", TEST_DICOM_OUTPUT_DIRECTORY );
+	DeleteFile( LabelFileSpec );
+	RemoveDirectory( TEST_DICOM_OUTPUT_DIRECTORY );
+}
+
+
+void TestDicomOutput()
+{
+	BOOL				bNoError = TRUE;
+	char				DictionaryFileSpec[ MAX_FILE_SPEC_LENGTH ];
+
+	InitDictionaryModule();
+	GetTestDataFileSpec( "DicomOutput\\OutputDictionary.txt", DictionaryFileSpec, MAX_FILE_SPEC_LENGTH );
+	bNoError = ReadDictionaryFile( DictionaryFileSpec, FALSE );
+	CheckTestResult( bNoError, "The Dicom output test dictionary can be read." );
+	RemoveTestConfigDirectories();
+	bNoError = LocateOrCreateDirectory( TEST_DICOM_OUTPUT_DIRECTORY );
+	CheckTestResult( bNoError, "The Dicom output test directory can be created." );
+	if ( bNoError )
+		{
+		TestDicomOutputVectors();
+		TestEditSpecificationLookUp();
+		TestDeletedAndAddedElements();
+		BenchmarkEditSpecificationLookUp();
+		TestOverlayPixels();
+		TestOverlayImageCache();
+		}
+	CloseExamEditModule();
+	RemoveTestConfigDirectories();
+	// This releases the dictionary and the overlay image kept by ComposeDicomFileOutput().
+	CloseDicomModule();
+}
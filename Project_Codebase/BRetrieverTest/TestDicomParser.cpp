@@ -0,0 +1,223 @@
+// TestDicomParser.cpp : Implements the tests of the Dicom element parser in Dicom.cpp,
+//	using the test files in TestData\DicomParser.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Exam.h"
+#include "BRetrieverTest.h"
+#include "FuzzDicomParser.h"
+
+
+// The test files are listed in TestData\DicomParser\DicomParserSeeds.txt, which is written by
+// MakeDicomParserSeeds.py along with the files.  Each line names a file and the image columns,
+// rows and bits allocated, and the length and file offset of the image data, expected from the
+// parse.  A file listed with zeros should be rejected.  The corpus files in TestData\DicomCorpus
+// are listed the same way, followed by the transfer syntax UID the parse should find.
+
+static void TestDicomParserSeed( char *pDirectoryName, char *pSeedFileName, unsigned short Columns, unsigned short Rows,
+									unsigned short BitsAllocated, unsigned long ImageLength, unsigned long ImageOffset,
+									char *pTransferSyntaxUID )
+{
+	BOOL					bNoError = TRUE;
+	BOOL					bParsedOK;
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					TestDescription[ MAX_FILE_SPEC_LENGTH ];
+	char					*pDicomData;
+	unsigned long			nDataBytes;
+	EXAM_INFO				ExamInfo;
+	DICOM_HEADER_SUMMARY	*pDicomHeader;
+
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s\\%s", pDirectoryName, pSeedFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pDicomData, &nDataBytes );
+	if ( bNoError )
+		{
+		bParsedOK = ParseDicomData( pDicomData, nDataBytes, &ExamInfo, &pDicomHeader );
+		if ( ImageLength > 0 )
+			{
+			bNoError = ( bParsedOK && pDicomHeader -> ImageColumns != 0 && pDicomHeader -> ImageRows != 0 &&
+							pDicomHeader -> BitsAllocated != 0 );
+			if ( bNoError )
+				bNoError = ( *pDicomHeader -> ImageColumns == Columns && *pDicomHeader -> ImageRows == Rows &&
+								*pDicomHeader -> BitsAllocated == BitsAllocated );
+			if ( bNoError )
+				bNoError = ( pDicomHeader -> ImageLengthInBytes == ImageLength && pDicomHeader -> pImageData != 0 &&
+								ImageOffset + ImageLength <= nDataBytes &&
+								memcmp( pDicomHeader -> pImageData, pDicomData + ImageOffset, ImageLength ) == 0 );
+			if ( bNoError && pTransferSyntaxUID != 0 )
+				bNoError = ( pDicomHeader -> TransferSyntaxUniqueIdentifier != 0 &&
+								strcmp( pDicomHeader -> TransferSyntaxUniqueIdentifier, pTransferSyntaxUID ) == 0 );
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s is parsed, and its image data located.", pSeedFileName );
+			}
+		else
+			{
+			bNoError = !bParsedOK;
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s is rejected.", pSeedFileName );
+			}
+		FreeParsedDicomData( &ExamInfo, pDicomHeader );
+		free( pDicomData );
+		}
+	else
+		_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s can be read.", pSeedFileName );
+	CheckTestResult( bNoError, TestDescription );
+}
+
+
+// A file cut short, or damaged, must not crash the parser, and any image data it locates
+// must lie within the file.  These are the checks the fuzz target in FuzzDicomParser.cpp
+// makes at random.  Only the first part of the file, holding the elements, is corrupted.
+static void TestDamagedDicomFiles( char *pSeedFileName )
+{
+	BOOL					bNoError = TRUE;
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					TestDescription[ MAX_FILE_SPEC_LENGTH ];
+	char					*pDicomData;
+	char					*pDamagedData;
+	unsigned long			nDataBytes;
+	unsigned long			DamagedLength;
+	unsigned long			nByte;
+	EXAM_INFO				ExamInfo;
+	DICOM_HEADER_SUMMARY	*pDicomHeader;
+
+	pDamagedData = 0;
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "DicomParser\\%s", pSeedFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pDicomData, &nDataBytes );
+	// Truncate the file at a range of lengths.
+	for ( DamagedLength = 0; bNoError && DamagedLength < nDataBytes; DamagedLength += 1 + DamagedLength / 16 )
+		{
+		if ( ParseDicomData( pDicomData, DamagedLength, &ExamInfo, &pDicomHeader ) )
+			bNoError = ( pDicomHeader -> ImageLengthInBytes <= DamagedLength );
+		FreeParsedDicomData( &ExamInfo, pDicomHeader );
+		}
+	// Corrupt single bytes throughout the elements.
+	if ( bNoError )
+		{
+		pDamagedData = (char*)malloc( nDataBytes );
+		bNoError = ( pDamagedData != 0 );
+		}
+	for ( nByte = 132; bNoError && nByte < nDataBytes && nByte < 4096; nByte += 3 )
+		{
+		memcpy( pDamagedData, pDicomData, nDataBytes );
+		pDamagedData[ nByte ] ^= (char)( 0x5A + nByte );
+		if ( ParseDicomData( pDamagedData, nDataBytes, &ExamInfo, &pDicomHeader ) )
+			bNoError = ( pDicomHeader -> ImageLengthInBytes <= nDataBytes );
+		FreeParsedDicomData( &ExamInfo, pDicomHeader );
+		}
+	_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "Truncated and corrupted copies of %s are handled.", pSeedFileName );
+	CheckTestResult( bNoError, TestDescription );
+	if ( pDicomData != 0 )
+		free( pDicomData );
+	if ( pDamagedData != 0 )
+		free( pDamagedData );
+}
+
+
+// The synthetic image corpus is written by TestData\DicomCorpus\MakeDicomCorpus.py.  It is too
+// large to keep with the other test data, so its files are checked only when it has been generated.
+static void TestDicomCorpus()
+{
+	BOOL				bNoError = TRUE;
+	FILE				*pManifestFile;
+	char				ManifestFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				DictionaryFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				TextLine[ 256 ];
+	char				CorpusFileName[ 64 ];
+	char				TransferSyntaxUID[ 68 ];
+	int					Columns;
+	int					Rows;
+	int					BitsAllocated;
+	unsigned long		ImageLength;
+	unsigned long		ImageOffset;
+	long				nCorpusFiles;
+
+	nCorpusFiles = 0;
+	GetTestDataFileSpec( "DicomCorpus\\DicomCorpus.txt", ManifestFileSpec, MAX_FILE_SPEC_LENGTH );
+	pManifestFile = fopen( ManifestFileSpec, "rt" );
+	if ( pManifestFile != 0 )
+		{
+		InitDictionaryModule();
+		GetTestDataFileSpec( "DicomCorpus\\CorpusDictionary.txt", DictionaryFileSpec, MAX_FILE_SPEC_LENGTH );
+		bNoError = ReadDictionaryFile( DictionaryFileSpec, FALSE );
+		CheckTestResult( bNoError, "The corpus dictionary can be read." );
+		while ( bNoError && fgets( TextLine, 256, pManifestFile ) != 0 )
+			{
+			if ( TextLine[ 0 ] != '#' && sscanf( TextLine, "%63s %d %d %d %lu %lu %67s", CorpusFileName, &Columns, &Rows,
+															&BitsAllocated, &ImageLength, &ImageOffset, TransferSyntaxUID ) == 7 )
+				{
+				TestDicomParserSeed( "DicomCorpus", CorpusFileName, (unsigned short)Columns, (unsigned short)Rows,
+										(unsigned short)BitsAllocated, ImageLength, ImageOffset, TransferSyntaxUID );
+				nCorpusFiles++;
+				}
+			}
+		fclose( pManifestFile );
+		CheckTestResult( bNoError && nCorpusFiles > 0, "The corpus files are listed." );
+		CloseDictionaryModule();
+		}
+	else
+		printf( "    The image corpus has not been generated.  Run MakeDicomCorpus.py in TestData\\DicomCorpus to check it.\n" );
+}
+
+
+void TestDicomParser()
+{
+	BOOL				bNoError = TRUE;
+	FILE				*pManifestFile;
+	char				ManifestFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				DictionaryFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				TextLine[ 256 ];
+	char				SeedFileName[ 64 ];
+	int					Columns;
+	int					Rows;
+	int					BitsAllocated;
+	unsigned long		ImageLength;
+	unsigned long		ImageOffset;
+	long				nSeeds;
+
+	nSeeds = 0;
+	InitDictionaryModule();
+	GetTestDataFileSpec( "DicomParser\\ParserDictionary.txt", DictionaryFileSpec, MAX_FILE_SPEC_LENGTH );
+	bNoError = ReadDictionaryFile( DictionaryFileSpec, FALSE );
+	CheckTestResult( bNoError, "The parser test dictionary can be read." );
+	GetTestDataFileSpec( "DicomParser\\DicomParserSeeds.txt", ManifestFileSpec, MAX_FILE_SPEC_LENGTH );
+	pManifestFile = fopen( ManifestFileSpec, "rt" );
+	bNoError = ( bNoError && pManifestFile != 0 );
+	while ( bNoError && fgets( TextLine, 256, pManifestFile ) != 0 )
+		{
+		if ( TextLine[ 0 ] != '#' && sscanf( TextLine, "%63s %d %d %d %lu %lu", SeedFileName, &Columns, &Rows,
+														&BitsAllocated, &ImageLength, &ImageOffset ) == 6 )
+			{
+			TestDicomParserSeed( "DicomParser", SeedFileName, (unsigned short)Columns, (unsigned short)Rows, (unsigned short)BitsAllocated,
+										ImageLength, ImageOffset, 0 );
+			TestDamagedDicomFiles( SeedFileName );
+			nSeeds++;
+			}
+		}
+	if ( pManifestFile != 0 )
+		fclose( pManifestFile );
+	CheckTestResult( bNoError && nSeeds > 0, "The Dicom parser test files are listed." );
+	CloseDictionaryModule();
+	TestDicomCorpus();
+}
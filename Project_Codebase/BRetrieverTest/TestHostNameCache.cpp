@@ -0,0 +1,164 @@
+// TestHostNameCache.cpp : Implements the tests of the client host name cache in
+//	HostNameCache.cpp, using a stub resolver in place of DNS.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#pragma pack(push, 8)		// Pack structure members on 8-byte boundaries, as BRetriever does.
+#include <winsock2.h>
+#pragma pack(pop)
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "WinSocketsAPI.h"
+#include "DicomAssoc.h"
+#include "DicomAcceptor.h"
+#include "BRetrieverTest.h"
+
+
+// The stub resolver stands in for a slow DNS server.  It answers after StubResolverDelay
+// milliseconds.  Addresses with an even last byte resolve to STUB_HOST_NAME, and the others
+// fail to resolve.
+#define STUB_HOST_NAME						"client.example.org"
+#define STUB_CLIENT_COUNT					32
+#define ACCEPT_LOOP_LATENCY_LIMIT			250			// Milliseconds for all the STUB_CLIENT_COUNT lookups.
+
+static DWORD					StubResolverDelay = 0;
+static volatile LONG			nStubResolverCalls = 0;
+static char						StubHostName[] = STUB_HOST_NAME;
+static hostent					StubHostEntity = { StubHostName, 0, AF_INET, 4, 0 };
+
+
+static BOOL StubGetHostByAddress( char *pAddressBuffer, int AddressLength, int AddressType, hostent **ppHostInformation )
+{
+	BOOL			bNoError = TRUE;
+
+	Sleep( StubResolverDelay );
+	InterlockedIncrement( &nStubResolverCalls );
+	bNoError = ( AddressLength == 4 && AddressType == AF_INET && ( pAddressBuffer[ 3 ] & 1 ) == 0 );
+	if ( bNoError )
+		*ppHostInformation = &StubHostEntity;
+	else
+		*ppHostInformation = 0;
+
+	return bNoError;
+}
+
+
+static unsigned long StubClientAddress( int nClient )
+{
+	// 10.1.2.nClient, in network byte order.
+	return 0x0002010AL | ( (unsigned long)( nClient + 1 ) << 24 );
+}
+
+
+// Wait for the lookup of every stub client address to finish.
+static BOOL WaitForStubLookups( DWORD Timeout )
+{
+	ULONGLONG		StartTime;
+
+	StartTime = GetTickCount64();
+	while ( nStubResolverCalls < STUB_CLIENT_COUNT && GetTickCount64() - StartTime < Timeout )
+		Sleep( 10 );
+	Sleep( 50 );			// Let the lookup threads record their results.
+
+	return ( nStubResolverCalls >= STUB_CLIENT_COUNT );
+}
+
+
+// A connection must be accepted without waiting for the client's host name to be resolved.
+static void TestHostNameLookupLatency()
+{
+	BOOL			bNoError = TRUE;
+	char			HostName[ MAX_CFG_STRING_LENGTH ];
+	ULONGLONG		StartTime;
+	ULONGLONG		ElapsedTime;
+	int				nClient;
+
+	StubResolverDelay = 1000;
+	nStubResolverCalls = 0;
+	StartTime = GetTickCount64();
+	for ( nClient = 0; nClient < STUB_CLIENT_COUNT; nClient++ )
+		{
+		strncpy_s( HostName, MAX_CFG_STRING_LENGTH, "unchanged", _TRUNCATE );
+		if ( LookUpCachedHostName( StubClientAddress( nClient ), HostName, TRUE ) || strcmp( HostName, "unchanged" ) != 0 )
+			bNoError = FALSE;
+		}
+	ElapsedTime = GetTickCount64() - StartTime;
+	printf( "    %d host name lookups started in %lu ms, with a %lu ms resolver.\n",
+				STUB_CLIENT_COUNT, (unsigned long)ElapsedTime, (unsigned long)StubResolverDelay );
+	CheckTestResult( bNoError && ElapsedTime < ACCEPT_LOOP_LATENCY_LIMIT, "Accepting a connection doesn't wait for its host name." );
+
+	bNoError = WaitForStubLookups( 10 * StubResolverDelay );
+	CheckTestResult( bNoError && nStubResolverCalls == STUB_CLIENT_COUNT, "Each client address is looked up once." );
+}
+
+
+// The resolved names are cached, and failed lookups aren't repeated.
+static void TestHostNameCacheContents()
+{
+	BOOL			bNoError = TRUE;
+	BOOL			bHostNameIsKnown;
+	char			HostName[ MAX_CFG_STRING_LENGTH ];
+	int				nClient;
+
+	for ( nClient = 0; nClient < STUB_CLIENT_COUNT; nClient++ )
+		{
+		HostName[ 0 ] = '\0';
+		bHostNameIsKnown = LookUpCachedHostName( StubClientAddress( nClient ), HostName, TRUE );
+		if ( ( StubClientAddress( nClient ) >> 24 ) % 2 == 0 )
+			bNoError = bNoError && bHostNameIsKnown && strcmp( HostName, STUB_HOST_NAME ) == 0;
+		else
+			bNoError = bNoError && !bHostNameIsKnown && HostName[ 0 ] == '\0';
+		}
+	Sleep( 50 );
+	CheckTestResult( bNoError, "Resolved host names are found in the cache." );
+	CheckTestResult( nStubResolverCalls == STUB_CLIENT_COUNT, "Failed host name lookups are not repeated." );
+}
+
+
+// Closing the cache must wait for the lookups under way, since they use Windows sockets.
+static void TestHostNameCacheClosing()
+{
+	char			HostName[ MAX_CFG_STRING_LENGTH ];
+	LONG			nResolverCallsBefore;
+
+	StubResolverDelay = 500;
+	nResolverCallsBefore = nStubResolverCalls;
+	LookUpCachedHostName( StubClientAddress( STUB_CLIENT_COUNT ), HostName, TRUE );
+	CloseHostNameCache();
+	CheckTestResult( nStubResolverCalls == nResolverCallsBefore + 1, "Closing the host name cache waits for the lookups under way." );
+}
+
+
+void TestHostNameCache()
+{
+	SetHostNameResolver( StubGetHostByAddress );
+	InitHostNameCache();
+	TestHostNameLookupLatency();
+	TestHostNameCacheContents();
+	TestHostNameCacheClosing();
+	SetHostNameResolver( GetWindowsHostByAddress );
+}
+
@@ -0,0 +1,214 @@
+// TestJpeg2000.cpp : Implements the tests of the JPEG 2000 decoder in ReformatJpeg2000.cpp,
+//	using the conformance vectors in TestData\Jpeg2000.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "ProductDispatcher.h"
+#include "ExamReformat.h"
+#include "BRetrieverTest.h"
+
+
+// The conformance vectors are listed in TestData\Jpeg2000\Jpeg2000Vectors.txt, which is written
+// by MakeJpeg2000Vectors.py along with the vectors.  Each line names a codestream, the Dicom
+// columns, rows and bits allocated to declare for it, and whether it should be decoded or
+// rejected.  A decoded image must match the pixel values in the .raw file of the same name.
+
+static void SetUpDicomHeader( DICOM_HEADER_SUMMARY *pDicomHeader, unsigned short *pColumns, unsigned short *pRows,
+									unsigned short *pBitsAllocated, char *pCodestream, unsigned long CodestreamLength )
+{
+	memset( pDicomHeader, 0, sizeof(DICOM_HEADER_SUMMARY) );
+	pDicomHeader -> ImageColumns = pColumns;
+	pDicomHeader -> ImageRows = pRows;
+	pDicomHeader -> BitsAllocated = pBitsAllocated;
+	pDicomHeader -> BitsStored = pBitsAllocated;
+	pDicomHeader -> pImageData = pCodestream;
+	pDicomHeader -> ImageLengthInBytes = CodestreamLength;
+}
+
+
+static void TestJpeg2000Vector( char *pVectorFileName, unsigned short Columns, unsigned short Rows,
+									unsigned short BitsAllocated, BOOL bShouldBeDecoded )
+{
+	BOOL					bNoError = TRUE;
+	BOOL					bImageCanBeDecoded;
+	DICOM_HEADER_SUMMARY	DicomHeader;
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					TestDescription[ MAX_FILE_SPEC_LENGTH ];
+	char					*pCodestream;
+	unsigned long			CodestreamLength;
+	char					*pExpectedImage;
+	unsigned long			ExpectedImageLength;
+	char					*pDecodedImage;
+	unsigned long			DecodedImageLength;
+	char					*pExtension;
+
+	pCodestream = 0;
+	pExpectedImage = 0;
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "Jpeg2000\\%s", pVectorFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pCodestream, &CodestreamLength );
+	if ( bNoError && bShouldBeDecoded )
+		{
+		pExtension = strrchr( RelativeFileSpec, '.' );
+		if ( pExtension != 0 )
+			strncpy_s( pExtension, MAX_FILE_SPEC_LENGTH - ( pExtension - RelativeFileSpec ), ".raw", _TRUNCATE );
+		bNoError = ReadTestDataFile( RelativeFileSpec, &pExpectedImage, &ExpectedImageLength );
+		}
+	if ( bNoError )
+		{
+		SetUpDicomHeader( &DicomHeader, &Columns, &Rows, &BitsAllocated, pCodestream, CodestreamLength );
+		bImageCanBeDecoded = Jpeg2000ImageCanBeDecoded( &DicomHeader );
+		if ( bShouldBeDecoded )
+			{
+			ClearConvertedImage();
+			bNoError = bImageCanBeDecoded && ConvertJpeg2000ImageToPNGFile( &DicomHeader, 0, FALSE );
+			if ( bNoError )
+				bNoError = GetConvertedImage( &pDecodedImage, &DecodedImageLength );
+			if ( bNoError )
+				bNoError = ( DecodedImageLength == ExpectedImageLength &&
+								memcmp( pDecodedImage, pExpectedImage, ExpectedImageLength ) == 0 );
+			// The Dicom header must be left describing the compressed image.
+			if ( bNoError )
+				bNoError = ( DicomHeader.pImageData == pCodestream && DicomHeader.ImageLengthInBytes == CodestreamLength );
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s is decoded exactly.", pVectorFileName );
+			ClearConvertedImage();
+			}
+		else
+			{
+			bNoError = !bImageCanBeDecoded;
+			if ( bNoError )
+				bNoError = !ConvertJpeg2000ImageToPNGFile( &DicomHeader, 0, FALSE );
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s is rejected.", pVectorFileName );
+			}
+		}
+	else
+		_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s can be read.", pVectorFileName );
+	CheckTestResult( bNoError, TestDescription );
+	if ( pCodestream != 0 )
+		free( pCodestream );
+	if ( pExpectedImage != 0 )
+		free( pExpectedImage );
+}
+
+
+// A codestream cut short, or damaged, must not crash the decoder.  Truncated codestreams may
+// legitimately decode to a lower quality image, so only the survival of the decoder and the
+// restoration of the Dicom header are checked.
+static void TestDamagedJpeg2000Codestreams( char *pVectorFileName, unsigned short Columns, unsigned short Rows )
+{
+	BOOL					bNoError = TRUE;
+	DICOM_HEADER_SUMMARY	DicomHeader;
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					*pCodestream;
+	char					*pDamagedCodestream;
+	unsigned long			CodestreamLength;
+	unsigned long			DamagedLength;
+	unsigned long			nByte;
+	unsigned short			BitsAllocated = 16;
+
+	pDamagedCodestream = 0;
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "Jpeg2000\\%s", pVectorFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pCodestream, &CodestreamLength );
+	if ( bNoError )
+		{
+		pDamagedCodestream = (char*)malloc( CodestreamLength );
+		bNoError = ( pDamagedCodestream != 0 );
+		}
+	// Truncate the codestream at a range of lengths.  Each copy is allocated at its exact
+	// length, so that a debug heap or address sanitizer can detect any overrun.
+	for ( DamagedLength = 0; bNoError && DamagedLength < CodestreamLength; DamagedLength += 1 + DamagedLength / 8 )
+		{
+		free( pDamagedCodestream );
+		pDamagedCodestream = (char*)malloc( DamagedLength + 1 );
+		bNoError = ( pDamagedCodestream != 0 );
+		if ( bNoError )
+			{
+			memcpy( pDamagedCodestream, pCodestream, DamagedLength );
+			SetUpDicomHeader( &DicomHeader, &Columns, &Rows, &BitsAllocated, pDamagedCodestream, DamagedLength );
+			if ( Jpeg2000ImageCanBeDecoded( &DicomHeader ) )
+				ConvertJpeg2000ImageToPNGFile( &DicomHeader, 0, FALSE );
+			bNoError = ( DicomHeader.pImageData == pDamagedCodestream && DicomHeader.ImageLengthInBytes == DamagedLength );
+			ClearConvertedImage();
+			}
+		}
+	// Corrupt single bytes throughout the codestream.
+	if ( bNoError )
+		{
+		free( pDamagedCodestream );
+		pDamagedCodestream = (char*)malloc( CodestreamLength );
+		bNoError = ( pDamagedCodestream != 0 );
+		}
+	for ( nByte = 0; bNoError && nByte < CodestreamLength; nByte += 7 )
+		{
+		memcpy( pDamagedCodestream, pCodestream, CodestreamLength );
+		pDamagedCodestream[ nByte ] ^= (char)( 0x5A + nByte );
+		SetUpDicomHeader( &DicomHeader, &Columns, &Rows, &BitsAllocated, pDamagedCodestream, CodestreamLength );
+		if ( Jpeg2000ImageCanBeDecoded( &DicomHeader ) )
+			ConvertJpeg2000ImageToPNGFile( &DicomHeader, 0, FALSE );
+		ClearConvertedImage();
+		}
+	CheckTestResult( bNoError, "Truncated and corrupted codestreams are handled." );
+	if ( pCodestream != 0 )
+		free( pCodestream );
+	if ( pDamagedCodestream != 0 )
+		free( pDamagedCodestream );
+}
+
+
+void TestJpeg2000Decoder()
+{
+	BOOL				bNoError = TRUE;
+	FILE				*pManifestFile;
+	char				ManifestFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				TextLine[ 256 ];
+	char				VectorFileName[ 64 ];
+	char				Expectation[ 16 ];
+	int					Columns;
+	int					Rows;
+	int					BitsAllocated;
+	long				nVectors;
+
+	nVectors = 0;
+	GetTestDataFileSpec( "Jpeg2000\\Jpeg2000Vectors.txt", ManifestFileSpec, MAX_FILE_SPEC_LENGTH );
+	pManifestFile = fopen( ManifestFileSpec, "rt" );
+	bNoError = ( pManifestFile != 0 );
+	while ( bNoError && fgets( TextLine, 256, pManifestFile ) != 0 )
+		{
+		if ( TextLine[ 0 ] != '#' && sscanf( TextLine, "%63s %d %d %d %15s", VectorFileName, &Columns, &Rows, &BitsAllocated, Expectation ) == 5 )
+			{
+			TestJpeg2000Vector( VectorFileName, (unsigned short)Columns, (unsigned short)Rows, (unsigned short)BitsAllocated,
+									( strcmp( Expectation, "DECODE" ) == 0 ) );
+			nVectors++;
+			}
+		}
+	if ( pManifestFile != 0 )
+		fclose( pManifestFile );
+	CheckTestResult( bNoError && nVectors > 0, "The JPEG 2000 conformance vectors are listed." );
+	TestDamagedJpeg2000Codestreams( "Gray12Layers.j2k", 67, 45 );
+	TestDamagedJpeg2000Codestreams( "Gray12Tiles.j2k", 67, 45 );
+}
+
@@ -0,0 +1,335 @@
+// TestJpegLossless.cpp : Implements the tests of the lossless JPEG decoder in
+//	ReformatJpegLossless.cpp and of the fallback to the JPEG libraries, using the test
+//	vectors in TestData\JpegLossless.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "ProductDispatcher.h"
+#include "ExamReformat.h"
+#include "BRetrieverTest.h"
+
+#pragma pack(push)
+#pragma pack(8)		// Pack structure members on 8-byte boundaries for faster access.
+
+extern "C"
+{
+#include "png.h"
+}
+
+#pragma pack(pop)
+
+
+// The test vectors are listed in TestData\JpegLossless\LosslessJpegVectors.txt, which is
+// written by MakeLosslessJpegVectors.py along with the vectors.  Each line names a lossless
+// JPEG image, the Dicom columns, rows and bits stored to declare for it, and the decoder
+// expected to handle it.  Each image is converted by OutputPNGImage(), the same as for a
+// received Dicom file, so that the choice between the lossless decoder and the JPEG
+// libraries is exercised along with the decoders themselves.
+
+#define DECODED_BY_LOSSLESS_DECODER		1
+#define DECODED_BY_JPEG_LIBRARY			2
+#define DECODED_AFTER_FALLBACK			3
+#define NOT_DECODED						4
+
+
+// Read the PNG image that follows the calibration data in an output file and compare its
+// pixels with the expected values, if any.  The PNG image must extend to the end of the file.
+static BOOL CheckOutputPNGImage( char *pOutputFileSpec, unsigned short Columns, unsigned short Rows, unsigned short BitsStored,
+									char *pExpectedImage, unsigned long ExpectedImageLength )
+{
+	BOOL					bNoError = TRUE;
+	FILE					*pImageFile;
+	png_struct				*pPngConfig;
+	png_info				*pPngImageInfo;
+	png_byte				*pRow;
+	long					FileSize;
+	long					nRow;
+	long					nColumn;
+	long					nBytesPerSample;
+	unsigned short			PixelValue;
+	unsigned short			ExpectedPixelValue;
+
+	pPngConfig = 0;
+	pPngImageInfo = 0;
+	pRow = 0;
+	nBytesPerSample = ( BitsStored <= 8 ) ? 1 : 2;
+	pImageFile = fopen( pOutputFileSpec, "rb" );
+	bNoError = ( pImageFile != 0 );
+	if ( bNoError )
+		{
+		fseek( pImageFile, 0, SEEK_END );
+		FileSize = ftell( pImageFile );
+		bNoError = ( fseek( pImageFile, sizeof(IMAGE_CALIBRATION_INFO), SEEK_SET ) == 0 );
+		}
+	if ( bNoError )
+		{
+		pPngConfig = png_create_read_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+		bNoError = ( pPngConfig != 0 );
+		}
+	if ( bNoError )
+		{
+		pPngImageInfo = png_create_info_struct( pPngConfig );
+		bNoError = ( pPngImageInfo != 0 );
+		}
+	if ( bNoError )
+		{
+		pRow = (png_byte*)malloc( Columns * nBytesPerSample );
+		bNoError = ( pRow != 0 );
+		}
+	if ( bNoError && setjmp( png_jmpbuf( pPngConfig ) ) )
+		bNoError = FALSE;
+	if ( bNoError )
+		{
+		png_init_io( pPngConfig, pImageFile );
+		png_read_info( pPngConfig, pPngImageInfo );
+		bNoError = ( png_get_image_width( pPngConfig, pPngImageInfo ) == Columns &&
+						png_get_image_height( pPngConfig, pPngImageInfo ) == Rows &&
+						png_get_bit_depth( pPngConfig, pPngImageInfo ) == 8 * nBytesPerSample &&
+						png_get_color_type( pPngConfig, pPngImageInfo ) == PNG_COLOR_TYPE_GRAY );
+		}
+	for ( nRow = 0; bNoError && nRow < Rows; nRow++ )
+		{
+		png_read_row( pPngConfig, pRow, NULL );
+		for ( nColumn = 0; pExpectedImage != 0 && bNoError && nColumn < Columns; nColumn++ )
+			{
+			// The PNG samples are big-endian, the expected values little-endian.
+			if ( nBytesPerSample == 1 )
+				{
+				PixelValue = (unsigned short)pRow[ nColumn ];
+				ExpectedPixelValue = (unsigned char)pExpectedImage[ nRow * Columns + nColumn ];
+				}
+			else
+				{
+				PixelValue = (unsigned short)( ( pRow[ 2 * nColumn ] << 8 ) | pRow[ 2 * nColumn + 1 ] );
+				ExpectedPixelValue = (unsigned short)( (unsigned char)pExpectedImage[ 2 * ( nRow * Columns + nColumn ) ] |
+										( (unsigned char)pExpectedImage[ 2 * ( nRow * Columns + nColumn ) + 1 ] << 8 ) );
+				}
+			bNoError = ( PixelValue == ExpectedPixelValue );
+			}
+		}
+	if ( bNoError )
+		{
+		png_read_end( pPngConfig, NULL );
+		bNoError = ( ftell( pImageFile ) == FileSize );
+		}
+	if ( pPngConfig != 0 )
+		png_destroy_read_struct( &pPngConfig, ( pPngImageInfo != 0 ) ? &pPngImageInfo : png_infopp_NULL, png_infopp_NULL );
+	if ( pRow != 0 )
+		free( pRow );
+	if ( pImageFile != 0 )
+		fclose( pImageFile );
+
+	return bNoError;
+}
+
+
+static void TestLosslessJpegVector( char *pVectorFileName, unsigned short Columns, unsigned short Rows,
+										unsigned short BitsStored, long ExpectedDecoder )
+{
+	BOOL					bNoError = TRUE;
+	BOOL					bImageWasConverted;
+	DICOM_HEADER_SUMMARY	DicomHeader;
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					TestDescription[ MAX_FILE_SPEC_LENGTH ];
+	char					*pJpegImage;
+	unsigned long			JpegImageLength;
+	char					*pExpectedImage;
+	unsigned long			ExpectedImageLength;
+	char					*pExtension;
+	unsigned short			BitsAllocated;
+	FILE					*pOutputImageFile;
+
+	pJpegImage = 0;
+	pExpectedImage = 0;
+	BitsAllocated = ( BitsStored <= 8 ) ? 8 : 16;
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "JpegLossless\\%s", pVectorFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pJpegImage, &JpegImageLength );
+	if ( bNoError && ( ExpectedDecoder == DECODED_BY_LOSSLESS_DECODER || ExpectedDecoder == DECODED_BY_JPEG_LIBRARY ) )
+		{
+		pExtension = strrchr( RelativeFileSpec, '.' );
+		if ( pExtension != 0 )
+			strncpy_s( pExtension, MAX_FILE_SPEC_LENGTH - ( pExtension - RelativeFileSpec ), ".raw", _TRUNCATE );
+		bNoError = ReadTestDataFile( RelativeFileSpec, &pExpectedImage, &ExpectedImageLength );
+		}
+	if ( bNoError )
+		{
+		memset( &DicomHeader, 0, sizeof(DICOM_HEADER_SUMMARY) );
+		DicomHeader.Modality = "CR";
+		DicomHeader.ImageColumns = &Columns;
+		DicomHeader.ImageRows = &Rows;
+		DicomHeader.BitsAllocated = &BitsAllocated;
+		DicomHeader.BitsStored = &BitsStored;
+		DicomHeader.CalibrationInfo.BitsAllocated = BitsAllocated;
+		DicomHeader.CalibrationInfo.BitsStored = BitsStored;
+		DicomHeader.FileDecodingPlan.ImageDataTransferSyntax = COMPRESSED_LOSSLESS;
+		DicomHeader.FileDecodingPlan.nTransferSyntaxIndex = JPEG_PROCESS_14_TRANSFER_SYNTAX;
+		DicomHeader.pImageData = pJpegImage;
+		DicomHeader.ImageLengthInBytes = JpegImageLength;
+		// The lossless decoder must accept exactly the images it is expected to decode.
+		bNoError = ( LosslessJpegImageCanBeDecoded( &DicomHeader ) ==
+						( ExpectedDecoder == DECODED_BY_LOSSLESS_DECODER || ExpectedDecoder == DECODED_AFTER_FALLBACK ) );
+		}
+	// A damaged image accepted by the lossless decoder must then be refused by it.
+	if ( bNoError && ExpectedDecoder == DECODED_AFTER_FALLBACK )
+		{
+		pOutputImageFile = fopen( TEST_OUTPUT_FILE_SPEC, "wb" );
+		bNoError = ( pOutputImageFile != 0 );
+		if ( bNoError )
+			{
+			bNoError = !ConvertLosslessJpegImageToPNGFile( &DicomHeader, pOutputImageFile );
+			fclose( pOutputImageFile );
+			}
+		remove( TEST_OUTPUT_FILE_SPEC );
+		}
+	if ( bNoError )
+		{
+		bImageWasConverted = OutputPNGImage( TEST_OUTPUT_FILE_SPEC, &DicomHeader );
+		if ( ExpectedDecoder == NOT_DECODED )
+			bNoError = !bImageWasConverted;
+		else
+			bNoError = bImageWasConverted &&
+							CheckOutputPNGImage( TEST_OUTPUT_FILE_SPEC, Columns, Rows, BitsStored, pExpectedImage, ExpectedImageLength );
+		remove( TEST_OUTPUT_FILE_SPEC );
+		}
+	switch ( ExpectedDecoder )
+		{
+		case DECODED_BY_LOSSLESS_DECODER:
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s is decoded exactly by the lossless decoder.", pVectorFileName );
+			break;
+		case DECODED_BY_JPEG_LIBRARY:
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s is decoded exactly by the JPEG library.", pVectorFileName );
+			break;
+		case DECODED_AFTER_FALLBACK:
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s is decoded by the JPEG library after the lossless decoder fails.", pVectorFileName );
+			break;
+		default:
+			_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "%s is rejected.", pVectorFileName );
+			break;
+		}
+	CheckTestResult( bNoError, TestDescription );
+	if ( pJpegImage != 0 )
+		free( pJpegImage );
+	if ( pExpectedImage != 0 )
+		free( pExpectedImage );
+}
+
+
+// An image cut short must not crash the lossless decoder, and the decoder must not read
+// beyond the end of the image data.  Each copy is allocated at its exact length, so that a
+// debug heap or address sanitizer can detect any overrun.
+static void TestTruncatedLosslessJpegImages( char *pVectorFileName, unsigned short Columns, unsigned short Rows, unsigned short BitsStored )
+{
+	BOOL					bNoError = TRUE;
+	DICOM_HEADER_SUMMARY	DicomHeader;
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					*pJpegImage;
+	char					*pTruncatedImage;
+	unsigned long			JpegImageLength;
+	unsigned long			TruncatedLength;
+	unsigned short			BitsAllocated = 16;
+	FILE					*pOutputImageFile;
+
+	pTruncatedImage = 0;
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "JpegLossless\\%s", pVectorFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pJpegImage, &JpegImageLength );
+	for ( TruncatedLength = 0; bNoError && TruncatedLength < JpegImageLength; TruncatedLength += 1 + TruncatedLength / 8 )
+		{
+		pTruncatedImage = (char*)malloc( TruncatedLength + 1 );
+		bNoError = ( pTruncatedImage != 0 );
+		if ( bNoError )
+			{
+			memcpy( pTruncatedImage, pJpegImage, TruncatedLength );
+			memset( &DicomHeader, 0, sizeof(DICOM_HEADER_SUMMARY) );
+			DicomHeader.Modality = "CR";
+			DicomHeader.ImageColumns = &Columns;
+			DicomHeader.ImageRows = &Rows;
+			DicomHeader.BitsAllocated = &BitsAllocated;
+			DicomHeader.BitsStored = &BitsStored;
+			DicomHeader.pImageData = pTruncatedImage;
+			DicomHeader.ImageLengthInBytes = TruncatedLength;
+			if ( LosslessJpegImageCanBeDecoded( &DicomHeader ) )
+				{
+				pOutputImageFile = fopen( TEST_OUTPUT_FILE_SPEC, "wb" );
+				bNoError = ( pOutputImageFile != 0 );
+				if ( bNoError )
+					{
+					ConvertLosslessJpegImageToPNGFile( &DicomHeader, pOutputImageFile );
+					fclose( pOutputImageFile );
+					}
+				remove( TEST_OUTPUT_FILE_SPEC );
+				}
+			free( pTruncatedImage );
+			}
+		}
+	CheckTestResult( bNoError, "Truncated lossless JPEG images are handled." );
+	if ( pJpegImage != 0 )
+		free( pJpegImage );
+}
+
+
+void TestLosslessJpegDecoder()
+{
+	BOOL				bNoError = TRUE;
+	FILE				*pManifestFile;
+	char				ManifestFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char				TextLine[ 256 ];
+	char				VectorFileName[ 64 ];
+	char				Decoder[ 16 ];
+	int					Columns;
+	int					Rows;
+	int					BitsStored;
+	long				ExpectedDecoder;
+	long				nVectors;
+
+	nVectors = 0;
+	GetTestDataFileSpec( "JpegLossless\\LosslessJpegVectors.txt", ManifestFileSpec, MAX_FILE_SPEC_LENGTH );
+	pManifestFile = fopen( ManifestFileSpec, "rt" );
+	bNoError = ( pManifestFile != 0 );
+	while ( bNoError && fgets( TextLine, 256, pManifestFile ) != 0 )
+		{
+		if ( TextLine[ 0 ] != '#' && sscanf( TextLine, "%63s %d %d %d %15s", VectorFileName, &Columns, &Rows, &BitsStored, Decoder ) == 5 )
+			{
+			if ( strcmp( Decoder, "FAST" ) == 0 )
+				ExpectedDecoder = DECODED_BY_LOSSLESS_DECODER;
+			else if ( strcmp( Decoder, "LIBRARY" ) == 0 )
+				ExpectedDecoder = DECODED_BY_JPEG_LIBRARY;
+			else if ( strcmp( Decoder, "FALLBACK" ) == 0 )
+				ExpectedDecoder = DECODED_AFTER_FALLBACK;
+			else
+				ExpectedDecoder = NOT_DECODED;
+			TestLosslessJpegVector( VectorFileName, (unsigned short)Columns, (unsigned short)Rows, (unsigned short)BitsStored, ExpectedDecoder );
+			nVectors++;
+			}
+		}
+	if ( pManifestFile != 0 )
+		fclose( pManifestFile );
+	CheckTestResult( bNoError && nVectors > 0, "The lossless JPEG test vectors are listed." );
+	TestTruncatedLosslessJpegImages( "Gray12Restart.jpg", 67, 45, 12 );
+	TestTruncatedLosslessJpegImages( "Gray16LongCodes.jpg", 67, 45, 16 );
+}
+
@@ -0,0 +1,246 @@
+// TestOperationWakeup.cpp : Implements the tests of the operation wakeups in Operation.cpp,
+//	using a stand-in for the product queue of ProductDispatcher.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "BRetrieverTest.h"
+
+
+// The stand-in queue holds only the time at which each item was queued.  The stand-in operation
+// takes the items off it in the loop of ProcessProductQueueThreadFunction(), going straight on
+// to the next item while there is one, and otherwise entering its cycle wait interval.
+#define STAND_IN_QUEUE_SIZE					200
+#define STAND_IN_CYCLE_INTERVAL				1			// Seconds, the fallback heartbeat.
+#define WAKEUP_LATENCY_LIMIT				100			// Milliseconds from queuing to processing.
+
+extern PRODUCT_OPERATION		*pPrimaryOperationList;
+
+static ULONGLONG				StandInQueueTimes[ STAND_IN_QUEUE_SIZE ];
+static volatile LONG			nStandInItemsQueued = 0;
+static volatile LONG			nStandInItemsProcessed = 0;
+static volatile LONG			nIdleWakeups = 0;
+static ULONGLONG				TotalLatency = 0;
+static ULONGLONG				MaximumLatency = 0;
+
+
+static unsigned __stdcall StandInQueueThreadFunction( VOID *pOperationStruct )
+{
+	PRODUCT_OPERATION			*pProductOperation;
+	BOOL						bTerminateOperation = FALSE;
+	BOOL						bItemWasProcessed;
+	ULONGLONG					Latency;
+
+	pProductOperation = (PRODUCT_OPERATION*)pOperationStruct;
+	while ( !bTerminateOperation )
+		{
+		bItemWasProcessed = ( nStandInItemsProcessed < nStandInItemsQueued );
+		if ( bItemWasProcessed )
+			{
+			Latency = GetTickCount64() - StandInQueueTimes[ nStandInItemsProcessed ];
+			TotalLatency += Latency;
+			if ( Latency > MaximumLatency )
+				MaximumLatency = Latency;
+			InterlockedIncrement( &nStandInItemsProcessed );
+			}
+		else
+			InterlockedIncrement( &nIdleWakeups );
+		if ( bItemWasProcessed )
+			bTerminateOperation = CheckForOperationTerminationRequest( pProductOperation );
+		else
+			EnterOperationCycleWaitInterval( pProductOperation, TRUE, &bTerminateOperation );
+		}
+	CloseOperation( pProductOperation );
+
+	return 0;
+}
+
+
+// Queue an item, and optionally wake the operation as QueueProductForTransfer() does.
+static void QueueStandInItem( BOOL bWakeOperation )
+{
+	if ( nStandInItemsQueued < STAND_IN_QUEUE_SIZE )
+		{
+		StandInQueueTimes[ nStandInItemsQueued ] = GetTickCount64();
+		InterlockedIncrement( &nStandInItemsQueued );
+		if ( bWakeOperation )
+			WakeOperationsOfType( OPERATION_TYPE_DISPATCH_FROM_QUEUE );
+		}
+}
+
+
+static BOOL WaitForStandInQueueToEmpty( DWORD Timeout )
+{
+	ULONGLONG		StartTime;
+
+	StartTime = GetTickCount64();
+	while ( nStandInItemsProcessed < nStandInItemsQueued && GetTickCount64() - StartTime < Timeout )
+		Sleep( 5 );
+
+	return ( nStandInItemsProcessed == nStandInItemsQueued );
+}
+
+
+static void ResetLatencies()
+{
+	TotalLatency = 0;
+	MaximumLatency = 0;
+}
+
+
+static PRODUCT_OPERATION *LaunchStandInOperation()
+{
+	PRODUCT_OPERATION	*pProductOperation;
+
+	pProductOperation = CreateProductOperation();
+	if ( pProductOperation != 0 )
+		{
+		strncpy_s( pProductOperation -> OperationName, MAX_CFG_STRING_LENGTH, "Stand-in Queue", _TRUNCATE );
+		pProductOperation -> OperationType = OPERATION_TYPE_DISPATCH_FROM_QUEUE;
+		pProductOperation -> OperationTimeInterval = STAND_IN_CYCLE_INTERVAL;
+		pProductOperation -> bEnabled = TRUE;
+		pProductOperation -> OpnState.ThreadFunction = StandInQueueThreadFunction;
+		pPrimaryOperationList = pProductOperation;
+		if ( !LaunchOperation( pProductOperation ) )
+			{
+			pPrimaryOperationList = 0;
+			DeleteProductOperation( pProductOperation );
+			pProductOperation = 0;
+			}
+		}
+
+	return pProductOperation;
+}
+
+
+// Without a wakeup, a queued item waits for the rest of the operation's cycle interval.
+static void TestLatencyWithoutWakeup()
+{
+	BOOL			bNoError = TRUE;
+	int				nItem;
+
+	ResetLatencies();
+	for ( nItem = 0; nItem < 4; nItem++ )
+		{
+		QueueStandInItem( FALSE );
+		Sleep( 330 );
+		}
+	bNoError = WaitForStandInQueueToEmpty( 3000 * STAND_IN_CYCLE_INTERVAL );
+	printf( "    Without a wakeup, 4 items waited %lu ms on average, and up to %lu ms, with a %d s cycle interval.\n",
+				(unsigned long)( TotalLatency / 4 ), (unsigned long)MaximumLatency, STAND_IN_CYCLE_INTERVAL );
+	CheckTestResult( bNoError, "The cycle interval processes the items queued without a wakeup." );
+}
+
+
+// With a wakeup, an item is processed as soon as it is queued.
+static void TestLatencyWithWakeup()
+{
+	BOOL			bNoError = TRUE;
+	int				nItem;
+
+	ResetLatencies();
+	for ( nItem = 0; nItem < 20; nItem++ )
+		{
+		QueueStandInItem( TRUE );
+		Sleep( 50 );
+		}
+	bNoError = WaitForStandInQueueToEmpty( 3000 * STAND_IN_CYCLE_INTERVAL );
+	printf( "    With a wakeup, 20 items waited %lu ms on average, and up to %lu ms.\n",
+				(unsigned long)( TotalLatency / 20 ), (unsigned long)MaximumLatency );
+	CheckTestResult( bNoError && MaximumLatency < WAKEUP_LATENCY_LIMIT, "A queued item is processed without waiting for the cycle interval." );
+}
+
+
+// A burst of items is processed back to back, within one cycle interval.
+static void TestQueuedBurst()
+{
+	BOOL			bNoError = TRUE;
+	int				nItem;
+	ULONGLONG		StartTime;
+	ULONGLONG		ElapsedTime;
+
+	ResetLatencies();
+	StartTime = GetTickCount64();
+	for ( nItem = 0; nItem < 100; nItem++ )
+		QueueStandInItem( TRUE );
+	bNoError = WaitForStandInQueueToEmpty( 3000 * STAND_IN_CYCLE_INTERVAL );
+	ElapsedTime = GetTickCount64() - StartTime;
+	printf( "    A burst of 100 items was processed in %lu ms.\n", (unsigned long)ElapsedTime );
+	CheckTestResult( bNoError && MaximumLatency < WAKEUP_LATENCY_LIMIT, "A burst of queued items is processed back to back." );
+}
+
+
+// With nothing queued, the operation wakes only for its cycle interval.  Any number of
+// wakeups received during a wait result in a single extra cycle.
+static void TestIdleWakeups()
+{
+	LONG			nIdleWakeupsBefore;
+	LONG			nIdleWakeupsDuringWait;
+	int				nWakeup;
+
+	Sleep( 100 );
+	nIdleWakeupsBefore = nIdleWakeups;
+	Sleep( 5000 );
+	nIdleWakeupsDuringWait = nIdleWakeups - nIdleWakeupsBefore;
+	printf( "    While idle, the operation woke %ld times per minute, with a %d s cycle interval.\n",
+				nIdleWakeupsDuringWait * 12, STAND_IN_CYCLE_INTERVAL );
+	CheckTestResult( nIdleWakeupsDuringWait >= 4 && nIdleWakeupsDuringWait <= 6, "An idle operation wakes only for its cycle interval." );
+
+	nIdleWakeupsBefore = nIdleWakeups;
+	for ( nWakeup = 0; nWakeup < 50; nWakeup++ )
+		WakeOperationsOfType( OPERATION_TYPE_DISPATCH_FROM_QUEUE );
+	Sleep( 100 );
+	CheckTestResult( nIdleWakeups - nIdleWakeupsBefore <= 2, "Repeated wakeups are coalesced." );
+}
+
+
+// TerminateAllOperations() cuts short the cycle wait interval of the operation.
+static void TestOperationTermination( PRODUCT_OPERATION *pProductOperation )
+{
+	TerminateAllOperations();
+	CheckTestResult( ( pProductOperation -> OpnState.StatusCode & OPERATION_STATUS_RUNNING ) == 0, "The operation terminates when requested." );
+}
+
+
+void TestOperationWakeup()
+{
+	PRODUCT_OPERATION	*pProductOperation;
+
+	InitProductOperationsModule();
+	pProductOperation = LaunchStandInOperation();
+	CheckTestResult( pProductOperation != 0, "The stand-in queue operation is launched." );
+	if ( pProductOperation != 0 )
+		{
+		TestLatencyWithoutWakeup();
+		TestLatencyWithWakeup();
+		TestQueuedBurst();
+		TestIdleWakeups();
+		TestOperationTermination( pProductOperation );
+		pPrimaryOperationList = 0;
+		DeleteProductOperation( pProductOperation );
+		}
+	CloseProductOperationsModule();
+}
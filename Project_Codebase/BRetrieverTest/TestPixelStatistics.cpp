@@ -0,0 +1,397 @@
+// TestPixelStatistics.cpp : Implements the tests of the pixel statistics that ExamReformat.cpp
+//	records in the PNG image files.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "ProductDispatcher.h"
+#include "ExamReformat.h"
+#include "BRetrieverTest.h"
+
+#pragma pack(push)
+#pragma pack(8)		// Pack structure members on 8-byte boundaries for faster access.
+
+extern "C"
+{
+#include "png.h"
+}
+
+#pragma pack(pop)
+
+
+// The pixel statistics are accumulated by ExamReformat.cpp as each image is written to its
+// PNG file, and recorded in the private chunk described in Calibration.h.  These tests write
+// PNG images the way the image converters do, and compare the recorded chunk with the
+// statistics computed directly from the pixel values.
+
+typedef struct
+	{
+	BOOL					bChunkFound;
+	unsigned short			Version;
+	unsigned short			PixelBitsSet;
+	unsigned long			nPixelsCounted;
+	unsigned short			MinPixelValue;
+	unsigned short			MaxPixelValue;
+	unsigned __int64		PixelValueSum;
+	} TEST_PIXEL_STATISTICS;
+
+
+static int PNGAPI ReadTestPixelStatisticsChunk( png_structp pPngConfig, png_unknown_chunkp pChunk )
+{
+	TEST_PIXEL_STATISTICS	*pStatistics;
+	int						bChunkWasHandled = 0;
+
+	pStatistics = (TEST_PIXEL_STATISTICS*)png_get_user_chunk_ptr( pPngConfig );
+	if ( memcmp( pChunk -> name, IMAGE_PIXEL_STATISTICS_CHUNK_NAME, 4 ) == 0 )
+		{
+		bChunkWasHandled = 1;
+		if ( pChunk -> size == IMAGE_PIXEL_STATISTICS_CHUNK_LENGTH )
+			{
+			pStatistics -> bChunkFound = TRUE;
+			pStatistics -> Version = png_get_uint_16( &pChunk -> data[ 0 ] );
+			pStatistics -> PixelBitsSet = png_get_uint_16( &pChunk -> data[ 2 ] );
+			pStatistics -> nPixelsCounted = png_get_uint_32( &pChunk -> data[ 4 ] );
+			pStatistics -> MinPixelValue = png_get_uint_16( &pChunk -> data[ 8 ] );
+			pStatistics -> MaxPixelValue = png_get_uint_16( &pChunk -> data[ 10 ] );
+			pStatistics -> PixelValueSum = ( (unsigned __int64)png_get_uint_32( &pChunk -> data[ 12 ] ) << 32 ) |
+												(unsigned __int64)png_get_uint_32( &pChunk -> data[ 16 ] );
+			}
+		}
+
+	return bChunkWasHandled;
+}
+
+
+// Read the PNG image beginning at ImageOffset in the file, and the pixel statistics chunk
+// following its image data, if there is one.
+static BOOL ReadRecordedPixelStatistics( char *pImageFileSpec, long ImageOffset, TEST_PIXEL_STATISTICS *pStatistics )
+{
+	BOOL					bNoError = TRUE;
+	FILE					*pImageFile;
+	png_struct				*pPngConfig;
+	png_info				*pPngImageInfo;
+	png_byte				*pRow;
+	png_uint_32				nRow;
+
+	memset( pStatistics, 0, sizeof(TEST_PIXEL_STATISTICS) );
+	pPngConfig = 0;
+	pPngImageInfo = 0;
+	pRow = 0;
+	pImageFile = fopen( pImageFileSpec, "rb" );
+	bNoError = ( pImageFile != 0 && fseek( pImageFile, ImageOffset, SEEK_SET ) == 0 );
+	if ( bNoError )
+		{
+		pPngConfig = png_create_read_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+		bNoError = ( pPngConfig != 0 );
+		}
+	if ( bNoError )
+		{
+		pPngImageInfo = png_create_info_struct( pPngConfig );
+		bNoError = ( pPngImageInfo != 0 );
+		}
+	if ( bNoError && setjmp( png_jmpbuf( pPngConfig ) ) )
+		bNoError = FALSE;
+	if ( bNoError )
+		{
+		png_init_io( pPngConfig, pImageFile );
+		png_set_read_user_chunk_fn( pPngConfig, pStatistics, ReadTestPixelStatisticsChunk );
+		png_read_info( pPngConfig, pPngImageInfo );
+		pRow = (png_byte*)malloc( png_get_rowbytes( pPngConfig, pPngImageInfo ) );
+		bNoError = ( pRow != 0 );
+		}
+	if ( bNoError )
+		{
+		for ( nRow = 0; nRow < png_get_image_height( pPngConfig, pPngImageInfo ); nRow++ )
+			png_read_row( pPngConfig, pRow, NULL );
+		png_read_end( pPngConfig, NULL );
+		}
+	if ( pPngConfig != 0 )
+		png_destroy_read_struct( &pPngConfig, ( pPngImageInfo != 0 ) ? &pPngImageInfo : png_infopp_NULL, png_infopp_NULL );
+	if ( pRow != 0 )
+		free( pRow );
+	if ( pImageFile != 0 )
+		fclose( pImageFile );
+
+	return bNoError;
+}
+
+
+static void ComputeExpectedPixelStatistics( unsigned short *pPixelValues, unsigned long nPixels, TEST_PIXEL_STATISTICS *pStatistics )
+{
+	unsigned long			nPixel;
+
+	memset( pStatistics, 0, sizeof(TEST_PIXEL_STATISTICS) );
+	pStatistics -> bChunkFound = TRUE;
+	pStatistics -> Version = IMAGE_PIXEL_STATISTICS_CHUNK_VERSION;
+	pStatistics -> nPixelsCounted = nPixels;
+	pStatistics -> MinPixelValue = 0xffff;
+	for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+		{
+		if ( pPixelValues[ nPixel ] < pStatistics -> MinPixelValue )
+			pStatistics -> MinPixelValue = pPixelValues[ nPixel ];
+		if ( pPixelValues[ nPixel ] > pStatistics -> MaxPixelValue )
+			pStatistics -> MaxPixelValue = pPixelValues[ nPixel ];
+		pStatistics -> PixelBitsSet |= pPixelValues[ nPixel ];
+		pStatistics -> PixelValueSum += pPixelValues[ nPixel ];
+		}
+}
+
+
+static BOOL PixelStatisticsMatch( TEST_PIXEL_STATISTICS *pRecordedStatistics, TEST_PIXEL_STATISTICS *pExpectedStatistics )
+{
+	return ( pRecordedStatistics -> bChunkFound == pExpectedStatistics -> bChunkFound &&
+				pRecordedStatistics -> Version == pExpectedStatistics -> Version &&
+				pRecordedStatistics -> nPixelsCounted == pExpectedStatistics -> nPixelsCounted &&
+				pRecordedStatistics -> MinPixelValue == pExpectedStatistics -> MinPixelValue &&
+				pRecordedStatistics -> MaxPixelValue == pExpectedStatistics -> MaxPixelValue &&
+				pRecordedStatistics -> PixelBitsSet == pExpectedStatistics -> PixelBitsSet &&
+				pRecordedStatistics -> PixelValueSum == pExpectedStatistics -> PixelValueSum );
+}
+
+
+// Write a grayscale or color PNG image the way the image converters do.  The 16-bit pixel
+// values are supplied in the little-endian byte order and swapped by libpng, as for most
+// images, or supplied in the PNG byte order, as for NM images.
+#define SUPPLY_LITTLE_ENDIAN_PIXELS		1
+#define SUPPLY_BIG_ENDIAN_PIXELS		2
+
+static BOOL WriteTestPNGImage( unsigned short *pPixelValues, unsigned long nColumns, unsigned long nRows, int BitDepth,
+								int ColorType, long PixelByteOrder, BOOL bCollectStatistics )
+{
+	BOOL					bNoError = TRUE;
+	FILE					*pImageFile;
+	png_struct				*pPngConfig;
+	png_info				*pPngImageInfo;
+	png_byte				*pRow;
+	unsigned long			nSamplesPerRow;
+	unsigned long			nRow;
+	unsigned long			nSample;
+	unsigned short			PixelValue;
+
+	pPngConfig = 0;
+	pPngImageInfo = 0;
+	nSamplesPerRow = ( ColorType == PNG_COLOR_TYPE_RGB ) ? 3 * nColumns : nColumns;
+	pRow = (png_byte*)malloc( nSamplesPerRow * 2 );
+	pImageFile = fopen( TEST_OUTPUT_FILE_SPEC, "wb" );
+	bNoError = ( pRow != 0 && pImageFile != 0 );
+	if ( bNoError )
+		{
+		pPngConfig = png_create_write_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+		bNoError = ( pPngConfig != 0 );
+		}
+	if ( bNoError )
+		{
+		pPngImageInfo = png_create_info_struct( pPngConfig );
+		bNoError = ( pPngImageInfo != 0 );
+		}
+	if ( bNoError && setjmp( png_jmpbuf( pPngConfig ) ) )
+		bNoError = FALSE;
+	if ( bNoError )
+		{
+		png_init_io( pPngConfig, pImageFile );
+		png_set_IHDR( pPngConfig, pPngImageInfo, nColumns, nRows, BitDepth, ColorType,
+						PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE );
+		png_write_info( pPngConfig, pPngImageInfo );
+		if ( BitDepth == 16 && PixelByteOrder == SUPPLY_LITTLE_ENDIAN_PIXELS )
+			png_set_swap( pPngConfig );
+		if ( bCollectStatistics )
+			CollectImagePixelStatistics( pPngConfig, ( PixelByteOrder == SUPPLY_LITTLE_ENDIAN_PIXELS ) );
+		for ( nRow = 0; nRow < nRows; nRow++ )
+			{
+			for ( nSample = 0; nSample < nSamplesPerRow; nSample++ )
+				{
+				PixelValue = pPixelValues[ nRow * nSamplesPerRow + nSample ];
+				if ( BitDepth == 8 )
+					pRow[ nSample ] = (png_byte)PixelValue;
+				else if ( PixelByteOrder == SUPPLY_LITTLE_ENDIAN_PIXELS )
+					{
+					pRow[ 2 * nSample ] = (png_byte)( PixelValue & 0xff );
+					pRow[ 2 * nSample + 1 ] = (png_byte)( PixelValue >> 8 );
+					}
+				else
+					{
+					pRow[ 2 * nSample ] = (png_byte)( PixelValue >> 8 );
+					pRow[ 2 * nSample + 1 ] = (png_byte)( PixelValue & 0xff );
+					}
+				}
+			png_write_row( pPngConfig, pRow );
+			}
+		WriteImagePixelStatisticsChunk( pPngConfig );
+		png_write_end( pPngConfig, pPngImageInfo );
+		}
+	if ( pPngConfig != 0 )
+		png_destroy_write_struct( &pPngConfig, ( pPngImageInfo != 0 ) ? &pPngImageInfo : png_infopp_NULL );
+	if ( pImageFile != 0 )
+		fclose( pImageFile );
+	if ( pRow != 0 )
+		free( pRow );
+
+	return bNoError;
+}
+
+
+static void TestGrayscaleImageStatistics( char *pTestDescription, unsigned long nColumns, unsigned long nRows, int BitDepth,
+											long PixelByteOrder, unsigned short BaseValue, unsigned short NoiseRange )
+{
+	BOOL					bNoError = TRUE;
+	unsigned short			*pPixelValues;
+	unsigned long			nPixel;
+	unsigned long			RandomValue;
+	TEST_PIXEL_STATISTICS	ExpectedStatistics;
+	TEST_PIXEL_STATISTICS	RecordedStatistics;
+
+	pPixelValues = (unsigned short*)malloc( nColumns * nRows * sizeof(unsigned short) );
+	bNoError = ( pPixelValues != 0 );
+	if ( bNoError )
+		{
+		// Fill the image with noise above the base value, from a fixed linear congruential sequence.
+		RandomValue = 12345;
+		for ( nPixel = 0; nPixel < nColumns * nRows; nPixel++ )
+			{
+			RandomValue = RandomValue * 1103515245 + 12345;
+			pPixelValues[ nPixel ] = (unsigned short)( BaseValue + ( ( RandomValue >> 16 ) & 0x7fff ) % ( (unsigned long)NoiseRange + 1 ) );
+			}
+		ComputeExpectedPixelStatistics( pPixelValues, nColumns * nRows, &ExpectedStatistics );
+		bNoError = WriteTestPNGImage( pPixelValues, nColumns, nRows, BitDepth, PNG_COLOR_TYPE_GRAY, PixelByteOrder, TRUE );
+		}
+	if ( bNoError )
+		bNoError = ReadRecordedPixelStatistics( TEST_OUTPUT_FILE_SPEC, 0, &RecordedStatistics );
+	if ( bNoError )
+		bNoError = PixelStatisticsMatch( &RecordedStatistics, &ExpectedStatistics );
+	remove( TEST_OUTPUT_FILE_SPEC );
+	if ( pPixelValues != 0 )
+		free( pPixelValues );
+	CheckTestResult( bNoError, pTestDescription );
+}
+
+
+// No statistics chunk may be recorded for a color image, or for an image for which the
+// statistics weren't collected.
+static void TestImagesWithoutStatistics()
+{
+	BOOL					bNoError = TRUE;
+	unsigned short			PixelValues[ 3 * 16 * 8 ];
+	unsigned long			nSample;
+	TEST_PIXEL_STATISTICS	RecordedStatistics;
+
+	for ( nSample = 0; nSample < 3 * 16 * 8; nSample++ )
+		PixelValues[ nSample ] = (unsigned short)( nSample & 0xff );
+	bNoError = WriteTestPNGImage( PixelValues, 16, 8, 8, PNG_COLOR_TYPE_RGB, SUPPLY_BIG_ENDIAN_PIXELS, TRUE );
+	if ( bNoError )
+		bNoError = ReadRecordedPixelStatistics( TEST_OUTPUT_FILE_SPEC, 0, &RecordedStatistics );
+	CheckTestResult( bNoError && !RecordedStatistics.bChunkFound, "No pixel statistics are recorded for a color image." );
+	bNoError = WriteTestPNGImage( PixelValues, 16, 8, 8, PNG_COLOR_TYPE_GRAY, SUPPLY_BIG_ENDIAN_PIXELS, FALSE );
+	if ( bNoError )
+		bNoError = ReadRecordedPixelStatistics( TEST_OUTPUT_FILE_SPEC, 0, &RecordedStatistics );
+	CheckTestResult( bNoError && !RecordedStatistics.bChunkFound, "No pixel statistics are recorded unless they were collected." );
+	remove( TEST_OUTPUT_FILE_SPEC );
+}
+
+
+// The image converters must record the statistics of the decoded image.  The PNG image
+// follows the calibration data in the converted image file.
+static void TestConvertedImageStatistics( char *pVectorFileName, unsigned short Columns, unsigned short Rows, unsigned short BitsStored )
+{
+	BOOL					bNoError = TRUE;
+	DICOM_HEADER_SUMMARY	DicomHeader;
+	char					RelativeFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					TestDescription[ MAX_FILE_SPEC_LENGTH ];
+	char					*pJpegImage;
+	unsigned long			JpegImageLength;
+	char					*pExpectedImage;
+	unsigned long			ExpectedImageLength;
+	unsigned short			*pPixelValues;
+	unsigned long			nPixel;
+	char					*pExtension;
+	unsigned short			BitsAllocated = 16;
+	TEST_PIXEL_STATISTICS	ExpectedStatistics;
+	TEST_PIXEL_STATISTICS	RecordedStatistics;
+
+	pExpectedImage = 0;
+	pPixelValues = 0;
+	_snprintf_s( RelativeFileSpec, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "JpegLossless\\%s", pVectorFileName );
+	bNoError = ReadTestDataFile( RelativeFileSpec, &pJpegImage, &JpegImageLength );
+	if ( bNoError )
+		{
+		pExtension = strrchr( RelativeFileSpec, '.' );
+		if ( pExtension != 0 )
+			strncpy_s( pExtension, MAX_FILE_SPEC_LENGTH - ( pExtension - RelativeFileSpec ), ".raw", _TRUNCATE );
+		bNoError = ReadTestDataFile( RelativeFileSpec, &pExpectedImage, &ExpectedImageLength );
+		}
+	if ( bNoError )
+		{
+		pPixelValues = (unsigned short*)malloc( Columns * Rows * sizeof(unsigned short) );
+		bNoError = ( pPixelValues != 0 && ExpectedImageLength == (unsigned long)Columns * Rows * 2 );
+		}
+	if ( bNoError )
+		{
+		for ( nPixel = 0; nPixel < (unsigned long)Columns * Rows; nPixel++ )
+			pPixelValues[ nPixel ] = (unsigned short)( (unsigned char)pExpectedImage[ 2 * nPixel ] |
+										( (unsigned char)pExpectedImage[ 2 * nPixel + 1 ] << 8 ) );
+		ComputeExpectedPixelStatistics( pPixelValues, Columns * Rows, &ExpectedStatistics );
+		memset( &DicomHeader, 0, sizeof(DICOM_HEADER_SUMMARY) );
+		DicomHeader.Modality = "DX";
+		DicomHeader.ImageColumns = &Columns;
+		DicomHeader.ImageRows = &Rows;
+		DicomHeader.BitsAllocated = &BitsAllocated;
+		DicomHeader.BitsStored = &BitsStored;
+		DicomHeader.CalibrationInfo.BitsAllocated = BitsAllocated;
+		DicomHeader.CalibrationInfo.BitsStored = BitsStored;
+		DicomHeader.FileDecodingPlan.ImageDataTransferSyntax = COMPRESSED_LOSSLESS;
+		DicomHeader.FileDecodingPlan.nTransferSyntaxIndex = JPEG_PROCESS_14_TRANSFER_SYNTAX;
+		DicomHeader.pImageData = pJpegImage;
+		DicomHeader.ImageLengthInBytes = JpegImageLength;
+		bNoError = OutputPNGImage( TEST_OUTPUT_FILE_SPEC, &DicomHeader );
+		}
+	if ( bNoError )
+		bNoError = ReadRecordedPixelStatistics( TEST_OUTPUT_FILE_SPEC, sizeof(IMAGE_CALIBRATION_INFO), &RecordedStatistics );
+	if ( bNoError )
+		bNoError = PixelStatisticsMatch( &RecordedStatistics, &ExpectedStatistics );
+	remove( TEST_OUTPUT_FILE_SPEC );
+	_snprintf_s( TestDescription, MAX_FILE_SPEC_LENGTH, _TRUNCATE, "The pixel statistics of %s are recorded.", pVectorFileName );
+	CheckTestResult( bNoError, TestDescription );
+	if ( pJpegImage != 0 )
+		free( pJpegImage );
+	if ( pExpectedImage != 0 )
+		free( pExpectedImage );
+	if ( pPixelValues != 0 )
+		free( pPixelValues );
+}
+
+
+void TestPixelStatistics()
+{
+	TestGrayscaleImageStatistics( "The pixel statistics of an 8-bit image are recorded.", 61, 47, 8, SUPPLY_BIG_ENDIAN_PIXELS, 3, 250 );
+	TestGrayscaleImageStatistics( "The pixel statistics of a byte-swapped 16-bit image are recorded.", 67, 45, 16, SUPPLY_LITTLE_ENDIAN_PIXELS, 100, 4000 );
+	TestGrayscaleImageStatistics( "The pixel statistics of an unswapped 16-bit image are recorded.", 67, 45, 16, SUPPLY_BIG_ENDIAN_PIXELS, 100, 4000 );
+	// The pixel value sum of this image exceeds 32 bits.
+	TestGrayscaleImageStatistics( "The pixel value sum of a large 16-bit image is recorded in full.", 3000, 2500, 16, SUPPLY_LITTLE_ENDIAN_PIXELS, 60000, 5535 );
+	TestImagesWithoutStatistics();
+	TestConvertedImageStatistics( "Gray16.jpg", 67, 45, 16 );
+	TestConvertedImageStatistics( "Gray12Predictor7.jpg", 67, 45, 12 );
+}
+
@@ -0,0 +1,365 @@
+// TestProcessingMetrics.cpp : Implements the tests of the processing stage histograms and the
+//	metrics file written by ProcessingMetrics.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include <process.h>
+#include "Module.h"
+#include "ReportStatus.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Exam.h"
+#include "ExamReformat.h"
+#include "ProcessingMetrics.h"
+#include "BRetrieverTest.h"
+#include "FuzzDicomParser.h"
+
+
+#define PERCENTILE_TEST_SAMPLES				100000
+#define CONCURRENT_RECORDING_THREADS		4
+#define CONCURRENT_RECORDING_SAMPLES		250000
+#define OVERHEAD_TIMING_CALLS				1000000
+#define OVERHEAD_TIMING_IMAGES				200
+#define OVERHEAD_TIMING_EXPORTS				20
+#define MAXIMUM_METRICS_OVERHEAD			1.0			// Percent of the image processing time.
+
+static METRIC_HISTOGRAM			TestHistogram = { "test", "Test" };
+
+
+static void ClearTestHistogram()
+{
+	memset( (void*)&TestHistogram, 0, sizeof(METRIC_HISTOGRAM) );
+	TestHistogram.pLabel = "test";
+	TestHistogram.pDescription = "Test";
+}
+
+
+// Each percentile estimate must lie within the 25 percent bucket resolution above the exact
+// value, and the count, total and maximum must be exact.
+static void TestMetricPercentiles()
+{
+	BOOL				bNoError = TRUE;
+	ULONGLONG			Value;
+	ULONGLONG			ExactValue;
+	ULONGLONG			EstimatedValue;
+	double				Percentiles[] = { 1.0, 10.0, 50.0, 90.0, 99.0, 99.9, 100.0 };
+	int					nPercentile;
+	char				TestDescription[ 256 ];
+
+	ClearTestHistogram();
+	for ( Value = 1; Value <= PERCENTILE_TEST_SAMPLES; Value++ )
+		RecordMetricValue( &TestHistogram, Value );
+	CheckTestResult( TestHistogram.nSamples == PERCENTILE_TEST_SAMPLES &&
+						TestHistogram.Total == (LONGLONG)PERCENTILE_TEST_SAMPLES * ( PERCENTILE_TEST_SAMPLES + 1 ) / 2 &&
+						TestHistogram.MaxValue == PERCENTILE_TEST_SAMPLES,
+						"The histogram count, total and maximum are exact." );
+	for ( nPercentile = 0; nPercentile < sizeof(Percentiles) / sizeof(double); nPercentile++ )
+		{
+		ExactValue = (ULONGLONG)( Percentiles[ nPercentile ] * PERCENTILE_TEST_SAMPLES / 100.0 );
+		EstimatedValue = GetMetricPercentile( &TestHistogram, Percentiles[ nPercentile ] );
+		if ( EstimatedValue < ExactValue || (double)EstimatedValue > 1.25 * (double)ExactValue )
+			{
+			printf( "    The %g percentile was estimated as %llu, for an exact value of %llu.\n",
+							Percentiles[ nPercentile ], EstimatedValue, ExactValue );
+			bNoError = FALSE;
+			}
+		}
+	_snprintf_s( TestDescription, 256, _TRUNCATE, "The percentiles of 1 to %d are estimated within 25 percent.", PERCENTILE_TEST_SAMPLES );
+	CheckTestResult( bNoError, TestDescription );
+	ClearTestHistogram();
+	RecordMetricValue( &TestHistogram, 0 );
+	RecordMetricValue( &TestHistogram, 0xFFFFFFFFFFFFull );
+	CheckTestResult( GetMetricPercentile( &TestHistogram, 10.0 ) == 1 &&
+						GetMetricPercentile( &TestHistogram, 100.0 ) == 0xFFFFFFFFFFFFull,
+						"Zero and values beyond the last bucket are recorded." );
+}
+
+
+static unsigned __stdcall RecordingThreadFunction( VOID *pThreadNumber )
+{
+	ULONGLONG			nSample;
+
+	for ( nSample = 0; nSample < CONCURRENT_RECORDING_SAMPLES; nSample++ )
+		RecordMetricValue( &TestHistogram, nSample + (ULONGLONG)pThreadNumber );
+
+	return 0;
+}
+
+
+// Values recorded by several threads at once must none of them be lost.
+static void TestConcurrentRecording()
+{
+	HANDLE				hThreads[ CONCURRENT_RECORDING_THREADS ];
+	unsigned			ThreadID;
+	size_t				nThread;
+	LONGLONG			nExpectedSamples;
+	LONGLONG			ExpectedTotal;
+	LONGLONG			nBucketSamples;
+	int					nBucket;
+	BOOL				bThreadsStarted = TRUE;
+
+	ClearTestHistogram();
+	for ( nThread = 0; nThread < CONCURRENT_RECORDING_THREADS; nThread++ )
+		{
+		hThreads[ nThread ] = (HANDLE)_beginthreadex( NULL, 0, RecordingThreadFunction, (VOID*)nThread, 0, &ThreadID );
+		if ( hThreads[ nThread ] == 0 )
+			bThreadsStarted = FALSE;
+		}
+	for ( nThread = 0; nThread < CONCURRENT_RECORDING_THREADS; nThread++ )
+		if ( hThreads[ nThread ] != 0 )
+			{
+			WaitForSingleObject( hThreads[ nThread ], INFINITE );
+			CloseHandle( hThreads[ nThread ] );
+			}
+	nExpectedSamples = (LONGLONG)CONCURRENT_RECORDING_THREADS * CONCURRENT_RECORDING_SAMPLES;
+	ExpectedTotal = 0;
+	for ( nThread = 0; nThread < CONCURRENT_RECORDING_THREADS; nThread++ )
+		ExpectedTotal += (LONGLONG)CONCURRENT_RECORDING_SAMPLES * ( CONCURRENT_RECORDING_SAMPLES - 1 ) / 2 + (LONGLONG)CONCURRENT_RECORDING_SAMPLES * nThread;
+	nBucketSamples = 0;
+	for ( nBucket = 0; nBucket < METRIC_HISTOGRAM_BUCKETS; nBucket++ )
+		nBucketSamples += TestHistogram.BucketCounts[ nBucket ];
+	CheckTestResult( bThreadsStarted && TestHistogram.nSamples == nExpectedSamples && nBucketSamples == nExpectedSamples &&
+						TestHistogram.Total == ExpectedTotal &&
+						TestHistogram.MaxValue == CONCURRENT_RECORDING_SAMPLES + CONCURRENT_RECORDING_THREADS - 2,
+						"No values are lost when 4 threads record into a histogram at once." );
+}
+
+
+// Read the metrics file back, checking that each histogram's buckets are cumulative and end
+// with the +Inf bucket equal to its count.  Return the count of the named series.
+static BOOL CheckMetricsFile( char *pSeriesName, unsigned long *pSeriesCount, unsigned long *pQueueDepths, BOOL *pbQueueDepthsMatch )
+{
+	BOOL				bNoError = TRUE;
+	FILE				*pMetricsFile;
+	char				TextLine[ 256 ];
+	char				SeriesName[ 128 ];
+	char				PreviousSeriesName[ 128 ];
+	char				StatusLabel[ 64 ];
+	char				*pBrace;
+	char				*pBound;
+	unsigned long		Count;
+	unsigned long		PreviousCount;
+	unsigned long		InfinityCount;
+	unsigned long		nQueueDepthsFound;
+	int					nStatusMetric;
+	char				*StatusLabels[ NUMBER_OF_QUEUE_STATUS_METRICS ] =
+							{ "item_queued", "item_being_processed", "extraction_completed", "source_deletable",
+								"study", "receive_error", "image_extraction_error" };
+
+	*pSeriesCount = 0;
+	*pbQueueDepthsMatch = TRUE;
+	nQueueDepthsFound = 0;
+	PreviousSeriesName[ 0 ] = '\0';
+	PreviousCount = 0;
+	InfinityCount = 0;
+	pMetricsFile = fopen( TEST_METRICS_FILE_SPEC, "rt" );
+	bNoError = ( pMetricsFile != 0 );
+	while ( bNoError && fgets( TextLine, 256, pMetricsFile ) != 0 )
+		{
+		if ( TextLine[ 0 ] == '#' )
+			continue;
+		if ( strstr( TextLine, "_bucket{" ) != 0 )
+			{
+			// The series is named by everything before the le label.
+			pBound = strstr( TextLine, "le=\"" );
+			pBrace = strrchr( TextLine, '}' );
+			bNoError = ( pBound != 0 && pBrace != 0 && sscanf( pBrace + 1, "%lu", &Count ) == 1 );
+			if ( bNoError )
+				{
+				*pBound = '\0';
+				strncpy_s( SeriesName, 128, TextLine, _TRUNCATE );
+				if ( strcmp( SeriesName, PreviousSeriesName ) != 0 )
+					PreviousCount = 0;
+				bNoError = ( Count >= PreviousCount );
+				PreviousCount = Count;
+				strncpy_s( PreviousSeriesName, 128, SeriesName, _TRUNCATE );
+				if ( strncmp( pBound + 4, "+Inf", 4 ) == 0 )
+					InfinityCount = Count;
+				}
+			}
+		else if ( strstr( TextLine, "_count" ) != 0 )
+			{
+			pBrace = strchr( TextLine, ' ' );
+			bNoError = ( pBrace != 0 && sscanf( pBrace, "%lu", &Count ) == 1 && Count == InfinityCount );
+			if ( bNoError && strncmp( TextLine, pSeriesName, strlen( pSeriesName ) ) == 0 )
+				*pSeriesCount = Count;
+			}
+		else if ( sscanf( TextLine, "bretriever_product_queue_items{status=\"%63[a-z_]\"} %lu", StatusLabel, &Count ) == 2 )
+			{
+			for ( nStatusMetric = 0; nStatusMetric < NUMBER_OF_QUEUE_STATUS_METRICS; nStatusMetric++ )
+				if ( strcmp( StatusLabel, StatusLabels[ nStatusMetric ] ) == 0 )
+					{
+					nQueueDepthsFound++;
+					if ( Count != pQueueDepths[ nStatusMetric ] )
+						*pbQueueDepthsMatch = FALSE;
+					}
+			}
+		}
+	if ( pMetricsFile != 0 )
+		fclose( pMetricsFile );
+	if ( nQueueDepthsFound != NUMBER_OF_QUEUE_STATUS_METRICS )
+		*pbQueueDepthsMatch = FALSE;
+
+	return bNoError;
+}
+
+
+static void TestMetricsFileExport()
+{
+	BOOL				bNoError = TRUE;
+	LARGE_INTEGER		StageStartTime;
+	unsigned long		QueueDepths[ NUMBER_OF_QUEUE_STATUS_METRICS ];
+	unsigned long		nHeaderParseSamples;
+	BOOL				bQueueDepthsMatch;
+	FILE				*pTemporaryFile;
+	int					nSample;
+
+	InitProcessingMetrics();
+	for ( nSample = 0; nSample < 25; nSample++ )
+		{
+		QueryPerformanceCounter( &StageStartTime );
+		RecordProcessingStageTime( STAGE_HEADER_PARSE, &StageStartTime );
+		RecordProcessingStageTime( STAGE_IMAGE_REFORMAT, &StageStartTime );
+		}
+	RecordAssociationBytesReceived( 1048576 );
+	memset( QueueDepths, 0, sizeof(QueueDepths) );
+	TallyProductQueueStatus( PRODUCT_STATUS_ITEM_QUEUED, QueueDepths );
+	TallyProductQueueStatus( PRODUCT_STATUS_ITEM_QUEUED, QueueDepths );
+	TallyProductQueueStatus( PRODUCT_STATUS_ITEM_QUEUED | PRODUCT_STATUS_ITEM_BEING_PROCESSED, QueueDepths );
+	TallyProductQueueStatus( PRODUCT_STATUS_STUDY, QueueDepths );
+	CheckTestResult( QueueDepths[ 0 ] == 3 && QueueDepths[ 1 ] == 1 && QueueDepths[ 4 ] == 1 && QueueDepths[ 2 ] == 0,
+						"The product queue is counted by processing status." );
+	// The file is written twice, so that the second one replaces the first.
+	bNoError = WriteProcessingMetricsFile( TEST_METRICS_FILE_SPEC, QueueDepths );
+	if ( bNoError )
+		bNoError = WriteProcessingMetricsFile( TEST_METRICS_FILE_SPEC, QueueDepths );
+	CheckTestResult( bNoError, "The metrics file can be written over a previous one." );
+	if ( bNoError )
+		bNoError = CheckMetricsFile( "bretriever_stage_duration_seconds_count{stage=\"header_parse\"}", &nHeaderParseSamples, QueueDepths, &bQueueDepthsMatch );
+	CheckTestResult( bNoError, "The metrics file histograms are cumulative, and agree with their counts." );
+	CheckTestResult( bNoError && nHeaderParseSamples == 25, "The metrics file counts the stage times recorded." );
+	CheckTestResult( bNoError && bQueueDepthsMatch, "The metrics file lists the product queue depth for each status." );
+	pTemporaryFile = fopen( TEST_METRICS_FILE_SPEC ".tmp", "rb" );
+	CheckTestResult( pTemporaryFile == 0, "No temporary metrics file is left behind." );
+	if ( pTemporaryFile != 0 )
+		fclose( pTemporaryFile );
+	DeleteFile( TEST_METRICS_FILE_SPEC );
+	InitProcessingMetrics();
+}
+
+
+static double GetElapsedSeconds( LARGE_INTEGER *pStartTime )
+{
+	LARGE_INTEGER		EndTime;
+	LARGE_INTEGER		CounterFrequency;
+
+	QueryPerformanceCounter( &EndTime );
+	QueryPerformanceFrequency( &CounterFrequency );
+
+	return (double)( EndTime.QuadPart - pStartTime -> QuadPart ) / (double)CounterFrequency.QuadPart;
+}
+
+
+// Compare the cost of the metrics with that of parsing a 300 x 250 image and writing its PNG file,
+// which is less than BRetriever does for each image.  Each image is timed in NUMBER_OF_PROCESSING_STAGES
+// stages, and the metrics file is written once for every METRICS_EXPORT_INTERVAL of processing.
+static void TestMetricsOverhead()
+{
+	BOOL					bNoError = TRUE;
+	char					DictionaryFileSpec[ MAX_FILE_SPEC_LENGTH ];
+	char					*pDicomData;
+	unsigned long			nDataBytes;
+	EXAM_INFO				ExamInfo;
+	DICOM_HEADER_SUMMARY	*pDicomHeader;
+	LARGE_INTEGER			StartTime;
+	LARGE_INTEGER			StageStartTime;
+	double					ImageSeconds;
+	double					StageTimingSeconds;
+	double					ExportSeconds;
+	double					ImagesPerExport;
+	double					OverheadPercent;
+	unsigned long			QueueDepths[ NUMBER_OF_QUEUE_STATUS_METRICS ];
+	int						nImage;
+	int						nCall;
+
+	pDicomData = 0;
+	InitDictionaryModule();
+	GetTestDataFileSpec( "DicomParser\\ParserDictionary.txt", DictionaryFileSpec, MAX_FILE_SPEC_LENGTH );
+	bNoError = ReadDictionaryFile( DictionaryFileSpec, FALSE );
+	if ( bNoError )
+		bNoError = ReadTestDataFile( "DicomParser\\MultipleBuffers.dcm", &pDicomData, &nDataBytes );
+	ImageSeconds = 0.0;
+	QueryPerformanceCounter( &StartTime );
+	for ( nImage = 0; bNoError && nImage < OVERHEAD_TIMING_IMAGES; nImage++ )
+		{
+		bNoError = ParseDicomData( pDicomData, nDataBytes, &ExamInfo, &pDicomHeader );
+		if ( bNoError )
+			{
+			// ReadDicomHeaderInfo() settles the image transfer syntax after the parse.  The test image is uncompressed.
+			pDicomHeader -> FileDecodingPlan.ImageDataTransferSyntax = UNCOMPRESSED;
+			bNoError = OutputPNGImage( TEST_OUTPUT_FILE_SPEC, pDicomHeader );
+			}
+		FreeParsedDicomData( &ExamInfo, pDicomHeader );
+		}
+	ImageSeconds = GetElapsedSeconds( &StartTime ) / OVERHEAD_TIMING_IMAGES;
+	remove( TEST_OUTPUT_FILE_SPEC );
+	if ( pDicomData != 0 )
+		free( pDicomData );
+	CloseDictionaryModule();
+	CheckTestResult( bNoError, "The test image can be read and written as a PNG file." );
+
+	QueryPerformanceCounter( &StartTime );
+	QueryPerformanceCounter( &StageStartTime );
+	for ( nCall = 0; nCall < OVERHEAD_TIMING_CALLS; nCall++ )
+		RecordProcessingStageTime( nCall % NUMBER_OF_PROCESSING_STAGES, &StageStartTime );
+	StageTimingSeconds = GetElapsedSeconds( &StartTime ) / OVERHEAD_TIMING_CALLS;
+
+	memset( QueueDepths, 0, sizeof(QueueDepths) );
+	QueryPerformanceCounter( &StartTime );
+	for ( nCall = 0; nCall < OVERHEAD_TIMING_EXPORTS; nCall++ )
+		WriteProcessingMetricsFile( TEST_METRICS_FILE_SPEC, QueueDepths );
+	ExportSeconds = GetElapsedSeconds( &StartTime ) / OVERHEAD_TIMING_EXPORTS;
+	DeleteFile( TEST_METRICS_FILE_SPEC );
+	InitProcessingMetrics();
+
+	OverheadPercent = 100.0;
+	if ( bNoError && ImageSeconds > 0.0 )
+		{
+		ImagesPerExport = (double)METRICS_EXPORT_INTERVAL / ( 1000.0 * ImageSeconds );
+		OverheadPercent = 100.0 * ( NUMBER_OF_PROCESSING_STAGES * StageTimingSeconds + ExportSeconds / ImagesPerExport ) / ImageSeconds;
+		printf( "    An image took %.3f ms to read and write as PNG.  Timing its %d stages took %.3f us,\n",
+							1000.0 * ImageSeconds, NUMBER_OF_PROCESSING_STAGES, 1000000.0 * NUMBER_OF_PROCESSING_STAGES * StageTimingSeconds );
+		printf( "    and writing the metrics file took %.3f ms, once for every %.0f images.\n", 1000.0 * ExportSeconds, ImagesPerExport );
+		printf( "    The metrics added %.4f percent to the image processing time.\n", OverheadPercent );
+		}
+	CheckTestResult( OverheadPercent < MAXIMUM_METRICS_OVERHEAD, "The metrics add less than 1 percent to the image processing time." );
+}
+
+
+void TestProcessingMetrics()
+{
+	TestMetricPercentiles();
+	TestConcurrentRecording();
+	TestMetricsFileExport();
+	TestMetricsOverhead();
+}
@@ -0,0 +1,391 @@
+// TestStubs.cpp : Implements the stand-ins for the BRetriever service functions called
+//	by the modules under test.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "ReportStatus.h"
+#include "ServiceMain.h"
+#include "Dicom.h"
+#include "Configuration.h"
+#include "Operation.h"
+#include "ProductDispatcher.h"
+#include "ExamReformat.h"
+#include "Exam.h"
+#include "ExamEdit.h"
+#include "BRetrieverTest.h"
+
+
+TRANSFER_SERVICE			TransferService;
+CONFIGURATION				ServiceConfiguration;
+PRODUCT_OPERATION			*pPrimaryOperationList = 0;
+
+// The network modules refer to these endpoints and operations, which are configured in
+// Configuration.cpp.  The forwarding test sets up the ones it uses.
+ENDPOINT					EndPointWatchFolder;
+ENDPOINT					EndPointNetworkIn;
+PRODUCT_OPERATION			OperationReceive;
+PRODUCT_OPERATION			OperationSendImage;
+unsigned long				BRetrieverStatus = 0;
+BOOL						bProgramTerminationRequested = FALSE;
+
+
+// The BRetriever modules under test report their progress and errors through the functions
+// below, which stand in for the service versions in ReportStatus.cpp and elsewhere.  Many
+// of the tests provoke errors deliberately, so the messages are discarded and each test
+// checks the outcome it expects instead.
+
+void LogMessage( char *pMessage, long MessageType )
+{
+}
+
+
+void RespondToError( unsigned long nModuleIndex, unsigned ErrorCode )
+{
+}
+
+
+void SubmitUserNotification( USER_NOTIFICATION *pUserNoticeDescriptor )
+{
+}
+
+
+void RegisterErrorDictionary( ERROR_DICTIONARY_MODULE *pNewErrorDictionaryModule )
+{
+}
+
+
+void LinkModuleToList( MODULE_INFO *pNewModuleInfo )
+{
+}
+
+
+BOOL StorageCapacityIsAdequate()
+{
+	return TRUE;
+}
+
+
+void UpdateBRetrieverStatus( unsigned long NewBRetrieverStatus )
+{
+	BRetrieverStatus = NewBRetrieverStatus;
+}
+
+
+// Unlike the version in Module.cpp, this doesn't change the current directory, from which the
+// test data and output files are located.
+BOOL LocateOrCreateDirectory( char *pDirectorySpec )
+{
+	return ( CreateDirectory( pDirectorySpec, NULL ) || GetLastError() == ERROR_ALREADY_EXISTS );
+}
+
+
+// The Dicom parser keeps its buffers and elements in lists.  These versions behave like the
+// ones in Module.cpp, without its check for an item already in the list.
+BOOL AppendToList( LIST_HEAD *pListHead, void *pItemToAppend )
+{
+	BOOL			bNoError = TRUE;
+	LIST_ELEMENT	*pNewListElement;
+	LIST_ELEMENT	**ppLink;
+
+	pNewListElement = (LIST_ELEMENT*)malloc( sizeof(LIST_ELEMENT) );
+	bNoError = ( pNewListElement != 0 );
+	if ( bNoError )
+		{
+		pNewListElement -> pItem = pItemToAppend;
+		pNewListElement -> pNextListElement = 0;
+		ppLink = pListHead;
+		while ( *ppLink != 0 )
+			ppLink = &( *ppLink ) -> pNextListElement;
+		*ppLink = pNewListElement;
+		}
+
+	return bNoError;
+}
+
+
+// The network modules build their association buffers with this version from Module.cpp.
+BOOL PrefixToList( LIST_HEAD *pListHead, void *pItemToPrefix )
+{
+	BOOL			bNoError = TRUE;
+	LIST_ELEMENT	*pNewListElement;
+
+	pNewListElement = (LIST_ELEMENT*)malloc( sizeof(LIST_ELEMENT) );
+	bNoError = ( pNewListElement != 0 );
+	if ( bNoError )
+		{
+		pNewListElement -> pItem = pItemToPrefix;
+		pNewListElement -> pNextListElement = *pListHead;
+		*pListHead = pNewListElement;
+		}
+
+	return bNoError;
+}
+
+
+BOOL EraseList( LIST_HEAD *pListHead )
+{
+	LIST_ELEMENT	*pListElement;
+	LIST_ELEMENT	*pNextListElement;
+
+	if ( pListHead != 0 )
+		{
+		pListElement = *pListHead;
+		while ( pListElement != 0 )
+			{
+			pNextListElement = pListElement -> pNextListElement;
+			if ( pListElement -> pItem != 0 )
+				free( pListElement -> pItem );
+			free( pListElement );
+			pListElement = pNextListElement;
+			}
+		*pListHead = 0;
+		}
+
+	return TRUE;
+}
+
+
+// Composing the Dicom output inserts and removes elements.  These are the versions in Module.cpp.
+BOOL InsertIntoList( LIST_HEAD *pListHead, void *pItemToAppend, LIST_ELEMENT *pListItemToInsertAfter )
+{
+	BOOL			bNoError = TRUE;
+	LIST_ELEMENT	*pNewListElement;
+	LIST_ELEMENT	*pListElement;
+	BOOL			bInsertionComplete;
+
+	pNewListElement = (LIST_ELEMENT*)malloc( sizeof(LIST_ELEMENT) );
+	bNoError = ( pNewListElement != 0 );
+	if ( bNoError )
+		{
+		pNewListElement -> pItem = pItemToAppend;
+		pNewListElement -> pNextListElement = 0;
+		pListElement = *pListHead;
+		if ( pListElement == 0 )
+			*pListHead = pNewListElement;
+		else
+			{
+			bInsertionComplete = FALSE;
+			while ( pListElement != 0 && !bInsertionComplete )
+				{
+				if ( pListElement == pListItemToInsertAfter )
+					{
+					pNewListElement -> pNextListElement = pListElement -> pNextListElement;
+					pListElement -> pNextListElement = pNewListElement;
+					bInsertionComplete = TRUE;
+					}
+				pListElement = pListElement -> pNextListElement;
+				}
+			}
+		}
+
+	return bNoError;
+}
+
+
+BOOL RemoveFromList( LIST_HEAD *pListHead, void *pListItemToRemove )
+{
+	LIST_ELEMENT	*pPrevListElement;
+	LIST_ELEMENT	*pListElement;
+	BOOL			bMatchingListElementFound = FALSE;
+
+	pListElement = *pListHead;
+	pPrevListElement = 0;
+	while ( pListElement != 0 && !bMatchingListElementFound )
+		{
+		if ( pListElement -> pItem == pListItemToRemove )
+			{
+			bMatchingListElementFound = TRUE;
+			if ( pPrevListElement == 0 )
+				*pListHead = pListElement -> pNextListElement;
+			else
+				pPrevListElement -> pNextListElement = pListElement -> pNextListElement;
+			free( pListElement );
+			}
+		else
+			{
+			pPrevListElement = pListElement;
+			pListElement = pListElement -> pNextListElement;
+			}
+		}
+
+	return bMatchingListElementFound;
+}
+
+
+// Unlike the version in Module.cpp, this doesn't change the current directory.
+BOOL DirectoryExists( char *pFullDirectorySpecification )
+{
+	char					DirectorySpec[ MAX_FILE_SPEC_LENGTH ];
+	struct __stat64			FileStatisticsBuffer;
+
+	strncpy_s( DirectorySpec, MAX_FILE_SPEC_LENGTH, pFullDirectorySpecification, _TRUNCATE );
+	if ( strlen( DirectorySpec ) > 1 && DirectorySpec[ strlen( DirectorySpec ) - 1 ] == '\\' )
+		DirectorySpec[ strlen( DirectorySpec ) - 1 ] = '\0';
+
+	return ( _stat64( DirectorySpec, &FileStatisticsBuffer ) == 0 && ( FileStatisticsBuffer.st_mode & _S_IFDIR ) != 0 );
+}
+
+
+// The version in ReportStatus.cpp.  The edit specifications and the transfer syntax of the Dicom
+// output are trimmed.  The trimmed text is moved with memmove(), which gives the result of the
+// overlapping strncpy_s() in ReportStatus.cpp without depending on the order of its copy.
+void TrimBlanks( char *pTextString )
+{
+	long			nOriginalLength;
+	long			nChars;
+	long			nChar;
+	char			*pTrimmedText = pTextString;
+	BOOL			bLeadingBlanksWereFound;
+
+	nOriginalLength = (long)strlen( pTrimmedText );
+	if ( nOriginalLength > 0 )
+		{
+		for ( nChar = 0; nChar < nOriginalLength; nChar++ )
+			if ( pTrimmedText[ nChar ] < ' ' )
+				pTrimmedText[ nChar ] = ' ';
+		bLeadingBlanksWereFound = FALSE;
+		while ( pTrimmedText[0] == ' ' || pTrimmedText[0] == '\n' )
+			{
+			pTrimmedText++;
+			bLeadingBlanksWereFound = TRUE;
+			}
+		nChars = (long)strlen( pTrimmedText );
+		while ( nChars > 0 && pTrimmedText[ --nChars ] == ' ' || pTrimmedText[ nChars ] == '\n' )
+			pTrimmedText[ nChars ] = '\0';
+		if ( bLeadingBlanksWereFound )
+			memmove( pTextString, pTrimmedText, strlen( pTrimmedText ) + 1 );
+		}
+}
+
+
+void TrimTrailingSpaces( char *pTextString )
+{
+	long			nChars;
+
+	nChars = (long)strlen( pTextString );
+	while ( nChars > 0 && pTextString[ --nChars ] == ' ' )
+		pTextString[ nChars ] = '\0';
+}
+
+
+void PruneEmbeddedSpaceAndPunctuation( char *pTextString )
+{
+}
+
+
+// The parser adds the element values to the abstract records of Abstract.cpp, which the
+// tests don't examine.
+BOOL OpenNewAbstractRecord()
+{
+	return TRUE;
+}
+
+
+BOOL AddNewAbstractDataElement( TAG DicomElementTag, char *pElementTextValue )
+{
+	return TRUE;
+}
+
+
+ABSTRACT_RECORD_TEXT_LINE *CreateNewAbstractRecords()
+{
+	return 0;
+}
+
+
+void DeallocateExamInfoAttributes( EXAM_INFO *pExamInfo )
+{
+	char			**ppAttributes[] = { &pExamInfo -> pFirstName, &pExamInfo -> pLastName, &pExamInfo -> pExamID,
+											&pExamInfo -> pAppointmentDate, &pExamInfo -> pAppointmentTime,
+											&pExamInfo -> pSeriesNumber, &pExamInfo -> pSeriesDescription };
+	size_t			nAttribute;
+
+	for ( nAttribute = 0; nAttribute < sizeof(ppAttributes) / sizeof(char**); nAttribute++ )
+		{
+		if ( *ppAttributes[ nAttribute ] != 0 )
+			free( *ppAttributes[ nAttribute ] );
+		*ppAttributes[ nAttribute ] = 0;
+		}
+}
+
+
+__int64 GetFileSizeInBytes( char *pFullFileSpecification )
+{
+	FILE			*pFile;
+	__int64			nFileSizeInBytes;
+
+	nFileSizeInBytes = 0;
+	pFile = fopen( pFullFileSpecification, "rb" );
+	if ( pFile != 0 )
+		{
+		if ( _fseeki64( pFile, 0, SEEK_END ) == 0 )
+			nFileSizeInBytes = _ftelli64( pFile );
+		fclose( pFile );
+		}
+
+	return nFileSizeInBytes;
+}
+
+
+// The decoded image is captured here, instead of being converted to a PNG file.
+static char					*pConvertedImageData = 0;
+static unsigned long		ConvertedImageLength = 0;
+
+
+void ClearConvertedImage()
+{
+	if ( pConvertedImageData != 0 )
+		free( pConvertedImageData );
+	pConvertedImageData = 0;
+	ConvertedImageLength = 0;
+}
+
+
+BOOL GetConvertedImage( char **ppImageData, unsigned long *pImageLength )
+{
+	*ppImageData = pConvertedImageData;
+	*pImageLength = ConvertedImageLength;
+
+	return ( pConvertedImageData != 0 );
+}
+
+
+BOOL ConvertUncompressedImageToPNGFile( DICOM_HEADER_SUMMARY *pDicomHeader, FILE *pOutputImageFile, BOOL bIncludesCalibrationData )
+{
+	BOOL			bNoError = TRUE;
+
+	ClearConvertedImage();
+	pConvertedImageData = (char*)malloc( pDicomHeader -> ImageLengthInBytes );
+	bNoError = ( pConvertedImageData != 0 );
+	if ( bNoError )
+		{
+		memcpy( pConvertedImageData, pDicomHeader -> pImageData, pDicomHeader -> ImageLengthInBytes );
+		ConvertedImageLength = pDicomHeader -> ImageLengthInBytes;
+		}
+
+	return bNoError;
+}
+
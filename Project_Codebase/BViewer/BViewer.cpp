@@ -28,6 +28,16 @@
 //
 // UPDATE HISTORY:
 //
+//	*[8] 10/19/2026 by agent
+//		While the configuration calls for study files that earlier BViewer versions can
+//		read, a study restored from a sectioned study file is saved again in the earlier
+//		layout.
+//	*[7] 10/19/2026 by agent
+//		Added the patient index.  Studies are added to and removed from the available
+//		and newly arrived study lists through AddStudyToList() and RemoveStudyFromList(),
+//		which keep the index current, so that a new study is matched to an existing
+//		patient by a single hash lookup.  A study that cannot be filed in the index is
+//		not added to the study list either, so the caller can discard it.
 //	*[6] 04/30/2024 by Tom Atwood
 //		Improved login failure response if no reader info was provided.
 //	*[5] 02/01/2024 by Tom Atwood
@@ -108,6 +118,7 @@ CBViewerApp::CBViewerApp()
 	m_ActiveStudyList = 0;
 	m_AvailableStudyList = 0;
 	m_NewlyArrivedStudyList = 0;
+	memset( m_PatientIndex, '\0', sizeof( m_PatientIndex ) );		// *[7]
 	m_pCurrentStudy = 0;
 	m_bNewAbstractsAreAvailable = FALSE;
 	m_nNewStudiesImported = 0;
@@ -498,10 +509,12 @@ BOOL CBViewerApp::SetUpAvailableStudies()
 			if ( pNewStudy != 0 )
 				{
 				bNoError = pNewStudy -> Restore( FoundFileSpec );
-				if ( bNoError && pNewStudy -> m_pDiagnosticStudyList != 0 )
-					AppendToList( &m_AvailableStudyList, (void*)pNewStudy );
-				else
+				if ( !bNoError || pNewStudy -> m_pDiagnosticStudyList == 0 ||
+							!AddStudyToList( &m_AvailableStudyList, pNewStudy ) )					// *[7]
 					delete pNewStudy;
+				else if ( BViewerConfiguration.bWriteLegacySDYFiles &&
+							pNewStudy -> m_SDYFileVersion >= SDY_FILE_VERSION_SECTIONED )				// *[8]
+					pNewStudy -> Save();
 				}
 			// Look for another file in the source directory.
 			bFileFound = FindNextFile( hFindFile, &FindFileInfo );
@@ -647,9 +660,11 @@ static void ProcessAbstractDataRow( char *pTitleRow, char *pDataRow )
 					sprintf_s( TextString, FILE_PATH_STRING_LENGTH, "Adding new study for AE_TITLE %s.", pNewStudy -> m_ReaderInfo.AE_TITLE );	// *[1] Replaced sprintf with sprintf_s.
 					LogMessage( TextString, MESSAGE_TYPE_SUPPLEMENTARY );
 					if ( bThisStudyIsAutoLoadable )
-						AppendToList( &ThisBViewerApp.m_AvailableStudyList, (void*)pNewStudy );
+						bNoError = ThisBViewerApp.AddStudyToList( &ThisBViewerApp.m_AvailableStudyList, pNewStudy );			// *[7]
 					else
-						AppendToList( &ThisBViewerApp.m_NewlyArrivedStudyList, (void*)pNewStudy );
+						bNoError = ThisBViewerApp.AddStudyToList( &ThisBViewerApp.m_NewlyArrivedStudyList, pNewStudy );		// *[7]
+					if ( !bNoError )																							// *[7]
+						delete pNewStudy;																						// *[7]
 					}
 				}
 			else						// *[1] Fix memory leak in event of an error.
@@ -1070,6 +1085,7 @@ void CBViewerApp::DeallocateListOfStudies()
 	LIST_ELEMENT			*pListElement;
 	LIST_ELEMENT			*pPrevListElement;
 	CStudy					*pStudy;
+	int						nIndexEntry;			// *[7]
 	
 	pListElement = m_AvailableStudyList;
 	while ( pListElement != 0 )
@@ -1082,6 +1098,109 @@ void CBViewerApp::DeallocateListOfStudies()
 		free( pPrevListElement );
 		}
 	m_AvailableStudyList = 0;
+	// *[7] The index only refers to the studies, which belong to the study lists.
+	for ( nIndexEntry = 0; nIndexEntry < PATIENT_INDEX_SIZE; nIndexEntry++ )
+		DissolveList( &m_PatientIndex[ nIndexEntry ] );
+}
+
+
+// *[7] Add the study to the specified study list, and file it in the patient index
+// under the hash of its patient name, ID and accession number.  If either step fails,
+// the study is left out of both, and the caller still owns it.
+BOOL CBViewerApp::AddStudyToList( LIST_HEAD *pStudyList, CStudy *pStudy )
+{
+	BOOL					bNoError = TRUE;
+
+	pStudy -> m_PatientKeyHash = pStudy -> CalculatePatientKeyHash();
+	bNoError = AppendToList( &m_PatientIndex[ pStudy -> m_PatientKeyHash & ( PATIENT_INDEX_SIZE - 1 ) ], (void*)pStudy );
+	if ( bNoError )
+		{
+		bNoError = AppendToList( pStudyList, (void*)pStudy );
+		if ( bNoError )
+			pStudy -> m_pStudyList = pStudyList;
+		else
+			RemoveFromList( &m_PatientIndex[ pStudy -> m_PatientKeyHash & ( PATIENT_INDEX_SIZE - 1 ) ], (void*)pStudy );
+		}
+	if ( !bNoError )
+		{
+		pStudy -> m_pStudyList = 0;
+		LogMessage( ">>> Unable to add the study to the study list.", MESSAGE_TYPE_ERROR );
+		}
+
+	return bNoError;
+}
+
+
+// *[7] Remove the study from the specified study list and from the patient index.
+BOOL CBViewerApp::RemoveStudyFromList( LIST_HEAD *pStudyList, CStudy *pStudy )
+{
+	BOOL					bNoError = TRUE;
+
+	if ( pStudy != 0 && pStudy -> m_pStudyList != 0 )
+		{
+		RemoveFromList( &m_PatientIndex[ pStudy -> m_PatientKeyHash & ( PATIENT_INDEX_SIZE - 1 ) ], (void*)pStudy );
+		pStudy -> m_pStudyList = 0;
+		}
+	bNoError = RemoveFromList( pStudyList, (void*)pStudy );
+
+	return bNoError;
+}
+
+
+// *[7] Refile a listed study whose patient name, ID or accession number has been edited.
+// A study that is not in either study list is ignored.  The study is filed under its new
+// hash before it is removed from the old entry, so that it is never left out of the index.
+void CBViewerApp::UpdatePatientIndex( CStudy *pStudy )
+{
+	unsigned long			PatientKeyHash;
+
+	if ( pStudy -> m_pStudyList != 0 )
+		{
+		PatientKeyHash = pStudy -> CalculatePatientKeyHash();
+		if ( PatientKeyHash != pStudy -> m_PatientKeyHash )
+			{
+			if ( AppendToList( &m_PatientIndex[ PatientKeyHash & ( PATIENT_INDEX_SIZE - 1 ) ], (void*)pStudy ) )
+				{
+				RemoveFromList( &m_PatientIndex[ pStudy -> m_PatientKeyHash & ( PATIENT_INDEX_SIZE - 1 ) ], (void*)pStudy );
+				pStudy -> m_PatientKeyHash = PatientKeyHash;
+				}
+			else
+				LogMessage( ">>> Unable to refile the edited study in the patient index.", MESSAGE_TYPE_ERROR );
+			}
+		}
+}
+
+
+// *[7] Find the listed study for the same patient name, ID and accession number as the new
+// study.  As when the two study lists were searched in turn, a newly arrived study is
+// preferred over an available one, and otherwise the earliest listed study is returned.
+CStudy *CBViewerApp::FindStudyForPatient( CStudy *pNewStudy )
+{
+	CStudy					*pMatchingStudy;
+	CStudy					*pIndexedStudy;
+	LIST_ELEMENT			*pIndexListElement;
+	unsigned long			PatientKeyHash;
+
+	pMatchingStudy = 0;
+	PatientKeyHash = pNewStudy -> CalculatePatientKeyHash();
+	pIndexListElement = m_PatientIndex[ PatientKeyHash & ( PATIENT_INDEX_SIZE - 1 ) ];
+	while ( pIndexListElement != 0 && ( pMatchingStudy == 0 || pMatchingStudy -> m_pStudyList != &m_NewlyArrivedStudyList ) )
+		{
+		pIndexedStudy = (CStudy*)pIndexListElement -> pItem;
+		if ( pIndexedStudy != 0 && pIndexedStudy != pNewStudy &&
+				pIndexedStudy -> m_PatientKeyHash == PatientKeyHash &&
+				strcmp( pIndexedStudy -> m_PatientLastName, pNewStudy -> m_PatientLastName ) == 0 &&
+				strcmp( pIndexedStudy -> m_PatientFirstName, pNewStudy -> m_PatientFirstName ) == 0 &&
+				strcmp( pIndexedStudy -> m_AccessionNumber, pNewStudy -> m_AccessionNumber ) == 0 &&
+				strcmp( pIndexedStudy -> m_PatientID, pNewStudy -> m_PatientID ) == 0 )
+			{
+			if ( pMatchingStudy == 0 || pIndexedStudy -> m_pStudyList == &m_NewlyArrivedStudyList )
+				pMatchingStudy = pIndexedStudy;
+			}
+		pIndexListElement = pIndexListElement -> pNextListElement;
+		}
+
+	return pMatchingStudy;
 }
 
 
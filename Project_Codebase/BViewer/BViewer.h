@@ -28,6 +28,12 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		Added the message that tells the study selection list that image previews
+//		have been read.
+//	*[2] 10/19/2026 by agent
+//		Added the patient index, which files the available and newly arrived studies
+//		by the hash of their patient identification fields.
 //	*[1] 01/13/2023 by Tom Atwood
 //		Fixed code security issues.
 //
@@ -100,6 +106,11 @@
 #define        WM_AUTOPROCESS		(WM_USER + 1)
 // Define a windows message for initiating the unattended production of a report for the current study.
 // #define        WM_AUTOREPORT		(WM_USER + 2)
+// Define a windows message for signaling that image previews have been read for the study selection list.
+#define        WM_THUMBNAIL_READ	(WM_USER + 3)			// *[3]
+
+
+#define PATIENT_INDEX_SIZE			1024		// *[2] Number of hash buckets in the patient index.  Must be a power of 2.
 
 
 // CBViewerApp:
@@ -113,6 +124,7 @@ public:
 	LIST_HEAD				m_ActiveStudyList;
 	LIST_HEAD				m_AvailableStudyList;
 	LIST_HEAD				m_NewlyArrivedStudyList;
+	LIST_HEAD				m_PatientIndex[ PATIENT_INDEX_SIZE ];		// *[2] The studies in the above two lists, filed by patient key hash.
 	CStudy					*m_pCurrentStudy;
 	char					m_AutoLoadSOPInstanceUID[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
 	HICON					m_hApplicationIcon;
@@ -146,6 +158,10 @@ public:
 	void						LaunchStudyUpdateTimer();
 	void						UpdateBRetrieverStatusDisplay();
 	void						DeallocateListOfStudies();
+	BOOL						AddStudyToList( LIST_HEAD *pStudyList, CStudy *pStudy );			// *[2]
+	BOOL						RemoveStudyFromList( LIST_HEAD *pStudyList, CStudy *pStudy );		// *[2]
+	void						UpdatePatientIndex( CStudy *pStudy );								// *[2]
+	CStudy						*FindStudyForPatient( CStudy *pNewStudy );							// *[2]
 	void						DeleteUserNoticeList();			// *[1]
 	void						TerminateTimers();
 	void						EraseReaderList();				// *[1] Changed function name.
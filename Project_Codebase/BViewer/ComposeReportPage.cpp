@@ -30,6 +30,13 @@
 //
 // UPDATE HISTORY:
 //
+//	*[7] 10/19/2026 by agent
+//		Count the unique report names by sorting them, instead of comparing every
+//		pair of names.
+//	*[6] 10/19/2026 by agent
+//		Refile the study in the patient index when the patient identification is edited,
+//		and remove a deleted study through RemoveStudyFromList(), which also removes it
+//		from the index.
 //	*[5] 07/17/2023 by Tom Atwood
 //		Fixed code security issues.
 //	*[4] 06/09/2023 by Tom Atwood
@@ -699,6 +706,7 @@ void CComposeReportPage::LoadStudyDataFromScreens()
 			pCurrentStudy -> m_PatientsBirthDate.bDateHasBeenEdited = m_EditDateOfBirth.m_bHasReceivedInput;
 
 			m_EditPatientID.GetWindowText( pCurrentStudy -> m_PatientID, sizeof( pCurrentStudy -> m_PatientID ) );
+			ThisBViewerApp.UpdatePatientIndex( pCurrentStudy );																					// *[6]
 			m_EditClassificationPurpose.GetWindowText( pCurrentStudy -> m_PatientComments, sizeof( pCurrentStudy -> m_PatientComments ) );
 			m_EditTypeOfReadingOther.GetWindowText( pCurrentStudy -> m_OtherTypeOfReading, sizeof( pCurrentStudy -> m_OtherTypeOfReading ) );
 			if ( pCurrentStudy -> m_pDiagnosticStudyList != 0 )
@@ -735,6 +743,13 @@ static void DeletePopupDialog( void *pResponseDialog )
 }
 
 
+// *[7] Compare two report names for sorting.
+static int CompareReportNames( const void *pName1, const void *pName2 )
+{
+	return strcmp( *(char**)pName1, *(char**)pName2 );
+}
+
+
 // Count the number of unique saved reports.
 void CComposeReportPage::SetReportCount()
 {
@@ -742,9 +757,8 @@ void CComposeReportPage::SetReportCount()
 	int						TotalCount = 0;					// *[4] Initialize the counter.
 	int						UniqueReportCount = 0;
 	char					**pReportNameArray = 0;			// *[4] Initialize the pointer.
-	char					*pReportName;
+	int						nReportNames = 0;				// *[7]
 	int						nReport;
-	int						mReport;
 
 	if ( m_pReportListCtrl != 0 )
 		{
@@ -765,28 +779,18 @@ void CComposeReportPage::SetReportCount()
 			if ( pReportNameArray != 0 )
 				{
 				pReportInfo = m_pReportListCtrl -> m_pFirstReport;
-				while ( pReportInfo != 0 )
+				while ( pReportInfo != 0 && nReportNames < TotalCount )
 					{
-					pReportName = (char*)malloc( 96 );
-					if ( pReportName != 0 )
-						{
-						strncpy_s( pReportName, 96, pReportInfo -> SubjectName, _TRUNCATE );	// *[4] Save space for null terminator.
-						pReportNameArray[ UniqueReportCount++ ] = pReportName;
-						}
+					pReportNameArray[ nReportNames++ ] = pReportInfo -> SubjectName;		// *[7] Point to the name in the list.
 					pReportInfo = pReportInfo -> pNextReportInfo;
 					}
-				// Cycle through the list to detect duplicates.
-				for ( nReport = 1; nReport < TotalCount; nReport++ )
-					{
-					for ( mReport = 0; mReport < nReport; mReport++ )
-						{
-						if ( strcmp( pReportNameArray[ nReport ], pReportNameArray[ mReport ] ) == 0 )
-							{
-							UniqueReportCount--;
-							break;
-							}
-						}
-					}
+				// *[7] Sort the names, so that duplicates are adjacent, and count the distinct ones.
+				qsort( pReportNameArray, nReportNames, sizeof(char*), CompareReportNames );
+				if ( nReportNames > 0 )
+					UniqueReportCount = 1;
+				for ( nReport = 1; nReport < nReportNames; nReport++ )
+					if ( strcmp( pReportNameArray[ nReport ], pReportNameArray[ nReport - 1 ] ) != 0 )
+						UniqueReportCount++;
 				}
 			}
 		}
@@ -796,15 +800,7 @@ void CComposeReportPage::SetReportCount()
 	m_StaticUniqueReportCount.Invalidate( TRUE );
 	// Deallocate the report name array.
 	if ( pReportNameArray != 0 )														// *[3] Added NULL check.
-		{
-		for ( nReport = 0; nReport < TotalCount; nReport++ )
-			if ( pReportNameArray[ nReport ] != 0 )										// *[4] Added NULL check.
-				{
-				free( pReportNameArray[ nReport ] );
-				pReportNameArray[ nReport ] = 0;										// *[4] Indicate no report name allocated.
-				}
-		free( pReportNameArray );
-		}
+		free( pReportNameArray );														// *[7] The names themselves belong to the report list.
 }
 
 
@@ -1145,7 +1141,7 @@ static void DeleteCurrentStudy( CStudy *pStudy )
 			pMainFrame -> m_pImageFrame[ IMAGE_FRAME_REPORT ] -> ClearImageDisplay();
 		}
 	pStudy -> DeleteStudyDataAndImages();
-	RemoveFromList( &ThisBViewerApp.m_AvailableStudyList, (void*)pStudy );
+	ThisBViewerApp.RemoveStudyFromList( &ThisBViewerApp.m_AvailableStudyList, pStudy );		// *[6]
 	delete pStudy;
 }
 
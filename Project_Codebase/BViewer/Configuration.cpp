@@ -29,6 +29,8 @@
 //
 // UPDATE HISTORY:
 //
+//	*[7] 10/19/2026 by agent
+//		Added the "WRITE SDY FILES FOR EARLIER BVIEWER VERSIONS" configuration setting.
 //	*[6] 05/14/2024 by Tom Atwood
 //		Removed obsolete film standard reference images.
 //	*[5] 05/14/2024 by Tom Atwood
@@ -161,6 +163,7 @@ void InitConfigurationModule()
 	BViewerConfiguration.bEnableAutoAdvanceToInterpretation = TRUE;
 	BViewerConfiguration.bPromptForStudyDeletion = TRUE;
 	BViewerConfiguration.bArchiveSDYFiles = FALSE;
+	BViewerConfiguration.bWriteLegacySDYFiles = FALSE;								// *[7]
 	BViewerConfiguration.bArchiveReportFiles = FALSE;
 	BViewerConfiguration.bArchiveImageFiles = FALSE;
 	BViewerConfiguration.bAutoGeneratePDFReportsFromAXTFiles = FALSE;
@@ -527,6 +530,15 @@ BOOL ParseConfigurationLine( char *pTextLine )
 				else
 					bNoError = FALSE;
 				}
+			else if ( _stricmp( pAttributeName, "WRITE SDY FILES FOR EARLIER BVIEWER VERSIONS" ) == 0 )		// *[7]
+				{
+				if ( _stricmp( pAttributeValue, "YES" ) == 0 )
+					BViewerConfiguration.bWriteLegacySDYFiles = TRUE;
+				else if ( _stricmp( pAttributeValue, "NO" ) == 0 )
+					BViewerConfiguration.bWriteLegacySDYFiles = FALSE;
+				else
+					bNoError = FALSE;
+				}
 			else if ( _stricmp( pAttributeName, "ARCHIVE REPORT FILES FOR COMPLETED STUDIES" ) == 0 )
 				{
 				if ( _stricmp( pAttributeValue, "YES" ) == 0 )
@@ -29,6 +29,9 @@
 //
 // UPDATE HISTORY:
 //
+//	*[4] 10/19/2026 by agent
+//		Added bWriteLegacySDYFiles, for writing study files that earlier BViewer versions
+//		can read.
 //	*[3] 05/14/2024 by Tom Atwood
 //		Removed obsolete film standard reference images.
 //	*[2] 01/23/2024 by Tom Atwood
@@ -188,6 +191,7 @@ typedef struct
 	BOOL					bEnableAutoAdvanceToInterpretation;
 	BOOL					bPromptForStudyDeletion;
 	BOOL					bArchiveSDYFiles;
+	BOOL					bWriteLegacySDYFiles;				// *[4]
 	BOOL					bArchiveReportFiles;
 	BOOL					bArchiveImageFiles;
 	BOOL					bAutoGeneratePDFReportsFromAXTFiles;
@@ -39,6 +39,29 @@
 //
 // UPDATE HISTORY:
 //
+//	*[11] 10/19/2026 by agent
+//		The image previews are windowed by the CPU version of the display shaders' windowing,
+//		in GrayscaleWindowing.cpp, so that a preview matches the image as it is first displayed.
+//	*[10] 10/19/2026 by agent
+//		The PNG row filter search is only skipped when the caller of WritePNGImageFile()
+//		designates the image as a report page.
+//	*[9] 10/19/2026 by agent
+//		The thumbnail column sums are 64-bit, so that a block of 16-bit pixels can't
+//		overflow them.
+//	*[8] 10/19/2026 by agent
+//		Removed CreateWindowedGrayscaleOutputImage(), which had no callers.
+//	*[7] 10/19/2026 by agent
+//		Read the pixel statistics chunk recorded by BRetriever following the PNG image data.
+//		When it is present, AnalyzeImagePixels() uses it instead of scanning the pixels.
+//	*[6] 10/19/2026 by agent
+//		Added ReadPNGThumbnailImage(), which produces a reduced-size preview of a grayscale
+//		image file without holding the full-resolution image in memory.
+//	*[5] 10/19/2026 by agent
+//		Added CreateWindowedGrayscaleOutputImage(), which applies the current grayscale
+//		windowing to the image without using the GPU.
+//	*[4] 10/19/2026 by agent
+//		Speeded up writing report page PNG files by buffering the output file and
+//		omitting the per-row PNG filter search.
 //	*[3] 07/17/2023 by Tom Atwood
 //		Fixed code security issues.
 //	*[2] 03/15/2023 by Tom Atwood
@@ -55,6 +78,7 @@
 #include "ReportStatus.h"
 #include "Access.h"
 #include "DiagnosticImage.h"
+#include "GrayscaleWindowing.h"			// *[11]
 #include "Mouse.h"
 #include "Customization.h"
 #include "FrameHeader.h"
@@ -137,6 +161,7 @@ CDiagnosticImage::CDiagnosticImage()
 	m_bImageHasBeenDownSampled = FALSE;
 	m_bImageHasBeenCompacted = FALSE;
 	m_pImageCalibrationInfo = 0;			// Allocated by ReadPNGFileHeader().
+	memset( &m_ImagePixelStatistics, 0, sizeof(IMAGE_PIXEL_STATISTICS) );		// *[7] Loaded by ReadPNGImageFile().
 	m_MaxGrayscaleValue = 256;
 	m_bConvertImageTo8BitGrayscale = FALSE;
 	m_LuminosityHistogram.nNumberOfBins = 0;
@@ -297,7 +322,8 @@ static char				VOI_LUTIsSpecifiedMsg[] = ", A VOI-LUT is specified";
 
 // This function is called immediately after the image has been read from the PNG file and buffered.
 // It performs an examination of the pixel data and compares with the characteristics declared in
-// the Dicom data elements.  Any detected errors are logged and overridden.
+// the Dicom data elements.  Any detected errors are logged and overridden.  If BRetriever recorded
+// the pixel statistics for the whole image in the file, they are used instead of scanning the pixels.
 void CDiagnosticImage::AnalyzeImagePixels()
 {
 	BOOL				bNoError = TRUE;
@@ -331,7 +357,32 @@ void CDiagnosticImage::AnalyzeImagePixels()
 	PixelBitsSet = 0;
 	MaxObservedPixelValue = 0;
 
-	if ( m_ImageBitDepth <= 8 )
+	if ( m_SamplesPerPixel == 1 && (size_t)m_ImagePixelStatistics.nPixelsCounted == nPixelCount )		// *[7]
+		{
+		PixelBitsSet = m_ImagePixelStatistics.PixelBitsSet;
+		// The recorded values are not inverted, so the inverted maximum becomes the minimum.
+		if ( m_pImageCalibrationInfo -> PhotometricInterpretation == PMINTERP_MONOCHROME1 )
+			{
+			if ( m_ImageBitDepth <= 8 )
+				{
+				MinObservedPixelValue = (unsigned short)(unsigned char)~m_ImagePixelStatistics.MaxPixelValue;
+				MaxObservedPixelValue = (unsigned short)(unsigned char)~m_ImagePixelStatistics.MinPixelValue;
+				}
+			else
+				{
+				MinObservedPixelValue = (unsigned short)~m_ImagePixelStatistics.MaxPixelValue;
+				MaxObservedPixelValue = (unsigned short)~m_ImagePixelStatistics.MinPixelValue;
+				}
+			}
+		else
+			{
+			MinObservedPixelValue = m_ImagePixelStatistics.MinPixelValue;
+			MaxObservedPixelValue = m_ImagePixelStatistics.MaxPixelValue;
+			}
+		_snprintf_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH,  _TRUNCATE, "Using the recorded pixel statistics:  Mean pixel value = %.1f", m_ImagePixelStatistics.MeanPixelValue );
+		LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
+		}
+	else if ( m_ImageBitDepth <= 8 )																	// *[7]
 		{
 		MinObservedPixelValue = 0x00ff;
 		p8BitPixel = m_pImageData;
@@ -1163,6 +1214,208 @@ BOOL ReadPNGFileHeader( FILE *pImageFile, IMAGE_CALIBRATION_INFO **ppImageCalibr
 }
 
 
+// *[6] Read a grayscale PNG image file into a reduced-size 8-bit preview image.  The image is read
+// one row at a time, and each block of rows is averaged into a row of the preview as it is read,
+// so the full-resolution image is never held in memory.  The window center and width recorded in
+// the image calibration header are applied to the averaged pixel values, as the display shaders
+// apply them (*[11]).  The preview image is allocated here, with its rows ordered from the top of
+// the image down, and must be freed by the caller.
+BOOL ReadPNGThumbnailImage( char *pFileSpec, unsigned long MaxThumbnailDimension, unsigned char **ppThumbnailData,
+								unsigned long *pThumbnailWidth, unsigned long *pThumbnailHeight )
+{
+	BOOL					bNoError = TRUE;
+	FILE					*pImageFile;
+	IMAGE_CALIBRATION_INFO	*pImageCalibrationInfo = 0;
+	unsigned long			ImageWidthInPixels = 0;
+	unsigned long			ImageHeightInPixels = 0;
+	int						ImageBitDepth = 0;
+	int						ColorType = 0;
+	int						InterlaceType = 0;
+	unsigned long			DecimationFactor = 1;
+	unsigned long			ThumbnailWidth = 0;
+	unsigned long			ThumbnailHeight = 0;
+	unsigned char			*pRowBuffer = 0;
+	unsigned __int64		*pColumnSums = 0;															// *[9]
+	unsigned char			*pThumbnailData = 0;
+	unsigned char			*pThumbnailPixel;
+	unsigned long			nRow;
+	unsigned long			nPixel;
+	unsigned long			nPixelsPerBlock;
+	GRAYSCALE_WINDOWING		Windowing;																// *[11]
+	GRAYSCALE_WINDOWING_TABLE	WindowingTable;															// *[11]
+
+#pragma pack(push)
+#pragma pack(16)		// Pack structure members on 16-byte boundaries for faster access.
+	png_struct		*pPngConfig = 0;
+	png_info		*pPngImageInfo = 0;
+#pragma pack(pop)
+
+	*ppThumbnailData = 0;
+	memset( &WindowingTable, 0, sizeof(GRAYSCALE_WINDOWING_TABLE) );								// *[11]
+	pImageFile = fopen( pFileSpec, "rb" );
+	bNoError = ( pImageFile != 0 && MaxThumbnailDimension > 0 );
+	if ( bNoError )
+		bNoError = ReadPNGFileHeader( pImageFile, &pImageCalibrationInfo );
+	if ( bNoError )
+		{
+		pPngConfig = png_create_read_struct( PNG_LIBPNG_VER_STRING, 0, 0, 0 );
+		if ( pPngConfig != 0 )
+			pPngImageInfo = png_create_info_struct( pPngConfig );
+		if ( pPngConfig == 0 || pPngImageInfo == 0 )
+			{
+			RespondToError( MODULE_IMAGE, IMAGE_ERROR_INSUFFICIENT_MEMORY );
+			bNoError = FALSE;
+			}
+		}
+	if ( bNoError )
+		{
+		// setjmp() must be called in every function that calls a PNG-reading libpng function.
+		if ( setjmp( png_jmpbuf( pPngConfig ) ) )
+			{
+			RespondToError( MODULE_IMAGE, IMAGE_ERROR_IMAGE_READ );
+			bNoError = FALSE;
+			}
+		}
+	if ( bNoError )
+		{
+		png_init_io( pPngConfig, pImageFile );
+		png_set_sig_bytes( pPngConfig, 8 );
+		png_read_info( pPngConfig, pPngImageInfo );
+		png_get_IHDR( pPngConfig, pPngImageInfo, &ImageWidthInPixels, &ImageHeightInPixels, &ImageBitDepth, &ColorType, &InterlaceType, NULL, NULL );
+		// Only the single-pass grayscale images produced by BRetriever are supported.
+		bNoError = ( ColorType == PNG_COLOR_TYPE_GRAY && InterlaceType == PNG_INTERLACE_NONE &&
+						( ImageBitDepth == 8 || ImageBitDepth == 16 ) && ImageWidthInPixels > 0 && ImageHeightInPixels > 0 );
+		}
+	if ( bNoError )
+		{
+		if ( ImageBitDepth > 8 )
+			png_set_swap( pPngConfig );
+		png_read_update_info( pPngConfig, pPngImageInfo );
+		if ( ImageWidthInPixels > ImageHeightInPixels )
+			DecimationFactor = ( ImageWidthInPixels + MaxThumbnailDimension - 1 ) / MaxThumbnailDimension;
+		else
+			DecimationFactor = ( ImageHeightInPixels + MaxThumbnailDimension - 1 ) / MaxThumbnailDimension;
+		if ( DecimationFactor == 0 )
+			DecimationFactor = 1;
+		ThumbnailWidth = ImageWidthInPixels / DecimationFactor;
+		ThumbnailHeight = ImageHeightInPixels / DecimationFactor;
+		bNoError = ( ThumbnailWidth > 0 && ThumbnailHeight > 0 );
+		}
+	if ( bNoError )
+		{
+		pRowBuffer = (unsigned char*)malloc( png_get_rowbytes( pPngConfig, pPngImageInfo ) );
+		pColumnSums = (unsigned __int64*)calloc( ThumbnailWidth, sizeof(unsigned __int64) );			// *[9]
+		pThumbnailData = (unsigned char*)malloc( ThumbnailWidth * ThumbnailHeight );
+		// *[11] Map the averaged pixel values through the recorded window, or through the full
+		// grayscale range if no window was recorded.
+		Windowing.WindowMinPixelAmplitude = 0.0;
+		Windowing.WindowMaxPixelAmplitude = 0.0;
+		if ( pImageCalibrationInfo != 0 && pImageCalibrationInfo -> WindowWidth > 1.0 )
+			{
+			Windowing.WindowMinPixelAmplitude = pImageCalibrationInfo -> WindowCenter - pImageCalibrationInfo -> WindowWidth / 2.0;
+			Windowing.WindowMaxPixelAmplitude = pImageCalibrationInfo -> WindowCenter + pImageCalibrationInfo -> WindowWidth / 2.0;
+			}
+		Windowing.Gamma = 1.0;
+		Windowing.bWindowingIsSigmoidal = FALSE;
+		Windowing.bColorsInverted = FALSE;
+		if ( pRowBuffer == 0 || pColumnSums == 0 || pThumbnailData == 0 ||
+					!PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, ImageBitDepth, ImageBitDepth, GRAYSCALE_OUTPUT_8BIT, 0 ) )
+			{
+			RespondToError( MODULE_IMAGE, IMAGE_ERROR_INSUFFICIENT_MEMORY );
+			bNoError = FALSE;
+			}
+		}
+	if ( bNoError )
+		{
+		nPixelsPerBlock = DecimationFactor * DecimationFactor;
+		pThumbnailPixel = pThumbnailData;
+		for ( nRow = 0; nRow < ThumbnailHeight * DecimationFactor; nRow++ )
+			{
+			png_read_row( pPngConfig, pRowBuffer, NULL );
+			if ( ImageBitDepth == 8 )
+				for ( nPixel = 0; nPixel < ThumbnailWidth * DecimationFactor; nPixel++ )
+					pColumnSums[ nPixel / DecimationFactor ] += pRowBuffer[ nPixel ];
+			else
+				for ( nPixel = 0; nPixel < ThumbnailWidth * DecimationFactor; nPixel++ )
+					pColumnSums[ nPixel / DecimationFactor ] += ( (unsigned short*)pRowBuffer )[ nPixel ];
+			// When a full block of rows has been summed, output the averaged row.
+			if ( ( nRow + 1 ) % DecimationFactor == 0 )
+				{
+				for ( nPixel = 0; nPixel < ThumbnailWidth; nPixel++ )
+					{
+					*pThumbnailPixel++ = WindowingTable.pOutputTable[ ( pColumnSums[ nPixel ] + nPixelsPerBlock / 2 ) / nPixelsPerBlock ];	// *[11]
+					pColumnSums[ nPixel ] = 0;
+					}
+				}
+			}
+		*ppThumbnailData = pThumbnailData;
+		*pThumbnailWidth = ThumbnailWidth;
+		*pThumbnailHeight = ThumbnailHeight;
+		}
+	else if ( pThumbnailData != 0 )
+		free( pThumbnailData );
+	if ( pPngConfig != 0 )
+		png_destroy_read_struct( &pPngConfig, &pPngImageInfo, png_infopp_NULL );
+	if ( pRowBuffer != 0 )
+		free( pRowBuffer );
+	if ( pColumnSums != 0 )
+		free( pColumnSums );
+	ReleaseGrayscaleWindowingTable( &WindowingTable );											// *[11]
+	if ( pImageCalibrationInfo != 0 )
+		{
+		// The LUT buffer pointers are only valid if ReadPNGFileHeader() allocated them.
+		if ( pImageCalibrationInfo -> ModalityLUTDataBufferSize > 0 && pImageCalibrationInfo -> ModalityLUTDataBufferSize < 4000000 &&
+					pImageCalibrationInfo -> pModalityLUTData != 0 )
+			free( pImageCalibrationInfo -> pModalityLUTData );
+		if ( pImageCalibrationInfo -> VOI_LUTDataBufferSize > 0 && pImageCalibrationInfo -> VOI_LUTDataBufferSize < 4000000 &&
+					pImageCalibrationInfo -> pVOI_LUTData != 0 )
+			free( pImageCalibrationInfo -> pVOI_LUTData );
+		free( pImageCalibrationInfo );
+		}
+	if ( pImageFile != 0 )
+		fclose( pImageFile );
+
+	return bNoError;
+}
+
+
+// *[7] This function is called by libpng for each unrecognized chunk in the PNG file.  The pixel
+// statistics chunk recorded by BRetriever is decoded into the structure registered with libpng.
+// Any other chunk is left for libpng to handle.
+static int PNGAPI ReadImagePixelStatisticsChunk( png_structp pPngConfig, png_unknown_chunkp pPngChunk )
+{
+	int						bChunkWasRecognized = 0;
+	IMAGE_PIXEL_STATISTICS	*pImagePixelStatistics;
+	png_bytep				pChunkData;
+	unsigned long			nPixelsCounted;
+	unsigned __int64		PixelValueSum;
+
+	if ( memcmp( pPngChunk -> name, IMAGE_PIXEL_STATISTICS_CHUNK_NAME, 4 ) == 0 )
+		{
+		bChunkWasRecognized = 1;
+		pImagePixelStatistics = (IMAGE_PIXEL_STATISTICS*)png_get_user_chunk_ptr( pPngConfig );
+		pChunkData = pPngChunk -> data;
+		// Newer versions of the chunk may append data, but must keep the version 1 layout.
+		if ( pImagePixelStatistics != 0 && pChunkData != 0 && pPngChunk -> size >= IMAGE_PIXEL_STATISTICS_CHUNK_LENGTH &&
+					png_get_uint_16( &pChunkData[ 0 ] ) >= IMAGE_PIXEL_STATISTICS_CHUNK_VERSION )
+			{
+			nPixelsCounted = (unsigned long)png_get_uint_32( &pChunkData[ 4 ] );
+			if ( nPixelsCounted > 0 )
+				{
+				PixelValueSum = ( (unsigned __int64)png_get_uint_32( &pChunkData[ 12 ] ) << 32 ) | png_get_uint_32( &pChunkData[ 16 ] );
+				pImagePixelStatistics -> nPixelsCounted = nPixelsCounted;
+				pImagePixelStatistics -> PixelBitsSet = png_get_uint_16( &pChunkData[ 2 ] );
+				pImagePixelStatistics -> MinPixelValue = png_get_uint_16( &pChunkData[ 8 ] );
+				pImagePixelStatistics -> MaxPixelValue = png_get_uint_16( &pChunkData[ 10 ] );
+				pImagePixelStatistics -> MeanPixelValue = (double)PixelValueSum / (double)nPixelsCounted;
+				}
+			}
+		}
+
+	return bChunkWasRecognized;
+}
+
+
 BOOL CDiagnosticImage::ReadPNGImageFile( char *pFileSpec, MONITOR_INFO *pDisplayMonitor, unsigned long ImageContentType )
 {
 	BOOL					bNoError = TRUE;
@@ -1265,6 +1518,9 @@ BOOL CDiagnosticImage::ReadPNGImageFile( char *pFileSpec, MONITOR_INFO *pDisplay
 		png_init_io( pPngConfig, pImageFile );
 		// Indicate that the first 8 bytes have already been read as a signature.
 		png_set_sig_bytes( pPngConfig, 8 );
+		// *[7] Pick up the pixel statistics chunk, if BRetriever recorded one.  It follows the image data.
+		memset( &m_ImagePixelStatistics, 0, sizeof(IMAGE_PIXEL_STATISTICS) );
+		png_set_read_user_chunk_fn( pPngConfig, &m_ImagePixelStatistics, ReadImagePixelStatisticsChunk );
 		// Read all of the PNG information that precedes the image data.
 		png_read_info( pPngConfig, pPngImageInfo );
 		// Expose some of the formatting information.
@@ -1354,6 +1610,8 @@ BOOL CDiagnosticImage::ReadPNGImageFile( char *pFileSpec, MONITOR_INFO *pDisplay
 			pRowPointers[ nRow ] = m_pImageData + ( ( (int)m_ImageHeightInPixels - nRow - 1 ) * ImageRowBytes );
 		// Read the image into memory.
 		png_read_image( pPngConfig, pRowPointers );
+		// *[7] Read the chunks following the image data.
+		png_read_end( pPngConfig, pPngImageInfo );
 
 		free( pRowPointers );
 		pRowPointers = 0;
@@ -1394,7 +1652,10 @@ BOOL CDiagnosticImage::ReadPNGImageFile( char *pFileSpec, MONITOR_INFO *pDisplay
 }
 
 
-BOOL CDiagnosticImage::WritePNGImageFile( char *pFileSpec )
+#define PNG_OUTPUT_FILE_BUFFER_SIZE		0x10000			// *[4]
+
+// *[10] Set bIsReportPage for a rendered report page, which is written without PNG row filtering.
+BOOL CDiagnosticImage::WritePNGImageFile( char *pFileSpec, BOOL bIsReportPage )
 {
 	BOOL					bNoError = TRUE;
 	FILE					*pOutputImageFile;
@@ -1427,6 +1688,7 @@ BOOL CDiagnosticImage::WritePNGImageFile( char *pFileSpec )
 		}
 	else
 		{
+		setvbuf( pOutputImageFile, NULL, _IOFBF, PNG_OUTPUT_FILE_BUFFER_SIZE );		// *[4] Write the file in large blocks.
 		nImagePixelsPerRow = (long)m_OutputImageWidthInPixels;
 		nImageBytesPerRow = nImagePixelsPerRow * 3;
 		nImageOutputBitDepth = 8;
@@ -1497,6 +1759,10 @@ BOOL CDiagnosticImage::WritePNGImageFile( char *pFileSpec )
 		// bit_depth is one of 1, 2, 4, 8, or 16.
 		png_set_IHDR( pPngConfig, pPngImageInfo, nImagePixelsPerRow, nImageRows, nImageOutputBitDepth,
 						PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE );
+		// *[4] The report pages are mostly uniform background and text, which compress well without
+		// row filtering, so skip the adaptive search through the filter types on every row.
+		if ( bIsReportPage )																		// *[10]
+			png_set_filter( pPngConfig, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE );
 		// Write the file header information.
 		png_write_info( pPngConfig, pPngImageInfo );
 
@@ -87,6 +87,7 @@ public:
 	unsigned short			m_MinObservedPixelValue;
 	GLenum					m_ImageColorFormat;					// *[1] Changed data type from int to GLenum.
 	IMAGE_CALIBRATION_INFO	*m_pImageCalibrationInfo;			// Allocated by ReadPNGFileHeader().
+	IMAGE_PIXEL_STATISTICS	m_ImagePixelStatistics;				// Loaded by ReadPNGImageFile(), if recorded by BRetriever.
 	unsigned char			*m_pImageData;
 	BOOL					m_bEnableGammaCorrection;
 	BOOL					m_bEnableOverlays;
@@ -126,7 +127,7 @@ public:
 	void			ReducePixelsToEightBits();
 	void			DownSampleImageResolution();
 	BOOL			ReadPNGImageFile( char *pFileSpec, MONITOR_INFO *pDisplayMonitor, unsigned long ImageContentType );
-	BOOL			WritePNGImageFile( char *pFileSpec );
+	BOOL			WritePNGImageFile( char *pFileSpec, BOOL bIsReportPage );
 };
 
 
@@ -134,6 +135,8 @@ public:
 	void			InitImageModule();
 	void			CloseImageModule();
 	BOOL			ReadPNGFileHeader( FILE *pImageFile, IMAGE_CALIBRATION_INFO **ppImageCalibrationInfo );
+	BOOL			ReadPNGThumbnailImage( char *pFileSpec, unsigned long MaxThumbnailDimension, unsigned char **ppThumbnailData,
+											unsigned long *pThumbnailWidth, unsigned long *pThumbnailHeight );
 
 
 
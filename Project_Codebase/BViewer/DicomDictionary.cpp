@@ -30,6 +30,10 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		Read the dictionary file through a larger stream buffer.  Index the dictionary
+//		entries that specify a single tag, so that they can be located by a binary search
+//		instead of by scanning the entire dictionary for every element.
 //	*[2] 01/30/2024 by Tom Atwood
 //		Tidied up call to fgets() so it conforms exactly to the Windows prototype.
 //	*[1] 01/09/2023 by Tom Atwood
@@ -83,6 +87,80 @@ void CloseDictionaryModule()
 static DICOM_DICTIONARY_ITEM		*pDicomDictionary = 0;
 static long							nTotalDictionaryItemCount = 0;
 
+// *[3] The dictionary index.  Entries for a single tag are listed in tag order.  Entries that
+// specify a range of tags are listed in dictionary order.  Each index entry is the location of
+// the item in the pDicomDictionary array.
+static long							*pSingleTagItemIndex = 0;
+static long							nSingleTagItems = 0;
+static long							*pTagRangeItemIndex = 0;
+static long							nTagRangeItems = 0;
+
+#define DICTIONARY_FILE_BUFFER_SIZE		0x10000
+
+
+// *[3] Erase the dictionary index.
+static void DeleteDictionaryIndex()
+{
+	if ( pSingleTagItemIndex != 0 )
+		free( pSingleTagItemIndex );
+	pSingleTagItemIndex = 0;
+	nSingleTagItems = 0;
+	if ( pTagRangeItemIndex != 0 )
+		free( pTagRangeItemIndex );
+	pTagRangeItemIndex = 0;
+	nTagRangeItems = 0;
+}
+
+
+// *[3] Order the single tag index by tag and, for duplicate tags, by dictionary order.
+static int CompareSingleTagItems( const void *pIndexEntry1, const void *pIndexEntry2 )
+{
+	DICOM_DICTIONARY_ITEM		*pDictItem1;
+	DICOM_DICTIONARY_ITEM		*pDictItem2;
+	int							ComparisonResult;
+
+	pDictItem1 = &pDicomDictionary[ *(long*)pIndexEntry1 ];
+	pDictItem2 = &pDicomDictionary[ *(long*)pIndexEntry2 ];
+	if ( pDictItem1 -> Group != pDictItem2 -> Group )
+		ComparisonResult = ( pDictItem1 -> Group < pDictItem2 -> Group ) ? -1 : 1;
+	else if ( pDictItem1 -> Element != pDictItem2 -> Element )
+		ComparisonResult = ( pDictItem1 -> Element < pDictItem2 -> Element ) ? -1 : 1;
+	else
+		ComparisonResult = ( *(long*)pIndexEntry1 < *(long*)pIndexEntry2 ) ? -1 : 1;
+
+	return ComparisonResult;
+}
+
+
+// *[3] Create the dictionary index.  If there isn't enough memory for it, the dictionary is
+// searched sequentially, as before.
+static void IndexDicomDictionary()
+{
+	long						nDictionaryItem;
+	DICOM_DICTIONARY_ITEM		*pDictItem;
+
+	DeleteDictionaryIndex();
+	if ( pDicomDictionary != 0 && nTotalDictionaryItemCount > 0 )
+		{
+		pSingleTagItemIndex = (long*)malloc( nTotalDictionaryItemCount * sizeof(long) );
+		pTagRangeItemIndex = (long*)malloc( nTotalDictionaryItemCount * sizeof(long) );
+		if ( pSingleTagItemIndex != 0 && pTagRangeItemIndex != 0 )
+			{
+			for ( nDictionaryItem = 0; nDictionaryItem < nTotalDictionaryItemCount; nDictionaryItem++ )
+				{
+				pDictItem = &pDicomDictionary[ nDictionaryItem ];
+				if ( pDictItem -> EndOfGroupRange == pDictItem -> Group && pDictItem -> EndOfElementRange == pDictItem -> Element &&
+							pDictItem -> GroupConstraint == MATCH_ANY && pDictItem -> ElementConstraint == MATCH_ANY )
+					pSingleTagItemIndex[ nSingleTagItems++ ] = nDictionaryItem;
+				else
+					pTagRangeItemIndex[ nTagRangeItems++ ] = nDictionaryItem;
+				}
+			qsort( pSingleTagItemIndex, nSingleTagItems, sizeof(long), CompareSingleTagItems );
+			}
+		else
+			DeleteDictionaryIndex();
+		}
+}
 
 
 // The contents of the Dicom dictionary are read into memory during program initialization
@@ -105,6 +183,7 @@ BOOL ReadDictionaryFile( char *DicomDictionaryFileSpec )
 	pDictFile = fopen( DicomDictionaryFileSpec, "rt" );
 	if ( pDictFile != 0 )
 		{
+		setvbuf( pDictFile, NULL, _IOFBF, DICTIONARY_FILE_BUFFER_SIZE );		// *[3]
 		nDictionaryItems = 0L;
 		// Count the number of items in the dictionary.
 		do
@@ -134,6 +213,7 @@ BOOL ReadDictionaryFile( char *DicomDictionaryFileSpec )
 				free( pDicomDictionary );
 				pDicomDictionary = 0;
 				nTotalDictionaryItemCount = 0;
+				DeleteDictionaryIndex();										// *[3]
 				}
 			// Now allocate the required memory and read the dictionary entries into memory.
 			pDicomDictionary = (DICOM_DICTIONARY_ITEM*)malloc( ( nDictionaryItems + 1 ) * sizeof( DICOM_DICTIONARY_ITEM ) );
@@ -162,6 +242,7 @@ BOOL ReadDictionaryFile( char *DicomDictionaryFileSpec )
 					}
 				while ( FileStatus == FILE_STATUS_OK );
 				nTotalDictionaryItemCount = nDictionaryItem;
+				IndexDicomDictionary();											// *[3]
 
 				if ( FileStatus & FILE_STATUS_READ_ERROR )
 					{
@@ -334,7 +415,8 @@ BOOL ParseDictionaryItem( char DictionaryLine[], DICOM_DICTIONARY_ITEM* pDictIte
 }
 
 
-DICOM_DICTIONARY_ITEM *GetDicomElementFromDictionary( TAG DicomElementTag )
+// *[3] Search the specified dictionary items sequentially for the first entry matching the tag.
+static DICOM_DICTIONARY_ITEM *SearchDictionary( TAG DicomElementTag, DICOM_DICTIONARY_ITEM *pFirstDicomDictionaryItem, long nDictionaryItems )
 {
 	DICOM_DICTIONARY_ITEM	*pDictItem;
 	BOOL					bMatchingItemFound;
@@ -344,9 +426,9 @@ DICOM_DICTIONARY_ITEM *GetDicomElementFromDictionary( TAG DicomElementTag )
 	pDictItem = 0;
 	// Read the value representation and the value length.
 	bMatchingItemFound = FALSE;
-	for ( nDictionaryItem = 0; nDictionaryItem < nTotalDictionaryItemCount && !bMatchingItemFound; nDictionaryItem++ )
+	for ( nDictionaryItem = 0; nDictionaryItem < nDictionaryItems && !bMatchingItemFound; nDictionaryItem++ )
 		{
-		pDictItem = &pDicomDictionary[ nDictionaryItem ];
+		pDictItem = &pFirstDicomDictionaryItem[ nDictionaryItem ];
 		if ( DicomElementTag.Group >= pDictItem -> Group &&
 						DicomElementTag.Group <= pDictItem -> EndOfGroupRange )
 			{
@@ -399,6 +481,66 @@ DICOM_DICTIONARY_ITEM *GetDicomElementFromDictionary( TAG DicomElementTag )
 }
 
 
+// *[3] Locate the first dictionary entry matching the tag, using the dictionary index.  This
+// produces the same result as a sequential search of the dictionary.
+static DICOM_DICTIONARY_ITEM *SearchIndexedDictionary( TAG DicomElementTag )
+{
+	DICOM_DICTIONARY_ITEM		*pDictItem;
+	DICOM_DICTIONARY_ITEM		*pIndexedItem;
+	long						nLowIndex;
+	long						nHighIndex;
+	long						nMiddleIndex;
+	long						nMatchingItem;
+	long						nRangeItem;
+
+	// Find the first single tag entry that matches the tag.
+	nMatchingItem = nTotalDictionaryItemCount;
+	nLowIndex = 0;
+	nHighIndex = nSingleTagItems;
+	while ( nLowIndex < nHighIndex )
+		{
+		nMiddleIndex = ( nLowIndex + nHighIndex ) / 2;
+		pIndexedItem = &pDicomDictionary[ pSingleTagItemIndex[ nMiddleIndex ] ];
+		if ( pIndexedItem -> Group < DicomElementTag.Group ||
+					( pIndexedItem -> Group == DicomElementTag.Group && pIndexedItem -> Element < DicomElementTag.Element ) )
+			nLowIndex = nMiddleIndex + 1;
+		else
+			nHighIndex = nMiddleIndex;
+		}
+	if ( nLowIndex < nSingleTagItems )
+		{
+		pIndexedItem = &pDicomDictionary[ pSingleTagItemIndex[ nLowIndex ] ];
+		if ( pIndexedItem -> Group == DicomElementTag.Group && pIndexedItem -> Element == DicomElementTag.Element )
+			nMatchingItem = pSingleTagItemIndex[ nLowIndex ];
+		}
+	// An entry for a range of tags takes precedence if it appears earlier in the dictionary.
+	for ( nRangeItem = 0; nRangeItem < nTagRangeItems && pTagRangeItemIndex[ nRangeItem ] < nMatchingItem; nRangeItem++ )
+		{
+		if ( SearchDictionary( DicomElementTag, &pDicomDictionary[ pTagRangeItemIndex[ nRangeItem ] ], 1 ) != 0 )
+			nMatchingItem = pTagRangeItemIndex[ nRangeItem ];
+		}
+	if ( nMatchingItem < nTotalDictionaryItemCount )
+		pDictItem = &pDicomDictionary[ nMatchingItem ];
+	else
+		pDictItem = 0;
+
+	return pDictItem;
+}
+
+
+DICOM_DICTIONARY_ITEM *GetDicomElementFromDictionary( TAG DicomElementTag )
+{
+	DICOM_DICTIONARY_ITEM	*pDictItem;
+
+	if ( pSingleTagItemIndex != 0 )																// *[3]
+		pDictItem = SearchIndexedDictionary( DicomElementTag );
+	else
+		pDictItem = SearchDictionary( DicomElementTag, pDicomDictionary, nTotalDictionaryItemCount );
+
+	return pDictItem;
+}
+
+
 void DeallocateDicomDictionary()
 {
 	long					nDictionaryItem;
@@ -418,6 +560,7 @@ void DeallocateDicomDictionary()
 		free( pDicomDictionary );
 		pDicomDictionary = 0;
 		}
+	DeleteDictionaryIndex();			// *[3]
 }
 
 
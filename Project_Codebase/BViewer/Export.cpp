@@ -28,6 +28,9 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		Add imported studies through AddStudyToList(), which files them in the patient index.
+//		A study that cannot be added is discarded.
 //	*[2] 03/14/2023 by Tom Atwood
 //		Fixed code security issues.
 //	*[1] 12/21/2022 by Tom Atwood
@@ -589,11 +592,14 @@ void ImportAbstractStudyRow( char *pTitleRow, char *pDataRow )
 				LogMessage( TextString, MESSAGE_TYPE_SUPPLEMENTARY );
 				if ( BViewerConfiguration.bAutoGeneratePDFReportsFromAXTFiles )
 					{
-					AppendToList( &ThisBViewerApp.m_AvailableStudyList, (void*)pNewStudy );
-					strncpy_s( ThisBViewerApp.m_AutoLoadSOPInstanceUID, DICOM_ATTRIBUTE_UI_STRING_LENGTH, pSOPInstanceUID, _TRUNCATE );			// *[1] Replaced strcpy with strncpy_s.
+					bNoError = ThisBViewerApp.AddStudyToList( &ThisBViewerApp.m_AvailableStudyList, pNewStudy );		// *[3]
+					if ( bNoError )																						// *[3]
+						strncpy_s( ThisBViewerApp.m_AutoLoadSOPInstanceUID, DICOM_ATTRIBUTE_UI_STRING_LENGTH, pSOPInstanceUID, _TRUNCATE );			// *[1] Replaced strcpy with strncpy_s.
 					}
 				else
-					AppendToList( &ThisBViewerApp.m_NewlyArrivedStudyList, (void*)pNewStudy );
+					bNoError = ThisBViewerApp.AddStudyToList( &ThisBViewerApp.m_NewlyArrivedStudyList, pNewStudy );	// *[3]
+				if ( !bNoError )																						// *[3]
+					delete pNewStudy;																					// *[3]
 				}
 			}
 		else if ( pNewStudy != 0 )			// *[1] Prevent memory leak if an error occurs.
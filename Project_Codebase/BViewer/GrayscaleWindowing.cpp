@@ -0,0 +1,248 @@
+// GrayscaleWindowing.cpp : Implements the CPU version of the grayscale windowing performed by the
+//  image display shaders.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include <math.h>
+#include "Module.h"
+#include "GrayscaleWindowing.h"
+
+
+// The windowing fragment shaders in ImageView.cpp compute each displayed pixel from the image
+// pixel under it.  These functions perform the same calculation without the GPU, for images
+// displayed, or written, one image pixel to one output pixel.  Any change to the calculation in
+// the shaders must be made here, too.
+//
+// Since the result depends only upon the stored pixel value, it is calculated once for each
+// possible value, and the image is then converted through the resulting table.
+
+
+// Return the shader's fCorrectedGrayIndex, before it is clamped or inverted, for a pixel value
+// that has been normalized into the range [0, 1], as the texture sampler presents it.
+double CalculateCorrectedGrayIndex( GRAYSCALE_WINDOWING *pWindowing, double MaxGrayIndex, double NormalizedPixelValue )
+{
+	double				UpScaledGrayIndex;
+	double				WindowMin;
+	double				WindowMax;
+
+	WindowMin = pWindowing -> WindowMinPixelAmplitude;
+	WindowMax = pWindowing -> WindowMaxPixelAmplitude;
+	UpScaledGrayIndex = NormalizedPixelValue * MaxGrayIndex;
+	// Apply VOI windowing, if specified.
+	if ( WindowMin != 0.0 && WindowMax > 1.0 )
+		{
+		if ( pWindowing -> bWindowingIsSigmoidal )
+			UpScaledGrayIndex = MaxGrayIndex / ( 1.0 + exp( -4.0 * ( UpScaledGrayIndex - ( WindowMax - WindowMin ) / 2.0 ) / ( WindowMax - WindowMin ) ) );
+		else if ( UpScaledGrayIndex <= WindowMin )
+			UpScaledGrayIndex = 0.0;
+		else if ( UpScaledGrayIndex > WindowMax )
+			UpScaledGrayIndex = MaxGrayIndex;
+		else
+			UpScaledGrayIndex = ( MaxGrayIndex / ( WindowMax - WindowMin ) ) * ( UpScaledGrayIndex - WindowMin );
+		}
+
+	return pow( UpScaledGrayIndex / MaxGrayIndex, pWindowing -> Gamma );
+}
+
+
+// Sample the packing table as the 10-bit grayscale shader samples it, as a one-dimensional texture
+// with linear interpolation between entries.  Positions beyond either end of the table are
+// blended with the texture's black border color.
+static void SamplePackingTable( unsigned char *pPackingTable, double TextureCoordinate, unsigned char *pRGBPixel )
+{
+	double				TexelPosition;
+	double				Fraction;
+	long				nLowerTexel;
+	int					nChannel;
+	double				LowerValue;
+	double				UpperValue;
+
+	TexelPosition = TextureCoordinate * (double)GRAYSCALE_PACKING_TABLE_SIZE - 0.5;
+	nLowerTexel = (long)floor( TexelPosition );
+	Fraction = TexelPosition - (double)nLowerTexel;
+	for ( nChannel = 0; nChannel < 3; nChannel++ )
+		{
+		LowerValue = 0.0;
+		UpperValue = 0.0;
+		if ( nLowerTexel >= 0 && nLowerTexel < GRAYSCALE_PACKING_TABLE_SIZE )
+			LowerValue = (double)pPackingTable[ nLowerTexel * 3 + nChannel ];
+		if ( nLowerTexel + 1 >= 0 && nLowerTexel + 1 < GRAYSCALE_PACKING_TABLE_SIZE )
+			UpperValue = (double)pPackingTable[ ( nLowerTexel + 1 ) * 3 + nChannel ];
+		pRGBPixel[ nChannel ] = (unsigned char)( LowerValue + Fraction * ( UpperValue - LowerValue ) + 0.5 );
+		}
+}
+
+
+// Calculate the output pixel for each stored pixel value of an image with the specified bit
+// depth.  The 12-bit grayscale packing table, as produced by CGraphicsAdapter::GenerateRGBLookupTable(),
+// is only needed for GRAYSCALE_OUTPUT_PACKED_RGB.  The table must be released by
+// ReleaseGrayscaleWindowingTable().  FALSE is returned for unsupported parameters, or if the
+// table can't be allocated.
+BOOL PrepareGrayscaleWindowingTable( GRAYSCALE_WINDOWING_TABLE *pWindowingTable, GRAYSCALE_WINDOWING *pWindowing,
+										int nStoredBitsPerPixel, int ImageBitDepth, int OutputFormat, unsigned char *pPackingTable )
+{
+	BOOL				bNoError = TRUE;
+	unsigned long		nBytesPerEntry = 0;
+	unsigned long		nPixelValue;
+	double				MaxGrayIndex;
+	double				MaxStoredValue;
+	double				CorrectedGrayIndex;
+	unsigned short		OutputLevel;
+
+	memset( pWindowingTable, 0, sizeof(GRAYSCALE_WINDOWING_TABLE) );
+	bNoError = ( ( nStoredBitsPerPixel == 8 || nStoredBitsPerPixel == 16 ) && ImageBitDepth >= 1 && ImageBitDepth <= 16 );
+	if ( bNoError )
+		{
+		switch ( OutputFormat )
+			{
+			case GRAYSCALE_OUTPUT_8BIT:
+				nBytesPerEntry = 1;
+				break;
+			case GRAYSCALE_OUTPUT_10BIT:
+				nBytesPerEntry = sizeof(unsigned short);
+				break;
+			case GRAYSCALE_OUTPUT_PACKED_RGB:
+				nBytesPerEntry = 3;
+				bNoError = ( pPackingTable != 0 );
+				break;
+			default:
+				bNoError = FALSE;
+				break;
+			}
+		}
+	if ( bNoError )
+		{
+		pWindowingTable -> nTableEntries = 1UL << nStoredBitsPerPixel;
+		pWindowingTable -> pOutputTable = (unsigned char*)malloc( pWindowingTable -> nTableEntries * nBytesPerEntry );
+		bNoError = ( pWindowingTable -> pOutputTable != 0 );
+		}
+	if ( bNoError )
+		{
+		pWindowingTable -> OutputFormat = OutputFormat;
+		pWindowingTable -> nStoredBitsPerPixel = nStoredBitsPerPixel;
+		// The shader is given a MaxGrayIndex of 2 to the power of the image bit depth, while the
+		// texture sampler normalizes each stored value by the largest value the texture holds.
+		MaxGrayIndex = (double)( 2 << ( ImageBitDepth - 1 ) );
+		MaxStoredValue = (double)( pWindowingTable -> nTableEntries - 1 );
+		for ( nPixelValue = 0; nPixelValue < pWindowingTable -> nTableEntries; nPixelValue++ )
+			{
+			CorrectedGrayIndex = CalculateCorrectedGrayIndex( pWindowing, MaxGrayIndex, (double)nPixelValue / MaxStoredValue );
+			if ( OutputFormat == GRAYSCALE_OUTPUT_PACKED_RGB )
+				{
+				// The 10-bit grayscale shader clamps the value before inverting it, keeping it
+				// within the lookup table.
+				if ( CorrectedGrayIndex < 0.0 )
+					CorrectedGrayIndex = 0.0;
+				if ( CorrectedGrayIndex > 0.999 )
+					CorrectedGrayIndex = 0.999;
+				if ( pWindowing -> bColorsInverted )
+					CorrectedGrayIndex = 1.0 - CorrectedGrayIndex;
+				SamplePackingTable( pPackingTable, CorrectedGrayIndex, &pWindowingTable -> pOutputTable[ nPixelValue * 3 ] );
+				}
+			else
+				{
+				// The frame buffer clamps the inverted value into the range [0, 1].
+				if ( pWindowing -> bColorsInverted )
+					CorrectedGrayIndex = 1.0 - CorrectedGrayIndex;
+				if ( CorrectedGrayIndex < 0.0 )
+					CorrectedGrayIndex = 0.0;
+				if ( CorrectedGrayIndex > 1.0 )
+					CorrectedGrayIndex = 1.0;
+				if ( OutputFormat == GRAYSCALE_OUTPUT_8BIT )
+					pWindowingTable -> pOutputTable[ nPixelValue ] = (unsigned char)( CorrectedGrayIndex * 255.0 + 0.5 );
+				else
+					{
+					OutputLevel = (unsigned short)( CorrectedGrayIndex * 1023.0 + 0.5 );
+					( (unsigned short*)pWindowingTable -> pOutputTable )[ nPixelValue ] = OutputLevel;
+					}
+				}
+			}
+		}
+
+	return bNoError;
+}
+
+
+void ReleaseGrayscaleWindowingTable( GRAYSCALE_WINDOWING_TABLE *pWindowingTable )
+{
+	if ( pWindowingTable -> pOutputTable != 0 )
+		free( pWindowingTable -> pOutputTable );
+	memset( pWindowingTable, 0, sizeof(GRAYSCALE_WINDOWING_TABLE) );
+}
+
+
+// Convert a run of stored pixels into output pixels of the table's format.  The input pixels are
+// bytes or unsigned shorts, according to the table's stored bits per pixel.
+void WindowGrayscalePixels( GRAYSCALE_WINDOWING_TABLE *pWindowingTable, void *pInputPixels, unsigned long nPixels, void *pOutputPixels )
+{
+	unsigned char		*p8BitInput;
+	unsigned short		*p16BitInput;
+	unsigned char		*pOutputTable;
+	unsigned char		*p8BitOutput;
+	unsigned short		*p16BitOutput;
+	unsigned char		*pTableEntry;
+	unsigned long		nPixel;
+
+	p8BitInput = (unsigned char*)pInputPixels;
+	p16BitInput = (unsigned short*)pInputPixels;
+	pOutputTable = pWindowingTable -> pOutputTable;
+	p8BitOutput = (unsigned char*)pOutputPixels;
+	p16BitOutput = (unsigned short*)pOutputPixels;
+	// The loops are kept separate, so that each is a plain table lookup per pixel.
+	switch ( pWindowingTable -> OutputFormat )
+		{
+		case GRAYSCALE_OUTPUT_8BIT:
+			if ( pWindowingTable -> nStoredBitsPerPixel == 8 )
+				for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+					p8BitOutput[ nPixel ] = pOutputTable[ p8BitInput[ nPixel ] ];
+			else
+				for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+					p8BitOutput[ nPixel ] = pOutputTable[ p16BitInput[ nPixel ] ];
+			break;
+		case GRAYSCALE_OUTPUT_10BIT:
+			if ( pWindowingTable -> nStoredBitsPerPixel == 8 )
+				for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+					p16BitOutput[ nPixel ] = ( (unsigned short*)pOutputTable )[ p8BitInput[ nPixel ] ];
+			else
+				for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+					p16BitOutput[ nPixel ] = ( (unsigned short*)pOutputTable )[ p16BitInput[ nPixel ] ];
+			break;
+		case GRAYSCALE_OUTPUT_PACKED_RGB:
+			for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+				{
+				if ( pWindowingTable -> nStoredBitsPerPixel == 8 )
+					pTableEntry = &pOutputTable[ p8BitInput[ nPixel ] * 3 ];
+				else
+					pTableEntry = &pOutputTable[ p16BitInput[ nPixel ] * 3 ];
+				*p8BitOutput++ = pTableEntry[ 0 ];
+				*p8BitOutput++ = pTableEntry[ 1 ];
+				*p8BitOutput++ = pTableEntry[ 2 ];
+				}
+			break;
+		}
+}
+
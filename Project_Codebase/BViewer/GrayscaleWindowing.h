@@ -0,0 +1,77 @@
+// GrayscaleWindowing.h : Defines the CPU version of the grayscale windowing performed by the
+//  image display shaders.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#pragma once
+
+#include "Module.h"
+
+
+// The output pixel formats, corresponding to the image rendering methods.
+#define GRAYSCALE_OUTPUT_8BIT				1		// One byte per pixel, as written to an 8-bit frame buffer.
+#define GRAYSCALE_OUTPUT_10BIT				2		// One unsigned short per pixel, from 0 to 1023, as written to a 10-bit frame buffer.
+#define GRAYSCALE_OUTPUT_PACKED_RGB			3		// Three bytes per pixel, packed through the 12-bit grayscale lookup table.
+
+// The number of entries in the lookup table that packs 12-bit grayscale values into RGB pixels for
+// 10-bit grayscale displays.  Each entry holds a red, a green and a blue byte.
+#define GRAYSCALE_PACKING_TABLE_SIZE		4096
+
+
+// The windowing parameters passed to the display shaders.  The window limits are in units of
+// the image's gray index, from 0 to 2 to the power of the image bit depth.  As in the shaders, no
+// windowing is applied unless WindowMinPixelAmplitude is nonzero and WindowMaxPixelAmplitude
+// is greater than 1.
+typedef struct
+	{
+	double			WindowMinPixelAmplitude;
+	double			WindowMaxPixelAmplitude;
+	double			Gamma;
+	BOOL			bWindowingIsSigmoidal;
+	BOOL			bColorsInverted;
+	} GRAYSCALE_WINDOWING;
+
+
+// The windowed output pixel for each possible stored pixel value.
+typedef struct
+	{
+	int				OutputFormat;
+	int				nStoredBitsPerPixel;			// 8 or 16.
+	unsigned long	nTableEntries;
+	unsigned char	*pOutputTable;
+	} GRAYSCALE_WINDOWING_TABLE;
+
+
+
+// Function prototypes.
+//
+double				CalculateCorrectedGrayIndex( GRAYSCALE_WINDOWING *pWindowing, double MaxGrayIndex, double NormalizedPixelValue );
+BOOL				PrepareGrayscaleWindowingTable( GRAYSCALE_WINDOWING_TABLE *pWindowingTable, GRAYSCALE_WINDOWING *pWindowing,
+													int nStoredBitsPerPixel, int ImageBitDepth, int OutputFormat, unsigned char *pPackingTable );
+void				ReleaseGrayscaleWindowingTable( GRAYSCALE_WINDOWING_TABLE *pWindowingTable );
+void				WindowGrayscalePixels( GRAYSCALE_WINDOWING_TABLE *pWindowingTable, void *pInputPixels, unsigned long nPixels, void *pOutputPixels );
+
@@ -30,6 +30,22 @@
 //
 // UPDATE HISTORY:
 //
+//	*[11] 10/19/2026 by agent
+//		Draw saved report pages without the GPU.  RenderReport() records its checkmarks,
+//		text and signature on a report page, which ReportRasterizer.cpp rasterizes over
+//		the report form into the output image buffer.  Printed pages are still rendered
+//		by OpenGL.
+//	*[10] 10/19/2026 by agent
+//		Noted that the windowing shaders' calculation is repeated in GrayscaleWindowing.cpp.
+//	*[9] 10/19/2026 by agent
+//		Read the report pixels for printing with 1-byte row alignment, too, so that rows
+//		aren't padded past the end of the output buffer, and copy them into the printable
+//		bitmap a row at a time at its 4-byte row alignment.  Designate saved report pages
+//		to the PNG writer.
+//	*[8] 10/19/2026 by agent
+//		Free the report output image buffer after each saved report page, and before
+//		another is allocated, instead of letting each page's buffer leak.  Read the
+//		report pixels for a saved file with 1-byte row alignment to match the PNG writer.
 //	*[7] 02/01/2024 by Tom Atwood
 //		Fixed code security issues.
 //	*[6] 07/06/2023 by Tom Atwood
@@ -147,6 +163,13 @@ CImageView::CImageView()
 		m_bEnableAnnotations = TRUE;
 	m_bRenderingCurrentlyBusy = FALSE;
 	m_bImageHasBeenRendered = FALSE;
+	m_pReportPage = 0;																			// *[11]
+	// *[11] The report glyph bitmaps may be kept in memory after the fonts are created, so start without any.
+	memset( m_ReportDateStringFontGlyphBitmapArray, 0, sizeof( m_ReportDateStringFontGlyphBitmapArray ) );
+	memset( m_ReportCommentFontGlyphBitmapArray, 0, sizeof( m_ReportCommentFontGlyphBitmapArray ) );
+	memset( m_ReportBoldTextFontGlyphBitmapArray, 0, sizeof( m_ReportBoldTextFontGlyphBitmapArray ) );
+	memset( m_ReportSmallTextFontGlyphBitmapArray, 0, sizeof( m_ReportSmallTextFontGlyphBitmapArray ) );
+	memset( m_ReportSmallItalicFontGlyphBitmapArray, 0, sizeof( m_ReportSmallItalicFontGlyphBitmapArray ) );
 	m_OffScreenFrameBufferID = 0;
 	m_ReportFormFrameBufferID = 0;
 
@@ -2111,7 +2134,7 @@ void CImageView::CreateReportTextVertices( GLuint hShaderProgram )
 {
 	CFont					TextFont;
 
-	if ( m_pAssignedDiagnosticImage != 0 )
+	if ( m_pAssignedDiagnosticImage != 0 && m_pReportPage == 0 )			// *[11] Nothing is needed for a recorded report page.
 		{
 		glUseProgram( hShaderProgram );
 			
@@ -2144,14 +2167,17 @@ void CImageView::CreateReportTextVertices( GLuint hShaderProgram )
 
 void CImageView::DeleteReportTextVertices( GLuint hShaderProgram )
 {
-	glUseProgram( hShaderProgram );
-	glDeleteVertexArrays( 1, &m_ReportVertexAttributesID );
-	glDeleteBuffers( 1, &m_ReportVertexBufferID );
-	glDisable( GL_BLEND );
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glActiveTexture( TEXTURE_UNIT_DEFAULT );
-	glUseProgram( 0 );
-	CheckOpenGLResultAt( __FILE__, __LINE__	);
+	if ( m_pReportPage == 0 )			// *[11] Nothing was created for a recorded report page.
+		{
+		glUseProgram( hShaderProgram );
+		glDeleteVertexArrays( 1, &m_ReportVertexAttributesID );
+		glDeleteBuffers( 1, &m_ReportVertexBufferID );
+		glDisable( GL_BLEND );
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glActiveTexture( TEXTURE_UNIT_DEFAULT );
+		glUseProgram( 0 );
+		CheckOpenGLResultAt( __FILE__, __LINE__	);
+		}
 }
 
 
@@ -2204,6 +2230,40 @@ void CImageView::RenderReportCheckmark()
 }
 
 
+// *[11] Record the two quads of the "X" mark in m_XMarkVertexArray on the report page.  The
+//		vertices are converted from the GPU coordinates back into pixels.
+void CImageView::RecordReportCheckmark()
+{
+	float					HalfPageWidth;
+	float					HalfPageHeight;
+	float					Vertex[ 4 ][ 2 ];
+	GLfloat					Color[ 3 ] = { 0.0f, 0.0f, 0.5f };
+
+	HalfPageWidth = (float)m_pReportPage -> WidthInPixels / 2.0f;
+	HalfPageHeight = (float)m_pReportPage -> HeightInPixels / 2.0f;
+
+	Vertex[ 0 ][ 0 ] = ( m_XMarkVertexArray.FwdSlashXbl + 1.0f ) * HalfPageWidth;
+	Vertex[ 0 ][ 1 ] = ( m_XMarkVertexArray.FwdSlashYbl + 1.0f ) * HalfPageHeight;
+	Vertex[ 1 ][ 0 ] = ( m_XMarkVertexArray.FwdSlashXbr + 1.0f ) * HalfPageWidth;
+	Vertex[ 1 ][ 1 ] = ( m_XMarkVertexArray.FwdSlashYbr + 1.0f ) * HalfPageHeight;
+	Vertex[ 2 ][ 0 ] = ( m_XMarkVertexArray.FwdSlashXtl + 1.0f ) * HalfPageWidth;
+	Vertex[ 2 ][ 1 ] = ( m_XMarkVertexArray.FwdSlashYtl + 1.0f ) * HalfPageHeight;
+	Vertex[ 3 ][ 0 ] = ( m_XMarkVertexArray.FwdSlashXtr + 1.0f ) * HalfPageWidth;
+	Vertex[ 3 ][ 1 ] = ( m_XMarkVertexArray.FwdSlashYtr + 1.0f ) * HalfPageHeight;
+	AddReportQuad( m_pReportPage, Vertex, Color );
+
+	Vertex[ 0 ][ 0 ] = ( m_XMarkVertexArray.BkwdSlashXbl + 1.0f ) * HalfPageWidth;
+	Vertex[ 0 ][ 1 ] = ( m_XMarkVertexArray.BkwdSlashYbl + 1.0f ) * HalfPageHeight;
+	Vertex[ 1 ][ 0 ] = ( m_XMarkVertexArray.BkwdSlashXbr + 1.0f ) * HalfPageWidth;
+	Vertex[ 1 ][ 1 ] = ( m_XMarkVertexArray.BkwdSlashYbr + 1.0f ) * HalfPageHeight;
+	Vertex[ 2 ][ 0 ] = ( m_XMarkVertexArray.BkwdSlashXtl + 1.0f ) * HalfPageWidth;
+	Vertex[ 2 ][ 1 ] = ( m_XMarkVertexArray.BkwdSlashYtl + 1.0f ) * HalfPageHeight;
+	Vertex[ 3 ][ 0 ] = ( m_XMarkVertexArray.BkwdSlashXtr + 1.0f ) * HalfPageWidth;
+	Vertex[ 3 ][ 1 ] = ( m_XMarkVertexArray.BkwdSlashYtr + 1.0f ) * HalfPageHeight;
+	AddReportQuad( m_pReportPage, Vertex, Color );
+}
+
+
 // *[4] The text-rendering parts of this function were heavily revised to convert from
 //		Requiring a separate texture for each character in each different font to using
 //		a single indexed texture for the entire font.
@@ -2271,9 +2331,17 @@ void CImageView::RenderReport( HDC hDC, unsigned long ImageDestination )
 
 	CheckOpenGLResultAt( __FILE__, __LINE__ );
 
-	glGetFloatv( GL_VIEWPORT, ViewportRect );
-	ViewportWidth = ViewportRect[ 2 ] - ViewportRect[ 0 ];
-	ViewportHeight = ViewportRect[ 3 ] - ViewportRect[ 1 ];
+	if ( m_pReportPage != 0 )												// *[11] A recorded report page covers the whole page.
+		{
+		ViewportWidth = (GLfloat)m_pReportPage -> WidthInPixels;
+		ViewportHeight = (GLfloat)m_pReportPage -> HeightInPixels;
+		}
+	else
+		{
+		glGetFloatv( GL_VIEWPORT, ViewportRect );
+		ViewportWidth = ViewportRect[ 2 ] - ViewportRect[ 0 ];
+		ViewportHeight = ViewportRect[ 3 ] - ViewportRect[ 1 ];
+		}
 	BaseScale = (GLfloat)m_pAssignedDiagnosticImage -> m_ScaleFactor;
 	BaseScale2 = 2.78f;							// *[3] Moved up here to ensure it is initialized.
 
@@ -2438,7 +2506,10 @@ void CImageView::RenderReport( HDC hDC, unsigned long ImageDestination )
 						m_XMarkVertexArray.BkwdSlashXtr = x + XLineWidth;
 						m_XMarkVertexArray.BkwdSlashYtr = y + MarkDy;
 
-						RenderReportCheckmark();
+						if ( m_pReportPage != 0 )								// *[11]
+							RecordReportCheckmark();
+						else
+							RenderReportCheckmark();
 //						CheckOpenGLResultAt( __FILE__, __LINE__ );
 						}
 					}
@@ -2742,7 +2813,12 @@ void CImageView::RenderReport( HDC hDC, unsigned long ImageDestination )
 						ScaledBitmapWidth = 0.306f * BaseScale2 * pSignatureBitmap -> WidthInPixels;
 						ScaledBitmapHeight = 0.306f *BaseScale2 * pSignatureBitmap -> HeightInPixels;
 
-						RenderSignatureTexture( hShaderProgram, pSignatureBitmap, m_ReportVertexBufferID, m_ReportVertexAttributesID,
+						// *[11] The signature fills half of its scaled dimensions, as drawn by RenderSignatureTexture().
+						if ( m_pReportPage != 0 )
+							AddReportBitmap( m_pReportPage, pSignatureBitmap -> pImageData, pSignatureBitmap -> WidthInPixels, pSignatureBitmap -> HeightInPixels,
+																			CharPosX, CharPosY, ScaledBitmapWidth / 2.0f, ScaledBitmapHeight / 2.0f );
+						else
+							RenderSignatureTexture( hShaderProgram, pSignatureBitmap, m_ReportVertexBufferID, m_ReportVertexAttributesID,
 																			CharPosX, CharPosY, ScaledBitmapWidth, ScaledBitmapHeight );
 						}
 					CheckOpenGLResultAt( __FILE__, __LINE__	);
@@ -2924,6 +3000,8 @@ void CImageView::CreateReportImage( unsigned long ImageDestination, BOOL bUseCur
 				RenderReport( m_hDC, IMAGE_DESTINATION_FILE );
 
 			// Allocate an output buffer associated with the current study and load it from the temporary framebuffer.
+			if ( m_pAssignedDiagnosticImage -> m_pOutputImageData != 0 )			// *[8] Release the buffer for any previous page.
+				free( m_pAssignedDiagnosticImage -> m_pOutputImageData );
 			m_pAssignedDiagnosticImage -> m_pOutputImageData = (unsigned char*)malloc( (int)( ReportFormWidthInPixels * ReportFormHeighthInPixels * 3.0f ) );
 			if ( ImageDestination == IMAGE_DESTINATION_PRINTER )
 				OutputColorFormat = GL_BGR;
@@ -2933,7 +3011,10 @@ void CImageView::CreateReportImage( unsigned long ImageDestination, BOOL bUseCur
 			if ( m_pAssignedDiagnosticImage -> m_pOutputImageData != 0 )			// *[3] Added allocation check.
 				{
 				LogMessage( "Reading the report form image texture into the report image output buffer.", MESSAGE_TYPE_SUPPLEMENTARY );		// *[2] Added report logging.
+				// *[8] The output buffer holds tightly packed rows.  *[9] This applies to both destinations.
+				glPixelStorei( GL_PACK_ALIGNMENT, 1 );
 				glReadPixels( 0, 0, (GLsizei)ReportFormWidthInPixels, (GLsizei)ReportFormHeighthInPixels, OutputColorFormat, GL_UNSIGNED_BYTE, m_pAssignedDiagnosticImage -> m_pOutputImageData );
+				glPixelStorei( GL_PACK_ALIGNMENT, 4 );
 				m_pAssignedDiagnosticImage -> m_OutputImageHeightInPixels = m_pAssignedDiagnosticImage -> m_ImageHeightInPixels;
 				m_pAssignedDiagnosticImage -> m_OutputImageWidthInPixels = m_pAssignedDiagnosticImage -> m_ImageWidthInPixels;
 				}
@@ -2952,6 +3033,52 @@ void CImageView::CreateReportImage( unsigned long ImageDestination, BOOL bUseCur
 }
 
 
+// *[11] This function draws a full-scale report image for saving to a file, without the GPU.
+//		RenderReport() records its drawing on a report page, which is then rasterized over
+//		the report form directly into the output image buffer.
+void CImageView::RasterizeReportImage( BOOL bUseCurrentStudy )
+{
+	REPORT_PAGE			ReportPage;
+	REPORT_PAGE			*pReportPage;
+	unsigned char		*pReportFormPixels = 0;
+
+	if ( m_pAssignedDiagnosticImage -> m_pOutputImageData != 0 )			// Release the buffer for any previous page.
+		free( m_pAssignedDiagnosticImage -> m_pOutputImageData );
+	m_pAssignedDiagnosticImage -> m_pOutputImageData = 0;
+	m_pAssignedDiagnosticImage -> m_OutputImageHeightInPixels = 0;
+	m_pAssignedDiagnosticImage -> m_OutputImageWidthInPixels = 0;
+	// The report form is read in as RGB rows from the bottom up, the same as the output image.
+	if ( m_pAssignedDiagnosticImage -> m_SamplesPerPixel == 3 )
+		pReportFormPixels = m_pAssignedDiagnosticImage -> m_pImageData;
+	if ( InitializeReportPage( &ReportPage, (long)m_pAssignedDiagnosticImage -> m_ImageWidthInPixels,
+									(long)m_pAssignedDiagnosticImage -> m_ImageHeightInPixels, pReportFormPixels ) )
+		{
+		if ( bUseCurrentStudy )
+			{
+			m_pReportPage = &ReportPage;
+			RenderReport( m_hDC, IMAGE_DESTINATION_FILE );
+			m_pReportPage = 0;
+			}
+		LogMessage( "Rasterizing the report page into the report image output buffer.", MESSAGE_TYPE_SUPPLEMENTARY );
+		pReportPage = &ReportPage;
+		RasterizeReportPages( &pReportPage, 1, MAX_REPORT_RASTER_THREADS );
+		// Hand the page's pixels over as the output image.
+		m_pAssignedDiagnosticImage -> m_pOutputImageData = ReportPage.pPixels;
+		ReportPage.pPixels = 0;
+		m_pAssignedDiagnosticImage -> m_OutputImageHeightInPixels = m_pAssignedDiagnosticImage -> m_ImageHeightInPixels;
+		m_pAssignedDiagnosticImage -> m_OutputImageWidthInPixels = m_pAssignedDiagnosticImage -> m_ImageWidthInPixels;
+		}
+	else
+		LogMessage( ">>> Error allocating the report page image.", MESSAGE_TYPE_SUPPLEMENTARY );
+	ReleaseReportPage( &ReportPage );
+	ReleaseFontCharacterGlyphBitmaps( m_ReportDateStringFontGlyphBitmapArray );
+	ReleaseFontCharacterGlyphBitmaps( m_ReportCommentFontGlyphBitmapArray );
+	ReleaseFontCharacterGlyphBitmaps( m_ReportBoldTextFontGlyphBitmapArray );
+	ReleaseFontCharacterGlyphBitmaps( m_ReportSmallTextFontGlyphBitmapArray );
+	ReleaseFontCharacterGlyphBitmaps( m_ReportSmallItalicFontGlyphBitmapArray );
+}
+
+
 // This function deletes the OpenGL report image in the graphics adapter after printing or saving to a file.
 void CImageView::DeleteReportImage()
 {
@@ -2990,8 +3117,8 @@ void CImageView::SaveReport()
 		glViewport( 0, 0, m_pAssignedDiagnosticImage -> m_ImageWidthInPixels,
 							m_pAssignedDiagnosticImage -> m_ImageHeightInPixels );
 
-		// Create the report image in the GPU and copy it to the m_pAssignedDiagnosticImage output image buffer.
-		CreateReportImage( IMAGE_DESTINATION_FILE, TRUE );
+		// Create the report image in the m_pAssignedDiagnosticImage output image buffer.
+		RasterizeReportImage( TRUE );																							// *[11]
 
 		strncpy_s( FileSpecForWriting, FULL_FILE_SPEC_STRING_LENGTH, BViewerConfiguration.ReportDirectory, _TRUNCATE );			// *[6] Replaced strncat with strncpy_s.
 		if ( FileSpecForWriting[ strlen( FileSpecForWriting ) - 1 ] != '\\' )
@@ -3045,9 +3172,14 @@ void CImageView::SaveReport()
 		// Write the report image to a file.
 		sprintf_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "Saving report page to an image file:  %s",  FileSpecForWriting );			// *[2] Added report logging.
 		LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
-		bNoError = m_pAssignedDiagnosticImage -> WritePNGImageFile( FileSpecForWriting );
+		bNoError = m_pAssignedDiagnosticImage -> WritePNGImageFile( FileSpecForWriting, TRUE );														// *[9]
 		if ( !bNoError )																											// *[3] Added error check.
 			LogMessage( " *** An error occurred saving the report page.", MESSAGE_TYPE_ERROR );
+		if ( m_pAssignedDiagnosticImage -> m_pOutputImageData != 0 )																// *[8] Release the page image buffer.
+			{
+			free( m_pAssignedDiagnosticImage -> m_pOutputImageData );
+			m_pAssignedDiagnosticImage -> m_pOutputImageData = 0;
+			}
 		
 		}
 
@@ -3190,7 +3322,9 @@ void CImageView::PrintReportPage( BOOL bUseCurrentStudy )
 	int					nResponseCode;
 	unsigned long		nImageWidth;
 	unsigned long		nImageHeight;
-	unsigned long		ImageSizeInBytes;
+	unsigned long		OutputRowBytes;						// *[9]
+	unsigned long		BitmapRowBytes;						// *[9]
+	unsigned long		nRow;								// *[9]
 	int					nRastersCopiedToPrinter;
 	char				Msg[ MAX_LOGGING_STRING_LENGTH ];
 
@@ -3258,8 +3392,13 @@ void CImageView::PrintReportPage( BOOL bUseCurrentStudy )
 				// Create the report image in the GPU and copy it to the m_pAssignedDiagnosticImage output image buffer.
 				CreateReportImage( IMAGE_DESTINATION_PRINTER, bUseCurrentStudy );
 
-				ImageSizeInBytes = m_pAssignedDiagnosticImage -> m_OutputImageWidthInPixels * m_pAssignedDiagnosticImage -> m_OutputImageHeightInPixels * 3;
-				memcpy( (unsigned char*)m_pDIBImageData, m_pAssignedDiagnosticImage -> m_pOutputImageData, ImageSizeInBytes );
+				// *[9] The output image rows are tightly packed.  Each row of the bitmap begins on a 4-byte boundary.
+				OutputRowBytes = m_pAssignedDiagnosticImage -> m_OutputImageWidthInPixels * 3;
+				BitmapRowBytes = ( nImageWidth * 3 + 3 ) & ~3;
+				if ( m_pAssignedDiagnosticImage -> m_pOutputImageData != 0 && OutputRowBytes <= BitmapRowBytes )
+					for ( nRow = 0; nRow < m_pAssignedDiagnosticImage -> m_OutputImageHeightInPixels && nRow < nImageHeight; nRow++ )
+						memcpy( (unsigned char*)m_pDIBImageData + nRow * BitmapRowBytes,
+									m_pAssignedDiagnosticImage -> m_pOutputImageData + nRow * OutputRowBytes, OutputRowBytes );
 				// At this point the current page bitmap is available for printing.
 				// Prepare the printer driver to receive data.
 				nResponseCode = m_PrinterDC.StartPage();
@@ -3524,19 +3663,26 @@ unsigned int CImageView::CreateFontCharacterGlyphTexture( HDC hDC, int FontHeigh
 				//		The cells are dimenstioned to be just large enough to hold the largest character glyph in the current character font.
 				CalculateMaximumFontGlyphDimensions( pFontGlyphBitmapArray, nChars, pMaxGlyphSubTextureHeight, pMaxGlyphSubTextureWidth );
 
-				// *[4] Create a single OpenGL texture to hold the text font character bitmap array.
-				glGenTextures( 1, &TextureID );
-				glBindTexture( GL_TEXTURE_2D, TextureID );
-				glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-				glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-				glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-				glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-				glTexImage2D( GL_TEXTURE_2D, 0, GL_RED, *pMaxGlyphSubTextureWidth * nChars, *pMaxGlyphSubTextureHeight, 0, GL_RED, GL_UNSIGNED_BYTE, NULL );
-				bOK = CheckOpenGLResultAt( __FILE__, __LINE__	);
+				// *[11] A report page drawn without the GPU uses the glyph bitmaps where they are.  They
+				//		are released by ReleaseFontCharacterGlyphBitmaps() once the page has been rasterized.
+				if ( m_pReportPage != 0 && TextureUnit == TEXTURE_UNIT_REPORT_TEXT )
+					TextureID = GLYPH_TEXTURE_NOT_CREATED;
+				else
+					{
+					// *[4] Create a single OpenGL texture to hold the text font character bitmap array.
+					glGenTextures( 1, &TextureID );
+					glBindTexture( GL_TEXTURE_2D, TextureID );
+					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+					glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+					glTexImage2D( GL_TEXTURE_2D, 0, GL_RED, *pMaxGlyphSubTextureWidth * nChars, *pMaxGlyphSubTextureHeight, 0, GL_RED, GL_UNSIGNED_BYTE, NULL );
+					bOK = CheckOpenGLResultAt( __FILE__, __LINE__	);
+					}
 				}
 	
 			// *[4] Transfer the character bitmaps to an OpenGL texture in the graphics memory.
-			for ( nChar = 0; nChar < nChars && bOK; nChar++ )
+			for ( nChar = 0; nChar < nChars && bOK && TextureID != GLYPH_TEXTURE_NOT_CREATED; nChar++ )			// *[11]
 				{
 				// Point to the bitmap array slot for this font character.
 				pGlyphBitmap = &pFontGlyphBitmapArray[ nChar ];
@@ -3572,7 +3718,9 @@ unsigned int CImageView::CreateFontCharacterGlyphTexture( HDC hDC, int FontHeigh
 void CImageView::DeleteFontCharacterGlyphTexture( GLenum TextureUnit, unsigned int *pTextureID )
 {
 	glActiveTexture( TextureUnit );		// Use texture unit for the font glyph texture to be deleted.
-	if ( *pTextureID != 0 )
+	if ( *pTextureID == GLYPH_TEXTURE_NOT_CREATED )		// *[11] There is no texture for glyphs kept in memory.
+		*pTextureID = 0;
+	else if ( *pTextureID != 0 )
 		{
 		glDeleteTextures( 1, (GLuint*)pTextureID );
 		*pTextureID = 0;
@@ -3581,6 +3729,23 @@ void CImageView::DeleteFontCharacterGlyphTexture( GLenum TextureUnit, unsigned i
 }
 
 
+// *[11] Free any glyph bitmaps kept in memory for drawing a report page without the GPU.
+void CImageView::ReleaseFontCharacterGlyphBitmaps( GLYPH_BITMAP_INFO *pFontGlyphBitmapArray )
+{
+	int						nChar;
+	GLYPH_BITMAP_INFO		*pGlyphBitmap;
+
+	for ( nChar = 0; nChar < 128; nChar++ )
+		{
+		pGlyphBitmap = &pFontGlyphBitmapArray[ nChar ];
+		if ( pGlyphBitmap -> pBitmapBuffer != 0 )
+			free( pGlyphBitmap -> pBitmapBuffer );
+		pGlyphBitmap -> pBitmapBuffer = 0;
+		pGlyphBitmap -> BufferSizeInBytes = 0;
+		}
+}
+
+
 // *[4] This function was modified to use the new generalized font texture functions.
 void CImageView::RenderImageAnnotations()
 {
@@ -3644,86 +3809,123 @@ void CImageView::RenderTextString( GLuint hShaderProgram, GLuint TextureUnit, un
 	GLfloat					ViewportWidth;
 	GLfloat					ViewportHeight;
 
-	glGetFloatv( GL_VIEWPORT, ViewportRect );
-	ViewportWidth = ViewportRect[ 2 ] - ViewportRect[ 0 ];
-	ViewportHeight = ViewportRect[ 3 ] - ViewportRect[ 1 ];
-	glUseProgram( hShaderProgram );
-	glUniform3f( glGetUniformLocation( hShaderProgram, "TextColor"), Color[ 0 ], Color[ 1 ], Color[ 2 ] );
-	CheckOpenGLResultAt( __FILE__, __LINE__ );
-	glBindVertexArray( VertexAttributesID );
-	glActiveTexture( TextureUnit );
-
-	// Iterate through the characters in pTextString.
-	for ( nChar = 0; nChar < strlen( pTextString ); nChar++ )
+	if ( m_pReportPage != 0 && TextureUnit == TEXTURE_UNIT_REPORT_TEXT )			// *[11] Record the text for a report page drawn without the GPU.
+		RecordReportTextString( pGlyphBitmapArray, pTextString, x, y, Color );
+	else
 		{
-		Char = pTextString[ nChar ];
-		if ( Char >= 0 && Char < 128 )
+		glGetFloatv( GL_VIEWPORT, ViewportRect );
+		ViewportWidth = ViewportRect[ 2 ] - ViewportRect[ 0 ];
+		ViewportHeight = ViewportRect[ 3 ] - ViewportRect[ 1 ];
+		glUseProgram( hShaderProgram );
+		glUniform3f( glGetUniformLocation( hShaderProgram, "TextColor"), Color[ 0 ], Color[ 1 ], Color[ 2 ] );
+		CheckOpenGLResultAt( __FILE__, __LINE__ );
+		glBindVertexArray( VertexAttributesID );
+		glActiveTexture( TextureUnit );
+
+		// Iterate through the characters in pTextString.
+		for ( nChar = 0; nChar < strlen( pTextString ); nChar++ )
 			{
-			pGlyphBitmap = &pGlyphBitmapArray[ Char ];
-			pGlyphMetrics = &pGlyphBitmap -> GlyphMetrics;
+			Char = pTextString[ nChar ];
+			if ( Char >= 0 && Char < 128 )
+				{
+				pGlyphBitmap = &pGlyphBitmapArray[ Char ];
+				pGlyphMetrics = &pGlyphBitmap -> GlyphMetrics;
 
-			// Offset the glyph bitmap to position it correctly inside the current character cell.
-			XPos = x + pGlyphMetrics -> gmptGlyphOrigin.x;
-			YPos = y + ( (GLfloat)pGlyphMetrics -> gmptGlyphOrigin.y - (GLfloat)pGlyphMetrics -> gmBlackBoxY );
+				// Offset the glyph bitmap to position it correctly inside the current character cell.
+				XPos = x + pGlyphMetrics -> gmptGlyphOrigin.x;
+				YPos = y + ( (GLfloat)pGlyphMetrics -> gmptGlyphOrigin.y - (GLfloat)pGlyphMetrics -> gmBlackBoxY );
 
- 			CellWidth = (GLfloat)pGlyphMetrics -> gmBlackBoxX;
-			CellHeight = (GLfloat)pGlyphMetrics -> gmBlackBoxY;
+				CellWidth = (GLfloat)pGlyphMetrics -> gmBlackBoxX;
+				CellHeight = (GLfloat)pGlyphMetrics -> gmBlackBoxY;
 
-			// Set up the vertex buffer for the current character.
-			// Adjust cell boundarys to mornalize to -1.0 < x , 1.0, -1.0 < y , 1.0.  The geometric
-			// transformation matrix expects this.
-			if ( TextureUnit == TEXTURE_UNIT_REPORT_TEXT )
-				{
-				XMin = 2.0f * XPos / (GLfloat)ViewportWidth - 1.0f;
-				YMin = 2.0f * YPos / (GLfloat)ViewportHeight - 1.0f;
-				XMax = 2.0f * ( XPos + CellWidth ) / (GLfloat)ViewportWidth - 1.0f;
-				YMax = 2.0f * ( YPos + CellHeight ) / (GLfloat)ViewportHeight - 1.0f;
-				}
-			else
-				{
-				XMin = (GLfloat)( ( XPos - ViewportWidth / 2.0 ) / ViewportWidth );
-				XMax = (GLfloat)( ( XPos + CellWidth - ViewportWidth / 2.0 ) / ViewportWidth );
-				YMin = (GLfloat)( ( YPos ) / ViewportHeight );
-				YMax = (GLfloat)( ( YPos + CellHeight ) / ViewportHeight );
-				}
+				// Set up the vertex buffer for the current character.
+				// Adjust cell boundarys to mornalize to -1.0 < x , 1.0, -1.0 < y , 1.0.  The geometric
+				// transformation matrix expects this.
+				if ( TextureUnit == TEXTURE_UNIT_REPORT_TEXT )
+					{
+					XMin = 2.0f * XPos / (GLfloat)ViewportWidth - 1.0f;
+					YMin = 2.0f * YPos / (GLfloat)ViewportHeight - 1.0f;
+					XMax = 2.0f * ( XPos + CellWidth ) / (GLfloat)ViewportWidth - 1.0f;
+					YMax = 2.0f * ( YPos + CellHeight ) / (GLfloat)ViewportHeight - 1.0f;
+					}
+				else
+					{
+					XMin = (GLfloat)( ( XPos - ViewportWidth / 2.0 ) / ViewportWidth );
+					XMax = (GLfloat)( ( XPos + CellWidth - ViewportWidth / 2.0 ) / ViewportWidth );
+					YMin = (GLfloat)( ( YPos ) / ViewportHeight );
+					YMax = (GLfloat)( ( YPos + CellHeight ) / ViewportHeight );
+					}
 
-			TexturePosXMin = (GLfloat)Char / (GLfloat)128.0;
-			TexturePosXMax = TexturePosXMin + CellWidth / ( (GLfloat)128.0 * MaxGlyphSubTextureWidth );
-			TexturePosYMin = 0.0;
-			TexturePosYMax = CellHeight / (GLfloat)MaxGlyphSubTextureHeight;
+				TexturePosXMin = (GLfloat)Char / (GLfloat)128.0;
+				TexturePosXMax = TexturePosXMin + CellWidth / ( (GLfloat)128.0 * MaxGlyphSubTextureWidth );
+				TexturePosYMin = 0.0;
+				TexturePosYMax = CellHeight / (GLfloat)MaxGlyphSubTextureHeight;
 
-			InitCharacterGlyphVertexRectangle( XMin, XMax, YMax, YMin, TexturePosXMin, TexturePosXMax, TexturePosYMin, TexturePosYMax );		// Invert the Y's.
-			// Bind the texture for the current character.  Indicate to the shader that we're using the designated texture unit.
-			if ( TextureUnit == TEXTURE_UNIT_IMAGE_ANNOTATIONS )
-				{
-				glUniform1i( glGetUniformLocation(  hShaderProgram, "AnnotationGlyphTexture" ), TEXUNIT_NUMBER_IMAGE_ANNOTATIONS );
-				CheckOpenGLResultAt( __FILE__, __LINE__ );
-				}
-			else if ( TextureUnit == TEXTURE_UNIT_IMAGE_MEASUREMENTS )
-				{
-				glUniform1i( glGetUniformLocation(  hShaderProgram, "MeasurementGlyphTexture" ), TEXUNIT_NUMBER_IMAGE_MEASUREMENTS );
-				CheckOpenGLResultAt( __FILE__, __LINE__ );
-				}
-			else
-				{
-				glUniform1i( glGetUniformLocation(  hShaderProgram, "ReportGlyphTexture" ), TEXUNIT_NUMBER_REPORT_TEXT );
+				InitCharacterGlyphVertexRectangle( XMin, XMax, YMax, YMin, TexturePosXMin, TexturePosXMax, TexturePosYMin, TexturePosYMax );		// Invert the Y's.
+				// Bind the texture for the current character.  Indicate to the shader that we're using the designated texture unit.
+				if ( TextureUnit == TEXTURE_UNIT_IMAGE_ANNOTATIONS )
+					{
+					glUniform1i( glGetUniformLocation(  hShaderProgram, "AnnotationGlyphTexture" ), TEXUNIT_NUMBER_IMAGE_ANNOTATIONS );
+					CheckOpenGLResultAt( __FILE__, __LINE__ );
+					}
+				else if ( TextureUnit == TEXTURE_UNIT_IMAGE_MEASUREMENTS )
+					{
+					glUniform1i( glGetUniformLocation(  hShaderProgram, "MeasurementGlyphTexture" ), TEXUNIT_NUMBER_IMAGE_MEASUREMENTS );
+					CheckOpenGLResultAt( __FILE__, __LINE__ );
+					}
+				else
+					{
+					glUniform1i( glGetUniformLocation(  hShaderProgram, "ReportGlyphTexture" ), TEXUNIT_NUMBER_REPORT_TEXT );
+					CheckOpenGLResultAt( __FILE__, __LINE__ );
+					}
+				glBindTexture( GL_TEXTURE_2D, TextureID );		// *[4]
+				// Bind the externally declared vertex buffer.
+				glBindBuffer( GL_ARRAY_BUFFER, VertexBufferID );
+				// Associate the current vertex array just specified with the OpenGL array buffer.
+				glBufferData( GL_ARRAY_BUFFER, sizeof( m_CharacterGlyphVertexRectangle ), &m_CharacterGlyphVertexRectangle, GL_STREAM_DRAW );
 				CheckOpenGLResultAt( __FILE__, __LINE__ );
+				// Render the character.
+				glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
 				}
-			glBindTexture( GL_TEXTURE_2D, TextureID );		// *[4]
-			// Bind the externally declared vertex buffer.
-			glBindBuffer( GL_ARRAY_BUFFER, VertexBufferID );
-			// Associate the current vertex array just specified with the OpenGL array buffer.
-			glBufferData( GL_ARRAY_BUFFER, sizeof( m_CharacterGlyphVertexRectangle ), &m_CharacterGlyphVertexRectangle, GL_STREAM_DRAW );
-			CheckOpenGLResultAt( __FILE__, __LINE__ );
-			// Render the character.
-			glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+
+			if ( pGlyphMetrics != 0 )			// *[1] Prevent any NULL dereference.
+				CellWidth = pGlyphMetrics -> gmCellIncX;
+			x += CellWidth;
 			}
+		}
+}
 
-		if ( pGlyphMetrics != 0 )			// *[1] Prevent any NULL dereference.
-			CellWidth = pGlyphMetrics -> gmCellIncX;
-		x += CellWidth;
+
+// *[11] Record the text string's glyphs on the report page, at the positions used by RenderTextString().
+void CImageView::RecordReportTextString( GLYPH_BITMAP_INFO *pGlyphBitmapArray, char *pTextString, float x, float y, GLfloat Color[ 3 ] )
+{
+	size_t					nChar;
+	char					Char;
+	GLYPH_BITMAP_INFO		*pGlyphBitmap;
+	GLYPHMETRICS			*pGlyphMetrics = 0;
+	unsigned long			GlyphBitmapSize;
+
+	for ( nChar = 0; nChar < strlen( pTextString ); nChar++ )
+		{
+		Char = pTextString[ nChar ];
+		if ( Char >= 0 && Char < 128 )
+			{
+			pGlyphBitmap = &pGlyphBitmapArray[ Char ];
+			pGlyphMetrics = &pGlyphBitmap -> GlyphMetrics;
+			// Blank characters, such as spaces, have no bitmap to draw.  Each bitmap row is DWORD aligned.
+			GlyphBitmapSize = ( ( pGlyphMetrics -> gmBlackBoxX + 3 ) & ~3 ) * pGlyphMetrics -> gmBlackBoxY;
+			if ( pGlyphBitmap -> pBitmapBuffer != 0 && pGlyphBitmap -> BufferSizeInBytes >= GlyphBitmapSize )
+				AddReportGlyph( m_pReportPage, (unsigned char*)pGlyphBitmap -> pBitmapBuffer,
+									(long)pGlyphMetrics -> gmBlackBoxX, (long)pGlyphMetrics -> gmBlackBoxY,
+									x + (float)pGlyphMetrics -> gmptGlyphOrigin.x,
+									y + (float)pGlyphMetrics -> gmptGlyphOrigin.y - (float)pGlyphMetrics -> gmBlackBoxY, Color );
+			}
+		if ( pGlyphMetrics != 0 )
+			x += (float)pGlyphMetrics -> gmCellIncX;
 		}
 }
+
+
 void CImageView::RenderImageMeasurementLines()
 {
 	GLfloat						ViewportRect[ 4 ];
@@ -4625,6 +4827,9 @@ const GLchar		VertexShaderWithTextureSourceCode[] =
 // It performs the grayscale windowing adjustsments, grayscale inversion if requested, and
 // adjustments for the display gamma setting.
 //
+// *[10] The windowing calculation in this shader and the next one is repeated on the CPU in
+// GrayscaleWindowing.cpp.  Any change to it must be made there, too.
+//
 const GLchar		FragmentShaderFor30BitColorSourceCode[] =
 "#version	330 core									\n"
 "														\n"
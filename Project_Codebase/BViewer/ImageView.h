@@ -33,12 +33,16 @@
 //	*[1] 05/01/2023 by Tom Atwood
 //		Converted the glyph bitmap array of textures into a single, indexed texture for each
 //		entire font.  Removed the texture Id from the GLYPH_BITMAP_INFO structure.
+//	*[2] 10/19/2026 by agent
+//		Added the report page on which the report drawing is recorded when a report
+//		page is saved, so that it can be rasterized without the GPU.
 //
 #pragma once
 
 #include <wingdi.h>
 #include "GraphicsAdapter.h"
 #include "FrameHeader.h"
+#include "ReportRasterizer.h"
 
 #define IMAGEVIEW_ERROR_INSUFFICIENT_MEMORY			1
 #define IMAGEVIEW_ERROR_GL_INVALID_ENUM				2
@@ -90,6 +94,10 @@ typedef struct
 	char				*pBitmapBuffer;
 	} GLYPH_BITMAP_INFO;
 
+// *[2] Returned in place of a glyph texture ID when the glyph bitmaps are kept in memory for
+//		drawing a report page without the GPU.
+#define GLYPH_TEXTURE_NOT_CREATED					0xFFFFFFFF
+
 
 #pragma pack(push)
 #pragma pack(1)		// Pack vertex array structure members on 1-byte boundaries.
@@ -195,6 +203,7 @@ public:
 	BITMAPINFO			m_PrintableBitmapInfo;
 	char				m_ReportDateTimeString[ 32 ];
 	unsigned char		*m_pDIBImageData;			// Pointer to the pixel data in the printable DIB.
+	REPORT_PAGE			*m_pReportPage;				// *[2] While not NULL, the report drawing is recorded here, instead of being rendered by OpenGL.
 	CMouse				m_Mouse;
 
 	BOOL				m_bEnableMeasure;
@@ -338,6 +347,7 @@ public:
 	void					SetDCPixelFormat( HDC hDC );
 	void					SetExportDCPixelFormat( HDC hDC );
 	void					CreateReportImage( unsigned long ImageDestination, BOOL bUseCurrentStudy );
+	void					RasterizeReportImage( BOOL bUseCurrentStudy );																				// *[2]
 	void					DeleteReportImage();
 	void					SaveReport();
 	BOOL					OpenReportForPrinting( BOOL bShowPrintDialog );
@@ -351,17 +361,20 @@ public:
 																GLenum TextureUnit, GLYPH_BITMAP_INFO *pFontGlyphBitmapArray,
 																GLsizei *pMaxGlyphSubTextureHeight, GLsizei *pMaxGlyphSubTextureWidth );
 	void					DeleteFontCharacterGlyphTexture( GLenum TextureUnit, unsigned int *pTextureID );															// *[1]
+	void					ReleaseFontCharacterGlyphBitmaps( GLYPH_BITMAP_INFO *pFontGlyphBitmapArray );																// *[2]
 	void					RenderImageAnnotations();
 	void					RenderTextString( GLuint hShaderProgram, GLuint TextureUnit, unsigned int TextureID,														// *[1]
 																GLsizei MaxGlyphSubTextureHeight, GLsizei MaxGlyphSubTextureWidth,
 																GLYPH_BITMAP_INFO *GlyphBitmapArray, char *pTextString, unsigned int VertexBufferID,
 																unsigned int VertexAttributesID, float x, float y, GLfloat Color[ 3 ] );
+	void					RecordReportTextString( GLYPH_BITMAP_INFO *pGlyphBitmapArray, char *pTextString, float x, float y, GLfloat Color[ 3 ] );				// *[2]
 
 	void					RenderImageMeasurementLines();
 	void					RenderImageMeasurements();
 	void					CreateReportTextVertices( GLuint hShaderProgram );
 	void					DeleteReportTextVertices( GLuint hShaderProgram );
 	void					RenderReportCheckmark();
+	void					RecordReportCheckmark();																									// *[2]
 	void					CreateSignatureTexture();
 	void					RenderSignatureTexture( GLuint hShaderProgram, SIGNATURE_BITMAP *pSignatureBitmap, unsigned int VertexBufferID,
 											unsigned int VertexAttributesID, float x, float y, float ScaledBitmapWidth, float ScaledBitmapHeight );
@@ -29,6 +29,14 @@
 //
 // UPDATE HISTORY:
 //
+//	*[6] 10/19/2026 by agent
+//		While the import copy threads are running, the user interface thread keeps
+//		processing window messages and shows how many of the files have been copied.
+//		The Cancel button stops the copying after the files already under way.
+//	*[5] 10/19/2026 by agent
+//		The checked DICOMDIR images are now copied by a small pool of threads.  The file
+//		names are still resolved in order on the user interface thread, and errors are
+//		reported once the copying has finished.
 //	*[4] 02/05/2024 by Tom Atwood
 //		Fixed code security issues.
 //	*[3] 07/19/2023 by Tom Atwood
@@ -43,6 +51,7 @@
 #include <direct.h>
 #include <stdio.h>
 #include <errno.h>
+#include <process.h>
 #include <afxcmn.h>
 #include "BViewer.h"
 #include "ImportDicomdir.h"
@@ -129,6 +138,9 @@ CImportDicomdir::CImportDicomdir( BOOL bSelectionIsAFolder, BOOL bSelectionIsADI
 	m_pExplorer = new CTreeCtrl;
 	m_pListOfFileSetItems = 0;
 	m_TotalImageFilesImported = 0;
+	m_bImportCopyInProgress = FALSE;														// *[6]
+	m_bImportCopyCancelRequested = FALSE;													// *[6]
+	m_ImportProgressMessage[ 0 ] = '\0';													// *[6]
 	strncpy_s( m_SelectedFileSpec, FULL_FILE_SPEC_STRING_LENGTH, pSelectedFileSpec, _TRUNCATE );	// *[1] Replaced strcpy with strncpy_s.
 	m_bSelectionIsAFolder = bSelectionIsAFolder;
 	m_bSelectionIsADICOMDIR = bSelectionIsADICOMDIR;
@@ -222,24 +234,25 @@ int CImportDicomdir::OnCreate( LPCREATESTRUCT lpCreateStruct )
 
 static char			*pTechSupportMessage = "Request technical support.";
 
-// Import a designated file into the BRetriever watch folder, from which
-// it will be picked up and processed.
-BOOL CImportDicomdir::CopyDesignatedFile( char *pSourceImageFileSpec )
+// *[5] Resolve the staging and watch folder file names for a designated file.  Duplicate
+// file names are made unique.
+BOOL CImportDicomdir::PrepareImportCopyJob( char *pSourceImageFileSpec, IMPORT_COPY_JOB *pImportCopyJob )
 {
 	BOOL					bNoError = TRUE;
-	char					InitialOutputImageFileSpec[ FILE_PATH_STRING_LENGTH ];
-	char					RevisedOutputImageFileSpec[ FILE_PATH_STRING_LENGTH ];
 	char					CurrentFileNameWithExtension[ FILE_PATH_STRING_LENGTH ];
 	LIST_ELEMENT			*pListElement;
 	char					*pEarlierFileName;
 	char					*pCurrentFileName;
-	char					Msg[ MAX_EXTRA_LONG_STRING_LENGTH ];
 	char					*pChar;
 	char					*pExtension;
 	char					Version[ 20 ];
-	int						RenameResult;
 
-	if ( strlen( pSourceImageFileSpec ) > 0 )
+	pImportCopyJob -> CopyResult = IMPORT_COPY_PENDING;
+	strncpy_s( pImportCopyJob -> SourceFileSpec, FULL_FILE_SPEC_STRING_LENGTH, pSourceImageFileSpec, _TRUNCATE );
+	pImportCopyJob -> StagedFileSpec[ 0 ] = '\0';
+	pImportCopyJob -> WatchFolderFileSpec[ 0 ] = '\0';
+	bNoError = ( strlen( pSourceImageFileSpec ) > 0 );
+	if ( bNoError )
 		{
 		pCurrentFileName = (char*)malloc( FILE_PATH_STRING_LENGTH );
 		bNoError = ( pCurrentFileName != 0 );
@@ -274,45 +287,70 @@ BOOL CImportDicomdir::CopyDesignatedFile( char *pSourceImageFileSpec )
 			// Add the name of the current file to the list of files to be checked for duplication.
 			AppendToList( &m_ListOfProcessedItemFileNames, pCurrentFileName );
 
-			// Copy the file to the Inbox directory.
-			strncpy_s( InitialOutputImageFileSpec, FILE_PATH_STRING_LENGTH, BViewerConfiguration.InboxDirectory, _TRUNCATE );	// *[1] Replaced strcpy with strncpy_s.
-			if ( InitialOutputImageFileSpec[ strlen( InitialOutputImageFileSpec ) - 1 ] != '\\' )
-				strncat_s( InitialOutputImageFileSpec, FILE_PATH_STRING_LENGTH, "\\", _TRUNCATE );								// *[2] Replaced strcat with strncat_s.
-			strncat_s( InitialOutputImageFileSpec, FILE_PATH_STRING_LENGTH, pCurrentFileName, _TRUNCATE );						// *[2] Replaced strncat with strncat_s.
-
-			// First, copy the file to the Inbox directory.
-			bNoError = CopyFile( pSourceImageFileSpec, InitialOutputImageFileSpec, FALSE );
-			if ( bNoError )
-				{
-				bNoError = MakeFileWriteable( InitialOutputImageFileSpec );															// *[4] Intrroduced this function to avoid a race condition.
-				// Rename it over to the Watch Folder, where BRetriever will pick it up and process it.
-				strncpy_s( RevisedOutputImageFileSpec, FILE_PATH_STRING_LENGTH, BViewerConfiguration.WatchDirectory, _TRUNCATE );	// *[1] Replaced strcpy with strncpy_s.
-				if ( RevisedOutputImageFileSpec[ strlen( RevisedOutputImageFileSpec ) - 1 ] != '\\' )
-					strncat_s( RevisedOutputImageFileSpec, FILE_PATH_STRING_LENGTH, "\\", _TRUNCATE );								// *[2] Replaced strcat with strncat_s.
-				strncat_s( RevisedOutputImageFileSpec, FILE_PATH_STRING_LENGTH, pCurrentFileName, _TRUNCATE );						// *[2] Replaced strncat with strncat_s.
-				// Then rename it into the Watch directory.  This two-stage file movement avoids having
-				// BRetriever try to grab the file for processing while it is still being copied into
-				// the Watch directory.  The rename operation is just a modification of a directory
-				// entry, so the file appears in the watch directory instantaneously.
-				RenameResult = rename( InitialOutputImageFileSpec, RevisedOutputImageFileSpec );
-				if ( RenameResult != 0 )
-					{
-					bNoError = FALSE;
-					strncpy_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "Unable to import\n", _TRUNCATE );								// *[1] Replaced strcpy with strncpy_s.
-					strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, InitialOutputImageFileSpec, _TRUNCATE );							// *[2] Replaced strcat with strncat_s.
-					ThisBViewerApp.NotifyUserOfImportSearchStatus( IMPORT_DICOMDIR_ERROR_FILE_MOVE, Msg, pTechSupportMessage );
-					}
-				}
-			else
-				{
-				strncpy_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "Unable to stage\n", _TRUNCATE );										// *[1] Replaced strcpy with strncpy_s.
-				strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, InitialOutputImageFileSpec, _TRUNCATE );								// *[2] Replaced strcat with strncat_s.
-				strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "\nfor import.", _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
-				ThisBViewerApp.NotifyUserOfImportSearchStatus( IMPORT_DICOMDIR_ERROR_FILE_MOVE, Msg, pTechSupportMessage );
-				}
-			free( pCurrentFileName );																								// *[1] Fix memory leak.
+			// The file will first be copied to the Inbox directory.
+			strncpy_s( pImportCopyJob -> StagedFileSpec, FILE_PATH_STRING_LENGTH, BViewerConfiguration.InboxDirectory, _TRUNCATE );	// *[1] Replaced strcpy with strncpy_s.
+			if ( pImportCopyJob -> StagedFileSpec[ strlen( pImportCopyJob -> StagedFileSpec ) - 1 ] != '\\' )
+				strncat_s( pImportCopyJob -> StagedFileSpec, FILE_PATH_STRING_LENGTH, "\\", _TRUNCATE );								// *[2] Replaced strcat with strncat_s.
+			strncat_s( pImportCopyJob -> StagedFileSpec, FILE_PATH_STRING_LENGTH, pCurrentFileName, _TRUNCATE );						// *[2] Replaced strncat with strncat_s.
+			// It will then be renamed over to the Watch Folder, where BRetriever will pick it up and process it.
+			strncpy_s( pImportCopyJob -> WatchFolderFileSpec, FILE_PATH_STRING_LENGTH, BViewerConfiguration.WatchDirectory, _TRUNCATE );	// *[1] Replaced strcpy with strncpy_s.
+			if ( pImportCopyJob -> WatchFolderFileSpec[ strlen( pImportCopyJob -> WatchFolderFileSpec ) - 1 ] != '\\' )
+				strncat_s( pImportCopyJob -> WatchFolderFileSpec, FILE_PATH_STRING_LENGTH, "\\", _TRUNCATE );						// *[2] Replaced strcat with strncat_s.
+			strncat_s( pImportCopyJob -> WatchFolderFileSpec, FILE_PATH_STRING_LENGTH, pCurrentFileName, _TRUNCATE );				// *[2] Replaced strncat with strncat_s.
+			// *[5] The file name is now freed with m_ListOfProcessedItemFileNames, instead of here while still listed.
 			}
 		}
+
+	return bNoError;
+}
+
+
+// *[5] Copy one image file to the Inbox directory, then rename it into the Watch directory.  This
+// two-stage file movement avoids having BRetriever try to grab the file for processing while it is
+// still being copied into the Watch directory.  The rename operation is just a modification of a
+// directory entry, so the file appears in the watch directory instantaneously.  This function is
+// called from the import copy threads, so it must not interact with the user interface.
+static void ExecuteImportCopyJob( IMPORT_COPY_JOB *pImportCopyJob )
+{
+	BOOL					bNoError;
+
+	bNoError = CopyFile( pImportCopyJob -> SourceFileSpec, pImportCopyJob -> StagedFileSpec, FALSE );
+	if ( bNoError )
+		{
+		MakeFileWriteable( pImportCopyJob -> StagedFileSpec );																	// *[4] Intrroduced this function to avoid a race condition.
+		if ( rename( pImportCopyJob -> StagedFileSpec, pImportCopyJob -> WatchFolderFileSpec ) == 0 )
+			pImportCopyJob -> CopyResult = IMPORT_COPY_COMPLETED;
+		else
+			pImportCopyJob -> CopyResult = IMPORT_COPY_MOVE_FAILED;
+		}
+	else
+		pImportCopyJob -> CopyResult = IMPORT_COPY_STAGING_FAILED;
+}
+
+
+// *[5] Notify the user of any failure and count the imported files.  Call this from
+// the user interface thread.
+BOOL CImportDicomdir::ReportImportCopyJobResult( IMPORT_COPY_JOB *pImportCopyJob )
+{
+	BOOL					bNoError;
+	char					Msg[ MAX_EXTRA_LONG_STRING_LENGTH ];
+
+	bNoError = ( pImportCopyJob -> CopyResult == IMPORT_COPY_COMPLETED );
+	if ( pImportCopyJob -> CopyResult == IMPORT_COPY_PENDING )
+		pImportCopyJob -> CopyResult = IMPORT_COPY_CANCELLED;								// *[6] This job wasn't started before the import was cancelled.
+	if ( pImportCopyJob -> CopyResult == IMPORT_COPY_MOVE_FAILED )
+		{
+		strncpy_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "Unable to import\n", _TRUNCATE );										// *[1] Replaced strcpy with strncpy_s.
+		strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, pImportCopyJob -> StagedFileSpec, _TRUNCATE );							// *[2] Replaced strcat with strncat_s.
+		ThisBViewerApp.NotifyUserOfImportSearchStatus( IMPORT_DICOMDIR_ERROR_FILE_MOVE, Msg, pTechSupportMessage );
+		}
+	else if ( pImportCopyJob -> CopyResult == IMPORT_COPY_STAGING_FAILED )
+		{
+		strncpy_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "Unable to stage\n", _TRUNCATE );										// *[1] Replaced strcpy with strncpy_s.
+		strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, pImportCopyJob -> StagedFileSpec, _TRUNCATE );							// *[2] Replaced strcat with strncat_s.
+		strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "\nfor import.", _TRUNCATE );											// *[2] Replaced strcat with strncat_s.
+		ThisBViewerApp.NotifyUserOfImportSearchStatus( IMPORT_DICOMDIR_ERROR_FILE_MOVE, Msg, pTechSupportMessage );
+		}
 	if ( bNoError )
 		m_TotalImageFilesImported++;
 
@@ -320,6 +358,119 @@ BOOL CImportDicomdir::CopyDesignatedFile( char *pSourceImageFileSpec )
 }
 
 
+// Import a designated file into the BRetriever watch folder, from which
+// it will be picked up and processed.
+BOOL CImportDicomdir::CopyDesignatedFile( char *pSourceImageFileSpec )
+{
+	BOOL					bNoError = TRUE;
+	IMPORT_COPY_JOB			ImportCopyJob;
+
+	bNoError = PrepareImportCopyJob( pSourceImageFileSpec, &ImportCopyJob );						// *[5] Split the file naming from the copying.
+	if ( bNoError )
+		{
+		ExecuteImportCopyJob( &ImportCopyJob );
+		bNoError = ReportImportCopyJobResult( &ImportCopyJob );
+		}
+
+	return bNoError;
+}
+
+
+// *[5] The jobs shared by the import copy threads.
+typedef struct
+	{
+	IMPORT_COPY_JOB		*pImportCopyJobArray;
+	long				nImportCopyJobs;
+	volatile long		nNextJobToClaim;
+	volatile long		nJobsCompleted;				// *[6]
+	volatile long		*pbCancelRequested;			// *[6]
+	} IMPORT_COPY_JOB_QUEUE;
+
+
+// *[5] Each import copy thread claims the next unclaimed job until none remain.
+// *[6] No further jobs are claimed once the import has been cancelled.
+static unsigned __stdcall ImportCopyThreadFunction( void *pArguments )
+{
+	IMPORT_COPY_JOB_QUEUE	*pImportCopyJobQueue;
+	long					nJob;
+
+	pImportCopyJobQueue = (IMPORT_COPY_JOB_QUEUE*)pArguments;
+	nJob = InterlockedIncrement( &pImportCopyJobQueue -> nNextJobToClaim ) - 1;
+	while ( nJob < pImportCopyJobQueue -> nImportCopyJobs && *pImportCopyJobQueue -> pbCancelRequested == FALSE )		// *[6]
+		{
+		ExecuteImportCopyJob( &pImportCopyJobQueue -> pImportCopyJobArray[ nJob ] );
+		InterlockedIncrement( &pImportCopyJobQueue -> nJobsCompleted );										// *[6]
+		nJob = InterlockedIncrement( &pImportCopyJobQueue -> nNextJobToClaim ) - 1;
+		}
+
+	return 0;
+}
+
+
+// *[6] Show the number of files copied so far in place of the user instructions.
+void CImportDicomdir::ShowImportCopyProgress( long nJobsCompleted, long nImportCopyJobs )
+{
+	if ( m_bImportCopyCancelRequested )
+		_snprintf_s( m_ImportProgressMessage, 128, _TRUNCATE, "Cancelling the import after %d of %d image files.", nJobsCompleted, nImportCopyJobs );
+	else
+		_snprintf_s( m_ImportProgressMessage, 128, _TRUNCATE, "Importing image files:  %d of %d copied.", nJobsCompleted, nImportCopyJobs );
+	m_StaticUserMessage.m_ControlText = m_ImportProgressMessage;
+	m_StaticUserMessage.Invalidate( TRUE );
+	m_StaticUserMessage.UpdateWindow();
+}
+
+
+// *[5] Copy the prepared files using a small pool of threads, so that reading from the
+// source media overlaps with writing to the Inbox directory.  Any job not picked up by a
+// thread is done here.  The results are reported after all the copying is finished.
+// *[6] While waiting for the threads, keep the window messages flowing, so the dialog is
+// repainted, the progress is shown, and the Cancel button can be pressed.
+void CImportDicomdir::PerformImportCopyJobs( IMPORT_COPY_JOB *pImportCopyJobArray, long nImportCopyJobs )
+{
+	IMPORT_COPY_JOB_QUEUE	ImportCopyJobQueue;
+	HANDLE					hCopyThreadHandles[ MAX_IMPORT_COPY_THREADS ];
+	unsigned				CopyThreadID;
+	int						nThreads;
+	int						nThread;
+	long					nJob;
+
+	ImportCopyJobQueue.pImportCopyJobArray = pImportCopyJobArray;
+	ImportCopyJobQueue.nImportCopyJobs = nImportCopyJobs;
+	ImportCopyJobQueue.nNextJobToClaim = 0;
+	ImportCopyJobQueue.nJobsCompleted = 0;													// *[6]
+	ImportCopyJobQueue.pbCancelRequested = &m_bImportCopyCancelRequested;					// *[6]
+	m_bImportCopyInProgress = TRUE;															// *[6]
+	ShowImportCopyProgress( 0, nImportCopyJobs );											// *[6]
+	nThreads = 0;
+	if ( nImportCopyJobs > 1 )
+		{
+		while ( nThreads < MAX_IMPORT_COPY_THREADS && nThreads < nImportCopyJobs )
+			{
+			hCopyThreadHandles[ nThreads ] = (HANDLE)_beginthreadex( NULL, 0, ImportCopyThreadFunction, (void*)&ImportCopyJobQueue, 0, &CopyThreadID );
+			if ( hCopyThreadHandles[ nThreads ] == 0 )
+				break;
+			nThreads++;
+			}
+		}
+	if ( nThreads > 0 )
+		{
+		// *[6] Replaced an indefinite wait, which froze the user interface until all the files were copied.
+		while ( WaitForMultipleObjects( nThreads, hCopyThreadHandles, TRUE, IMPORT_COPY_PROGRESS_INTERVAL ) == WAIT_TIMEOUT )
+			{
+			CheckWindowsMessages();
+			ShowImportCopyProgress( ImportCopyJobQueue.nJobsCompleted, nImportCopyJobs );
+			}
+		for ( nThread = 0; nThread < nThreads; nThread++ )
+			CloseHandle( hCopyThreadHandles[ nThread ] );
+		}
+	else
+		ImportCopyThreadFunction( (void*)&ImportCopyJobQueue );
+	m_bImportCopyInProgress = FALSE;														// *[6]
+	for ( nJob = 0; nJob < nImportCopyJobs; nJob++ )
+		ReportImportCopyJobResult( &pImportCopyJobArray[ nJob ] );
+}
+
+
 void CImportDicomdir::EraseFileSpecList( IMAGE_FILE_SET_SPECIFICATION **ppFileSpecList )
 {
 	IMAGE_FILE_SET_SPECIFICATION		*pImageFileSetSpecification;
@@ -504,12 +655,23 @@ void CImportDicomdir::OnBnClickedImportCheckedItems( NMHDR *pNMHDR, LRESULT *pRe
 	char							*pChar;
 	CWnd							*pParentWindow;
 	CWaitCursor						DisplaysHourglass;
+	IMPORT_COPY_JOB					*pImportCopyJobArray;						// *[5]
+	long							nCheckedItems;								// *[5]
+	long							nImportCopyJobs;							// *[5]
 
+	// *[6] Window messages are processed while the files are being copied, so ignore
+	// another press of the import button until the copying is finished.
+	if ( m_bImportCopyInProgress )
+		{
+		*pResult = 0;
+		return;
+		}
 	m_ListOfProcessedItemFileNames = 0;
 	m_nDuplicateFileNamesDetected = 0;
 	pImageFileSetSpecification = m_pListOfFileSetItems;
 	pListOfCheckedItems = 0;
 	pPrevCheckedFileSetItem = 0;
+	nCheckedItems = 0;
 	while ( pImageFileSetSpecification != 0 )
 		{
 		if ( pImageFileSetSpecification -> DicomNodeType == DICOM_NODE_IMAGE )
@@ -528,12 +690,18 @@ void CImportDicomdir::OnBnClickedImportCheckedItems( NMHDR *pNMHDR, LRESULT *pRe
 					else
 						pPrevCheckedFileSetItem -> pNextFileSetStruct = pCheckedFileSetItem;
 					pPrevCheckedFileSetItem = pCheckedFileSetItem;
+					nCheckedItems++;
 					}
 				}
 			}
 		pImageFileSetSpecification = pImageFileSetSpecification -> pNextFileSetStruct;
 		}			// ... end while another tree item found.
 	// Process the list of checked items.
+	// *[5] Resolve the file names here, then copy the files using the import copy threads.
+	pImportCopyJobArray = 0;
+	if ( nCheckedItems > 0 )
+		pImportCopyJobArray = (IMPORT_COPY_JOB*)malloc( nCheckedItems * sizeof(IMPORT_COPY_JOB) );
+	nImportCopyJobs = 0;
 	pImageFileSetSpecification = pListOfCheckedItems;
 	while ( pImageFileSetSpecification != 0 )
 		{
@@ -543,10 +711,21 @@ void CImportDicomdir::OnBnClickedImportCheckedItems( NMHDR *pNMHDR, LRESULT *pRe
 			{
 			pChar++;
 			strncpy_s( pChar, FULL_FILE_SPEC_STRING_LENGTH - (UINT_PTR)( pChar - FullSourceFileSpec ), pImageFileSetSpecification -> NodeInformation, _TRUNCATE );	// *[1] Replaced strcpy with strncpy_s.
-			CopyDesignatedFile( FullSourceFileSpec );
+			if ( pImportCopyJobArray != 0 && nImportCopyJobs < nCheckedItems )
+				{
+				if ( PrepareImportCopyJob( FullSourceFileSpec, &pImportCopyJobArray[ nImportCopyJobs ] ) )
+					nImportCopyJobs++;
+				}
+			else
+				CopyDesignatedFile( FullSourceFileSpec );		// If the job array couldn't be allocated, copy the files one at a time.
 			}
 		pImageFileSetSpecification = pImageFileSetSpecification -> pNextFileSetStruct;
 		}
+	if ( pImportCopyJobArray != 0 )
+		{
+		PerformImportCopyJobs( pImportCopyJobArray, nImportCopyJobs );
+		free( pImportCopyJobArray );
+		}
 	OnExitImportDicomdirSelector();
 	m_pExplorer -> DeleteAllItems();
 	delete m_pExplorer;
@@ -687,6 +866,14 @@ void CImportDicomdir::DisplayDicomdirFileTree()
 
 void CImportDicomdir::OnBnClickedImportCancel( NMHDR *pNMHDR, LRESULT *pResult )
 {
+	// *[6] If the files are being copied, stop copying them.  The import function
+	// will close the window when the copy threads have finished.
+	if ( m_bImportCopyInProgress )
+		{
+		InterlockedExchange( &m_bImportCopyCancelRequested, TRUE );
+		*pResult = 0;
+		return;
+		}
 	m_pExplorer -> DeleteAllItems();
 	delete m_pExplorer;
 	m_pExplorer = 0;
@@ -43,6 +43,25 @@
 
 typedef 	void (*IMPORT_CALLBACK_FUNCTION)( void *pParentWindow);
 
+
+// A single image file to be copied into the BRetriever watch folder.  The file names are resolved
+// on the user interface thread.  The copying may be done by a pool of import copy threads.
+typedef struct
+	{
+	char				SourceFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+	char				StagedFileSpec[ FILE_PATH_STRING_LENGTH ];
+	char				WatchFolderFileSpec[ FILE_PATH_STRING_LENGTH ];
+	int					CopyResult;
+							#define IMPORT_COPY_PENDING				0
+							#define IMPORT_COPY_COMPLETED			1
+							#define IMPORT_COPY_STAGING_FAILED		2
+							#define IMPORT_COPY_MOVE_FAILED			3
+							#define IMPORT_COPY_CANCELLED			4
+	} IMPORT_COPY_JOB;
+
+#define MAX_IMPORT_COPY_THREADS			4
+#define IMPORT_COPY_PROGRESS_INTERVAL	100		// Milliseconds between progress updates while copying.
+
 // CImportDicomdir
 class CImportDicomdir : public CWnd
 {
@@ -83,6 +102,9 @@ public:
 	IMAGE_FILE_SET_SPECIFICATION	*m_pListOfFileSetItems;
 	HTREEITEM						m_SelectedItem;
 	unsigned long					m_TotalImageFilesImported;
+	BOOL							m_bImportCopyInProgress;
+	volatile long					m_bImportCopyCancelRequested;
+	char							m_ImportProgressMessage[ 128 ];
 	IMPORT_CALLBACK_FUNCTION		m_CallbackFunction;
 
 // Method prototypes:
@@ -90,6 +112,10 @@ public:
 public:
 	BOOL				SetPosition( int x, int y, CWnd *pParentWnd, CString WindowClass );
 	BOOL				CopyDesignatedFile( char *pSourceImageFileSpec );
+	BOOL				PrepareImportCopyJob( char *pSourceImageFileSpec, IMPORT_COPY_JOB *pImportCopyJob );
+	BOOL				ReportImportCopyJobResult( IMPORT_COPY_JOB *pImportCopyJob );
+	void				PerformImportCopyJobs( IMPORT_COPY_JOB *pImportCopyJobArray, long nImportCopyJobs );
+	void				ShowImportCopyProgress( long nJobsCompleted, long nImportCopyJobs );
 	void				EraseFileSpecList( IMAGE_FILE_SET_SPECIFICATION **ppFileSpecList );
 	BOOL				ReadDicomDirectoryFile( char *pDicomdirFileSpec );
 	BOOL				SearchForDICOMDIRFiles( char *pSourceDirectorySpec );
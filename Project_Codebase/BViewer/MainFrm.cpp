@@ -30,6 +30,10 @@
 // UPDATE HISTORY:
 //
 //
+//	*[5] 10/19/2026 by agent
+//		Move the newly arrived studies to the available list through RemoveStudyFromList()
+//		and AddStudyToList(), so that the patient index records which list holds each study.
+//		A study that cannot be added to the available list is discarded.
 //	*[4] 01/30/2024 by Tom Atwood
 //		Corrected buffer size error in ProcessUserNotificationWithoutWaiting().
 //	*[3] 07/19/2023 by Tom Atwood
@@ -987,18 +991,16 @@ void CMainFrame::OnCreateAManualStudy( NMHDR *pNMHDR, LRESULT *pResult )
 
 void CMainFrame::AddNewlyArrivedStudies()
 {
-	LIST_ELEMENT			*pListElement;
-	void					*pNewStudy;
+	CStudy					*pNewStudy;		// *[5]
 
-	pListElement = ThisBViewerApp.m_NewlyArrivedStudyList;
-	while ( pListElement != 0 )
+	// *[5] Take each study from the head of the newly arrived list, preserving the order.
+	while ( ThisBViewerApp.m_NewlyArrivedStudyList != 0 )
 		{
-		pNewStudy = pListElement -> pItem;
-		if ( pNewStudy != 0 )
-			AppendToList( &ThisBViewerApp.m_AvailableStudyList, pNewStudy );
-		pListElement = pListElement -> pNextListElement;
+		pNewStudy = (CStudy*)ThisBViewerApp.m_NewlyArrivedStudyList -> pItem;
+		ThisBViewerApp.RemoveStudyFromList( &ThisBViewerApp.m_NewlyArrivedStudyList, pNewStudy );
+		if ( pNewStudy != 0 && !ThisBViewerApp.AddStudyToList( &ThisBViewerApp.m_AvailableStudyList, pNewStudy ) )
+			delete pNewStudy;
 		}
-	DissolveList( &ThisBViewerApp.m_NewlyArrivedStudyList );
 }
 
 
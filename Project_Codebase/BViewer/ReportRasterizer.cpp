@@ -0,0 +1,541 @@
+// ReportRasterizer.cpp : Implements the CPU rendering of the report overlays onto the
+//  report form image, for saving report pages to files.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include <math.h>
+#include <process.h>
+#include "Module.h"
+#include "ReportRasterizer.h"
+
+
+// CImageView::RenderReport() draws the checkmarks, the text and the signature over the report
+// form.  For the display, this is done by OpenGL.  For a saved page, the drawing is recorded on a
+// REPORT_PAGE instead, and the page is rasterized here, without the GPU, so that pages can be
+// produced without a frame buffer and read back.  The pixels produced follow the rules used by
+// the report shaders in ImageView.cpp:
+//
+//	- A pixel is drawn if its center lies inside the quad or rectangle being drawn.
+//	- The glyph and signature textures are sampled with linear filtering.  Glyph texels outside
+//		the glyph's black box are empty.  The signature's edge texels are extended (clamped).
+//	- A glyph pixel is blended with the color underneath, using 4 times the sampled glyph coverage
+//		as the alpha value.  Quads and the signature are opaque.
+//
+// Any change to the report shaders or to their blending must be made here, too.
+
+
+// The jobs shared by the report rasterizing threads.  Each job is one band of rows of one page.
+typedef struct
+	{
+	REPORT_PAGE			**ppReportPages;
+	long				nReportPages;
+	long				nRasterJobs;
+	volatile long		nNextJobToClaim;
+	} REPORT_RASTER_JOB_QUEUE;
+
+
+BOOL InitializeReportPage( REPORT_PAGE *pReportPage, long WidthInPixels, long HeightInPixels, unsigned char *pReportFormPixels )
+{
+	BOOL				bNoError = TRUE;
+	size_t				nImageBytes = 0;
+
+	memset( pReportPage, 0, sizeof(REPORT_PAGE) );
+	bNoError = ( WidthInPixels > 0 && HeightInPixels > 0 );
+	if ( bNoError )
+		{
+		nImageBytes = (size_t)WidthInPixels * (size_t)HeightInPixels * 3;
+		pReportPage -> pPixels = (unsigned char*)malloc( nImageBytes );
+		bNoError = ( pReportPage -> pPixels != 0 );
+		}
+	if ( bNoError )
+		{
+		pReportPage -> WidthInPixels = WidthInPixels;
+		pReportPage -> HeightInPixels = HeightInPixels;
+		// The report form is drawn onto a black background.
+		if ( pReportFormPixels != 0 )
+			memcpy( pReportPage -> pPixels, pReportFormPixels, nImageBytes );
+		else
+			memset( pReportPage -> pPixels, 0, nImageBytes );
+		}
+
+	return bNoError;
+}
+
+
+void ReleaseReportPage( REPORT_PAGE *pReportPage )
+{
+	if ( pReportPage -> pPixels != 0 )
+		free( pReportPage -> pPixels );
+	if ( pReportPage -> pDrawingArray != 0 )
+		free( pReportPage -> pDrawingArray );
+	memset( pReportPage, 0, sizeof(REPORT_PAGE) );
+}
+
+
+// Return the next free drawing slot for the page, enlarging the drawing array as needed.
+// NULL is returned if the array can't be enlarged.
+static REPORT_DRAWING *AddReportDrawing( REPORT_PAGE *pReportPage, int DrawingType )
+{
+	REPORT_DRAWING		*pNewDrawingArray;
+	REPORT_DRAWING		*pDrawing = 0;
+
+	if ( pReportPage -> nDrawings >= pReportPage -> nDrawingsAllocated )
+		{
+		pNewDrawingArray = (REPORT_DRAWING*)realloc( pReportPage -> pDrawingArray,
+								( pReportPage -> nDrawingsAllocated + REPORT_DRAWING_ALLOCATION_UNIT ) * sizeof(REPORT_DRAWING) );
+		if ( pNewDrawingArray != 0 )
+			{
+			pReportPage -> pDrawingArray = pNewDrawingArray;
+			pReportPage -> nDrawingsAllocated += REPORT_DRAWING_ALLOCATION_UNIT;
+			}
+		}
+	if ( pReportPage -> nDrawings < pReportPage -> nDrawingsAllocated )
+		{
+		pDrawing = &pReportPage -> pDrawingArray[ pReportPage -> nDrawings ];
+		pReportPage -> nDrawings++;
+		memset( pDrawing, 0, sizeof(REPORT_DRAWING) );
+		pDrawing -> DrawingType = DrawingType;
+		}
+
+	return pDrawing;
+}
+
+
+BOOL AddReportQuad( REPORT_PAGE *pReportPage, float Vertex[ 4 ][ 2 ], float Color[ 3 ] )
+{
+	REPORT_DRAWING		*pDrawing;
+
+	pDrawing = AddReportDrawing( pReportPage, REPORT_DRAWING_QUAD );
+	if ( pDrawing != 0 )
+		{
+		memcpy( pDrawing -> Vertex, Vertex, sizeof( pDrawing -> Vertex ) );
+		memcpy( pDrawing -> Color, Color, sizeof( pDrawing -> Color ) );
+		}
+
+	return ( pDrawing != 0 );
+}
+
+
+// The glyph bitmap is in the form returned by GetGlyphOutline() for GGO_GRAY8_BITMAP:  rows from
+// the top of the glyph down, each padded to a multiple of 4 bytes, with coverage values from 0 to 64.
+// The lower left corner of the glyph's black box is placed at ( x, y ).
+BOOL AddReportGlyph( REPORT_PAGE *pReportPage, unsigned char *pGlyphBitmap, long GlyphWidth, long GlyphHeight,
+										float x, float y, float Color[ 3 ] )
+{
+	REPORT_DRAWING		*pDrawing = 0;
+
+	if ( pGlyphBitmap != 0 && GlyphWidth > 0 && GlyphHeight > 0 )
+		{
+		pDrawing = AddReportDrawing( pReportPage, REPORT_DRAWING_GLYPH );
+		if ( pDrawing != 0 )
+			{
+			memcpy( pDrawing -> Color, Color, sizeof( pDrawing -> Color ) );
+			pDrawing -> XMin = x;
+			pDrawing -> YMin = y;
+			pDrawing -> XMax = x + (float)GlyphWidth;
+			pDrawing -> YMax = y + (float)GlyphHeight;
+			pDrawing -> SourceWidth = GlyphWidth;
+			pDrawing -> SourceHeight = GlyphHeight;
+			pDrawing -> pSourcePixels = pGlyphBitmap;
+			}
+		}
+
+	return ( pDrawing != 0 );
+}
+
+
+// The bitmap pixels are in the form of a 24-bit bitmap file's image data:  RGB rows from the
+// bottom of the image up, each padded to a multiple of 4 bytes.  The bitmap is scaled to fill
+// the rectangle with its lower left corner at ( x, y ).
+BOOL AddReportBitmap( REPORT_PAGE *pReportPage, unsigned char *pBitmapPixels, long BitmapWidth, long BitmapHeight,
+										float x, float y, float DisplayedWidth, float DisplayedHeight )
+{
+	REPORT_DRAWING		*pDrawing = 0;
+
+	if ( pBitmapPixels != 0 && BitmapWidth > 0 && BitmapHeight > 0 && DisplayedWidth > 0.0f && DisplayedHeight > 0.0f )
+		{
+		pDrawing = AddReportDrawing( pReportPage, REPORT_DRAWING_BITMAP );
+		if ( pDrawing != 0 )
+			{
+			pDrawing -> XMin = x;
+			pDrawing -> YMin = y;
+			pDrawing -> XMax = x + DisplayedWidth;
+			pDrawing -> YMax = y + DisplayedHeight;
+			pDrawing -> SourceWidth = BitmapWidth;
+			pDrawing -> SourceHeight = BitmapHeight;
+			pDrawing -> pSourcePixels = pBitmapPixels;
+			}
+		}
+
+	return ( pDrawing != 0 );
+}
+
+
+// Convert a color component from 0.0 to 1.0 into an 8-bit level, as it is stored in the frame buffer.
+static unsigned char ConvertToColorLevel( float Value )
+{
+	if ( Value < 0.0f )
+		Value = 0.0f;
+	else if ( Value > 1.0f )
+		Value = 1.0f;
+
+	return (unsigned char)( Value * 255.0f + 0.5f );
+}
+
+
+// Find the range of pixels, from nFirstPixel up to, but not including, nEndPixel, whose centers lie
+// inside [ Low, High ), limited to [ nLimitLow, nLimitHigh ).
+static void GetCoveredPixelRange( float Low, float High, long nLimitLow, long nLimitHigh, long *pnFirstPixel, long *pnEndPixel )
+{
+	*pnFirstPixel = (long)ceil( Low - 0.5f );
+	*pnEndPixel = (long)ceil( High - 0.5f );
+	if ( *pnFirstPixel < nLimitLow )
+		*pnFirstPixel = nLimitLow;
+	if ( *pnEndPixel > nLimitHigh )
+		*pnEndPixel = nLimitHigh;
+}
+
+
+static void RasterizeReportQuad( REPORT_PAGE *pReportPage, REPORT_DRAWING *pDrawing, long nFirstRow, long nEndRow )
+{
+	float				Corner[ 4 ][ 2 ];
+	float				Orientation;
+	float				XLow, XHigh;
+	float				YLow, YHigh;
+	float				CenterX, CenterY;
+	float				EdgeSide;
+	unsigned char		ColorLevel[ 3 ];
+	long				nRow, nRowEnd;
+	long				nColumn, nFirstColumn, nColumnEnd;
+	int					nCorner;
+	int					nEdge;
+	BOOL				bInside;
+	unsigned char		*pPixel;
+
+	// Put the corners in order around the quad.  The triangle strip order is lower left, lower
+	// right, upper left, upper right.
+	memcpy( Corner[ 0 ], pDrawing -> Vertex[ 0 ], sizeof( Corner[ 0 ] ) );
+	memcpy( Corner[ 1 ], pDrawing -> Vertex[ 1 ], sizeof( Corner[ 1 ] ) );
+	memcpy( Corner[ 2 ], pDrawing -> Vertex[ 3 ], sizeof( Corner[ 2 ] ) );
+	memcpy( Corner[ 3 ], pDrawing -> Vertex[ 2 ], sizeof( Corner[ 3 ] ) );
+	Orientation = 0.0f;
+	XLow = XHigh = Corner[ 0 ][ 0 ];
+	YLow = YHigh = Corner[ 0 ][ 1 ];
+	for ( nCorner = 0; nCorner < 4; nCorner++ )
+		{
+		Orientation += Corner[ nCorner ][ 0 ] * Corner[ ( nCorner + 1 ) % 4 ][ 1 ] - Corner[ ( nCorner + 1 ) % 4 ][ 0 ] * Corner[ nCorner ][ 1 ];
+		if ( Corner[ nCorner ][ 0 ] < XLow )
+			XLow = Corner[ nCorner ][ 0 ];
+		if ( Corner[ nCorner ][ 0 ] > XHigh )
+			XHigh = Corner[ nCorner ][ 0 ];
+		if ( Corner[ nCorner ][ 1 ] < YLow )
+			YLow = Corner[ nCorner ][ 1 ];
+		if ( Corner[ nCorner ][ 1 ] > YHigh )
+			YHigh = Corner[ nCorner ][ 1 ];
+		}
+	ColorLevel[ 0 ] = ConvertToColorLevel( pDrawing -> Color[ 0 ] );
+	ColorLevel[ 1 ] = ConvertToColorLevel( pDrawing -> Color[ 1 ] );
+	ColorLevel[ 2 ] = ConvertToColorLevel( pDrawing -> Color[ 2 ] );
+	GetCoveredPixelRange( YLow, YHigh, nFirstRow, nEndRow, &nRow, &nRowEnd );
+	GetCoveredPixelRange( XLow, XHigh, 0, pReportPage -> WidthInPixels, &nFirstColumn, &nColumnEnd );
+	if ( Orientation != 0.0f )
+		{
+		for ( ; nRow < nRowEnd; nRow++ )
+			{
+			CenterY = (float)nRow + 0.5f;
+			pPixel = &pReportPage -> pPixels[ ( (size_t)nRow * pReportPage -> WidthInPixels + nFirstColumn ) * 3 ];
+			for ( nColumn = nFirstColumn; nColumn < nColumnEnd; nColumn++ )
+				{
+				CenterX = (float)nColumn + 0.5f;
+				// The pixel center is inside if it is on the inner side of every edge.
+				bInside = TRUE;
+				for ( nEdge = 0; nEdge < 4 && bInside; nEdge++ )
+					{
+					EdgeSide = ( Corner[ ( nEdge + 1 ) % 4 ][ 0 ] - Corner[ nEdge ][ 0 ] ) * ( CenterY - Corner[ nEdge ][ 1 ] ) -
+								( Corner[ ( nEdge + 1 ) % 4 ][ 1 ] - Corner[ nEdge ][ 1 ] ) * ( CenterX - Corner[ nEdge ][ 0 ] );
+					if ( Orientation < 0.0f )
+						EdgeSide = -EdgeSide;
+					bInside = ( EdgeSide >= 0.0f );
+					}
+				if ( bInside )
+					{
+					pPixel[ 0 ] = ColorLevel[ 0 ];
+					pPixel[ 1 ] = ColorLevel[ 1 ];
+					pPixel[ 2 ] = ColorLevel[ 2 ];
+					}
+				pPixel += 3;
+				}
+			}
+		}
+}
+
+
+// Return a glyph texel value, from 0.0 to 1.0, as the texture sampler presents it.
+static float GetGlyphTexel( REPORT_DRAWING *pDrawing, long RowPitch, long nColumn, long nRow )
+{
+	float				TexelValue = 0.0f;
+
+	if ( nColumn >= 0 && nColumn < pDrawing -> SourceWidth && nRow >= 0 && nRow < pDrawing -> SourceHeight )
+		TexelValue = (float)pDrawing -> pSourcePixels[ nRow * RowPitch + nColumn ] / 255.0f;
+
+	return TexelValue;
+}
+
+
+static void RasterizeReportGlyph( REPORT_PAGE *pReportPage, REPORT_DRAWING *pDrawing, long nFirstRow, long nEndRow )
+{
+	long				RowPitch;
+	float				ColorValue[ 3 ];
+	float				TexelX, TexelY;
+	float				FractionX, FractionY;
+	long				nTexelColumn, nTexelRow;
+	float				Coverage;
+	float				Alpha;
+	long				nRow, nRowEnd;
+	long				nColumn, nFirstColumn, nColumnEnd;
+	int					nChannel;
+	unsigned char		*pPixel;
+
+	RowPitch = ( pDrawing -> SourceWidth + 3 ) & ~3;
+	for ( nChannel = 0; nChannel < 3; nChannel++ )
+		ColorValue[ nChannel ] = pDrawing -> Color[ nChannel ];
+	GetCoveredPixelRange( pDrawing -> YMin, pDrawing -> YMax, nFirstRow, nEndRow, &nRow, &nRowEnd );
+	GetCoveredPixelRange( pDrawing -> XMin, pDrawing -> XMax, 0, pReportPage -> WidthInPixels, &nFirstColumn, &nColumnEnd );
+	for ( ; nRow < nRowEnd; nRow++ )
+		{
+		// The glyph rows are counted from the top of the glyph.
+		TexelY = ( pDrawing -> YMax - ( (float)nRow + 0.5f ) ) - 0.5f;
+		nTexelRow = (long)floor( TexelY );
+		FractionY = TexelY - (float)nTexelRow;
+		pPixel = &pReportPage -> pPixels[ ( (size_t)nRow * pReportPage -> WidthInPixels + nFirstColumn ) * 3 ];
+		for ( nColumn = nFirstColumn; nColumn < nColumnEnd; nColumn++ )
+			{
+			TexelX = ( (float)nColumn + 0.5f - pDrawing -> XMin ) - 0.5f;
+			nTexelColumn = (long)floor( TexelX );
+			FractionX = TexelX - (float)nTexelColumn;
+			Coverage = ( 1.0f - FractionY ) * ( ( 1.0f - FractionX ) * GetGlyphTexel( pDrawing, RowPitch, nTexelColumn, nTexelRow ) +
+														FractionX * GetGlyphTexel( pDrawing, RowPitch, nTexelColumn + 1, nTexelRow ) ) +
+						FractionY * ( ( 1.0f - FractionX ) * GetGlyphTexel( pDrawing, RowPitch, nTexelColumn, nTexelRow + 1 ) +
+														FractionX * GetGlyphTexel( pDrawing, RowPitch, nTexelColumn + 1, nTexelRow + 1 ) );
+			// The glyph coverage runs from 0 to 64, so the shader multiplies it by 4.
+			Alpha = 4.0f * Coverage;
+			if ( Alpha > 1.0f )
+				Alpha = 1.0f;
+			if ( Alpha > 0.0f )
+				{
+				for ( nChannel = 0; nChannel < 3; nChannel++ )
+					pPixel[ nChannel ] = ConvertToColorLevel( ColorValue[ nChannel ] * Alpha + (float)pPixel[ nChannel ] / 255.0f * ( 1.0f - Alpha ) );
+				}
+			pPixel += 3;
+			}
+		}
+}
+
+
+// Find the pair of texels on either side of a sampling position, clamped to the edges of the bitmap.
+static void GetClampedTexelPair( float TexelPosition, long nTexels, long *pnLowerTexel, long *pnUpperTexel, float *pFraction )
+{
+	if ( TexelPosition < 0.0f )
+		TexelPosition = 0.0f;
+	else if ( TexelPosition > (float)( nTexels - 1 ) )
+		TexelPosition = (float)( nTexels - 1 );
+	*pnLowerTexel = (long)floor( TexelPosition );
+	*pFraction = TexelPosition - (float)*pnLowerTexel;
+	*pnUpperTexel = *pnLowerTexel + 1;
+	if ( *pnUpperTexel > nTexels - 1 )
+		*pnUpperTexel = nTexels - 1;
+}
+
+
+static void RasterizeReportBitmap( REPORT_PAGE *pReportPage, REPORT_DRAWING *pDrawing, long nFirstRow, long nEndRow )
+{
+	long				RowPitch;
+	float				XScale, YScale;
+	long				nLowerTexelRow, nUpperTexelRow;
+	long				nLowerTexelColumn, nUpperTexelColumn;
+	float				FractionX, FractionY;
+	unsigned char		*pLowerRow;
+	unsigned char		*pUpperRow;
+	float				LowerValue, UpperValue;
+	long				nRow, nRowEnd;
+	long				nColumn, nFirstColumn, nColumnEnd;
+	int					nChannel;
+	unsigned char		*pPixel;
+
+	RowPitch = ( pDrawing -> SourceWidth * 3 + 3 ) & ~3;
+	XScale = (float)pDrawing -> SourceWidth / ( pDrawing -> XMax - pDrawing -> XMin );
+	YScale = (float)pDrawing -> SourceHeight / ( pDrawing -> YMax - pDrawing -> YMin );
+	GetCoveredPixelRange( pDrawing -> YMin, pDrawing -> YMax, nFirstRow, nEndRow, &nRow, &nRowEnd );
+	GetCoveredPixelRange( pDrawing -> XMin, pDrawing -> XMax, 0, pReportPage -> WidthInPixels, &nFirstColumn, &nColumnEnd );
+	for ( ; nRow < nRowEnd; nRow++ )
+		{
+		GetClampedTexelPair( ( (float)nRow + 0.5f - pDrawing -> YMin ) * YScale - 0.5f, pDrawing -> SourceHeight,
+																&nLowerTexelRow, &nUpperTexelRow, &FractionY );
+		pLowerRow = &pDrawing -> pSourcePixels[ nLowerTexelRow * RowPitch ];
+		pUpperRow = &pDrawing -> pSourcePixels[ nUpperTexelRow * RowPitch ];
+		pPixel = &pReportPage -> pPixels[ ( (size_t)nRow * pReportPage -> WidthInPixels + nFirstColumn ) * 3 ];
+		for ( nColumn = nFirstColumn; nColumn < nColumnEnd; nColumn++ )
+			{
+			GetClampedTexelPair( ( (float)nColumn + 0.5f - pDrawing -> XMin ) * XScale - 0.5f, pDrawing -> SourceWidth,
+																&nLowerTexelColumn, &nUpperTexelColumn, &FractionX );
+			for ( nChannel = 0; nChannel < 3; nChannel++ )
+				{
+				LowerValue = ( 1.0f - FractionX ) * (float)pLowerRow[ nLowerTexelColumn * 3 + nChannel ] +
+											FractionX * (float)pLowerRow[ nUpperTexelColumn * 3 + nChannel ];
+				UpperValue = ( 1.0f - FractionX ) * (float)pUpperRow[ nLowerTexelColumn * 3 + nChannel ] +
+											FractionX * (float)pUpperRow[ nUpperTexelColumn * 3 + nChannel ];
+				pPixel[ nChannel ] = (unsigned char)( ( 1.0f - FractionY ) * LowerValue + FractionY * UpperValue + 0.5f );
+				}
+			pPixel += 3;
+			}
+		}
+}
+
+
+// Draw everything recorded for the page, in the order it was recorded, within the specified
+// band of rows.
+static void RasterizeReportBand( REPORT_PAGE *pReportPage, long nFirstRow, long nEndRow )
+{
+	long				nDrawing;
+	REPORT_DRAWING		*pDrawing;
+
+	for ( nDrawing = 0; nDrawing < pReportPage -> nDrawings; nDrawing++ )
+		{
+		pDrawing = &pReportPage -> pDrawingArray[ nDrawing ];
+		switch ( pDrawing -> DrawingType )
+			{
+			case REPORT_DRAWING_QUAD:
+				RasterizeReportQuad( pReportPage, pDrawing, nFirstRow, nEndRow );
+				break;
+			case REPORT_DRAWING_GLYPH:
+				RasterizeReportGlyph( pReportPage, pDrawing, nFirstRow, nEndRow );
+				break;
+			case REPORT_DRAWING_BITMAP:
+				RasterizeReportBitmap( pReportPage, pDrawing, nFirstRow, nEndRow );
+				break;
+			}
+		}
+}
+
+
+static long CountReportPageBands( REPORT_PAGE *pReportPage )
+{
+	long				nBands = 0;
+
+	if ( pReportPage != 0 && pReportPage -> pPixels != 0 )
+		nBands = ( pReportPage -> HeightInPixels + REPORT_RASTER_BAND_HEIGHT - 1 ) / REPORT_RASTER_BAND_HEIGHT;
+
+	return nBands;
+}
+
+
+// Locate the band of rows for a job, counting the bands page by page.
+static void ExecuteReportRasterJob( REPORT_RASTER_JOB_QUEUE *pReportRasterJobQueue, long nJob )
+{
+	long				nPage;
+	REPORT_PAGE			*pReportPage;
+	long				nFirstRow;
+	long				nEndRow;
+
+	nPage = 0;
+	while ( nJob >= CountReportPageBands( pReportRasterJobQueue -> ppReportPages[ nPage ] ) )
+		{
+		nJob -= CountReportPageBands( pReportRasterJobQueue -> ppReportPages[ nPage ] );
+		nPage++;
+		}
+	pReportPage = pReportRasterJobQueue -> ppReportPages[ nPage ];
+	nFirstRow = nJob * REPORT_RASTER_BAND_HEIGHT;
+	nEndRow = nFirstRow + REPORT_RASTER_BAND_HEIGHT;
+	if ( nEndRow > pReportPage -> HeightInPixels )
+		nEndRow = pReportPage -> HeightInPixels;
+	RasterizeReportBand( pReportPage, nFirstRow, nEndRow );
+}
+
+
+// Each report rasterizing thread claims the next unclaimed band until none remain.
+static unsigned __stdcall ReportRasterThreadFunction( void *pArguments )
+{
+	REPORT_RASTER_JOB_QUEUE		*pReportRasterJobQueue;
+	long						nJob;
+
+	pReportRasterJobQueue = (REPORT_RASTER_JOB_QUEUE*)pArguments;
+	nJob = InterlockedIncrement( &pReportRasterJobQueue -> nNextJobToClaim ) - 1;
+	while ( nJob < pReportRasterJobQueue -> nRasterJobs )
+		{
+		ExecuteReportRasterJob( pReportRasterJobQueue, nJob );
+		nJob = InterlockedIncrement( &pReportRasterJobQueue -> nNextJobToClaim ) - 1;
+		}
+
+	return 0;
+}
+
+
+// Rasterize the drawings recorded for each of the pages onto the page's pixels.  The bands of
+// rows of all the pages are shared among up to nThreads threads.  If no thread can be started,
+// the pages are rasterized on the calling thread.  The result doesn't depend upon the number
+// of threads.
+void RasterizeReportPages( REPORT_PAGE **ppReportPages, long nReportPages, int nThreads )
+{
+	REPORT_RASTER_JOB_QUEUE		ReportRasterJobQueue;
+	HANDLE						hRasterThreadHandles[ MAX_REPORT_RASTER_THREADS ];
+	unsigned					RasterThreadID;
+	int							nThreadsStarted;
+	int							nThread;
+	long						nPage;
+	BOOL						bThreadStarted;
+
+	ReportRasterJobQueue.ppReportPages = ppReportPages;
+	ReportRasterJobQueue.nReportPages = nReportPages;
+	ReportRasterJobQueue.nRasterJobs = 0;
+	ReportRasterJobQueue.nNextJobToClaim = 0;
+	for ( nPage = 0; nPage < nReportPages; nPage++ )
+		ReportRasterJobQueue.nRasterJobs += CountReportPageBands( ppReportPages[ nPage ] );
+	if ( nThreads > MAX_REPORT_RASTER_THREADS )
+		nThreads = MAX_REPORT_RASTER_THREADS;
+	nThreadsStarted = 0;
+	bThreadStarted = TRUE;
+	if ( ReportRasterJobQueue.nRasterJobs > 1 && nThreads > 1 )
+		{
+		while ( bThreadStarted && nThreadsStarted < nThreads && nThreadsStarted < ReportRasterJobQueue.nRasterJobs )
+			{
+			hRasterThreadHandles[ nThreadsStarted ] = (HANDLE)_beginthreadex( NULL, 0, ReportRasterThreadFunction,
+																(void*)&ReportRasterJobQueue, 0, &RasterThreadID );
+			bThreadStarted = ( hRasterThreadHandles[ nThreadsStarted ] != 0 );
+			if ( bThreadStarted )
+				nThreadsStarted++;
+			}
+		}
+	if ( nThreadsStarted > 0 )
+		{
+		WaitForMultipleObjects( nThreadsStarted, hRasterThreadHandles, TRUE, INFINITE );
+		for ( nThread = 0; nThread < nThreadsStarted; nThread++ )
+			CloseHandle( hRasterThreadHandles[ nThread ] );
+		}
+	else
+		ReportRasterThreadFunction( (void*)&ReportRasterJobQueue );
+}
+
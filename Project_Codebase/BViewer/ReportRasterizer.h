@@ -0,0 +1,90 @@
+// ReportRasterizer.h : Defines the CPU rendering of the report overlays onto the
+//  report form image, for saving report pages to files.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#pragma once
+
+#include "Module.h"
+
+
+// The kinds of drawing recorded for a report page.
+#define REPORT_DRAWING_QUAD				1		// A filled quadrilateral, such as one stroke of a checkmark.
+#define REPORT_DRAWING_GLYPH			2		// A text character glyph, blended according to its coverage.
+#define REPORT_DRAWING_BITMAP			3		// An RGB bitmap, such as the reader's signature, scaled to fill a rectangle.
+
+// The number of page rows rasterized as a single job.  The bands of rows are drawn
+// independently, so the bands of one or more pages can be shared among several threads.
+#define REPORT_RASTER_BAND_HEIGHT		64
+#define MAX_REPORT_RASTER_THREADS		8
+
+#define REPORT_DRAWING_ALLOCATION_UNIT	256
+
+
+// The positions are in pixels from the lower left corner of the page, as they are given to
+// OpenGL for a viewport covering the page.
+typedef struct
+	{
+	int				DrawingType;
+	float			Color[ 3 ];				// For quads and glyphs, from 0.0 to 1.0.
+	float			Vertex[ 4 ][ 2 ];		// For quads:  the corners in triangle strip order, lower left,
+											//  lower right, upper left, upper right.
+	float			XMin;					// For glyphs and bitmaps:  the rectangle to be filled.
+	float			YMin;
+	float			XMax;
+	float			YMax;
+	long			SourceWidth;			// For glyphs and bitmaps:  the source pixels, which are
+	long			SourceHeight;			//  not copied and must remain until the page is rasterized.
+	unsigned char	*pSourcePixels;
+	} REPORT_DRAWING;
+
+
+// A report page image.  The pixels are stored as in the report image output buffer, in packed
+// RGB rows from the bottom of the page up.
+typedef struct
+	{
+	long			WidthInPixels;
+	long			HeightInPixels;
+	unsigned char	*pPixels;
+	REPORT_DRAWING	*pDrawingArray;
+	long			nDrawings;
+	long			nDrawingsAllocated;
+	} REPORT_PAGE;
+
+
+
+// Function prototypes.
+//
+BOOL				InitializeReportPage( REPORT_PAGE *pReportPage, long WidthInPixels, long HeightInPixels, unsigned char *pReportFormPixels );
+void				ReleaseReportPage( REPORT_PAGE *pReportPage );
+BOOL				AddReportQuad( REPORT_PAGE *pReportPage, float Vertex[ 4 ][ 2 ], float Color[ 3 ] );
+BOOL				AddReportGlyph( REPORT_PAGE *pReportPage, unsigned char *pGlyphBitmap, long GlyphWidth, long GlyphHeight,
+										float x, float y, float Color[ 3 ] );
+BOOL				AddReportBitmap( REPORT_PAGE *pReportPage, unsigned char *pBitmapPixels, long BitmapWidth, long BitmapHeight,
+										float x, float y, float DisplayedWidth, float DisplayedHeight );
+void				RasterizeReportPages( REPORT_PAGE **ppReportPages, long nReportPages, int nThreads );
+
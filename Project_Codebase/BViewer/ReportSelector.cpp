@@ -29,6 +29,10 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		The report directory is no longer searched when the report list is refreshed,
+//		unless files have been added to or removed from the directory since the list
+//		was last created.  Suspended redrawing while the list control is repopulated.
 //	*[2] 03/14/2023 by Tom Atwood
 //		Fixed code security issues.
 //	*[1] 12/21/2022 by Tom Atwood
@@ -53,6 +57,8 @@ CReportSelector::CReportSelector()
 {
 	m_pFirstReport = 0;
 	m_nCurrentlySelectedItem = -1;
+	m_ListedReportDirectory[ 0 ] = '\0';												// *[3]
+	memset( &m_ListedReportDirectoryWriteTime, 0, sizeof(FILETIME) );					// *[3]
 }
 
 CReportSelector::~CReportSelector()
@@ -109,6 +115,7 @@ void CReportSelector::EraseReportList()
 		free( pPrevReportInfo );
 		}
 	m_pFirstReport = 0;
+	m_ListedReportDirectory[ 0 ] = '\0';				// *[3] The list must be recreated from the directory.
 }
 
 
@@ -126,6 +133,7 @@ void CReportSelector::CreateReportList()
 	REPORT_INFO				*pNewReportInfo;
 	char					*pChar;
 	int						nChar;
+	WIN32_FILE_ATTRIBUTE_DATA	DirectoryAttributes;
 
 	// Add the edited studies to the study list by reading the saved study data files.
 	ReportDirectory[ 0 ] = '\0';			// *[1] Eliminated call to strcpy.
@@ -134,6 +142,16 @@ void CReportSelector::CreateReportList()
 		strncat_s( ReportDirectory, FILE_PATH_STRING_LENGTH, "\\", _TRUNCATE );									// *[1] Replaced strncat with strncat_s.
 	// Check existence of path to configuration directory.
 	bNoError = SetCurrentDirectory( ReportDirectory );
+	// *[3] Adding, removing or renaming a report file updates the directory's last write time.  If
+	// this hasn't changed since the list was created, the current list is still valid.
+	if ( bNoError && GetFileAttributesEx( ReportDirectory, GetFileExInfoStandard, &DirectoryAttributes ) )
+		{
+		if ( strcmp( ReportDirectory, m_ListedReportDirectory ) == 0 &&
+					CompareFileTime( &DirectoryAttributes.ftLastWriteTime, &m_ListedReportDirectoryWriteTime ) == 0 )
+			bNoError = FALSE;
+		}
+	else
+		memset( &DirectoryAttributes, 0, sizeof(WIN32_FILE_ATTRIBUTE_DATA) );
 	if ( bNoError )
 		{
 		pLastReportInfoInList = 0;
@@ -196,6 +214,12 @@ void CReportSelector::CreateReportList()
 			}
 		if ( hFindFile != INVALID_HANDLE_VALUE )
 			FindClose( hFindFile );
+		// *[3] Record the directory state this list was created from.
+		if ( DirectoryAttributes.ftLastWriteTime.dwLowDateTime != 0 || DirectoryAttributes.ftLastWriteTime.dwHighDateTime != 0 )
+			{
+			strncpy_s( m_ListedReportDirectory, FILE_PATH_STRING_LENGTH, ReportDirectory, _TRUNCATE );
+			m_ListedReportDirectoryWriteTime = DirectoryAttributes.ftLastWriteTime;
+			}
 		}
 }
 
@@ -237,6 +261,7 @@ void CReportSelector::UpdateReportListDisplay()
 	char						ListItemText[ 2048 ];
 	char						*pText;
 
+	SetRedraw( FALSE );			// *[3]
 	DeleteAllItems();
 	pHdrCtrl = GetHeaderCtrl();
 	HeaderItemCount = pHdrCtrl -> GetItemCount();
@@ -309,6 +334,8 @@ void CReportSelector::UpdateReportListDisplay()
 		pReportInfo = pReportInfo -> pNextReportInfo;
 		}
 	SortItems( TextColumnSortComparator, (LPARAM)this );
+	SetRedraw( TRUE );			// *[3]
+	Invalidate( TRUE );			// *[3]
 }
 
 
@@ -72,6 +72,8 @@ public:
 	REPORT_LIST_FORMAT			*m_pReportListFormat;
 	CReportSelectorHeading		m_ReportSelectorHeading;
 	int							m_nCurrentlySelectedItem;
+	char						m_ListedReportDirectory[ FILE_PATH_STRING_LENGTH ];
+	FILETIME					m_ListedReportDirectoryWriteTime;		// When the listed report directory was last changed.
 
 public:
 	void				UpdateReportListDisplay();
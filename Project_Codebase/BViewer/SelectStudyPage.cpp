@@ -29,6 +29,12 @@
 //
 // UPDATE HISTORY:
 //
+//	*[4] 10/19/2026 by agent
+//		The study selection list is a virtual list.  Its check boxes and SOP instance UIDs
+//		are read from the list's rows, rather than from the list control.
+//	*[3] 10/19/2026 by agent
+//		Remove deleted studies through RemoveStudyFromList(), which also removes them from
+//		the patient index.
 //	*[2] 03/28/2023 by Tom Atwood
 //		Fixed code security issues.
 //	*[1] 01/10/2023 by Tom Atwood
@@ -94,7 +100,7 @@ BOOL CSelectStudyPage::OnInitDialog()
 	if ( m_pPatientListCtrl != 0 )
 		{
 		m_pPatientListCtrl -> Create( WS_CHILD | WS_MAXIMIZE | WS_TABSTOP | WS_VISIBLE |
-										LVS_REPORT | LVS_SHOWSELALWAYS | LVS_SINGLESEL | LVS_SORTASCENDING,
+										LVS_REPORT | LVS_SHOWSELALWAYS | LVS_SINGLESEL | LVS_OWNERDATA,		// *[4] The list sorts its own rows.
 										ClientRect, this, IDC_PATIENT_LIST );
 		m_pPatientListCtrl -> SetExtendedStyle( LVS_EX_CHECKBOXES | LVS_EX_FULLROWSELECT | LVS_EX_GRIDLINES );
 		m_pPatientListCtrl -> SetTextBkColor( COLOR_ANALYSIS_BKGD );
@@ -232,10 +238,10 @@ void CSelectStudyPage::DeleteCheckedImages()
 		nItems = m_pPatientListCtrl -> GetItemCount();
 		for ( nItem = 0; nItem < nItems; nItem++ )
 			{
-			if ( m_pPatientListCtrl -> GetCheck( nItem ) != 0 )
+			if ( m_pPatientListCtrl -> GetRowCheck( nItem ) )												// *[4]
 				{
 				bMatchingImageFound = FALSE;
-				SubitemText = m_pPatientListCtrl -> GetItemText( nItem, m_pPatientListCtrl -> m_pListFormat -> nColumns - 1 );
+				SubitemText = m_pPatientListCtrl -> GetRowSOPInstanceUID( nItem );								// *[4]
 				pAvailableStudyListElement = ThisBViewerApp.m_AvailableStudyList;
 				while ( pAvailableStudyListElement != 0 && !bMatchingImageFound )
 					{
@@ -279,7 +285,7 @@ void CSelectStudyPage::DeleteCheckedImages()
 							}
 						}
 					pStudy -> DeleteStudyDataAndImages();
-					RemoveFromList( &ThisBViewerApp.m_AvailableStudyList, (void*)pStudy );
+					ThisBViewerApp.RemoveStudyFromList( &ThisBViewerApp.m_AvailableStudyList, pStudy );		// *[3]
 					delete pStudy;
 					pStudy = 0;			// *[1] Added this for code safety.
 					m_pPatientListCtrl -> m_nCurrentlySelectedItem = -1;
@@ -287,11 +293,7 @@ void CSelectStudyPage::DeleteCheckedImages()
 				}			// ...end if item checked.
 			}			// ...end for next list item.
 		m_pPatientListCtrl -> UpdatePatientList();
-		nItems = m_pPatientListCtrl -> GetItemCount();
-		for ( nItem = 0; nItem < nItems; nItem++ )
-			{
-			m_pPatientListCtrl -> SetCheck( nItem, 0 );
-			}
+		m_pPatientListCtrl -> ClearRowChecks();							// *[4]
 		Invalidate();
 		UpdateWindow();
 		}
@@ -332,7 +334,7 @@ void CSelectStudyPage::DeleteStudyList()
 							}
 						}
 					pStudy -> DeleteStudyDataAndImages();
-					RemoveFromList( &ThisBViewerApp.m_AvailableStudyList, (void*)pStudy );
+					ThisBViewerApp.RemoveStudyFromList( &ThisBViewerApp.m_AvailableStudyList, pStudy );		// *[3]
 					delete pStudy;
 					pStudy = 0;
 					pAvailableStudyListElement = 0;
@@ -341,11 +343,7 @@ void CSelectStudyPage::DeleteStudyList()
 				}
 			}			// ...end for next list item.
 		m_pPatientListCtrl -> UpdatePatientList();
-		nItems = m_pPatientListCtrl -> GetItemCount();
-		for ( nItem = 0; nItem < nItems; nItem++ )
-			{
-			m_pPatientListCtrl -> SetCheck( nItem, 0 );
-			}
+		m_pPatientListCtrl -> ClearRowChecks();							// *[4]
 		Invalidate();
 		UpdateWindow();
 		}
@@ -0,0 +1,265 @@
+// StandardManifest.cpp : Implements the copying of the I.L.O. standard image files from
+//  the installation media, and their verification against the standards manifest.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include "Module.h"
+#include "StandardManifest.h"
+#include "zlib.h"
+
+
+// The standard files are read from the media in blocks of this size.
+#define STANDARD_FILE_COPY_BUFFER_SIZE		0x100000
+
+
+// Copy the next blank-delimited field of a manifest line, and advance past it.
+static BOOL ReadManifestField( char **ppChar, char *pField, size_t FieldSize )
+{
+	BOOL				bNoError = TRUE;
+	char				*pChar;
+	size_t				FieldLength;
+
+	pChar = *ppChar;
+	while ( *pChar == ' ' || *pChar == '\t' )
+		pChar++;
+	FieldLength = strcspn( pChar, " \t\r\n" );
+	bNoError = ( FieldLength > 0 && FieldLength < FieldSize );
+	if ( bNoError )
+		{
+		memcpy( pField, pChar, FieldLength );
+		pField[ FieldLength ] = '\0';
+		}
+	*ppChar = pChar + FieldLength;
+
+	return bNoError;
+}
+
+
+// Read a manifest field as a number in the specified base.
+static BOOL ReadManifestNumber( char **ppChar, int NumberBase, unsigned long *pNumber )
+{
+	BOOL				bNoError = TRUE;
+	char				NumberText[ 32 ];
+	char				*pEndOfNumber;
+
+	bNoError = ReadManifestField( ppChar, NumberText, 32 );
+	if ( bNoError )
+		{
+		*pNumber = strtoul( NumberText, &pEndOfNumber, NumberBase );
+		bNoError = ( *pEndOfNumber == '\0' );
+		}
+
+	return bNoError;
+}
+
+
+// Read the manifest of standard files.  A manifest with any line that cannot be
+// interpreted is rejected as a whole.
+BOOL ReadStandardManifest( char *pManifestFileSpec, STANDARD_MANIFEST **ppManifest )
+{
+	BOOL						bNoError = TRUE;
+	STANDARD_MANIFEST			*pManifest;
+	STANDARD_MANIFEST_ENTRY		*pEntry;
+	FILE						*pManifestFile = 0;
+	char						TextLine[ MAX_EXTRA_LONG_STRING_LENGTH ];
+	char						*pChar;
+
+	*ppManifest = 0;
+	pManifest = (STANDARD_MANIFEST*)calloc( 1, sizeof(STANDARD_MANIFEST) );
+	bNoError = ( pManifest != 0 );
+	if ( bNoError )
+		{
+		pManifest -> pEntries = (STANDARD_MANIFEST_ENTRY*)calloc( MAX_STANDARD_MANIFEST_ENTRIES, sizeof(STANDARD_MANIFEST_ENTRY) );
+		bNoError = ( pManifest -> pEntries != 0 );
+		}
+	if ( bNoError )
+		{
+		pManifestFile = fopen( pManifestFileSpec, "rt" );
+		bNoError = ( pManifestFile != 0 );
+		}
+	while ( bNoError && fgets( TextLine, MAX_EXTRA_LONG_STRING_LENGTH, pManifestFile ) != 0 )
+		{
+		pChar = TextLine;
+		while ( *pChar == ' ' || *pChar == '\t' )
+			pChar++;
+		if ( *pChar != '#' && *pChar != '\r' && *pChar != '\n' && *pChar != '\0' )
+			{
+			bNoError = ( pManifest -> nEntries < MAX_STANDARD_MANIFEST_ENTRIES );
+			if ( bNoError )
+				{
+				pEntry = &pManifest -> pEntries[ pManifest -> nEntries ];
+				bNoError = ReadManifestField( &pChar, pEntry -> FileName, STANDARD_FILE_NAME_LENGTH ) &&
+							ReadManifestNumber( &pChar, 10, &pEntry -> FileSize ) &&
+							ReadManifestNumber( &pChar, 16, &pEntry -> FileCRC ) &&
+							ReadManifestField( &pChar, pEntry -> SOPInstanceUID, STANDARD_UID_STRING_LENGTH );
+				}
+			if ( bNoError )
+				{
+				// Nothing may follow the SOP instance UID.
+				pChar += strspn( pChar, " \t\r\n" );
+				bNoError = ( *pChar == '\0' );
+				}
+			if ( bNoError )
+				pManifest -> nEntries++;
+			}
+		}
+	if ( pManifestFile != 0 )
+		fclose( pManifestFile );
+	if ( bNoError )
+		bNoError = ( pManifest -> nEntries > 0 );
+	if ( bNoError )
+		*ppManifest = pManifest;
+	else
+		DeallocateStandardManifest( pManifest );
+
+	return bNoError;
+}
+
+
+void DeallocateStandardManifest( STANDARD_MANIFEST *pManifest )
+{
+	if ( pManifest != 0 )
+		{
+		if ( pManifest -> pEntries != 0 )
+			free( pManifest -> pEntries );
+		free( pManifest );
+		}
+}
+
+
+// The media file names are compared without regard to case.
+STANDARD_MANIFEST_ENTRY *FindStandardManifestEntry( STANDARD_MANIFEST *pManifest, char *pFileName )
+{
+	STANDARD_MANIFEST_ENTRY		*pEntry = 0;
+	unsigned long				nEntry;
+
+	for ( nEntry = 0; pEntry == 0 && nEntry < pManifest -> nEntries; nEntry++ )
+		if ( _stricmp( pManifest -> pEntries[ nEntry ].FileName, pFileName ) == 0 )
+			pEntry = &pManifest -> pEntries[ nEntry ];
+
+	return pEntry;
+}
+
+
+// Copy a standard file, calculating the size and the CRC-32 of its contents as it is copied,
+// so that the media are read only once.  If the copy fails, the partial copy is removed.
+BOOL CopyStandardFile( char *pSourceFileSpec, char *pCopiedFileSpec, unsigned long *pFileSize, unsigned long *pFileCRC )
+{
+	BOOL				bNoError = TRUE;
+	FILE				*pSourceFile = 0;
+	FILE				*pCopiedFile = 0;
+	unsigned char		*pBuffer;
+	size_t				nBytesRead;
+	unsigned long		FileSize;
+	unsigned long		FileCRC;
+
+	FileSize = 0L;
+	FileCRC = crc32( 0L, Z_NULL, 0 );
+	pBuffer = (unsigned char*)malloc( STANDARD_FILE_COPY_BUFFER_SIZE );
+	bNoError = ( pBuffer != 0 );
+	if ( bNoError )
+		{
+		pSourceFile = fopen( pSourceFileSpec, "rb" );
+		bNoError = ( pSourceFile != 0 );
+		}
+	if ( bNoError )
+		{
+		pCopiedFile = fopen( pCopiedFileSpec, "wb" );
+		bNoError = ( pCopiedFile != 0 );
+		}
+	if ( bNoError )
+		{
+		do
+			{
+			nBytesRead = fread_s( pBuffer, STANDARD_FILE_COPY_BUFFER_SIZE, 1, STANDARD_FILE_COPY_BUFFER_SIZE, pSourceFile );
+			if ( nBytesRead > 0 )
+				{
+				FileCRC = crc32( FileCRC, (Bytef*)pBuffer, (uInt)nBytesRead );
+				FileSize += (unsigned long)nBytesRead;
+				bNoError = ( fwrite( pBuffer, 1, nBytesRead, pCopiedFile ) == nBytesRead );
+				}
+			}
+		while ( bNoError && nBytesRead == STANDARD_FILE_COPY_BUFFER_SIZE );
+		if ( bNoError )
+			bNoError = ( ferror( pSourceFile ) == 0 );
+		}
+	if ( pSourceFile != 0 )
+		fclose( pSourceFile );
+	if ( pCopiedFile != 0 )
+		{
+		if ( fclose( pCopiedFile ) != 0 )
+			bNoError = FALSE;
+		if ( !bNoError )
+			remove( pCopiedFileSpec );
+		}
+	if ( pBuffer != 0 )
+		free( pBuffer );
+	*pFileSize = FileSize;
+	*pFileCRC = FileCRC;
+
+	return bNoError;
+}
+
+
+// Check the size and CRC-32 of a copied standard file against the manifest entry for its
+// media file name.  A matching entry is marked as verified.
+int VerifyStandardFile( STANDARD_MANIFEST *pManifest, char *pFileName, unsigned long FileSize, unsigned long FileCRC )
+{
+	int							VerificationResult;
+	STANDARD_MANIFEST_ENTRY		*pEntry;
+
+	pEntry = FindStandardManifestEntry( pManifest, pFileName );
+	if ( pEntry == 0 )
+		VerificationResult = STANDARD_FILE_NOT_LISTED;
+	else
+		{
+		pEntry -> bFileVerified = ( pEntry -> FileSize == FileSize && pEntry -> FileCRC == FileCRC );
+		if ( pEntry -> bFileVerified )
+			VerificationResult = STANDARD_FILE_VERIFIED;
+		else
+			VerificationResult = STANDARD_FILE_CORRUPT;
+		}
+
+	return VerificationResult;
+}
+
+
+// A standard image may be installed only if the media file it was extracted from has been
+// copied and verified.
+BOOL StandardImageIsVerified( STANDARD_MANIFEST *pManifest, char *pSOPInstanceUID )
+{
+	BOOL						bImageIsVerified = FALSE;
+	unsigned long				nEntry;
+
+	for ( nEntry = 0; nEntry < pManifest -> nEntries; nEntry++ )
+		if ( strcmp( pManifest -> pEntries[ nEntry ].SOPInstanceUID, pSOPInstanceUID ) == 0 &&
+					pManifest -> pEntries[ nEntry ].bFileVerified )
+			bImageIsVerified = TRUE;
+
+	return bImageIsVerified;
+}
+
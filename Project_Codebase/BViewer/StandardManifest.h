@@ -0,0 +1,79 @@
+// StandardManifest.h : Defines the manifest of the I.L.O. standard image files, and the
+//  functions that copy the standard files from the installation media and check them
+//  against the manifest.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#pragma once
+
+#include "Module.h"
+
+
+// The manifest is looked for beside the DICOMDIR file on the standards media, and then in
+// the BViewer configuration folder.
+#define STANDARD_MANIFEST_FILE_NAME			"StandardsManifest.txt"
+
+#define MAX_STANDARD_MANIFEST_ENTRIES		256
+#define STANDARD_FILE_NAME_LENGTH			64
+#define STANDARD_UID_STRING_LENGTH			128
+
+// Results of checking a copied standard file against the manifest.
+#define STANDARD_FILE_VERIFIED				1
+#define STANDARD_FILE_NOT_LISTED			2
+#define STANDARD_FILE_CORRUPT				3
+
+
+// Each manifest line lists a Dicom file on the standards media by its file name, followed
+// by its size in bytes, the CRC-32 of its contents in hexadecimal, and the SOP instance UID
+// of the standard image it holds.  Blank lines and lines beginning with '#' are ignored.
+typedef struct
+	{
+	char				FileName[ STANDARD_FILE_NAME_LENGTH ];
+	unsigned long		FileSize;
+	unsigned long		FileCRC;
+	char				SOPInstanceUID[ STANDARD_UID_STRING_LENGTH ];
+	BOOL				bFileVerified;			// Set when a copy of the file matches the manifest.
+	} STANDARD_MANIFEST_ENTRY;
+
+
+typedef struct
+	{
+	unsigned long				nEntries;
+	STANDARD_MANIFEST_ENTRY		*pEntries;
+	} STANDARD_MANIFEST;
+
+
+
+// Function prototypes.
+//
+BOOL						ReadStandardManifest( char *pManifestFileSpec, STANDARD_MANIFEST **ppManifest );
+void						DeallocateStandardManifest( STANDARD_MANIFEST *pManifest );
+STANDARD_MANIFEST_ENTRY		*FindStandardManifestEntry( STANDARD_MANIFEST *pManifest, char *pFileName );
+BOOL						CopyStandardFile( char *pSourceFileSpec, char *pCopiedFileSpec, unsigned long *pFileSize, unsigned long *pFileCRC );
+int							VerifyStandardFile( STANDARD_MANIFEST *pManifest, char *pFileName, unsigned long FileSize, unsigned long FileCRC );
+BOOL						StandardImageIsVerified( STANDARD_MANIFEST *pManifest, char *pSOPInstanceUID );
+
@@ -30,6 +30,23 @@
 //
 // UPDATE HISTORY:
 //
+//	*[9] 10/19/2026 by agent
+//		Check each standard file against the manifest of the expected file sizes and
+//		CRC-32 values shipped with the standards, instead of against the source file it
+//		was just copied from.  The file is copied and its CRC-32 calculated in a single
+//		pass, so the media are read only once.  LoadReferenceStandards() counts and
+//		installs only the standard images extracted from verified files.
+//	*[8] 10/19/2026 by agent
+//		Remove an installed standard study through RemoveStudyFromList(), which also
+//		removes it from the patient index.
+//	*[7] 10/19/2026 by agent
+//		A copied standard image file is also compared with its source by the CRC-32 of
+//		its contents.
+//	*[6] 10/19/2026 by agent
+//		Verify each copied standard image file against its source before it is handed
+//		to BRetriever, so that an unreadable or truncated file on the standards media is
+//		reported instead of stalling the installation.  Shortened the polling interval
+//		while waiting for BRetriever to extract the standard images.
 //	*[5] 02/21/2024 by Tom Atwood
 //		Fixed code security issues.
 //	*[4] 02/05/2024 by Tom Atwood
@@ -51,6 +68,7 @@
 #include "StandardSelector.h"
 #include "Access.h"
 #include "CustomizePage.h"
+#include "StandardManifest.h"				// *[9]
 
 
 extern CONFIGURATION				BViewerConfiguration;
@@ -81,6 +99,8 @@ static ERROR_DICTIONARY_ENTRY	InstallErrorCodes[] =
 				{ INSTALL_ERROR_FILE_MOVE				, "An error occurred attempting to stage the installable image file." },
 				{ INSTALL_ERROR_DICOMDIR_READ			, "An error occurred attempting to read a DICOMDIR file." },
 				{ INSTALL_ERROR_WAITING_FOR_MEDIA		, "The I.L.O. standards disk needs to be mounted." },
+				{ INSTALL_ERROR_FILE_CORRUPT			, "A standard image file on the installation media did not match the standards manifest." },	// *[9]
+				{ INSTALL_ERROR_MANIFEST_READ			, "An error occurred attempting to read the standards manifest." },							// *[9]
 				{ 0										, NULL }
 			};
 
@@ -208,6 +228,7 @@ CStandardSelector::CStandardSelector( int DialogWidth, int DialogHeight, COLORRE
 	m_WindowStyle = WindowStyle;
 	m_pExplorer = new CTreeCtrl;
 	m_pListOfFileSetItems = 0;
+	m_pStandardManifest = 0;					// *[9]
 	m_TotalImageFilesInstalled = 0;
 	m_SelectedDriveSpec[ 0 ] = '\0';			// *[1] Eliminated call to strcpy.
 	m_bStandardsVolumeFound = FALSE;
@@ -220,6 +241,7 @@ CStandardSelector::~CStandardSelector()
 {
 	if ( m_pExplorer != 0 )
 		delete m_pExplorer;
+	DeallocateStandardManifest( m_pStandardManifest );		// *[9]
 	DestroyWindow();
 }
 
@@ -437,13 +459,17 @@ void CStandardSelector::InstallFromDICOMDIRFile()
 		strncat_s( SearchDirectory, FULL_FILE_SPEC_STRING_LENGTH, "Queued Files\\", _TRUNCATE );											// *[3] Replaced strcat with strncat_s.
 		pCustomizePage -> DeleteFolderContents( SearchDirectory, 0 );
 		}
-	bNoError = ReadDicomDirectoryFile( m_SelectedFileSpec );
-	if ( !bNoError )
+	bNoError = LoadStandardManifest();																										// *[9]
+	if ( bNoError )																															// *[9]
 		{
-		strncpy_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "An error occurred interpreting\nthe Dicom file set information from", _TRUNCATE );	// *[1] Replaced strcpy with strncpy_s.
-		strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, m_SelectedFileSpec, _TRUNCATE );														// *[3] Replaced strcat with strncat_s.
-		strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "\nfor install.", _TRUNCATE );														// *[3] Replaced strcat with strncat_s.
-		ThisBViewerApp.NotifyUserOfInstallSearchStatus( INSTALL_ERROR_DICOMDIR_READ, Msg, pTechSupportMessage );
+		bNoError = ReadDicomDirectoryFile( m_SelectedFileSpec );
+		if ( !bNoError )
+			{
+			strncpy_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "An error occurred interpreting\nthe Dicom file set information from", _TRUNCATE );	// *[1] Replaced strcpy with strncpy_s.
+			strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, m_SelectedFileSpec, _TRUNCATE );													// *[3] Replaced strcat with strncat_s.
+			strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "\nfor install.", _TRUNCATE );														// *[3] Replaced strcat with strncat_s.
+			ThisBViewerApp.NotifyUserOfInstallSearchStatus( INSTALL_ERROR_DICOMDIR_READ, Msg, pTechSupportMessage );
+			}
 		}
 	if ( bNoError )
 		{
@@ -455,7 +481,7 @@ void CStandardSelector::InstallFromDICOMDIRFile()
 			ThisBViewerApp.ReadNewAbstractData();
 			// Count the number of standard images available so far.
 			bNoError = LoadReferenceStandards( TRUE);
-			Sleep( 3000 );	// Wait 3 seconds for BRetriever to provide more PNG files.
+			Sleep( 1000 );	// *[6] Wait 1 second for BRetriever to provide more PNG files.
 			}
 		}
 	if ( bNoError )
@@ -485,6 +511,58 @@ void CStandardSelector::InstallFromDICOMDIRFile()
 }
 
 
+// *[9] Read the manifest of the standard files, which is looked for beside the DICOMDIR file
+// on the standards media and then in the configuration folder.  Without a manifest the
+// standard files are installed as they are read, as before.  A manifest that is present
+// but cannot be read stops the installation.
+BOOL CStandardSelector::LoadStandardManifest()
+{
+	BOOL					bNoError = TRUE;
+	BOOL					bManifestFound;
+	char					ManifestFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+	char					*pChar;
+	char					Msg[ MAX_EXTRA_LONG_STRING_LENGTH ];
+
+	DeallocateStandardManifest( m_pStandardManifest );
+	m_pStandardManifest = 0;
+	strncpy_s( ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH, m_SelectedFileSpec, _TRUNCATE );
+	pChar = strrchr( ManifestFileSpec, '\\' );
+	if ( pChar != 0 )
+		pChar[ 1 ] = '\0';
+	strncat_s( ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH, STANDARD_MANIFEST_FILE_NAME, _TRUNCATE );
+	bManifestFound = ( GetFileAttributes( ManifestFileSpec ) != INVALID_FILE_ATTRIBUTES );
+	if ( !bManifestFound )
+		{
+		strncpy_s( ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH, BViewerConfiguration.ConfigDirectory, _TRUNCATE );
+		if ( ManifestFileSpec[ strlen( ManifestFileSpec ) - 1 ] != '\\' )
+			strncat_s( ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH, "\\", _TRUNCATE );
+		strncat_s( ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH, STANDARD_MANIFEST_FILE_NAME, _TRUNCATE );
+		bManifestFound = ( GetFileAttributes( ManifestFileSpec ) != INVALID_FILE_ATTRIBUTES );
+		}
+	if ( bManifestFound )
+		{
+		bNoError = ReadStandardManifest( ManifestFileSpec, &m_pStandardManifest );
+		if ( bNoError )
+			{
+			_snprintf_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, _TRUNCATE, "Checking the standard files against the %d files listed in %s.",
+							m_pStandardManifest -> nEntries, ManifestFileSpec );
+			LogMessage( Msg, MESSAGE_TYPE_NORMAL_LOG );
+			}
+		else
+			{
+			strncpy_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "The standards manifest\n", _TRUNCATE );
+			strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, ManifestFileSpec, _TRUNCATE );
+			strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "\ncould not be read.", _TRUNCATE );
+			ThisBViewerApp.NotifyUserOfInstallSearchStatus( INSTALL_ERROR_MANIFEST_READ, Msg, pTechSupportMessage );
+			}
+		}
+	else
+		LogMessage( "No standards manifest was found.  The standard files are installed without being checked.", MESSAGE_TYPE_NORMAL_LOG );
+
+	return bNoError;
+}
+
+
 // Import a designated file into the BRetriever watch folder, from which
 // it will be picked up and processed.
 BOOL CStandardSelector::CopyDesignatedFile( char *pSourceImageFileSpec )
@@ -495,6 +573,9 @@ BOOL CStandardSelector::CopyDesignatedFile( char *pSourceImageFileSpec )
 	char					*pChar;
 	BOOL					bNoError = TRUE;
 	int						RenameResult;
+	unsigned long			FileSize;				// *[9]
+	unsigned long			FileCRC;				// *[9]
+	int						VerificationResult;		// *[9]
 
 	if ( strlen( pSourceImageFileSpec ) > 0 )
 		{
@@ -505,8 +586,23 @@ BOOL CStandardSelector::CopyDesignatedFile( char *pSourceImageFileSpec )
 		pChar = strrchr( pSourceImageFileSpec, '\\' );
 		pChar++;
 		strncat_s( FullOutputImageFileSpec, FILE_PATH_STRING_LENGTH, pChar, _TRUNCATE );									// *[2] Replaced strncat with strncat_s.
-		bNoError = CopyFile( FullInputImageFileSpec, FullOutputImageFileSpec, FALSE );
-		if ( bNoError )
+		VerificationResult = STANDARD_FILE_VERIFIED;																			// *[9] Unless the manifest shows otherwise.
+		bNoError = CopyStandardFile( FullInputImageFileSpec, FullOutputImageFileSpec, &FileSize, &FileCRC );					// *[9]
+		if ( bNoError && m_pStandardManifest != 0 )																				// *[9]
+			VerificationResult = VerifyStandardFile( m_pStandardManifest, pChar, FileSize, FileCRC );
+		if ( bNoError && VerificationResult != STANDARD_FILE_VERIFIED )															// *[6] *[9]
+			{
+			bNoError = FALSE;
+			remove( FullOutputImageFileSpec );
+			strncpy_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "The standards media file\n", _TRUNCATE );
+			strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, FullInputImageFileSpec, _TRUNCATE );
+			if ( VerificationResult == STANDARD_FILE_NOT_LISTED )																// *[9]
+				strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "\nis not listed in the standards manifest.", _TRUNCATE );
+			else
+				strncat_s( Msg, MAX_EXTRA_LONG_STRING_LENGTH, "\nis damaged or unreadable.", _TRUNCATE );
+			ThisBViewerApp.NotifyUserOfImportSearchStatus( INSTALL_ERROR_FILE_CORRUPT, Msg, "Check the I.L.O. standards media." );
+			}
+		else if ( bNoError )																					// *[6]
 			{
 			bNoError = MakeFileWriteable( FullOutputImageFileSpec );										// *[4] Intrroduced this function to avoid a race condition.
 
@@ -723,7 +819,8 @@ BOOL CStandardSelector::ReadDicomDirectoryFile( char *pDicomdirFileSpec )
 						strncpy_s( pChar, FULL_FILE_SPEC_STRING_LENGTH - (INT_PTR)( pChar - FullSourceFileSpec ),
 												pImageFileSetSpecification -> NodeInformation, _TRUNCATE );										// *[1] Replaced strcpy with strncpy_s.
 						}
-					bNoError = CopyDesignatedFile( FullSourceFileSpec );
+					if ( !CopyDesignatedFile( FullSourceFileSpec ) )			// *[9] A file that fails its check fails the installation.
+						bNoError = FALSE;
 					m_nFilesCopiedFromMedia++;
 					sprintf_s( Step2StatusMessage, MAX_LOGGING_STRING_LENGTH, "Status:  %d of %2d files copied from I.L.O. media.", m_nFilesCopiedFromMedia, m_nStandards );
 					if ( m_nFilesCopiedFromMedia == m_nStandards )
@@ -844,6 +941,7 @@ BOOL CStandardSelector::LoadReferenceStandards( BOOL bCountOnly )
 	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
 	char					*pImageFileName;
 	BOOL					bValidLevel;
+	char					Msg[ MAX_LOGGING_STRING_LENGTH ];			// *[9]
 
 	m_nFilesEncodedAsPNG = 0L;
 	pStudyListElement = ThisBViewerApp.m_NewlyArrivedStudyList;
@@ -874,7 +972,19 @@ BOOL CStandardSelector::LoadReferenceStandards( BOOL bCountOnly )
 							if ( pDiagnosticImage != 0 )
 								{
 								pImageFileName = pDiagnosticImage -> SOPInstanceUID;
-								if ( pImageFileName != 0 )
+								if ( pImageFileName != 0 && m_pStandardManifest != 0 &&
+											!StandardImageIsVerified( m_pStandardManifest, pImageFileName ) )		// *[9]
+									{
+									// *[9] An image that was not extracted from a verified media file is
+									// neither counted nor installed.  It is removed below with its series.
+									if ( !bCountOnly )
+										{
+										_snprintf_s( Msg, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
+														"Standard image %s is not from a verified media file and was not installed.", pImageFileName );
+										LogMessage( Msg, MESSAGE_TYPE_NORMAL_LOG );
+										}
+									}
+								else if ( pImageFileName != 0 )														// *[9]
 									{
 									if ( bCountOnly )
 										{
@@ -947,7 +1057,7 @@ BOOL CStandardSelector::LoadReferenceStandards( BOOL bCountOnly )
 				{
 				LogMessage( "Deleting installed standard study, etc.", MESSAGE_TYPE_SUPPLEMENTARY );
 				pStudy -> DeleteStudyDataAndImages();
-				RemoveFromList( &ThisBViewerApp.m_NewlyArrivedStudyList, (void*)pStudy );
+				ThisBViewerApp.RemoveStudyFromList( &ThisBViewerApp.m_NewlyArrivedStudyList, pStudy );		// *[8]
 				delete pStudy;
 				ThisBViewerApp.m_pCurrentStudy = 0;
 				LogMessage( "    Study, etc., deleted.", MESSAGE_TYPE_SUPPLEMENTARY );
@@ -32,6 +32,7 @@
 
 #include "Dicom.h"
 #include "TomStatic.h"
+#include "StandardManifest.h"
 
 
 #define INSTALL_ERROR_INSUFFICIENT_MEMORY		1
@@ -39,8 +40,10 @@
 #define INSTALL_ERROR_FILE_MOVE					3
 #define INSTALL_ERROR_DICOMDIR_READ				4
 #define INSTALL_ERROR_WAITING_FOR_MEDIA			5
+#define INSTALL_ERROR_FILE_CORRUPT				6
+#define INSTALL_ERROR_MANIFEST_READ				7
 
-#define INSTALL_ERROR_DICT_LENGTH				5
+#define INSTALL_ERROR_DICT_LENGTH				7
 
 
 
@@ -101,6 +104,7 @@ public:
 	unsigned long					m_nFilesEncodedAsPNG;
 	unsigned long					m_nFilesReadyForUse;
 	unsigned long					m_TotalImageFilesInstalled;
+	STANDARD_MANIFEST				*m_pStandardManifest;
 
 // Method prototypes:
 //
@@ -109,6 +113,7 @@ public:
 	void				ListStorageDevices();
 	void				InstallFromDICOMDIRFile();
 	BOOL				SetPosition( int x, int y, CWnd *pParentWnd, CString WindowClass );
+	BOOL				LoadStandardManifest();
 	BOOL				CopyDesignatedFile( char *pSourceImageFileSpec );
 	BOOL				CopyDirectoryContents( char *pSourceDirectorySpec );
 	void				EraseFileSpecList( IMAGE_FILE_SET_SPECIFICATION **ppFileSpecList );
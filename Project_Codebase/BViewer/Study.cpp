@@ -29,6 +29,26 @@
 //
 // UPDATE HISTORY:
 //
+//	*[9] 10/19/2026 by agent
+//		The study file records are now composed member by member by the functions in
+//		StudyFile.cpp, so that the layout no longer depends on the structure packing of
+//		the build (SDY file version 5).  The earlier field-by-field layout is read from
+//		memory, and is written instead when the configuration calls for study files that
+//		earlier BViewer versions can read.
+//	*[8] 10/19/2026 by agent
+//		Study files are now written in a sectioned layout (SDY file version 4):  a header
+//		with a CRC-32, a section table and contiguous arrays of fixed-length records.  The
+//		whole file is composed in memory and written in one operation, and is read back
+//		in one operation.  Sections and record members added by later versions are skipped.
+//		Files in the earlier field-by-field layout are still read by RestoreLegacyStudyFile(),
+//		and are converted when the study is next saved.
+//	*[7] 10/19/2026 by agent
+//		MergeWithExistingStudies() looks up the matching patient in the application's
+//		patient index instead of searching both study lists.
+//	*[6] 10/19/2026 by agent
+//		Buffer the study file I/O, so that a study file is read from disk in a single
+//		operation and written with as few operations as possible, instead of one
+//		operation per field.  The file format is unchanged.
 //	*[5] 01/23/2024 by Tom Atwood
 //		Fixed code security issues.
 //	*[4] 01/23/2024 by Tom Atwood
@@ -43,12 +63,17 @@
 //
 //
 #include "StdAfx.h"
+#include <sys/types.h>																// *[6]
+#include <sys/stat.h>																// *[6]
 #include "BViewer.h"
 #include "Study.h"
 #include "Configuration.h"
 #include "Customization.h"
 
 
+#define MAX_STUDY_FILE_SIZE					0x4000000		// *[8] *[9] Larger study files are not read.
+
+
 extern CONFIGURATION				BViewerConfiguration;
 extern CCustomization				*pBViewerCustomization;
 extern CBViewerApp					ThisBViewerApp;
@@ -177,12 +202,14 @@ void CStudy::Initialize()
 	memset( &m_ReaderInfo, '\0', sizeof( READER_PERSONAL_INFO ) );
 	m_AccessionNumber[ 0 ] = '\0';		// *[1] Eliminated call to strcpy.
 	m_bStudyWasPreviouslyInterpreted = FALSE;
-	m_SDYFileVersion = 3;					// *[4]	Changed the m_SDYFileVersion from 2 to 3 due to READER_PERSONAL_INFO size change.
+	m_SDYFileVersion = SDY_FILE_VERSION_SECTIONED;		// *[4]	Changed the m_SDYFileVersion from 2 to 3 due to READER_PERSONAL_INFO size change.  *[8] Now 4.  *[9] Now 5.
 	m_pEventParameters = 0;
 	m_ReportPage1FilePath[ 0 ] = '\0';		// *[1] Eliminated call to strcpy.
 	m_ReportPage2FilePath[ 0 ] = '\0';		// *[1] Eliminated call to strcpy.
 	memset( &m_ClientInfo, '\0', sizeof( CLIENT_INFO ) );
 	memset( &BViewerConfiguration.m_ClientInfo, '\0', sizeof( CLIENT_INFO ) );
+	m_PatientKeyHash = 0;					// *[7]
+	m_pStudyList = 0;						// *[7]
 }
 
 
@@ -1667,12 +1694,36 @@ void CStudy::LoadImageData( char *pTitleRow, char *pDataRow, DIAGNOSTIC_SERIES *
 }
 
 
+// *[7] Return a hash of the fields that identify the patient for study merging.  The
+// patient index files each listed study under this hash.
+unsigned long CStudy::CalculatePatientKeyHash()
+{
+	char					*pKeyFields[ 4 ];
+	char					*pChar;
+	int						nField;
+	unsigned long			HashValue;
+
+	pKeyFields[ 0 ] = m_PatientLastName;
+	pKeyFields[ 1 ] = m_PatientFirstName;
+	pKeyFields[ 2 ] = m_AccessionNumber;
+	pKeyFields[ 3 ] = m_PatientID;
+	// Use the FNV-1a hash, with a field separator so that shifted field boundaries hash differently.
+	HashValue = 2166136261UL;
+	for ( nField = 0; nField < 4; nField++ )
+		{
+		for ( pChar = pKeyFields[ nField ]; *pChar != '\0'; pChar++ )
+			HashValue = ( HashValue ^ (unsigned char)*pChar ) * 16777619UL;
+		HashValue = ( HashValue ^ 0xFF ) * 16777619UL;
+		}
+
+	return HashValue;
+}
+
+
 BOOL CStudy::MergeWithExistingStudies( BOOL *pbNewStudyMergedWithExistingStudy )
 {
 	BOOL					bNoError = TRUE;
-	BOOL					bAvailableStudiesExamined;
 	CStudy					*pExistingStudy;
-	LIST_ELEMENT			*pStudyListElement;
 	BOOL					bMatchingPatientFound;
 	BOOL					bMatchingStudyFound;
 	BOOL					bMatchingSeriesFound;
@@ -1697,67 +1748,49 @@ BOOL CStudy::MergeWithExistingStudies( BOOL *pbNewStudyMergedWithExistingStudy )
 	// The new (current) study only includes a single study, series and image, since it was imported
 	// from a single Dicom image file:
 	// Check for a match with existing studies.
-	bAvailableStudiesExamined = FALSE;
-	pStudyListElement = ThisBViewerApp.m_NewlyArrivedStudyList;
-	while ( pStudyListElement != 0 && !bMatchingPatientFound )
+	pExistingStudy = ThisBViewerApp.FindStudyForPatient( this );								// *[7] Look up the patient in the index.
+	if ( pExistingStudy != 0 )
 		{
-		pExistingStudy = (CStudy*)pStudyListElement -> pItem;
-		if ( pExistingStudy != 0 &&
-				strcmp( pExistingStudy -> m_PatientLastName, m_PatientLastName ) == 0 &&
-				strcmp( pExistingStudy -> m_PatientFirstName, m_PatientFirstName ) == 0 &&
-				strcmp( pExistingStudy -> m_AccessionNumber, m_AccessionNumber ) == 0 &&
-				strcmp( pExistingStudy -> m_PatientID, m_PatientID ) == 0 )
-			{
-			bMatchingPatientFound = TRUE;
-			// A matching patient was found in the existing list.  See if this patient has a
-			// study that matches the new one.
-			pNewDiagnosticStudy = m_pDiagnosticStudyList;		// There is only one study in this list.
-			pExistingDiagnosticStudy = pExistingStudy -> m_pDiagnosticStudyList;
-			while ( pNewDiagnosticStudy != 0 && pExistingDiagnosticStudy != 0 && !bMatchingStudyFound )
-				{
-				if ( strcmp( pNewDiagnosticStudy -> StudyInstanceUID, pExistingDiagnosticStudy -> StudyInstanceUID ) == 0 )
+		bMatchingPatientFound = TRUE;
+		// A matching patient was found in the existing list.  See if this patient has a
+		// study that matches the new one.
+		pNewDiagnosticStudy = m_pDiagnosticStudyList;		// There is only one study in this list.
+		pExistingDiagnosticStudy = pExistingStudy -> m_pDiagnosticStudyList;
+		while ( pNewDiagnosticStudy != 0 && pExistingDiagnosticStudy != 0 && !bMatchingStudyFound )
+			{
+			if ( strcmp( pNewDiagnosticStudy -> StudyInstanceUID, pExistingDiagnosticStudy -> StudyInstanceUID ) == 0 )
+				{
+				bMatchingStudyFound = TRUE;
+				// A matching study was found in the existing list for this patient.  See if this study has a
+				// series that matches the new one.
+				pNewDiagnosticSeries = pNewDiagnosticStudy -> pDiagnosticSeriesList;	// There is only one series in this list.
+				pExistingDiagnosticSeries = pExistingDiagnosticStudy -> pDiagnosticSeriesList;
+				while ( pExistingDiagnosticSeries != 0 && !bMatchingSeriesFound )
 					{
-					bMatchingStudyFound = TRUE;
-					// A matching study was found in the existing list for this patient.  See if this study has a
-					// series that matches the new one.
-					pNewDiagnosticSeries = pNewDiagnosticStudy -> pDiagnosticSeriesList;	// There is only one series in this list.
-					pExistingDiagnosticSeries = pExistingDiagnosticStudy -> pDiagnosticSeriesList;
-					while ( pExistingDiagnosticSeries != 0 && !bMatchingSeriesFound )
+					if ( strcmp( pNewDiagnosticSeries -> SeriesInstanceUID, pExistingDiagnosticSeries -> SeriesInstanceUID ) == 0 )
 						{
-						if ( strcmp( pNewDiagnosticSeries -> SeriesInstanceUID, pExistingDiagnosticSeries -> SeriesInstanceUID ) == 0 )
+						bMatchingSeriesFound = TRUE;
+						// A matching series was found in the existing list for this study.  See if this series has an
+						// image that matches the new one.
+						pNewDiagnosticImage = pNewDiagnosticSeries -> pDiagnosticImageList;	// There is only one image in this list.
+						pExistingDiagnosticImage = pExistingDiagnosticSeries -> pDiagnosticImageList;
+						while ( pExistingDiagnosticImage != 0 && !bMatchingImageFound )
 							{
-							bMatchingSeriesFound = TRUE;
-							// A matching series was found in the existing list for this study.  See if this series has an
-							// image that matches the new one.
-							pNewDiagnosticImage = pNewDiagnosticSeries -> pDiagnosticImageList;	// There is only one image in this list.
-							pExistingDiagnosticImage = pExistingDiagnosticSeries -> pDiagnosticImageList;
-							while ( pExistingDiagnosticImage != 0 && !bMatchingImageFound )
+							if ( strcmp( pNewDiagnosticImage -> SOPInstanceUID, pExistingDiagnosticImage -> SOPInstanceUID ) == 0 )
 								{
-								if ( strcmp( pNewDiagnosticImage -> SOPInstanceUID, pExistingDiagnosticImage -> SOPInstanceUID ) == 0 )
-									{
-									// A matching image was found in the existing list for this series.
-									bMatchingImageFound = TRUE;
-									}
-								if ( !bMatchingImageFound )
-									pExistingDiagnosticImage = pExistingDiagnosticImage -> pNextDiagnosticImage;
+								// A matching image was found in the existing list for this series.
+								bMatchingImageFound = TRUE;
 								}
+							if ( !bMatchingImageFound )
+								pExistingDiagnosticImage = pExistingDiagnosticImage -> pNextDiagnosticImage;
 							}
-						if ( !bMatchingSeriesFound )
-							pExistingDiagnosticSeries = pExistingDiagnosticSeries -> pNextDiagnosticSeries;
 						}
+					if ( !bMatchingSeriesFound )
+						pExistingDiagnosticSeries = pExistingDiagnosticSeries -> pNextDiagnosticSeries;
 					}
-				if ( !bMatchingStudyFound )
-					pExistingDiagnosticStudy = pExistingDiagnosticStudy -> pNextDiagnosticStudy;
-				}
-			}
-		if ( !bMatchingPatientFound )
-			{
-			pStudyListElement = pStudyListElement -> pNextListElement;
-			if ( pStudyListElement == 0 && !bAvailableStudiesExamined )
-				{
-				pStudyListElement = ThisBViewerApp.m_AvailableStudyList;
-				bAvailableStudiesExamined = TRUE;
 				}
+			if ( !bMatchingStudyFound )
+				pExistingDiagnosticStudy = pExistingDiagnosticStudy -> pNextDiagnosticStudy;
 			}
 		}
 	if ( !bMatchingImageFound )			// If the new image isn't a duplicate...
@@ -1806,7 +1839,7 @@ BOOL CStudy::MergeWithExistingStudies( BOOL *pbNewStudyMergedWithExistingStudy )
 					}
 				else
 					{
-					RemoveFromList( &ThisBViewerApp.m_AvailableStudyList, (void*)pExistingStudy );
+					ThisBViewerApp.RemoveStudyFromList( pExistingStudy -> m_pStudyList, pExistingStudy );		// *[7]
 					delete pExistingStudy;
 					bMatchingPatientFound = FALSE;		// Allow the new patient to be added in place of the corrupt one.
 					}
@@ -1846,116 +1879,149 @@ void CStudy::GetDateOfRadiographMMDDYY( char *pDateString )
 }
 
 
-BOOL CStudy::SaveDiagnosticImage( FILE *pStudyFile, DIAGNOSTIC_IMAGE *pDiagnosticImage )
+// *[8] Gather the fixed-length study members into a study file record.
+void CStudy::CopyToStudyRecord( SDY_STUDY_RECORD *pStudyRecord )
 {
-	BOOL					bNoError = TRUE;
-	size_t					nBytesToWrite;
-	size_t					nBytesWritten;
-
-	nBytesToWrite = sizeof(DIAGNOSTIC_IMAGE);
-	nBytesWritten = fwrite( pDiagnosticImage, 1, nBytesToWrite, pStudyFile );
-	bNoError = ( nBytesWritten == nBytesToWrite );
-
-	return bNoError;
+	memset( pStudyRecord, '\0', sizeof(SDY_STUDY_RECORD) );
+	memcpy( pStudyRecord -> ReaderAddressed, m_ReaderAddressed, DICOM_ATTRIBUTE_STRING_LENGTH );
+	memcpy( pStudyRecord -> PatientLastName, m_PatientLastName, DICOM_ATTRIBUTE_STRING_LENGTH );
+	memcpy( pStudyRecord -> PatientFirstName, m_PatientFirstName, DICOM_ATTRIBUTE_STRING_LENGTH );
+	memcpy( pStudyRecord -> PatientID, m_PatientID, DICOM_ATTRIBUTE_STRING_LENGTH );
+	pStudyRecord -> PatientsBirthDate = m_PatientsBirthDate;
+	memcpy( pStudyRecord -> PatientsSex, m_PatientsSex, 4 );
+	memcpy( pStudyRecord -> PatientComments, m_PatientComments, DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
+	pStudyRecord -> Reserved = m_Reserved;
+	pStudyRecord -> GammaSetting = m_GammaSetting;
+	pStudyRecord -> WindowCenter = m_WindowCenter;
+	pStudyRecord -> WindowWidth = m_WindowWidth;
+	pStudyRecord -> MaxGrayscaleValue = m_MaxGrayscaleValue;
+	memcpy( pStudyRecord -> TimeStudyFirstOpened, m_TimeStudyFirstOpened, 32 );
+	memcpy( pStudyRecord -> TimeReportApproved, m_TimeReportApproved, 32 );
+	pStudyRecord -> nCurrentObjectID = m_nCurrentObjectID;
+	pStudyRecord -> bImageQualityVisited = m_bImageQualityVisited;
+	pStudyRecord -> bParenchymalAbnormalitiesVisited = m_bParenchymalAbnormalitiesVisited;
+	pStudyRecord -> bPleuralAbnormalitiesVisited = m_bPleuralAbnormalitiesVisited;
+	pStudyRecord -> bOtherAbnormalitiesVisited = m_bOtherAbnormalitiesVisited;
+	pStudyRecord -> AnyParenchymalAbnormalities = m_AnyParenchymalAbnormalities;
+	pStudyRecord -> AnyPleuralAbnormalities = m_AnyPleuralAbnormalities;
+	pStudyRecord -> AnyOtherAbnormalities = m_AnyOtherAbnormalities;
+	pStudyRecord -> ImageQuality = m_ImageQuality;
+	pStudyRecord -> ObservedParenchymalAbnormalities = m_ObservedParenchymalAbnormalities;
+	pStudyRecord -> ObservedPleuralPlaqueSites = m_ObservedPleuralPlaqueSites;
+	pStudyRecord -> ObservedPleuralCalcificationSites = m_ObservedPleuralCalcificationSites;
+	pStudyRecord -> ObservedPlaqueExtent = m_ObservedPlaqueExtent;
+	pStudyRecord -> ObservedPlaqueWidth = m_ObservedPlaqueWidth;
+	pStudyRecord -> ObservedCostophrenicAngleObliteration = m_ObservedCostophrenicAngleObliteration;
+	pStudyRecord -> ObservedPleuralThickeningSites = m_ObservedPleuralThickeningSites;
+	pStudyRecord -> ObservedThickeningCalcificationSites = m_ObservedThickeningCalcificationSites;
+	pStudyRecord -> ObservedThickeningExtent = m_ObservedThickeningExtent;
+	pStudyRecord -> ObservedThickeningWidth = m_ObservedThickeningWidth;
+	pStudyRecord -> ObservedOtherSymbols = m_ObservedOtherSymbols;
+	pStudyRecord -> ObservedOtherAbnormalities = m_ObservedOtherAbnormalities;
+	pStudyRecord -> PhysicianNotificationStatus = m_PhysicianNotificationStatus;
+	pStudyRecord -> Reserved2 = m_Reserved2;
+	pStudyRecord -> DateOfRadiograph = m_DateOfRadiograph;
+	memcpy( pStudyRecord -> Reserved1, m_Reserved1, 12 );
+	pStudyRecord -> TypeOfReading = m_TypeOfReading;
+	memcpy( pStudyRecord -> OtherTypeOfReading, m_OtherTypeOfReading, DICOM_ATTRIBUTE_STRING_LENGTH );
+	memcpy( pStudyRecord -> FacilityIDNumber, m_FacilityIDNumber, 10 );
+	pStudyRecord -> DateOfReading = m_DateOfReading;
+	pStudyRecord -> bReportViewed = m_bReportViewed;
+	pStudyRecord -> bReportApproved = m_bReportApproved;
+	pStudyRecord -> bStudyWasPreviouslyInterpreted = m_bStudyWasPreviouslyInterpreted;
 }
 
 
-BOOL CStudy::SaveDiagnosticSeries( FILE *pStudyFile, DIAGNOSTIC_SERIES *pDiagnosticSeries )
+// *[8] Load the fixed-length study members from a study file record.  The character arrays
+// are terminated, in case the file has been damaged.
+void CStudy::CopyFromStudyRecord( SDY_STUDY_RECORD *pStudyRecord )
 {
-	BOOL					bNoError = TRUE;
-	size_t					nBytesToWrite;
-	size_t					nBytesWritten;
-	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
-	unsigned long			nImages;
-	unsigned long			LengthInBytes;
+	strncpy_s( m_ReaderAddressed, DICOM_ATTRIBUTE_STRING_LENGTH, pStudyRecord -> ReaderAddressed, _TRUNCATE );
+	strncpy_s( m_PatientLastName, DICOM_ATTRIBUTE_STRING_LENGTH, pStudyRecord -> PatientLastName, _TRUNCATE );
+	strncpy_s( m_PatientFirstName, DICOM_ATTRIBUTE_STRING_LENGTH, pStudyRecord -> PatientFirstName, _TRUNCATE );
+	strncpy_s( m_PatientID, DICOM_ATTRIBUTE_STRING_LENGTH, pStudyRecord -> PatientID, _TRUNCATE );
+	m_PatientsBirthDate = pStudyRecord -> PatientsBirthDate;
+	strncpy_s( m_PatientsSex, 4, pStudyRecord -> PatientsSex, _TRUNCATE );
+	strncpy_s( m_PatientComments, DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH, pStudyRecord -> PatientComments, _TRUNCATE );
+	m_Reserved = pStudyRecord -> Reserved;
+	m_GammaSetting = pStudyRecord -> GammaSetting;
+	m_WindowCenter = pStudyRecord -> WindowCenter;
+	m_WindowWidth = pStudyRecord -> WindowWidth;
+	m_MaxGrayscaleValue = pStudyRecord -> MaxGrayscaleValue;
+	strncpy_s( m_TimeStudyFirstOpened, 32, pStudyRecord -> TimeStudyFirstOpened, _TRUNCATE );
+	strncpy_s( m_TimeReportApproved, 32, pStudyRecord -> TimeReportApproved, _TRUNCATE );
+	m_nCurrentObjectID = pStudyRecord -> nCurrentObjectID;
+	m_bImageQualityVisited = pStudyRecord -> bImageQualityVisited;
+	m_bParenchymalAbnormalitiesVisited = pStudyRecord -> bParenchymalAbnormalitiesVisited;
+	m_bPleuralAbnormalitiesVisited = pStudyRecord -> bPleuralAbnormalitiesVisited;
+	m_bOtherAbnormalitiesVisited = pStudyRecord -> bOtherAbnormalitiesVisited;
+	m_AnyParenchymalAbnormalities = pStudyRecord -> AnyParenchymalAbnormalities;
+	m_AnyPleuralAbnormalities = pStudyRecord -> AnyPleuralAbnormalities;
+	m_AnyOtherAbnormalities = pStudyRecord -> AnyOtherAbnormalities;
+	m_ImageQuality = pStudyRecord -> ImageQuality;
+	m_ObservedParenchymalAbnormalities = pStudyRecord -> ObservedParenchymalAbnormalities;
+	m_ObservedPleuralPlaqueSites = pStudyRecord -> ObservedPleuralPlaqueSites;
+	m_ObservedPleuralCalcificationSites = pStudyRecord -> ObservedPleuralCalcificationSites;
+	m_ObservedPlaqueExtent = pStudyRecord -> ObservedPlaqueExtent;
+	m_ObservedPlaqueWidth = pStudyRecord -> ObservedPlaqueWidth;
+	m_ObservedCostophrenicAngleObliteration = pStudyRecord -> ObservedCostophrenicAngleObliteration;
+	m_ObservedPleuralThickeningSites = pStudyRecord -> ObservedPleuralThickeningSites;
+	m_ObservedThickeningCalcificationSites = pStudyRecord -> ObservedThickeningCalcificationSites;
+	m_ObservedThickeningExtent = pStudyRecord -> ObservedThickeningExtent;
+	m_ObservedThickeningWidth = pStudyRecord -> ObservedThickeningWidth;
+	m_ObservedOtherSymbols = pStudyRecord -> ObservedOtherSymbols;
+	m_ObservedOtherAbnormalities = pStudyRecord -> ObservedOtherAbnormalities;
+	m_PhysicianNotificationStatus = pStudyRecord -> PhysicianNotificationStatus;
+	m_Reserved2 = pStudyRecord -> Reserved2;
+	m_DateOfRadiograph = pStudyRecord -> DateOfRadiograph;
+	strncpy_s( m_Reserved1, 12, pStudyRecord -> Reserved1, _TRUNCATE );
+	m_TypeOfReading = pStudyRecord -> TypeOfReading;
+	strncpy_s( m_OtherTypeOfReading, DICOM_ATTRIBUTE_STRING_LENGTH, pStudyRecord -> OtherTypeOfReading, _TRUNCATE );
+	strncpy_s( m_FacilityIDNumber, 10, pStudyRecord -> FacilityIDNumber, _TRUNCATE );
+	m_DateOfReading = pStudyRecord -> DateOfReading;
+	m_bReportViewed = pStudyRecord -> bReportViewed;
+	m_bReportApproved = pStudyRecord -> bReportApproved;
+	m_bStudyWasPreviouslyInterpreted = pStudyRecord -> bStudyWasPreviouslyInterpreted;
+}
 
-	nBytesToWrite = sizeof(DIAGNOSTIC_SERIES);
-	nBytesWritten = fwrite( pDiagnosticSeries, 1, nBytesToWrite, pStudyFile );
-	bNoError = ( nBytesWritten == nBytesToWrite );
-	if ( bNoError )
-		{
-		// Record the number of images for the current study.
-		pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
-		nImages = 0;
-		while ( pDiagnosticImage != 0 )
-			{
-			nImages++;
-			pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
-			}
-		nBytesToWrite = sizeof(unsigned long);
-		nBytesWritten = fwrite( &nImages, 1, nBytesToWrite, pStudyFile );
-		bNoError = ( nBytesWritten == nBytesToWrite );
-		if ( bNoError )
-			{
-			// Record the length of the image structure.
-			nBytesToWrite = sizeof(unsigned long);
-			LengthInBytes = sizeof(DIAGNOSTIC_IMAGE);
-			nBytesWritten = fwrite( &LengthInBytes, 1, nBytesToWrite, pStudyFile );
-			bNoError = ( nBytesWritten == nBytesToWrite );
-			}
-		if ( bNoError )
-			{
-			// Record the list of images for the current study.
-			pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
-			nImages = 0;
-			while ( bNoError && pDiagnosticImage != 0 )
-				{
-				bNoError = SaveDiagnosticImage( pStudyFile, pDiagnosticImage );
-				pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
-				}
-			}
-		}
 
-	return bNoError;
+// *[9] Gather everything recorded in the study file.  The texts and the diagnostic study list
+// are referred to, not copied.
+void CStudy::CopyToStudyFileContents( STUDY_FILE_CONTENTS *pStudyFileContents )
+{
+	memset( pStudyFileContents, '\0', sizeof(STUDY_FILE_CONTENTS) );
+	pStudyFileContents -> FileVersion = m_SDYFileVersion;
+	CopyToStudyRecord( &pStudyFileContents -> StudyRecord );
+	pStudyFileContents -> pImageDefectOtherText = (char*)(const char*)m_ImageDefectOtherText;
+	pStudyFileContents -> pOtherAbnormalitiesCommentsText = (char*)(const char*)m_OtherAbnormalitiesCommentsText;
+	pStudyFileContents -> pDiagnosticStudyList = m_pDiagnosticStudyList;
+	memcpy( &pStudyFileContents -> ReaderInfo, &m_ReaderInfo, sizeof(READER_PERSONAL_INFO) );
+	memcpy( &pStudyFileContents -> ClientInfo, &m_ClientInfo, sizeof(CLIENT_INFO) );
 }
 
 
-BOOL CStudy::SaveDiagnosticStudy( FILE *pStudyFile, DIAGNOSTIC_STUDY *pDiagnosticStudy )
+// *[9] Load the study from the contents restored from its study file.  The restored diagnostic
+// study list is taken over by the study.
+void CStudy::CopyFromStudyFileContents( STUDY_FILE_CONTENTS *pStudyFileContents )
 {
-	BOOL					bNoError = TRUE;
-	size_t					nBytesToWrite;
-	size_t					nBytesWritten;
-	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
-	unsigned long			nSeries;
-	unsigned long			LengthInBytes;
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
 
-	nBytesToWrite = sizeof(DIAGNOSTIC_STUDY);
-	nBytesWritten = fwrite( pDiagnosticStudy, 1, nBytesToWrite, pStudyFile );
-	bNoError = ( nBytesWritten == nBytesToWrite );
-	if ( bNoError )
+	CopyFromStudyRecord( &pStudyFileContents -> StudyRecord );
+	if ( pStudyFileContents -> pImageDefectOtherText != 0 )
+		m_ImageDefectOtherText = pStudyFileContents -> pImageDefectOtherText;
+	if ( pStudyFileContents -> pOtherAbnormalitiesCommentsText != 0 )
+		m_OtherAbnormalitiesCommentsText = pStudyFileContents -> pOtherAbnormalitiesCommentsText;
+	m_pDiagnosticStudyList = pStudyFileContents -> pDiagnosticStudyList;
+	pStudyFileContents -> pDiagnosticStudyList = 0;
+	pDiagnosticStudy = m_pDiagnosticStudyList;
+	while ( pDiagnosticStudy != 0 )
 		{
-		// Record the number of series for the current study.
-		pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList;
-		nSeries = 0;
-		while ( pDiagnosticSeries != 0 )
-			{
-			nSeries++;
-			pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
-			}
-		nBytesToWrite = sizeof(unsigned long);
-		nBytesWritten = fwrite( &nSeries, 1, nBytesToWrite, pStudyFile );
-		bNoError = ( nBytesWritten == nBytesToWrite );
-		if ( bNoError )
-			{
-			// Record the length of the series structure.
-			nBytesToWrite = sizeof(unsigned long);
-			LengthInBytes = sizeof(DIAGNOSTIC_SERIES);
-			nBytesWritten = fwrite( &LengthInBytes, 1, nBytesToWrite, pStudyFile );
-			bNoError = ( nBytesWritten == nBytesToWrite );
-			}
-		if ( bNoError )
-			{
-			// Record the list of series for the current study.
-			pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList;
-			while ( bNoError && pDiagnosticSeries != 0 )
-				{
-				bNoError = SaveDiagnosticSeries( pStudyFile, pDiagnosticSeries );
-				pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
-				}
-			}
+		strncpy_s( m_AccessionNumber, DICOM_ATTRIBUTE_STRING_LENGTH, pDiagnosticStudy -> AccessionNumber, _TRUNCATE );
+		pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
 		}
-
-	return bNoError;
+	memcpy( &m_ReaderInfo, &pStudyFileContents -> ReaderInfo, sizeof(READER_PERSONAL_INFO) );
+	memcpy( &m_ClientInfo, &pStudyFileContents -> ClientInfo, sizeof(CLIENT_INFO) );
+	m_SDYFileVersion = pStudyFileContents -> FileVersion;
 }
 
 
@@ -1968,7 +2034,10 @@ void CStudy::GetStudyFileName( char *pStudyFileName, size_t BufferSize )
 	strncat_s( pStudyFileName, BufferSize, m_PatientID, _TRUNCATE );																	// *[3] Replaced strcat with strncat_s.
 	strncat_s( pStudyFileName, BufferSize, "_", _TRUNCATE );																			// *[3] Replaced strcat with strncat_s.
 	if ( strlen( m_AccessionNumber ) == 0 )
+		{
 		strncpy_s( m_AccessionNumber, DICOM_ATTRIBUTE_STRING_LENGTH, this -> m_pDiagnosticStudyList -> AccessionNumber, _TRUNCATE );	// *[5] Replaced strcat with strncpy_s.
+		ThisBViewerApp.UpdatePatientIndex( this );																						// *[7]
+		}
 	strncat_s( pStudyFileName, BufferSize, m_AccessionNumber, _TRUNCATE );																// *[3] Replaced strcat with strncat_s.
 	strncat_s( pStudyFileName, BufferSize, ".sdy", _TRUNCATE );																			// *[3] Replaced strcat with strncat_s.
 }
@@ -1984,9 +2053,9 @@ BOOL CStudy::Save()
 	size_t				nBytesToWrite;
 	size_t				nBytesWritten;
 	size_t				nRemainingCharacters;
-	unsigned long		LengthInBytes;
-	DIAGNOSTIC_STUDY	*pDiagnosticStudy;
-	unsigned long		nStudies;
+	char				*pFileImage;				// *[8]
+	STUDY_FILE_CONTENTS	StudyFileContents;			// *[9]
+	unsigned long		FileVersion;				// *[9]
 	char				Msg[ FULL_FILE_SPEC_STRING_LENGTH ];
 
 	strncpy_s( DataDirectory, FILE_PATH_STRING_LENGTH, BViewerConfiguration.DataDirectory, _TRUNCATE );			// *[2] Replaced strncat with strncpy_s.
@@ -2003,986 +2072,98 @@ BOOL CStudy::Save()
 		GetStudyFileName( &FileSpec[ strlen( FileSpec ) ], nRemainingCharacters );
 		_snprintf_s( Msg, FULL_FILE_SPEC_STRING_LENGTH, _TRUNCATE, "Saving study data to file %s.", FileSpec );	// *[2] Replaced sprintf() with _snprintf_s.
 		LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
-		pStudyFile = fopen( FileSpec, "wb" );
-		if ( pStudyFile != 0 )
+		// *[8] Compose the entire file in memory, so that it is written in one operation.  *[9] The
+		// earlier field-by-field layout is composed instead while earlier BViewer versions are to
+		// read the study files.
+		CopyToStudyFileContents( &StudyFileContents );
+		if ( BViewerConfiguration.bWriteLegacySDYFiles )
 			{
-			nBytesToWrite = DICOM_ATTRIBUTE_STRING_LENGTH;
-
-			nBytesWritten = fwrite( m_ReaderAddressed, 1, nBytesToWrite, pStudyFile );
-			bNoError = ( nBytesWritten == nBytesToWrite );
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( m_PatientLastName, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( m_PatientFirstName, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( m_PatientID, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(EDITED_DATE);
-				nBytesWritten = fwrite( &m_PatientsBirthDate, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = 4;
-				nBytesWritten = fwrite( m_PatientsSex, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH;
-				nBytesWritten = fwrite( m_PatientComments, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(double);
-				nBytesWritten = fwrite( &m_Reserved, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_Reserved, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_GammaSetting, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_WindowCenter, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_WindowWidth, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_MaxGrayscaleValue, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = 32;
-				nBytesWritten = fwrite( m_TimeStudyFirstOpened, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( m_TimeReportApproved, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(UINT);
-				nBytesWritten = fwrite( &m_nCurrentObjectID, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(BOOL);
-				nBytesWritten = fwrite( &m_bImageQualityVisited, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_bParenchymalAbnormalitiesVisited, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_bPleuralAbnormalitiesVisited, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_bOtherAbnormalitiesVisited, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(char);
-				nBytesWritten = fwrite( &m_AnyParenchymalAbnormalities, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_AnyPleuralAbnormalities, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_AnyOtherAbnormalities, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(unsigned long);
-				nBytesWritten = fwrite( &m_ImageQuality, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedParenchymalAbnormalities, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(unsigned short);
-				nBytesWritten = fwrite( &m_ObservedPleuralPlaqueSites, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedPleuralCalcificationSites, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedPlaqueExtent, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedPlaqueWidth, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedCostophrenicAngleObliteration, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedPleuralThickeningSites, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedThickeningCalcificationSites, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedThickeningExtent, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedThickeningWidth, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(unsigned long);
-				nBytesWritten = fwrite( &m_ObservedOtherSymbols, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesWritten = fwrite( &m_ObservedOtherAbnormalities, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(unsigned long);
-				LengthInBytes = m_ImageDefectOtherText.GetLength();
-				nBytesWritten = fwrite( &LengthInBytes, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				if ( bNoError )
-					{
-					nBytesToWrite = LengthInBytes;
-					nBytesWritten = fwrite( (const char*)m_ImageDefectOtherText, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
-				}
-			if ( bNoError )
+			pFileImage = ComposeLegacyStudyFileImage( &StudyFileContents, &nBytesToWrite );
+			FileVersion = SDY_FILE_VERSION_LEGACY;
+			}
+		else
+			{
+			pFileImage = ComposeStudyFileImage( &StudyFileContents, &nBytesToWrite );
+			FileVersion = SDY_FILE_VERSION_SECTIONED;
+			}
+		bNoError = ( pFileImage != 0 );
+		if ( bNoError )
+			{
+			pStudyFile = fopen( FileSpec, "wb" );
+			if ( pStudyFile != 0 )
 				{
-				nBytesToWrite = sizeof(unsigned long);
-				LengthInBytes = m_OtherAbnormalitiesCommentsText.GetLength();
-				nBytesWritten = fwrite( &LengthInBytes, 1, nBytesToWrite, pStudyFile );
+				nBytesWritten = fwrite( pFileImage, 1, nBytesToWrite, pStudyFile );
 				bNoError = ( nBytesWritten == nBytesToWrite );
+				fclose( pStudyFile );
 				if ( bNoError )
-					{
-					nBytesToWrite = LengthInBytes;
-					nBytesWritten = fwrite( (const char*)m_OtherAbnormalitiesCommentsText, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
+					m_SDYFileVersion = FileVersion;
 				}
+			else
+				bNoError = FALSE;
+			free( pFileImage );
+			}
+		}
+	bFileWrittenSuccessfully = bNoError;
+	
+	return bFileWrittenSuccessfully;
+}
+
+
+// *[8] Read the entire study file in one operation.  *[9] A sectioned file is restored by
+// RestoreStudyFileImage(), and a file in the earlier layout by RestoreLegacyStudyFileImage().
+BOOL CStudy::Restore( char *pFullFilePath )
+{
+	BOOL					bNoError = TRUE;
+	FILE					*pStudyFile;
+	struct __stat64			FileStatisticsBuffer;
+	char					*pFileImage = 0;
+	size_t					FileLength = 0;
+	size_t					nBytesRead;
+	STUDY_FILE_CONTENTS		StudyFileContents;
+	char					Msg[ FULL_FILE_SPEC_STRING_LENGTH ];
+
+	pStudyFile = fopen( pFullFilePath, "rb" );
+	bNoError = ( pStudyFile != 0 );
+	if ( bNoError )
+		{
+		bNoError = ( _fstat64( _fileno( pStudyFile ), &FileStatisticsBuffer ) == 0 &&
+					FileStatisticsBuffer.st_size > 0 && FileStatisticsBuffer.st_size <= MAX_STUDY_FILE_SIZE );
+		if ( bNoError )
+			{
+			FileLength = (size_t)FileStatisticsBuffer.st_size;
+			pFileImage = (char*)malloc( FileLength );
+			bNoError = ( pFileImage != 0 );
+			}
+		if ( bNoError )
+			{
+			nBytesRead = fread_s( pFileImage, FileLength, 1, FileLength, pStudyFile );
+			bNoError = ( nBytesRead == FileLength );
+			}
+		fclose( pStudyFile );
+		if ( bNoError )
+			{
+			if ( FileLength >= sizeof(SDY_FILE_SIGNATURE) && memcmp( pFileImage, SDY_FILE_SIGNATURE, sizeof(SDY_FILE_SIGNATURE) ) == 0 )
+				bNoError = RestoreStudyFileImage( pFileImage, FileLength, &StudyFileContents );
+			else
+				bNoError = RestoreLegacyStudyFileImage( pFileImage, FileLength, &StudyFileContents );
 			if ( bNoError )
 				{
-				nBytesToWrite = sizeof(unsigned long);
-				nBytesWritten = fwrite( &m_PhysicianNotificationStatus, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
+				CopyFromStudyFileContents( &StudyFileContents );
+				DeallocateStudyFileContents( &StudyFileContents );
 				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(EDITED_DATE);
-				nBytesWritten = fwrite( &m_Reserved2, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(EDITED_DATE);
-				nBytesWritten = fwrite( &m_DateOfRadiograph, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(unsigned long);
-				LengthInBytes = sizeof( m_Reserved1 );
-				nBytesWritten = fwrite( &LengthInBytes, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				if ( bNoError )
-					{
-					nBytesToWrite = LengthInBytes;
-					nBytesWritten = fwrite( m_Reserved1, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(unsigned short);
-				nBytesWritten = fwrite( &m_TypeOfReading, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(unsigned long);
-				LengthInBytes = sizeof( m_OtherTypeOfReading );
-				nBytesWritten = fwrite( &LengthInBytes, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				if ( bNoError )
-					{
-					nBytesToWrite = LengthInBytes;
-					nBytesWritten = fwrite( m_OtherTypeOfReading, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(unsigned long);
-				LengthInBytes = sizeof( m_FacilityIDNumber );
-				nBytesWritten = fwrite( &LengthInBytes, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				if ( bNoError )
-					{
-					nBytesToWrite = LengthInBytes;
-					nBytesWritten = fwrite( m_FacilityIDNumber, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(EDITED_DATE);
-				nBytesWritten = fwrite( &m_DateOfReading, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(BOOL);
-				nBytesWritten = fwrite( &m_bReportViewed, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof(BOOL);
-				nBytesWritten = fwrite( &m_bReportApproved, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				}
-
-			if ( bNoError )
-				{
-				// Record the number of studies for the current patient.
-				pDiagnosticStudy = m_pDiagnosticStudyList;
-				nStudies = 0;
-				while (pDiagnosticStudy != 0 )
-					{
-					nStudies++;
-					pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
-					}
-				nBytesToWrite = sizeof(unsigned long);
-				nBytesWritten = fwrite( &nStudies, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				if ( bNoError )
-					{
-					// Record the length of the study structure.
-					nBytesToWrite = sizeof(unsigned long);
-					LengthInBytes = sizeof(DIAGNOSTIC_STUDY);
-					nBytesWritten = fwrite( &LengthInBytes, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
-				if ( bNoError )
-					{
-					// Record the list of studies for the current patient.
-					pDiagnosticStudy = m_pDiagnosticStudyList;
-					while ( bNoError && pDiagnosticStudy != 0 )
-						{
-						bNoError = SaveDiagnosticStudy( pStudyFile, pDiagnosticStudy );
-						pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
-						}
-					}
-				}
-			if ( bNoError )
-				{
-				nBytesToWrite = sizeof( m_SDYFileVersion );
-				nBytesWritten = fwrite( &m_SDYFileVersion, 1, nBytesToWrite, pStudyFile );
-				bNoError = ( nBytesWritten == nBytesToWrite );
-				if ( bNoError )
-					{
-					nBytesToWrite = sizeof( READER_PERSONAL_INFO );
-					nBytesWritten = fwrite( &m_ReaderInfo, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
-				if ( bNoError )
-					{
-					nBytesToWrite = sizeof( BOOL );
-					nBytesWritten = fwrite( &m_bStudyWasPreviouslyInterpreted, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
-				if ( bNoError )
-					{
-					nBytesToWrite = sizeof( CLIENT_INFO );
-					nBytesWritten = fwrite( &m_ClientInfo, 1, nBytesToWrite, pStudyFile );
-					bNoError = ( nBytesWritten == nBytesToWrite );
-					}
-				}
-			fclose( pStudyFile );
-			}
-		else
-			bNoError = FALSE;
-		}
-	bFileWrittenSuccessfully = bNoError;
-	
-	return bFileWrittenSuccessfully;
-}
-
-
-BOOL CStudy::RestoreDiagnosticImage( FILE *pStudyFile, DIAGNOSTIC_IMAGE **ppDiagnosticImage )
-{
-	BOOL					bNoError = TRUE;
-	size_t					nBytesToRead;
-	size_t					nBytesRead;
-	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
-
-	nBytesToRead = sizeof(DIAGNOSTIC_IMAGE);
-	pDiagnosticImage = ( DIAGNOSTIC_IMAGE* )malloc( sizeof(DIAGNOSTIC_IMAGE) );
-	bNoError = ( pDiagnosticImage != 0 );
-	if ( bNoError )
-		{
-		nBytesRead = fread_s( pDiagnosticImage, sizeof(DIAGNOSTIC_IMAGE), 1, nBytesToRead, pStudyFile );		// *[2] Converted from fread to fread_s.
-		bNoError = ( nBytesRead == nBytesToRead );
-		pDiagnosticImage -> pNextDiagnosticImage = 0;
-		}
-	if ( bNoError )
-		*ppDiagnosticImage = pDiagnosticImage;
-	else
-		{
-		*ppDiagnosticImage = 0;
-		if ( pDiagnosticImage != 0 )			// *[1] Prevent memory leak ater bad file read.
-			free( pDiagnosticImage );			// *[1]
-		}
-
-	return bNoError;
-}
-
-
-BOOL CStudy::RestoreDiagnosticSeries( FILE *pStudyFile, DIAGNOSTIC_SERIES **ppDiagnosticSeries, BOOL bOlderSeriesWithoutManufacturer )
-{
-	BOOL					bNoError = TRUE;
-	size_t					nBytesToRead;
-	size_t					nBytesRead;
-	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
-	DIAGNOSTIC_IMAGE		**ppDiagnosticImage;
-	unsigned long			nImageCount;
-	unsigned long			nImage;
-	unsigned long			LengthInBytes;
-
-	nBytesToRead = sizeof(DIAGNOSTIC_SERIES);
-	if ( bOlderSeriesWithoutManufacturer )
-		nBytesToRead -= DICOM_ATTRIBUTE_UI_STRING_LENGTH;
-	pDiagnosticSeries = (DIAGNOSTIC_SERIES*)malloc( sizeof(DIAGNOSTIC_SERIES) );
-	bNoError = ( pDiagnosticSeries != 0 );
-	if ( bNoError )
-		{
-		nBytesRead = fread_s( pDiagnosticSeries, sizeof(DIAGNOSTIC_SERIES), 1, nBytesToRead, pStudyFile );		// *[2] Converted from fread to fread_s.
-		bNoError = ( nBytesRead == nBytesToRead );
-		pDiagnosticSeries -> pNextDiagnosticSeries = 0;
-		if ( bOlderSeriesWithoutManufacturer )
-			pDiagnosticSeries -> Manufacturer[ 0 ] = '\0';		// *[1] Eliminated call to strcpy.
-		}
-	if ( bNoError )
-		{
-		// Read the number of images for the current study.
-		nBytesToRead = sizeof(unsigned long);
-		nBytesRead = fread_s( &nImageCount, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-		bNoError = ( nBytesRead == nBytesToRead );
-		}
-	if ( bNoError )
-		{
-		// Read the length of the image structure.
-		nBytesToRead = sizeof(unsigned long);
-		nBytesRead = fread_s( &LengthInBytes, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-		bNoError = ( nBytesRead == nBytesToRead );
-		if ( bNoError )
-			if ( LengthInBytes != sizeof(DIAGNOSTIC_IMAGE) )
-				bNoError = FALSE;
-		}
-	if ( bNoError )
-		{
-		// Read the list of images for the current study.
-		ppDiagnosticImage = &pDiagnosticSeries -> pDiagnosticImageList;
-		for ( nImage = 0; nImage < nImageCount; nImage++ )
-			{
-			bNoError = RestoreDiagnosticImage( pStudyFile, ppDiagnosticImage );
-			ppDiagnosticImage = &( *ppDiagnosticImage ) -> pNextDiagnosticImage;
-			}
-		}
-	if ( bNoError )
-		*ppDiagnosticSeries = pDiagnosticSeries;
-	else
-		{
-		*ppDiagnosticSeries = 0;
-		if ( pDiagnosticSeries != 0 )			// *[1] Fixed potential memory leak.
-			free( pDiagnosticSeries );			// *[1]
-		}
-
-	return bNoError;
-}
-
-
-BOOL CStudy::RestoreDiagnosticStudy( FILE *pStudyFile, DIAGNOSTIC_STUDY **ppDiagnosticStudy )
-{
-	BOOL					bNoError = TRUE;
-	BOOL					bOlderSeriesWithoutManufacturer;
-	size_t					nBytesToRead;
-	size_t					nBytesRead;
-	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
-	DIAGNOSTIC_SERIES		**ppDiagnosticSeries;
-	unsigned long			nSeriesCount;
-	unsigned long			nSeries;
-	unsigned long			LengthInBytes;
-
-	bOlderSeriesWithoutManufacturer = FALSE;
-	nBytesToRead = sizeof(DIAGNOSTIC_STUDY);
-	pDiagnosticStudy = (DIAGNOSTIC_STUDY*)malloc( sizeof(DIAGNOSTIC_STUDY) );
-	bNoError = ( pDiagnosticStudy != 0 );
-	if ( bNoError )
-		{
-		nBytesRead = fread_s( pDiagnosticStudy, sizeof(DIAGNOSTIC_STUDY), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-		bNoError = ( nBytesRead == nBytesToRead );
-		pDiagnosticStudy -> pNextDiagnosticStudy = 0;
-		}
-	if ( bNoError )
-		strncpy_s( m_AccessionNumber, DICOM_ATTRIBUTE_STRING_LENGTH, pDiagnosticStudy -> AccessionNumber, _TRUNCATE );	// *[2] Replaced strncat with strncpy_s.
-	if ( bNoError )
-		{
-		// Read the number of series recorded for this study.
-		nBytesToRead = sizeof(unsigned long);
-		nBytesRead = fread_s( &nSeriesCount, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );						// *[2] Converted from fread to fread_s.
-		bNoError = ( nBytesRead == nBytesToRead );
-		}
-	if ( bNoError )
-		{
-		// Read the length of the series structure.
-		nBytesToRead = sizeof(unsigned long);
-		nBytesRead = fread_s( &LengthInBytes, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );					// *[2] Converted from fread to fread_s.
-		bNoError = ( nBytesRead == nBytesToRead );
-		if ( bNoError )
-			if ( LengthInBytes != sizeof(DIAGNOSTIC_SERIES) )
-				{
-				if ( LengthInBytes == sizeof(DIAGNOSTIC_SERIES) - DICOM_ATTRIBUTE_UI_STRING_LENGTH )
-					bOlderSeriesWithoutManufacturer = TRUE;
-				else
-					bNoError = FALSE;
-				}
-		}
-	if ( bNoError )
-		{
-		// Read the list of series for the current study.
-		ppDiagnosticSeries = &pDiagnosticStudy -> pDiagnosticSeriesList;
-		for ( nSeries = 0; nSeries < nSeriesCount; nSeries++ )
-			{
-			bNoError = RestoreDiagnosticSeries( pStudyFile, ppDiagnosticSeries, bOlderSeriesWithoutManufacturer );
-			ppDiagnosticSeries = &( *ppDiagnosticSeries ) -> pNextDiagnosticSeries;
-			}
-		}
-	if ( bNoError )
-		*ppDiagnosticStudy = pDiagnosticStudy;
-	else
-		{
-		*ppDiagnosticStudy = 0;
-		if  ( pDiagnosticStudy != 0 )
-			free( pDiagnosticStudy );
-		}
-
-	return bNoError;
-}
-
-
-BOOL CStudy::Restore( char *pFullFilePath )
-{
-	BOOL				bNoError = TRUE;
-	BOOL				bFileReadSuccessfully;
-	FILE				*pStudyFile;
-	size_t				nBytesToRead;
-	size_t				nBytesRead;
-	size_t				nBytesInEarlierBViewerVersions;
-	unsigned long		LengthInBytes;
-	size_t				StringLength;
-	DIAGNOSTIC_STUDY	**ppDiagnosticStudy;
-	unsigned long		nStudyCount;
-	unsigned long		nStudy;
-	char				*pTextBuffer = 0;	// *[2] Added redundant initialization to please Fortify.
-	char				Msg[ FULL_FILE_SPEC_STRING_LENGTH ];
-
-	pStudyFile = fopen( pFullFilePath, "rb" );
-	if ( pStudyFile != 0 )
-		{
-		nBytesToRead = DICOM_ATTRIBUTE_STRING_LENGTH;
-		nBytesRead = fread_s( m_ReaderAddressed, DICOM_ATTRIBUTE_STRING_LENGTH, 1, nBytesToRead, pStudyFile );					// *[2] Converted from fread to fread_s.
-		bNoError = ( nBytesRead == nBytesToRead );
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( m_PatientLastName, DICOM_ATTRIBUTE_UI_STRING_LENGTH, 1, nBytesToRead, pStudyFile );			// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( m_PatientFirstName, DICOM_ATTRIBUTE_UI_STRING_LENGTH, 1, nBytesToRead, pStudyFile );			// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( m_PatientID, DICOM_ATTRIBUTE_UI_STRING_LENGTH, 1, nBytesToRead, pStudyFile );					// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(EDITED_DATE);
-			nBytesRead = fread_s( &m_PatientsBirthDate, sizeof(EDITED_DATE), 1, nBytesToRead, pStudyFile );						// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = 4;
-			nBytesRead = fread_s( m_PatientsSex, 4, 1, nBytesToRead, pStudyFile );												// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH;
-			nBytesRead = fread_s( m_PatientComments, DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH, 1, nBytesToRead, pStudyFile );	// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(double);
-			nBytesRead = fread_s( &m_Reserved, sizeof(double), 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_Reserved, sizeof(double), 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_GammaSetting, sizeof(double), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_WindowCenter, sizeof(double), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_WindowWidth, sizeof(double), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_MaxGrayscaleValue, sizeof(double), 1, nBytesToRead, pStudyFile );							// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = 32;
-			nBytesRead = fread_s( m_TimeStudyFirstOpened, 32, 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( m_TimeReportApproved, 32, 1, nBytesToRead, pStudyFile );										// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
 			}
-		if ( bNoError )
+		if ( !bNoError )
 			{
-			nBytesToRead = sizeof(UINT);
-			nBytesRead = fread_s( &m_nCurrentObjectID, sizeof(UINT), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
+			_snprintf_s( Msg, FULL_FILE_SPEC_STRING_LENGTH, _TRUNCATE, "Unable to restore study file %s", pFullFilePath );
+			LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
 			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(BOOL);
-			nBytesRead = fread_s( &m_bImageQualityVisited, sizeof(BOOL), 1, nBytesToRead, pStudyFile );							// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_bParenchymalAbnormalitiesVisited, sizeof(BOOL), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_bPleuralAbnormalitiesVisited, sizeof(BOOL), 1, nBytesToRead, pStudyFile );					// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_bOtherAbnormalitiesVisited, sizeof(BOOL), 1, nBytesToRead, pStudyFile );					// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(char);
-			nBytesRead = fread_s( &m_AnyParenchymalAbnormalities, sizeof(char), 1, nBytesToRead, pStudyFile );					// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_AnyPleuralAbnormalities, sizeof(char), 1, nBytesToRead, pStudyFile );						// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_AnyOtherAbnormalities, sizeof(char), 1, nBytesToRead, pStudyFile );						// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &m_ImageQuality, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );						// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedParenchymalAbnormalities, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );	// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned short);
-			nBytesRead = fread_s( &m_ObservedPleuralPlaqueSites, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );			// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedPleuralCalcificationSites, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );	// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedPlaqueExtent, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedPlaqueWidth, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedCostophrenicAngleObliteration, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );	// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedPleuralThickeningSites, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );			// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedThickeningCalcificationSites, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );	// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedThickeningExtent, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedThickeningWidth, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &m_ObservedOtherSymbols, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );					// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesRead = fread_s( &m_ObservedOtherAbnormalities, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &LengthInBytes, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead && LengthInBytes < DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
-			if ( bNoError )
-				{
-				StringLength = (size_t)LengthInBytes;																				// *[1] Forced allocation size to be data type size_t.
-				pTextBuffer = (char*)malloc( StringLength + 1 );																	// *[1]
-				bNoError = ( pTextBuffer != 0 );
-				}
-			if ( bNoError )
-				{
-				nBytesToRead = LengthInBytes;
-				nBytesRead = fread_s( pTextBuffer, StringLength + 1, 1, nBytesToRead, pStudyFile );												// *[2] Converted from fread to fread_s.
-				pTextBuffer[ nBytesToRead ] = '\0';
-				bNoError = ( nBytesRead == nBytesToRead );
-				if ( bNoError )
-					m_ImageDefectOtherText = pTextBuffer;
-				free( pTextBuffer );
-				}
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &LengthInBytes, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead && LengthInBytes < DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
-			if ( bNoError )
-				{
-				StringLength = (size_t)LengthInBytes;																				// *[1] Forced allocation size to be data type size_t.
-				pTextBuffer = (char*)malloc( StringLength + 1 );																	// *[1]
-				bNoError = ( pTextBuffer != 0 );
-				}
-			if ( bNoError )
-				{
-				nBytesToRead = LengthInBytes;
-				nBytesRead = fread_s( pTextBuffer, StringLength + 1, 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-				pTextBuffer[ nBytesToRead ] = '\0';
-				bNoError = ( nBytesRead == nBytesToRead );
-				if ( bNoError )
-					m_OtherAbnormalitiesCommentsText = pTextBuffer;
-				free( pTextBuffer );
-				}
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &m_PhysicianNotificationStatus, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(EDITED_DATE);
-			nBytesRead = fread_s( &m_Reserved2, sizeof(EDITED_DATE), 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(EDITED_DATE);
-			nBytesRead = fread_s( &m_DateOfRadiograph, sizeof(EDITED_DATE), 1, nBytesToRead, pStudyFile );							// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &LengthInBytes, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead && LengthInBytes < DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
-			if ( bNoError )
-				{
-				StringLength = (size_t)LengthInBytes;																				// *[1] Forced allocation size to be data type size_t.
-				pTextBuffer = (char*)malloc( StringLength + 1 );																	// *[1]
-				bNoError = ( pTextBuffer != 0 );
-				}
-			if ( bNoError )
-				{
-				nBytesToRead = LengthInBytes;
-				nBytesRead = fread_s( pTextBuffer, StringLength + 1, 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-				bNoError = ( nBytesRead == nBytesToRead );
-				if ( bNoError )
-					strncpy_s( m_Reserved1, 12, pTextBuffer, _TRUNCATE );															// *[1] Replaced strcpy with strncpy_s.
-				free( pTextBuffer );
-				pTextBuffer = 0;																									// *[1] Added this for code safety.
-				}
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned short);
-			nBytesRead = fread_s( &m_TypeOfReading, sizeof(unsigned short), 1, nBytesToRead, pStudyFile );							// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &LengthInBytes, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead && LengthInBytes < DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
-			if ( bNoError )
-				{
-				StringLength = (size_t)LengthInBytes;																				// *[1] Forced allocation size to be data type size_t.
-				pTextBuffer = (char*)malloc( StringLength + 1 );																	// *[1]
-				bNoError = ( pTextBuffer != 0 );
-				}
-			if ( bNoError )
-				{
-				nBytesToRead = LengthInBytes;
-				nBytesRead = fread_s( pTextBuffer, StringLength + 1, 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-				bNoError = ( nBytesRead == nBytesToRead );
-				if ( bNoError )
-					strncpy_s( m_OtherTypeOfReading, DICOM_ATTRIBUTE_STRING_LENGTH, pTextBuffer, _TRUNCATE );						// *[2] Replaced strncat with strncpy_s.
-				free( pTextBuffer );
-				pTextBuffer = 0;																									// *[1] Added this for code safety.
-				}
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &LengthInBytes, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead && LengthInBytes < DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
-			if ( bNoError )
-				{
-				StringLength = (size_t)LengthInBytes;																				// *[1] Forced allocation size to be data type size_t.
-				pTextBuffer = (char*)malloc( StringLength + 1 );																	// *[1]
-				bNoError = ( pTextBuffer != 0 );
-				}
-			if ( bNoError )
-				{
-				nBytesToRead = LengthInBytes;
-				nBytesRead = fread_s( pTextBuffer, StringLength + 1, 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-				bNoError = ( nBytesRead == nBytesToRead );
-				if ( bNoError )
-					strncpy_s( m_FacilityIDNumber, 10, pTextBuffer, _TRUNCATE );													// *[2] Replaced strncat with strncpy_s.
-				free( pTextBuffer );
-				pTextBuffer = 0;																									// *[1] Added this for code safety.
-				}
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(EDITED_DATE);
-			nBytesRead = fread_s( &m_DateOfReading, sizeof(EDITED_DATE), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(BOOL);
-			nBytesRead = fread_s( &m_bReportViewed, sizeof(BOOL), 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			nBytesToRead = sizeof(BOOL);
-			nBytesRead = fread_s( &m_bReportApproved, sizeof(BOOL), 1, nBytesToRead, pStudyFile );									// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			}
-		if ( bNoError )
-			{
-			// Read the number of studies recorded for this patient.
-			nBytesToRead = sizeof(unsigned long);
-			nBytesRead = fread_s( &nStudyCount, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );								// *[2] Converted from fread to fread_s.
-			bNoError = ( nBytesRead == nBytesToRead );
-			if ( bNoError )
-				{
-				// Read the length of the study structure.
-				nBytesToRead = sizeof(unsigned long);
-				nBytesRead = fread_s( &LengthInBytes, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );							// *[2] Converted from fread to fread_s.
-				bNoError = ( nBytesRead == nBytesToRead );
-				if ( bNoError )
-					if ( LengthInBytes != sizeof(DIAGNOSTIC_STUDY) )
-						bNoError = FALSE;
-				}
-			if ( bNoError )
-				{
-				// Read the list of studies for the current patient.
-				ppDiagnosticStudy = &m_pDiagnosticStudyList;
-				for ( nStudy = 0; nStudy < nStudyCount && bNoError; nStudy++ )
-					{
-					bNoError = RestoreDiagnosticStudy( pStudyFile, ppDiagnosticStudy );
-					ppDiagnosticStudy = &( *ppDiagnosticStudy ) -> pNextDiagnosticStudy;
-					}
-				}
-			if ( bNoError )
-				{
-				nBytesToRead = sizeof(m_SDYFileVersion);
-				nBytesRead = fread_s( &m_SDYFileVersion, sizeof(unsigned long), 1, nBytesToRead, pStudyFile );						// *[2] Converted from fread to fread_s.
-				if ( nBytesRead == 0 )
-					m_SDYFileVersion = 0;
-				switch ( m_SDYFileVersion )
-					{
-					case 1:
-					case 2:
-						nBytesToRead = nBytesInEarlierBViewerVersions = 352;
-						// The more recently added members of READER_PERSONAL_INFO, namely IsDefaultReader, m_CountryInfo, and pwLength will not be modified by this read, but will be preserved.
-						nBytesRead = fread_s( &m_ReaderInfo, sizeof(READER_PERSONAL_INFO), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-						bNoError = ( nBytesRead == nBytesInEarlierBViewerVersions );													// *[4] READER_PERSONAL_INFO size changed in BViewer 1.2u.
-						if ( bNoError )
-							{
-							nBytesToRead = sizeof(BOOL);
-							nBytesRead = fread_s( &m_bStudyWasPreviouslyInterpreted, sizeof(BOOL), 1, nBytesToRead, pStudyFile );		// *[2] Converted from fread to fread_s.
-							bNoError = ( nBytesRead == nBytesToRead );
-							}
-						if ( m_SDYFileVersion == 1 )
-							break;
-						nBytesToRead = sizeof(CLIENT_INFO);
-						nBytesRead = fread_s( &m_ClientInfo, sizeof(CLIENT_INFO), 1, nBytesToRead, pStudyFile );						// *[2] Converted from fread to fread_s.
-						bNoError = ( nBytesRead == nBytesToRead );
-						break;
-					case 3:
-						nBytesToRead = sizeof(READER_PERSONAL_INFO);
-						nBytesRead = fread_s( &m_ReaderInfo, sizeof(READER_PERSONAL_INFO), 1, nBytesToRead, pStudyFile );				// *[2] Converted from fread to fread_s.
-						bNoError = ( nBytesRead == nBytesToRead );						// *[4] READER_PERSONAL_INFO size changed in BViewer 1.2u.
-						if ( bNoError )
-							{
-							nBytesToRead = sizeof(BOOL);
-							nBytesRead = fread_s( &m_bStudyWasPreviouslyInterpreted, sizeof(BOOL), 1, nBytesToRead, pStudyFile );		// *[2] Converted from fread to fread_s.
-							bNoError = ( nBytesRead == nBytesToRead );
-							}
-						if ( bNoError )
-							{
-							nBytesToRead = sizeof(CLIENT_INFO);
-							nBytesRead = fread_s( &m_ClientInfo, sizeof(CLIENT_INFO), 1, nBytesToRead, pStudyFile );						// *[2] Converted from fread to fread_s.
-							bNoError = ( nBytesRead == nBytesToRead );
-							}
-						break;
-					}
-				}
-			if ( !bNoError )
-				{
-				_snprintf_s( Msg, FULL_FILE_SPEC_STRING_LENGTH, _TRUNCATE, "Unable to restore study file for %s", m_PatientLastName );	// *[2] Replaced sprintf() with _snprintf_s.
-				LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
-				}
-			}
-		fclose( pStudyFile );
 		}
-	else
-		bNoError = FALSE;
-	bFileReadSuccessfully = bNoError;
+	if ( pFileImage != 0 )
+		free( pFileImage );
 	if ( bNoError )
 		UnpackData();
 	
-	return bFileReadSuccessfully;
+	return bNoError;
 }
 
 
@@ -30,6 +30,16 @@
 //
 // UPDATE HISTORY:
 //
+//	*[4] 10/19/2026 by agent
+//		Moved the diagnostic study, series and image structures and the study file
+//		definitions to StudyFile.h.  The study file is composed and restored by the
+//		functions in StudyFile.cpp, from a STUDY_FILE_CONTENTS structure.
+//	*[3] 10/19/2026 by agent
+//		Added the header, section table and study record of the sectioned (version 4)
+//		study file layout.
+//	*[2] 10/19/2026 by agent
+//		Added m_PatientKeyHash, m_pStudyList and CalculatePatientKeyHash() for filing
+//		the study in the application's patient index.
 //	*[1] 02/01/2024 by Tom Atwood
 //		Fixed code security issues.
 //
@@ -41,77 +51,7 @@
 #include "DicomDictionary.h"
 #include "Abstract.h"
 #include "Client.h"
-
-
-typedef struct _DiagnosticImage
-	{
-	char						ImageType[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						InstanceNumber[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						InstanceCreationDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						InstanceCreationTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						ContentDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						ContentTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						AcquisitionNumber[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						AcquisitionDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						AcquisitionTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						SamplesPerPixel[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						PhotometricInterpretation[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						Rows[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						Columns[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						PixelAspectRatio[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						BitsAllocated[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						BitsStored[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						HighBit[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						PixelRepresentation[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						WindowCenter[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						WindowWidth[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						SOPInstanceUID[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
-	int							Reserved;
-	struct _DiagnosticImage		*pNextDiagnosticImage;
-	} DIAGNOSTIC_IMAGE;
-
-
-typedef struct _DiagnosticSeries
-	{
-	char						Modality[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						SeriesNumber[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						Laterality[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						SeriesDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						SeriesTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						ProtocolName[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						SeriesDescription[ DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH ];
-	char						BodyPartExamined[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						PatientPosition[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						PatientOrientation[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						SeriesInstanceUID[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
-	char						Manufacturer[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
-	DIAGNOSTIC_IMAGE			*pDiagnosticImageList;
-	struct _DiagnosticSeries	*pNextDiagnosticSeries;
-	} DIAGNOSTIC_SERIES;
-
-
-typedef struct _DiagnosticStudy
-	{
-	char						AccessionNumber[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						StudyDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						StudyTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						ReferringPhysiciansName[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						ReferringPhysiciansPhone[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						ResponsibleOrganization[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						InstitutionName[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						StudyID[ DICOM_ATTRIBUTE_STRING_LENGTH ];
-	char						StudyDescription[ DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH ];
-	char						StudyInstanceUID[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
-	DIAGNOSTIC_SERIES			*pDiagnosticSeriesList;
-	struct _DiagnosticStudy		*pNextDiagnosticStudy;
-	} DIAGNOSTIC_STUDY;
-
-
-typedef struct
-	{
-	SYSTEMTIME		Date;
-	BOOL			bDateHasBeenEdited;
-	} EDITED_DATE;
+#include "StudyFile.h"													// *[4]
 
 
 class CStudy
@@ -393,6 +333,8 @@ public:
 	EVENT_PARAMETERS		*m_pEventParameters;
 	char					m_ReportPage1FilePath[ FULL_FILE_SPEC_STRING_LENGTH ];
 	char					m_ReportPage2FilePath[ FULL_FILE_SPEC_STRING_LENGTH ];
+	unsigned long			m_PatientKeyHash;						// *[2] The hash under which this study is filed in the patient index.
+	LIST_HEAD				*m_pStudyList;							// *[2] The application study list holding this study, or zero if none.
 
 
 
@@ -412,18 +354,17 @@ public:
 	void			LoadStudyData( char *pTitleRow, char *pDataRow );
 	void			LoadSeriesData( char *pTitleRow, char *pDataRow, DIAGNOSTIC_STUDY *pDiagnosticStudy );
 	void			LoadImageData( char *pTitleRow, char *pDataRow, DIAGNOSTIC_SERIES *pDiagnosticSeries );
+	unsigned long	CalculatePatientKeyHash();									// *[2]
 	BOOL			MergeWithExistingStudies( BOOL *pbNewStudyMergedWithExistingStudy );
 	void			GetDateOfRadiographMMDDYY( char *pDateString );
 
-	BOOL			SaveDiagnosticImage( FILE *pStudyFile, DIAGNOSTIC_IMAGE *pDiagnosticImage );
-	BOOL			SaveDiagnosticSeries( FILE *pStudyFile, DIAGNOSTIC_SERIES *pDiagnosticSeries );
-	BOOL			SaveDiagnosticStudy( FILE *pStudyFile, DIAGNOSTIC_STUDY *pDiagnosticStudy );
+	void			CopyToStudyRecord( SDY_STUDY_RECORD *pStudyRecord );				// *[3]
+	void			CopyFromStudyRecord( SDY_STUDY_RECORD *pStudyRecord );				// *[3]
+	void			CopyToStudyFileContents( STUDY_FILE_CONTENTS *pStudyFileContents );		// *[4]
+	void			CopyFromStudyFileContents( STUDY_FILE_CONTENTS *pStudyFileContents );	// *[4]
 	void			GetStudyFileName( char *pStudyFileName, size_t BufferSize );
 	BOOL			Save();
 
-	BOOL			RestoreDiagnosticImage( FILE *pStudyFile, DIAGNOSTIC_IMAGE **ppDiagnosticImage );
-	BOOL			RestoreDiagnosticSeries( FILE *pStudyFile, DIAGNOSTIC_SERIES **ppDiagnosticSeries, BOOL bOlderSeriesWithoutManufacturer );
-	BOOL			RestoreDiagnosticStudy( FILE *pStudyFile, DIAGNOSTIC_STUDY **ppDiagnosticStudy );
 	BOOL			Restore( char *pFullFilePath );
 
 	void			DeleteStudyDataAndImages();
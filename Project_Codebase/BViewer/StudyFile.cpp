@@ -0,0 +1,1148 @@
+// StudyFile.cpp : Implements the composition and restoration of the study (.sdy) files.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include "Module.h"
+#include "Configuration.h"
+#include "StudyFile.h"
+#include "zlib.h"
+
+
+// The earliest study files recorded only this much of the reader information.
+#define LEGACY_READER_INFO_LENGTH			352
+
+
+// Each member of a study file record is located in its structure by an entry in the record's
+// member table.  The members are written one after another, in table order, without padding,
+// so new members may only be appended to a table.  The list pointers are not recorded.
+typedef struct
+	{
+	size_t				Offset;					// From the beginning of the structure.
+	unsigned long		Length;
+	} SDY_RECORD_MEMBER;
+
+
+typedef struct
+	{
+	SDY_RECORD_MEMBER	*pMembers;
+	size_t				nMembers;
+	size_t				StructureLength;
+	} SDY_RECORD_LAYOUT;
+
+
+#define SDY_MEMBER( StructureType, Member )			{ offsetof( StructureType, Member ), sizeof( ( (StructureType*)0 ) -> Member ) }
+#define SDY_LAYOUT( StructureType, MemberTable )	{ MemberTable, sizeof( MemberTable ) / sizeof( SDY_RECORD_MEMBER ), sizeof( StructureType ) }
+
+
+static SDY_RECORD_MEMBER	StudyRecordMembers[] =
+	{
+	SDY_MEMBER( SDY_STUDY_RECORD, ReaderAddressed ),
+	SDY_MEMBER( SDY_STUDY_RECORD, PatientLastName ),
+	SDY_MEMBER( SDY_STUDY_RECORD, PatientFirstName ),
+	SDY_MEMBER( SDY_STUDY_RECORD, PatientID ),
+	SDY_MEMBER( SDY_STUDY_RECORD, PatientsBirthDate.Date ),
+	SDY_MEMBER( SDY_STUDY_RECORD, PatientsBirthDate.bDateHasBeenEdited ),
+	SDY_MEMBER( SDY_STUDY_RECORD, PatientsSex ),
+	SDY_MEMBER( SDY_STUDY_RECORD, PatientComments ),
+	SDY_MEMBER( SDY_STUDY_RECORD, Reserved ),
+	SDY_MEMBER( SDY_STUDY_RECORD, GammaSetting ),
+	SDY_MEMBER( SDY_STUDY_RECORD, WindowCenter ),
+	SDY_MEMBER( SDY_STUDY_RECORD, WindowWidth ),
+	SDY_MEMBER( SDY_STUDY_RECORD, MaxGrayscaleValue ),
+	SDY_MEMBER( SDY_STUDY_RECORD, TimeStudyFirstOpened ),
+	SDY_MEMBER( SDY_STUDY_RECORD, TimeReportApproved ),
+	SDY_MEMBER( SDY_STUDY_RECORD, nCurrentObjectID ),
+	SDY_MEMBER( SDY_STUDY_RECORD, bImageQualityVisited ),
+	SDY_MEMBER( SDY_STUDY_RECORD, bParenchymalAbnormalitiesVisited ),
+	SDY_MEMBER( SDY_STUDY_RECORD, bPleuralAbnormalitiesVisited ),
+	SDY_MEMBER( SDY_STUDY_RECORD, bOtherAbnormalitiesVisited ),
+	SDY_MEMBER( SDY_STUDY_RECORD, AnyParenchymalAbnormalities ),
+	SDY_MEMBER( SDY_STUDY_RECORD, AnyPleuralAbnormalities ),
+	SDY_MEMBER( SDY_STUDY_RECORD, AnyOtherAbnormalities ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ImageQuality ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedParenchymalAbnormalities ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedPleuralPlaqueSites ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedPleuralCalcificationSites ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedPlaqueExtent ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedPlaqueWidth ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedCostophrenicAngleObliteration ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedPleuralThickeningSites ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedThickeningCalcificationSites ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedThickeningExtent ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedThickeningWidth ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedOtherSymbols ),
+	SDY_MEMBER( SDY_STUDY_RECORD, ObservedOtherAbnormalities ),
+	SDY_MEMBER( SDY_STUDY_RECORD, PhysicianNotificationStatus ),
+	SDY_MEMBER( SDY_STUDY_RECORD, Reserved2.Date ),
+	SDY_MEMBER( SDY_STUDY_RECORD, Reserved2.bDateHasBeenEdited ),
+	SDY_MEMBER( SDY_STUDY_RECORD, DateOfRadiograph.Date ),
+	SDY_MEMBER( SDY_STUDY_RECORD, DateOfRadiograph.bDateHasBeenEdited ),
+	SDY_MEMBER( SDY_STUDY_RECORD, Reserved1 ),
+	SDY_MEMBER( SDY_STUDY_RECORD, TypeOfReading ),
+	SDY_MEMBER( SDY_STUDY_RECORD, OtherTypeOfReading ),
+	SDY_MEMBER( SDY_STUDY_RECORD, FacilityIDNumber ),
+	SDY_MEMBER( SDY_STUDY_RECORD, DateOfReading.Date ),
+	SDY_MEMBER( SDY_STUDY_RECORD, DateOfReading.bDateHasBeenEdited ),
+	SDY_MEMBER( SDY_STUDY_RECORD, bReportViewed ),
+	SDY_MEMBER( SDY_STUDY_RECORD, bReportApproved ),
+	SDY_MEMBER( SDY_STUDY_RECORD, bStudyWasPreviouslyInterpreted )
+	};
+
+
+static SDY_RECORD_MEMBER	DiagnosticStudyMembers[] =
+	{
+	SDY_MEMBER( DIAGNOSTIC_STUDY, AccessionNumber ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, StudyDate ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, StudyTime ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, ReferringPhysiciansName ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, ReferringPhysiciansPhone ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, ResponsibleOrganization ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, InstitutionName ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, StudyID ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, StudyDescription ),
+	SDY_MEMBER( DIAGNOSTIC_STUDY, StudyInstanceUID )
+	};
+
+
+static SDY_RECORD_MEMBER	DiagnosticSeriesMembers[] =
+	{
+	SDY_MEMBER( DIAGNOSTIC_SERIES, Modality ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, SeriesNumber ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, Laterality ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, SeriesDate ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, SeriesTime ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, ProtocolName ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, SeriesDescription ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, BodyPartExamined ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, PatientPosition ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, PatientOrientation ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, SeriesInstanceUID ),
+	SDY_MEMBER( DIAGNOSTIC_SERIES, Manufacturer )
+	};
+
+
+static SDY_RECORD_MEMBER	DiagnosticImageMembers[] =
+	{
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, ImageType ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, InstanceNumber ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, InstanceCreationDate ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, InstanceCreationTime ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, ContentDate ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, ContentTime ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, AcquisitionNumber ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, AcquisitionDate ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, AcquisitionTime ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, SamplesPerPixel ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, PhotometricInterpretation ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, Rows ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, Columns ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, PixelAspectRatio ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, BitsAllocated ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, BitsStored ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, HighBit ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, PixelRepresentation ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, WindowCenter ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, WindowWidth ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, SOPInstanceUID ),
+	SDY_MEMBER( DIAGNOSTIC_IMAGE, Reserved )
+	};
+
+
+// The signature bitmap pointer is not recorded.
+static SDY_RECORD_MEMBER	ReaderInfoMembers[] =
+	{
+	SDY_MEMBER( READER_PERSONAL_INFO, LastName ),
+	SDY_MEMBER( READER_PERSONAL_INFO, ID ),
+	SDY_MEMBER( READER_PERSONAL_INFO, Initials ),
+	SDY_MEMBER( READER_PERSONAL_INFO, StreetAddress ),
+	SDY_MEMBER( READER_PERSONAL_INFO, City ),
+	SDY_MEMBER( READER_PERSONAL_INFO, State ),
+	SDY_MEMBER( READER_PERSONAL_INFO, ZipCode ),
+	SDY_MEMBER( READER_PERSONAL_INFO, LoginName ),
+	SDY_MEMBER( READER_PERSONAL_INFO, EncodedPassword ),
+	SDY_MEMBER( READER_PERSONAL_INFO, bLoginNameEntered ),
+	SDY_MEMBER( READER_PERSONAL_INFO, bPasswordEntered ),
+	SDY_MEMBER( READER_PERSONAL_INFO, AE_TITLE ),
+	SDY_MEMBER( READER_PERSONAL_INFO, ReportSignatureName ),
+	SDY_MEMBER( READER_PERSONAL_INFO, IsDefaultReader ),
+	SDY_MEMBER( READER_PERSONAL_INFO, m_CountryInfo.CountryName ),
+	SDY_MEMBER( READER_PERSONAL_INFO, m_CountryInfo.DateFormat ),
+	SDY_MEMBER( READER_PERSONAL_INFO, pwLength )
+	};
+
+
+static SDY_RECORD_MEMBER	ClientInfoMembers[] =
+	{
+	SDY_MEMBER( CLIENT_INFO, Name ),
+	SDY_MEMBER( CLIENT_INFO, StreetAddress ),
+	SDY_MEMBER( CLIENT_INFO, City ),
+	SDY_MEMBER( CLIENT_INFO, State ),
+	SDY_MEMBER( CLIENT_INFO, ZipCode ),
+	SDY_MEMBER( CLIENT_INFO, Phone ),
+	SDY_MEMBER( CLIENT_INFO, OtherContactInfo )
+	};
+
+
+static SDY_RECORD_LAYOUT	StudyRecordLayout = SDY_LAYOUT( SDY_STUDY_RECORD, StudyRecordMembers );
+static SDY_RECORD_LAYOUT	DiagnosticStudyLayout = SDY_LAYOUT( DIAGNOSTIC_STUDY, DiagnosticStudyMembers );
+static SDY_RECORD_LAYOUT	DiagnosticSeriesLayout = SDY_LAYOUT( DIAGNOSTIC_SERIES, DiagnosticSeriesMembers );
+static SDY_RECORD_LAYOUT	DiagnosticImageLayout = SDY_LAYOUT( DIAGNOSTIC_IMAGE, DiagnosticImageMembers );
+static SDY_RECORD_LAYOUT	ReaderInfoLayout = SDY_LAYOUT( READER_PERSONAL_INFO, ReaderInfoMembers );
+static SDY_RECORD_LAYOUT	ClientInfoLayout = SDY_LAYOUT( CLIENT_INFO, ClientInfoMembers );
+
+
+// Return the length of the study file records described by a member table.
+static unsigned long StudyFileRecordLength( SDY_RECORD_LAYOUT *pRecordLayout )
+{
+	unsigned long			RecordLength;
+	size_t					nMember;
+
+	RecordLength = 0;
+	for ( nMember = 0; nMember < pRecordLayout -> nMembers; nMember++ )
+		RecordLength += pRecordLayout -> pMembers[ nMember ].Length;
+
+	return RecordLength;
+}
+
+
+// Copy the members of a structure into its study file record.
+static void PackStudyFileRecord( char *pRecord, void *pStructure, SDY_RECORD_LAYOUT *pRecordLayout )
+{
+	SDY_RECORD_MEMBER		*pMember;
+	size_t					nMember;
+
+	for ( nMember = 0; nMember < pRecordLayout -> nMembers; nMember++ )
+		{
+		pMember = &pRecordLayout -> pMembers[ nMember ];
+		memcpy( pRecord, (char*)pStructure + pMember -> Offset, pMember -> Length );
+		pRecord += pMember -> Length;
+		}
+}
+
+
+// Copy a study file record into its structure.  The record may have been written by a version
+// with fewer or more members than this one.  Members it lacks are zeroed, and members that
+// this version doesn't know are passed over.
+static void UnpackStudyFileRecord( void *pStructure, char *pRecord, unsigned long RecordLength, SDY_RECORD_LAYOUT *pRecordLayout )
+{
+	SDY_RECORD_MEMBER		*pMember;
+	size_t					nMember;
+	unsigned long			MemberPosition;
+
+	memset( pStructure, '\0', pRecordLayout -> StructureLength );
+	MemberPosition = 0;
+	for ( nMember = 0; nMember < pRecordLayout -> nMembers &&
+						pRecordLayout -> pMembers[ nMember ].Length <= RecordLength - MemberPosition; nMember++ )
+		{
+		pMember = &pRecordLayout -> pMembers[ nMember ];
+		memcpy( (char*)pStructure + pMember -> Offset, pRecord + MemberPosition, pMember -> Length );
+		MemberPosition += pMember -> Length;
+		}
+}
+
+
+// Return the length of a study file section, padded so that the following section begins
+// on an 8-byte boundary.
+static size_t StudyFileSectionLength( unsigned long RecordLength, unsigned long nRecords )
+{
+	return ( (size_t)RecordLength * nRecords + 7 ) & ~(size_t)7;
+}
+
+
+// Enter the next section into the section table of a study file image, and return the address
+// in the image where its records are to be placed.
+static char *AddStudyFileSection( char *pFileImage, unsigned long SectionID, unsigned long RecordLength,
+									unsigned long nRecords, unsigned long *pNextSectionOffset )
+{
+	SDY_FILE_HEADER			*pFileHeader;
+	SDY_SECTION_ENTRY		*pSectionEntry;
+	char					*pSectionData;
+
+	pFileHeader = (SDY_FILE_HEADER*)pFileImage;
+	pSectionEntry = (SDY_SECTION_ENTRY*)( pFileImage + sizeof(SDY_FILE_HEADER) ) + pFileHeader -> nSections;
+	pSectionEntry -> SectionID = SectionID;
+	pSectionEntry -> Offset = *pNextSectionOffset;
+	pSectionEntry -> RecordLength = RecordLength;
+	pSectionEntry -> nRecords = nRecords;
+	pFileHeader -> nSections++;
+	pSectionData = pFileImage + *pNextSectionOffset;
+	*pNextSectionOffset += (unsigned long)StudyFileSectionLength( RecordLength, nRecords );
+
+	return pSectionData;
+}
+
+
+// Locate a section in the memory image of a study file.  The section is not reported as found
+// if its records would extend beyond the end of the file.
+static BOOL FindStudyFileSection( char *pFileImage, SDY_FILE_HEADER *pFileHeader, unsigned long SectionID, SDY_SECTION_ENTRY *pSectionEntry )
+{
+	BOOL					bSectionFound = FALSE;
+	unsigned long			nSection;
+
+	for ( nSection = 0; nSection < pFileHeader -> nSections && !bSectionFound; nSection++ )
+		{
+		memcpy( pSectionEntry, pFileImage + pFileHeader -> HeaderLength + nSection * pFileHeader -> SectionEntryLength, sizeof(SDY_SECTION_ENTRY) );
+		bSectionFound = ( pSectionEntry -> SectionID == SectionID );
+		}
+	if ( bSectionFound )
+		bSectionFound = ( pSectionEntry -> Offset <= pFileHeader -> FileLength &&
+							(unsigned __int64)pSectionEntry -> RecordLength * pSectionEntry -> nRecords <= pFileHeader -> FileLength - pSectionEntry -> Offset );
+
+	return bSectionFound;
+}
+
+
+// Restore one of the free text fields from its study file section, into a newly allocated string.
+static BOOL RestoreStudyFileText( char *pFileImage, SDY_SECTION_ENTRY *pSectionEntry, char **ppText )
+{
+	BOOL					bNoError = TRUE;
+	char					*pTextBuffer;
+
+	bNoError = ( pSectionEntry -> RecordLength == 1 && pSectionEntry -> nRecords < DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
+	if ( bNoError )
+		{
+		pTextBuffer = (char*)malloc( (size_t)pSectionEntry -> nRecords + 1 );
+		bNoError = ( pTextBuffer != 0 );
+		if ( bNoError )
+			{
+			memcpy( pTextBuffer, pFileImage + pSectionEntry -> Offset, pSectionEntry -> nRecords );
+			pTextBuffer[ pSectionEntry -> nRecords ] = '\0';
+			*ppText = pTextBuffer;
+			}
+		}
+
+	return bNoError;
+}
+
+
+static unsigned long StudyFileTextLength( char *pText )
+{
+	unsigned long			TextLength;
+
+	if ( pText != 0 )
+		TextLength = (unsigned long)strlen( pText );
+	else
+		TextLength = 0;
+
+	return TextLength;
+}
+
+
+// Compose the memory image of a sectioned study file.  The diagnostic study, series and image
+// records are each stored contiguously, in list order, with the number of series in each study
+// and of images in each series recorded in their own sections.  The caller frees the returned
+// image.
+char *ComposeStudyFileImage( STUDY_FILE_CONTENTS *pStudyFileContents, size_t *pFileLength )
+{
+	char					*pFileImage;
+	SDY_FILE_HEADER			*pFileHeader;
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
+	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
+	unsigned long			nStudies;
+	unsigned long			nSeries;
+	unsigned long			nImages;
+	unsigned long			nSeriesInStudy;
+	unsigned long			nImagesInSeries;
+	unsigned long			StudyRecordLength;
+	unsigned long			DiagnosticStudyLength;
+	unsigned long			DiagnosticSeriesLength;
+	unsigned long			DiagnosticImageLength;
+	unsigned long			ReaderInfoLength;
+	unsigned long			ClientInfoLength;
+	unsigned long			ImageDefectTextLength;
+	unsigned long			CommentsTextLength;
+	unsigned long			NextSectionOffset;
+	size_t					FileLength;
+	char					*pSectionData;
+	char					*pStudyData;
+	char					*pSeriesCountData;
+	char					*pSeriesData;
+	char					*pImageCountData;
+	char					*pImageData;
+
+	// Count the records for each section.
+	nStudies = 0;
+	nSeries = 0;
+	nImages = 0;
+	pDiagnosticStudy = pStudyFileContents -> pDiagnosticStudyList;
+	while ( pDiagnosticStudy != 0 )
+		{
+		nStudies++;
+		pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList;
+		while ( pDiagnosticSeries != 0 )
+			{
+			nSeries++;
+			pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
+			while ( pDiagnosticImage != 0 )
+				{
+				nImages++;
+				pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
+				}
+			pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
+			}
+		pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
+		}
+	StudyRecordLength = StudyFileRecordLength( &StudyRecordLayout );
+	DiagnosticStudyLength = StudyFileRecordLength( &DiagnosticStudyLayout );
+	DiagnosticSeriesLength = StudyFileRecordLength( &DiagnosticSeriesLayout );
+	DiagnosticImageLength = StudyFileRecordLength( &DiagnosticImageLayout );
+	ReaderInfoLength = StudyFileRecordLength( &ReaderInfoLayout );
+	ClientInfoLength = StudyFileRecordLength( &ClientInfoLayout );
+	ImageDefectTextLength = StudyFileTextLength( pStudyFileContents -> pImageDefectOtherText );
+	CommentsTextLength = StudyFileTextLength( pStudyFileContents -> pOtherAbnormalitiesCommentsText );
+	FileLength = sizeof(SDY_FILE_HEADER) + SDY_SECTION_COUNT * sizeof(SDY_SECTION_ENTRY) +
+					StudyFileSectionLength( StudyRecordLength, 1 ) +
+					StudyFileSectionLength( 1, ImageDefectTextLength ) +
+					StudyFileSectionLength( 1, CommentsTextLength ) +
+					StudyFileSectionLength( DiagnosticStudyLength, nStudies ) +
+					StudyFileSectionLength( sizeof(unsigned long), nStudies ) +
+					StudyFileSectionLength( DiagnosticSeriesLength, nSeries ) +
+					StudyFileSectionLength( sizeof(unsigned long), nSeries ) +
+					StudyFileSectionLength( DiagnosticImageLength, nImages ) +
+					StudyFileSectionLength( ReaderInfoLength, 1 ) +
+					StudyFileSectionLength( ClientInfoLength, 1 );
+	// Zero the image, so that the section padding is zero.
+	pFileImage = (char*)calloc( 1, FileLength );
+	if ( pFileImage != 0 )
+		{
+		pFileHeader = (SDY_FILE_HEADER*)pFileImage;
+		memcpy( pFileHeader -> Signature, SDY_FILE_SIGNATURE, sizeof( pFileHeader -> Signature ) );
+		pFileHeader -> FileVersion = SDY_FILE_VERSION_SECTIONED;
+		pFileHeader -> HeaderLength = sizeof(SDY_FILE_HEADER);
+		pFileHeader -> SectionEntryLength = sizeof(SDY_SECTION_ENTRY);
+		pFileHeader -> FileLength = (unsigned long)FileLength;
+		NextSectionOffset = sizeof(SDY_FILE_HEADER) + SDY_SECTION_COUNT * sizeof(SDY_SECTION_ENTRY);
+
+		pSectionData = AddStudyFileSection( pFileImage, SDY_SECTION_STUDY, StudyRecordLength, 1, &NextSectionOffset );
+		PackStudyFileRecord( pSectionData, &pStudyFileContents -> StudyRecord, &StudyRecordLayout );
+		pSectionData = AddStudyFileSection( pFileImage, SDY_SECTION_IMAGE_DEFECT_TEXT, 1, ImageDefectTextLength, &NextSectionOffset );
+		memcpy( pSectionData, pStudyFileContents -> pImageDefectOtherText, ImageDefectTextLength );
+		pSectionData = AddStudyFileSection( pFileImage, SDY_SECTION_OTHER_ABNORMALITIES_TEXT, 1, CommentsTextLength, &NextSectionOffset );
+		memcpy( pSectionData, pStudyFileContents -> pOtherAbnormalitiesCommentsText, CommentsTextLength );
+		pStudyData = AddStudyFileSection( pFileImage, SDY_SECTION_DIAGNOSTIC_STUDIES, DiagnosticStudyLength, nStudies, &NextSectionOffset );
+		pSeriesCountData = AddStudyFileSection( pFileImage, SDY_SECTION_SERIES_COUNTS, sizeof(unsigned long), nStudies, &NextSectionOffset );
+		pSeriesData = AddStudyFileSection( pFileImage, SDY_SECTION_DIAGNOSTIC_SERIES, DiagnosticSeriesLength, nSeries, &NextSectionOffset );
+		pImageCountData = AddStudyFileSection( pFileImage, SDY_SECTION_IMAGE_COUNTS, sizeof(unsigned long), nSeries, &NextSectionOffset );
+		pImageData = AddStudyFileSection( pFileImage, SDY_SECTION_DIAGNOSTIC_IMAGES, DiagnosticImageLength, nImages, &NextSectionOffset );
+		pSectionData = AddStudyFileSection( pFileImage, SDY_SECTION_READER_INFO, ReaderInfoLength, 1, &NextSectionOffset );
+		PackStudyFileRecord( pSectionData, &pStudyFileContents -> ReaderInfo, &ReaderInfoLayout );
+		pSectionData = AddStudyFileSection( pFileImage, SDY_SECTION_CLIENT_INFO, ClientInfoLength, 1, &NextSectionOffset );
+		PackStudyFileRecord( pSectionData, &pStudyFileContents -> ClientInfo, &ClientInfoLayout );
+
+		pDiagnosticStudy = pStudyFileContents -> pDiagnosticStudyList;
+		while ( pDiagnosticStudy != 0 )
+			{
+			PackStudyFileRecord( pStudyData, pDiagnosticStudy, &DiagnosticStudyLayout );
+			pStudyData += DiagnosticStudyLength;
+			nSeriesInStudy = 0;
+			pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList;
+			while ( pDiagnosticSeries != 0 )
+				{
+				nSeriesInStudy++;
+				PackStudyFileRecord( pSeriesData, pDiagnosticSeries, &DiagnosticSeriesLayout );
+				pSeriesData += DiagnosticSeriesLength;
+				nImagesInSeries = 0;
+				pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
+				while ( pDiagnosticImage != 0 )
+					{
+					nImagesInSeries++;
+					PackStudyFileRecord( pImageData, pDiagnosticImage, &DiagnosticImageLayout );
+					pImageData += DiagnosticImageLength;
+					pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
+					}
+				memcpy( pImageCountData, &nImagesInSeries, sizeof(unsigned long) );
+				pImageCountData += sizeof(unsigned long);
+				pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
+				}
+			memcpy( pSeriesCountData, &nSeriesInStudy, sizeof(unsigned long) );
+			pSeriesCountData += sizeof(unsigned long);
+			pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
+			}
+		pFileHeader -> CRC = crc32( crc32( 0L, Z_NULL, 0 ), (const Bytef*)( pFileImage + sizeof(SDY_FILE_HEADER) ),
+																(uInt)( FileLength - sizeof(SDY_FILE_HEADER) ) );
+		*pFileLength = FileLength;
+		}
+	else
+		*pFileLength = 0;
+
+	return pFileImage;
+}
+
+
+// Restore the contents of a study from the memory image of a sectioned study file.  Sections
+// are located through the section table, so any sections added by later versions are passed
+// over.  If the file can't be restored, nothing is left allocated in the contents.
+BOOL RestoreStudyFileImage( char *pFileImage, size_t FileLength, STUDY_FILE_CONTENTS *pStudyFileContents )
+{
+	BOOL					bNoError = TRUE;
+	SDY_FILE_HEADER			FileHeader;
+	SDY_SECTION_ENTRY		SectionEntry;
+	SDY_SECTION_ENTRY		StudySection;
+	SDY_SECTION_ENTRY		SeriesCountSection;
+	SDY_SECTION_ENTRY		SeriesSection;
+	SDY_SECTION_ENTRY		ImageCountSection;
+	SDY_SECTION_ENTRY		ImageSection;
+	DIAGNOSTIC_STUDY		**ppDiagnosticStudy;
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
+	DIAGNOSTIC_SERIES		**ppDiagnosticSeries;
+	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		**ppDiagnosticImage;
+	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
+	unsigned long			nStudy;
+	unsigned long			nSeries;
+	unsigned long			nImage;
+	unsigned long			nSeriesInStudy;
+	unsigned long			nImagesInSeries;
+
+	memset( pStudyFileContents, '\0', sizeof(STUDY_FILE_CONTENTS) );
+	memset( &StudySection, '\0', sizeof(SDY_SECTION_ENTRY) );
+	bNoError = ( FileLength >= sizeof(SDY_FILE_HEADER) );
+	if ( bNoError )
+		{
+		memcpy( &FileHeader, pFileImage, sizeof(SDY_FILE_HEADER) );
+		bNoError = ( memcmp( FileHeader.Signature, SDY_FILE_SIGNATURE, sizeof(SDY_FILE_SIGNATURE) ) == 0 &&
+						FileHeader.FileVersion >= SDY_FILE_VERSION_SECTIONED &&
+						FileHeader.HeaderLength >= sizeof(SDY_FILE_HEADER) && FileHeader.HeaderLength <= FileLength &&
+						FileHeader.FileLength == FileLength && FileHeader.SectionEntryLength >= sizeof(SDY_SECTION_ENTRY) &&
+						FileHeader.nSections <= ( FileLength - FileHeader.HeaderLength ) / FileHeader.SectionEntryLength );
+		}
+	if ( bNoError )
+		bNoError = ( FileHeader.CRC == crc32( crc32( 0L, Z_NULL, 0 ), (const Bytef*)( pFileImage + FileHeader.HeaderLength ),
+																		(uInt)( FileLength - FileHeader.HeaderLength ) ) );
+	if ( bNoError )
+		{
+		bNoError = ( FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_STUDY, &SectionEntry ) && SectionEntry.nRecords == 1 );
+		if ( bNoError )
+			UnpackStudyFileRecord( &pStudyFileContents -> StudyRecord, pFileImage + SectionEntry.Offset, SectionEntry.RecordLength, &StudyRecordLayout );
+		}
+	if ( bNoError && FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_IMAGE_DEFECT_TEXT, &SectionEntry ) )
+		bNoError = RestoreStudyFileText( pFileImage, &SectionEntry, &pStudyFileContents -> pImageDefectOtherText );
+	if ( bNoError && FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_OTHER_ABNORMALITIES_TEXT, &SectionEntry ) )
+		bNoError = RestoreStudyFileText( pFileImage, &SectionEntry, &pStudyFileContents -> pOtherAbnormalitiesCommentsText );
+	if ( bNoError )
+		bNoError = ( FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_DIAGNOSTIC_STUDIES, &StudySection ) &&
+						FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_SERIES_COUNTS, &SeriesCountSection ) &&
+						FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_DIAGNOSTIC_SERIES, &SeriesSection ) &&
+						FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_IMAGE_COUNTS, &ImageCountSection ) &&
+						FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_DIAGNOSTIC_IMAGES, &ImageSection ) &&
+						SeriesCountSection.RecordLength == sizeof(unsigned long) && SeriesCountSection.nRecords == StudySection.nRecords &&
+						ImageCountSection.RecordLength == sizeof(unsigned long) && ImageCountSection.nRecords == SeriesSection.nRecords );
+	// Rebuild the study, series and image lists from their record sections.
+	nSeries = 0;
+	nImage = 0;
+	ppDiagnosticStudy = &pStudyFileContents -> pDiagnosticStudyList;
+	for ( nStudy = 0; bNoError && nStudy < StudySection.nRecords; nStudy++ )
+		{
+		pDiagnosticStudy = (DIAGNOSTIC_STUDY*)malloc( sizeof(DIAGNOSTIC_STUDY) );
+		bNoError = ( pDiagnosticStudy != 0 );
+		if ( bNoError )
+			{
+			UnpackStudyFileRecord( pDiagnosticStudy, pFileImage + StudySection.Offset + nStudy * StudySection.RecordLength, StudySection.RecordLength, &DiagnosticStudyLayout );
+			*ppDiagnosticStudy = pDiagnosticStudy;
+			ppDiagnosticStudy = &pDiagnosticStudy -> pNextDiagnosticStudy;
+			memcpy( &nSeriesInStudy, pFileImage + SeriesCountSection.Offset + nStudy * sizeof(unsigned long), sizeof(unsigned long) );
+			bNoError = ( nSeriesInStudy <= SeriesSection.nRecords - nSeries );
+			ppDiagnosticSeries = &pDiagnosticStudy -> pDiagnosticSeriesList;
+			for ( ; bNoError && nSeriesInStudy > 0; nSeriesInStudy-- )
+				{
+				pDiagnosticSeries = (DIAGNOSTIC_SERIES*)malloc( sizeof(DIAGNOSTIC_SERIES) );
+				bNoError = ( pDiagnosticSeries != 0 );
+				if ( bNoError )
+					{
+					UnpackStudyFileRecord( pDiagnosticSeries, pFileImage + SeriesSection.Offset + nSeries * SeriesSection.RecordLength, SeriesSection.RecordLength, &DiagnosticSeriesLayout );
+					*ppDiagnosticSeries = pDiagnosticSeries;
+					ppDiagnosticSeries = &pDiagnosticSeries -> pNextDiagnosticSeries;
+					memcpy( &nImagesInSeries, pFileImage + ImageCountSection.Offset + nSeries * sizeof(unsigned long), sizeof(unsigned long) );
+					nSeries++;
+					bNoError = ( nImagesInSeries <= ImageSection.nRecords - nImage );
+					ppDiagnosticImage = &pDiagnosticSeries -> pDiagnosticImageList;
+					for ( ; bNoError && nImagesInSeries > 0; nImagesInSeries-- )
+						{
+						pDiagnosticImage = (DIAGNOSTIC_IMAGE*)malloc( sizeof(DIAGNOSTIC_IMAGE) );
+						bNoError = ( pDiagnosticImage != 0 );
+						if ( bNoError )
+							{
+							UnpackStudyFileRecord( pDiagnosticImage, pFileImage + ImageSection.Offset + nImage * ImageSection.RecordLength, ImageSection.RecordLength, &DiagnosticImageLayout );
+							*ppDiagnosticImage = pDiagnosticImage;
+							ppDiagnosticImage = &pDiagnosticImage -> pNextDiagnosticImage;
+							nImage++;
+							}
+						}
+					}
+				}
+			}
+		}
+	if ( bNoError && FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_READER_INFO, &SectionEntry ) && SectionEntry.nRecords == 1 )
+		UnpackStudyFileRecord( &pStudyFileContents -> ReaderInfo, pFileImage + SectionEntry.Offset, SectionEntry.RecordLength, &ReaderInfoLayout );
+	if ( bNoError && FindStudyFileSection( pFileImage, &FileHeader, SDY_SECTION_CLIENT_INFO, &SectionEntry ) && SectionEntry.nRecords == 1 )
+		UnpackStudyFileRecord( &pStudyFileContents -> ClientInfo, pFileImage + SectionEntry.Offset, SectionEntry.RecordLength, &ClientInfoLayout );
+	if ( bNoError )
+		pStudyFileContents -> FileVersion = FileHeader.FileVersion;
+	else
+		DeallocateStudyFileContents( pStudyFileContents );
+
+	return bNoError;
+}
+
+
+// The legacy study file layout is composed in two passes, the first without a file image, to
+// measure it.
+static void AppendLegacyField( char *pFileImage, size_t *pFileLength, void *pField, size_t FieldLength )
+{
+	if ( pFileImage != 0 )
+		memcpy( pFileImage + *pFileLength, pField, FieldLength );
+	*pFileLength += FieldLength;
+}
+
+
+// The free text fields, and some of the character arrays, are preceded by their lengths.
+static void AppendLegacyText( char *pFileImage, size_t *pFileLength, char *pText, unsigned long TextLength )
+{
+	AppendLegacyField( pFileImage, pFileLength, &TextLength, sizeof(unsigned long) );
+	AppendLegacyField( pFileImage, pFileLength, pText, TextLength );
+}
+
+
+// Compose the field-by-field layout of the study file used before SDY file version 4, as it
+// was written by BViewer.  The structures are recorded as they are laid out in memory, so the
+// file is only read correctly by a build for the same platform.  The list and bitmap pointers
+// are recorded as zero.  Return the length of the file.
+static size_t ComposeLegacyStudyFileData( STUDY_FILE_CONTENTS *pStudyFileContents, char *pFileImage )
+{
+	SDY_STUDY_RECORD		*pStudyRecord;
+	size_t					FileLength;
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
+	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
+	DIAGNOSTIC_STUDY		DiagnosticStudy;
+	DIAGNOSTIC_SERIES		DiagnosticSeries;
+	DIAGNOSTIC_IMAGE		DiagnosticImage;
+	READER_PERSONAL_INFO	ReaderInfo;
+	unsigned long			nStudies;
+	unsigned long			nSeries;
+	unsigned long			nImages;
+	unsigned long			LengthInBytes;
+	unsigned long			FileVersion;
+
+	pStudyRecord = &pStudyFileContents -> StudyRecord;
+	FileLength = 0;
+	AppendLegacyField( pFileImage, &FileLength, pStudyRecord -> ReaderAddressed, DICOM_ATTRIBUTE_STRING_LENGTH );
+	AppendLegacyField( pFileImage, &FileLength, pStudyRecord -> PatientLastName, DICOM_ATTRIBUTE_STRING_LENGTH );
+	AppendLegacyField( pFileImage, &FileLength, pStudyRecord -> PatientFirstName, DICOM_ATTRIBUTE_STRING_LENGTH );
+	AppendLegacyField( pFileImage, &FileLength, pStudyRecord -> PatientID, DICOM_ATTRIBUTE_STRING_LENGTH );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> PatientsBirthDate, sizeof(EDITED_DATE) );
+	AppendLegacyField( pFileImage, &FileLength, pStudyRecord -> PatientsSex, 4 );
+	AppendLegacyField( pFileImage, &FileLength, pStudyRecord -> PatientComments, DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
+	// The reserved value was recorded twice.
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> Reserved, sizeof(double) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> Reserved, sizeof(double) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> GammaSetting, sizeof(double) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> WindowCenter, sizeof(double) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> WindowWidth, sizeof(double) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> MaxGrayscaleValue, sizeof(double) );
+	AppendLegacyField( pFileImage, &FileLength, pStudyRecord -> TimeStudyFirstOpened, 32 );
+	AppendLegacyField( pFileImage, &FileLength, pStudyRecord -> TimeReportApproved, 32 );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> nCurrentObjectID, sizeof(UINT) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> bImageQualityVisited, sizeof(BOOL) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> bParenchymalAbnormalitiesVisited, sizeof(BOOL) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> bPleuralAbnormalitiesVisited, sizeof(BOOL) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> bOtherAbnormalitiesVisited, sizeof(BOOL) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> AnyParenchymalAbnormalities, sizeof(char) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> AnyPleuralAbnormalities, sizeof(char) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> AnyOtherAbnormalities, sizeof(char) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ImageQuality, sizeof(unsigned long) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedParenchymalAbnormalities, sizeof(unsigned long) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedPleuralPlaqueSites, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedPleuralCalcificationSites, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedPlaqueExtent, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedPlaqueWidth, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedCostophrenicAngleObliteration, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedPleuralThickeningSites, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedThickeningCalcificationSites, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedThickeningExtent, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedThickeningWidth, sizeof(unsigned short) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedOtherSymbols, sizeof(unsigned long) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> ObservedOtherAbnormalities, sizeof(unsigned long) );
+	AppendLegacyText( pFileImage, &FileLength, pStudyFileContents -> pImageDefectOtherText,
+						StudyFileTextLength( pStudyFileContents -> pImageDefectOtherText ) );
+	AppendLegacyText( pFileImage, &FileLength, pStudyFileContents -> pOtherAbnormalitiesCommentsText,
+						StudyFileTextLength( pStudyFileContents -> pOtherAbnormalitiesCommentsText ) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> PhysicianNotificationStatus, sizeof(unsigned long) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> Reserved2, sizeof(EDITED_DATE) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> DateOfRadiograph, sizeof(EDITED_DATE) );
+	AppendLegacyText( pFileImage, &FileLength, pStudyRecord -> Reserved1, sizeof( pStudyRecord -> Reserved1 ) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> TypeOfReading, sizeof(unsigned short) );
+	AppendLegacyText( pFileImage, &FileLength, pStudyRecord -> OtherTypeOfReading, sizeof( pStudyRecord -> OtherTypeOfReading ) );
+	AppendLegacyText( pFileImage, &FileLength, pStudyRecord -> FacilityIDNumber, sizeof( pStudyRecord -> FacilityIDNumber ) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> DateOfReading, sizeof(EDITED_DATE) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> bReportViewed, sizeof(BOOL) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> bReportApproved, sizeof(BOOL) );
+
+	// Record each study, followed by its series, each followed by its images.  Each list is
+	// preceded by its length and the length of its structure.
+	nStudies = 0;
+	pDiagnosticStudy = pStudyFileContents -> pDiagnosticStudyList;
+	while ( pDiagnosticStudy != 0 )
+		{
+		nStudies++;
+		pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
+		}
+	LengthInBytes = sizeof(DIAGNOSTIC_STUDY);
+	AppendLegacyField( pFileImage, &FileLength, &nStudies, sizeof(unsigned long) );
+	AppendLegacyField( pFileImage, &FileLength, &LengthInBytes, sizeof(unsigned long) );
+	pDiagnosticStudy = pStudyFileContents -> pDiagnosticStudyList;
+	while ( pDiagnosticStudy != 0 )
+		{
+		memcpy( &DiagnosticStudy, pDiagnosticStudy, sizeof(DIAGNOSTIC_STUDY) );
+		DiagnosticStudy.pDiagnosticSeriesList = 0;
+		DiagnosticStudy.pNextDiagnosticStudy = 0;
+		AppendLegacyField( pFileImage, &FileLength, &DiagnosticStudy, sizeof(DIAGNOSTIC_STUDY) );
+		nSeries = 0;
+		pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList;
+		while ( pDiagnosticSeries != 0 )
+			{
+			nSeries++;
+			pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
+			}
+		LengthInBytes = sizeof(DIAGNOSTIC_SERIES);
+		AppendLegacyField( pFileImage, &FileLength, &nSeries, sizeof(unsigned long) );
+		AppendLegacyField( pFileImage, &FileLength, &LengthInBytes, sizeof(unsigned long) );
+		pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList;
+		while ( pDiagnosticSeries != 0 )
+			{
+			memcpy( &DiagnosticSeries, pDiagnosticSeries, sizeof(DIAGNOSTIC_SERIES) );
+			DiagnosticSeries.pDiagnosticImageList = 0;
+			DiagnosticSeries.pNextDiagnosticSeries = 0;
+			AppendLegacyField( pFileImage, &FileLength, &DiagnosticSeries, sizeof(DIAGNOSTIC_SERIES) );
+			nImages = 0;
+			pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
+			while ( pDiagnosticImage != 0 )
+				{
+				nImages++;
+				pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
+				}
+			LengthInBytes = sizeof(DIAGNOSTIC_IMAGE);
+			AppendLegacyField( pFileImage, &FileLength, &nImages, sizeof(unsigned long) );
+			AppendLegacyField( pFileImage, &FileLength, &LengthInBytes, sizeof(unsigned long) );
+			pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
+			while ( pDiagnosticImage != 0 )
+				{
+				memcpy( &DiagnosticImage, pDiagnosticImage, sizeof(DIAGNOSTIC_IMAGE) );
+				DiagnosticImage.pNextDiagnosticImage = 0;
+				AppendLegacyField( pFileImage, &FileLength, &DiagnosticImage, sizeof(DIAGNOSTIC_IMAGE) );
+				pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
+				}
+			pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
+			}
+		pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
+		}
+
+	FileVersion = SDY_FILE_VERSION_LEGACY;
+	AppendLegacyField( pFileImage, &FileLength, &FileVersion, sizeof(unsigned long) );
+	memcpy( &ReaderInfo, &pStudyFileContents -> ReaderInfo, sizeof(READER_PERSONAL_INFO) );
+	ReaderInfo.pSignatureBitmap = 0;
+	AppendLegacyField( pFileImage, &FileLength, &ReaderInfo, sizeof(READER_PERSONAL_INFO) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyRecord -> bStudyWasPreviouslyInterpreted, sizeof(BOOL) );
+	AppendLegacyField( pFileImage, &FileLength, &pStudyFileContents -> ClientInfo, sizeof(CLIENT_INFO) );
+
+	return FileLength;
+}
+
+
+// Compose the memory image of a study file in the legacy layout, which earlier BViewer
+// versions read.  The caller frees the returned image.
+char *ComposeLegacyStudyFileImage( STUDY_FILE_CONTENTS *pStudyFileContents, size_t *pFileLength )
+{
+	char					*pFileImage;
+	size_t					FileLength;
+
+	FileLength = ComposeLegacyStudyFileData( pStudyFileContents, 0 );
+	pFileImage = (char*)malloc( FileLength );
+	if ( pFileImage != 0 )
+		{
+		ComposeLegacyStudyFileData( pStudyFileContents, pFileImage );
+		*pFileLength = FileLength;
+		}
+	else
+		*pFileLength = 0;
+
+	return pFileImage;
+}
+
+
+static BOOL ReadLegacyField( char *pFileImage, size_t FileLength, size_t *pFilePosition, void *pField, size_t FieldLength )
+{
+	BOOL					bNoError = TRUE;
+
+	bNoError = ( FieldLength <= FileLength - *pFilePosition );
+	if ( bNoError )
+		{
+		memcpy( pField, pFileImage + *pFilePosition, FieldLength );
+		*pFilePosition += FieldLength;
+		}
+
+	return bNoError;
+}
+
+
+// Read a free text field, preceded by its length, into a newly allocated string.
+static BOOL ReadLegacyText( char *pFileImage, size_t FileLength, size_t *pFilePosition, char **ppText )
+{
+	BOOL					bNoError = TRUE;
+	unsigned long			LengthInBytes;
+
+	bNoError = ReadLegacyField( pFileImage, FileLength, pFilePosition, &LengthInBytes, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ( LengthInBytes < DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH && LengthInBytes <= FileLength - *pFilePosition );
+	if ( bNoError )
+		{
+		*ppText = (char*)malloc( (size_t)LengthInBytes + 1 );
+		bNoError = ( *ppText != 0 );
+		}
+	if ( bNoError )
+		{
+		memcpy( *ppText, pFileImage + *pFilePosition, LengthInBytes );
+		( *ppText )[ LengthInBytes ] = '\0';
+		*pFilePosition += LengthInBytes;
+		}
+
+	return bNoError;
+}
+
+
+// Read a character array, preceded by its recorded length, truncating it if necessary to fit
+// the array and terminating it.
+static BOOL ReadLegacyString( char *pFileImage, size_t FileLength, size_t *pFilePosition, char *pString, size_t StringSize )
+{
+	BOOL					bNoError = TRUE;
+	unsigned long			LengthInBytes;
+	size_t					nCharacters;
+
+	bNoError = ReadLegacyField( pFileImage, FileLength, pFilePosition, &LengthInBytes, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ( LengthInBytes < DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH && LengthInBytes <= FileLength - *pFilePosition );
+	if ( bNoError )
+		{
+		nCharacters = strnlen( pFileImage + *pFilePosition, LengthInBytes );
+		if ( nCharacters >= StringSize )
+			nCharacters = StringSize - 1;
+		memcpy( pString, pFileImage + *pFilePosition, nCharacters );
+		pString[ nCharacters ] = '\0';
+		*pFilePosition += LengthInBytes;
+		}
+
+	return bNoError;
+}
+
+
+// Read a diagnostic study, with its series and their images, and append it to the list.  Each
+// structure is added to the list as soon as it is allocated, so that it is deallocated with
+// the list if the file is found to be damaged.
+static BOOL ReadLegacyDiagnosticStudy( char *pFileImage, size_t FileLength, size_t *pFilePosition, DIAGNOSTIC_STUDY **ppDiagnosticStudy )
+{
+	BOOL					bNoError = TRUE;
+	BOOL					bOlderSeriesWithoutManufacturer;
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
+	DIAGNOSTIC_SERIES		**ppDiagnosticSeries;
+	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		**ppDiagnosticImage;
+	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
+	unsigned long			nSeriesCount;
+	unsigned long			nSeries;
+	unsigned long			nImageCount;
+	unsigned long			nImage;
+	unsigned long			LengthInBytes;
+	size_t					SeriesLength;
+
+	pDiagnosticStudy = (DIAGNOSTIC_STUDY*)malloc( sizeof(DIAGNOSTIC_STUDY) );
+	bNoError = ( pDiagnosticStudy != 0 );
+	if ( bNoError )
+		{
+		*ppDiagnosticStudy = pDiagnosticStudy;
+		bNoError = ReadLegacyField( pFileImage, FileLength, pFilePosition, pDiagnosticStudy, sizeof(DIAGNOSTIC_STUDY) );
+		pDiagnosticStudy -> pDiagnosticSeriesList = 0;
+		pDiagnosticStudy -> pNextDiagnosticStudy = 0;
+		}
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, pFilePosition, &nSeriesCount, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, pFilePosition, &LengthInBytes, sizeof(unsigned long) );
+	if ( bNoError )
+		{
+		// Series recorded by the earliest versions lack the manufacturer.
+		bOlderSeriesWithoutManufacturer = ( LengthInBytes == sizeof(DIAGNOSTIC_SERIES) - DICOM_ATTRIBUTE_UI_STRING_LENGTH );
+		bNoError = ( LengthInBytes == sizeof(DIAGNOSTIC_SERIES) || bOlderSeriesWithoutManufacturer );
+		SeriesLength = LengthInBytes;
+		}
+	ppDiagnosticSeries = &pDiagnosticStudy -> pDiagnosticSeriesList;
+	for ( nSeries = 0; bNoError && nSeries < nSeriesCount; nSeries++ )
+		{
+		pDiagnosticSeries = (DIAGNOSTIC_SERIES*)malloc( sizeof(DIAGNOSTIC_SERIES) );
+		bNoError = ( pDiagnosticSeries != 0 );
+		if ( bNoError )
+			{
+			*ppDiagnosticSeries = pDiagnosticSeries;
+			ppDiagnosticSeries = &pDiagnosticSeries -> pNextDiagnosticSeries;
+			bNoError = ReadLegacyField( pFileImage, FileLength, pFilePosition, pDiagnosticSeries, SeriesLength );
+			pDiagnosticSeries -> pDiagnosticImageList = 0;
+			pDiagnosticSeries -> pNextDiagnosticSeries = 0;
+			if ( bOlderSeriesWithoutManufacturer )
+				pDiagnosticSeries -> Manufacturer[ 0 ] = '\0';
+			}
+		if ( bNoError )
+			bNoError = ReadLegacyField( pFileImage, FileLength, pFilePosition, &nImageCount, sizeof(unsigned long) );
+		if ( bNoError )
+			bNoError = ( ReadLegacyField( pFileImage, FileLength, pFilePosition, &LengthInBytes, sizeof(unsigned long) ) &&
+							LengthInBytes == sizeof(DIAGNOSTIC_IMAGE) );
+		ppDiagnosticImage = &pDiagnosticSeries -> pDiagnosticImageList;
+		for ( nImage = 0; bNoError && nImage < nImageCount; nImage++ )
+			{
+			pDiagnosticImage = (DIAGNOSTIC_IMAGE*)malloc( sizeof(DIAGNOSTIC_IMAGE) );
+			bNoError = ( pDiagnosticImage != 0 );
+			if ( bNoError )
+				{
+				*ppDiagnosticImage = pDiagnosticImage;
+				ppDiagnosticImage = &pDiagnosticImage -> pNextDiagnosticImage;
+				bNoError = ReadLegacyField( pFileImage, FileLength, pFilePosition, pDiagnosticImage, sizeof(DIAGNOSTIC_IMAGE) );
+				pDiagnosticImage -> pNextDiagnosticImage = 0;
+				}
+			}
+		}
+
+	return bNoError;
+}
+
+
+// Restore the contents of a study from the memory image of a study file in the legacy layout,
+// as written by BViewer before SDY file version 4, or by ComposeLegacyStudyFileImage().  If the
+// file can't be restored, nothing is left allocated in the contents.
+BOOL RestoreLegacyStudyFileImage( char *pFileImage, size_t FileLength, STUDY_FILE_CONTENTS *pStudyFileContents )
+{
+	BOOL					bNoError = TRUE;
+	SDY_STUDY_RECORD		*pStudyRecord;
+	size_t					FilePosition;
+	DIAGNOSTIC_STUDY		**ppDiagnosticStudy;
+	unsigned long			nStudyCount;
+	unsigned long			nStudy;
+	unsigned long			LengthInBytes;
+	unsigned long			FileVersion;
+
+	memset( pStudyFileContents, '\0', sizeof(STUDY_FILE_CONTENTS) );
+	pStudyRecord = &pStudyFileContents -> StudyRecord;
+	FilePosition = 0;
+	bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, pStudyRecord -> ReaderAddressed, DICOM_ATTRIBUTE_STRING_LENGTH );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, pStudyRecord -> PatientLastName, DICOM_ATTRIBUTE_STRING_LENGTH );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, pStudyRecord -> PatientFirstName, DICOM_ATTRIBUTE_STRING_LENGTH );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, pStudyRecord -> PatientID, DICOM_ATTRIBUTE_STRING_LENGTH );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> PatientsBirthDate, sizeof(EDITED_DATE) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, pStudyRecord -> PatientsSex, 4 );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, pStudyRecord -> PatientComments, DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> Reserved, sizeof(double) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> Reserved, sizeof(double) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> GammaSetting, sizeof(double) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> WindowCenter, sizeof(double) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> WindowWidth, sizeof(double) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> MaxGrayscaleValue, sizeof(double) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, pStudyRecord -> TimeStudyFirstOpened, 32 );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, pStudyRecord -> TimeReportApproved, 32 );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> nCurrentObjectID, sizeof(UINT) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> bImageQualityVisited, sizeof(BOOL) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> bParenchymalAbnormalitiesVisited, sizeof(BOOL) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> bPleuralAbnormalitiesVisited, sizeof(BOOL) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> bOtherAbnormalitiesVisited, sizeof(BOOL) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> AnyParenchymalAbnormalities, sizeof(char) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> AnyPleuralAbnormalities, sizeof(char) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> AnyOtherAbnormalities, sizeof(char) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ImageQuality, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedParenchymalAbnormalities, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedPleuralPlaqueSites, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedPleuralCalcificationSites, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedPlaqueExtent, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedPlaqueWidth, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedCostophrenicAngleObliteration, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedPleuralThickeningSites, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedThickeningCalcificationSites, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedThickeningExtent, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedThickeningWidth, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedOtherSymbols, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> ObservedOtherAbnormalities, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ReadLegacyText( pFileImage, FileLength, &FilePosition, &pStudyFileContents -> pImageDefectOtherText );
+	if ( bNoError )
+		bNoError = ReadLegacyText( pFileImage, FileLength, &FilePosition, &pStudyFileContents -> pOtherAbnormalitiesCommentsText );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> PhysicianNotificationStatus, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> Reserved2, sizeof(EDITED_DATE) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> DateOfRadiograph, sizeof(EDITED_DATE) );
+	if ( bNoError )
+		bNoError = ReadLegacyString( pFileImage, FileLength, &FilePosition, pStudyRecord -> Reserved1, sizeof( pStudyRecord -> Reserved1 ) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> TypeOfReading, sizeof(unsigned short) );
+	if ( bNoError )
+		bNoError = ReadLegacyString( pFileImage, FileLength, &FilePosition, pStudyRecord -> OtherTypeOfReading, sizeof( pStudyRecord -> OtherTypeOfReading ) );
+	if ( bNoError )
+		bNoError = ReadLegacyString( pFileImage, FileLength, &FilePosition, pStudyRecord -> FacilityIDNumber, sizeof( pStudyRecord -> FacilityIDNumber ) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> DateOfReading, sizeof(EDITED_DATE) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> bReportViewed, sizeof(BOOL) );
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> bReportApproved, sizeof(BOOL) );
+
+	// Read the list of studies for the current patient.
+	if ( bNoError )
+		bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &nStudyCount, sizeof(unsigned long) );
+	if ( bNoError )
+		bNoError = ( ReadLegacyField( pFileImage, FileLength, &FilePosition, &LengthInBytes, sizeof(unsigned long) ) &&
+						LengthInBytes == sizeof(DIAGNOSTIC_STUDY) );
+	ppDiagnosticStudy = &pStudyFileContents -> pDiagnosticStudyList;
+	for ( nStudy = 0; bNoError && nStudy < nStudyCount; nStudy++ )
+		{
+		bNoError = ReadLegacyDiagnosticStudy( pFileImage, FileLength, &FilePosition, ppDiagnosticStudy );
+		if ( bNoError )
+			ppDiagnosticStudy = &( *ppDiagnosticStudy ) -> pNextDiagnosticStudy;
+		}
+
+	// The files of the earliest versions end here.  Versions 1 and 2 recorded less of the
+	// reader information, and version 1 no client information.
+	if ( bNoError )
+		{
+		if ( FileLength - FilePosition < sizeof(unsigned long) )
+			FileVersion = 0;
+		else
+			ReadLegacyField( pFileImage, FileLength, &FilePosition, &FileVersion, sizeof(unsigned long) );
+		switch ( FileVersion )
+			{
+			case 1:
+			case 2:
+				bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyFileContents -> ReaderInfo, LEGACY_READER_INFO_LENGTH );
+				if ( bNoError )
+					bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> bStudyWasPreviouslyInterpreted, sizeof(BOOL) );
+				if ( bNoError && FileVersion == 2 )
+					bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyFileContents -> ClientInfo, sizeof(CLIENT_INFO) );
+				break;
+			case SDY_FILE_VERSION_LEGACY:
+				bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyFileContents -> ReaderInfo, sizeof(READER_PERSONAL_INFO) );
+				if ( bNoError )
+					bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyRecord -> bStudyWasPreviouslyInterpreted, sizeof(BOOL) );
+				if ( bNoError )
+					bNoError = ReadLegacyField( pFileImage, FileLength, &FilePosition, &pStudyFileContents -> ClientInfo, sizeof(CLIENT_INFO) );
+				break;
+			}
+		pStudyFileContents -> ReaderInfo.pSignatureBitmap = 0;
+		pStudyFileContents -> FileVersion = FileVersion;
+		}
+	if ( !bNoError )
+		DeallocateStudyFileContents( pStudyFileContents );
+
+	return bNoError;
+}
+
+
+void DeallocateDiagnosticStudyList( DIAGNOSTIC_STUDY *pDiagnosticStudyList )
+{
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
+	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
+	DIAGNOSTIC_STUDY		*pPrevDiagnosticStudy;
+	DIAGNOSTIC_SERIES		*pPrevDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		*pPrevDiagnosticImage;
+
+	pDiagnosticStudy = pDiagnosticStudyList;
+	while ( pDiagnosticStudy != 0 )
+		{
+		pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList;
+		while ( pDiagnosticSeries != 0 )
+			{
+			pPrevDiagnosticSeries = pDiagnosticSeries;
+			pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
+			while ( pDiagnosticImage != 0 )
+				{
+				pPrevDiagnosticImage = pDiagnosticImage;
+				pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
+				free( pPrevDiagnosticImage );
+				}
+			pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
+			free( pPrevDiagnosticSeries );
+			}
+		pPrevDiagnosticStudy = pDiagnosticStudy;
+		pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
+		free( pPrevDiagnosticStudy );
+		}
+}
+
+
+// Deallocate the texts and diagnostic study list of restored study file contents.
+void DeallocateStudyFileContents( STUDY_FILE_CONTENTS *pStudyFileContents )
+{
+	if ( pStudyFileContents -> pImageDefectOtherText != 0 )
+		free( pStudyFileContents -> pImageDefectOtherText );
+	pStudyFileContents -> pImageDefectOtherText = 0;
+	if ( pStudyFileContents -> pOtherAbnormalitiesCommentsText != 0 )
+		free( pStudyFileContents -> pOtherAbnormalitiesCommentsText );
+	pStudyFileContents -> pOtherAbnormalitiesCommentsText = 0;
+	DeallocateDiagnosticStudyList( pStudyFileContents -> pDiagnosticStudyList );
+	pStudyFileContents -> pDiagnosticStudyList = 0;
+}
@@ -0,0 +1,238 @@
+// StudyFile.h : Defines the data structures recorded in the study (.sdy) files, and
+//  the functions that compose and restore the study files.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#pragma once
+
+#include "Module.h"
+#include "Configuration.h"
+#include "Abstract.h"
+
+
+typedef struct _DiagnosticImage
+	{
+	char						ImageType[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						InstanceNumber[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						InstanceCreationDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						InstanceCreationTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						ContentDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						ContentTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						AcquisitionNumber[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						AcquisitionDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						AcquisitionTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						SamplesPerPixel[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						PhotometricInterpretation[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						Rows[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						Columns[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						PixelAspectRatio[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						BitsAllocated[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						BitsStored[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						HighBit[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						PixelRepresentation[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						WindowCenter[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						WindowWidth[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						SOPInstanceUID[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
+	int							Reserved;
+	struct _DiagnosticImage		*pNextDiagnosticImage;
+	} DIAGNOSTIC_IMAGE;
+
+
+typedef struct _DiagnosticSeries
+	{
+	char						Modality[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						SeriesNumber[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						Laterality[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						SeriesDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						SeriesTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						ProtocolName[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						SeriesDescription[ DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH ];
+	char						BodyPartExamined[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						PatientPosition[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						PatientOrientation[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						SeriesInstanceUID[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
+	char						Manufacturer[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
+	DIAGNOSTIC_IMAGE			*pDiagnosticImageList;
+	struct _DiagnosticSeries	*pNextDiagnosticSeries;
+	} DIAGNOSTIC_SERIES;
+
+
+typedef struct _DiagnosticStudy
+	{
+	char						AccessionNumber[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						StudyDate[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						StudyTime[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						ReferringPhysiciansName[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						ReferringPhysiciansPhone[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						ResponsibleOrganization[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						InstitutionName[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						StudyID[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char						StudyDescription[ DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH ];
+	char						StudyInstanceUID[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];
+	DIAGNOSTIC_SERIES			*pDiagnosticSeriesList;
+	struct _DiagnosticStudy		*pNextDiagnosticStudy;
+	} DIAGNOSTIC_STUDY;
+
+
+typedef struct
+	{
+	SYSTEMTIME		Date;
+	BOOL			bDateHasBeenEdited;
+	} EDITED_DATE;
+
+
+// A study file begins with an SDY_FILE_HEADER, followed by a table of SDY_SECTION_ENTRY items
+// locating each section.  Each section is a contiguous array of fixed-length records, padded
+// to a multiple of 8 bytes.  The header, table entry and record lengths are all recorded in the
+// file, so that a later version can lengthen any of them by appending members, or add sections,
+// without making its files unreadable here.
+//
+// The records are composed member by member, following the member tables in StudyFile.cpp, so
+// that the file layout doesn't depend on the structure member alignment or the pointer size of
+// the build.  The header and section table entries are packed for the same reason.  Numbers are
+// stored in the little-endian byte order of the Windows platforms.  Version 4 files, whose
+// records were copied whole from memory, are not read.
+//
+// Before version 4, the study file was written field by field in the layout now composed by
+// ComposeLegacyStudyFileImage(), which earlier BViewer versions still read.
+#define SDY_FILE_SIGNATURE						"BVSTUDY"
+#define SDY_FILE_VERSION_LEGACY					3
+#define SDY_FILE_VERSION_SECTIONED				5
+
+#pragma pack( push, 1 )
+
+typedef struct
+	{
+	char			Signature[ 8 ];				// SDY_FILE_SIGNATURE, including the terminating null.
+	unsigned long	FileVersion;
+	unsigned long	HeaderLength;
+	unsigned long	SectionEntryLength;
+	unsigned long	nSections;
+	unsigned long	FileLength;
+	unsigned long	CRC;						// CRC-32 of everything following the header.
+	} SDY_FILE_HEADER;
+
+
+typedef struct
+	{
+	unsigned long	SectionID;
+						#define SDY_SECTION_STUDY						1
+						#define SDY_SECTION_IMAGE_DEFECT_TEXT			2
+						#define SDY_SECTION_OTHER_ABNORMALITIES_TEXT	3
+						#define SDY_SECTION_DIAGNOSTIC_STUDIES			4
+						#define SDY_SECTION_SERIES_COUNTS				5		// The number of series in each study.
+						#define SDY_SECTION_DIAGNOSTIC_SERIES			6
+						#define SDY_SECTION_IMAGE_COUNTS				7		// The number of images in each series.
+						#define SDY_SECTION_DIAGNOSTIC_IMAGES			8
+						#define SDY_SECTION_READER_INFO					9
+						#define SDY_SECTION_CLIENT_INFO					10
+						#define SDY_SECTION_COUNT						10
+	unsigned long	Offset;						// From the beginning of the file.
+	unsigned long	RecordLength;
+	unsigned long	nRecords;
+	} SDY_SECTION_ENTRY;
+
+#pragma pack( pop )
+
+
+// The single record of the SDY_SECTION_STUDY section.  It is written in the order of
+// StudyRecordMembers[] in StudyFile.cpp, where new members may only be appended.
+typedef struct
+	{
+	char			ReaderAddressed[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char			PatientLastName[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char			PatientFirstName[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char			PatientID[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	EDITED_DATE		PatientsBirthDate;
+	char			PatientsSex[ 4 ];
+	char			PatientComments[ DICOM_ATTRIBUTE_DESCRIPTIVE_STRING_LENGTH ];
+	double			Reserved;
+	double			GammaSetting;
+	double			WindowCenter;
+	double			WindowWidth;
+	double			MaxGrayscaleValue;
+	char			TimeStudyFirstOpened[ 32 ];
+	char			TimeReportApproved[ 32 ];
+	UINT			nCurrentObjectID;
+	BOOL			bImageQualityVisited;
+	BOOL			bParenchymalAbnormalitiesVisited;
+	BOOL			bPleuralAbnormalitiesVisited;
+	BOOL			bOtherAbnormalitiesVisited;
+	char			AnyParenchymalAbnormalities;
+	char			AnyPleuralAbnormalities;
+	char			AnyOtherAbnormalities;
+	unsigned long	ImageQuality;
+	unsigned long	ObservedParenchymalAbnormalities;
+	unsigned short	ObservedPleuralPlaqueSites;
+	unsigned short	ObservedPleuralCalcificationSites;
+	unsigned short	ObservedPlaqueExtent;
+	unsigned short	ObservedPlaqueWidth;
+	unsigned short	ObservedCostophrenicAngleObliteration;
+	unsigned short	ObservedPleuralThickeningSites;
+	unsigned short	ObservedThickeningCalcificationSites;
+	unsigned short	ObservedThickeningExtent;
+	unsigned short	ObservedThickeningWidth;
+	unsigned long	ObservedOtherSymbols;
+	unsigned long	ObservedOtherAbnormalities;
+	unsigned long	PhysicianNotificationStatus;
+	EDITED_DATE		Reserved2;
+	EDITED_DATE		DateOfRadiograph;
+	char			Reserved1[ 12 ];
+	unsigned short	TypeOfReading;
+	char			OtherTypeOfReading[ DICOM_ATTRIBUTE_STRING_LENGTH ];
+	char			FacilityIDNumber[ 10 ];
+	EDITED_DATE		DateOfReading;
+	BOOL			bReportViewed;
+	BOOL			bReportApproved;
+	BOOL			bStudyWasPreviouslyInterpreted;
+	} SDY_STUDY_RECORD;
+
+
+// Everything recorded in a study file, apart from the CStudy object it is restored into.
+// The text pointers may be zero for empty texts.
+typedef struct
+	{
+	unsigned long			FileVersion;
+	SDY_STUDY_RECORD		StudyRecord;
+	char					*pImageDefectOtherText;
+	char					*pOtherAbnormalitiesCommentsText;
+	DIAGNOSTIC_STUDY		*pDiagnosticStudyList;
+	READER_PERSONAL_INFO	ReaderInfo;
+	CLIENT_INFO				ClientInfo;
+	} STUDY_FILE_CONTENTS;
+
+
+
+// Function prototypes.
+//
+char				*ComposeStudyFileImage( STUDY_FILE_CONTENTS *pStudyFileContents, size_t *pFileLength );
+char				*ComposeLegacyStudyFileImage( STUDY_FILE_CONTENTS *pStudyFileContents, size_t *pFileLength );
+BOOL				RestoreStudyFileImage( char *pFileImage, size_t FileLength, STUDY_FILE_CONTENTS *pStudyFileContents );
+BOOL				RestoreLegacyStudyFileImage( char *pFileImage, size_t FileLength, STUDY_FILE_CONTENTS *pStudyFileContents );
+void				DeallocateDiagnosticStudyList( DIAGNOSTIC_STUDY *pDiagnosticStudyList );
+void				DeallocateStudyFileContents( STUDY_FILE_CONTENTS *pStudyFileContents );
+
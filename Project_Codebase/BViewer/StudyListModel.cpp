@@ -0,0 +1,806 @@
+// StudyListModel.cpp : Implements the rows of the study selection list, kept in display
+//  order for a list control that asks for each row as it is drawn.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include <ctype.h>
+#include "Module.h"
+#include "StudyListModel.h"
+
+
+// The list is brought up to date by reporting every image row in the study list between calls
+// to BeginStudyListUpdate() and EndStudyListUpdate().  A reported row that is already in the
+// list is left where it is unless its text has changed.  New rows are inserted in sorted order,
+// and rows that weren't reported are deleted, each in a number of steps that grows with the
+// logarithm of the number of rows.  The range of list positions affected is recorded, so that
+// only the rows on view that have changed need to be redrawn.
+
+
+static unsigned long HashStudyListUID( char *pSOPInstanceUID )
+{
+	unsigned long		HashValue;
+	unsigned char		*pChar;
+
+	HashValue = 2166136261UL;
+	for ( pChar = (unsigned char*)pSOPInstanceUID; *pChar != '\0'; pChar++ )
+		HashValue = ( HashValue ^ *pChar ) * 16777619UL;
+
+	return HashValue & ( STUDY_LIST_INDEX_SIZE - 1 );
+}
+
+
+static int GetSubtreeHeight( STUDY_LIST_ROW *pSubtree )
+{
+	return ( pSubtree != 0 ) ? pSubtree -> SubtreeHeight : 0;
+}
+
+
+static long GetSubtreeRowCount( STUDY_LIST_ROW *pSubtree )
+{
+	return ( pSubtree != 0 ) ? pSubtree -> nRowsInSubtree : 0;
+}
+
+
+static void UpdateSubtreeSize( STUDY_LIST_ROW *pSubtree )
+{
+	int					LeftHeight;
+	int					RightHeight;
+
+	LeftHeight = GetSubtreeHeight( pSubtree -> pLeftSubtree );
+	RightHeight = GetSubtreeHeight( pSubtree -> pRightSubtree );
+	pSubtree -> SubtreeHeight = 1 + ( ( LeftHeight > RightHeight ) ? LeftHeight : RightHeight );
+	pSubtree -> nRowsInSubtree = 1 + GetSubtreeRowCount( pSubtree -> pLeftSubtree ) + GetSubtreeRowCount( pSubtree -> pRightSubtree );
+}
+
+
+static STUDY_LIST_ROW *RotateSubtreeRight( STUDY_LIST_ROW *pSubtree )
+{
+	STUDY_LIST_ROW		*pNewSubtree;
+
+	pNewSubtree = pSubtree -> pLeftSubtree;
+	pSubtree -> pLeftSubtree = pNewSubtree -> pRightSubtree;
+	pNewSubtree -> pRightSubtree = pSubtree;
+	UpdateSubtreeSize( pSubtree );
+	UpdateSubtreeSize( pNewSubtree );
+
+	return pNewSubtree;
+}
+
+
+static STUDY_LIST_ROW *RotateSubtreeLeft( STUDY_LIST_ROW *pSubtree )
+{
+	STUDY_LIST_ROW		*pNewSubtree;
+
+	pNewSubtree = pSubtree -> pRightSubtree;
+	pSubtree -> pRightSubtree = pNewSubtree -> pLeftSubtree;
+	pNewSubtree -> pLeftSubtree = pSubtree;
+	UpdateSubtreeSize( pSubtree );
+	UpdateSubtreeSize( pNewSubtree );
+
+	return pNewSubtree;
+}
+
+
+// Restore the balance of a subtree after a row has been inserted or removed below it, so that
+// the heights of its two branches differ by no more than one.
+static STUDY_LIST_ROW *BalanceSubtree( STUDY_LIST_ROW *pSubtree )
+{
+	int					Imbalance;
+
+	UpdateSubtreeSize( pSubtree );
+	Imbalance = GetSubtreeHeight( pSubtree -> pLeftSubtree ) - GetSubtreeHeight( pSubtree -> pRightSubtree );
+	if ( Imbalance > 1 )
+		{
+		if ( GetSubtreeHeight( pSubtree -> pLeftSubtree -> pLeftSubtree ) < GetSubtreeHeight( pSubtree -> pLeftSubtree -> pRightSubtree ) )
+			pSubtree -> pLeftSubtree = RotateSubtreeLeft( pSubtree -> pLeftSubtree );
+		pSubtree = RotateSubtreeRight( pSubtree );
+		}
+	else if ( Imbalance < -1 )
+		{
+		if ( GetSubtreeHeight( pSubtree -> pRightSubtree -> pRightSubtree ) < GetSubtreeHeight( pSubtree -> pRightSubtree -> pLeftSubtree ) )
+			pSubtree -> pRightSubtree = RotateSubtreeRight( pSubtree -> pRightSubtree );
+		pSubtree = RotateSubtreeLeft( pSubtree );
+		}
+
+	return pSubtree;
+}
+
+
+// Rows with the same sort key keep the order in which they were added, whichever way the list
+// is sorted, so that every row has a single place in the list.
+static int CompareStudyListRows( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pRow1, STUDY_LIST_ROW *pRow2 )
+{
+	int					RowDifference;
+
+	RowDifference = strcmp( pRow1 -> pSortKey, pRow2 -> pSortKey );
+	if ( !pStudyListModel -> bSortAscending )
+		RowDifference = -RowDifference;
+	if ( RowDifference == 0 )
+		{
+		if ( pRow1 -> ArrivalSequence < pRow2 -> ArrivalSequence )
+			RowDifference = -1;
+		else if ( pRow1 -> ArrivalSequence > pRow2 -> ArrivalSequence )
+			RowDifference = 1;
+		}
+
+	return RowDifference;
+}
+
+
+static STUDY_LIST_ROW *InsertRowInSubtree( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pSubtree, STUDY_LIST_ROW *pRow )
+{
+	if ( pSubtree == 0 )
+		{
+		pRow -> pLeftSubtree = 0;
+		pRow -> pRightSubtree = 0;
+		pRow -> SubtreeHeight = 1;
+		pRow -> nRowsInSubtree = 1;
+		pSubtree = pRow;
+		}
+	else
+		{
+		if ( CompareStudyListRows( pStudyListModel, pRow, pSubtree ) < 0 )
+			pSubtree -> pLeftSubtree = InsertRowInSubtree( pStudyListModel, pSubtree -> pLeftSubtree, pRow );
+		else
+			pSubtree -> pRightSubtree = InsertRowInSubtree( pStudyListModel, pSubtree -> pRightSubtree, pRow );
+		pSubtree = BalanceSubtree( pSubtree );
+		}
+
+	return pSubtree;
+}
+
+
+static STUDY_LIST_ROW *RemoveFirstRowInSubtree( STUDY_LIST_ROW *pSubtree, STUDY_LIST_ROW **ppFirstRow )
+{
+	if ( pSubtree -> pLeftSubtree == 0 )
+		{
+		*ppFirstRow = pSubtree;
+		pSubtree = pSubtree -> pRightSubtree;
+		}
+	else
+		{
+		pSubtree -> pLeftSubtree = RemoveFirstRowInSubtree( pSubtree -> pLeftSubtree, ppFirstRow );
+		pSubtree = BalanceSubtree( pSubtree );
+		}
+
+	return pSubtree;
+}
+
+
+static STUDY_LIST_ROW *RemoveRowFromSubtree( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pSubtree, STUDY_LIST_ROW *pRow )
+{
+	int					RowDifference;
+	STUDY_LIST_ROW		*pNextRow;
+	STUDY_LIST_ROW		*pRightSubtree;
+
+	if ( pSubtree != 0 )
+		{
+		RowDifference = CompareStudyListRows( pStudyListModel, pRow, pSubtree );
+		if ( RowDifference < 0 )
+			{
+			pSubtree -> pLeftSubtree = RemoveRowFromSubtree( pStudyListModel, pSubtree -> pLeftSubtree, pRow );
+			pSubtree = BalanceSubtree( pSubtree );
+			}
+		else if ( RowDifference > 0 )
+			{
+			pSubtree -> pRightSubtree = RemoveRowFromSubtree( pStudyListModel, pSubtree -> pRightSubtree, pRow );
+			pSubtree = BalanceSubtree( pSubtree );
+			}
+		else if ( pSubtree -> pRightSubtree == 0 )
+			pSubtree = pSubtree -> pLeftSubtree;
+		else
+			{
+			// Put the row that follows in the list in place of the one removed.
+			pRightSubtree = RemoveFirstRowInSubtree( pSubtree -> pRightSubtree, &pNextRow );
+			pNextRow -> pLeftSubtree = pSubtree -> pLeftSubtree;
+			pNextRow -> pRightSubtree = pRightSubtree;
+			pSubtree = BalanceSubtree( pNextRow );
+			}
+		}
+
+	return pSubtree;
+}
+
+
+// Return the position of a row in the list, counting from zero.
+static long GetRowPosition( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pRow )
+{
+	long				nPosition;
+	STUDY_LIST_ROW		*pSubtree;
+	int					RowDifference;
+	BOOL				bRowFound;
+
+	nPosition = 0;
+	bRowFound = FALSE;
+	pSubtree = pStudyListModel -> pRootRow;
+	while ( pSubtree != 0 && !bRowFound )
+		{
+		RowDifference = CompareStudyListRows( pStudyListModel, pRow, pSubtree );
+		if ( RowDifference < 0 )
+			pSubtree = pSubtree -> pLeftSubtree;
+		else if ( RowDifference > 0 )
+			{
+			nPosition += GetSubtreeRowCount( pSubtree -> pLeftSubtree ) + 1;
+			pSubtree = pSubtree -> pRightSubtree;
+			}
+		else
+			{
+			nPosition += GetSubtreeRowCount( pSubtree -> pLeftSubtree );
+			bRowFound = TRUE;
+			}
+		}
+	if ( !bRowFound )
+		nPosition = -1;
+
+	return nPosition;
+}
+
+
+static void MarkDirtyRows( STUDY_LIST_MODEL *pStudyListModel, long nFirstRow, long nLastRow )
+{
+	if ( nFirstRow >= 0 && nLastRow >= nFirstRow )
+		{
+		if ( pStudyListModel -> nFirstDirtyRow < 0 || nFirstRow < pStudyListModel -> nFirstDirtyRow )
+			pStudyListModel -> nFirstDirtyRow = nFirstRow;
+		if ( nLastRow > pStudyListModel -> nLastDirtyRow )
+			pStudyListModel -> nLastDirtyRow = nLastRow;
+		}
+}
+
+
+// Set the lower case copy of the sort column text.  The previous key is kept if there isn't
+// memory for the new one.
+static BOOL SetRowSortKey( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pRow )
+{
+	BOOL				bNoError = TRUE;
+	char				*pSortKey;
+	char				*pChar;
+
+	pSortKey = _strdup( pRow -> ppColumnText[ pStudyListModel -> nSortColumn ] );
+	bNoError = ( pSortKey != 0 );
+	if ( bNoError )
+		{
+		for ( pChar = pSortKey; *pChar != '\0'; pChar++ )
+			*pChar = (char)tolower( (unsigned char)*pChar );
+		if ( pRow -> pSortKey != 0 )
+			free( pRow -> pSortKey );
+		pRow -> pSortKey = pSortKey;
+		}
+
+	return bNoError;
+}
+
+
+static BOOL SortKeyMatchesText( char *pSortKey, char *pText )
+{
+	while ( *pSortKey != '\0' && *pSortKey == (char)tolower( (unsigned char)*pText ) )
+		{
+		pSortKey++;
+		pText++;
+		}
+
+	return ( *pSortKey == '\0' && *pText == '\0' );
+}
+
+
+// Copy the column text into a single allocation, which replaces any text the row already has.
+static BOOL SetRowText( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pRow, char **ppColumnText )
+{
+	BOOL				bNoError = TRUE;
+	size_t				TextSize;
+	size_t				ColumnTextSize;
+	int					nColumn;
+	char				**ppNewColumnText;
+	char				*pText;
+
+	TextSize = pStudyListModel -> nColumns * sizeof(char*);
+	for ( nColumn = 0; nColumn < pStudyListModel -> nColumns; nColumn++ )
+		TextSize += strlen( ppColumnText[ nColumn ] ) + 1;
+	ppNewColumnText = (char**)malloc( TextSize );
+	bNoError = ( ppNewColumnText != 0 );
+	if ( bNoError )
+		{
+		pText = (char*)&ppNewColumnText[ pStudyListModel -> nColumns ];
+		for ( nColumn = 0; nColumn < pStudyListModel -> nColumns; nColumn++ )
+			{
+			ColumnTextSize = strlen( ppColumnText[ nColumn ] ) + 1;
+			memcpy( pText, ppColumnText[ nColumn ], ColumnTextSize );
+			ppNewColumnText[ nColumn ] = pText;
+			pText += ColumnTextSize;
+			}
+		if ( pRow -> ppColumnText != 0 )
+			free( pRow -> ppColumnText );
+		pRow -> ppColumnText = ppNewColumnText;
+		}
+
+	return bNoError;
+}
+
+
+static BOOL RowTextMatches( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pRow, char **ppColumnText )
+{
+	BOOL				bTextMatches;
+	int					nColumn;
+
+	bTextMatches = TRUE;
+	for ( nColumn = 0; nColumn < pStudyListModel -> nColumns && bTextMatches; nColumn++ )
+		bTextMatches = ( strcmp( pRow -> ppColumnText[ nColumn ], ppColumnText[ nColumn ] ) == 0 );
+
+	return bTextMatches;
+}
+
+
+static void DeleteRowContents( STUDY_LIST_ROW *pRow )
+{
+	if ( pRow -> ppColumnText != 0 )
+		free( pRow -> ppColumnText );
+	if ( pRow -> pSortKey != 0 )
+		free( pRow -> pSortKey );
+	free( pRow );
+}
+
+
+static void DeleteRowsInSubtree( STUDY_LIST_ROW *pSubtree )
+{
+	if ( pSubtree != 0 )
+		{
+		DeleteRowsInSubtree( pSubtree -> pLeftSubtree );
+		DeleteRowsInSubtree( pSubtree -> pRightSubtree );
+		DeleteRowContents( pSubtree );
+		}
+}
+
+
+// Find a row with the designated SOP instance UID.  During a list update, only the rows that
+// haven't yet been reported can be chosen, so that an image that is listed more than once is
+// matched to a different row each time.
+static STUDY_LIST_ROW *FindRowInIndex( STUDY_LIST_MODEL *pStudyListModel, char *pSOPInstanceUID, BOOL bUnreportedRowsOnly )
+{
+	STUDY_LIST_ROW		*pRow;
+
+	pRow = pStudyListModel -> pUIDIndex[ HashStudyListUID( pSOPInstanceUID ) ];
+	while ( pRow != 0 && ( strcmp( pRow -> ppColumnText[ pStudyListModel -> nUIDColumn ], pSOPInstanceUID ) != 0 ||
+								( bUnreportedRowsOnly && pRow -> UpdateGeneration == pStudyListModel -> UpdateGeneration ) ) )
+		pRow = pRow -> pNextRowInBucket;
+
+	return pRow;
+}
+
+
+static void RemoveRowFromIndex( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pRow )
+{
+	STUDY_LIST_ROW		**ppBucketLink;
+
+	ppBucketLink = &pStudyListModel -> pUIDIndex[ HashStudyListUID( pRow -> ppColumnText[ pStudyListModel -> nUIDColumn ] ) ];
+	while ( *ppBucketLink != 0 && *ppBucketLink != pRow )
+		ppBucketLink = &( *ppBucketLink ) -> pNextRowInBucket;
+	if ( *ppBucketLink == pRow )
+		*ppBucketLink = pRow -> pNextRowInBucket;
+	pRow -> pNextRowInBucket = 0;
+}
+
+
+static void RemoveStudyListRow( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pRow )
+{
+	long				nPosition;
+
+	nPosition = GetRowPosition( pStudyListModel, pRow );
+	pStudyListModel -> pRootRow = RemoveRowFromSubtree( pStudyListModel, pStudyListModel -> pRootRow, pRow );
+	RemoveRowFromIndex( pStudyListModel, pRow );
+	// The rows that followed move up one place, and the last place is vacated.
+	MarkDirtyRows( pStudyListModel, nPosition, pStudyListModel -> nRows - 1 );
+	pStudyListModel -> nRows--;
+	pStudyListModel -> nRowsDeleted++;
+	DeleteRowContents( pRow );
+}
+
+
+BOOL InitStudyListModel( STUDY_LIST_MODEL *pStudyListModel, int nColumns, int nSortColumn, BOOL bSortAscending )
+{
+	BOOL				bNoError = TRUE;
+
+	memset( pStudyListModel, 0, sizeof(STUDY_LIST_MODEL) );
+	bNoError = ( nColumns > 0 && nColumns <= MAX_STUDY_LIST_COLUMNS );
+	if ( bNoError )
+		{
+		pStudyListModel -> nColumns = nColumns;
+		pStudyListModel -> nUIDColumn = nColumns - 1;
+		pStudyListModel -> nSortColumn = ( nSortColumn >= 0 && nSortColumn < nColumns ) ? nSortColumn : 0;
+		pStudyListModel -> bSortAscending = bSortAscending;
+		pStudyListModel -> nFirstDirtyRow = -1;
+		pStudyListModel -> nLastDirtyRow = -1;
+		pStudyListModel -> pUIDIndex = (STUDY_LIST_ROW**)calloc( STUDY_LIST_INDEX_SIZE, sizeof(STUDY_LIST_ROW*) );
+		bNoError = ( pStudyListModel -> pUIDIndex != 0 );
+		}
+
+	return bNoError;
+}
+
+
+void CloseStudyListModel( STUDY_LIST_MODEL *pStudyListModel )
+{
+	DeleteRowsInSubtree( pStudyListModel -> pRootRow );
+	if ( pStudyListModel -> pUIDIndex != 0 )
+		free( pStudyListModel -> pUIDIndex );
+	memset( pStudyListModel, 0, sizeof(STUDY_LIST_MODEL) );
+	pStudyListModel -> nFirstDirtyRow = -1;
+	pStudyListModel -> nLastDirtyRow = -1;
+}
+
+
+void ClearStudyListModel( STUDY_LIST_MODEL *pStudyListModel )
+{
+	DeleteRowsInSubtree( pStudyListModel -> pRootRow );
+	pStudyListModel -> pRootRow = 0;
+	if ( pStudyListModel -> pUIDIndex != 0 )
+		memset( pStudyListModel -> pUIDIndex, 0, STUDY_LIST_INDEX_SIZE * sizeof(STUDY_LIST_ROW*) );
+	MarkDirtyRows( pStudyListModel, 0, pStudyListModel -> nRows - 1 );
+	pStudyListModel -> nRowsDeleted += pStudyListModel -> nRows;
+	pStudyListModel -> nRows = 0;
+}
+
+
+static void CollectRowsInSubtree( STUDY_LIST_ROW *pSubtree, STUDY_LIST_ROW **ppRows, long *pnRows )
+{
+	if ( pSubtree != 0 )
+		{
+		CollectRowsInSubtree( pSubtree -> pLeftSubtree, ppRows, pnRows );
+		ppRows[ ( *pnRows )++ ] = pSubtree;
+		CollectRowsInSubtree( pSubtree -> pRightSubtree, ppRows, pnRows );
+		}
+}
+
+
+// Re-sort the list on another column, or in the other direction.  The whole list is redrawn.
+BOOL SetStudyListSortOrder( STUDY_LIST_MODEL *pStudyListModel, int nSortColumn, BOOL bSortAscending )
+{
+	BOOL				bNoError = TRUE;
+	STUDY_LIST_ROW		**ppRows;
+	long				nRows;
+	long				nRow;
+
+	bNoError = ( nSortColumn >= 0 && nSortColumn < pStudyListModel -> nColumns );
+	if ( bNoError && ( nSortColumn != pStudyListModel -> nSortColumn || bSortAscending != pStudyListModel -> bSortAscending ) )
+		{
+		ppRows = 0;
+		if ( pStudyListModel -> nRows > 0 )
+			{
+			ppRows = (STUDY_LIST_ROW**)malloc( pStudyListModel -> nRows * sizeof(STUDY_LIST_ROW*) );
+			bNoError = ( ppRows != 0 );
+			}
+		if ( bNoError )
+			{
+			nRows = 0;
+			CollectRowsInSubtree( pStudyListModel -> pRootRow, ppRows, &nRows );
+			pStudyListModel -> pRootRow = 0;
+			pStudyListModel -> nSortColumn = nSortColumn;
+			pStudyListModel -> bSortAscending = bSortAscending;
+			for ( nRow = 0; nRow < nRows; nRow++ )
+				{
+				if ( !SetRowSortKey( pStudyListModel, ppRows[ nRow ] ) )
+					bNoError = FALSE;
+				pStudyListModel -> pRootRow = InsertRowInSubtree( pStudyListModel, pStudyListModel -> pRootRow, ppRows[ nRow ] );
+				}
+			MarkDirtyRows( pStudyListModel, 0, nRows - 1 );
+			}
+		if ( ppRows != 0 )
+			free( ppRows );
+		}
+
+	return bNoError;
+}
+
+
+BOOL AddStudyListRow( STUDY_LIST_MODEL *pStudyListModel, char **ppColumnText, BOOL bChecked )
+{
+	BOOL				bNoError = TRUE;
+	STUDY_LIST_ROW		*pRow;
+	unsigned long		HashValue;
+
+	pRow = (STUDY_LIST_ROW*)calloc( 1, sizeof(STUDY_LIST_ROW) );
+	bNoError = ( pRow != 0 );
+	bNoError = ( bNoError && SetRowText( pStudyListModel, pRow, ppColumnText ) );
+	bNoError = ( bNoError && SetRowSortKey( pStudyListModel, pRow ) );
+	if ( bNoError )
+		{
+		pRow -> ArrivalSequence = pStudyListModel -> NextArrivalSequence++;
+		pRow -> UpdateGeneration = pStudyListModel -> UpdateGeneration;
+		pRow -> bChecked = bChecked;
+		pRow -> bCheckRequested = bChecked;
+		pStudyListModel -> pRootRow = InsertRowInSubtree( pStudyListModel, pStudyListModel -> pRootRow, pRow );
+		HashValue = HashStudyListUID( pRow -> ppColumnText[ pStudyListModel -> nUIDColumn ] );
+		pRow -> pNextRowInBucket = pStudyListModel -> pUIDIndex[ HashValue ];
+		pStudyListModel -> pUIDIndex[ HashValue ] = pRow;
+		pStudyListModel -> nRows++;
+		pStudyListModel -> nRowsAdded++;
+		// The new row and those that follow it have changed places.
+		MarkDirtyRows( pStudyListModel, GetRowPosition( pStudyListModel, pRow ), pStudyListModel -> nRows - 1 );
+		}
+	else if ( pRow != 0 )
+		DeleteRowContents( pRow );
+
+	return bNoError;
+}
+
+
+BOOL DeleteStudyListRow( STUDY_LIST_MODEL *pStudyListModel, char *pSOPInstanceUID )
+{
+	STUDY_LIST_ROW		*pRow;
+
+	pRow = FindRowInIndex( pStudyListModel, pSOPInstanceUID, FALSE );
+	if ( pRow != 0 )
+		RemoveStudyListRow( pStudyListModel, pRow );
+
+	return ( pRow != 0 );
+}
+
+
+void BeginStudyListUpdate( STUDY_LIST_MODEL *pStudyListModel )
+{
+	pStudyListModel -> UpdateGeneration++;
+	pStudyListModel -> nRowsReported = 0;
+	pStudyListModel -> nRowsAdded = 0;
+	pStudyListModel -> nRowsChanged = 0;
+	pStudyListModel -> nRowsDeleted = 0;
+}
+
+
+// Report a row during a list update.  A row that isn't in the list is added.  A row whose text
+// has changed is redrawn in place, unless its sort column has changed, when it is moved.  The
+// check box is set as reported when the row is added, and whenever the reported setting
+// changes, but is otherwise left as the user has set it.
+BOOL UpdateStudyListRow( STUDY_LIST_MODEL *pStudyListModel, char **ppColumnText, BOOL bChecked )
+{
+	BOOL				bNoError = TRUE;
+	STUDY_LIST_ROW		*pRow;
+	long				nOldPosition;
+	long				nNewPosition;
+
+	pRow = FindRowInIndex( pStudyListModel, ppColumnText[ pStudyListModel -> nUIDColumn ], TRUE );
+	if ( pRow == 0 )
+		bNoError = AddStudyListRow( pStudyListModel, ppColumnText, bChecked );
+	else
+		{
+		pRow -> UpdateGeneration = pStudyListModel -> UpdateGeneration;
+		nOldPosition = -1;
+		if ( !RowTextMatches( pStudyListModel, pRow, ppColumnText ) )
+			{
+			nOldPosition = GetRowPosition( pStudyListModel, pRow );
+			if ( SortKeyMatchesText( pRow -> pSortKey, ppColumnText[ pStudyListModel -> nSortColumn ] ) )
+				{
+				bNoError = SetRowText( pStudyListModel, pRow, ppColumnText );
+				MarkDirtyRows( pStudyListModel, nOldPosition, nOldPosition );
+				}
+			else
+				{
+				// The rows between the old and the new positions move by one place.  The new text
+				// is kept in the same place if there isn't memory for it.
+				pStudyListModel -> pRootRow = RemoveRowFromSubtree( pStudyListModel, pStudyListModel -> pRootRow, pRow );
+				bNoError = ( SetRowText( pStudyListModel, pRow, ppColumnText ) && SetRowSortKey( pStudyListModel, pRow ) );
+				pStudyListModel -> pRootRow = InsertRowInSubtree( pStudyListModel, pStudyListModel -> pRootRow, pRow );
+				nNewPosition = GetRowPosition( pStudyListModel, pRow );
+				if ( nNewPosition < nOldPosition )
+					MarkDirtyRows( pStudyListModel, nNewPosition, nOldPosition );
+				else
+					MarkDirtyRows( pStudyListModel, nOldPosition, nNewPosition );
+				}
+			pStudyListModel -> nRowsChanged++;
+			}
+		if ( bChecked != pRow -> bCheckRequested )
+			{
+			pRow -> bChecked = bChecked;
+			pRow -> bCheckRequested = bChecked;
+			if ( nOldPosition < 0 )
+				{
+				nOldPosition = GetRowPosition( pStudyListModel, pRow );
+				MarkDirtyRows( pStudyListModel, nOldPosition, nOldPosition );
+				}
+			}
+		}
+	pStudyListModel -> nRowsReported++;
+
+	return bNoError;
+}
+
+
+static STUDY_LIST_ROW *FindUnreportedRowInSubtree( STUDY_LIST_MODEL *pStudyListModel, STUDY_LIST_ROW *pSubtree )
+{
+	STUDY_LIST_ROW		*pRow = 0;
+
+	if ( pSubtree != 0 )
+		{
+		if ( pSubtree -> UpdateGeneration != pStudyListModel -> UpdateGeneration )
+			pRow = pSubtree;
+		else
+			{
+			pRow = FindUnreportedRowInSubtree( pStudyListModel, pSubtree -> pLeftSubtree );
+			if ( pRow == 0 )
+				pRow = FindUnreportedRowInSubtree( pStudyListModel, pSubtree -> pRightSubtree );
+			}
+		}
+
+	return pRow;
+}
+
+
+// Delete the rows that weren't reported during the list update.  Nothing needs to be searched
+// when every row was reported, as when studies have only been added.
+void EndStudyListUpdate( STUDY_LIST_MODEL *pStudyListModel )
+{
+	STUDY_LIST_ROW		**ppRows;
+	STUDY_LIST_ROW		*pRow;
+	long				nRows;
+	long				nRow;
+	long				nUnreportedRows;
+
+	if ( pStudyListModel -> nRowsReported < pStudyListModel -> nRows )
+		{
+		ppRows = (STUDY_LIST_ROW**)malloc( pStudyListModel -> nRows * sizeof(STUDY_LIST_ROW*) );
+		if ( ppRows != 0 )
+			{
+			nRows = 0;
+			CollectRowsInSubtree( pStudyListModel -> pRootRow, ppRows, &nRows );
+			nUnreportedRows = 0;
+			for ( nRow = 0; nRow < nRows; nRow++ )
+				if ( ppRows[ nRow ] -> UpdateGeneration != pStudyListModel -> UpdateGeneration )
+					ppRows[ nUnreportedRows++ ] = ppRows[ nRow ];
+			// Remove them from the end of the list, so that fewer rows change places.
+			for ( nRow = nUnreportedRows - 1; nRow >= 0; nRow-- )
+				RemoveStudyListRow( pStudyListModel, ppRows[ nRow ] );
+			free( ppRows );
+			}
+		else
+			{
+			pRow = FindUnreportedRowInSubtree( pStudyListModel, pStudyListModel -> pRootRow );
+			while ( pRow != 0 )
+				{
+				RemoveStudyListRow( pStudyListModel, pRow );
+				pRow = FindUnreportedRowInSubtree( pStudyListModel, pStudyListModel -> pRootRow );
+				}
+			}
+		}
+}
+
+
+// Return the row at the designated position in the list, or a null pointer.
+STUDY_LIST_ROW *GetStudyListRow( STUDY_LIST_MODEL *pStudyListModel, long nRow )
+{
+	STUDY_LIST_ROW		*pSubtree;
+	STUDY_LIST_ROW		*pRow;
+	long				nRowsOnLeft;
+
+	pRow = 0;
+	pSubtree = pStudyListModel -> pRootRow;
+	if ( nRow < 0 || nRow >= pStudyListModel -> nRows )
+		pSubtree = 0;
+	while ( pSubtree != 0 && pRow == 0 )
+		{
+		nRowsOnLeft = GetSubtreeRowCount( pSubtree -> pLeftSubtree );
+		if ( nRow < nRowsOnLeft )
+			pSubtree = pSubtree -> pLeftSubtree;
+		else if ( nRow == nRowsOnLeft )
+			pRow = pSubtree;
+		else
+			{
+			nRow -= nRowsOnLeft + 1;
+			pSubtree = pSubtree -> pRightSubtree;
+			}
+		}
+
+	return pRow;
+}
+
+
+// Return the list position of the row for the designated image, or -1 if it isn't listed.
+long FindStudyListRow( STUDY_LIST_MODEL *pStudyListModel, char *pSOPInstanceUID )
+{
+	long				nPosition;
+	STUDY_LIST_ROW		*pRow;
+
+	nPosition = -1;
+	if ( pStudyListModel -> pUIDIndex != 0 )
+		{
+		pRow = FindRowInIndex( pStudyListModel, pSOPInstanceUID, FALSE );
+		if ( pRow != 0 )
+			nPosition = GetRowPosition( pStudyListModel, pRow );
+		}
+
+	return nPosition;
+}
+
+
+// Return the text of a column of the row at the designated list position.  Never returns a
+// null pointer.
+char *GetStudyListRowText( STUDY_LIST_MODEL *pStudyListModel, long nRow, int nColumn )
+{
+	char				*pText = "";
+	STUDY_LIST_ROW		*pRow;
+
+	pRow = GetStudyListRow( pStudyListModel, nRow );
+	if ( pRow != 0 && nColumn >= 0 && nColumn < pStudyListModel -> nColumns )
+		pText = pRow -> ppColumnText[ nColumn ];
+
+	return pText;
+}
+
+
+BOOL GetStudyListRowCheck( STUDY_LIST_MODEL *pStudyListModel, long nRow )
+{
+	STUDY_LIST_ROW		*pRow;
+
+	pRow = GetStudyListRow( pStudyListModel, nRow );
+
+	return ( pRow != 0 && pRow -> bChecked );
+}
+
+
+void SetStudyListRowCheck( STUDY_LIST_MODEL *pStudyListModel, long nRow, BOOL bChecked )
+{
+	STUDY_LIST_ROW		*pRow;
+
+	pRow = GetStudyListRow( pStudyListModel, nRow );
+	if ( pRow != 0 && pRow -> bChecked != bChecked )
+		{
+		pRow -> bChecked = bChecked;
+		MarkDirtyRows( pStudyListModel, nRow, nRow );
+		}
+}
+
+
+static void ClearChecksInSubtree( STUDY_LIST_ROW *pSubtree )
+{
+	if ( pSubtree != 0 )
+		{
+		pSubtree -> bChecked = FALSE;
+		ClearChecksInSubtree( pSubtree -> pLeftSubtree );
+		ClearChecksInSubtree( pSubtree -> pRightSubtree );
+		}
+}
+
+
+void ClearStudyListRowChecks( STUDY_LIST_MODEL *pStudyListModel )
+{
+	ClearChecksInSubtree( pStudyListModel -> pRootRow );
+	MarkDirtyRows( pStudyListModel, 0, pStudyListModel -> nRows - 1 );
+}
+
+
+// Report the range of list positions that have changed since the last call, and start
+// recording again.  The range may extend past the end of the list, where rows were removed.
+BOOL TakeStudyListDirtyRows( STUDY_LIST_MODEL *pStudyListModel, long *pnFirstDirtyRow, long *pnLastDirtyRow )
+{
+	BOOL				bRowsAreDirty;
+
+	bRowsAreDirty = ( pStudyListModel -> nFirstDirtyRow >= 0 );
+	*pnFirstDirtyRow = pStudyListModel -> nFirstDirtyRow;
+	*pnLastDirtyRow = pStudyListModel -> nLastDirtyRow;
+	pStudyListModel -> nFirstDirtyRow = -1;
+	pStudyListModel -> nLastDirtyRow = -1;
+
+	return bRowsAreDirty;
+}
+
@@ -0,0 +1,101 @@
+// StudyListModel.h : Defines the rows of the study selection list, kept in display order
+//  for a list control that asks for each row as it is drawn.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#pragma once
+
+#include "Module.h"
+
+
+#define MAX_STUDY_LIST_COLUMNS				30
+
+// The number of hash buckets in the SOP instance UID index.  Must be a power of 2.
+#define STUDY_LIST_INDEX_SIZE				65536
+
+
+// Each row holds the text of its columns, and a lower case copy of the sort column text, so that
+// rows are compared without regard to case by a plain string comparison.  The rows are the
+// nodes of a balanced tree in display order.  Each node counts the rows in its subtree, so that
+// a row can be found by its position in the list, and a position found for a row, in a number
+// of steps that grows with the logarithm of the number of rows.
+typedef struct _STUDY_LIST_ROW
+	{
+	char					**ppColumnText;			// The column text pointers, followed by the text, in one allocation.
+	char					*pSortKey;
+	unsigned long			ArrivalSequence;		// Orders rows with the same sort key, oldest first.
+	unsigned long			UpdateGeneration;		// The list update in which the row was last reported.
+	BOOL					bChecked;				// The row's check box.
+	BOOL					bCheckRequested;		// The check box setting last reported by the list update.
+	struct _STUDY_LIST_ROW	*pLeftSubtree;
+	struct _STUDY_LIST_ROW	*pRightSubtree;
+	int						SubtreeHeight;
+	long					nRowsInSubtree;
+	struct _STUDY_LIST_ROW	*pNextRowInBucket;		// The next row in the same UID index bucket.
+	} STUDY_LIST_ROW;
+
+
+typedef struct
+	{
+	int						nColumns;
+	int						nUIDColumn;				// The column holding the SOP instance UID, which identifies the row.
+	int						nSortColumn;
+	BOOL					bSortAscending;
+	STUDY_LIST_ROW			*pRootRow;
+	STUDY_LIST_ROW			**pUIDIndex;			// The first row in each hash bucket.
+	long					nRows;
+	unsigned long			NextArrivalSequence;
+	unsigned long			UpdateGeneration;
+	long					nRowsReported;			// The rows reported in the current list update.
+	long					nFirstDirtyRow;			// The range of list positions that need to be redrawn,
+	long					nLastDirtyRow;			//  or -1 if none do.
+	long					nRowsAdded;				// The changes made by the last list update.
+	long					nRowsChanged;
+	long					nRowsDeleted;
+	} STUDY_LIST_MODEL;
+
+
+
+// Function prototypes.
+//
+BOOL				InitStudyListModel( STUDY_LIST_MODEL *pStudyListModel, int nColumns, int nSortColumn, BOOL bSortAscending );
+void				CloseStudyListModel( STUDY_LIST_MODEL *pStudyListModel );
+void				ClearStudyListModel( STUDY_LIST_MODEL *pStudyListModel );
+BOOL				SetStudyListSortOrder( STUDY_LIST_MODEL *pStudyListModel, int nSortColumn, BOOL bSortAscending );
+BOOL				AddStudyListRow( STUDY_LIST_MODEL *pStudyListModel, char **ppColumnText, BOOL bChecked );
+BOOL				DeleteStudyListRow( STUDY_LIST_MODEL *pStudyListModel, char *pSOPInstanceUID );
+void				BeginStudyListUpdate( STUDY_LIST_MODEL *pStudyListModel );
+BOOL				UpdateStudyListRow( STUDY_LIST_MODEL *pStudyListModel, char **ppColumnText, BOOL bChecked );
+void				EndStudyListUpdate( STUDY_LIST_MODEL *pStudyListModel );
+STUDY_LIST_ROW		*GetStudyListRow( STUDY_LIST_MODEL *pStudyListModel, long nRow );
+long				FindStudyListRow( STUDY_LIST_MODEL *pStudyListModel, char *pSOPInstanceUID );
+char				*GetStudyListRowText( STUDY_LIST_MODEL *pStudyListModel, long nRow, int nColumn );
+BOOL				GetStudyListRowCheck( STUDY_LIST_MODEL *pStudyListModel, long nRow );
+void				SetStudyListRowCheck( STUDY_LIST_MODEL *pStudyListModel, long nRow, BOOL bChecked );
+void				ClearStudyListRowChecks( STUDY_LIST_MODEL *pStudyListModel );
+BOOL				TakeStudyListDirtyRows( STUDY_LIST_MODEL *pStudyListModel, long *pnFirstDirtyRow, long *pnLastDirtyRow );
+
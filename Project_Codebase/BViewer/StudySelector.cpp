@@ -29,6 +29,29 @@
 //
 // UPDATE HISTORY:
 //
+//	*[8] 10/19/2026 by agent
+//		The list control is a virtual list, which asks for the text, preview and check box of
+//		each row as it is drawn.  The rows are kept in display order by a study list model,
+//		which UpdatePatientList() brings up to date with the study list.  Only the rows that
+//		were added, deleted or changed are inserted or removed, each in a number of steps that
+//		grows with the logarithm of the number of rows, and only the rows on view that they
+//		affect are redrawn.  The list is no longer rebuilt and re-sorted for every update.
+//		The images are found in the list through the model's SOP instance UID index.
+//	*[7] 10/19/2026 by agent
+//		The row previews are read on a separate thread, and a placeholder is shown until each
+//		one is ready, so that scrolling isn't held up reading image files.  The previews are
+//		kept in a cache of limited size, indexed by SOP instance UID, and are saved in the
+//		image folder for the next session.
+//	*[6] 10/19/2026 by agent
+//		Each selection list row shows a reduced-size preview of its image.  The previews
+//		are read when the rows are first displayed, and are kept for reuse when the list
+//		is rebuilt.
+//	*[5] 10/19/2026 by agent
+//		Speeded up UpdatePatientList():  Redrawing is suspended while the list is rebuilt,
+//		the column formatting is classified once per update instead of once per cell, and
+//		the rows are sorted on saved copies of the sort column text instead of reading
+//		the text back from the list control for every comparison.  Corrected the row
+//		index used for checking edited studies.
 //	*[4] 11/3/2023 by Tom Atwood
 //		Replaced pCurrentReaderInfo with pBViewerCustomization -> m_ReaderInfo.
 //	*[3] 07/19/2023 by Tom Atwood
@@ -67,11 +90,27 @@ CStudySelector::CStudySelector()
 	m_SelectorHeading.m_pParentStudySelector = (void*)this;
 	m_nColumns = 0;
 	m_nColumnToSort = 0;
+	m_bStudyListModelStarted = FALSE;		// *[8]
+	memset( &m_StudyListModel, 0, sizeof(STUDY_LIST_MODEL) );		// *[8]
+	m_bThumbnailCacheStarted = FALSE;		// *[7]
+	memset( m_ThumbnailImageVersion, 0, sizeof(m_ThumbnailImageVersion) );		// *[7]
 }
 
 
 CStudySelector::~CStudySelector()
 {
+	char			CacheFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+
+	if ( m_bStudyListModelStarted )			// *[8]
+		CloseStudyListModel( &m_StudyListModel );
+	// *[7] Keep the previews for the next session.
+	if ( m_bThumbnailCacheStarted )
+		{
+		GetThumbnailCacheFileSpec( CacheFileSpec );
+		if ( !SaveThumbnailCache( CacheFileSpec ) )
+			LogMessage( "The image preview cache could not be saved.", MESSAGE_TYPE_SUPPLEMENTARY );
+		CloseThumbnailCache();
+		}
 }
 
 
@@ -82,6 +121,9 @@ BEGIN_MESSAGE_MAP( CStudySelector, CListCtrl )
 	ON_NOTIFY_REFLECT( NM_CLICK, OnNMClick )
 	ON_NOTIFY( HDN_ENDTRACKA, 0, OnHdnEndtrack )
 	ON_NOTIFY( HDN_ENDTRACKW, 0, OnHdnEndtrack )
+	ON_NOTIFY_REFLECT( LVN_GETDISPINFO, OnGetDisplayInfo )
+	ON_NOTIFY_REFLECT( LVN_KEYDOWN, OnListKeyDown )
+	ON_MESSAGE( WM_THUMBNAIL_READ, OnThumbnailRead )
 END_MESSAGE_MAP()
 
 
@@ -91,12 +133,30 @@ static BOOL		bSortAscending[ 22 ];			// Storage for the flags that toggle betwee
 int CStudySelector::OnCreate( LPCREATESTRUCT lpCreateStruct )
 {
 	int			nColumn;
+	char		CacheFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
 
 	SetBkColor( COLOR_PATIENT );
 	if ( CListCtrl::OnCreate( lpCreateStruct ) == -1 )
 		return -1;
 
 	m_SelectorHeading.SubclassHeaderCtrl( GetHeaderCtrl() );
+	// *[8] The check boxes of the virtual list are supplied by OnGetDisplayInfo().
+	SetCallbackMask( LVIS_STATEIMAGEMASK );
+	// *[6] Set up the image list for the row previews.  *[7] The image list holds the placeholder image,
+	// followed by one image for each thumbnail cache entry.
+	if ( m_ThumbnailImageList.Create( THUMBNAIL_DIMENSION, THUMBNAIL_DIMENSION, ILC_COLOR24, THUMBNAIL_CACHE_CAPACITY + 1, 0 ) &&
+				m_ThumbnailImageList.SetImageCount( THUMBNAIL_CACHE_CAPACITY + 1 ) && ReplaceThumbnailImage( 0, 0, 0, 0 ) )
+		{
+		SetImageList( &m_ThumbnailImageList, LVSIL_SMALL );
+		m_bThumbnailCacheStarted = InitThumbnailCache( ReadStudyListThumbnail, NotifyStudyListThumbnailRead, (void*)GetSafeHwnd() );
+		if ( m_bThumbnailCacheStarted )
+			{
+			GetThumbnailCacheFileSpec( CacheFileSpec );
+			LoadThumbnailCache( CacheFileSpec );
+			}
+		else
+			LogMessage( "The image preview reader could not be started.", MESSAGE_TYPE_SUPPLEMENTARY );
+		}
 
 	// Initialize the column sorting order flags.
 	bSortAscending[ 0 ] = TRUE;
@@ -198,101 +258,124 @@ LIST_FORMAT		ImageEmphasisListFormat =
 
 
 
-// Sorting is based on the values of ListCtrlItem.lParam = (DWORD_PTR)&pStudy -> m_PatientLastName.
-// This needs to be changed to ListCtrlItem.pszText = ListItemText.
-
-// The first two parameters are the row numbers of the items to be sorted.
-static int CALLBACK TextColumnSortComparator( LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort )
-{
-	int					nRow1;
-	int					nRow2;
-	int					ItemDifference = 0;			// *[2] Initialize return value.
-	char				Text1[ 256 ];
-	char				Text2[ 256 ];
-
-	CStudySelector* pStudySelector = (CStudySelector*) lParamSort;
-	if ( pStudySelector != 0 )
-		{
-		nRow1 = (int)lParam1;
-		nRow2 = (int)lParam2;
-		pStudySelector -> GetItemText( nRow1, pStudySelector -> m_nColumnToSort, Text1, 255 );		// *[2] Eliminated unreferenced returned text length.
-		pStudySelector -> GetItemText( nRow2, pStudySelector -> m_nColumnToSort, Text2, 255 );		// *[2] Eliminated unreferenced returned text length.
-	
-		
-		if ( bSortAscending[ pStudySelector -> m_nColumnToSort ] )
-			ItemDifference = _stricmp( Text1, Text2 );
-		else
-			ItemDifference = _stricmp( Text2, Text1 );
-		}
-
-	return ItemDifference;
-}
+// *[5] Column text formatting types, classified once per list update.
+#define COLUMN_TEXT_PLAIN			0
+#define COLUMN_TEXT_BIRTH_DATE		1
+#define COLUMN_TEXT_DATE_READ		2
+#define COLUMN_TEXT_STUDY_DATE		3
 
 
 void CStudySelector::UpdatePatientList()
 {
-	int						nItemIndex = 0;					// *[2] Initialized count.
+	BOOL					bNoError = TRUE;
 	int						nColumn;
 	LIST_ELEMENT			*pPatientListElement;
-	char					ListItemText[ 2048 ];
+	char					*pRowText;						// *[8] The text of every column of a row.
+	char					*pListItemText;					// *[8]
+	char					*pColumnText[ MAX_LIST_COLUMNS ];		// *[8]
 	char					DateText[ 2048 ];
-	LVITEM					ListCtrlItem;
 	CHeaderCtrl				*pHdrCtrl;
 	HDITEM					HeaderItem;
 	int						HeaderItemCount;
-	long					nImage;
 	CStudy					*pStudy;
 	char					*pListItemFieldValue;
 	SYSTEMTIME				*pDate;
+	LIST_FORMAT				*pNewListFormat;				// *[8]
 	LIST_COLUMN_FORMAT		*pColumnFormat;
 	char					*pDataStructure = 0;			// [2] Initialized pointer.
 	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
 	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
 	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
-	BOOL					bListSortedOK;
+	BOOL					bListRebuilt;					// *[8]
+	long					nFirstDirtyRow;					// *[8]
+	long					nLastDirtyRow;					// *[8]
+	char					SelectedSOPInstanceUID[ DICOM_ATTRIBUTE_UI_STRING_LENGTH ];		// *[8]
 	BOOL					bAssignStudyToCurrentReader;
 	BOOL					bStudyAetitleMatchesSomeReader;
 	LIST_ELEMENT			*pUserListElement;
 	READER_PERSONAL_INFO	*pSomeReaderInfo;
+	int						ColumnTextType[ MAX_LIST_COLUMNS ];			// *[5]
 
 	EnableWindow( FALSE );
-	DeleteAllItems();
-
-	pHdrCtrl = GetHeaderCtrl();
-	HeaderItemCount = pHdrCtrl -> GetItemCount();
-	// Delete all of the current header items.
-	for ( nColumn = HeaderItemCount - 1; nColumn >= 0; nColumn-- )
-		DeleteColumn( nColumn );
-
 	// Set up the data columns.
+	pNewListFormat = m_pListFormat;
 	switch ( pBViewerCustomization -> m_StudyInformationDisplayEmphasis )
 		{
 		case INFO_EMPHASIS_PATIENT:
-			m_pListFormat = &PatientEmphasisListFormat;
+			pNewListFormat = &PatientEmphasisListFormat;
 			break;
 		case INFO_EMPHASIS_STUDY:
-			m_pListFormat = &StudyEmphasisListFormat;
+			pNewListFormat = &StudyEmphasisListFormat;
 			break;
 		case INFO_EMPHASIS_SERIES:
-			m_pListFormat = &SeriesEmphasisListFormat;
+			pNewListFormat = &SeriesEmphasisListFormat;
 			break;
 		case INFO_EMPHASIS_IMAGE:
-			m_pListFormat = &ImageEmphasisListFormat;
+			pNewListFormat = &ImageEmphasisListFormat;
 			break;
 		}
-	// Build the header structure.
+	// *[8] Note the selected image, so that it can be selected again wherever its row ends up.
+	SelectedSOPInstanceUID[ 0 ] = '\0';
+	if ( m_nCurrentlySelectedItem >= 0 )
+		strncpy_s( SelectedSOPInstanceUID, DICOM_ATTRIBUTE_UI_STRING_LENGTH, GetRowSOPInstanceUID( m_nCurrentlySelectedItem ), _TRUNCATE );
+	// *[8] The columns and the rows are only replaced when the display emphasis changes.
+	bListRebuilt = ( pNewListFormat != m_pListFormat || !m_bStudyListModelStarted );
+	if ( bListRebuilt )
+		{
+		SetRedraw( FALSE );													// *[5] Don't repaint as the columns are replaced.
+		SetItemCountEx( 0 );
+		pHdrCtrl = GetHeaderCtrl();
+		HeaderItemCount = pHdrCtrl -> GetItemCount();
+		// Delete all of the current header items.
+		for ( nColumn = HeaderItemCount - 1; nColumn >= 0; nColumn-- )
+			DeleteColumn( nColumn );
+		m_pListFormat = pNewListFormat;
+		// Build the header structure.
+		for ( nColumn = 0; nColumn < (int)m_pListFormat -> nColumns; nColumn++ )
+			{
+			pColumnFormat = &m_pListFormat -> ColumnFormatArray[ nColumn ];
+			InsertColumn( nColumn, pColumnFormat -> pColumnTitle, LVCFMT_LEFT, pColumnFormat -> ColumnWidth, nColumn );
+			memset( &HeaderItem, 0, sizeof( HDITEM ));
+			HeaderItem.mask = HDI_FORMAT;
+			HeaderItem.fmt =  HDF_LEFT | HDF_STRING | HDF_OWNERDRAW;
+			pHdrCtrl -> SetItem( nColumn, &HeaderItem );
+			}
+		if ( m_nColumnToSort >= (int)m_pListFormat -> nColumns )
+			m_nColumnToSort = 0;
+		if ( m_bStudyListModelStarted )
+			CloseStudyListModel( &m_StudyListModel );
+		m_bStudyListModelStarted = InitStudyListModel( &m_StudyListModel, (int)m_pListFormat -> nColumns, m_nColumnToSort, bSortAscending[ m_nColumnToSort ] );
+		bNoError = m_bStudyListModelStarted;
+		}
+	else if ( !SetStudyListSortOrder( &m_StudyListModel, m_nColumnToSort, bSortAscending[ m_nColumnToSort ] ) )
+		LogMessage( "An error occurred sorting the patient list.", MESSAGE_TYPE_SUPPLEMENTARY );	// *[2]
 	for ( nColumn = 0; nColumn < (int)m_pListFormat -> nColumns; nColumn++ )
 		{
 		pColumnFormat = &m_pListFormat -> ColumnFormatArray[ nColumn ];
-		InsertColumn( nColumn, pColumnFormat -> pColumnTitle, LVCFMT_LEFT, pColumnFormat -> ColumnWidth, nColumn );
-		memset( &HeaderItem, 0, sizeof( HDITEM ));
-		HeaderItem.mask = HDI_FORMAT;
-		HeaderItem.fmt =  HDF_LEFT | HDF_STRING | HDF_OWNERDRAW;
-		pHdrCtrl -> SetItem( nColumn, &HeaderItem );
+		// *[5] Classify the column's text formatting here, rather than for every row.
+		if ( strcmp( pColumnFormat -> pColumnTitle, " Birth Date" ) == 0 )
+			ColumnTextType[ nColumn ] = COLUMN_TEXT_BIRTH_DATE;
+		else if ( strcmp( pColumnFormat -> pColumnTitle, " Date Read" ) == 0 )
+			ColumnTextType[ nColumn ] = COLUMN_TEXT_DATE_READ;
+		else if ( strcmp( pColumnFormat -> pColumnTitle, " Study Date" ) == 0 )
+			ColumnTextType[ nColumn ] = COLUMN_TEXT_STUDY_DATE;
+		else
+			ColumnTextType[ nColumn ] = COLUMN_TEXT_PLAIN;
+		}
+	pRowText = 0;
+	if ( bNoError )
+		{
+		pRowText = (char*)malloc( MAX_LIST_COLUMNS * 2048 );
+		bNoError = ( pRowText != 0 );
 		}
-	// Populate the subject study list display.
-	pPatientListElement = ThisBViewerApp.m_AvailableStudyList;
-	nImage = 0;
+	if ( bNoError )
+		{
+		// *[8] Report every image row to the study list model, which changes only the rows that differ.
+		BeginStudyListUpdate( &m_StudyListModel );
+		pPatientListElement = ThisBViewerApp.m_AvailableStudyList;
+		}
+	else
+		pPatientListElement = 0;
 	while( pPatientListElement != 0 )
 		{
 		pStudy = (CStudy*)pPatientListElement -> pItem;
@@ -333,18 +416,11 @@ void CStudySelector::UpdatePatientList()
 						pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
 						while ( pDiagnosticImage != 0 )
 							{
-							// Create a selection list row for this image.
+							// Compose the text of the selection list row for this image.
 							for ( nColumn = 0; nColumn < (int)m_pListFormat -> nColumns; nColumn++ )			// *[2] Removed unnecessary error test.
 								{
 								pColumnFormat = &m_pListFormat -> ColumnFormatArray[ nColumn ];
-								memset( &ListCtrlItem, 0, sizeof( LVITEM ) );
-								ListCtrlItem.mask = LVIF_TEXT | LVIF_PARAM;
-								if ( nColumn != 0 )
-									{
-									ListCtrlItem.iSubItem = nColumn;
-									ListCtrlItem.iItem = nItemIndex;
-									}
-								ListCtrlItem.cchTextMax = pColumnFormat -> ColumnWidth / 3;
+								pListItemText = &pRowText[ nColumn * 2048 ];								// *[8]
 								switch ( pColumnFormat -> DatabaseHierarchyLevel )
 									{
 									case ABSTRACT_LEVEL_PATIENT:
@@ -361,50 +437,43 @@ void CStudySelector::UpdatePatientList()
 										break;
 									}
 								pListItemFieldValue = (char*)( pDataStructure + pColumnFormat -> DataStructureOffset );
-								if ( strcmp( pColumnFormat -> pColumnTitle, " Birth Date" ) == 0 )
+								if ( ColumnTextType[ nColumn ] == COLUMN_TEXT_BIRTH_DATE )						// *[5]
 									{
 									// bDateHasBeenEdited is also set if a non-blank value was read from the Dicom data element.
 									if ( ( (EDITED_DATE*)pListItemFieldValue ) -> bDateHasBeenEdited )
 										{
 										pDate = &( (EDITED_DATE*)pListItemFieldValue ) -> Date;
-										_snprintf_s( ListItemText, 2048, _TRUNCATE, "%2u/%2u/%4u", pDate -> wMonth, pDate -> wDay, pDate -> wYear );	// *[2] Replaced sprintf() with _snprintf_s.
+										_snprintf_s( pListItemText, 2048, _TRUNCATE, "%2u/%2u/%4u", pDate -> wMonth, pDate -> wDay, pDate -> wYear );	// *[2] Replaced sprintf() with _snprintf_s.
 										}
 									else
-										strncpy_s( ListItemText, 2048, "  /  /    ", _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
+										strncpy_s( pListItemText, 2048, "  /  /    ", _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
 									}
-								else if ( strcmp( pColumnFormat -> pColumnTitle, " Date Read" ) == 0 )
+								else if ( ColumnTextType[ nColumn ] == COLUMN_TEXT_DATE_READ )					// *[5]
 									{
 									pDate = &( (EDITED_DATE*)pListItemFieldValue ) -> Date;
 									if ( pDate -> wYear > 1900 )
-										_snprintf_s( ListItemText, 2048, _TRUNCATE, "%4u/%2u/%2u %2u:%2u:%2u", pDate -> wYear, pDate -> wMonth, pDate -> wDay,	// *[2] Replaced sprintf() with _snprintf_s.
+										_snprintf_s( pListItemText, 2048, _TRUNCATE, "%4u/%2u/%2u %2u:%2u:%2u", pDate -> wYear, pDate -> wMonth, pDate -> wDay,	// *[2] Replaced sprintf() with _snprintf_s.
 																							pDate -> wHour, pDate -> wMinute, pDate -> wSecond );
 									else
-										strncpy_s( ListItemText, 2048, "  /  /    ", _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
+										strncpy_s( pListItemText, 2048, "  /  /    ", _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
 									}
-								else if ( strcmp( pColumnFormat -> pColumnTitle, " Study Date" ) == 0 )
+								else if ( ColumnTextType[ nColumn ] == COLUMN_TEXT_STUDY_DATE )					// *[5]
 									{
 									strncpy_s( DateText, 2048, (char*)( pDataStructure + pColumnFormat -> DataStructureOffset ), _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
 									if ( strlen( DateText ) > 0 )
 										{
-										_snprintf_s( ListItemText, 2048, _TRUNCATE, "%.4s/%.2s/%.2s", DateText, &DateText[ 4 ], &DateText[ 6 ] );	// *[2] Replaced sprintf() with _snprintf_s.
+										_snprintf_s( pListItemText, 2048, _TRUNCATE, "%.4s/%.2s/%.2s", DateText, &DateText[ 4 ], &DateText[ 6 ] );	// *[2] Replaced sprintf() with _snprintf_s.
 										}
 									else
-										strncpy_s( ListItemText, 2048, "  /  /    ", _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
+										strncpy_s( pListItemText, 2048, "  /  /    ", _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
 									}
 								else
-									strncpy_s( ListItemText, 2048, (char*)( pDataStructure + pColumnFormat -> DataStructureOffset ), _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
+									strncpy_s( pListItemText, 2048, (char*)( pDataStructure + pColumnFormat -> DataStructureOffset ), _TRUNCATE );		// *[1] Replaced strcpy with strncpy_s.
 
-								ListCtrlItem.pszText = ListItemText;
-								// Specify the sorting parameter.
-								ListCtrlItem.lParam = (DWORD_PTR)&pStudy -> m_PatientLastName;
-								if ( nColumn == 0 )
-									nItemIndex = InsertItem( &ListCtrlItem );			// Insert a new row item.
-								else
-									SetItemText( nItemIndex, nColumn, ListItemText );	// Modify this row to specify data for another column.
+								pColumnText[ nColumn ] = pListItemText;										// *[8]
 								}			// ...loop to next column for this selection list row.
-							if ( pStudy -> m_bStudyHasBeenEdited )
-								SetCheck( nImage, TRUE );
-							nImage++;
+							if ( bNoError )
+								bNoError = UpdateStudyListRow( &m_StudyListModel, pColumnText, pStudy -> m_bStudyHasBeenEdited );		// *[8]
 							pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
 							}
 						pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
@@ -415,13 +484,33 @@ void CStudySelector::UpdatePatientList()
 			}
 		pPatientListElement = pPatientListElement -> pNextListElement;
 		}
-	// Sort the items according to the selected column.
-	bListSortedOK = SortItemsEx( TextColumnSortComparator, (LPARAM)this );
-	if ( !bListSortedOK )																			// *[2] Added error response.
-		LogMessage( "An error occurred sorting the patient list.", MESSAGE_TYPE_SUPPLEMENTARY );	// *[2]
+	if ( pRowText != 0 )
+		{
+		// *[8] Delete the rows of the images that are no longer listed.  If a row couldn't be
+		// reported, the rest are left for the next update.
+		if ( bNoError )
+			EndStudyListUpdate( &m_StudyListModel );
+		free( pRowText );
+		}
+	if ( !bNoError )
+		LogMessage( "An error occurred updating the patient list.", MESSAGE_TYPE_SUPPLEMENTARY );
 
+	// *[8] Tell the list control how many rows there are, without scrolling or repainting the
+	// rows on view that haven't changed.
+	SetItemCountEx( ( m_bStudyListModelStarted ) ? (int)m_StudyListModel.nRows : 0, LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL );
+	if ( bListRebuilt )
+		{
+		TakeStudyListDirtyRows( &m_StudyListModel, &nFirstDirtyRow, &nLastDirtyRow );		// Every row is redrawn.
+		SetRedraw( TRUE );													// *[5]
+		Invalidate();
+		}
+	else
+		RedrawChangedRows();
+	if ( strlen( SelectedSOPInstanceUID ) > 0 )
+		m_nCurrentlySelectedItem = (int)FindStudyListRow( &m_StudyListModel, SelectedSOPInstanceUID );
 	if (  m_nCurrentlySelectedItem >= 0 )
 		{
+		SetItemState( -1, 0, LVIS_FOCUSED | LVIS_SELECTED );				// *[8] The row may have moved.
 		SetItemState( m_nCurrentlySelectedItem, LVIS_FOCUSED | LVIS_SELECTED, LVIS_FOCUSED | LVIS_SELECTED );
 		EnsureVisible( m_nCurrentlySelectedItem, 0 );
 		}
@@ -429,31 +518,261 @@ void CStudySelector::UpdatePatientList()
 }
 
 
-// This provides an essential CListCtrl function that Microsoft omitted.
-int CStudySelector::GetCurrentlySelectedItem()
+// *[7] The preview images are read from the image files on the thumbnail cache's reader thread.
+// The image file for the designated SOP instance UID is in the image folder.
+static BOOL ReadStudyListThumbnail( char *pSOPInstanceUID, unsigned long MaxThumbnailDimension, unsigned char **ppThumbnailData,
+									unsigned long *pThumbnailWidth, unsigned long *pThumbnailHeight )
+{
+	char					ImageFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+
+	strncpy_s( ImageFileSpec, FULL_FILE_SPEC_STRING_LENGTH, BViewerConfiguration.ImageDirectory, _TRUNCATE );
+	if ( strlen( ImageFileSpec ) > 0 && ImageFileSpec[ strlen( ImageFileSpec ) - 1 ] != '\\' )
+		strncat_s( ImageFileSpec, FULL_FILE_SPEC_STRING_LENGTH, "\\", _TRUNCATE );
+	strncat_s( ImageFileSpec, FULL_FILE_SPEC_STRING_LENGTH, pSOPInstanceUID, _TRUNCATE );
+	strncat_s( ImageFileSpec, FULL_FILE_SPEC_STRING_LENGTH, ".png", _TRUNCATE );
+
+	return ReadPNGThumbnailImage( ImageFileSpec, MaxThumbnailDimension, ppThumbnailData, pThumbnailWidth, pThumbnailHeight );
+}
+
+
+// *[7] Ask the selection list to repaint when the reader thread has read a preview.  Only one
+// request is posted until the list responds, however many previews are read in the meantime.
+static volatile LONG		bThumbnailRepaintPosted = FALSE;
+
+static void NotifyStudyListThumbnailRead( void *pStudySelectorWindow )
 {
-	int				nItem;
-	int				nItems;
-	int				nSelectedItem;
-	BOOL			bSelectedItemFound;
-	unsigned int	ItemState;
-
-	bSelectedItemFound = FALSE;
-	nSelectedItem = -1;
-	nItem = 0;
-	nItems = GetItemCount();
-	while ( nItem < nItems && !bSelectedItemFound )
+	if ( InterlockedExchange( &bThumbnailRepaintPosted, TRUE ) == FALSE )
+		PostMessage( (HWND)pStudySelectorWindow, WM_THUMBNAIL_READ, 0, 0 );
+}
+
+
+// *[7] Repaint the list, so that the previews read since the last request replace their placeholders.
+LRESULT CStudySelector::OnThumbnailRead( WPARAM wParam, LPARAM lParam )
+{
+	InterlockedExchange( &bThumbnailRepaintPosted, FALSE );
+	Invalidate( FALSE );
+
+	return 0;
+}
+
+
+void CStudySelector::GetThumbnailCacheFileSpec( char *pCacheFileSpec )
+{
+	strncpy_s( pCacheFileSpec, FULL_FILE_SPEC_STRING_LENGTH, BViewerConfiguration.ImageDirectory, _TRUNCATE );
+	if ( strlen( pCacheFileSpec ) > 0 && pCacheFileSpec[ strlen( pCacheFileSpec ) - 1 ] != '\\' )
+		strncat_s( pCacheFileSpec, FULL_FILE_SPEC_STRING_LENGTH, "\\", _TRUNCATE );
+	strncat_s( pCacheFileSpec, FULL_FILE_SPEC_STRING_LENGTH, THUMBNAIL_CACHE_FILE_NAME, _TRUNCATE );
+}
+
+
+// *[6] Replace an image in the image list with a preview, centered in a square, 24-bit, top-down
+// bitmap.  *[7] Without preview pixels, the placeholder shown while a preview is being read is drawn.
+BOOL CStudySelector::ReplaceThumbnailImage( int nImage, unsigned char *pThumbnailData, unsigned long ThumbnailWidth, unsigned long ThumbnailHeight )
+{
+	BOOL					bNoError = TRUE;
+	BITMAPINFO				BitmapInfo;
+	HBITMAP					hBitmap;
+	unsigned char			*pBitmapBits;
+	unsigned long			BitmapRowBytes;
+	unsigned long			nRow;
+	unsigned long			nPixel;
+	unsigned char			*pBitmapPixel;
+	unsigned char			PixelValue;
+	unsigned long			LeftMargin;
+	unsigned long			TopMargin;
+	CBitmap					ThumbnailBitmap;
+
+	memset( &BitmapInfo, 0, sizeof(BITMAPINFO) );
+	BitmapInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	BitmapInfo.bmiHeader.biWidth = THUMBNAIL_DIMENSION;
+	BitmapInfo.bmiHeader.biHeight = -THUMBNAIL_DIMENSION;
+	BitmapInfo.bmiHeader.biPlanes = 1;
+	BitmapInfo.bmiHeader.biBitCount = 24;
+	BitmapInfo.bmiHeader.biCompression = BI_RGB;
+	pBitmapBits = 0;
+	hBitmap = CreateDIBSection( 0, &BitmapInfo, DIB_RGB_COLORS, (void**)&pBitmapBits, 0, 0 );
+	bNoError = ( hBitmap != 0 && pBitmapBits != 0 );
+	if ( bNoError )
 		{
-		ItemState = GetItemState( nItem, LVIS_SELECTED );
-		if ( ItemState == LVIS_SELECTED )
+		BitmapRowBytes = ( ( THUMBNAIL_DIMENSION * 3 ) + 3 ) & ~3;
+		memset( pBitmapBits, 0, BitmapRowBytes * THUMBNAIL_DIMENSION );
+		if ( pThumbnailData == 0 )
 			{
-			bSelectedItemFound = TRUE;
-			nSelectedItem = nItem;
+			// The placeholder is a gray frame.
+			ThumbnailWidth = THUMBNAIL_DIMENSION;
+			ThumbnailHeight = THUMBNAIL_DIMENSION;
 			}
-		nItem++;
+		LeftMargin = ( THUMBNAIL_DIMENSION - ThumbnailWidth ) / 2;
+		TopMargin = ( THUMBNAIL_DIMENSION - ThumbnailHeight ) / 2;
+		for ( nRow = 0; nRow < ThumbnailHeight; nRow++ )
+			{
+			pBitmapPixel = pBitmapBits + ( TopMargin + nRow ) * BitmapRowBytes + LeftMargin * 3;
+			for ( nPixel = 0; nPixel < ThumbnailWidth; nPixel++ )
+				{
+				if ( pThumbnailData != 0 )
+					PixelValue = pThumbnailData[ nRow * ThumbnailWidth + nPixel ];
+				else if ( nRow < 2 || nRow >= ThumbnailHeight - 2 || nPixel < 2 || nPixel >= ThumbnailWidth - 2 )
+					PixelValue = 0x80;
+				else
+					PixelValue = 0x30;
+				*pBitmapPixel++ = PixelValue;
+				*pBitmapPixel++ = PixelValue;
+				*pBitmapPixel++ = PixelValue;
+				}
+			}
+		// The image list keeps its own copy of the bitmap.
+		ThumbnailBitmap.Attach( hBitmap );
+		bNoError = m_ThumbnailImageList.Replace( nImage, &ThumbnailBitmap, (CBitmap*)0 );
+		ThumbnailBitmap.DeleteObject();
 		}
 
-	return nSelectedItem;
+	return bNoError;
+}
+
+
+// *[6] Return the image list index of the preview for the designated image.  *[7] The preview is
+// looked up in the thumbnail cache, which requests it from the reader thread if it hasn't been
+// read, so the user interface is never held up reading image files.  The placeholder is shown
+// until the preview is ready.  The image list image for a cache entry is only replaced when
+// the entry has been given a different preview.
+int CStudySelector::GetThumbnailImageIndex( char *pSOPInstanceUID )
+{
+	int						nImageListIndex;
+	THUMBNAIL				Thumbnail;
+	int						ThumbnailState;
+	int						nImage;
+
+	nImageListIndex = I_IMAGENONE;
+	if ( m_bThumbnailCacheStarted && m_ThumbnailImageList.GetSafeHandle() != 0 )
+		{
+		ThumbnailState = LookUpThumbnail( pSOPInstanceUID, &Thumbnail );
+		if ( ThumbnailState == THUMBNAIL_STATE_PENDING )
+			nImageListIndex = 0;
+		else if ( ThumbnailState == THUMBNAIL_STATE_READY )
+			{
+			nImage = Thumbnail.nCacheEntry + 1;
+			if ( m_ThumbnailImageVersion[ Thumbnail.nCacheEntry ] == Thumbnail.ContentVersion ||
+						ReplaceThumbnailImage( nImage, Thumbnail.PixelData, Thumbnail.ThumbnailWidth, Thumbnail.ThumbnailHeight ) )
+				{
+				m_ThumbnailImageVersion[ Thumbnail.nCacheEntry ] = Thumbnail.ContentVersion;
+				nImageListIndex = nImage;
+				}
+			}
+		}
+
+	return nImageListIndex;
+}
+
+
+// *[6] Supply the preview image for a list row, when it is displayed.  *[7] The image index isn't
+// retained by the list control, since the placeholder is replaced when the preview has been read,
+// and a cache entry may be reused for another image.  *[8] The text and the check box of each row
+// are also supplied from the study list model as the row is drawn.
+void CStudySelector::OnGetDisplayInfo( NMHDR *pNMHDR, LRESULT *pResult )
+{
+	NMLVDISPINFO			*pDisplayInfo;
+	int						nItem;
+
+	pDisplayInfo = (NMLVDISPINFO*)pNMHDR;
+	nItem = pDisplayInfo -> item.iItem;
+	if ( m_bStudyListModelStarted && nItem >= 0 && nItem < m_StudyListModel.nRows )
+		{
+		if ( ( pDisplayInfo -> item.mask & LVIF_TEXT ) != 0 && pDisplayInfo -> item.cchTextMax > 0 )
+			strncpy_s( pDisplayInfo -> item.pszText, pDisplayInfo -> item.cchTextMax,
+							GetStudyListRowText( &m_StudyListModel, nItem, pDisplayInfo -> item.iSubItem ), _TRUNCATE );
+		if ( ( pDisplayInfo -> item.mask & LVIF_IMAGE ) != 0 && pDisplayInfo -> item.iSubItem == 0 )
+			pDisplayInfo -> item.iImage = GetThumbnailImageIndex( GetRowSOPInstanceUID( nItem ) );
+		if ( ( pDisplayInfo -> item.mask & LVIF_STATE ) != 0 )
+			{
+			pDisplayInfo -> item.state = INDEXTOSTATEIMAGEMASK( GetStudyListRowCheck( &m_StudyListModel, nItem ) ? 2 : 1 );
+			pDisplayInfo -> item.stateMask = LVIS_STATEIMAGEMASK;
+			}
+		}
+
+	*pResult = 0;
+}
+
+
+// *[8] Return the SOP instance UID of the image listed in a row.  Never returns a null pointer.
+char *CStudySelector::GetRowSOPInstanceUID( int nItem )
+{
+	return GetStudyListRowText( &m_StudyListModel, nItem, m_StudyListModel.nUIDColumn );
+}
+
+
+// *[8] The virtual list control doesn't keep the check boxes.  They are kept by the study list model.
+BOOL CStudySelector::GetRowCheck( int nItem )
+{
+	return GetStudyListRowCheck( &m_StudyListModel, nItem );
+}
+
+
+void CStudySelector::ToggleRowCheck( int nItem )
+{
+	SetStudyListRowCheck( &m_StudyListModel, nItem, !GetStudyListRowCheck( &m_StudyListModel, nItem ) );
+	RedrawChangedRows();
+}
+
+
+void CStudySelector::ClearRowChecks()
+{
+	ClearStudyListRowChecks( &m_StudyListModel );
+	RedrawChangedRows();
+}
+
+
+// *[8] Redraw the rows on view that the study list model reports as having changed.  The model's
+// range may extend past the end of the list, when rows have been deleted, and the rows that
+// were vacated are then erased as well.
+void CStudySelector::RedrawChangedRows()
+{
+	long					nFirstDirtyRow;
+	long					nLastDirtyRow;
+	long					nTopRow;
+	long					nBottomRow;
+
+	if ( TakeStudyListDirtyRows( &m_StudyListModel, &nFirstDirtyRow, &nLastDirtyRow ) )
+		{
+		nTopRow = GetTopIndex();
+		nBottomRow = nTopRow + GetCountPerPage();
+		if ( nFirstDirtyRow < nTopRow )
+			nFirstDirtyRow = nTopRow;
+		if ( nLastDirtyRow > nBottomRow )
+			nLastDirtyRow = nBottomRow;
+		if ( nFirstDirtyRow <= nLastDirtyRow )
+			{
+			if ( nLastDirtyRow >= m_StudyListModel.nRows )
+				Invalidate( FALSE );
+			else
+				RedrawItems( (int)nFirstDirtyRow, (int)nLastDirtyRow );
+			}
+		}
+}
+
+
+// *[8] The space bar checks or unchecks the selected row.
+void CStudySelector::OnListKeyDown( NMHDR *pNMHDR, LRESULT *pResult )
+{
+	NMLVKEYDOWN				*pKeyDown;
+	int						nSelectedItem;
+
+	pKeyDown = (NMLVKEYDOWN*)pNMHDR;
+	if ( pKeyDown -> wVKey == VK_SPACE )
+		{
+		nSelectedItem = GetCurrentlySelectedItem();
+		if ( nSelectedItem >= 0 )
+			ToggleRowCheck( nSelectedItem );
+		}
+
+	*pResult = 0;
+}
+
+
+// This provides an essential CListCtrl function that Microsoft omitted.  *[8] The list control
+// finds the selected row, rather than each row being asked in turn.
+int CStudySelector::GetCurrentlySelectedItem()
+{
+	return GetNextItem( -1, LVNI_SELECTED );
 }
 
 
@@ -465,7 +784,6 @@ void CStudySelector::AutoSelectPatientItem( char *pSelectedSOPInstanceUID )
 	int						nListItem;
 	int						nListItems;
 	int						nSelectedItem;
-	CString					SOPInstanceUIDString;
 	RECT					SelectedItemRectangle;
 	RECT					SelectionListRectangleInScreenCoordinates;
 	double					ScreenWidth;
@@ -479,77 +797,64 @@ void CStudySelector::AutoSelectPatientItem( char *pSelectedSOPInstanceUID )
 	sprintf_s( Msg, FILE_PATH_STRING_LENGTH, "Automatically selecting image for viewing:  %s", pSelectedSOPInstanceUID );	// *[1] Replaced sprintf with sprintf_s.
 	LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
 	bSelectFirstItem = ( pSelectedSOPInstanceUID == 0 );
-	// Find the matching item from the list.
-	nListItem = 0;
+	// Find the matching item from the list.  *[8] The row is found through the study list model's index.
 	nListItems = GetItemCount();
-	bMatchingImageFound = FALSE;
-	while ( nListItem < nListItems && !bMatchingImageFound )
+	if ( bSelectFirstItem )
+		nListItem = ( nListItems > 0 ) ? 0 : -1;
+	else
+		nListItem = (int)FindStudyListRow( &m_StudyListModel, pSelectedSOPInstanceUID );
+	bMatchingImageFound = ( nListItem >= 0 );
+	if ( bMatchingImageFound )
 		{
-		if ( bSelectFirstItem )
+		nSelectedItem = GetCurrentlySelectedItem();
+		if ( nSelectedItem >= 0 )	// If there is a current selection
 			{
-			bMatchingImageFound = TRUE;
-			nListItem = 0;
+			// Deselect the currently selected image.
+			SetItemState( nSelectedItem, 0, LVIS_SELECTED );
 			}
-		else
+		// Select the matched item.
+		SetItemState( nListItem, LVIS_SELECTED, LVIS_SELECTED );
+		// This function is on the wrong thread for viewing the image.  To engage the
+		// viewing, Send a message that this item has been clicked.
+		EnsureVisible( nListItem, FALSE );									// *[8] The row must be on view to be clicked.
+		bNoError = GetItemRect( nListItem, &SelectedItemRectangle, LVIR_BOUNDS );
+		if ( bNoError )
 			{
-			SOPInstanceUIDString = GetItemText( nListItem, m_pListFormat -> nColumns - 1 );
-			if ( strcmp( (const char*)SOPInstanceUIDString, pSelectedSOPInstanceUID ) == 0 )
-				{
-				bMatchingImageFound = TRUE;
-				}
+			GetWindowRect( &SelectionListRectangleInScreenCoordinates );
+			OffsetRect( &SelectedItemRectangle, SelectionListRectangleInScreenCoordinates.left, SelectionListRectangleInScreenCoordinates.top );
+			sprintf_s( Msg, FILE_PATH_STRING_LENGTH, "Selected item %d rectangle:  %d, %d, %d, %d", nListItem, SelectedItemRectangle.left,
+														SelectedItemRectangle.top, SelectedItemRectangle.right, SelectedItemRectangle.bottom );	// *[1] Replaced sprintf with sprintf_s.
+			LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
+			ScreenWidth    = ::GetSystemMetrics( SM_CXSCREEN ) - 1; 
+			ScreenHeight  = ::GetSystemMetrics( SM_CYSCREEN ) - 1; 
+			// Generate a simulated mouse click in this rectangle.
+			MouseX = ( SelectedItemRectangle.left + 100 ) * (65535.0 / ScreenWidth );
+			MouseY = ( SelectedItemRectangle.top + ( SelectedItemRectangle. bottom - SelectedItemRectangle.top ) / 2.0 ) * (65535.0 / ScreenHeight );
+			_snprintf_s( Msg, FILE_PATH_STRING_LENGTH, _TRUNCATE, "Calculated mouse hit:  %d, %d", (int)MouseX, (int)MouseY );	// *[2] Replaced sprintf() with _snprintf_s.
+			LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
+			// Move the mouse to the specified point.
+			MouseInputSpecification.type = INPUT_MOUSE;
+			MouseInputSpecification.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
+			MouseInputSpecification.mi.dx = (long)MouseX;
+			MouseInputSpecification.mi.dy = (long)MouseY;
+			nMouseEventsGenerated = ::SendInput( 1, &MouseInputSpecification, sizeof(INPUT) );
+			if ( nMouseEventsGenerated != 1 )
+				LogMessage( "Mouse move error.", MESSAGE_TYPE_SUPPLEMENTARY );
+			// Simulate a left button press.
+			MouseInputSpecification.type = INPUT_MOUSE;
+			MouseInputSpecification.mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
+			nMouseEventsGenerated = ::SendInput( 1, &MouseInputSpecification, sizeof(INPUT) );
+			if ( nMouseEventsGenerated != 1 )
+				LogMessage( "Mouse left button down error.", MESSAGE_TYPE_SUPPLEMENTARY );
+			// Simulate a left button release.
+			MouseInputSpecification.type = INPUT_MOUSE;
+			MouseInputSpecification.mi.dwFlags = MOUSEEVENTF_LEFTUP;
+			nMouseEventsGenerated = ::SendInput( 1, &MouseInputSpecification, sizeof(INPUT) );
+			if ( nMouseEventsGenerated != 1 )
+				LogMessage( "Mouse left button release error.", MESSAGE_TYPE_SUPPLEMENTARY );
+			Invalidate();
+			UpdateWindow();
 			}
-		if ( bMatchingImageFound )
-			{
-			nSelectedItem = GetCurrentlySelectedItem();
-			if ( nSelectedItem >= 0 )	// If there is a current selection
-				{
-				// Deselect the currently selected image.
-				SetItemState( nSelectedItem, 0, LVIS_SELECTED );
-				}
-			// Select the matched item.
-			SetItemState( nListItem, LVIS_SELECTED, LVIS_SELECTED );
-			// This function is on the wrong thread for viewing the image.  To engage the
-			// viewing, Send a message that this item has been clicked.
-			bNoError = GetItemRect( nListItem, &SelectedItemRectangle, LVIR_BOUNDS );
-			if ( bNoError )
-				{
-				GetWindowRect( &SelectionListRectangleInScreenCoordinates );
-				OffsetRect( &SelectedItemRectangle, SelectionListRectangleInScreenCoordinates.left, SelectionListRectangleInScreenCoordinates.top );
-				sprintf_s( Msg, FILE_PATH_STRING_LENGTH, "Selected item %d rectangle:  %d, %d, %d, %d", nListItem, SelectedItemRectangle.left,
-															SelectedItemRectangle.top, SelectedItemRectangle.right, SelectedItemRectangle.bottom );	// *[1] Replaced sprintf with sprintf_s.
-				LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
-				ScreenWidth    = ::GetSystemMetrics( SM_CXSCREEN ) - 1; 
-				ScreenHeight  = ::GetSystemMetrics( SM_CYSCREEN ) - 1; 
-				// Generate a simulated mouse click in this rectangle.
-				MouseX = ( SelectedItemRectangle.left + 100 ) * (65535.0 / ScreenWidth );
-				MouseY = ( SelectedItemRectangle.top + ( SelectedItemRectangle. bottom - SelectedItemRectangle.top ) / 2.0 ) * (65535.0 / ScreenHeight );
-				_snprintf_s( Msg, FILE_PATH_STRING_LENGTH, _TRUNCATE, "Calculated mouse hit:  %d, %d", (int)MouseX, (int)MouseY );	// *[2] Replaced sprintf() with _snprintf_s.
-				LogMessage( Msg, MESSAGE_TYPE_SUPPLEMENTARY );
-				// Move the mouse to the specified point.
-				MouseInputSpecification.type = INPUT_MOUSE;
-				MouseInputSpecification.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
-				MouseInputSpecification.mi.dx = (long)MouseX;
-				MouseInputSpecification.mi.dy = (long)MouseY;
-				nMouseEventsGenerated = ::SendInput( 1, &MouseInputSpecification, sizeof(INPUT) );
-				if ( nMouseEventsGenerated != 1 )
-					LogMessage( "Mouse move error.", MESSAGE_TYPE_SUPPLEMENTARY );
-				// Simulate a left button press.
-				MouseInputSpecification.type = INPUT_MOUSE;
-				MouseInputSpecification.mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
-				nMouseEventsGenerated = ::SendInput( 1, &MouseInputSpecification, sizeof(INPUT) );
-				if ( nMouseEventsGenerated != 1 )
-					LogMessage( "Mouse left button down error.", MESSAGE_TYPE_SUPPLEMENTARY );
-				// Simulate a left button release.
-				MouseInputSpecification.type = INPUT_MOUSE;
-				MouseInputSpecification.mi.dwFlags = MOUSEEVENTF_LEFTUP;
-				nMouseEventsGenerated = ::SendInput( 1, &MouseInputSpecification, sizeof(INPUT) );
-				if ( nMouseEventsGenerated != 1 )
-					LogMessage( "Mouse left button release error.", MESSAGE_TYPE_SUPPLEMENTARY );
-				Invalidate();
-				UpdateWindow();
-				}
-			}
-		nListItem++;
 		}
 }
 
@@ -594,7 +899,7 @@ void CStudySelector::OnPatientItemSelected()
 		strncpy_s( ImagePath, FILE_PATH_STRING_LENGTH, BViewerConfiguration.ImageDirectory, _TRUNCATE );	// *[2] Replaced strncat with strncpy_s.
 		if ( ImagePath[ strlen( ImagePath ) - 1 ] != '\\' )
 			strncat_s( ImagePath, FILE_PATH_STRING_LENGTH, "\\", _TRUNCATE );								// *[2] Replaced strcat with strncat_s.
-		SubitemText = GetItemText( nSelectedItem, m_pListFormat -> nColumns - 1 );
+		SubitemText = GetRowSOPInstanceUID( nSelectedItem );											// *[8]
 		pAvailableStudyListElement = ThisBViewerApp.m_AvailableStudyList;
 		while ( pAvailableStudyListElement != 0 && !bMatchingDicomFileFound )
 			{
@@ -766,6 +1071,7 @@ void CStudySelector::OnNMClick( NMHDR *pNMHDR, LRESULT *pResult )
 	CHeaderCtrl			*pHdrCtrl;
 	HDHITTESTINFO		HitTestInfo;
 	int					nHeaderColumnClicked;
+	LVHITTESTINFO		ItemHitTestInfo;			// *[8]
 
 	lpnmlv = (LPNMLISTVIEW)pNMHDR;
 	m_SelectorHeading.GetItemRect( 0, &ColumnHeaderRect );
@@ -779,6 +1085,14 @@ void CStudySelector::OnNMClick( NMHDR *pNMHDR, LRESULT *pResult )
 		if ( nHeaderColumnClicked != -1 )
 			m_nColumnToSort = nHeaderColumnClicked;
 		}
+	// *[8] A click on a row's check box checks or unchecks the row.
+	if ( lpnmlv != 0 && lpnmlv -> iItem >= 0 )
+		{
+		ItemHitTestInfo.pt = lpnmlv -> ptAction;
+		ItemHitTestInfo.flags = 0;
+		if ( HitTest( &ItemHitTestInfo ) == lpnmlv -> iItem && ( ItemHitTestInfo.flags & LVHT_ONITEMSTATEICON ) != 0 )
+			ToggleRowCheck( lpnmlv -> iItem );
+		}
 	if ( lpnmlv != 0 && lpnmlv -> ptAction.x > 22 )
 		OnPatientItemSelected();
 
@@ -30,6 +30,8 @@
 #pragma once
 
 #include "SelectorHeading.h"
+#include "ThumbnailCache.h"
+#include "StudyListModel.h"
 
 typedef struct
 	{
@@ -39,7 +41,7 @@ typedef struct
 	long				DataStructureOffset;
 	} LIST_COLUMN_FORMAT;
 
-#define MAX_LIST_COLUMNS		30
+#define MAX_LIST_COLUMNS		MAX_STUDY_LIST_COLUMNS
 
 
 typedef struct
@@ -61,9 +63,22 @@ public:
 	LIST_FORMAT				*m_pListFormat;
 	int						m_nColumns;
 	int						m_nColumnToSort;
+	STUDY_LIST_MODEL		m_StudyListModel;			// The list rows, in display order.  The list control asks for each row as it is drawn.
+	BOOL					m_bStudyListModelStarted;
+	CImageList				m_ThumbnailImageList;		// The placeholder, then the image preview for each thumbnail cache entry.
+	unsigned long			m_ThumbnailImageVersion[ THUMBNAIL_CACHE_CAPACITY ];	// The cache entry contents in the image list.
+	BOOL					m_bThumbnailCacheStarted;
 
 
 	void				ResetColumnWidth( int nItemAffected, int NewWidth );
+	char				*GetRowSOPInstanceUID( int nItem );
+	BOOL				GetRowCheck( int nItem );
+	void				ToggleRowCheck( int nItem );
+	void				ClearRowChecks();
+	void				RedrawChangedRows();
+	void				GetThumbnailCacheFileSpec( char *pCacheFileSpec );
+	BOOL				ReplaceThumbnailImage( int nImage, unsigned char *pThumbnailData, unsigned long ThumbnailWidth, unsigned long ThumbnailHeight );
+	int					GetThumbnailImageIndex( char *pSOPInstanceUID );
 	int					GetCurrentlySelectedItem();
 	void				UpdatePatientList();
 	void				AutoSelectPatientItem( char *pSelectedSOPInstanceUID );
@@ -84,6 +99,9 @@ protected:
 	afx_msg BOOL		OnEraseBkgnd( CDC *pDC );
 	afx_msg void		OnNMClick( NMHDR *pNMHDR, LRESULT *pResult );
 	afx_msg void		OnHdnEndtrack( NMHDR *pNMHDR, LRESULT *pResult );
+	afx_msg void		OnGetDisplayInfo( NMHDR *pNMHDR, LRESULT *pResult );
+	afx_msg void		OnListKeyDown( NMHDR *pNMHDR, LRESULT *pResult );
+	afx_msg LRESULT		OnThumbnailRead( WPARAM wParam, LPARAM lParam );
 	//}}AFX_VIRTUAL
 };
 
@@ -0,0 +1,587 @@
+// ThumbnailCache.cpp : Implements the cache of the reduced-size image previews shown in
+//  the study selection list, and the thread that reads the previews from the image files.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#include <process.h>
+#include "Module.h"
+#include "ThumbnailCache.h"
+
+
+// The previews are looked up on the user interface thread, which is never held up by the reading
+// of an image file.  A preview that hasn't been read is requested from the reader thread, and the
+// caller shows a placeholder until the notification function reports that the preview is ready.
+// The cache is shared by the two threads, and is held only while entries are looked up or filled.
+static THUMBNAIL_CACHE_ENTRY		*pThumbnailCache = 0;
+static int							ThumbnailIndex[ THUMBNAIL_INDEX_SIZE ];		// The first cache entry in each bucket, or -1.
+static int							nThumbnailCacheEntriesUsed = 0;
+static int							ThumbnailRequests[ MAX_THUMBNAIL_REQUESTS ];	// Cache entries to be read, the most recent last.
+static int							nThumbnailRequests = 0;
+static BOOL							bThumbnailReadInProgress = FALSE;
+static unsigned long				ThumbnailLookupSequence = 0;
+static unsigned long				ThumbnailContentSequence = 0;
+static THUMBNAIL_CACHE_STATISTICS	ThumbnailCacheStatistics;
+static HANDLE						hThumbnailCacheSemaphore = 0;
+static HANDLE						hThumbnailRequestSemaphore = 0;				// Counts the requests for the reader thread.
+static HANDLE						hThumbnailReaderThread = 0;
+static volatile BOOL				bThumbnailReaderStopRequested = FALSE;
+static THUMBNAIL_READER				ReadThumbnail = 0;
+static THUMBNAIL_NOTIFIER			NotifyThumbnailRead = 0;
+static void							*pThumbnailNotificationContext = 0;
+
+
+static unsigned __stdcall ThumbnailReaderThreadFunction( void *pArguments );
+
+
+static unsigned long HashSOPInstanceUID( char *pSOPInstanceUID )
+{
+	unsigned long		HashValue;
+	unsigned char		*pChar;
+
+	HashValue = 2166136261UL;
+	for ( pChar = (unsigned char*)pSOPInstanceUID; *pChar != '\0'; pChar++ )
+		HashValue = ( HashValue ^ *pChar ) * 16777619UL;
+
+	return HashValue & ( THUMBNAIL_INDEX_SIZE - 1 );
+}
+
+
+static int FindThumbnailCacheEntry( char *pSOPInstanceUID )
+{
+	int					nEntry;
+
+	nEntry = ThumbnailIndex[ HashSOPInstanceUID( pSOPInstanceUID ) ];
+	while ( nEntry >= 0 && strcmp( pThumbnailCache[ nEntry ].SOPInstanceUID, pSOPInstanceUID ) != 0 )
+		nEntry = pThumbnailCache[ nEntry ].nNextEntryInBucket;
+
+	return nEntry;
+}
+
+
+static void RemoveFromThumbnailIndex( int nEntry )
+{
+	int					*pnBucketLink;
+
+	pnBucketLink = &ThumbnailIndex[ HashSOPInstanceUID( pThumbnailCache[ nEntry ].SOPInstanceUID ) ];
+	while ( *pnBucketLink >= 0 && *pnBucketLink != nEntry )
+		pnBucketLink = &pThumbnailCache[ *pnBucketLink ].nNextEntryInBucket;
+	if ( *pnBucketLink == nEntry )
+		*pnBucketLink = pThumbnailCache[ nEntry ].nNextEntryInBucket;
+	pThumbnailCache[ nEntry ].nNextEntryInBucket = -1;
+}
+
+
+// Give a cache entry to a new image, and file it in the index.  An unused entry is taken if
+// there is one.  Otherwise the entry that has gone unused the longest is replaced, unless it
+// is waiting to be read.
+static int ClaimThumbnailCacheEntry( char *pSOPInstanceUID )
+{
+	int							nEntry;
+	int							nCandidateEntry;
+	THUMBNAIL_CACHE_ENTRY		*pEntry;
+	unsigned long				HashValue;
+
+	if ( nThumbnailCacheEntriesUsed < THUMBNAIL_CACHE_CAPACITY )
+		nEntry = nThumbnailCacheEntriesUsed++;
+	else
+		{
+		nEntry = -1;
+		for ( nCandidateEntry = 0; nCandidateEntry < THUMBNAIL_CACHE_CAPACITY; nCandidateEntry++ )
+			if ( pThumbnailCache[ nCandidateEntry ].ThumbnailState != THUMBNAIL_STATE_PENDING &&
+						( nEntry < 0 || pThumbnailCache[ nCandidateEntry ].LastUse < pThumbnailCache[ nEntry ].LastUse ) )
+				nEntry = nCandidateEntry;
+		if ( nEntry >= 0 && pThumbnailCache[ nEntry ].ThumbnailState != THUMBNAIL_STATE_EMPTY )
+			{
+			RemoveFromThumbnailIndex( nEntry );
+			ThumbnailCacheStatistics.nEvictions++;
+			}
+		}
+	if ( nEntry >= 0 )
+		{
+		pEntry = &pThumbnailCache[ nEntry ];
+		strncpy_s( pEntry -> SOPInstanceUID, THUMBNAIL_UID_STRING_LENGTH, pSOPInstanceUID, _TRUNCATE );
+		pEntry -> ThumbnailState = THUMBNAIL_STATE_PENDING;
+		pEntry -> ContentVersion = ++ThumbnailContentSequence;
+		pEntry -> LastUse = ThumbnailLookupSequence;
+		pEntry -> ThumbnailWidth = 0;
+		pEntry -> ThumbnailHeight = 0;
+		HashValue = HashSOPInstanceUID( pEntry -> SOPInstanceUID );
+		pEntry -> nNextEntryInBucket = ThumbnailIndex[ HashValue ];
+		ThumbnailIndex[ HashValue ] = nEntry;
+		}
+
+	return nEntry;
+}
+
+
+// Return a cache entry to the unused state.  It is the first to be taken for a new image.
+static void ReleaseThumbnailCacheEntry( int nEntry )
+{
+	RemoveFromThumbnailIndex( nEntry );
+	pThumbnailCache[ nEntry ].ThumbnailState = THUMBNAIL_STATE_EMPTY;
+	pThumbnailCache[ nEntry ].SOPInstanceUID[ 0 ] = '\0';
+	pThumbnailCache[ nEntry ].LastUse = 0;
+}
+
+
+// Add a request for the reader thread.  If the queue is full, the oldest request is dropped.
+static void RequestThumbnail( int nEntry )
+{
+	if ( nThumbnailRequests == MAX_THUMBNAIL_REQUESTS )
+		{
+		ReleaseThumbnailCacheEntry( ThumbnailRequests[ 0 ] );
+		memmove( &ThumbnailRequests[ 0 ], &ThumbnailRequests[ 1 ], ( MAX_THUMBNAIL_REQUESTS - 1 ) * sizeof(int) );
+		nThumbnailRequests--;
+		ThumbnailCacheStatistics.nDroppedRequests++;
+		}
+	ThumbnailRequests[ nThumbnailRequests++ ] = nEntry;
+	ReleaseSemaphore( hThumbnailRequestSemaphore, 1L, NULL );
+}
+
+
+// Move a waiting request to the end of the queue, so that the previews of the rows most recently
+// displayed are read first.
+static void ExpediteThumbnailRequest( int nEntry )
+{
+	int					nRequest;
+
+	for ( nRequest = 0; nRequest < nThumbnailRequests - 1; nRequest++ )
+		if ( ThumbnailRequests[ nRequest ] == nEntry )
+			{
+			memmove( &ThumbnailRequests[ nRequest ], &ThumbnailRequests[ nRequest + 1 ], ( nThumbnailRequests - nRequest - 1 ) * sizeof(int) );
+			ThumbnailRequests[ nThumbnailRequests - 1 ] = nEntry;
+			}
+}
+
+
+// Set up an empty cache and start the reader thread.  The reader function is called on that
+// thread for each preview requested.  The notification function, if any, is called on the same
+// thread after each preview is read, and must not wait for the user interface thread.
+BOOL InitThumbnailCache( THUMBNAIL_READER ReadThumbnailFunction, THUMBNAIL_NOTIFIER NotifyThumbnailReadFunction, void *pNotificationContext )
+{
+	BOOL					bNoError = TRUE;
+	int						nBucket;
+	unsigned int			ReaderThreadID;
+
+	pThumbnailCache = (THUMBNAIL_CACHE_ENTRY*)calloc( THUMBNAIL_CACHE_CAPACITY, sizeof(THUMBNAIL_CACHE_ENTRY) );
+	bNoError = ( pThumbnailCache != 0 );
+	if ( bNoError )
+		{
+		for ( nBucket = 0; nBucket < THUMBNAIL_INDEX_SIZE; nBucket++ )
+			ThumbnailIndex[ nBucket ] = -1;
+		nThumbnailCacheEntriesUsed = 0;
+		nThumbnailRequests = 0;
+		bThumbnailReadInProgress = FALSE;
+		ThumbnailLookupSequence = 0;
+		ThumbnailContentSequence = 0;
+		memset( &ThumbnailCacheStatistics, 0, sizeof(THUMBNAIL_CACHE_STATISTICS) );
+		ReadThumbnail = ReadThumbnailFunction;
+		NotifyThumbnailRead = NotifyThumbnailReadFunction;
+		pThumbnailNotificationContext = pNotificationContext;
+		bThumbnailReaderStopRequested = FALSE;
+		hThumbnailCacheSemaphore = CreateSemaphore( NULL, 1L, 1L, NULL );
+		hThumbnailRequestSemaphore = CreateSemaphore( NULL, 0L, 0x7fffffffL, NULL );
+		bNoError = ( hThumbnailCacheSemaphore != 0 && hThumbnailRequestSemaphore != 0 );
+		}
+	if ( bNoError )
+		{
+		hThumbnailReaderThread = (HANDLE)_beginthreadex(	NULL,						// No security issues for child processes.
+															0,							// Use same stack size as parent process.
+															ThumbnailReaderThreadFunction,
+															NULL,						// No argument for thread function.
+															0,							// Initialize thread state as running.
+															&ReaderThreadID );
+		bNoError = ( hThumbnailReaderThread != 0 );
+		}
+	if ( !bNoError )
+		CloseThumbnailCache();
+
+	return bNoError;
+}
+
+
+// Stop the reader thread and release the cache.  If the thread doesn't finish in time, the cache
+// is left for it, since BViewer is ending anyway.
+void CloseThumbnailCache()
+{
+	BOOL					bReaderFinished;
+
+	bReaderFinished = TRUE;
+	if ( hThumbnailReaderThread != 0 )
+		{
+		bThumbnailReaderStopRequested = TRUE;
+		ReleaseSemaphore( hThumbnailRequestSemaphore, 1L, NULL );
+		bReaderFinished = ( WaitForSingleObject( hThumbnailReaderThread, THUMBNAIL_SHUTDOWN_TIMEOUT ) == WAIT_OBJECT_0 );
+		if ( bReaderFinished )
+			CloseHandle( hThumbnailReaderThread );
+		}
+	if ( bReaderFinished )
+		{
+		hThumbnailReaderThread = 0;
+		if ( hThumbnailCacheSemaphore != 0 )
+			CloseHandle( hThumbnailCacheSemaphore );
+		hThumbnailCacheSemaphore = 0;
+		if ( hThumbnailRequestSemaphore != 0 )
+			CloseHandle( hThumbnailRequestSemaphore );
+		hThumbnailRequestSemaphore = 0;
+		if ( pThumbnailCache != 0 )
+			free( pThumbnailCache );
+		pThumbnailCache = 0;
+		}
+}
+
+
+// Copy the cached preview for the designated image into pThumbnail, and return its state.  If the
+// image hasn't been seen before, its preview is requested from the reader thread and the pending
+// state is returned at once.  The pixels are only copied for a preview that is ready.
+int LookUpThumbnail( char *pSOPInstanceUID, THUMBNAIL *pThumbnail )
+{
+	int							nEntry;
+	THUMBNAIL_CACHE_ENTRY		*pEntry;
+
+	pThumbnail -> nCacheEntry = -1;
+	pThumbnail -> ThumbnailState = THUMBNAIL_STATE_EMPTY;
+	pThumbnail -> ContentVersion = 0;
+	pThumbnail -> ThumbnailWidth = 0;
+	pThumbnail -> ThumbnailHeight = 0;
+	if ( pThumbnailCache != 0 && strlen( pSOPInstanceUID ) > 0 &&
+				WaitForSingleObject( hThumbnailCacheSemaphore, THUMBNAIL_CACHE_ACCESS_TIMEOUT ) == WAIT_OBJECT_0 )
+		{
+		ThumbnailCacheStatistics.nLookups++;
+		ThumbnailLookupSequence++;
+		nEntry = FindThumbnailCacheEntry( pSOPInstanceUID );
+		if ( nEntry >= 0 )
+			{
+			pThumbnailCache[ nEntry ].LastUse = ThumbnailLookupSequence;
+			if ( pThumbnailCache[ nEntry ].ThumbnailState == THUMBNAIL_STATE_PENDING )
+				ExpediteThumbnailRequest( nEntry );
+			else
+				ThumbnailCacheStatistics.nHits++;
+			}
+		else
+			{
+			nEntry = ClaimThumbnailCacheEntry( pSOPInstanceUID );
+			if ( nEntry >= 0 )
+				RequestThumbnail( nEntry );
+			}
+		if ( nEntry >= 0 )
+			{
+			pEntry = &pThumbnailCache[ nEntry ];
+			pThumbnail -> nCacheEntry = nEntry;
+			pThumbnail -> ThumbnailState = pEntry -> ThumbnailState;
+			pThumbnail -> ContentVersion = pEntry -> ContentVersion;
+			if ( pEntry -> ThumbnailState == THUMBNAIL_STATE_READY )
+				{
+				pThumbnail -> ThumbnailWidth = pEntry -> ThumbnailWidth;
+				pThumbnail -> ThumbnailHeight = pEntry -> ThumbnailHeight;
+				memcpy( pThumbnail -> PixelData, pEntry -> PixelData, pEntry -> ThumbnailWidth * pEntry -> ThumbnailHeight );
+				}
+			}
+		ReleaseSemaphore( hThumbnailCacheSemaphore, 1L, NULL );
+		}
+
+	return pThumbnail -> ThumbnailState;
+}
+
+
+// Read the requested previews, the most recent request first.
+static unsigned __stdcall ThumbnailReaderThreadFunction( void *pArguments )
+{
+	int							nEntry;
+	THUMBNAIL_CACHE_ENTRY		*pEntry;
+	char						SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH ];
+	unsigned long				ContentVersion;
+	BOOL						bThumbnailRead;
+	unsigned char				*pThumbnailData;
+	unsigned long				ThumbnailWidth;
+	unsigned long				ThumbnailHeight;
+
+	while ( !bThumbnailReaderStopRequested )
+		{
+		WaitForSingleObject( hThumbnailRequestSemaphore, INFINITE );
+		nEntry = -1;
+		if ( !bThumbnailReaderStopRequested &&
+					WaitForSingleObject( hThumbnailCacheSemaphore, THUMBNAIL_CACHE_ACCESS_TIMEOUT ) == WAIT_OBJECT_0 )
+			{
+			// A dropped request leaves a count on the request semaphore with nothing to read.
+			if ( nThumbnailRequests > 0 )
+				{
+				nEntry = ThumbnailRequests[ --nThumbnailRequests ];
+				strncpy_s( SOPInstanceUID, THUMBNAIL_UID_STRING_LENGTH, pThumbnailCache[ nEntry ].SOPInstanceUID, _TRUNCATE );
+				ContentVersion = pThumbnailCache[ nEntry ].ContentVersion;
+				bThumbnailReadInProgress = TRUE;
+				}
+			ReleaseSemaphore( hThumbnailCacheSemaphore, 1L, NULL );
+			}
+		if ( nEntry >= 0 )
+			{
+			// The image file is read without holding the cache.
+			pThumbnailData = 0;
+			ThumbnailWidth = 0;
+			ThumbnailHeight = 0;
+			bThumbnailRead = ReadThumbnail( SOPInstanceUID, THUMBNAIL_DIMENSION, &pThumbnailData, &ThumbnailWidth, &ThumbnailHeight );
+			bThumbnailRead = ( bThumbnailRead && pThumbnailData != 0 && ThumbnailWidth > 0 && ThumbnailWidth <= THUMBNAIL_DIMENSION &&
+									ThumbnailHeight > 0 && ThumbnailHeight <= THUMBNAIL_DIMENSION );
+			WaitForSingleObject( hThumbnailCacheSemaphore, INFINITE );
+			pEntry = &pThumbnailCache[ nEntry ];
+			if ( pEntry -> ThumbnailState == THUMBNAIL_STATE_PENDING && pEntry -> ContentVersion == ContentVersion )
+				{
+				if ( bThumbnailRead )
+					{
+					memcpy( pEntry -> PixelData, pThumbnailData, ThumbnailWidth * ThumbnailHeight );
+					pEntry -> ThumbnailWidth = ThumbnailWidth;
+					pEntry -> ThumbnailHeight = ThumbnailHeight;
+					pEntry -> ThumbnailState = THUMBNAIL_STATE_READY;
+					ThumbnailCacheStatistics.nThumbnailsRead++;
+					}
+				else
+					{
+					pEntry -> ThumbnailState = THUMBNAIL_STATE_FAILED;
+					ThumbnailCacheStatistics.nReadFailures++;
+					}
+				pEntry -> ContentVersion = ++ThumbnailContentSequence;
+				}
+			ReleaseSemaphore( hThumbnailCacheSemaphore, 1L, NULL );
+			if ( pThumbnailData != 0 )
+				free( pThumbnailData );
+			if ( NotifyThumbnailRead != 0 )
+				NotifyThumbnailRead( pThumbnailNotificationContext );
+			// The read is finished for WaitForThumbnailRequests() once its notification has been made.
+			WaitForSingleObject( hThumbnailCacheSemaphore, INFINITE );
+			bThumbnailReadInProgress = FALSE;
+			ReleaseSemaphore( hThumbnailCacheSemaphore, 1L, NULL );
+			}
+		}
+
+	return 0;
+}
+
+
+// Wait until the reader thread has no more requests.  Return FALSE if it is still busy when
+// the timeout, in milliseconds, expires.
+BOOL WaitForThumbnailRequests( DWORD Timeout )
+{
+	BOOL					bRequestsFinished;
+	BOOL					bTimedOut;
+	ULONGLONG				StopTime;
+
+	bRequestsFinished = FALSE;
+	bTimedOut = FALSE;
+	StopTime = GetTickCount64() + Timeout;
+	while ( !bRequestsFinished && !bTimedOut && pThumbnailCache != 0 )
+		{
+		if ( WaitForSingleObject( hThumbnailCacheSemaphore, THUMBNAIL_CACHE_ACCESS_TIMEOUT ) == WAIT_OBJECT_0 )
+			{
+			bRequestsFinished = ( nThumbnailRequests == 0 && !bThumbnailReadInProgress );
+			ReleaseSemaphore( hThumbnailCacheSemaphore, 1L, NULL );
+			}
+		if ( !bRequestsFinished )
+			{
+			bTimedOut = ( GetTickCount64() >= StopTime );
+			Sleep( 1 );
+			}
+		}
+
+	return bRequestsFinished;
+}
+
+
+void GetThumbnailCacheStatistics( THUMBNAIL_CACHE_STATISTICS *pStatistics )
+{
+	memset( pStatistics, 0, sizeof(THUMBNAIL_CACHE_STATISTICS) );
+	if ( pThumbnailCache != 0 &&
+				WaitForSingleObject( hThumbnailCacheSemaphore, THUMBNAIL_CACHE_ACCESS_TIMEOUT ) == WAIT_OBJECT_0 )
+		{
+		memcpy( pStatistics, &ThumbnailCacheStatistics, sizeof(THUMBNAIL_CACHE_STATISTICS) );
+		ReleaseSemaphore( hThumbnailCacheSemaphore, 1L, NULL );
+		}
+}
+
+
+// Order the saved previews from the least recently used, so that the order of use is restored
+// when they are loaded.
+static int CompareThumbnailLastUse( const void *pFirstEntry, const void *pSecondEntry )
+{
+	unsigned long			FirstLastUse;
+	unsigned long			SecondLastUse;
+
+	FirstLastUse = pThumbnailCache[ *(int*)pFirstEntry ].LastUse;
+	SecondLastUse = pThumbnailCache[ *(int*)pSecondEntry ].LastUse;
+
+	return ( FirstLastUse < SecondLastUse ) ? -1 : ( FirstLastUse > SecondLastUse ) ? 1 : 0;
+}
+
+
+// The cache file begins with its signature, the preview dimension and the number of previews.
+// Each preview follows, as its SOP instance UID, its width and height, and its pixel rows.  The
+// numbers are stored as 4 bytes, least significant byte first.
+static BOOL WriteThumbnailCacheNumber( FILE *pCacheFile, unsigned long Number )
+{
+	unsigned char			NumberBytes[ 4 ];
+
+	NumberBytes[ 0 ] = (unsigned char)( Number & 0xff );
+	NumberBytes[ 1 ] = (unsigned char)( ( Number >> 8 ) & 0xff );
+	NumberBytes[ 2 ] = (unsigned char)( ( Number >> 16 ) & 0xff );
+	NumberBytes[ 3 ] = (unsigned char)( ( Number >> 24 ) & 0xff );
+
+	return ( fwrite( NumberBytes, 1, 4, pCacheFile ) == 4 );
+}
+
+
+static BOOL ReadThumbnailCacheNumber( FILE *pCacheFile, unsigned long *pNumber )
+{
+	BOOL					bNoError = TRUE;
+	unsigned char			NumberBytes[ 4 ];
+
+	bNoError = ( fread_s( NumberBytes, 4, 1, 4, pCacheFile ) == 4 );
+	if ( bNoError )
+		*pNumber = (unsigned long)NumberBytes[ 0 ] | ( (unsigned long)NumberBytes[ 1 ] << 8 ) |
+						( (unsigned long)NumberBytes[ 2 ] << 16 ) | ( (unsigned long)NumberBytes[ 3 ] << 24 );
+
+	return bNoError;
+}
+
+
+// Save the previews that have been read, for the next session.  Known failures aren't saved,
+// in case the image files are replaced.
+BOOL SaveThumbnailCache( char *pCacheFileSpec )
+{
+	BOOL						bNoError = TRUE;
+	FILE						*pCacheFile = 0;
+	int							*pSavedEntries = 0;
+	int							nSavedEntries;
+	int							nEntry;
+	int							nSavedEntry;
+	THUMBNAIL_CACHE_ENTRY		*pEntry;
+
+	bNoError = ( pThumbnailCache != 0 &&
+					WaitForSingleObject( hThumbnailCacheSemaphore, THUMBNAIL_CACHE_ACCESS_TIMEOUT ) == WAIT_OBJECT_0 );
+	if ( bNoError )
+		{
+		nSavedEntries = 0;
+		pSavedEntries = (int*)malloc( THUMBNAIL_CACHE_CAPACITY * sizeof(int) );
+		bNoError = ( pSavedEntries != 0 );
+		if ( bNoError )
+			{
+			for ( nEntry = 0; nEntry < nThumbnailCacheEntriesUsed; nEntry++ )
+				if ( pThumbnailCache[ nEntry ].ThumbnailState == THUMBNAIL_STATE_READY )
+					pSavedEntries[ nSavedEntries++ ] = nEntry;
+			qsort( pSavedEntries, nSavedEntries, sizeof(int), CompareThumbnailLastUse );
+			bNoError = ( fopen_s( &pCacheFile, pCacheFileSpec, "wb" ) == 0 && pCacheFile != 0 );
+			}
+		if ( bNoError )
+			{
+			bNoError = ( fwrite( THUMBNAIL_CACHE_FILE_SIGNATURE, 1, 8, pCacheFile ) == 8 &&
+							WriteThumbnailCacheNumber( pCacheFile, THUMBNAIL_DIMENSION ) &&
+							WriteThumbnailCacheNumber( pCacheFile, (unsigned long)nSavedEntries ) );
+			for ( nSavedEntry = 0; nSavedEntry < nSavedEntries && bNoError; nSavedEntry++ )
+				{
+				pEntry = &pThumbnailCache[ pSavedEntries[ nSavedEntry ] ];
+				bNoError = ( fwrite( pEntry -> SOPInstanceUID, 1, THUMBNAIL_UID_STRING_LENGTH, pCacheFile ) == THUMBNAIL_UID_STRING_LENGTH &&
+								WriteThumbnailCacheNumber( pCacheFile, pEntry -> ThumbnailWidth ) &&
+								WriteThumbnailCacheNumber( pCacheFile, pEntry -> ThumbnailHeight ) &&
+								fwrite( pEntry -> PixelData, 1, pEntry -> ThumbnailWidth * pEntry -> ThumbnailHeight, pCacheFile ) ==
+																				pEntry -> ThumbnailWidth * pEntry -> ThumbnailHeight );
+				}
+			if ( fclose( pCacheFile ) != 0 )
+				bNoError = FALSE;
+			if ( !bNoError )
+				remove( pCacheFileSpec );
+			}
+		if ( pSavedEntries != 0 )
+			free( pSavedEntries );
+		ReleaseSemaphore( hThumbnailCacheSemaphore, 1L, NULL );
+		}
+
+	return bNoError;
+}
+
+
+// Load the previews saved by an earlier session into the cache.  A file that cannot be read,
+// or that was saved with a different preview dimension, is ignored.
+BOOL LoadThumbnailCache( char *pCacheFileSpec )
+{
+	BOOL						bNoError = TRUE;
+	FILE						*pCacheFile = 0;
+	char						Signature[ 8 ];
+	unsigned long				ThumbnailDimension;
+	unsigned long				nSavedEntries;
+	unsigned long				nSavedEntry;
+	int							nEntry;
+	THUMBNAIL_CACHE_ENTRY		*pEntry;
+	char						SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH ];
+	unsigned long				ThumbnailWidth;
+	unsigned long				ThumbnailHeight;
+
+	bNoError = ( pThumbnailCache != 0 && fopen_s( &pCacheFile, pCacheFileSpec, "rb" ) == 0 && pCacheFile != 0 );
+	if ( bNoError )
+		{
+		bNoError = ( fread_s( Signature, 8, 1, 8, pCacheFile ) == 8 && memcmp( Signature, THUMBNAIL_CACHE_FILE_SIGNATURE, 8 ) == 0 &&
+						ReadThumbnailCacheNumber( pCacheFile, &ThumbnailDimension ) && ThumbnailDimension == THUMBNAIL_DIMENSION &&
+						ReadThumbnailCacheNumber( pCacheFile, &nSavedEntries ) && nSavedEntries <= THUMBNAIL_CACHE_CAPACITY );
+		if ( bNoError && WaitForSingleObject( hThumbnailCacheSemaphore, THUMBNAIL_CACHE_ACCESS_TIMEOUT ) == WAIT_OBJECT_0 )
+			{
+			for ( nSavedEntry = 0; nSavedEntry < nSavedEntries && bNoError; nSavedEntry++ )
+				{
+				bNoError = ( fread_s( SOPInstanceUID, THUMBNAIL_UID_STRING_LENGTH, 1, THUMBNAIL_UID_STRING_LENGTH, pCacheFile ) == THUMBNAIL_UID_STRING_LENGTH &&
+								ReadThumbnailCacheNumber( pCacheFile, &ThumbnailWidth ) && ThumbnailWidth > 0 && ThumbnailWidth <= THUMBNAIL_DIMENSION &&
+								ReadThumbnailCacheNumber( pCacheFile, &ThumbnailHeight ) && ThumbnailHeight > 0 && ThumbnailHeight <= THUMBNAIL_DIMENSION );
+				if ( bNoError )
+					{
+					SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH - 1 ] = '\0';
+					bNoError = ( strlen( SOPInstanceUID ) > 0 );
+					}
+				if ( bNoError && FindThumbnailCacheEntry( SOPInstanceUID ) < 0 )
+					{
+					ThumbnailLookupSequence++;
+					nEntry = ClaimThumbnailCacheEntry( SOPInstanceUID );
+					bNoError = ( nEntry >= 0 );
+					if ( bNoError )
+						{
+						pEntry = &pThumbnailCache[ nEntry ];
+						bNoError = ( fread_s( pEntry -> PixelData, THUMBNAIL_DIMENSION * THUMBNAIL_DIMENSION, 1,
+												ThumbnailWidth * ThumbnailHeight, pCacheFile ) == ThumbnailWidth * ThumbnailHeight );
+						pEntry -> ThumbnailWidth = ThumbnailWidth;
+						pEntry -> ThumbnailHeight = ThumbnailHeight;
+						pEntry -> ThumbnailState = THUMBNAIL_STATE_READY;
+						if ( !bNoError )
+							ReleaseThumbnailCacheEntry( nEntry );
+						}
+					}
+				else if ( bNoError )
+					bNoError = ( fseek( pCacheFile, ThumbnailWidth * ThumbnailHeight, SEEK_CUR ) == 0 );
+				}
+			ReleaseSemaphore( hThumbnailCacheSemaphore, 1L, NULL );
+			}
+		else
+			bNoError = FALSE;
+		fclose( pCacheFile );
+		}
+
+	return bNoError;
+}
+
@@ -0,0 +1,121 @@
+// ThumbnailCache.h : Defines the cache of the reduced-size image previews shown in the
+//  study selection list, and the thread that reads the previews from the image files.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+// UPDATE HISTORY:
+//
+//
+//
+#pragma once
+
+#include "Module.h"
+
+
+// The size, in pixels, of the square image previews.
+#define THUMBNAIL_DIMENSION					40
+
+// The number of previews held in memory.  When the cache is full, the preview that has gone
+// unused the longest is replaced.
+#define THUMBNAIL_CACHE_CAPACITY			1024
+// The number of hash buckets in the SOP instance UID index.  Must be a power of 2.
+#define THUMBNAIL_INDEX_SIZE				2048
+// The number of previews waiting to be read.  When more are requested, as when the list is
+// scrolled quickly, the oldest requests are dropped.  They are requested again if their rows
+// come back into view.
+#define MAX_THUMBNAIL_REQUESTS				64
+
+#define THUMBNAIL_UID_STRING_LENGTH			128
+
+#define THUMBNAIL_CACHE_ACCESS_TIMEOUT		5000
+#define THUMBNAIL_SHUTDOWN_TIMEOUT			10000
+
+// The previews read so far are kept in this file in the image folder between sessions.
+#define THUMBNAIL_CACHE_FILE_NAME			"BViewerThumbnails.dat"
+#define THUMBNAIL_CACHE_FILE_SIGNATURE		"BVTHUMB1"
+
+// The states of a cached preview.
+#define THUMBNAIL_STATE_EMPTY				0
+#define THUMBNAIL_STATE_PENDING				1		// Waiting for the reader thread.
+#define THUMBNAIL_STATE_READY				2
+#define THUMBNAIL_STATE_FAILED				3		// The image file could not be read.  It isn't tried again.
+
+
+// The function that reads the preview for an image, given its SOP instance UID.  The preview
+// is returned as 8-bit grayscale rows from the top of the image down, no larger than the
+// specified dimension in either direction, in a buffer allocated with malloc().
+typedef BOOL (*THUMBNAIL_READER)( char *pSOPInstanceUID, unsigned long MaxThumbnailDimension,
+									unsigned char **ppThumbnailData, unsigned long *pThumbnailWidth, unsigned long *pThumbnailHeight );
+// The function that is called on the reader thread each time a preview has been read.
+typedef void (*THUMBNAIL_NOTIFIER)( void *pNotificationContext );
+
+
+typedef struct
+	{
+	char				SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH ];
+	int					ThumbnailState;
+	unsigned long		ContentVersion;			// Changed whenever the entry is given new contents.
+	unsigned long		LastUse;				// The lookup sequence number when the entry was last requested.
+	int					nNextEntryInBucket;		// The next entry in the same index bucket, or -1.
+	unsigned long		ThumbnailWidth;
+	unsigned long		ThumbnailHeight;
+	unsigned char		PixelData[ THUMBNAIL_DIMENSION * THUMBNAIL_DIMENSION ];
+	} THUMBNAIL_CACHE_ENTRY;
+
+
+// A copy of a cached preview, for the caller of LookUpThumbnail().  The cache entry number
+// stays the same for as long as the entry holds the same image, and is never larger than
+// THUMBNAIL_CACHE_CAPACITY - 1, so it can number a fixed set of display bitmaps.
+typedef struct
+	{
+	int					nCacheEntry;
+	int					ThumbnailState;
+	unsigned long		ContentVersion;
+	unsigned long		ThumbnailWidth;
+	unsigned long		ThumbnailHeight;
+	unsigned char		PixelData[ THUMBNAIL_DIMENSION * THUMBNAIL_DIMENSION ];
+	} THUMBNAIL;
+
+
+typedef struct
+	{
+	unsigned long		nLookups;
+	unsigned long		nHits;					// Lookups answered with a preview, or with a known failure.
+	unsigned long		nThumbnailsRead;
+	unsigned long		nReadFailures;
+	unsigned long		nEvictions;
+	unsigned long		nDroppedRequests;
+	} THUMBNAIL_CACHE_STATISTICS;
+
+
+
+// Function prototypes.
+//
+BOOL			InitThumbnailCache( THUMBNAIL_READER ReadThumbnail, THUMBNAIL_NOTIFIER NotifyThumbnailRead, void *pNotificationContext );
+void			CloseThumbnailCache();
+int				LookUpThumbnail( char *pSOPInstanceUID, THUMBNAIL *pThumbnail );
+BOOL			WaitForThumbnailRequests( DWORD Timeout );
+void			GetThumbnailCacheStatistics( THUMBNAIL_CACHE_STATISTICS *pStatistics );
+BOOL			SaveThumbnailCache( char *pCacheFileSpec );
+BOOL			LoadThumbnailCache( char *pCacheFileSpec );
+
@@ -29,11 +29,19 @@
 //
 // UPDATE HISTORY:
 //
+//	*[3] 10/19/2026 by agent
+//		The identity of the displayed log file is recorded, so that a log file replaced by
+//		CheckForLogFileRotation() is read in full, instead of appended to the display.
+//	*[2] 10/19/2026 by agent
+//		Only the log file bytes added since the page was last viewed are now read and
+//		appended to the display.  For a large log file, only its most recent portion is
+//		read and displayed, to keep the page from hanging.
 //	*[1] 01/20/2023 by Tom Atwood
 //		Fixed code security issues.
 //
 //
 #include "stdafx.h"
+#include <io.h>
 #include "BViewer.h"
 #include "Module.h"
 #include "Configuration.h"
@@ -55,6 +63,12 @@ CViewLogPage::CViewLogPage() : CPropertyPage(CViewLogPage::IDD),
 	m_bLogDisplayInitialized = FALSE;
 	m_LogGranularity = SUMMARY_LOG;
 	m_pLogText = 0;
+	m_DisplayedLogGranularity = SUMMARY_LOG;		// *[2]
+	m_DisplayedLogFileSize = 0;						// *[2]
+	m_DisplayedLogTextLength = 0;					// *[2]
+	m_bAppendLogText = FALSE;						// *[2]
+	m_DisplayedLogFileIndex = 0;					// *[3]
+	m_DisplayedLogVolumeSerialNumber = 0;			// *[3]
 	m_BkgdBrush.CreateSolidBrush( COLOR_LOG_BKGD );
 }
 
@@ -88,6 +102,14 @@ BOOL CViewLogPage::OnInitDialog()
 }
 
 
+// *[2] Read the log file text that is not already being displayed.  If the log file
+// has grown since it was last read, only the new bytes are read, and m_bAppendLogText
+// is set to indicate that they are to be appended to the display.  Otherwise, the
+// display is to be replaced, using no more than the final MAX_LOG_DISPLAY_SIZE bytes
+// of the log file, beginning at a line boundary.
+// *[3] When the log file reaches its size limit, it is renamed and a new log file is
+// started under the same name.  The new file can have grown past the displayed size by
+// the time the page is shown again, so appending also requires the file index to match.
 BOOL CViewLogPage::ReadLogFile()
 {
 	char						*pFullLogFileSpecification;
@@ -95,8 +117,14 @@ BOOL CViewLogPage::ReadLogFile()
 	WIN32_FIND_DATA				FindFileInfo;
 	HANDLE						hFindFile;
 	BOOL						bFileFound;
+	BY_HANDLE_FILE_INFORMATION	LogFileInfo;
+	BOOL						bFileIdentified;
+	unsigned __int64			LogFileIndex;
+	__int64						LogFileSize;
+	__int64						ReadStartingOffset;
 	size_t						LogFileSizeInBytes;
 	char						*pLogTextBuffer;
+	char						*pFirstLine;
 	size_t						nBytesRead;
 	BOOL						bLogReadSuccessfully;
 
@@ -117,29 +145,98 @@ BOOL CViewLogPage::ReadLogFile()
 	if ( bFileFound )
 		{
 		pLogTextBuffer = 0;
-		LogFileSizeInBytes = (size_t)FindFileInfo.nFileSizeLow;
-		if ( LogFileSizeInBytes > 0 )
+		LogFileSize = ( (__int64)FindFileInfo.nFileSizeHigh << 32 ) | (__int64)FindFileInfo.nFileSizeLow;		// *[2]
+		// *[3] Identify the log file that is actually opened.
+		LogFileIndex = 0;
+		bFileIdentified = FALSE;
+		pLogFile = fopen( pFullLogFileSpecification, "rb" );
+		if ( pLogFile != 0 )
+			bFileIdentified = GetFileInformationByHandle( (HANDLE)_get_osfhandle( _fileno( pLogFile ) ), &LogFileInfo );
+		if ( bFileIdentified )
+			{
+			LogFileIndex = ( (unsigned __int64)LogFileInfo.nFileIndexHigh << 32 ) | (unsigned __int64)LogFileInfo.nFileIndexLow;
+			LogFileSize = ( (__int64)LogFileInfo.nFileSizeHigh << 32 ) | (__int64)LogFileInfo.nFileSizeLow;
+			}
+		// *[2] Decide whether the new text can be appended to what is already displayed.
+		m_bAppendLogText = ( m_DisplayedLogFileSize > 0 && m_DisplayedLogGranularity == m_LogGranularity &&
+								bFileIdentified && LogFileIndex == m_DisplayedLogFileIndex &&						// *[3]
+								LogFileInfo.dwVolumeSerialNumber == m_DisplayedLogVolumeSerialNumber &&				// *[3]
+								LogFileSize >= m_DisplayedLogFileSize &&
+								m_DisplayedLogTextLength + (size_t)( LogFileSize - m_DisplayedLogFileSize ) <= MAX_LOG_DISPLAY_SIZE );
+		if ( m_bAppendLogText )
+			ReadStartingOffset = m_DisplayedLogFileSize;
+		else if ( LogFileSize > MAX_LOG_DISPLAY_SIZE )
+			ReadStartingOffset = LogFileSize - MAX_LOG_DISPLAY_SIZE;
+		else
+			ReadStartingOffset = 0;
+		LogFileSizeInBytes = (size_t)( LogFileSize - ReadStartingOffset );
+		if ( LogFileSizeInBytes > 0 || !m_bAppendLogText )			// *[3] A newly rotated log file can be empty.
 			pLogTextBuffer = (char*)malloc( LogFileSizeInBytes + 1 );
+		else
+			bLogReadSuccessfully = TRUE;		// *[2] Nothing has been added to the log file.
 		if ( pLogTextBuffer != 0 )
 			{
-			pLogFile = fopen( pFullLogFileSpecification, "rb" );
-			if ( pLogFile != 0 )
+			if ( pLogFile != 0 && _fseeki64( pLogFile, ReadStartingOffset, SEEK_SET ) == 0 )		// *[2]
 				{
 				nBytesRead = fread_s( pLogTextBuffer, LogFileSizeInBytes + 1, 1, LogFileSizeInBytes, pLogFile );		// *[1] Converted from fread to fread_s.
-				fclose( pLogFile );
 				pLogTextBuffer[ nBytesRead ] = '\0';
 				m_pLogText = pLogTextBuffer;
+				// *[2] If reading began partway into the log file, skip the partial first line.
+				if ( !m_bAppendLogText && ReadStartingOffset > 0 )
+					{
+					pFirstLine = (char*)memchr( pLogTextBuffer, '\n', nBytesRead );
+					if ( pFirstLine != 0 )
+						{
+						pFirstLine++;
+						nBytesRead -= (size_t)( pFirstLine - pLogTextBuffer );
+						memmove( pLogTextBuffer, pFirstLine, nBytesRead + 1 );
+						}
+					}
+				if ( m_bAppendLogText )
+					m_DisplayedLogTextLength += nBytesRead;
+				else
+					m_DisplayedLogTextLength = nBytesRead;
+				m_DisplayedLogFileSize = ReadStartingOffset + (__int64)LogFileSizeInBytes;
+				m_DisplayedLogGranularity = m_LogGranularity;
+				m_DisplayedLogFileIndex = LogFileIndex;										// *[3]
+				if ( bFileIdentified )
+					m_DisplayedLogVolumeSerialNumber = LogFileInfo.dwVolumeSerialNumber;		// *[3]
 				bLogReadSuccessfully = TRUE;
 				}
 			else
 				free ( pLogTextBuffer );			// *[1] Fixed potential memory leak.
 			}
+		if ( pLogFile != 0 )
+			fclose( pLogFile );						// *[3]
 		}
 
 	return bLogReadSuccessfully;
 }
 
 
+// *[2] Show the text most recently read from the log file, either appending it to the
+// displayed text or replacing the displayed text.
+void CViewLogPage::DisplayLogText()
+{
+	int					nTextLength;
+
+	if ( m_pLogText != 0 )
+		{
+		if ( m_bAppendLogText )
+			{
+			nTextLength = m_EditLog.GetWindowTextLength();
+			m_EditLog.SetSel( nTextLength, nTextLength );
+			m_EditLog.ReplaceSel( m_pLogText );
+			}
+		else
+			m_EditLog.SetWindowText( m_pLogText );
+		free( m_pLogText );
+		m_pLogText = 0;
+		}
+	m_EditLog.SendMessage( WM_VSCROLL, SB_BOTTOM, 0 );
+}
+
+
 BOOL CViewLogPage::OnSetActive()
 {
 	CMainFrame			*pMainFrame;
@@ -153,10 +250,7 @@ BOOL CViewLogPage::OnSetActive()
 		pMainFrame -> m_wndDlgBar.m_ButtonShowLogDetail.Invalidate( TRUE );
 		}
 	if ( ReadLogFile() )
-		{
-		m_EditLog.SetWindowText( m_pLogText );
-		m_EditLog.SendMessage( WM_VSCROLL, SB_BOTTOM, 0 );
-		}
+		DisplayLogText();			// *[2]
 
 	pControlPanel = (CControlPanel*)GetParent();
 	if ( pControlPanel != 0 )
@@ -208,10 +302,7 @@ void CViewLogPage::OnShowLogDetail()
 		pMainFrame -> m_wndDlgBar.m_ButtonShowLogDetail.Invalidate( TRUE );
 		}
 	if ( ReadLogFile() )
-		{
-		m_EditLog.SetWindowText( m_pLogText );
-		m_EditLog.SendMessage( WM_VSCROLL, SB_BOTTOM, 0 );
-		}
+		DisplayLogText();			// *[2]
 }
 
 
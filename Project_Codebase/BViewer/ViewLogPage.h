@@ -45,12 +45,20 @@ public:
 	CBrush				m_BkgdBrush;
 	TomEdit				m_EditLog;
 	char				*m_pLogText;
+	unsigned char		m_DisplayedLogGranularity;
+	__int64				m_DisplayedLogFileSize;		// The number of log file bytes already in the edit control.
+	size_t				m_DisplayedLogTextLength;
+	BOOL				m_bAppendLogText;			// Set if m_pLogText holds only the text added since the last read.
+	unsigned __int64	m_DisplayedLogFileIndex;	// Identifies the displayed log file, which is replaced when the log is rotated.
+	DWORD				m_DisplayedLogVolumeSerialNumber;
+							#define		MAX_LOG_DISPLAY_SIZE		0x400000
 
 // Dialog Data
 	enum { IDD = IDD_PROP_PAGE_LOG };
 
 public:
 	BOOL					ReadLogFile();
+	void					DisplayLogText();
 	void					OnShowLogDetail();
 
 protected:
@@ -0,0 +1,141 @@
+// BViewerTest.cpp : Implements the test program for the BViewer modules that can
+//	be exercised without the user interface.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "BViewerTest.h"
+
+
+static char					TestDataDirectory[ FULL_FILE_SPEC_STRING_LENGTH ] = DEFAULT_TEST_DATA_DIRECTORY;
+static long					nTestsPassed = 0;
+static long					nTestsFailed = 0;
+
+
+// Record and report the outcome of a single test check.
+void CheckTestResult( BOOL bTestPassed, char *pTestDescription )
+{
+	if ( bTestPassed )
+		{
+		nTestsPassed++;
+		printf( "    Passed:  %s\n", pTestDescription );
+		}
+	else
+		{
+		nTestsFailed++;
+		printf( "*** FAILED:  %s\n", pTestDescription );
+		}
+}
+
+
+void GetTestDataFileSpec( char *pRelativeFileSpec, char *pFileSpec, size_t nBufferSize )
+{
+	strncpy_s( pFileSpec, nBufferSize, TestDataDirectory, _TRUNCATE );
+	strncat_s( pFileSpec, nBufferSize, pRelativeFileSpec, _TRUNCATE );
+}
+
+
+// Read an entire file into a newly allocated buffer, which the caller frees.
+BOOL ReadFileContents( char *pFileSpec, char **ppFileData, unsigned long *pFileSize )
+{
+	BOOL			bNoError = TRUE;
+	FILE			*pDataFile;
+	long			FileSize;
+
+	*ppFileData = 0;
+	*pFileSize = 0;
+	pDataFile = fopen( pFileSpec, "rb" );
+	bNoError = ( pDataFile != 0 );
+	if ( bNoError )
+		{
+		bNoError = ( fseek( pDataFile, 0, SEEK_END ) == 0 );
+		FileSize = ftell( pDataFile );
+		bNoError = ( bNoError && FileSize >= 0 && fseek( pDataFile, 0, SEEK_SET ) == 0 );
+		}
+	if ( bNoError )
+		{
+		*ppFileData = (char*)malloc( FileSize + 1 );
+		bNoError = ( *ppFileData != 0 );
+		}
+	if ( bNoError )
+		{
+		bNoError = ( fread( *ppFileData, 1, FileSize, pDataFile ) == (size_t)FileSize );
+		( *ppFileData )[ FileSize ] = '\0';
+		*pFileSize = (unsigned long)FileSize;
+		}
+	if ( pDataFile != 0 )
+		fclose( pDataFile );
+	if ( !bNoError )
+		{
+		if ( *ppFileData != 0 )
+			free( *ppFileData );
+		*ppFileData = 0;
+		}
+
+	return bNoError;
+}
+
+
+BOOL ReadTestDataFile( char *pRelativeFileSpec, char **ppFileData, unsigned long *pFileSize )
+{
+	BOOL			bNoError = TRUE;
+	char			FileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+
+	GetTestDataFileSpec( pRelativeFileSpec, FileSpec, FULL_FILE_SPEC_STRING_LENGTH );
+	bNoError = ReadFileContents( FileSpec, ppFileData, pFileSize );
+	if ( !bNoError )
+		printf( "Unable to read the test data file %s\n", FileSpec );
+
+	return bNoError;
+}
+
+
+// BViewerTest exercises the BViewer modules that do their work without the user interface
+// or OpenGL:  the composition and restoration of the study files, the copying and
+// checking of the standard files, the cache of image previews for the study list, the
+// rows of the study list, the CPU version of the display shaders' grayscale windowing, and
+// the CPU rasterization of saved report pages.
+// Run the program from the BViewerTest folder, or name
+// the test data folder (ending in a backslash) on the command line.  The exit code is the number of failed checks.
+int main( int argc, char *argv[] )
+{
+	if ( argc > 1 )
+		strncpy_s( TestDataDirectory, FULL_FILE_SPEC_STRING_LENGTH, argv[ 1 ], _TRUNCATE );
+
+	printf( "Study files:\n" );
+	TestStudyFile();
+	printf( "\nStandard files:\n" );
+	TestStandardManifest();
+	printf( "\nImage previews:\n" );
+	TestThumbnailCache();
+	printf( "\nStudy list:\n" );
+	TestStudyListModel();
+	printf( "\nGrayscale windowing:\n" );
+	TestGrayscaleWindowing();
+	printf( "\nReport pages:\n" );
+	TestReportRasterizer();
+
+	printf( "\n%ld checks passed, %ld failed.\n", nTestsPassed, nTestsFailed );
+
+	return (int)nTestsFailed;
+}
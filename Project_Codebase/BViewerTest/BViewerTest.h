@@ -0,0 +1,59 @@
+// BViewerTest.h : Defines the functions shared by the BViewer module tests.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#pragma once
+
+
+// The test data files are read from this directory, unless another is named on the
+// command line.
+#define DEFAULT_TEST_DATA_DIRECTORY			".\\TestData\\"
+
+// Study files are written here, read back and then deleted.
+#define TEST_STUDY_FILE_SPEC				".\\BViewerTest.sdy"
+
+// Standard files are copied here, checked and then deleted.  The standard files for the
+// throughput test are generated with the second name.
+#define TEST_COPIED_STANDARD_FILE_SPEC		".\\BViewerTestStandard.dcm"
+#define TEST_STANDARD_MEDIA_FILE_SPEC		".\\BViewerTestMedia%02lu.dcm"
+
+// The image preview cache is saved here, loaded again and then deleted.
+#define TEST_THUMBNAIL_CACHE_FILE_SPEC		".\\BViewerTestThumbnails.dat"
+
+// A report page that doesn't match its golden page is written here, for inspection.
+#define TEST_REPORT_PAGE_FILE_SPEC			".\\BViewerTestReportPage.ppm"
+
+
+// Function prototypes.
+//
+void			CheckTestResult( BOOL bTestPassed, char *pTestDescription );
+void			GetTestDataFileSpec( char *pRelativeFileSpec, char *pFileSpec, size_t nBufferSize );
+BOOL			ReadFileContents( char *pFileSpec, char **ppFileData, unsigned long *pFileSize );
+BOOL			ReadTestDataFile( char *pRelativeFileSpec, char **ppFileData, unsigned long *pFileSize );
+
+void			TestStudyFile();
+void			TestStandardManifest();
+void			TestThumbnailCache();
+void			TestStudyListModel();
+void			TestGrayscaleWindowing();
+void			TestReportRasterizer();
@@ -0,0 +1,58 @@
+# MakeStandardsVectors.py : Generates the standards media files and manifests used by
+#	BViewerTest to check the copying of the standard files and their verification against
+#	the standards manifest in StandardManifest.cpp.
+#
+#	Each media file is a small Dicom-like file:  a 128-byte preamble, "DICM", and then
+#	pseudorandom bytes.  StandardsManifest.txt lists the expected size and CRC-32 of each file,
+#	calculated here with zlib, independently of BViewer.  Some of the media files are then
+#	damaged, so that they no longer match the manifest:
+#
+#		IM000001 - IM000004		Match the manifest.
+#		IM000005				One byte of the file is changed.
+#		IM000006				The file is truncated.
+#		IM000007				Not listed in the manifest.
+#		IM000008				Listed in the manifest, but missing from the media.
+#
+#	BadManifest.txt has a CRC-32 that is not a hexadecimal number.
+#
+#	Usage:  python MakeStandardsVectors.py      (run in this directory)
+#
+import os
+import random
+import zlib
+
+
+FileSizes = [ 6000, 7132, 4096, 9001, 5120, 8192, 3000, 4500 ]
+
+def SOPInstanceUID( nFile ):
+	return "2.25.4711.2022.%d" % nFile
+
+
+def MediaFileContents( nFile ):
+	Random = random.Random( nFile )
+	Body = bytes( Random.getrandbits( 8 ) for _ in range( FileSizes[ nFile - 1 ] - 132 ) )
+	return b"\0" * 128 + b"DICM" + Body
+
+
+Manifest = [ "# I.L.O. standards manifest for the BViewerTest standards media.",
+			"# File name    Size    CRC-32    SOP instance UID" ]
+for nFile in range( 1, 9 ):
+	FileName = "IM%06d" % nFile
+	Contents = MediaFileContents( nFile )
+	if nFile != 7:
+		Manifest.append( "%s  %d  %08X  %s" % ( FileName, len( Contents ), zlib.crc32( Contents ), SOPInstanceUID( nFile ) ) )
+	if nFile == 5:
+		Contents = Contents[ : 1000 ] + bytes( [ Contents[ 1000 ] ^ 0x10 ] ) + Contents[ 1001 : ]
+	elif nFile == 6:
+		Contents = Contents[ : 4000 ]
+	if nFile != 8:
+		with open( FileName, "wb" ) as MediaFile:
+			MediaFile.write( Contents )
+	elif os.path.exists( FileName ):
+		os.remove( FileName )
+
+with open( "StandardsManifest.txt", "w", newline = "\r\n" ) as ManifestFile:
+	ManifestFile.write( "\n".join( Manifest ) + "\n" )
+
+with open( "BadManifest.txt", "w", newline = "\r\n" ) as ManifestFile:
+	ManifestFile.write( "\n".join( Manifest[ : 3 ] + [ "IM000002  7132  NOTACRC  2.25.4711.2022.2" ] ) + "\n" )
@@ -0,0 +1,113 @@
+# MakeStudyFileVectors.py : Generates the sectioned study file used by BViewerTest to check
+#	the study file layout composed by StudyFile.cpp.
+#
+#	Sectioned.sdy is composed here from the layout defined in StudyFile.h and the member tables
+#	in StudyFile.cpp, independently of the C structures, so that the test checks that the file
+#	doesn't depend on the structure packing, pointer size or compiler of the build.  Its contents
+#	are those filled in by FillTestStudyFileContents() in TestStudyFile.cpp for two studies of
+#	two series of three images:  every character array holds its member name, followed in the
+#	diagnostic study, series and image records by the number of the record within the file.
+#	The two must be changed together.
+#
+#	Usage:  python MakeStudyFileVectors.py      (run in this directory)
+#
+import struct
+import zlib
+
+
+SDY_FILE_VERSION_SECTIONED = 5
+HEADER_LENGTH = 32
+SECTION_ENTRY_LENGTH = 16
+
+
+def Text( Value, Size ):
+	Value = Value.encode( "latin-1" )[ : Size - 1 ]
+	return Value + b"\0" * ( Size - len( Value ) )
+
+
+def Date( Year, Month, Day, bDateHasBeenEdited ):
+	# SYSTEMTIME:  year, month, day of week, day, hour, minute, second, milliseconds.
+	return struct.pack( "<8H", Year, Month, 0, Day, 9, 30, 0, 0 ) + struct.pack( "<i", bDateHasBeenEdited )
+
+
+def Names( Members, Suffix = "" ):
+	return b"".join( Text( Name + Suffix, Size ) for Name, Size in Members )
+
+
+StudyRecord = ( Names( [ ( "ReaderAddressed", 32 ), ( "PatientLastName", 32 ), ( "PatientFirstName", 32 ), ( "PatientID", 32 ) ] ) +
+				Date( 1956, 4, 23, 1 ) +
+				Text( "F", 4 ) +
+				Text( "PatientComments", 1024 ) +
+				struct.pack( "<5d", 0.25, 1.5, 2047.5, 4095.0, 4095.0 ) +
+				Names( [ ( "TimeStudyFirstOpened", 32 ), ( "TimeReportApproved", 32 ) ] ) +
+				struct.pack( "<I4i", 17, 1, 0, 1, 0 ) +
+				b"YNY" +
+				struct.pack( "<2I9H3I", 2, 0x00012345, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0x00C0FFEE, 0x00BADCAB, 3 ) +
+				Date( 2001, 2, 3, 0 ) +
+				Date( 2026, 10, 12, 0 ) +
+				Text( "Reserved1", 12 ) +
+				struct.pack( "<H", 4 ) +
+				Names( [ ( "OtherTypeOfReading", 32 ), ( "FacilityIDNumber", 10 ) ] ) +
+				Date( 2026, 10, 19, 1 ) +
+				struct.pack( "<3i", 1, 0, 1 ) )
+
+ImageDefectText = b"The lower right lung zone is obscured by a positioning error."
+CommentsText = b"A healed rib fracture is seen on the left."
+
+ReaderInfo = ( Names( [ ( "LastName", 32 ), ( "ID", 12 ) ] ) + Text( "RDR", 4 ) +
+				Names( [ ( "StreetAddress", 64 ), ( "City", 32 ) ] ) + Text( "GA", 4 ) +
+				Names( [ ( "ZipCode", 12 ), ( "LoginName", 32 ), ( "EncodedPassword", 64 ) ] ) +
+				struct.pack( "<2i", 1, 1 ) +
+				Names( [ ( "AE_TITLE", 20 ), ( "ReportSignatureName", 64 ) ] ) +
+				struct.pack( "<i", 1 ) +
+				Text( "m_CountryInfo.CountryName", 64 ) +
+				struct.pack( "<ib", 3, 12 ) )
+
+ClientInfo = Names( [ ( Name, 128 ) for Name in ( "Name", "StreetAddress", "City", "State", "ZipCode", "Phone", "OtherContactInfo" ) ] )
+
+StudyMembers = [ ( Name, 32 ) for Name in ( "AccessionNumber", "StudyDate", "StudyTime", "ReferringPhysiciansName",
+					"ReferringPhysiciansPhone", "ResponsibleOrganization", "InstitutionName", "StudyID" ) ] + \
+				[ ( "StudyDescription", 1024 ), ( "StudyInstanceUID", 128 ) ]
+SeriesMembers = [ ( Name, 32 ) for Name in ( "Modality", "SeriesNumber", "Laterality", "SeriesDate", "SeriesTime", "ProtocolName" ) ] + \
+				[ ( "SeriesDescription", 1024 ) ] + \
+				[ ( Name, 32 ) for Name in ( "BodyPartExamined", "PatientPosition", "PatientOrientation" ) ] + \
+				[ ( "SeriesInstanceUID", 128 ), ( "Manufacturer", 128 ) ]
+ImageMembers = [ ( Name, 32 ) for Name in ( "ImageType", "InstanceNumber", "InstanceCreationDate", "InstanceCreationTime",
+					"ContentDate", "ContentTime", "AcquisitionNumber", "AcquisitionDate", "AcquisitionTime", "SamplesPerPixel",
+					"PhotometricInterpretation", "Rows", "Columns", "PixelAspectRatio", "BitsAllocated", "BitsStored",
+					"HighBit", "PixelRepresentation", "WindowCenter", "WindowWidth" ) ] + \
+				[ ( "SOPInstanceUID", 128 ) ]
+
+nStudies, nSeriesPerStudy, nImagesPerSeries = 2, 2, 3
+StudyRecords = [ Names( StudyMembers, " %d" % nStudy ) for nStudy in range( nStudies ) ]
+SeriesRecords = [ Names( SeriesMembers, " %d" % nSeries ) for nSeries in range( nStudies * nSeriesPerStudy ) ]
+ImageRecords = [ Names( ImageMembers, " %d" % nImage ) + struct.pack( "<i", 1000 + nImage )
+					for nImage in range( nStudies * nSeriesPerStudy * nImagesPerSeries ) ]
+
+# Section identifier, record length and records, in the order they are composed.
+Sections = [ ( 1, len( StudyRecord ), [ StudyRecord ] ),
+			( 2, 1, [ bytes( [ Byte ] ) for Byte in ImageDefectText ] ),
+			( 3, 1, [ bytes( [ Byte ] ) for Byte in CommentsText ] ),
+			( 4, len( StudyRecords[ 0 ] ), StudyRecords ),
+			( 5, 4, [ struct.pack( "<I", nSeriesPerStudy ) ] * nStudies ),
+			( 6, len( SeriesRecords[ 0 ] ), SeriesRecords ),
+			( 7, 4, [ struct.pack( "<I", nImagesPerSeries ) ] * ( nStudies * nSeriesPerStudy ) ),
+			( 8, len( ImageRecords[ 0 ] ), ImageRecords ),
+			( 9, len( ReaderInfo ), [ ReaderInfo ] ),
+			( 10, len( ClientInfo ), [ ClientInfo ] ) ]
+
+SectionTable = b""
+SectionData = b""
+NextSectionOffset = HEADER_LENGTH + len( Sections ) * SECTION_ENTRY_LENGTH
+for SectionID, RecordLength, Records in Sections:
+	Data = b"".join( Records )
+	Data += b"\0" * ( -len( Data ) % 8 )
+	SectionTable += struct.pack( "<4I", SectionID, NextSectionOffset, RecordLength, len( Records ) )
+	SectionData += Data
+	NextSectionOffset += len( Data )
+Body = SectionTable + SectionData
+FileLength = HEADER_LENGTH + len( Body )
+Header = b"BVSTUDY\0" + struct.pack( "<6I", SDY_FILE_VERSION_SECTIONED, HEADER_LENGTH, SECTION_ENTRY_LENGTH,
+											len( Sections ), FileLength, zlib.crc32( Body ) & 0xFFFFFFFF )
+with open( "Sectioned.sdy", "wb" ) as StudyFile:
+	StudyFile.write( Header + Body )
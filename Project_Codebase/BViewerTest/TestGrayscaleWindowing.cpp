@@ -0,0 +1,432 @@
+// TestGrayscaleWindowing.cpp : Implements the tests of the CPU version of the display shaders'
+//	grayscale windowing, in GrayscaleWindowing.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include <math.h>
+#include "Module.h"
+#include "GrayscaleWindowing.h"
+#include "BViewerTest.h"
+
+
+// The CPU output may differ from the shader output by one output level in each channel, since
+// the shaders calculate in single precision and the GPU rounds the interpolated lookup table
+// value at its own precision.
+#define WINDOWING_TOLERANCE					1
+
+// The benchmark image is a 16-bit 4K frame.
+#define BENCHMARK_IMAGE_WIDTH				3840
+#define BENCHMARK_IMAGE_HEIGHT				2160
+#define BENCHMARK_IMAGE_REPEATS				10
+
+
+typedef struct
+	{
+	int						nStoredBitsPerPixel;
+	int						ImageBitDepth;
+	GRAYSCALE_WINDOWING		Windowing;
+	char					*pDescription;
+	} WINDOWING_TEST_CASE;
+
+
+static WINDOWING_TEST_CASE		WindowingTestCases[] =
+	{
+		{ 16, 16, { 0.0, 0.0, 1.0, FALSE, FALSE }, "16-bit, no window" },
+		{ 16, 16, { 12000.0, 52000.0, 1.0, FALSE, FALSE }, "16-bit, linear window" },
+		{ 16, 16, { 12000.0, 52000.0, 1.0, FALSE, TRUE }, "16-bit, linear window, inverted" },
+		{ 16, 16, { 20000.0, 21000.0, 2.2, FALSE, FALSE }, "16-bit, narrow linear window, gamma 2.2" },
+		{ 16, 16, { 12000.0, 52000.0, 0.45, TRUE, FALSE }, "16-bit, sigmoid window, gamma 0.45" },
+		{ 16, 16, { 100.0, 65000.0, 1.0, TRUE, TRUE }, "16-bit, sigmoid window, inverted" },
+		{ 8, 8, { 0.0, 0.0, 1.0, FALSE, FALSE }, "8-bit, no window" },
+		{ 8, 8, { 40.0, 200.0, 1.8, FALSE, TRUE }, "8-bit, linear window, gamma 1.8, inverted" },
+		{ 8, 8, { 40.0, 200.0, 1.0, TRUE, FALSE }, "8-bit, sigmoid window" },
+	};
+
+#define WINDOWING_TEST_CASE_COUNT			( sizeof(WindowingTestCases) / sizeof(WINDOWING_TEST_CASE) )
+
+
+// A transcription of the body of the windowing fragment shaders in ImageView.cpp, calculating in
+// single precision as the GPU does.  The 10-bit grayscale shader clamps the value before inverting
+// it; the 30-bit color shader leaves the clamping to the frame buffer.
+static float EvaluateWindowingShader( GRAYSCALE_WINDOWING *pWindowing, float MaxGrayIndex, float fRawGrayIndex, BOOL bIs10BitGrayscaleShader )
+{
+	float				WindowMin;
+	float				WindowMax;
+	float				GammaValue;
+	float				fUpScaledGrayIndex;
+	float				fGrayIndex;
+	float				fCorrectedGrayIndex;
+	float				normalizer;
+
+	WindowMin = (float)pWindowing -> WindowMinPixelAmplitude;
+	WindowMax = (float)pWindowing -> WindowMaxPixelAmplitude;
+	GammaValue = (float)pWindowing -> Gamma;
+	normalizer = 1.0f / MaxGrayIndex;
+	fUpScaledGrayIndex = fRawGrayIndex * MaxGrayIndex;
+	if ( WindowMin != 0.0f && WindowMax > 1.0f )
+		{
+		if ( pWindowing -> bWindowingIsSigmoidal )
+			fUpScaledGrayIndex = MaxGrayIndex / ( 1.0f + expf( -4.0f * ( fUpScaledGrayIndex - ( WindowMax - WindowMin ) / 2.0f ) / ( WindowMax - WindowMin ) ) );
+		else if ( fUpScaledGrayIndex <= WindowMin )
+			fUpScaledGrayIndex = 0.0f;
+		else if ( fUpScaledGrayIndex > WindowMax )
+			fUpScaledGrayIndex = MaxGrayIndex;
+		else
+			fUpScaledGrayIndex = ( MaxGrayIndex / ( WindowMax - WindowMin ) ) * ( fUpScaledGrayIndex - WindowMin );
+		}
+	fGrayIndex = fUpScaledGrayIndex * normalizer;
+	fCorrectedGrayIndex = powf( fGrayIndex, GammaValue );
+	if ( bIs10BitGrayscaleShader )
+		{
+		if ( fCorrectedGrayIndex < 0.0f )
+			fCorrectedGrayIndex = 0.0f;
+		if ( fCorrectedGrayIndex > 0.999f )
+			fCorrectedGrayIndex = 0.999f;
+		}
+	if ( pWindowing -> bColorsInverted )
+		fCorrectedGrayIndex = 1.0f - fCorrectedGrayIndex;
+
+	return fCorrectedGrayIndex;
+}
+
+
+// The conversion of a shader output value to a frame buffer level.
+static long QuantizeShaderOutput( float fShaderOutput, long MaxLevel )
+{
+	if ( fShaderOutput < 0.0f )
+		fShaderOutput = 0.0f;
+	if ( fShaderOutput > 1.0f )
+		fShaderOutput = 1.0f;
+
+	return (long)floorf( fShaderOutput * (float)MaxLevel + 0.5f );
+}
+
+
+// A stand-in for the 12-bit grayscale packing table in GraphicsAdapter.cpp, whose channels rise
+// together with small offsets, as they do in the real table.
+static void FillTestPackingTable( unsigned char *pPackingTable )
+{
+	long				nEntry;
+
+	for ( nEntry = 0; nEntry < GRAYSCALE_PACKING_TABLE_SIZE; nEntry++ )
+		{
+		pPackingTable[ nEntry * 3 ] = (unsigned char)( nEntry >> 4 );
+		pPackingTable[ nEntry * 3 + 1 ] = (unsigned char)( ( nEntry + 5 < GRAYSCALE_PACKING_TABLE_SIZE ? nEntry + 5 : nEntry ) >> 4 );
+		pPackingTable[ nEntry * 3 + 2 ] = (unsigned char)( ( nEntry + 11 < GRAYSCALE_PACKING_TABLE_SIZE ? nEntry + 11 : nEntry ) >> 4 );
+		}
+}
+
+
+// The 1D texture lookup performed by the 10-bit grayscale shader, with linear filtering and a
+// black border, in single precision.
+static void SampleTestPackingTable( unsigned char *pPackingTable, float TextureCoordinate, long *pRGBLevels )
+{
+	float				TexelPosition;
+	float				Fraction;
+	long				nLowerTexel;
+	int					nChannel;
+	float				LowerValue;
+	float				UpperValue;
+
+	TexelPosition = TextureCoordinate * (float)GRAYSCALE_PACKING_TABLE_SIZE - 0.5f;
+	nLowerTexel = (long)floorf( TexelPosition );
+	Fraction = TexelPosition - (float)nLowerTexel;
+	for ( nChannel = 0; nChannel < 3; nChannel++ )
+		{
+		LowerValue = ( nLowerTexel >= 0 && nLowerTexel < GRAYSCALE_PACKING_TABLE_SIZE ) ? (float)pPackingTable[ nLowerTexel * 3 + nChannel ] / 255.0f : 0.0f;
+		UpperValue = ( nLowerTexel + 1 >= 0 && nLowerTexel + 1 < GRAYSCALE_PACKING_TABLE_SIZE ) ? (float)pPackingTable[ ( nLowerTexel + 1 ) * 3 + nChannel ] / 255.0f : 0.0f;
+		pRGBLevels[ nChannel ] = QuantizeShaderOutput( LowerValue + Fraction * ( UpperValue - LowerValue ), 255 );
+		}
+}
+
+
+// Compare every entry of the windowing table with the shader's output for the same stored pixel
+// value.  Return the largest difference found, in output levels.
+static long CompareWithShader( WINDOWING_TEST_CASE *pTestCase, int OutputFormat, unsigned char *pPackingTable )
+{
+	GRAYSCALE_WINDOWING_TABLE	WindowingTable;
+	long						LargestDifference = 0;
+	long						Difference;
+	unsigned long				nPixelValue;
+	float						MaxGrayIndex;
+	float						fRawGrayIndex;
+	float						fShaderOutput;
+	long						ShaderLevel;
+	long						ShaderRGBLevels[ 3 ];
+	long						CPULevel;
+	int							nChannel;
+
+	if ( PrepareGrayscaleWindowingTable( &WindowingTable, &pTestCase -> Windowing, pTestCase -> nStoredBitsPerPixel,
+											pTestCase -> ImageBitDepth, OutputFormat, pPackingTable ) )
+		{
+		MaxGrayIndex = (float)( 2 << ( pTestCase -> ImageBitDepth - 1 ) );
+		for ( nPixelValue = 0; nPixelValue < WindowingTable.nTableEntries; nPixelValue++ )
+			{
+			// The texture sampler normalizes the stored value.
+			fRawGrayIndex = (float)nPixelValue / (float)( WindowingTable.nTableEntries - 1 );
+			fShaderOutput = EvaluateWindowingShader( &pTestCase -> Windowing, MaxGrayIndex, fRawGrayIndex, ( OutputFormat == GRAYSCALE_OUTPUT_PACKED_RGB ) );
+			if ( OutputFormat == GRAYSCALE_OUTPUT_PACKED_RGB )
+				{
+				SampleTestPackingTable( pPackingTable, fShaderOutput, ShaderRGBLevels );
+				for ( nChannel = 0; nChannel < 3; nChannel++ )
+					{
+					Difference = labs( (long)WindowingTable.pOutputTable[ nPixelValue * 3 + nChannel ] - ShaderRGBLevels[ nChannel ] );
+					if ( Difference > LargestDifference )
+						LargestDifference = Difference;
+					}
+				}
+			else
+				{
+				if ( OutputFormat == GRAYSCALE_OUTPUT_8BIT )
+					{
+					ShaderLevel = QuantizeShaderOutput( fShaderOutput, 255 );
+					CPULevel = (long)WindowingTable.pOutputTable[ nPixelValue ];
+					}
+				else
+					{
+					ShaderLevel = QuantizeShaderOutput( fShaderOutput, 1023 );
+					CPULevel = (long)( (unsigned short*)WindowingTable.pOutputTable )[ nPixelValue ];
+					}
+				Difference = labs( CPULevel - ShaderLevel );
+				if ( Difference > LargestDifference )
+					LargestDifference = Difference;
+				}
+			}
+		ReleaseGrayscaleWindowingTable( &WindowingTable );
+		}
+	else
+		LargestDifference = 65536;
+
+	return LargestDifference;
+}
+
+
+// Every output level matches the shader's, within the tolerance, for each output format.
+static void TestWindowingMatchesShaders()
+{
+	unsigned char			PackingTable[ GRAYSCALE_PACKING_TABLE_SIZE * 3 ];
+	unsigned long			nTestCase;
+	long					LargestDifference;
+	long					LargestDifferenceForFormat[ 3 ];
+	int						nFormat;
+	int						OutputFormats[ 3 ] = { GRAYSCALE_OUTPUT_8BIT, GRAYSCALE_OUTPUT_10BIT, GRAYSCALE_OUTPUT_PACKED_RGB };
+	char					TestDescription[ 256 ];
+
+	FillTestPackingTable( PackingTable );
+	for ( nFormat = 0; nFormat < 3; nFormat++ )
+		LargestDifferenceForFormat[ nFormat ] = 0;
+	for ( nTestCase = 0; nTestCase < WINDOWING_TEST_CASE_COUNT; nTestCase++ )
+		{
+		LargestDifference = 0;
+		for ( nFormat = 0; nFormat < 3; nFormat++ )
+			{
+			LargestDifferenceForFormat[ nFormat ] = CompareWithShader( &WindowingTestCases[ nTestCase ], OutputFormats[ nFormat ], PackingTable );
+			if ( LargestDifferenceForFormat[ nFormat ] > LargestDifference )
+				LargestDifference = LargestDifferenceForFormat[ nFormat ];
+			}
+		_snprintf_s( TestDescription, 256, _TRUNCATE, "%s:  8-bit, 10-bit and packed RGB output within %d level of the shaders (%ld, %ld, %ld).",
+						WindowingTestCases[ nTestCase ].pDescription, WINDOWING_TOLERANCE,
+						LargestDifferenceForFormat[ 0 ], LargestDifferenceForFormat[ 1 ], LargestDifferenceForFormat[ 2 ] );
+		CheckTestResult( LargestDifference <= WINDOWING_TOLERANCE, TestDescription );
+		}
+}
+
+
+// Check a few output values worked out by hand, and the conversion of a run of pixels.
+static void TestWindowingValues()
+{
+	BOOL						bNoError = TRUE;
+	GRAYSCALE_WINDOWING			Windowing = { 16384.0, 49152.0, 1.0, FALSE, FALSE };
+	GRAYSCALE_WINDOWING_TABLE	WindowingTable;
+	unsigned short				InputPixels[ 5 ] = { 0, 16384, 32768, 49152, 65535 };
+	unsigned char				Output8BitPixels[ 5 ];
+	unsigned char				ExpectedNormal[ 5 ] = { 0, 0, 128, 255, 255 };
+	unsigned char				ExpectedInverted[ 5 ] = { 255, 255, 127, 0, 0 };
+	unsigned short				Output10BitPixels[ 5 ];
+	unsigned short				Expected10Bit[ 5 ] = { 0, 0, 512, 1023, 1023 };
+	unsigned char				Input8BitPixels[ 4 ] = { 0, 64, 128, 255 };
+	unsigned char				Expected8BitInput[ 4 ] = { 0, 64, 128, 255 };
+	unsigned char				PackingTable[ GRAYSCALE_PACKING_TABLE_SIZE * 3 ];
+	unsigned char				OutputRGBPixels[ 5 * 3 ];
+
+	bNoError = PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 16, 16, GRAYSCALE_OUTPUT_8BIT, 0 );
+	if ( bNoError )
+		{
+		WindowGrayscalePixels( &WindowingTable, InputPixels, 5, Output8BitPixels );
+		bNoError = ( memcmp( Output8BitPixels, ExpectedNormal, 5 ) == 0 );
+		ReleaseGrayscaleWindowingTable( &WindowingTable );
+		}
+	Windowing.bColorsInverted = TRUE;
+	if ( bNoError && PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 16, 16, GRAYSCALE_OUTPUT_8BIT, 0 ) )
+		{
+		WindowGrayscalePixels( &WindowingTable, InputPixels, 5, Output8BitPixels );
+		bNoError = ( memcmp( Output8BitPixels, ExpectedInverted, 5 ) == 0 );
+		ReleaseGrayscaleWindowingTable( &WindowingTable );
+		}
+	Windowing.bColorsInverted = FALSE;
+	if ( bNoError && PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 16, 16, GRAYSCALE_OUTPUT_10BIT, 0 ) )
+		{
+		WindowGrayscalePixels( &WindowingTable, InputPixels, 5, Output10BitPixels );
+		bNoError = ( memcmp( Output10BitPixels, Expected10Bit, sizeof(Expected10Bit) ) == 0 );
+		ReleaseGrayscaleWindowingTable( &WindowingTable );
+		}
+	CheckTestResult( bNoError, "A linear window maps its limits to black and white, and its center to mid-gray." );
+
+	// Without a window, an 8-bit image is unchanged.
+	Windowing.WindowMinPixelAmplitude = 0.0;
+	Windowing.WindowMaxPixelAmplitude = 0.0;
+	bNoError = PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 8, 8, GRAYSCALE_OUTPUT_8BIT, 0 );
+	if ( bNoError )
+		{
+		WindowGrayscalePixels( &WindowingTable, Input8BitPixels, 4, Output8BitPixels );
+		bNoError = ( memcmp( Output8BitPixels, Expected8BitInput, 4 ) == 0 );
+		ReleaseGrayscaleWindowingTable( &WindowingTable );
+		}
+	CheckTestResult( bNoError, "An 8-bit image without a window is output unchanged." );
+
+	// Packed pixels take the table entry for their 12-bit gray index.
+	FillTestPackingTable( PackingTable );
+	bNoError = PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 16, 16, GRAYSCALE_OUTPUT_PACKED_RGB, PackingTable );
+	if ( bNoError )
+		{
+		WindowGrayscalePixels( &WindowingTable, InputPixels, 5, OutputRGBPixels );
+		bNoError = ( memcmp( OutputRGBPixels, PackingTable, 3 ) == 0 &&
+						OutputRGBPixels[ 4 * 3 ] == PackingTable[ 4091 * 3 ] && OutputRGBPixels[ 2 * 3 ] == PackingTable[ 2048 * 3 ] );
+		ReleaseGrayscaleWindowingTable( &WindowingTable );
+		}
+	CheckTestResult( bNoError, "Packed RGB pixels are taken from the 12-bit grayscale lookup table." );
+
+	// Unsupported requests are refused.
+	bNoError = !PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 12, 12, GRAYSCALE_OUTPUT_8BIT, 0 ) &&
+				!PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 16, 16, GRAYSCALE_OUTPUT_PACKED_RGB, 0 ) &&
+				!PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 16, 16, 0, 0 );
+	CheckTestResult( bNoError, "Unsupported pixel sizes and output formats are refused." );
+}
+
+
+static double GetElapsedMilliseconds( LARGE_INTEGER *pStartTime, LARGE_INTEGER *pCounterFrequency )
+{
+	LARGE_INTEGER			EndTime;
+
+	QueryPerformanceCounter( &EndTime );
+
+	return (double)( EndTime.QuadPart - pStartTime -> QuadPart ) * 1000.0 / (double)pCounterFrequency -> QuadPart;
+}
+
+
+// Measure the time to window a 16-bit 4K image into each output format, against calculating
+// the windowing formula for each pixel.
+static void TestWindowingThroughput()
+{
+	BOOL						bNoError = TRUE;
+	GRAYSCALE_WINDOWING			Windowing = { 12000.0, 52000.0, 0.8, TRUE, FALSE };
+	GRAYSCALE_WINDOWING_TABLE	WindowingTable;
+	unsigned long				nPixels;
+	unsigned long				nPixel;
+	unsigned long				nRow;
+	unsigned long				nRepeat;
+	unsigned short				*pInputImage;
+	unsigned char				*pOutputImage;
+	unsigned char				PackingTable[ GRAYSCALE_PACKING_TABLE_SIZE * 3 ];
+	int							nFormat;
+	int							OutputFormats[ 3 ] = { GRAYSCALE_OUTPUT_8BIT, GRAYSCALE_OUTPUT_10BIT, GRAYSCALE_OUTPUT_PACKED_RGB };
+	char						*pFormatNames[ 3 ] = { "8-bit", "10-bit", "packed RGB" };
+	double						TableMilliseconds[ 3 ];
+	double						ImageMilliseconds[ 3 ];
+	double						FormulaMilliseconds;
+	double						CorrectedGrayIndex;
+	BOOL						bOutputMatches;
+	LARGE_INTEGER				CounterFrequency;
+	LARGE_INTEGER				StartTime;
+
+	QueryPerformanceFrequency( &CounterFrequency );
+	FillTestPackingTable( PackingTable );
+	nPixels = BENCHMARK_IMAGE_WIDTH * BENCHMARK_IMAGE_HEIGHT;
+	pInputImage = (unsigned short*)malloc( nPixels * sizeof(unsigned short) );
+	pOutputImage = (unsigned char*)malloc( nPixels * 3 );
+	bNoError = ( pInputImage != 0 && pOutputImage != 0 );
+	if ( bNoError )
+		{
+		// A gradient, with noise, so that the table lookups are scattered.
+		for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+			pInputImage[ nPixel ] = (unsigned short)( ( ( nPixel % BENCHMARK_IMAGE_WIDTH ) * 17 + ( nPixel / BENCHMARK_IMAGE_WIDTH ) * 11 + ( nPixel * 2654435761UL >> 22 ) ) & 0xFFFF );
+		}
+	for ( nFormat = 0; nFormat < 3 && bNoError; nFormat++ )
+		{
+		QueryPerformanceCounter( &StartTime );
+		bNoError = PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 16, 16, OutputFormats[ nFormat ], PackingTable );
+		TableMilliseconds[ nFormat ] = GetElapsedMilliseconds( &StartTime, &CounterFrequency );
+		if ( bNoError )
+			{
+			QueryPerformanceCounter( &StartTime );
+			for ( nRepeat = 0; nRepeat < BENCHMARK_IMAGE_REPEATS; nRepeat++ )
+				for ( nRow = 0; nRow < BENCHMARK_IMAGE_HEIGHT; nRow++ )
+					WindowGrayscalePixels( &WindowingTable, &pInputImage[ nRow * BENCHMARK_IMAGE_WIDTH ], BENCHMARK_IMAGE_WIDTH,
+											&pOutputImage[ nRow * BENCHMARK_IMAGE_WIDTH * 3 ] );
+			ImageMilliseconds[ nFormat ] = GetElapsedMilliseconds( &StartTime, &CounterFrequency ) / BENCHMARK_IMAGE_REPEATS;
+			ReleaseGrayscaleWindowingTable( &WindowingTable );
+			}
+		}
+	CheckTestResult( bNoError, "A 16-bit 4K image is windowed into 8-bit, 10-bit and packed RGB output." );
+
+	// For comparison, the formula calculated for every pixel, as the shader does.
+	FormulaMilliseconds = 0.0;
+	bOutputMatches = FALSE;
+	if ( bNoError && PrepareGrayscaleWindowingTable( &WindowingTable, &Windowing, 16, 16, GRAYSCALE_OUTPUT_8BIT, 0 ) )
+		{
+		QueryPerformanceCounter( &StartTime );
+		for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+			{
+			CorrectedGrayIndex = CalculateCorrectedGrayIndex( &Windowing, 65536.0, (double)pInputImage[ nPixel ] / 65535.0 );
+			if ( CorrectedGrayIndex > 1.0 )
+				CorrectedGrayIndex = 1.0;
+			pOutputImage[ nPixel ] = (unsigned char)( CorrectedGrayIndex * 255.0 + 0.5 );
+			}
+		FormulaMilliseconds = GetElapsedMilliseconds( &StartTime, &CounterFrequency );
+		bOutputMatches = TRUE;
+		for ( nPixel = 0; nPixel < nPixels && bOutputMatches; nPixel++ )
+			bOutputMatches = ( pOutputImage[ nPixel ] == WindowingTable.pOutputTable[ pInputImage[ nPixel ] ] );
+		ReleaseGrayscaleWindowingTable( &WindowingTable );
+		}
+	CheckTestResult( bOutputMatches, "The table gives the same 4K image as calculating each pixel." );
+	if ( bNoError )
+		{
+		for ( nFormat = 0; nFormat < 3; nFormat++ )
+			printf( "    %s output:  table prepared in %.2f ms, %dx%d image windowed in %.2f ms (%.0f megapixels/s).\n",
+						pFormatNames[ nFormat ], TableMilliseconds[ nFormat ], BENCHMARK_IMAGE_WIDTH, BENCHMARK_IMAGE_HEIGHT,
+						ImageMilliseconds[ nFormat ], (double)nPixels / ( ImageMilliseconds[ nFormat ] * 1000.0 ) );
+		printf( "    Calculating the formula for each pixel took %.1f ms.\n", FormulaMilliseconds );
+		}
+	if ( pInputImage != 0 )
+		free( pInputImage );
+	if ( pOutputImage != 0 )
+		free( pOutputImage );
+}
+
+
+void TestGrayscaleWindowing()
+{
+	TestWindowingMatchesShaders();
+	TestWindowingValues();
+	TestWindowingThroughput();
+}
@@ -0,0 +1,747 @@
+// TestReportRasterizer.cpp : Implements the tests of the CPU rendering of report pages, in
+//	ReportRasterizer.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ReportRasterizer.h"
+#include "BViewerTest.h"
+#include "zlib.h"
+
+
+// The golden page may differ from the rasterized page by one level in each channel, for
+// differences in floating point rounding between compilers.
+#define GOLDEN_PAGE_TOLERANCE				1
+#define GOLDEN_PAGE_WIDTH					240
+#define GOLDEN_PAGE_HEIGHT					310
+
+// The benchmark pages are the size of a report form scanned at 200 pixels per inch, with
+// about as much drawing as a fully completed page 1.
+#define BENCHMARK_PAGE_WIDTH				1700
+#define BENCHMARK_PAGE_HEIGHT				2200
+#define BENCHMARK_PAGE_COUNT				8
+#define BENCHMARK_CHECKMARK_COUNT			40
+#define BENCHMARK_TEXT_LINE_COUNT			24
+
+#define TEST_FONT_SIZE						128
+
+
+// A test glyph, in the form of a GLYPH_BITMAP_INFO from GetGlyphOutline():  the black box
+// dimensions, its origin relative to the pen position, the pen advance, and the coverage rows
+// from the top down, padded to a multiple of 4 bytes.
+typedef struct
+	{
+	long					Width;
+	long					Height;
+	long					OriginX;
+	long					OriginY;
+	long					CellIncX;
+	unsigned char			*pBitmap;
+	} TEST_GLYPH;
+
+
+// Fill the glyphs for the printable characters with a recognizable coverage pattern:  an
+// outline, a diagonal stroke and a bar whose height depends upon the character.  The row
+// padding is filled with full coverage, so that any reading of it shows up on the page.
+static BOOL CreateTestFont( TEST_GLYPH *pTestFont, long FontHeight )
+{
+	BOOL					bNoError = TRUE;
+	int						nChar;
+	TEST_GLYPH				*pGlyph;
+	long					RowPitch;
+	long					nRow;
+	long					nColumn;
+	long					Diagonal;
+	unsigned char			Coverage;
+
+	memset( pTestFont, 0, TEST_FONT_SIZE * sizeof(TEST_GLYPH) );
+	for ( nChar = 0; nChar < TEST_FONT_SIZE && bNoError; nChar++ )
+		{
+		pGlyph = &pTestFont[ nChar ];
+		pGlyph -> CellIncX = FontHeight / 2;
+		if ( nChar > ' ' && nChar < 127 )
+			{
+			pGlyph -> Width = FontHeight / 2 + nChar % 4;
+			pGlyph -> Height = FontHeight - nChar % 3;
+			pGlyph -> OriginX = 1;
+			pGlyph -> OriginY = pGlyph -> Height;
+			if ( nChar % 5 == 0 )
+				pGlyph -> OriginY -= FontHeight / 5;		// A descender.
+			pGlyph -> CellIncX = pGlyph -> Width + 2;
+			RowPitch = ( pGlyph -> Width + 3 ) & ~3;
+			pGlyph -> pBitmap = (unsigned char*)malloc( RowPitch * pGlyph -> Height );
+			bNoError = ( pGlyph -> pBitmap != 0 );
+			if ( bNoError )
+				{
+				memset( pGlyph -> pBitmap, 0xFF, RowPitch * pGlyph -> Height );
+				for ( nRow = 0; nRow < pGlyph -> Height; nRow++ )
+					for ( nColumn = 0; nColumn < pGlyph -> Width; nColumn++ )
+						{
+						Diagonal = labs( nColumn * pGlyph -> Height - nRow * pGlyph -> Width );
+						if ( nRow == 0 || nColumn == 0 || nRow == pGlyph -> Height - 1 || nColumn == pGlyph -> Width - 1 )
+							Coverage = 64;
+						else if ( Diagonal < pGlyph -> Height )
+							Coverage = 48;
+						else if ( Diagonal < 2 * pGlyph -> Height )
+							Coverage = 20;
+						else if ( nRow == nChar % pGlyph -> Height )
+							Coverage = 32;
+						else
+							Coverage = 0;
+						pGlyph -> pBitmap[ nRow * RowPitch + nColumn ] = Coverage;
+						}
+				}
+			}
+		}
+
+	return bNoError;
+}
+
+
+static void ReleaseTestFont( TEST_GLYPH *pTestFont )
+{
+	int						nChar;
+
+	for ( nChar = 0; nChar < TEST_FONT_SIZE; nChar++ )
+		if ( pTestFont[ nChar ].pBitmap != 0 )
+			free( pTestFont[ nChar ].pBitmap );
+	memset( pTestFont, 0, TEST_FONT_SIZE * sizeof(TEST_GLYPH) );
+}
+
+
+// Record a text string as CImageView::RecordReportTextString() does.
+static void AddTestText( REPORT_PAGE *pReportPage, TEST_GLYPH *pTestFont, char *pTextString, float x, float y, float Color[ 3 ] )
+{
+	size_t					nChar;
+	TEST_GLYPH				*pGlyph;
+
+	for ( nChar = 0; nChar < strlen( pTextString ); nChar++ )
+		{
+		pGlyph = &pTestFont[ pTextString[ nChar ] & 0x7F ];
+		if ( pGlyph -> pBitmap != 0 )
+			AddReportGlyph( pReportPage, pGlyph -> pBitmap, pGlyph -> Width, pGlyph -> Height,
+								x + (float)pGlyph -> OriginX, y + (float)( pGlyph -> OriginY - pGlyph -> Height ), Color );
+		x += (float)pGlyph -> CellIncX;
+		}
+}
+
+
+// Record the two strokes of an "X" mark as CImageView::RenderReport() lays them out.
+static void AddTestCheckmark( REPORT_PAGE *pReportPage, float x, float y, float MarkSize, float LineWidth )
+{
+	float					Vertex[ 4 ][ 2 ];
+	float					Color[ 3 ] = { 0.0f, 0.0f, 0.5f };
+
+	Vertex[ 0 ][ 0 ] = x;							Vertex[ 0 ][ 1 ] = y;
+	Vertex[ 1 ][ 0 ] = x + LineWidth;				Vertex[ 1 ][ 1 ] = y;
+	Vertex[ 2 ][ 0 ] = x + MarkSize;				Vertex[ 2 ][ 1 ] = y + MarkSize;
+	Vertex[ 3 ][ 0 ] = x + MarkSize + LineWidth;	Vertex[ 3 ][ 1 ] = y + MarkSize;
+	AddReportQuad( pReportPage, Vertex, Color );
+	Vertex[ 0 ][ 0 ] = x + MarkSize;				Vertex[ 0 ][ 1 ] = y;
+	Vertex[ 1 ][ 0 ] = x + MarkSize + LineWidth;	Vertex[ 1 ][ 1 ] = y;
+	Vertex[ 2 ][ 0 ] = x;							Vertex[ 2 ][ 1 ] = y + MarkSize;
+	Vertex[ 3 ][ 0 ] = x + LineWidth;				Vertex[ 3 ][ 1 ] = y + MarkSize;
+	AddReportQuad( pReportPage, Vertex, Color );
+}
+
+
+// A blank form:  ruled lines and boxes on an off-white page, in RGB rows from the bottom up.
+static unsigned char *CreateTestForm( long Width, long Height )
+{
+	unsigned char			*pFormPixels;
+	unsigned char			*pPixel;
+	long					nRow;
+	long					nColumn;
+
+	pFormPixels = (unsigned char*)malloc( Width * Height * 3 );
+	if ( pFormPixels != 0 )
+		{
+		pPixel = pFormPixels;
+		for ( nRow = 0; nRow < Height; nRow++ )
+			for ( nColumn = 0; nColumn < Width; nColumn++ )
+				{
+				if ( nRow % 24 == 5 )
+					{
+					pPixel[ 0 ] = 120;
+					pPixel[ 1 ] = 120;
+					pPixel[ 2 ] = 160;
+					}
+				else if ( nColumn % 40 == 7 )
+					{
+					pPixel[ 0 ] = 200;
+					pPixel[ 1 ] = 200;
+					pPixel[ 2 ] = 220;
+					}
+				else
+					{
+					pPixel[ 0 ] = 248;
+					pPixel[ 1 ] = 246;
+					pPixel[ 2 ] = 240;
+					}
+				pPixel += 3;
+				}
+		}
+
+	return pFormPixels;
+}
+
+
+// A signature bitmap, in the form of a 24-bit bitmap file's image data, with its row padding
+// filled with a color that would show up on the page.
+static unsigned char *CreateTestSignature( long Width, long Height )
+{
+	unsigned char			*pBitmapPixels;
+	unsigned char			*pPixel;
+	long					RowPitch;
+	long					nRow;
+	long					nColumn;
+
+	RowPitch = ( Width * 3 + 3 ) & ~3;
+	pBitmapPixels = (unsigned char*)malloc( RowPitch * Height );
+	if ( pBitmapPixels != 0 )
+		{
+		memset( pBitmapPixels, 0xEE, RowPitch * Height );
+		for ( nRow = 0; nRow < Height; nRow++ )
+			for ( nColumn = 0; nColumn < Width; nColumn++ )
+				{
+				pPixel = &pBitmapPixels[ nRow * RowPitch + nColumn * 3 ];
+				if ( ( nColumn * nColumn / 7 + nRow * 3 ) % 11 < 3 )
+					{
+					pPixel[ 0 ] = 20;
+					pPixel[ 1 ] = 30;
+					pPixel[ 2 ] = (unsigned char)( 120 + nColumn % 50 );
+					}
+				else
+					{
+					pPixel[ 0 ] = 255;
+					pPixel[ 1 ] = 255;
+					pPixel[ 2 ] = (unsigned char)( 255 - nRow );
+					}
+				}
+		}
+
+	return pBitmapPixels;
+}
+
+
+// Record the drawing of the golden page:  checkmarks, two fonts of text, some of it over a
+// checkmark, and a signature scaled up by a fractional factor.
+static void RecordGoldenPage( REPORT_PAGE *pReportPage, TEST_GLYPH *pLargeFont, TEST_GLYPH *pSmallFont, unsigned char *pSignaturePixels )
+{
+	float					TextColor[ 3 ] = { 0.0f, 0.0f, 1.0f };
+	float					ItalicColor[ 3 ] = { 0.3f, 0.1f, 0.6f };
+
+	AddTestCheckmark( pReportPage, 20.37f, 270.81f, 13.09f, 5.2f );
+	AddTestCheckmark( pReportPage, 61.5f, 270.81f, 13.09f, 5.2f );
+	AddTestCheckmark( pReportPage, 150.0f, 231.0f, 13.09f, 5.2f );
+	AddTestCheckmark( pReportPage, 190.42f, 200.13f, 9.12f, 3.6f );
+	AddTestCheckmark( pReportPage, 30.9f, 150.66f, 9.12f, 3.6f );
+	AddTestCheckmark( pReportPage, 231.2f, 100.0f, 13.09f, 5.2f );
+	AddTestText( pReportPage, pLargeFont, "10/19/2026", 12.35f, 244.6f, TextColor );
+	AddTestText( pReportPage, pSmallFont, "Small opacities, both lungs.", 8.0f, 210.25f, TextColor );
+	AddTestText( pReportPage, pSmallFont, "Over the mark", 140.7f, 233.4f, ItalicColor );
+	AddTestText( pReportPage, pLargeFont, "ABC xyz 0123", 20.5f, 120.0f, TextColor );
+	AddTestText( pReportPage, pSmallFont, "Reader 987", 150.25f, 58.5f, TextColor );
+	AddReportBitmap( pReportPage, pSignaturePixels, 37, 11, 130.4f, 20.7f, 37.0f * 2.3f, 11.0f * 2.3f );
+}
+
+
+// Write a page as a binary PPM file, with the rows from the top down.
+static BOOL WriteReportPageFile( REPORT_PAGE *pReportPage, char *pFileSpec )
+{
+	BOOL					bNoError = TRUE;
+	FILE					*pPageFile;
+	long					nRow;
+
+	pPageFile = fopen( pFileSpec, "wb" );
+	bNoError = ( pPageFile != 0 );
+	if ( bNoError )
+		{
+		fprintf( pPageFile, "P6\n%ld %ld\n255\n", pReportPage -> WidthInPixels, pReportPage -> HeightInPixels );
+		for ( nRow = pReportPage -> HeightInPixels - 1; nRow >= 0 && bNoError; nRow-- )
+			bNoError = ( fwrite( &pReportPage -> pPixels[ (size_t)nRow * pReportPage -> WidthInPixels * 3 ], 3,
+																pReportPage -> WidthInPixels, pPageFile ) == (size_t)pReportPage -> WidthInPixels );
+		fclose( pPageFile );
+		}
+
+	return bNoError;
+}
+
+
+// Read a gzip-compressed binary PPM golden page into RGB rows from the bottom up, as a
+// report page is stored.
+static BOOL ReadGoldenPageFile( char *pRelativeFileSpec, long ExpectedWidth, long ExpectedHeight, unsigned char **ppGoldenPixels )
+{
+	BOOL					bNoError = TRUE;
+	char					FileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+	gzFile					GoldenFile;
+	char					HeaderLine[ 64 ];
+	long					Width = 0;
+	long					Height = 0;
+	long					nRow;
+	int						nRowBytes;
+
+	*ppGoldenPixels = 0;
+	GetTestDataFileSpec( pRelativeFileSpec, FileSpec, FULL_FILE_SPEC_STRING_LENGTH );
+	GoldenFile = gzopen( FileSpec, "rb" );
+	bNoError = ( GoldenFile != 0 );
+	if ( bNoError )
+		bNoError = ( gzgets( GoldenFile, HeaderLine, sizeof( HeaderLine ) ) != 0 && strncmp( HeaderLine, "P6", 2 ) == 0 &&
+						gzgets( GoldenFile, HeaderLine, sizeof( HeaderLine ) ) != 0 && sscanf( HeaderLine, "%ld %ld", &Width, &Height ) == 2 &&
+						gzgets( GoldenFile, HeaderLine, sizeof( HeaderLine ) ) != 0 && strncmp( HeaderLine, "255", 3 ) == 0 &&
+						Width == ExpectedWidth && Height == ExpectedHeight );
+	if ( bNoError )
+		{
+		*ppGoldenPixels = (unsigned char*)malloc( Width * Height * 3 );
+		bNoError = ( *ppGoldenPixels != 0 );
+		}
+	nRowBytes = (int)( Width * 3 );
+	for ( nRow = Height - 1; nRow >= 0 && bNoError; nRow-- )
+		bNoError = ( gzread( GoldenFile, &( *ppGoldenPixels )[ nRow * nRowBytes ], nRowBytes ) == nRowBytes );
+	if ( GoldenFile != 0 )
+		gzclose( GoldenFile );
+	if ( !bNoError )
+		{
+		printf( "Unable to read the golden page file %s\n", FileSpec );
+		if ( *ppGoldenPixels != 0 )
+			free( *ppGoldenPixels );
+		*ppGoldenPixels = 0;
+		}
+
+	return bNoError;
+}
+
+
+// Count the pixels that differ, and find the largest difference in any channel.
+static void ComparePagePixels( unsigned char *pPixels, unsigned char *pExpectedPixels, long nPixels, long *pnDifferentPixels, int *pMaxDifference )
+{
+	long					nPixel;
+	int						nChannel;
+	int						Difference;
+	BOOL					bPixelDiffers;
+
+	*pnDifferentPixels = 0;
+	*pMaxDifference = 0;
+	for ( nPixel = 0; nPixel < nPixels; nPixel++ )
+		{
+		bPixelDiffers = FALSE;
+		for ( nChannel = 0; nChannel < 3; nChannel++ )
+			{
+			Difference = abs( (int)pPixels[ nPixel * 3 + nChannel ] - (int)pExpectedPixels[ nPixel * 3 + nChannel ] );
+			if ( Difference > 0 )
+				bPixelDiffers = TRUE;
+			if ( Difference > *pMaxDifference )
+				*pMaxDifference = Difference;
+			}
+		if ( bPixelDiffers )
+			( *pnDifferentPixels )++;
+		}
+}
+
+
+static BOOL PixelEquals( REPORT_PAGE *pReportPage, long nColumn, long nRow, int Red, int Green, int Blue )
+{
+	unsigned char			*pPixel;
+
+	pPixel = &pReportPage -> pPixels[ ( nRow * pReportPage -> WidthInPixels + nColumn ) * 3 ];
+
+	return ( pPixel[ 0 ] == Red && pPixel[ 1 ] == Green && pPixel[ 2 ] == Blue );
+}
+
+
+static void TestReportPagePreparation()
+{
+	BOOL					bNoError = TRUE;
+	REPORT_PAGE				ReportPage;
+	unsigned char			*pFormPixels;
+	float					Vertex[ 4 ][ 2 ] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 1.0f } };
+	float					Color[ 3 ] = { 1.0f, 0.0f, 0.0f };
+	long					nDrawing;
+
+	pFormPixels = CreateTestForm( 50, 30 );
+	bNoError = ( pFormPixels != 0 && InitializeReportPage( &ReportPage, 50, 30, pFormPixels ) );
+	CheckTestResult( bNoError && memcmp( ReportPage.pPixels, pFormPixels, 50 * 30 * 3 ) == 0 && ReportPage.nDrawings == 0,
+						"A report page starts as a copy of the report form." );
+	if ( bNoError )
+		{
+		for ( nDrawing = 0; nDrawing < 3 * REPORT_DRAWING_ALLOCATION_UNIT && bNoError; nDrawing++ )
+			bNoError = AddReportQuad( &ReportPage, Vertex, Color );
+		CheckTestResult( bNoError && ReportPage.nDrawings == 3 * REPORT_DRAWING_ALLOCATION_UNIT &&
+							ReportPage.pDrawingArray[ 2 * REPORT_DRAWING_ALLOCATION_UNIT + 5 ].DrawingType == REPORT_DRAWING_QUAD,
+							"The drawing list grows as drawings are recorded." );
+		ReleaseReportPage( &ReportPage );
+		}
+	if ( pFormPixels != 0 )
+		free( pFormPixels );
+
+	bNoError = InitializeReportPage( &ReportPage, 4, 2, 0 );
+	CheckTestResult( bNoError && PixelEquals( &ReportPage, 0, 0, 0, 0, 0 ) && PixelEquals( &ReportPage, 3, 1, 0, 0, 0 ),
+						"A report page without a form starts black." );
+	if ( bNoError )
+		{
+		bNoError = !AddReportGlyph( &ReportPage, 0, 3, 3, 0.0f, 0.0f, Color ) &&
+					!AddReportBitmap( &ReportPage, ReportPage.pPixels, 0, 1, 0.0f, 0.0f, 1.0f, 1.0f ) &&
+					ReportPage.nDrawings == 0;
+		CheckTestResult( bNoError, "Empty glyphs and bitmaps aren't recorded." );
+		ReleaseReportPage( &ReportPage );
+		}
+	CheckTestResult( !InitializeReportPage( &ReportPage, 0, 10, 0 ) && ReportPage.pPixels == 0, "An empty report page is refused." );
+}
+
+
+// Check drawings whose pixels can be worked out by hand.
+static void TestReportDrawingValues()
+{
+	BOOL					bNoError = TRUE;
+	REPORT_PAGE				ReportPage;
+	unsigned char			FormPixels[ 40 * 30 * 3 ];
+	long					nPixel;
+	float					Vertex[ 4 ][ 2 ] = { { 10.0f, 10.0f }, { 20.0f, 10.0f }, { 10.0f, 15.0f }, { 20.0f, 15.0f } };
+	float					ClippedVertex[ 4 ][ 2 ] = { { 35.0f, -5.0f }, { 45.0f, -5.0f }, { 35.0f, 5.0f }, { 45.0f, 5.0f } };
+	float					CheckmarkColor[ 3 ] = { 0.0f, 0.0f, 0.5f };
+	float					TextColor[ 3 ] = { 1.0f, 0.0f, 0.0f };
+	unsigned char			GlyphBitmap[ 3 * 8 ];
+	unsigned char			SignaturePixels[ 2 * 12 ];
+	unsigned char			StretchedPixels[ 8 ];
+	double					Alpha;
+	BOOL					bPixelsMatch;
+	long					nRow;
+	long					nColumn;
+	REPORT_PAGE				*pReportPage;
+
+	for ( nPixel = 0; nPixel < 40 * 30; nPixel++ )
+		{
+		FormPixels[ nPixel * 3 ] = 100;
+		FormPixels[ nPixel * 3 + 1 ] = 150;
+		FormPixels[ nPixel * 3 + 2 ] = 200;
+		}
+	// A 5 x 3 glyph, with its rows padded to 8 bytes:  a full top row, and a quarter-covered pixel below it.
+	memset( GlyphBitmap, 0xFF, sizeof( GlyphBitmap ) );
+	memset( GlyphBitmap, 64, 5 );
+	memset( &GlyphBitmap[ 8 ], 0, 5 );
+	GlyphBitmap[ 8 ] = 16;
+	memset( &GlyphBitmap[ 16 ], 0, 5 );
+	// A 3 x 2 signature, with its rows padded to 12 bytes.
+	memset( SignaturePixels, 0xEE, sizeof( SignaturePixels ) );
+	for ( nPixel = 0; nPixel < 9; nPixel++ )
+		{
+		SignaturePixels[ nPixel ] = (unsigned char)( 10 + nPixel );
+		SignaturePixels[ 12 + nPixel ] = (unsigned char)( 100 + nPixel );
+		}
+	// A 2 x 1 bitmap, to be stretched to 4 x 1.
+	memset( StretchedPixels, 0, sizeof( StretchedPixels ) );
+	StretchedPixels[ 3 ] = 200;
+	StretchedPixels[ 4 ] = 100;
+	StretchedPixels[ 5 ] = 40;
+
+	bNoError = InitializeReportPage( &ReportPage, 40, 30, FormPixels );
+	if ( bNoError )
+		{
+		AddReportQuad( &ReportPage, Vertex, CheckmarkColor );
+		AddReportGlyph( &ReportPage, GlyphBitmap, 5, 3, 25.0f, 20.0f, TextColor );
+		AddReportBitmap( &ReportPage, SignaturePixels, 3, 2, 2.0f, 2.0f, 3.0f, 2.0f );
+		AddReportBitmap( &ReportPage, StretchedPixels, 2, 1, 30.0f, 2.0f, 4.0f, 1.0f );
+		AddReportQuad( &ReportPage, ClippedVertex, CheckmarkColor );
+		AddReportGlyph( &ReportPage, GlyphBitmap, 5, 3, 37.0f, 27.0f, TextColor );
+		pReportPage = &ReportPage;
+		RasterizeReportPages( &pReportPage, 1, 1 );
+
+		CheckTestResult( PixelEquals( &ReportPage, 10, 10, 0, 0, 128 ) && PixelEquals( &ReportPage, 19, 14, 0, 0, 128 ) &&
+							PixelEquals( &ReportPage, 9, 12, 100, 150, 200 ) && PixelEquals( &ReportPage, 20, 12, 100, 150, 200 ) &&
+							PixelEquals( &ReportPage, 15, 15, 100, 150, 200 ) && PixelEquals( &ReportPage, 15, 9, 100, 150, 200 ),
+							"A quad fills the pixels whose centers lie inside it." );
+
+		bPixelsMatch = TRUE;
+		for ( nColumn = 25; nColumn < 30; nColumn++ )
+			bPixelsMatch = ( bPixelsMatch && PixelEquals( &ReportPage, nColumn, 22, 255, 0, 0 ) );
+		CheckTestResult( bPixelsMatch && PixelEquals( &ReportPage, 30, 22, 100, 150, 200 ) && PixelEquals( &ReportPage, 24, 22, 100, 150, 200 ),
+							"Full glyph coverage paints the text color, with the first glyph row at the top." );
+		Alpha = 4.0 * 16.0 / 255.0;
+		CheckTestResult( abs( (int)ReportPage.pPixels[ ( 21 * 40 + 25 ) * 3 ] - (int)( 255.0 * Alpha + 100.0 * ( 1.0 - Alpha ) + 0.5 ) ) <= 1 &&
+							abs( (int)ReportPage.pPixels[ ( 21 * 40 + 25 ) * 3 + 1 ] - (int)( 150.0 * ( 1.0 - Alpha ) + 0.5 ) ) <= 1 &&
+							abs( (int)ReportPage.pPixels[ ( 21 * 40 + 25 ) * 3 + 2 ] - (int)( 200.0 * ( 1.0 - Alpha ) + 0.5 ) ) <= 1 &&
+							PixelEquals( &ReportPage, 26, 21, 100, 150, 200 ) && PixelEquals( &ReportPage, 25, 20, 100, 150, 200 ),
+							"Partial glyph coverage is blended with 4 times the coverage as its opacity." );
+
+		bPixelsMatch = TRUE;
+		for ( nRow = 0; nRow < 2; nRow++ )
+			for ( nColumn = 0; nColumn < 3; nColumn++ )
+				bPixelsMatch = ( bPixelsMatch && memcmp( &ReportPage.pPixels[ ( ( 2 + nRow ) * 40 + 2 + nColumn ) * 3 ],
+																&SignaturePixels[ nRow * 12 + nColumn * 3 ], 3 ) == 0 );
+		CheckTestResult( bPixelsMatch && PixelEquals( &ReportPage, 5, 2, 100, 150, 200 ) && PixelEquals( &ReportPage, 2, 4, 100, 150, 200 ),
+							"An unscaled bitmap is copied, skipping the row padding." );
+		CheckTestResult( PixelEquals( &ReportPage, 30, 2, 0, 0, 0 ) && PixelEquals( &ReportPage, 31, 2, 50, 25, 10 ) &&
+							PixelEquals( &ReportPage, 32, 2, 150, 75, 30 ) && PixelEquals( &ReportPage, 33, 2, 200, 100, 40 ),
+							"A stretched bitmap is interpolated between pixels and extended at its edges." );
+		CheckTestResult( PixelEquals( &ReportPage, 39, 0, 0, 0, 128 ) && PixelEquals( &ReportPage, 35, 4, 0, 0, 128 ) &&
+							PixelEquals( &ReportPage, 34, 4, 100, 150, 200 ) && PixelEquals( &ReportPage, 35, 5, 100, 150, 200 ) &&
+							PixelEquals( &ReportPage, 39, 29, 255, 0, 0 ),
+							"Drawings are clipped at the edges of the page." );
+		ReleaseReportPage( &ReportPage );
+		}
+	CheckTestResult( bNoError, "The hand-worked report page was prepared." );
+}
+
+
+// Prepare the golden page's form, fonts and signature, and record its drawing on each of the pages.
+typedef struct
+	{
+	unsigned char			*pFormPixels;
+	unsigned char			*pSignaturePixels;
+	TEST_GLYPH				LargeFont[ TEST_FONT_SIZE ];
+	TEST_GLYPH				SmallFont[ TEST_FONT_SIZE ];
+	} GOLDEN_PAGE_INPUTS;
+
+
+static BOOL PrepareGoldenPageInputs( GOLDEN_PAGE_INPUTS *pInputs )
+{
+	BOOL					bNoError;
+
+	pInputs -> pFormPixels = CreateTestForm( GOLDEN_PAGE_WIDTH, GOLDEN_PAGE_HEIGHT );
+	pInputs -> pSignaturePixels = CreateTestSignature( 37, 11 );
+	bNoError = CreateTestFont( pInputs -> LargeFont, 14 );
+	bNoError = CreateTestFont( pInputs -> SmallFont, 9 ) && bNoError;
+
+	return ( bNoError && pInputs -> pFormPixels != 0 && pInputs -> pSignaturePixels != 0 );
+}
+
+
+static void ReleaseGoldenPageInputs( GOLDEN_PAGE_INPUTS *pInputs )
+{
+	if ( pInputs -> pFormPixels != 0 )
+		free( pInputs -> pFormPixels );
+	if ( pInputs -> pSignaturePixels != 0 )
+		free( pInputs -> pSignaturePixels );
+	ReleaseTestFont( pInputs -> LargeFont );
+	ReleaseTestFont( pInputs -> SmallFont );
+}
+
+
+static BOOL PrepareGoldenPage( REPORT_PAGE *pReportPage, GOLDEN_PAGE_INPUTS *pInputs )
+{
+	BOOL					bNoError;
+
+	bNoError = InitializeReportPage( pReportPage, GOLDEN_PAGE_WIDTH, GOLDEN_PAGE_HEIGHT, pInputs -> pFormPixels );
+	if ( bNoError )
+		RecordGoldenPage( pReportPage, pInputs -> LargeFont, pInputs -> SmallFont, pInputs -> pSignaturePixels );
+
+	return bNoError;
+}
+
+
+// Compare the golden page, drawn on several threads, with the reference image in the test data.
+// If they differ, the page drawn is written out for inspection.  Once a change to the drawing
+// has been checked, that file, compressed with gzip, becomes the new reference image.
+static void TestReportGoldenPage()
+{
+	BOOL					bNoError;
+	GOLDEN_PAGE_INPUTS		Inputs;
+	REPORT_PAGE				ReportPage;
+	REPORT_PAGE				*pReportPage;
+	unsigned char			*pGoldenPixels = 0;
+	long					nDifferentPixels = 0;
+	int						MaxDifference = 0;
+	char					Msg[ 256 ];
+
+	memset( &ReportPage, 0, sizeof(REPORT_PAGE) );
+	bNoError = PrepareGoldenPageInputs( &Inputs ) && PrepareGoldenPage( &ReportPage, &Inputs );
+	if ( bNoError )
+		{
+		pReportPage = &ReportPage;
+		RasterizeReportPages( &pReportPage, 1, MAX_REPORT_RASTER_THREADS );
+		bNoError = ReadGoldenPageFile( "Report\\ReportPage.ppm.gz", GOLDEN_PAGE_WIDTH, GOLDEN_PAGE_HEIGHT, &pGoldenPixels );
+		}
+	if ( bNoError )
+		{
+		ComparePagePixels( ReportPage.pPixels, pGoldenPixels, GOLDEN_PAGE_WIDTH * GOLDEN_PAGE_HEIGHT, &nDifferentPixels, &MaxDifference );
+		bNoError = ( MaxDifference <= GOLDEN_PAGE_TOLERANCE );
+		printf( "    %ld of %d pixels differ from the golden page, by at most %d.\n",
+					nDifferentPixels, GOLDEN_PAGE_WIDTH * GOLDEN_PAGE_HEIGHT, MaxDifference );
+		}
+	if ( !bNoError && ReportPage.pPixels != 0 && WriteReportPageFile( &ReportPage, TEST_REPORT_PAGE_FILE_SPEC ) )
+		printf( "    The page drawn has been written to %s.\n", TEST_REPORT_PAGE_FILE_SPEC );
+	_snprintf_s( Msg, 256, _TRUNCATE, "The report page matches the golden page to within %d level.", GOLDEN_PAGE_TOLERANCE );
+	CheckTestResult( bNoError, Msg );
+	if ( pGoldenPixels != 0 )
+		free( pGoldenPixels );
+	ReleaseReportPage( &ReportPage );
+	ReleaseGoldenPageInputs( &Inputs );
+}
+
+
+// The result must not depend upon the number of threads, or upon how many pages are drawn together.
+static void TestReportThreadsAgree()
+{
+	BOOL					bNoError;
+	GOLDEN_PAGE_INPUTS		Inputs;
+	REPORT_PAGE				ReportPages[ 4 ];
+	REPORT_PAGE				*pReportPages[ 4 ];
+	int						nPage;
+	BOOL					bPagesMatch;
+
+	memset( ReportPages, 0, sizeof( ReportPages ) );
+	bNoError = PrepareGoldenPageInputs( &Inputs );
+	for ( nPage = 0; nPage < 4 && bNoError; nPage++ )
+		{
+		bNoError = PrepareGoldenPage( &ReportPages[ nPage ], &Inputs );
+		pReportPages[ nPage ] = &ReportPages[ nPage ];
+		}
+	bPagesMatch = FALSE;
+	if ( bNoError )
+		{
+		RasterizeReportPages( &pReportPages[ 0 ], 1, 1 );
+		RasterizeReportPages( &pReportPages[ 1 ], 3, MAX_REPORT_RASTER_THREADS );
+		bPagesMatch = TRUE;
+		for ( nPage = 1; nPage < 4; nPage++ )
+			bPagesMatch = ( bPagesMatch && memcmp( ReportPages[ nPage ].pPixels, ReportPages[ 0 ].pPixels, GOLDEN_PAGE_WIDTH * GOLDEN_PAGE_HEIGHT * 3 ) == 0 );
+		}
+	CheckTestResult( bPagesMatch, "Pages drawn together on several threads match a page drawn on one thread." );
+	for ( nPage = 0; nPage < 4; nPage++ )
+		ReleaseReportPage( &ReportPages[ nPage ] );
+	ReleaseGoldenPageInputs( &Inputs );
+}
+
+
+static double GetElapsedMilliseconds( LARGE_INTEGER *pStartTime, LARGE_INTEGER *pCounterFrequency )
+{
+	LARGE_INTEGER			EndTime;
+
+	QueryPerformanceCounter( &EndTime );
+
+	return (double)( EndTime.QuadPart - pStartTime -> QuadPart ) * 1000.0 / (double)pCounterFrequency -> QuadPart;
+}
+
+
+// Record the drawing of a completed page 1 on a full-size page:  checkmarks, the date fields,
+// the comment lines and the signature.
+static BOOL PrepareBenchmarkPage( REPORT_PAGE *pReportPage, unsigned char *pFormPixels, TEST_GLYPH *pLargeFont, TEST_GLYPH *pSmallFont,
+										unsigned char *pSignaturePixels )
+{
+	BOOL					bNoError;
+	float					TextColor[ 3 ] = { 0.0f, 0.0f, 1.0f };
+	int						nMark;
+	int						nLine;
+
+	bNoError = InitializeReportPage( pReportPage, BENCHMARK_PAGE_WIDTH, BENCHMARK_PAGE_HEIGHT, pFormPixels );
+	if ( bNoError )
+		{
+		for ( nMark = 0; nMark < BENCHMARK_CHECKMARK_COUNT; nMark++ )
+			AddTestCheckmark( pReportPage, 120.3f + 150.7f * ( nMark % 10 ), 1500.2f + 110.9f * ( nMark / 10 ), 56.0f, 22.2f );
+		for ( nLine = 0; nLine < 4; nLine++ )
+			AddTestText( pReportPage, pLargeFont, "10/19/2026", 140.6f + 400.0f * nLine, 2000.4f, TextColor );
+		for ( nLine = 0; nLine < BENCHMARK_TEXT_LINE_COUNT; nLine++ )
+			AddTestText( pReportPage, pSmallFont, "Small rounded opacities in both upper zones, 1/0.", 180.5f, 1300.8f - 41.3f * nLine, TextColor );
+		AddReportBitmap( pReportPage, pSignaturePixels, 200, 60, 147.3f, 286.3f, 170.1f, 51.0f );
+		}
+
+	return bNoError;
+}
+
+
+// Measure the pages per second produced on one thread, and with the pages drawn together on
+// several threads, as a batch of saved reports would be.
+static void TestReportPageThroughput()
+{
+	BOOL					bNoError;
+	unsigned char			*pFormPixels;
+	unsigned char			*pSignaturePixels;
+	TEST_GLYPH				LargeFont[ TEST_FONT_SIZE ];
+	TEST_GLYPH				SmallFont[ TEST_FONT_SIZE ];
+	REPORT_PAGE				ReportPages[ BENCHMARK_PAGE_COUNT ];
+	REPORT_PAGE				*pReportPages[ BENCHMARK_PAGE_COUNT ];
+	REPORT_PAGE				SerialPage;
+	REPORT_PAGE				*pSerialPage;
+	long					nDrawings = 0;
+	int						nPage;
+	LARGE_INTEGER			CounterFrequency;
+	LARGE_INTEGER			StartTime;
+	double					SerialMilliseconds = 0.0;
+	double					BatchMilliseconds = 0.0;
+	BOOL					bPagesMatch;
+
+	QueryPerformanceFrequency( &CounterFrequency );
+	memset( ReportPages, 0, sizeof( ReportPages ) );
+	memset( &SerialPage, 0, sizeof(REPORT_PAGE) );
+	pFormPixels = CreateTestForm( BENCHMARK_PAGE_WIDTH, BENCHMARK_PAGE_HEIGHT );
+	pSignaturePixels = CreateTestSignature( 200, 60 );
+	bNoError = CreateTestFont( LargeFont, 61 );
+	bNoError = CreateTestFont( SmallFont, 30 ) && bNoError && pFormPixels != 0 && pSignaturePixels != 0;
+
+	// One page after another, each on the calling thread.
+	if ( bNoError )
+		{
+		QueryPerformanceCounter( &StartTime );
+		for ( nPage = 0; nPage < BENCHMARK_PAGE_COUNT && bNoError; nPage++ )
+			{
+			ReleaseReportPage( &SerialPage );
+			bNoError = PrepareBenchmarkPage( &SerialPage, pFormPixels, LargeFont, SmallFont, pSignaturePixels );
+			pSerialPage = &SerialPage;
+			RasterizeReportPages( &pSerialPage, 1, 1 );
+			}
+		SerialMilliseconds = GetElapsedMilliseconds( &StartTime, &CounterFrequency ) / BENCHMARK_PAGE_COUNT;
+		nDrawings = SerialPage.nDrawings;
+		}
+	// All the pages together, on several threads.
+	if ( bNoError )
+		{
+		QueryPerformanceCounter( &StartTime );
+		for ( nPage = 0; nPage < BENCHMARK_PAGE_COUNT && bNoError; nPage++ )
+			{
+			bNoError = PrepareBenchmarkPage( &ReportPages[ nPage ], pFormPixels, LargeFont, SmallFont, pSignaturePixels );
+			pReportPages[ nPage ] = &ReportPages[ nPage ];
+			}
+		if ( bNoError )
+			RasterizeReportPages( pReportPages, BENCHMARK_PAGE_COUNT, MAX_REPORT_RASTER_THREADS );
+		BatchMilliseconds = GetElapsedMilliseconds( &StartTime, &CounterFrequency ) / BENCHMARK_PAGE_COUNT;
+		}
+	bPagesMatch = bNoError;
+	for ( nPage = 0; nPage < BENCHMARK_PAGE_COUNT && bPagesMatch; nPage++ )
+		bPagesMatch = ( memcmp( ReportPages[ nPage ].pPixels, SerialPage.pPixels, BENCHMARK_PAGE_WIDTH * BENCHMARK_PAGE_HEIGHT * 3 ) == 0 );
+	CheckTestResult( bPagesMatch, "Full-size report pages drawn together on several threads match those drawn one at a time." );
+	if ( bNoError )
+		{
+		printf( "    %dx%d pages with %ld drawings each, one at a time:  %.1f ms per page (%.1f pages/s).\n",
+					BENCHMARK_PAGE_WIDTH, BENCHMARK_PAGE_HEIGHT, nDrawings, SerialMilliseconds, 1000.0 / SerialMilliseconds );
+		printf( "    %d pages drawn together on up to %d threads:  %.1f ms per page (%.1f pages/s).\n",
+					BENCHMARK_PAGE_COUNT, MAX_REPORT_RASTER_THREADS, BatchMilliseconds, 1000.0 / BatchMilliseconds );
+		}
+	for ( nPage = 0; nPage < BENCHMARK_PAGE_COUNT; nPage++ )
+		ReleaseReportPage( &ReportPages[ nPage ] );
+	ReleaseReportPage( &SerialPage );
+	ReleaseTestFont( LargeFont );
+	ReleaseTestFont( SmallFont );
+	if ( pFormPixels != 0 )
+		free( pFormPixels );
+	if ( pSignaturePixels != 0 )
+		free( pSignaturePixels );
+}
+
+
+void TestReportRasterizer()
+{
+	TestReportPagePreparation();
+	TestReportDrawingValues();
+	TestReportGoldenPage();
+	TestReportThreadsAgree();
+	TestReportPageThroughput();
+}
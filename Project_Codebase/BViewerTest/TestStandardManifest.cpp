@@ -0,0 +1,333 @@
+// TestStandardManifest.cpp : Implements the tests of the copying and verification of the
+//	I.L.O. standard files by StandardManifest.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "StandardManifest.h"
+#include "zlib.h"
+#include "BViewerTest.h"
+
+
+#define BENCHMARK_STANDARD_FILE_COUNT		22
+#define BENCHMARK_STANDARD_FILE_SIZE		0x400000
+#define BENCHMARK_COPY_BUFFER_SIZE			0x100000
+
+
+// The media files generated by MakeStandardsVectors.py, with the result expected from
+// checking each against StandardsManifest.txt.
+typedef struct
+	{
+	char			*pFileName;
+	char			*pSOPInstanceUID;
+	BOOL			bFileIsOnMedia;
+	int				ExpectedResult;
+	} TEST_STANDARD_FILE;
+
+static TEST_STANDARD_FILE	TestStandardFiles[] =
+	{
+		{ "IM000001", "2.25.4711.2022.1", TRUE, STANDARD_FILE_VERIFIED },
+		{ "IM000002", "2.25.4711.2022.2", TRUE, STANDARD_FILE_VERIFIED },
+		{ "IM000003", "2.25.4711.2022.3", TRUE, STANDARD_FILE_VERIFIED },
+		{ "IM000004", "2.25.4711.2022.4", TRUE, STANDARD_FILE_VERIFIED },
+		{ "IM000005", "2.25.4711.2022.5", TRUE, STANDARD_FILE_CORRUPT },
+		{ "IM000006", "2.25.4711.2022.6", TRUE, STANDARD_FILE_CORRUPT },
+		{ "IM000007", "2.25.4711.2022.7", TRUE, STANDARD_FILE_NOT_LISTED },
+		{ "IM000008", "2.25.4711.2022.8", FALSE, 0 },
+		{ 0, 0, FALSE, 0 }
+	};
+
+
+static BOOL FileExists( char *pFileSpec )
+{
+	BOOL			bFileExists;
+	FILE			*pFile;
+
+	pFile = fopen( pFileSpec, "rb" );
+	bFileExists = ( pFile != 0 );
+	if ( bFileExists )
+		fclose( pFile );
+
+	return bFileExists;
+}
+
+
+static BOOL FilesMatch( char *pFileSpec, char *pOtherFileSpec )
+{
+	BOOL			bFilesMatch;
+	char			*pFileData = 0;
+	char			*pOtherFileData = 0;
+	unsigned long	FileSize;
+	unsigned long	OtherFileSize;
+
+	bFilesMatch = ReadFileContents( pFileSpec, &pFileData, &FileSize ) &&
+					ReadFileContents( pOtherFileSpec, &pOtherFileData, &OtherFileSize ) &&
+					FileSize == OtherFileSize && memcmp( pFileData, pOtherFileData, FileSize ) == 0;
+	if ( pFileData != 0 )
+		free( pFileData );
+	if ( pOtherFileData != 0 )
+		free( pOtherFileData );
+
+	return bFilesMatch;
+}
+
+
+static void TestReadStandardManifest()
+{
+	BOOL						bNoError = TRUE;
+	STANDARD_MANIFEST			*pManifest = 0;
+	STANDARD_MANIFEST_ENTRY		*pEntry;
+	char						ManifestFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+
+	GetTestDataFileSpec( "Standards\\StandardsManifest.txt", ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH );
+	bNoError = ReadStandardManifest( ManifestFileSpec, &pManifest );
+	CheckTestResult( bNoError && pManifest -> nEntries == 7, "The standards manifest lists seven files, skipping its comments." );
+	if ( bNoError )
+		{
+		pEntry = FindStandardManifestEntry( pManifest, "im000003" );
+		CheckTestResult( pEntry != 0 && pEntry -> FileSize == 4096 && pEntry -> FileCRC == 0x377CAFAEL &&
+							strcmp( pEntry -> SOPInstanceUID, "2.25.4711.2022.3" ) == 0 && !pEntry -> bFileVerified,
+							"A manifest entry is found by its file name in any case, with its size, CRC-32 and UID." );
+		CheckTestResult( FindStandardManifestEntry( pManifest, "IM000007" ) == 0, "A file missing from the manifest is not found." );
+		}
+	DeallocateStandardManifest( pManifest );
+
+	GetTestDataFileSpec( "Standards\\BadManifest.txt", ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH );
+	pManifest = 0;
+	bNoError = ReadStandardManifest( ManifestFileSpec, &pManifest );
+	CheckTestResult( !bNoError && pManifest == 0, "A manifest with a line that cannot be read is rejected." );
+
+	GetTestDataFileSpec( "Standards\\NoManifest.txt", ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH );
+	bNoError = ReadStandardManifest( ManifestFileSpec, &pManifest );
+	CheckTestResult( !bNoError && pManifest == 0, "A missing manifest is reported." );
+}
+
+
+// Copy each of the standards media files and check it against the manifest, as
+// CStandardSelector::CopyDesignatedFile() does.
+static void TestStandardFileVerification()
+{
+	BOOL						bNoError = TRUE;
+	STANDARD_MANIFEST			*pManifest = 0;
+	TEST_STANDARD_FILE			*pTestFile;
+	char						ManifestFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+	char						RelativeFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+	char						MediaFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+	char						Description[ MAX_EXTRA_LONG_STRING_LENGTH ];
+	unsigned long				FileSize;
+	unsigned long				FileCRC;
+	BOOL						bFileCopied;
+	int							VerificationResult;
+	BOOL						bResultIsCorrect;
+	BOOL						bImageIsVerified;
+
+	GetTestDataFileSpec( "Standards\\StandardsManifest.txt", ManifestFileSpec, FULL_FILE_SPEC_STRING_LENGTH );
+	bNoError = ReadStandardManifest( ManifestFileSpec, &pManifest );
+	for ( pTestFile = TestStandardFiles; bNoError && pTestFile -> pFileName != 0; pTestFile++ )
+		{
+		_snprintf_s( RelativeFileSpec, FULL_FILE_SPEC_STRING_LENGTH, _TRUNCATE, "Standards\\%s", pTestFile -> pFileName );
+		GetTestDataFileSpec( RelativeFileSpec, MediaFileSpec, FULL_FILE_SPEC_STRING_LENGTH );
+		bFileCopied = CopyStandardFile( MediaFileSpec, TEST_COPIED_STANDARD_FILE_SPEC, &FileSize, &FileCRC );
+		if ( pTestFile -> bFileIsOnMedia )
+			{
+			VerificationResult = 0;
+			if ( bFileCopied )
+				VerificationResult = VerifyStandardFile( pManifest, pTestFile -> pFileName, FileSize, FileCRC );
+			bResultIsCorrect = bFileCopied && FilesMatch( MediaFileSpec, TEST_COPIED_STANDARD_FILE_SPEC ) &&
+								VerificationResult == pTestFile -> ExpectedResult;
+			switch ( pTestFile -> ExpectedResult )
+				{
+				case STANDARD_FILE_VERIFIED:
+					_snprintf_s( Description, MAX_EXTRA_LONG_STRING_LENGTH, _TRUNCATE, "%s is copied and matches the manifest.", pTestFile -> pFileName );
+					break;
+				case STANDARD_FILE_CORRUPT:
+					_snprintf_s( Description, MAX_EXTRA_LONG_STRING_LENGTH, _TRUNCATE, "%s is copied and is found to be damaged.", pTestFile -> pFileName );
+					break;
+				default:
+					_snprintf_s( Description, MAX_EXTRA_LONG_STRING_LENGTH, _TRUNCATE, "%s is copied and is found to be missing from the manifest.", pTestFile -> pFileName );
+					break;
+				}
+			}
+		else
+			{
+			bResultIsCorrect = !bFileCopied && !FileExists( TEST_COPIED_STANDARD_FILE_SPEC );
+			_snprintf_s( Description, MAX_EXTRA_LONG_STRING_LENGTH, _TRUNCATE, "%s is missing from the media, and no copy is left behind.", pTestFile -> pFileName );
+			}
+		CheckTestResult( bResultIsCorrect, Description );
+		remove( TEST_COPIED_STANDARD_FILE_SPEC );
+		}
+	if ( bNoError )
+		{
+		// Only the images from the files that matched the manifest may be installed.
+		bResultIsCorrect = TRUE;
+		for ( pTestFile = TestStandardFiles; pTestFile -> pFileName != 0; pTestFile++ )
+			{
+			bImageIsVerified = StandardImageIsVerified( pManifest, pTestFile -> pSOPInstanceUID );
+			if ( bImageIsVerified != ( pTestFile -> ExpectedResult == STANDARD_FILE_VERIFIED ) )
+				bResultIsCorrect = FALSE;
+			}
+		CheckTestResult( bResultIsCorrect, "Only the standard images from the verified files are accepted for installation." );
+
+		// A file that is copied again from damaged media loses its verification.
+		GetTestDataFileSpec( "Standards\\IM000005", MediaFileSpec, FULL_FILE_SPEC_STRING_LENGTH );
+		bFileCopied = CopyStandardFile( MediaFileSpec, TEST_COPIED_STANDARD_FILE_SPEC, &FileSize, &FileCRC );
+		VerificationResult = VerifyStandardFile( pManifest, "IM000001", FileSize, FileCRC );
+		CheckTestResult( bFileCopied && VerificationResult == STANDARD_FILE_CORRUPT && !StandardImageIsVerified( pManifest, "2.25.4711.2022.1" ),
+							"A standard file that no longer matches the manifest is no longer accepted." );
+		remove( TEST_COPIED_STANDARD_FILE_SPEC );
+		}
+	else
+		CheckTestResult( FALSE, "The standards manifest is read for the verification tests." );
+	DeallocateStandardManifest( pManifest );
+}
+
+
+// The previous check:  the file was copied, and then the source file and the copy were each
+// read again to compare their CRC-32 values.
+static BOOL CopyAndCompareStandardFile( char *pSourceFileSpec, char *pCopiedFileSpec, unsigned char *pBuffer )
+{
+	BOOL				bNoError = TRUE;
+	FILE				*pSourceFile;
+	FILE				*pCopiedFile;
+	size_t				nBytesRead;
+	unsigned long		FileCRC[ 2 ];
+	char				*pFileSpec[ 2 ];
+	int					nFile;
+
+	pSourceFile = fopen( pSourceFileSpec, "rb" );
+	pCopiedFile = fopen( pCopiedFileSpec, "wb" );
+	bNoError = ( pSourceFile != 0 && pCopiedFile != 0 );
+	while ( bNoError && ( nBytesRead = fread( pBuffer, 1, BENCHMARK_COPY_BUFFER_SIZE, pSourceFile ) ) > 0 )
+		bNoError = ( fwrite( pBuffer, 1, nBytesRead, pCopiedFile ) == nBytesRead );
+	if ( pSourceFile != 0 )
+		fclose( pSourceFile );
+	if ( pCopiedFile != 0 )
+		fclose( pCopiedFile );
+	pFileSpec[ 0 ] = pSourceFileSpec;
+	pFileSpec[ 1 ] = pCopiedFileSpec;
+	for ( nFile = 0; bNoError && nFile < 2; nFile++ )
+		{
+		FileCRC[ nFile ] = crc32( 0L, Z_NULL, 0 );
+		pSourceFile = fopen( pFileSpec[ nFile ], "rb" );
+		bNoError = ( pSourceFile != 0 );
+		while ( bNoError && ( nBytesRead = fread( pBuffer, 1, BENCHMARK_COPY_BUFFER_SIZE, pSourceFile ) ) > 0 )
+			FileCRC[ nFile ] = crc32( FileCRC[ nFile ], (Bytef*)pBuffer, (uInt)nBytesRead );
+		if ( pSourceFile != 0 )
+			fclose( pSourceFile );
+		}
+
+	return bNoError && FileCRC[ 0 ] == FileCRC[ 1 ];
+}
+
+
+// Time the copying and checking of a full set of 22 standard files of 4 MB each, in a single
+// pass against a manifest, and as before, by reading the source and the copy again.  The
+// files are all in the file cache here, so the times understate the cost of each extra read
+// from removable media.
+static void TestStandardFileThroughput()
+{
+	BOOL						bNoError = TRUE;
+	STANDARD_MANIFEST			Manifest;
+	STANDARD_MANIFEST_ENTRY		ManifestEntries[ BENCHMARK_STANDARD_FILE_COUNT ];
+	unsigned char				*pBuffer;
+	char						MediaFileSpec[ FULL_FILE_SPEC_STRING_LENGTH ];
+	FILE						*pMediaFile;
+	unsigned long				nFile;
+	unsigned long				nByte;
+	unsigned long				RandomValue;
+	unsigned long				FileSize;
+	unsigned long				FileCRC;
+	ULONGLONG					StartTime;
+	ULONGLONG					SinglePassTime = 0;
+	ULONGLONG					PreviousCheckTime = 0;
+	double						Megabytes;
+
+	memset( ManifestEntries, 0, sizeof( ManifestEntries ) );
+	Manifest.nEntries = BENCHMARK_STANDARD_FILE_COUNT;
+	Manifest.pEntries = ManifestEntries;
+	pBuffer = (unsigned char*)malloc( BENCHMARK_STANDARD_FILE_SIZE );
+	bNoError = ( pBuffer != 0 );
+	RandomValue = 12345;
+	for ( nFile = 0; bNoError && nFile < BENCHMARK_STANDARD_FILE_COUNT; nFile++ )
+		{
+		for ( nByte = 0; nByte < BENCHMARK_STANDARD_FILE_SIZE; nByte++ )
+			{
+			RandomValue = ( RandomValue * 1103515245 + 12345 ) & 0x7FFFFFFF;
+			pBuffer[ nByte ] = (unsigned char)( RandomValue >> 16 );
+			}
+		_snprintf_s( ManifestEntries[ nFile ].FileName, STANDARD_FILE_NAME_LENGTH, _TRUNCATE, "IM%06lu", nFile + 1 );
+		_snprintf_s( ManifestEntries[ nFile ].SOPInstanceUID, STANDARD_UID_STRING_LENGTH, _TRUNCATE, "2.25.4711.%lu", nFile + 1 );
+		ManifestEntries[ nFile ].FileSize = BENCHMARK_STANDARD_FILE_SIZE;
+		ManifestEntries[ nFile ].FileCRC = crc32( crc32( 0L, Z_NULL, 0 ), (Bytef*)pBuffer, BENCHMARK_STANDARD_FILE_SIZE );
+		_snprintf_s( MediaFileSpec, FULL_FILE_SPEC_STRING_LENGTH, _TRUNCATE, TEST_STANDARD_MEDIA_FILE_SPEC, nFile + 1 );
+		pMediaFile = fopen( MediaFileSpec, "wb" );
+		bNoError = ( pMediaFile != 0 );
+		if ( bNoError )
+			{
+			bNoError = ( fwrite( pBuffer, 1, BENCHMARK_STANDARD_FILE_SIZE, pMediaFile ) == BENCHMARK_STANDARD_FILE_SIZE );
+			fclose( pMediaFile );
+			}
+		}
+
+	StartTime = GetTickCount64();
+	for ( nFile = 0; bNoError && nFile < BENCHMARK_STANDARD_FILE_COUNT; nFile++ )
+		{
+		_snprintf_s( MediaFileSpec, FULL_FILE_SPEC_STRING_LENGTH, _TRUNCATE, TEST_STANDARD_MEDIA_FILE_SPEC, nFile + 1 );
+		bNoError = CopyStandardFile( MediaFileSpec, TEST_COPIED_STANDARD_FILE_SPEC, &FileSize, &FileCRC ) &&
+					VerifyStandardFile( &Manifest, ManifestEntries[ nFile ].FileName, FileSize, FileCRC ) == STANDARD_FILE_VERIFIED;
+		}
+	SinglePassTime = GetTickCount64() - StartTime;
+	CheckTestResult( bNoError, "22 standard files of 4 MB are copied and verified against the manifest." );
+
+	StartTime = GetTickCount64();
+	for ( nFile = 0; bNoError && nFile < BENCHMARK_STANDARD_FILE_COUNT; nFile++ )
+		{
+		_snprintf_s( MediaFileSpec, FULL_FILE_SPEC_STRING_LENGTH, _TRUNCATE, TEST_STANDARD_MEDIA_FILE_SPEC, nFile + 1 );
+		bNoError = CopyAndCompareStandardFile( MediaFileSpec, TEST_COPIED_STANDARD_FILE_SPEC, pBuffer );
+		}
+	PreviousCheckTime = GetTickCount64() - StartTime;
+	if ( bNoError )
+		{
+		Megabytes = (double)BENCHMARK_STANDARD_FILE_COUNT * BENCHMARK_STANDARD_FILE_SIZE / 1048576.0;
+		printf( "    %.0f MB of standard files were copied and checked in %lu ms in a single pass (%.0f MB/s), and in %lu ms by reading them again (%.0f MB/s).\n",
+					Megabytes, (unsigned long)SinglePassTime, Megabytes * 1000.0 / (double)( SinglePassTime > 0 ? SinglePassTime : 1 ),
+					(unsigned long)PreviousCheckTime, Megabytes * 1000.0 / (double)( PreviousCheckTime > 0 ? PreviousCheckTime : 1 ) );
+		}
+
+	for ( nFile = 0; nFile < BENCHMARK_STANDARD_FILE_COUNT; nFile++ )
+		{
+		_snprintf_s( MediaFileSpec, FULL_FILE_SPEC_STRING_LENGTH, _TRUNCATE, TEST_STANDARD_MEDIA_FILE_SPEC, nFile + 1 );
+		remove( MediaFileSpec );
+		}
+	remove( TEST_COPIED_STANDARD_FILE_SPEC );
+	if ( pBuffer != 0 )
+		free( pBuffer );
+}
+
+
+void TestStandardManifest()
+{
+	TestReadStandardManifest();
+	TestStandardFileVerification();
+	TestStandardFileThroughput();
+}
@@ -0,0 +1,851 @@
+// TestStudyFile.cpp : Implements the tests of the study (.sdy) files composed and
+//	restored by StudyFile.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "Configuration.h"
+#include "StudyFile.h"
+#include "zlib.h"
+#include "BViewerTest.h"
+
+
+#define BENCHMARK_STUDY_COUNT				10000
+
+// A later version's records, header and section table entries are lengthened by these amounts.
+#define LATER_RECORD_EXTENSION				16
+#define LATER_HEADER_EXTENSION				8
+#define LATER_SECTION_ENTRY_EXTENSION		4
+#define LATER_SECTION_ID					99
+
+#define SET_TEST_TEXT( pStructure, Member, nRecord )	_snprintf_s( (pStructure) -> Member, sizeof( (pStructure) -> Member ), _TRUNCATE, "%s %ld", #Member, (long)(nRecord) )
+#define SET_TEST_NAME( pStructure, Member )				_snprintf_s( (pStructure) -> Member, sizeof( (pStructure) -> Member ), _TRUNCATE, "%s", #Member )
+
+
+static char					TestImageDefectText[] = "The lower right lung zone is obscured by a positioning error.";
+static char					TestCommentsText[] = "A healed rib fracture is seen on the left.";
+
+
+static void SetTestDate( EDITED_DATE *pEditedDate, WORD Year, WORD Month, WORD Day, BOOL bDateHasBeenEdited )
+{
+	pEditedDate -> Date.wYear = Year;
+	pEditedDate -> Date.wMonth = Month;
+	pEditedDate -> Date.wDay = Day;
+	pEditedDate -> Date.wHour = 9;
+	pEditedDate -> Date.wMinute = 30;
+	pEditedDate -> bDateHasBeenEdited = bDateHasBeenEdited;
+}
+
+
+// Fill in the contents of a study file.  Every character array is set to its member name, and
+// in the diagnostic structures also to the number of its record within the file.
+// MakeStudyFileVectors.py composes StudyFile\Sectioned.sdy from the same contents.
+static BOOL FillTestStudyFileContents( STUDY_FILE_CONTENTS *pStudyFileContents, long nStudies, long nSeriesPerStudy, long nImagesPerSeries )
+{
+	BOOL					bNoError = TRUE;
+	SDY_STUDY_RECORD		*pStudyRecord;
+	READER_PERSONAL_INFO	*pReaderInfo;
+	CLIENT_INFO				*pClientInfo;
+	DIAGNOSTIC_STUDY		**ppDiagnosticStudy;
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
+	DIAGNOSTIC_SERIES		**ppDiagnosticSeries;
+	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		**ppDiagnosticImage;
+	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
+	long					nStudy;
+	long					nSeries;
+	long					nImage;
+	long					nSeriesInFile;
+	long					nImagesInFile;
+
+	memset( pStudyFileContents, '\0', sizeof(STUDY_FILE_CONTENTS) );
+	pStudyFileContents -> FileVersion = SDY_FILE_VERSION_SECTIONED;
+	pStudyRecord = &pStudyFileContents -> StudyRecord;
+	SET_TEST_NAME( pStudyRecord, ReaderAddressed );
+	SET_TEST_NAME( pStudyRecord, PatientLastName );
+	SET_TEST_NAME( pStudyRecord, PatientFirstName );
+	SET_TEST_NAME( pStudyRecord, PatientID );
+	SetTestDate( &pStudyRecord -> PatientsBirthDate, 1956, 4, 23, TRUE );
+	strncpy_s( pStudyRecord -> PatientsSex, 4, "F", _TRUNCATE );
+	SET_TEST_NAME( pStudyRecord, PatientComments );
+	pStudyRecord -> Reserved = 0.25;
+	pStudyRecord -> GammaSetting = 1.5;
+	pStudyRecord -> WindowCenter = 2047.5;
+	pStudyRecord -> WindowWidth = 4095.0;
+	pStudyRecord -> MaxGrayscaleValue = 4095.0;
+	SET_TEST_NAME( pStudyRecord, TimeStudyFirstOpened );
+	SET_TEST_NAME( pStudyRecord, TimeReportApproved );
+	pStudyRecord -> nCurrentObjectID = 17;
+	pStudyRecord -> bImageQualityVisited = TRUE;
+	pStudyRecord -> bParenchymalAbnormalitiesVisited = FALSE;
+	pStudyRecord -> bPleuralAbnormalitiesVisited = TRUE;
+	pStudyRecord -> bOtherAbnormalitiesVisited = FALSE;
+	pStudyRecord -> AnyParenchymalAbnormalities = 'Y';
+	pStudyRecord -> AnyPleuralAbnormalities = 'N';
+	pStudyRecord -> AnyOtherAbnormalities = 'Y';
+	pStudyRecord -> ImageQuality = 2;
+	pStudyRecord -> ObservedParenchymalAbnormalities = 0x00012345;
+	pStudyRecord -> ObservedPleuralPlaqueSites = 1;
+	pStudyRecord -> ObservedPleuralCalcificationSites = 2;
+	pStudyRecord -> ObservedPlaqueExtent = 3;
+	pStudyRecord -> ObservedPlaqueWidth = 4;
+	pStudyRecord -> ObservedCostophrenicAngleObliteration = 5;
+	pStudyRecord -> ObservedPleuralThickeningSites = 6;
+	pStudyRecord -> ObservedThickeningCalcificationSites = 7;
+	pStudyRecord -> ObservedThickeningExtent = 8;
+	pStudyRecord -> ObservedThickeningWidth = 9;
+	pStudyRecord -> ObservedOtherSymbols = 0x00C0FFEE;
+	pStudyRecord -> ObservedOtherAbnormalities = 0x00BADCAB;
+	pStudyRecord -> PhysicianNotificationStatus = 3;
+	SetTestDate( &pStudyRecord -> Reserved2, 2001, 2, 3, FALSE );
+	SetTestDate( &pStudyRecord -> DateOfRadiograph, 2026, 10, 12, FALSE );
+	SET_TEST_NAME( pStudyRecord, Reserved1 );
+	pStudyRecord -> TypeOfReading = 4;
+	SET_TEST_NAME( pStudyRecord, OtherTypeOfReading );
+	SET_TEST_NAME( pStudyRecord, FacilityIDNumber );
+	SetTestDate( &pStudyRecord -> DateOfReading, 2026, 10, 19, TRUE );
+	pStudyRecord -> bReportViewed = TRUE;
+	pStudyRecord -> bReportApproved = FALSE;
+	pStudyRecord -> bStudyWasPreviouslyInterpreted = TRUE;
+	pStudyFileContents -> pImageDefectOtherText = TestImageDefectText;
+	pStudyFileContents -> pOtherAbnormalitiesCommentsText = TestCommentsText;
+
+	pReaderInfo = &pStudyFileContents -> ReaderInfo;
+	SET_TEST_NAME( pReaderInfo, LastName );
+	SET_TEST_NAME( pReaderInfo, ID );
+	strncpy_s( pReaderInfo -> Initials, 4, "RDR", _TRUNCATE );
+	SET_TEST_NAME( pReaderInfo, StreetAddress );
+	SET_TEST_NAME( pReaderInfo, City );
+	strncpy_s( pReaderInfo -> State, 4, "GA", _TRUNCATE );
+	SET_TEST_NAME( pReaderInfo, ZipCode );
+	SET_TEST_NAME( pReaderInfo, LoginName );
+	SET_TEST_NAME( pReaderInfo, EncodedPassword );
+	pReaderInfo -> bLoginNameEntered = TRUE;
+	pReaderInfo -> bPasswordEntered = TRUE;
+	SET_TEST_NAME( pReaderInfo, AE_TITLE );
+	SET_TEST_NAME( pReaderInfo, ReportSignatureName );
+	pReaderInfo -> IsDefaultReader = TRUE;
+	SET_TEST_NAME( pReaderInfo, m_CountryInfo.CountryName );
+	pReaderInfo -> m_CountryInfo.DateFormat = DATE_FORMAT_MDY;
+	pReaderInfo -> pwLength = 12;
+
+	pClientInfo = &pStudyFileContents -> ClientInfo;
+	SET_TEST_NAME( pClientInfo, Name );
+	SET_TEST_NAME( pClientInfo, StreetAddress );
+	SET_TEST_NAME( pClientInfo, City );
+	SET_TEST_NAME( pClientInfo, State );
+	SET_TEST_NAME( pClientInfo, ZipCode );
+	SET_TEST_NAME( pClientInfo, Phone );
+	SET_TEST_NAME( pClientInfo, OtherContactInfo );
+
+	// The structures are zeroed when they are allocated, so that they can be compared whole.
+	nSeriesInFile = 0;
+	nImagesInFile = 0;
+	ppDiagnosticStudy = &pStudyFileContents -> pDiagnosticStudyList;
+	for ( nStudy = 0; bNoError && nStudy < nStudies; nStudy++ )
+		{
+		pDiagnosticStudy = (DIAGNOSTIC_STUDY*)calloc( 1, sizeof(DIAGNOSTIC_STUDY) );
+		bNoError = ( pDiagnosticStudy != 0 );
+		if ( bNoError )
+			{
+			*ppDiagnosticStudy = pDiagnosticStudy;
+			ppDiagnosticStudy = &pDiagnosticStudy -> pNextDiagnosticStudy;
+			SET_TEST_TEXT( pDiagnosticStudy, AccessionNumber, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, StudyDate, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, StudyTime, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, ReferringPhysiciansName, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, ReferringPhysiciansPhone, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, ResponsibleOrganization, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, InstitutionName, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, StudyID, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, StudyDescription, nStudy );
+			SET_TEST_TEXT( pDiagnosticStudy, StudyInstanceUID, nStudy );
+			ppDiagnosticSeries = &pDiagnosticStudy -> pDiagnosticSeriesList;
+			}
+		for ( nSeries = 0; bNoError && nSeries < nSeriesPerStudy; nSeries++ )
+			{
+			pDiagnosticSeries = (DIAGNOSTIC_SERIES*)calloc( 1, sizeof(DIAGNOSTIC_SERIES) );
+			bNoError = ( pDiagnosticSeries != 0 );
+			if ( bNoError )
+				{
+				*ppDiagnosticSeries = pDiagnosticSeries;
+				ppDiagnosticSeries = &pDiagnosticSeries -> pNextDiagnosticSeries;
+				SET_TEST_TEXT( pDiagnosticSeries, Modality, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, SeriesNumber, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, Laterality, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, SeriesDate, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, SeriesTime, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, ProtocolName, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, SeriesDescription, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, BodyPartExamined, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, PatientPosition, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, PatientOrientation, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, SeriesInstanceUID, nSeriesInFile );
+				SET_TEST_TEXT( pDiagnosticSeries, Manufacturer, nSeriesInFile );
+				nSeriesInFile++;
+				ppDiagnosticImage = &pDiagnosticSeries -> pDiagnosticImageList;
+				}
+			for ( nImage = 0; bNoError && nImage < nImagesPerSeries; nImage++ )
+				{
+				pDiagnosticImage = (DIAGNOSTIC_IMAGE*)calloc( 1, sizeof(DIAGNOSTIC_IMAGE) );
+				bNoError = ( pDiagnosticImage != 0 );
+				if ( bNoError )
+					{
+					*ppDiagnosticImage = pDiagnosticImage;
+					ppDiagnosticImage = &pDiagnosticImage -> pNextDiagnosticImage;
+					SET_TEST_TEXT( pDiagnosticImage, ImageType, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, InstanceNumber, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, InstanceCreationDate, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, InstanceCreationTime, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, ContentDate, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, ContentTime, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, AcquisitionNumber, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, AcquisitionDate, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, AcquisitionTime, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, SamplesPerPixel, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, PhotometricInterpretation, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, Rows, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, Columns, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, PixelAspectRatio, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, BitsAllocated, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, BitsStored, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, HighBit, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, PixelRepresentation, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, WindowCenter, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, WindowWidth, nImagesInFile );
+					SET_TEST_TEXT( pDiagnosticImage, SOPInstanceUID, nImagesInFile );
+					pDiagnosticImage -> Reserved = 1000 + nImagesInFile;
+					nImagesInFile++;
+					}
+				}
+			}
+		}
+	if ( !bNoError )
+		DeallocateDiagnosticStudyList( pStudyFileContents -> pDiagnosticStudyList );
+
+	return bNoError;
+}
+
+
+static BOOL TestTextsMatch( char *pText, char *pOtherText )
+{
+	if ( pText == 0 )
+		pText = "";
+	if ( pOtherText == 0 )
+		pOtherText = "";
+
+	return ( strcmp( pText, pOtherText ) == 0 );
+}
+
+
+// Compare two study file contents member for member.  The list pointers are set aside, and
+// the structures' padding is zero in both, since each is zeroed before it is filled or restored.
+static BOOL StudyFileContentsMatch( STUDY_FILE_CONTENTS *pStudyFileContents, STUDY_FILE_CONTENTS *pOtherStudyFileContents )
+{
+	BOOL					bMatch = TRUE;
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
+	DIAGNOSTIC_STUDY		*pOtherDiagnosticStudy;
+	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
+	DIAGNOSTIC_SERIES		*pOtherDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
+	DIAGNOSTIC_IMAGE		*pOtherDiagnosticImage;
+	DIAGNOSTIC_STUDY		DiagnosticStudy;
+	DIAGNOSTIC_STUDY		OtherDiagnosticStudy;
+	DIAGNOSTIC_SERIES		DiagnosticSeries;
+	DIAGNOSTIC_SERIES		OtherDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		DiagnosticImage;
+	DIAGNOSTIC_IMAGE		OtherDiagnosticImage;
+
+	bMatch = ( memcmp( &pStudyFileContents -> StudyRecord, &pOtherStudyFileContents -> StudyRecord, sizeof(SDY_STUDY_RECORD) ) == 0 &&
+				TestTextsMatch( pStudyFileContents -> pImageDefectOtherText, pOtherStudyFileContents -> pImageDefectOtherText ) &&
+				TestTextsMatch( pStudyFileContents -> pOtherAbnormalitiesCommentsText, pOtherStudyFileContents -> pOtherAbnormalitiesCommentsText ) &&
+				memcmp( &pStudyFileContents -> ReaderInfo, &pOtherStudyFileContents -> ReaderInfo, sizeof(READER_PERSONAL_INFO) ) == 0 &&
+				memcmp( &pStudyFileContents -> ClientInfo, &pOtherStudyFileContents -> ClientInfo, sizeof(CLIENT_INFO) ) == 0 );
+	pDiagnosticStudy = pStudyFileContents -> pDiagnosticStudyList;
+	pOtherDiagnosticStudy = pOtherStudyFileContents -> pDiagnosticStudyList;
+	while ( bMatch && pDiagnosticStudy != 0 && pOtherDiagnosticStudy != 0 )
+		{
+		memcpy( &DiagnosticStudy, pDiagnosticStudy, sizeof(DIAGNOSTIC_STUDY) );
+		memcpy( &OtherDiagnosticStudy, pOtherDiagnosticStudy, sizeof(DIAGNOSTIC_STUDY) );
+		DiagnosticStudy.pDiagnosticSeriesList = OtherDiagnosticStudy.pDiagnosticSeriesList = 0;
+		DiagnosticStudy.pNextDiagnosticStudy = OtherDiagnosticStudy.pNextDiagnosticStudy = 0;
+		bMatch = ( memcmp( &DiagnosticStudy, &OtherDiagnosticStudy, sizeof(DIAGNOSTIC_STUDY) ) == 0 );
+		pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList;
+		pOtherDiagnosticSeries = pOtherDiagnosticStudy -> pDiagnosticSeriesList;
+		while ( bMatch && pDiagnosticSeries != 0 && pOtherDiagnosticSeries != 0 )
+			{
+			memcpy( &DiagnosticSeries, pDiagnosticSeries, sizeof(DIAGNOSTIC_SERIES) );
+			memcpy( &OtherDiagnosticSeries, pOtherDiagnosticSeries, sizeof(DIAGNOSTIC_SERIES) );
+			DiagnosticSeries.pDiagnosticImageList = OtherDiagnosticSeries.pDiagnosticImageList = 0;
+			DiagnosticSeries.pNextDiagnosticSeries = OtherDiagnosticSeries.pNextDiagnosticSeries = 0;
+			bMatch = ( memcmp( &DiagnosticSeries, &OtherDiagnosticSeries, sizeof(DIAGNOSTIC_SERIES) ) == 0 );
+			pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList;
+			pOtherDiagnosticImage = pOtherDiagnosticSeries -> pDiagnosticImageList;
+			while ( bMatch && pDiagnosticImage != 0 && pOtherDiagnosticImage != 0 )
+				{
+				memcpy( &DiagnosticImage, pDiagnosticImage, sizeof(DIAGNOSTIC_IMAGE) );
+				memcpy( &OtherDiagnosticImage, pOtherDiagnosticImage, sizeof(DIAGNOSTIC_IMAGE) );
+				DiagnosticImage.pNextDiagnosticImage = OtherDiagnosticImage.pNextDiagnosticImage = 0;
+				bMatch = ( memcmp( &DiagnosticImage, &OtherDiagnosticImage, sizeof(DIAGNOSTIC_IMAGE) ) == 0 );
+				pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage;
+				pOtherDiagnosticImage = pOtherDiagnosticImage -> pNextDiagnosticImage;
+				}
+			bMatch = ( bMatch && pDiagnosticImage == 0 && pOtherDiagnosticImage == 0 );
+			pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries;
+			pOtherDiagnosticSeries = pOtherDiagnosticSeries -> pNextDiagnosticSeries;
+			}
+		bMatch = ( bMatch && pDiagnosticSeries == 0 && pOtherDiagnosticSeries == 0 );
+		pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy;
+		pOtherDiagnosticStudy = pOtherDiagnosticStudy -> pNextDiagnosticStudy;
+		}
+	bMatch = ( bMatch && pDiagnosticStudy == 0 && pOtherDiagnosticStudy == 0 );
+
+	return bMatch;
+}
+
+
+static BOOL StudyFileContentsAreEmpty( STUDY_FILE_CONTENTS *pStudyFileContents )
+{
+	return ( pStudyFileContents -> pDiagnosticStudyList == 0 && pStudyFileContents -> pImageDefectOtherText == 0 &&
+				pStudyFileContents -> pOtherAbnormalitiesCommentsText == 0 );
+}
+
+
+static BOOL ImagesMatch( char *pFileImage, size_t FileLength, char *pOtherFileImage, size_t OtherFileLength )
+{
+	return ( pFileImage != 0 && pOtherFileImage != 0 && FileLength == OtherFileLength &&
+				memcmp( pFileImage, pOtherFileImage, FileLength ) == 0 );
+}
+
+
+// Restore a study file image, and report whether the contents match the expected ones.  The
+// restored contents are deallocated.
+static BOOL StudyFileImageRestoresContents( char *pFileImage, size_t FileLength, BOOL bIsLegacyLayout, STUDY_FILE_CONTENTS *pExpectedContents )
+{
+	BOOL					bMatch = TRUE;
+	STUDY_FILE_CONTENTS		RestoredContents;
+
+	if ( bIsLegacyLayout )
+		bMatch = RestoreLegacyStudyFileImage( pFileImage, FileLength, &RestoredContents );
+	else
+		bMatch = RestoreStudyFileImage( pFileImage, FileLength, &RestoredContents );
+	if ( bMatch )
+		{
+		bMatch = StudyFileContentsMatch( &RestoredContents, pExpectedContents );
+		DeallocateStudyFileContents( &RestoredContents );
+		}
+
+	return bMatch;
+}
+
+
+static BOOL IsResizableStudyFileSection( unsigned long SectionID )
+{
+	return ( SectionID == SDY_SECTION_STUDY || SectionID == SDY_SECTION_DIAGNOSTIC_STUDIES ||
+				SectionID == SDY_SECTION_DIAGNOSTIC_SERIES || SectionID == SDY_SECTION_DIAGNOSTIC_IMAGES ||
+				SectionID == SDY_SECTION_READER_INFO || SectionID == SDY_SECTION_CLIENT_INFO );
+}
+
+
+// Recompose a sectioned study file image as another version would have written it, with the
+// records of one section, or of all the record sections if ResizedSectionID is zero, longer or
+// shorter by RecordLengthChange bytes.  Lengthened records are filled out with bytes this
+// version must ignore.  For a later version, the header and the section table entries are also
+// lengthened, and a section this version doesn't know is added.  The caller frees the new image.
+static char *ResizeStudyFileRecords( char *pFileImage, unsigned long ResizedSectionID, long RecordLengthChange,
+										BOOL bIsLaterVersion, size_t *pResizedFileLength )
+{
+	char					*pResizedFileImage;
+	SDY_FILE_HEADER			FileHeader;
+	SDY_FILE_HEADER			*pResizedFileHeader;
+	SDY_SECTION_ENTRY		SectionEntry;
+	SDY_SECTION_ENTRY		ResizedSectionEntry;
+	unsigned long			nSection;
+	unsigned long			nRecord;
+	unsigned long			ResizedHeaderLength;
+	unsigned long			ResizedSectionEntryLength;
+	unsigned long			NextSectionOffset;
+	size_t					ResizedFileLength;
+	char					*pRecord;
+	char					*pResizedRecord;
+
+	memcpy( &FileHeader, pFileImage, sizeof(SDY_FILE_HEADER) );
+	ResizedHeaderLength = sizeof(SDY_FILE_HEADER) + ( bIsLaterVersion ? LATER_HEADER_EXTENSION : 0 );
+	ResizedSectionEntryLength = sizeof(SDY_SECTION_ENTRY) + ( bIsLaterVersion ? LATER_SECTION_ENTRY_EXTENSION : 0 );
+	ResizedFileLength = ResizedHeaderLength + ( FileHeader.nSections + 1 ) * ResizedSectionEntryLength;
+	for ( nSection = 0; nSection < FileHeader.nSections; nSection++ )
+		{
+		memcpy( &SectionEntry, pFileImage + sizeof(SDY_FILE_HEADER) + nSection * sizeof(SDY_SECTION_ENTRY), sizeof(SDY_SECTION_ENTRY) );
+		if ( IsResizableStudyFileSection( SectionEntry.SectionID ) && ( ResizedSectionID == 0 || SectionEntry.SectionID == ResizedSectionID ) )
+			SectionEntry.RecordLength += RecordLengthChange;
+		ResizedFileLength += ( SectionEntry.RecordLength * SectionEntry.nRecords + 7 ) & ~7;
+		}
+	if ( bIsLaterVersion )
+		ResizedFileLength += 2 * sizeof(double);
+	pResizedFileImage = (char*)calloc( 1, ResizedFileLength );
+	if ( pResizedFileImage != 0 )
+		{
+		memset( pResizedFileImage + sizeof(SDY_FILE_HEADER), 0xA5, ResizedHeaderLength - sizeof(SDY_FILE_HEADER) );
+		NextSectionOffset = ResizedHeaderLength + ( FileHeader.nSections + 1 ) * ResizedSectionEntryLength;
+		for ( nSection = 0; nSection < FileHeader.nSections; nSection++ )
+			{
+			memcpy( &SectionEntry, pFileImage + sizeof(SDY_FILE_HEADER) + nSection * sizeof(SDY_SECTION_ENTRY), sizeof(SDY_SECTION_ENTRY) );
+			memcpy( &ResizedSectionEntry, &SectionEntry, sizeof(SDY_SECTION_ENTRY) );
+			if ( IsResizableStudyFileSection( SectionEntry.SectionID ) && ( ResizedSectionID == 0 || SectionEntry.SectionID == ResizedSectionID ) )
+				ResizedSectionEntry.RecordLength += RecordLengthChange;
+			ResizedSectionEntry.Offset = NextSectionOffset;
+			for ( nRecord = 0; nRecord < SectionEntry.nRecords; nRecord++ )
+				{
+				pRecord = pFileImage + SectionEntry.Offset + nRecord * SectionEntry.RecordLength;
+				pResizedRecord = pResizedFileImage + ResizedSectionEntry.Offset + nRecord * ResizedSectionEntry.RecordLength;
+				if ( ResizedSectionEntry.RecordLength > SectionEntry.RecordLength )
+					{
+					memcpy( pResizedRecord, pRecord, SectionEntry.RecordLength );
+					memset( pResizedRecord + SectionEntry.RecordLength, 0xA5, ResizedSectionEntry.RecordLength - SectionEntry.RecordLength );
+					}
+				else
+					memcpy( pResizedRecord, pRecord, ResizedSectionEntry.RecordLength );
+				}
+			memcpy( pResizedFileImage + ResizedHeaderLength + nSection * ResizedSectionEntryLength, &ResizedSectionEntry, sizeof(SDY_SECTION_ENTRY) );
+			NextSectionOffset += ( ResizedSectionEntry.RecordLength * ResizedSectionEntry.nRecords + 7 ) & ~7;
+			}
+		if ( bIsLaterVersion )
+			{
+			ResizedSectionEntry.SectionID = LATER_SECTION_ID;
+			ResizedSectionEntry.Offset = NextSectionOffset;
+			ResizedSectionEntry.RecordLength = sizeof(double);
+			ResizedSectionEntry.nRecords = 2;
+			memcpy( pResizedFileImage + ResizedHeaderLength + nSection * ResizedSectionEntryLength, &ResizedSectionEntry, sizeof(SDY_SECTION_ENTRY) );
+			memset( pResizedFileImage + NextSectionOffset, 0x5A, 2 * sizeof(double) );
+			nSection++;
+			}
+		pResizedFileHeader = (SDY_FILE_HEADER*)pResizedFileImage;
+		memcpy( pResizedFileHeader, &FileHeader, sizeof(SDY_FILE_HEADER) );
+		if ( bIsLaterVersion )
+			pResizedFileHeader -> FileVersion = SDY_FILE_VERSION_SECTIONED + 1;
+		pResizedFileHeader -> HeaderLength = ResizedHeaderLength;
+		pResizedFileHeader -> SectionEntryLength = ResizedSectionEntryLength;
+		pResizedFileHeader -> nSections = nSection;
+		pResizedFileHeader -> FileLength = (unsigned long)ResizedFileLength;
+		pResizedFileHeader -> CRC = crc32( crc32( 0L, Z_NULL, 0 ), (const Bytef*)( pResizedFileImage + ResizedHeaderLength ),
+																	(uInt)( ResizedFileLength - ResizedHeaderLength ) );
+		*pResizedFileLength = ResizedFileLength;
+		}
+
+	return pResizedFileImage;
+}
+
+
+static void TestSectionedStudyFile()
+{
+	BOOL					bNoError = TRUE;
+	STUDY_FILE_CONTENTS		StudyFileContents;
+	STUDY_FILE_CONTENTS		RestoredContents;
+	char					*pFileImage = 0;
+	size_t					FileLength = 0;
+	char					*pRecomposedFileImage = 0;
+	size_t					RecomposedFileLength = 0;
+	char					*pExpectedFileImage = 0;
+	unsigned long			ExpectedFileLength = 0;
+	BOOL					bRestored;
+	BOOL					bRecomposed;
+
+	bNoError = FillTestStudyFileContents( &StudyFileContents, 2, 2, 3 );
+	if ( bNoError )
+		{
+		pFileImage = ComposeStudyFileImage( &StudyFileContents, &FileLength );
+		bNoError = ( pFileImage != 0 );
+		}
+	bRestored = FALSE;
+	bRecomposed = FALSE;
+	if ( bNoError && RestoreStudyFileImage( pFileImage, FileLength, &RestoredContents ) )
+		{
+		bRestored = ( StudyFileContentsMatch( &RestoredContents, &StudyFileContents ) &&
+						RestoredContents.FileVersion == SDY_FILE_VERSION_SECTIONED );
+		pRecomposedFileImage = ComposeStudyFileImage( &RestoredContents, &RecomposedFileLength );
+		bRecomposed = ImagesMatch( pRecomposedFileImage, RecomposedFileLength, pFileImage, FileLength );
+		DeallocateStudyFileContents( &RestoredContents );
+		}
+	CheckTestResult( bRestored, "A sectioned study file image is restored with the contents it was composed from." );
+	CheckTestResult( bRecomposed, "The restored contents are composed into the same study file image." );
+
+	// The expected file was composed independently, from the layout defined in StudyFile.h.
+	if ( bNoError )
+		bNoError = ReadTestDataFile( "StudyFile\\Sectioned.sdy", &pExpectedFileImage, &ExpectedFileLength );
+	CheckTestResult( bNoError && ImagesMatch( pFileImage, FileLength, pExpectedFileImage, ExpectedFileLength ),
+						"The study file image matches StudyFile\\Sectioned.sdy byte for byte." );
+	CheckTestResult( bNoError && StudyFileImageRestoresContents( pExpectedFileImage, ExpectedFileLength, FALSE, &StudyFileContents ),
+						"StudyFile\\Sectioned.sdy is restored with the contents it was composed from." );
+
+	if ( pRecomposedFileImage != 0 )
+		free( pRecomposedFileImage );
+	if ( pExpectedFileImage != 0 )
+		free( pExpectedFileImage );
+	if ( pFileImage != 0 )
+		free( pFileImage );
+	DeallocateDiagnosticStudyList( StudyFileContents.pDiagnosticStudyList );
+}
+
+
+static void TestDamagedStudyFile()
+{
+	BOOL					bNoError = TRUE;
+	STUDY_FILE_CONTENTS		StudyFileContents;
+	STUDY_FILE_CONTENTS		RestoredContents;
+	char					*pFileImage = 0;
+	size_t					FileLength = 0;
+	BOOL					bRejected;
+
+	bNoError = FillTestStudyFileContents( &StudyFileContents, 2, 2, 3 );
+	if ( bNoError )
+		{
+		pFileImage = ComposeStudyFileImage( &StudyFileContents, &FileLength );
+		bNoError = ( pFileImage != 0 );
+		}
+	if ( bNoError )
+		{
+		pFileImage[ FileLength / 2 ] ^= 0x01;
+		bRejected = !RestoreStudyFileImage( pFileImage, FileLength, &RestoredContents );
+		CheckTestResult( bRejected && StudyFileContentsAreEmpty( &RestoredContents ),
+							"A study file with a damaged byte fails its CRC check, and nothing is restored." );
+		pFileImage[ FileLength / 2 ] ^= 0x01;
+
+		bRejected = !RestoreStudyFileImage( pFileImage, FileLength - 1, &RestoredContents );
+		CheckTestResult( bRejected && StudyFileContentsAreEmpty( &RestoredContents ), "A truncated study file is not restored." );
+
+		( (SDY_FILE_HEADER*)pFileImage ) -> FileVersion = SDY_FILE_VERSION_SECTIONED - 1;
+		bRejected = !RestoreStudyFileImage( pFileImage, FileLength, &RestoredContents );
+		CheckTestResult( bRejected && StudyFileContentsAreEmpty( &RestoredContents ),
+							"A version 4 study file, whose layout depended on the build, is not restored." );
+		( (SDY_FILE_HEADER*)pFileImage ) -> FileVersion = SDY_FILE_VERSION_SECTIONED;
+
+		// Leave only the study record and text sections in the section table.
+		( (SDY_FILE_HEADER*)pFileImage ) -> nSections = 3;
+		bRejected = !RestoreStudyFileImage( pFileImage, FileLength, &RestoredContents );
+		CheckTestResult( bRejected && StudyFileContentsAreEmpty( &RestoredContents ),
+							"A study file missing its diagnostic study sections is not restored." );
+		}
+	else
+		CheckTestResult( FALSE, "A study file image can be composed for the damaged file tests." );
+
+	if ( pFileImage != 0 )
+		free( pFileImage );
+	DeallocateDiagnosticStudyList( StudyFileContents.pDiagnosticStudyList );
+}
+
+
+static void ClearReservedImageMembers( DIAGNOSTIC_STUDY *pDiagnosticStudyList )
+{
+	DIAGNOSTIC_STUDY		*pDiagnosticStudy;
+	DIAGNOSTIC_SERIES		*pDiagnosticSeries;
+	DIAGNOSTIC_IMAGE		*pDiagnosticImage;
+
+	for ( pDiagnosticStudy = pDiagnosticStudyList; pDiagnosticStudy != 0; pDiagnosticStudy = pDiagnosticStudy -> pNextDiagnosticStudy )
+		for ( pDiagnosticSeries = pDiagnosticStudy -> pDiagnosticSeriesList; pDiagnosticSeries != 0; pDiagnosticSeries = pDiagnosticSeries -> pNextDiagnosticSeries )
+			for ( pDiagnosticImage = pDiagnosticSeries -> pDiagnosticImageList; pDiagnosticImage != 0; pDiagnosticImage = pDiagnosticImage -> pNextDiagnosticImage )
+				pDiagnosticImage -> Reserved = 0;
+}
+
+
+static void TestOtherStudyFileVersions()
+{
+	BOOL					bNoError = TRUE;
+	STUDY_FILE_CONTENTS		StudyFileContents;
+	STUDY_FILE_CONTENTS		RestoredContents;
+	char					*pFileImage = 0;
+	size_t					FileLength = 0;
+	char					*pResizedFileImage;
+	size_t					ResizedFileLength;
+	BOOL					bRestored;
+
+	bNoError = FillTestStudyFileContents( &StudyFileContents, 2, 2, 3 );
+	if ( bNoError )
+		{
+		pFileImage = ComposeStudyFileImage( &StudyFileContents, &FileLength );
+		bNoError = ( pFileImage != 0 );
+		}
+
+	pResizedFileImage = 0;
+	if ( bNoError )
+		pResizedFileImage = ResizeStudyFileRecords( pFileImage, 0, LATER_RECORD_EXTENSION, TRUE, &ResizedFileLength );
+	CheckTestResult( pResizedFileImage != 0 &&
+						StudyFileImageRestoresContents( pResizedFileImage, ResizedFileLength, FALSE, &StudyFileContents ),
+						"A later version's study file, with longer records, header and section entries and a new section, is restored." );
+	if ( pResizedFileImage != 0 )
+		free( pResizedFileImage );
+
+	// An image record written without its last member is restored with that member zeroed.
+	pResizedFileImage = 0;
+	if ( bNoError )
+		pResizedFileImage = ResizeStudyFileRecords( pFileImage, SDY_SECTION_DIAGNOSTIC_IMAGES, -(long)sizeof(int), FALSE, &ResizedFileLength );
+	bRestored = FALSE;
+	if ( pResizedFileImage != 0 && RestoreStudyFileImage( pResizedFileImage, ResizedFileLength, &RestoredContents ) )
+		{
+		ClearReservedImageMembers( StudyFileContents.pDiagnosticStudyList );
+		bRestored = StudyFileContentsMatch( &RestoredContents, &StudyFileContents );
+		DeallocateStudyFileContents( &RestoredContents );
+		}
+	CheckTestResult( bRestored, "An earlier version's study file, with shorter image records, is restored with the missing member zeroed." );
+	if ( pResizedFileImage != 0 )
+		free( pResizedFileImage );
+
+	if ( pFileImage != 0 )
+		free( pFileImage );
+	DeallocateDiagnosticStudyList( StudyFileContents.pDiagnosticStudyList );
+}
+
+
+// The legacy layout records the structures as they are laid out in memory, so it is checked by
+// restoring it in the same build.  Files written by earlier versions lack the reader and client
+// information at the end, or record less of it.
+static void TestLegacyStudyFile()
+{
+	BOOL					bNoError = TRUE;
+	STUDY_FILE_CONTENTS		StudyFileContents;
+	STUDY_FILE_CONTENTS		RestoredContents;
+	char					*pFileImage = 0;
+	size_t					FileLength = 0;
+	char					*pSectionedFileImage = 0;
+	size_t					SectionedFileLength = 0;
+	char					*pRecomposedFileImage = 0;
+	size_t					RecomposedFileLength = 0;
+	char					*pEarlierFileImage = 0;
+	size_t					EarlierFileLength;
+	size_t					TrailerLength;
+	size_t					SeriesPosition;
+	unsigned long			OlderSeriesLength;
+	unsigned long			FileVersion;
+	BOOL					bRestored;
+	BOOL					bConverted;
+
+	bNoError = FillTestStudyFileContents( &StudyFileContents, 2, 2, 3 );
+	if ( bNoError )
+		{
+		pFileImage = ComposeLegacyStudyFileImage( &StudyFileContents, &FileLength );
+		pSectionedFileImage = ComposeStudyFileImage( &StudyFileContents, &SectionedFileLength );
+		bNoError = ( pFileImage != 0 && pSectionedFileImage != 0 );
+		}
+	bRestored = FALSE;
+	bConverted = FALSE;
+	if ( bNoError && RestoreLegacyStudyFileImage( pFileImage, FileLength, &RestoredContents ) )
+		{
+		bRestored = ( StudyFileContentsMatch( &RestoredContents, &StudyFileContents ) &&
+						RestoredContents.FileVersion == SDY_FILE_VERSION_LEGACY );
+		pRecomposedFileImage = ComposeStudyFileImage( &RestoredContents, &RecomposedFileLength );
+		bConverted = ImagesMatch( pRecomposedFileImage, RecomposedFileLength, pSectionedFileImage, SectionedFileLength );
+		if ( pRecomposedFileImage != 0 )
+			free( pRecomposedFileImage );
+		pRecomposedFileImage = ComposeLegacyStudyFileImage( &RestoredContents, &RecomposedFileLength );
+		bConverted = ( bConverted && ImagesMatch( pRecomposedFileImage, RecomposedFileLength, pFileImage, FileLength ) );
+		if ( pRecomposedFileImage != 0 )
+			free( pRecomposedFileImage );
+		DeallocateStudyFileContents( &RestoredContents );
+		}
+	CheckTestResult( bRestored, "A legacy study file image is restored with the contents it was composed from." );
+	CheckTestResult( bConverted, "The restored contents are composed into the same sectioned and legacy study file images." );
+
+	bRestored = FALSE;
+	if ( bNoError && !RestoreLegacyStudyFileImage( pFileImage, FileLength / 2, &RestoredContents ) )
+		bRestored = StudyFileContentsAreEmpty( &RestoredContents );
+	CheckTestResult( bRestored, "A truncated legacy study file is not restored." );
+
+	// The files of the earliest versions end after the diagnostic studies.  Those of versions 1
+	// and 2 follow them with 352 bytes of the reader information.
+	TrailerLength = sizeof(unsigned long) + sizeof(READER_PERSONAL_INFO) + sizeof(BOOL) + sizeof(CLIENT_INFO);
+	bRestored = FALSE;
+	if ( bNoError && RestoreLegacyStudyFileImage( pFileImage, FileLength - TrailerLength, &RestoredContents ) )
+		{
+		bRestored = ( RestoredContents.FileVersion == 0 && RestoredContents.ReaderInfo.LastName[ 0 ] == '\0' &&
+						RestoredContents.StudyRecord.bStudyWasPreviouslyInterpreted == FALSE );
+		RestoredContents.StudyRecord.bStudyWasPreviouslyInterpreted = TRUE;
+		memcpy( &RestoredContents.ReaderInfo, &StudyFileContents.ReaderInfo, sizeof(READER_PERSONAL_INFO) );
+		memcpy( &RestoredContents.ClientInfo, &StudyFileContents.ClientInfo, sizeof(CLIENT_INFO) );
+		bRestored = ( bRestored && StudyFileContentsMatch( &RestoredContents, &StudyFileContents ) );
+		DeallocateStudyFileContents( &RestoredContents );
+		}
+	CheckTestResult( bRestored, "A legacy study file from the earliest versions, without reader information, is restored." );
+
+	if ( bNoError )
+		{
+		EarlierFileLength = FileLength - TrailerLength + sizeof(unsigned long) + 352 + sizeof(BOOL);
+		pEarlierFileImage = (char*)malloc( EarlierFileLength );
+		bNoError = ( pEarlierFileImage != 0 );
+		}
+	bRestored = FALSE;
+	if ( bNoError )
+		{
+		memcpy( pEarlierFileImage, pFileImage, FileLength - TrailerLength );
+		FileVersion = 1;
+		memcpy( pEarlierFileImage + FileLength - TrailerLength, &FileVersion, sizeof(unsigned long) );
+		memcpy( pEarlierFileImage + FileLength - TrailerLength + sizeof(unsigned long), pFileImage + FileLength - TrailerLength + sizeof(unsigned long), 352 );
+		memcpy( pEarlierFileImage + EarlierFileLength - sizeof(BOOL), &StudyFileContents.StudyRecord.bStudyWasPreviouslyInterpreted, sizeof(BOOL) );
+		if ( RestoreLegacyStudyFileImage( pEarlierFileImage, EarlierFileLength, &RestoredContents ) )
+			{
+			bRestored = ( RestoredContents.FileVersion == 1 && RestoredContents.ClientInfo.Name[ 0 ] == '\0' &&
+							strcmp( RestoredContents.ReaderInfo.ReportSignatureName, StudyFileContents.ReaderInfo.ReportSignatureName ) == 0 &&
+							RestoredContents.ReaderInfo.IsDefaultReader == FALSE );
+			memcpy( &RestoredContents.ReaderInfo, &StudyFileContents.ReaderInfo, sizeof(READER_PERSONAL_INFO) );
+			memcpy( &RestoredContents.ClientInfo, &StudyFileContents.ClientInfo, sizeof(CLIENT_INFO) );
+			bRestored = ( bRestored && StudyFileContentsMatch( &RestoredContents, &StudyFileContents ) );
+			DeallocateStudyFileContents( &RestoredContents );
+			}
+		free( pEarlierFileImage );
+		pEarlierFileImage = 0;
+		}
+	CheckTestResult( bRestored, "A version 1 legacy study file, with the shorter reader information, is restored." );
+
+	// Series recorded by the earliest versions lack the manufacturer.  Rewrite the only series of
+	// a one-image file that way.
+	if ( pFileImage != 0 )
+		free( pFileImage );
+	DeallocateDiagnosticStudyList( StudyFileContents.pDiagnosticStudyList );
+	bNoError = FillTestStudyFileContents( &StudyFileContents, 1, 1, 1 );
+	pFileImage = 0;
+	if ( bNoError )
+		{
+		pFileImage = ComposeLegacyStudyFileImage( &StudyFileContents, &FileLength );
+		OlderSeriesLength = (unsigned long)( sizeof(DIAGNOSTIC_SERIES) - DICOM_ATTRIBUTE_UI_STRING_LENGTH );
+		EarlierFileLength = FileLength - DICOM_ATTRIBUTE_UI_STRING_LENGTH;
+		pEarlierFileImage = (char*)calloc( 1, EarlierFileLength );
+		bNoError = ( pFileImage != 0 && pEarlierFileImage != 0 );
+		}
+	bRestored = FALSE;
+	if ( bNoError )
+		{
+		SeriesPosition = FileLength - TrailerLength - sizeof(DIAGNOSTIC_IMAGE) - 2 * sizeof(unsigned long) - sizeof(DIAGNOSTIC_SERIES);
+		memcpy( pEarlierFileImage, pFileImage, SeriesPosition );
+		memcpy( pEarlierFileImage + SeriesPosition - sizeof(unsigned long), &OlderSeriesLength, sizeof(unsigned long) );
+		memcpy( pEarlierFileImage + SeriesPosition, pFileImage + SeriesPosition, offsetof( DIAGNOSTIC_SERIES, Manufacturer ) );
+		memcpy( pEarlierFileImage + SeriesPosition + OlderSeriesLength, pFileImage + SeriesPosition + sizeof(DIAGNOSTIC_SERIES),
+					FileLength - SeriesPosition - sizeof(DIAGNOSTIC_SERIES) );
+		if ( RestoreLegacyStudyFileImage( pEarlierFileImage, EarlierFileLength, &RestoredContents ) )
+			{
+			bRestored = ( RestoredContents.pDiagnosticStudyList -> pDiagnosticSeriesList -> Manufacturer[ 0 ] == '\0' );
+			memset( StudyFileContents.pDiagnosticStudyList -> pDiagnosticSeriesList -> Manufacturer, 0, DICOM_ATTRIBUTE_UI_STRING_LENGTH );
+			memset( RestoredContents.pDiagnosticStudyList -> pDiagnosticSeriesList -> Manufacturer, 0, DICOM_ATTRIBUTE_UI_STRING_LENGTH );
+			bRestored = ( bRestored && StudyFileContentsMatch( &RestoredContents, &StudyFileContents ) );
+			DeallocateStudyFileContents( &RestoredContents );
+			}
+		}
+	CheckTestResult( bRestored, "A legacy study file with series recorded without the manufacturer is restored." );
+
+	if ( pEarlierFileImage != 0 )
+		free( pEarlierFileImage );
+	if ( pSectionedFileImage != 0 )
+		free( pSectionedFileImage );
+	if ( pFileImage != 0 )
+		free( pFileImage );
+	DeallocateDiagnosticStudyList( StudyFileContents.pDiagnosticStudyList );
+}
+
+
+// Save and restore a study file, as BViewer does for each study it lists.
+static BOOL SaveAndRestoreStudyFile( STUDY_FILE_CONTENTS *pStudyFileContents, BOOL bIsLegacyLayout, BOOL bThroughFile )
+{
+	BOOL					bNoError = TRUE;
+	char					*pFileImage;
+	size_t					FileLength;
+	char					*pReadFileImage = 0;
+	unsigned long			ReadFileLength = 0;
+	FILE					*pStudyFile;
+	STUDY_FILE_CONTENTS		RestoredContents;
+
+	if ( bIsLegacyLayout )
+		pFileImage = ComposeLegacyStudyFileImage( pStudyFileContents, &FileLength );
+	else
+		pFileImage = ComposeStudyFileImage( pStudyFileContents, &FileLength );
+	bNoError = ( pFileImage != 0 );
+	if ( bNoError && bThroughFile )
+		{
+		pStudyFile = fopen( TEST_STUDY_FILE_SPEC, "wb" );
+		bNoError = ( pStudyFile != 0 );
+		if ( bNoError )
+			{
+			bNoError = ( fwrite( pFileImage, 1, FileLength, pStudyFile ) == FileLength );
+			fclose( pStudyFile );
+			}
+		if ( bNoError )
+			bNoError = ReadFileContents( TEST_STUDY_FILE_SPEC, &pReadFileImage, &ReadFileLength );
+		}
+	if ( bNoError )
+		{
+		if ( bThroughFile )
+			bNoError = ( bIsLegacyLayout ? RestoreLegacyStudyFileImage( pReadFileImage, ReadFileLength, &RestoredContents ) :
+											RestoreStudyFileImage( pReadFileImage, ReadFileLength, &RestoredContents ) );
+		else
+			bNoError = ( bIsLegacyLayout ? RestoreLegacyStudyFileImage( pFileImage, FileLength, &RestoredContents ) :
+											RestoreStudyFileImage( pFileImage, FileLength, &RestoredContents ) );
+		}
+	if ( bNoError )
+		DeallocateStudyFileContents( &RestoredContents );
+	if ( pReadFileImage != 0 )
+		free( pReadFileImage );
+	if ( pFileImage != 0 )
+		free( pFileImage );
+
+	return bNoError;
+}
+
+
+// Time the saving and restoring of a study file for each of 10,000 studies of two images, in
+// memory and through the file system, in each layout.
+static void TestStudyFileThroughput()
+{
+	BOOL					bNoError = TRUE;
+	STUDY_FILE_CONTENTS		StudyFileContents;
+	ULONGLONG				StartTime;
+	ULONGLONG				ElapsedTimes[ 2 ][ 2 ];
+	long					nLayout;
+	long					nMedium;
+	long					nStudy;
+
+	bNoError = FillTestStudyFileContents( &StudyFileContents, 1, 1, 2 );
+	for ( nMedium = 0; bNoError && nMedium < 2; nMedium++ )
+		for ( nLayout = 0; bNoError && nLayout < 2; nLayout++ )
+			{
+			StartTime = GetTickCount64();
+			for ( nStudy = 0; bNoError && nStudy < BENCHMARK_STUDY_COUNT; nStudy++ )
+				bNoError = SaveAndRestoreStudyFile( &StudyFileContents, nLayout == 1, nMedium == 1 );
+			ElapsedTimes[ nMedium ][ nLayout ] = GetTickCount64() - StartTime;
+			}
+	remove( TEST_STUDY_FILE_SPEC );
+	if ( bNoError )
+		{
+		printf( "    %d study files were composed and restored in memory in %lu ms in the sectioned layout, and %lu ms in the legacy layout.\n",
+					BENCHMARK_STUDY_COUNT, (unsigned long)ElapsedTimes[ 0 ][ 0 ], (unsigned long)ElapsedTimes[ 0 ][ 1 ] );
+		printf( "    %d study files were written and read back in %lu ms in the sectioned layout, and %lu ms in the legacy layout.\n",
+					BENCHMARK_STUDY_COUNT, (unsigned long)ElapsedTimes[ 1 ][ 0 ], (unsigned long)ElapsedTimes[ 1 ][ 1 ] );
+		}
+	CheckTestResult( bNoError, "10000 study files are saved and restored in each layout." );
+	DeallocateDiagnosticStudyList( StudyFileContents.pDiagnosticStudyList );
+}
+
+
+void TestStudyFile()
+{
+	TestSectionedStudyFile();
+	TestDamagedStudyFile();
+	TestOtherStudyFileVersions();
+	TestLegacyStudyFile();
+	TestStudyFileThroughput();
+}
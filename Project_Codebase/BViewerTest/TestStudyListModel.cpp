@@ -0,0 +1,539 @@
+// TestStudyListModel.cpp : Implements the tests of the rows of the study selection list,
+//	in StudyListModel.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include <math.h>
+#include "Module.h"
+#include "StudyListModel.h"
+#include "BViewerTest.h"
+
+
+// The small test lists have a name column, a date column and the SOP instance UID.
+#define TEST_LIST_COLUMNS					3
+#define TEST_TEXT_LENGTH					64
+
+// The benchmark list has the columns of the patient emphasis format, with four images in each
+// study.  A study arrives each second for a minute, and every tenth is deleted.
+#define BENCHMARK_LIST_COLUMNS				16
+#define BENCHMARK_STUDY_COUNT				25000
+#define BENCHMARK_IMAGES_PER_STUDY			4
+#define BENCHMARK_ARRIVAL_COUNT				60
+#define BENCHMARK_SINGLE_ROW_CHANGES		10000
+
+
+static char		*TestLastNames[] = { "Smith", "johnson", "Williams", "BROWN", "Jones", "garcia", "Miller", "Davis",
+									"Rodriguez", "martinez", "Hernandez", "Lopez", "Gonzalez", "wilson", "Anderson", "Thomas" };
+
+
+static void SetTestRow( char Text[][ TEST_TEXT_LENGTH ], char **ppColumnText, char *pName, char *pDate, char *pSOPInstanceUID )
+{
+	strncpy_s( Text[ 0 ], TEST_TEXT_LENGTH, pName, _TRUNCATE );
+	strncpy_s( Text[ 1 ], TEST_TEXT_LENGTH, pDate, _TRUNCATE );
+	strncpy_s( Text[ 2 ], TEST_TEXT_LENGTH, pSOPInstanceUID, _TRUNCATE );
+	ppColumnText[ 0 ] = Text[ 0 ];
+	ppColumnText[ 1 ] = Text[ 1 ];
+	ppColumnText[ 2 ] = Text[ 2 ];
+}
+
+
+// Check that the rows are in the expected order, listed by their UIDs.
+static BOOL ListOrderMatches( STUDY_LIST_MODEL *pStudyListModel, char **pExpectedSOPInstanceUIDs, long nExpectedRows )
+{
+	BOOL					bOrderMatches;
+	long					nRow;
+
+	bOrderMatches = ( pStudyListModel -> nRows == nExpectedRows );
+	for ( nRow = 0; nRow < nExpectedRows && bOrderMatches; nRow++ )
+		bOrderMatches = ( strcmp( GetStudyListRowText( pStudyListModel, nRow, pStudyListModel -> nUIDColumn ), pExpectedSOPInstanceUIDs[ nRow ] ) == 0 &&
+							FindStudyListRow( pStudyListModel, pExpectedSOPInstanceUIDs[ nRow ] ) == nRow );
+
+	return bOrderMatches;
+}
+
+
+// Rows are sorted without regard to case, and rows with the same sort text stay in the order
+// in which they arrived, in either direction.
+static void TestStudyListOrder()
+{
+	BOOL					bNoError = TRUE;
+	STUDY_LIST_MODEL		StudyListModel;
+	char					Text[ TEST_LIST_COLUMNS ][ TEST_TEXT_LENGTH ];
+	char					*ppColumnText[ TEST_LIST_COLUMNS ];
+	char					*AscendingOrder[] = { "1.4", "1.2", "1.5", "1.3", "1.1" };
+	char					*DescendingOrder[] = { "1.1", "1.3", "1.2", "1.5", "1.4" };
+	char					*DateOrder[] = { "1.3", "1.1", "1.5", "1.2", "1.4" };
+
+	bNoError = InitStudyListModel( &StudyListModel, TEST_LIST_COLUMNS, 0, TRUE );
+	SetTestRow( Text, ppColumnText, "Smith", "2026/03/01", "1.1" );
+	bNoError = ( bNoError && AddStudyListRow( &StudyListModel, ppColumnText, FALSE ) );
+	SetTestRow( Text, ppColumnText, "adams", "2026/04/15", "1.2" );
+	bNoError = ( bNoError && AddStudyListRow( &StudyListModel, ppColumnText, FALSE ) );
+	SetTestRow( Text, ppColumnText, "Jones", "2026/01/20", "1.3" );
+	bNoError = ( bNoError && AddStudyListRow( &StudyListModel, ppColumnText, FALSE ) );
+	SetTestRow( Text, ppColumnText, "Adam", "2026/05/30", "1.4" );
+	bNoError = ( bNoError && AddStudyListRow( &StudyListModel, ppColumnText, FALSE ) );
+	SetTestRow( Text, ppColumnText, "ADAMS", "2026/03/09", "1.5" );
+	bNoError = ( bNoError && AddStudyListRow( &StudyListModel, ppColumnText, FALSE ) );
+	CheckTestResult( bNoError && ListOrderMatches( &StudyListModel, AscendingOrder, 5 ),
+						"The rows are sorted without regard to case, the earlier arrival first." );
+	bNoError = ( bNoError && SetStudyListSortOrder( &StudyListModel, 0, FALSE ) );
+	CheckTestResult( bNoError && ListOrderMatches( &StudyListModel, DescendingOrder, 5 ),
+						"Rows with the same sort text keep their order when the list is sorted in reverse." );
+	bNoError = ( bNoError && SetStudyListSortOrder( &StudyListModel, 1, TRUE ) );
+	CheckTestResult( bNoError && ListOrderMatches( &StudyListModel, DateOrder, 5 ), "The rows can be sorted on another column." );
+	CheckTestResult( FindStudyListRow( &StudyListModel, "1.9" ) == -1 && GetStudyListRow( &StudyListModel, 5 ) == 0 &&
+						strcmp( GetStudyListRowText( &StudyListModel, -1, 0 ), "" ) == 0,
+						"Rows that aren't listed are not found." );
+	CloseStudyListModel( &StudyListModel );
+}
+
+
+// Check the order of the whole list, and that each row is found where it is listed.
+static BOOL StudyListIsConsistent( STUDY_LIST_MODEL *pStudyListModel )
+{
+	BOOL					bListIsConsistent;
+	STUDY_LIST_ROW			*pRow;
+	STUDY_LIST_ROW			*pPreviousRow;
+	long					nRow;
+	int						KeyDifference;
+
+	bListIsConsistent = ( pStudyListModel -> pRootRow == 0 ) ? ( pStudyListModel -> nRows == 0 ) :
+							( pStudyListModel -> pRootRow -> nRowsInSubtree == pStudyListModel -> nRows );
+	pPreviousRow = 0;
+	for ( nRow = 0; nRow < pStudyListModel -> nRows && bListIsConsistent; nRow++ )
+		{
+		pRow = GetStudyListRow( pStudyListModel, nRow );
+		bListIsConsistent = ( pRow != 0 );
+		if ( bListIsConsistent && pPreviousRow != 0 )
+			{
+			KeyDifference = strcmp( pPreviousRow -> pSortKey, pRow -> pSortKey );
+			if ( !pStudyListModel -> bSortAscending )
+				KeyDifference = -KeyDifference;
+			bListIsConsistent = ( KeyDifference < 0 || ( KeyDifference == 0 && pPreviousRow -> ArrivalSequence < pRow -> ArrivalSequence ) );
+			}
+		bListIsConsistent = ( bListIsConsistent &&
+								FindStudyListRow( pStudyListModel, pRow -> ppColumnText[ pStudyListModel -> nUIDColumn ] ) == nRow );
+		pPreviousRow = pRow;
+		}
+
+	return bListIsConsistent;
+}
+
+
+// A balanced tree of n rows is never more than about 1.44 log2( n ) levels deep.
+static BOOL StudyListIsBalanced( STUDY_LIST_MODEL *pStudyListModel )
+{
+	double					MaxHeight;
+
+	MaxHeight = 1.45 * log( (double)pStudyListModel -> nRows + 2.0 ) / log( 2.0 );
+
+	return ( pStudyListModel -> pRootRow == 0 || (double)pStudyListModel -> pRootRow -> SubtreeHeight <= MaxHeight );
+}
+
+
+// Rows are added and deleted at random, and the list is checked against the rows expected.
+static void TestStudyListChanges()
+{
+	BOOL					bNoError = TRUE;
+	BOOL					bListIsConsistent;
+	STUDY_LIST_MODEL		StudyListModel;
+	char					Text[ TEST_LIST_COLUMNS ][ TEST_TEXT_LENGTH ];
+	char					*ppColumnText[ TEST_LIST_COLUMNS ];
+	char					Name[ TEST_TEXT_LENGTH ];
+	char					SOPInstanceUID[ TEST_TEXT_LENGTH ];
+	BOOL					bRowIsListed[ 2000 ];
+	long					nListedRows;
+	unsigned long			nChange;
+	unsigned long			nImage;
+	unsigned long			RandomValue;
+
+	memset( bRowIsListed, 0, sizeof(bRowIsListed) );
+	nListedRows = 0;
+	bListIsConsistent = TRUE;
+	RandomValue = 4711;
+	bNoError = InitStudyListModel( &StudyListModel, TEST_LIST_COLUMNS, 0, TRUE );
+	for ( nChange = 0; nChange < 20000 && bNoError && bListIsConsistent; nChange++ )
+		{
+		RandomValue = ( RandomValue * 1103515245 + 12345 ) & 0x7FFFFFFF;
+		nImage = ( RandomValue >> 8 ) % 2000;
+		_snprintf_s( SOPInstanceUID, TEST_TEXT_LENGTH, _TRUNCATE, "2.25.33.%lu", nImage );
+		if ( bRowIsListed[ nImage ] )
+			{
+			bNoError = DeleteStudyListRow( &StudyListModel, SOPInstanceUID );
+			bRowIsListed[ nImage ] = FALSE;
+			nListedRows--;
+			}
+		else
+			{
+			_snprintf_s( Name, TEST_TEXT_LENGTH, _TRUNCATE, "%s %lu", TestLastNames[ nImage % 16 ], nImage % 7 );
+			SetTestRow( Text, ppColumnText, Name, "", SOPInstanceUID );
+			bNoError = AddStudyListRow( &StudyListModel, ppColumnText, FALSE );
+			bRowIsListed[ nImage ] = TRUE;
+			nListedRows++;
+			}
+		if ( nChange % 1000 == 999 )
+			{
+			bListIsConsistent = ( StudyListModel.nRows == nListedRows && StudyListIsConsistent( &StudyListModel ) &&
+									StudyListIsBalanced( &StudyListModel ) );
+			// Change direction now and then, so that both are exercised.
+			if ( nChange % 3000 == 2999 )
+				bNoError = SetStudyListSortOrder( &StudyListModel, 0, !StudyListModel.bSortAscending );
+			}
+		}
+	CheckTestResult( bNoError && bListIsConsistent,
+						"After 20000 random additions and deletions, the rows are in order, balanced and found where listed." );
+	CloseStudyListModel( &StudyListModel );
+}
+
+
+static void ReportTestRows( STUDY_LIST_MODEL *pStudyListModel, char **pNames, long nRows, unsigned long nFirstImage, unsigned long nSkippedImage )
+{
+	char					Text[ TEST_LIST_COLUMNS ][ TEST_TEXT_LENGTH ];
+	char					*ppColumnText[ TEST_LIST_COLUMNS ];
+	char					SOPInstanceUID[ TEST_TEXT_LENGTH ];
+	long					nRow;
+
+	for ( nRow = 0; nRow < nRows; nRow++ )
+		{
+		if ( nFirstImage + nRow != nSkippedImage )
+			{
+			_snprintf_s( SOPInstanceUID, TEST_TEXT_LENGTH, _TRUNCATE, "1.%lu", nFirstImage + nRow );
+			SetTestRow( Text, ppColumnText, pNames[ nRow ], "2026/10/19", SOPInstanceUID );
+			UpdateStudyListRow( pStudyListModel, ppColumnText, FALSE );
+			}
+		}
+}
+
+
+static BOOL DirtyRowsMatch( STUDY_LIST_MODEL *pStudyListModel, long nExpectedFirstRow, long nExpectedLastRow )
+{
+	BOOL					bRowsAreDirty;
+	long					nFirstDirtyRow;
+	long					nLastDirtyRow;
+
+	bRowsAreDirty = TakeStudyListDirtyRows( pStudyListModel, &nFirstDirtyRow, &nLastDirtyRow );
+
+	return ( nExpectedFirstRow < 0 ) ? !bRowsAreDirty :
+				( bRowsAreDirty && nFirstDirtyRow == nExpectedFirstRow && nLastDirtyRow == nExpectedLastRow );
+}
+
+
+// The list is brought up to date by reporting every row.  Only the changes are made, and only the
+// list positions they affect need to be redrawn.
+static void TestStudyListUpdates()
+{
+	BOOL					bNoError = TRUE;
+	STUDY_LIST_MODEL		StudyListModel;
+	char					Text[ TEST_LIST_COLUMNS ][ TEST_TEXT_LENGTH ];
+	char					*ppColumnText[ TEST_LIST_COLUMNS ];
+	char					*Names[] = { "Able", "Baker", "Charlie", "Dog", "Easy", "Fox", "George", "How", "Item", "Jig" };
+	long					nFirstDirtyRow;
+	long					nLastDirtyRow;
+
+	bNoError = InitStudyListModel( &StudyListModel, TEST_LIST_COLUMNS, 0, TRUE );
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 99 );
+	EndStudyListUpdate( &StudyListModel );
+	CheckTestResult( bNoError && StudyListModel.nRows == 10 && StudyListModel.nRowsAdded == 10 && DirtyRowsMatch( &StudyListModel, 0, 9 ),
+						"The first update adds every row." );
+
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 99 );
+	EndStudyListUpdate( &StudyListModel );
+	CheckTestResult( StudyListModel.nRowsAdded == 0 && StudyListModel.nRowsChanged == 0 && StudyListModel.nRowsDeleted == 0 &&
+						DirtyRowsMatch( &StudyListModel, -1, -1 ), "An update without changes leaves every row alone." );
+
+	// A new study arrives, and is sorted into the list.
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 99 );
+	SetTestRow( Text, ppColumnText, "Dogwood", "2026/10/19", "1.10" );
+	UpdateStudyListRow( &StudyListModel, ppColumnText, FALSE );
+	EndStudyListUpdate( &StudyListModel );
+	CheckTestResult( StudyListModel.nRows == 11 && StudyListModel.nRowsAdded == 1 && FindStudyListRow( &StudyListModel, "1.10" ) == 4 &&
+						DirtyRowsMatch( &StudyListModel, 4, 10 ), "An arriving row is inserted in order, and the rows after it are redrawn." );
+
+	// Other text than the sort column changes.
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 99 );
+	SetTestRow( Text, ppColumnText, "Dogwood", "2026/10/20", "1.10" );
+	UpdateStudyListRow( &StudyListModel, ppColumnText, FALSE );
+	EndStudyListUpdate( &StudyListModel );
+	CheckTestResult( StudyListModel.nRowsChanged == 1 && strcmp( GetStudyListRowText( &StudyListModel, 4, 1 ), "2026/10/20" ) == 0 &&
+						DirtyRowsMatch( &StudyListModel, 4, 4 ), "A row whose text changes is redrawn in place." );
+
+	// The sort column changes, and the row moves further down the list.
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 99 );
+	SetTestRow( Text, ppColumnText, "Hound", "2026/10/20", "1.10" );
+	UpdateStudyListRow( &StudyListModel, ppColumnText, FALSE );
+	EndStudyListUpdate( &StudyListModel );
+	CheckTestResult( StudyListModel.nRowsChanged == 1 && FindStudyListRow( &StudyListModel, "1.10" ) == 7 &&
+						StudyListIsConsistent( &StudyListModel ) && DirtyRowsMatch( &StudyListModel, 4, 7 ),
+						"A row whose sort text changes is moved, and only the rows in between are redrawn." );
+
+	// A study is deleted.
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 2 );
+	SetTestRow( Text, ppColumnText, "Hound", "2026/10/20", "1.10" );
+	UpdateStudyListRow( &StudyListModel, ppColumnText, FALSE );
+	EndStudyListUpdate( &StudyListModel );
+	CheckTestResult( StudyListModel.nRows == 10 && StudyListModel.nRowsDeleted == 1 && FindStudyListRow( &StudyListModel, "1.2" ) == -1 &&
+						StudyListIsConsistent( &StudyListModel ) && DirtyRowsMatch( &StudyListModel, 2, 10 ),
+						"A row that isn't reported is deleted, and the rows after it are redrawn." );
+
+	// The same image listed twice has two rows.
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 2 );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 2 );
+	SetTestRow( Text, ppColumnText, "Hound", "2026/10/20", "1.10" );
+	UpdateStudyListRow( &StudyListModel, ppColumnText, FALSE );
+	EndStudyListUpdate( &StudyListModel );
+	bNoError = ( StudyListModel.nRows == 19 && StudyListModel.nRowsAdded == 9 );
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 2 );
+	SetTestRow( Text, ppColumnText, "Hound", "2026/10/20", "1.10" );
+	UpdateStudyListRow( &StudyListModel, ppColumnText, FALSE );
+	EndStudyListUpdate( &StudyListModel );
+	CheckTestResult( bNoError && StudyListModel.nRows == 10 && StudyListModel.nRowsDeleted == 9 && StudyListIsConsistent( &StudyListModel ),
+						"An image listed twice has a row for each listing." );
+	TakeStudyListDirtyRows( &StudyListModel, &nFirstDirtyRow, &nLastDirtyRow );
+
+	// The check box is kept as the user sets it, unless the reported setting changes.
+	SetStudyListRowCheck( &StudyListModel, 0, TRUE );
+	bNoError = DirtyRowsMatch( &StudyListModel, 0, 0 );
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 2 );
+	SetTestRow( Text, ppColumnText, "Hound", "2026/10/20", "1.10" );
+	UpdateStudyListRow( &StudyListModel, ppColumnText, TRUE );
+	EndStudyListUpdate( &StudyListModel );
+	bNoError = ( bNoError && GetStudyListRowCheck( &StudyListModel, 0 ) && GetStudyListRowCheck( &StudyListModel, 6 ) &&
+					DirtyRowsMatch( &StudyListModel, 6, 6 ) );
+	ClearStudyListRowChecks( &StudyListModel );
+	BeginStudyListUpdate( &StudyListModel );
+	ReportTestRows( &StudyListModel, Names, 10, 0, 2 );
+	SetTestRow( Text, ppColumnText, "Hound", "2026/10/20", "1.10" );
+	UpdateStudyListRow( &StudyListModel, ppColumnText, TRUE );
+	EndStudyListUpdate( &StudyListModel );
+	CheckTestResult( bNoError && !GetStudyListRowCheck( &StudyListModel, 0 ) && !GetStudyListRowCheck( &StudyListModel, 6 ),
+						"The check boxes are kept as the user leaves them, unless the study's edited status changes." );
+	CloseStudyListModel( &StudyListModel );
+}
+
+
+// The benchmark studies hold their text the way the study records do, with the dates in
+// Dicom form.  The images of a study share its patient and study text.
+typedef struct
+	{
+	char					Text[ BENCHMARK_LIST_COLUMNS - 1 ][ TEST_TEXT_LENGTH ];
+	char					SOPInstanceUID[ BENCHMARK_IMAGES_PER_STUDY ][ TEST_TEXT_LENGTH ];
+	} BENCHMARK_STUDY;
+
+static BENCHMARK_STUDY		*pBenchmarkStudies = 0;
+
+
+static void ComposeBenchmarkStudy( unsigned long nStudy, BENCHMARK_STUDY *pStudy )
+{
+	unsigned long			nImage;
+
+	_snprintf_s( pStudy -> Text[ 0 ], TEST_TEXT_LENGTH, _TRUNCATE, "%s", TestLastNames[ ( nStudy * 7 ) % 16 ] );
+	_snprintf_s( pStudy -> Text[ 1 ], TEST_TEXT_LENGTH, _TRUNCATE, "Pat%lu", nStudy % 97 );
+	_snprintf_s( pStudy -> Text[ 2 ], TEST_TEXT_LENGTH, _TRUNCATE, "P%06lu", nStudy );
+	_snprintf_s( pStudy -> Text[ 3 ], TEST_TEXT_LENGTH, _TRUNCATE, "%04lu%02lu%02lu", 1940 + nStudy % 60, nStudy % 12 + 1, nStudy % 28 + 1 );
+	_snprintf_s( pStudy -> Text[ 4 ], TEST_TEXT_LENGTH, _TRUNCATE, "%s", ( nStudy % 2 == 0 ) ? "M" : "F" );
+	_snprintf_s( pStudy -> Text[ 5 ], TEST_TEXT_LENGTH, _TRUNCATE, "DX" );
+	_snprintf_s( pStudy -> Text[ 6 ], TEST_TEXT_LENGTH, _TRUNCATE, "Chest PA and lateral" );
+	_snprintf_s( pStudy -> Text[ 7 ], TEST_TEXT_LENGTH, _TRUNCATE, "CHEST" );
+	_snprintf_s( pStudy -> Text[ 8 ], TEST_TEXT_LENGTH, _TRUNCATE, "Chest two views" );
+	_snprintf_s( pStudy -> Text[ 9 ], TEST_TEXT_LENGTH, _TRUNCATE, "2026%02lu%02lu", nStudy % 12 + 1, nStudy % 28 + 1 );
+	_snprintf_s( pStudy -> Text[ 10 ], TEST_TEXT_LENGTH, _TRUNCATE, "  /  /    " );
+	_snprintf_s( pStudy -> Text[ 11 ], TEST_TEXT_LENGTH, _TRUNCATE, "Dr. Referring %lu", nStudy % 50 );
+	_snprintf_s( pStudy -> Text[ 12 ], TEST_TEXT_LENGTH, _TRUNCATE, "555-%04lu", nStudy % 10000 );
+	_snprintf_s( pStudy -> Text[ 13 ], TEST_TEXT_LENGTH, _TRUNCATE, "Clinic %lu", nStudy % 20 );
+	_snprintf_s( pStudy -> Text[ 14 ], TEST_TEXT_LENGTH, _TRUNCATE, "" );
+	for ( nImage = 0; nImage < BENCHMARK_IMAGES_PER_STUDY; nImage++ )
+		_snprintf_s( pStudy -> SOPInstanceUID[ nImage ], TEST_TEXT_LENGTH, _TRUNCATE, "2.25.4711.33.%lu.%lu", nStudy, nImage );
+}
+
+
+// The row text is composed the way the study selector composes it:  the dates are formatted,
+// and the other text is copied.
+static void ComposeBenchmarkRow( BENCHMARK_STUDY *pStudy, unsigned long nImage, char Text[][ TEST_TEXT_LENGTH ], char **ppColumnText )
+{
+	int						nColumn;
+
+	for ( nColumn = 0; nColumn < BENCHMARK_LIST_COLUMNS - 1; nColumn++ )
+		{
+		if ( nColumn == 3 || nColumn == 9 )
+			_snprintf_s( Text[ nColumn ], TEST_TEXT_LENGTH, _TRUNCATE, "%.4s/%.2s/%.2s", pStudy -> Text[ nColumn ],
+							&pStudy -> Text[ nColumn ][ 4 ], &pStudy -> Text[ nColumn ][ 6 ] );
+		else
+			strncpy_s( Text[ nColumn ], TEST_TEXT_LENGTH, pStudy -> Text[ nColumn ], _TRUNCATE );
+		ppColumnText[ nColumn ] = Text[ nColumn ];
+		}
+	strncpy_s( Text[ nColumn ], TEST_TEXT_LENGTH, pStudy -> SOPInstanceUID[ nImage ], _TRUNCATE );
+	ppColumnText[ nColumn ] = Text[ nColumn ];
+}
+
+
+// Report the rows of every study that is listed.  Every tenth study after the first arrival is
+// deleted.
+static void ReportBenchmarkRows( STUDY_LIST_MODEL *pStudyListModel, unsigned long nStudies )
+{
+	char					Text[ BENCHMARK_LIST_COLUMNS ][ TEST_TEXT_LENGTH ];
+	char					*ppColumnText[ BENCHMARK_LIST_COLUMNS ];
+	unsigned long			nStudy;
+	unsigned long			nImage;
+
+	for ( nStudy = 0; nStudy < nStudies; nStudy++ )
+		if ( nStudy < BENCHMARK_STUDY_COUNT || ( nStudy - BENCHMARK_STUDY_COUNT ) % 10 != 9 || nStudy == nStudies - 1 )
+			for ( nImage = 0; nImage < BENCHMARK_IMAGES_PER_STUDY; nImage++ )
+				{
+				ComposeBenchmarkRow( &pBenchmarkStudies[ nStudy ], nImage, Text, ppColumnText );
+				UpdateStudyListRow( pStudyListModel, ppColumnText, FALSE );
+				}
+}
+
+
+static double GetElapsedMilliseconds( LARGE_INTEGER *pStartTime, LARGE_INTEGER *pCounterFrequency )
+{
+	LARGE_INTEGER			EndTime;
+
+	QueryPerformanceCounter( &EndTime );
+
+	return (double)( EndTime.QuadPart - pStartTime -> QuadPart ) * 1000.0 / (double)pCounterFrequency -> QuadPart;
+}
+
+
+// Measure the time to bring a list of 100,000 rows up to date each time a study arrives, as the
+// study selector does, and the time the list itself takes to add and delete a row.
+static void TestStudyListThroughput()
+{
+	BOOL					bNoError = TRUE;
+	BOOL					bUpdatesAreCorrect;
+	STUDY_LIST_MODEL		StudyListModel;
+	char					Text[ BENCHMARK_LIST_COLUMNS ][ TEST_TEXT_LENGTH ];
+	char					*ppColumnText[ BENCHMARK_LIST_COLUMNS ];
+	unsigned long			nArrival;
+	unsigned long			nStudies;
+	unsigned long			nChange;
+	long					nExpectedRows;
+	long					nFirstDirtyRow;
+	long					nLastDirtyRow;
+	LARGE_INTEGER			CounterFrequency;
+	LARGE_INTEGER			StartTime;
+	double					BuildMilliseconds;
+	double					RebuildMilliseconds;
+	double					UpdateMilliseconds;
+	double					LongestUpdateMilliseconds;
+	double					TotalUpdateMilliseconds;
+	double					RowChangeMicroseconds;
+	BENCHMARK_STUDY			NewStudy;
+
+	QueryPerformanceFrequency( &CounterFrequency );
+	pBenchmarkStudies = (BENCHMARK_STUDY*)malloc( ( BENCHMARK_STUDY_COUNT + BENCHMARK_ARRIVAL_COUNT ) * sizeof(BENCHMARK_STUDY) );
+	bNoError = ( pBenchmarkStudies != 0 );
+	for ( nStudies = 0; bNoError && nStudies < BENCHMARK_STUDY_COUNT + BENCHMARK_ARRIVAL_COUNT; nStudies++ )
+		ComposeBenchmarkStudy( nStudies, &pBenchmarkStudies[ nStudies ] );
+	bNoError = ( bNoError && InitStudyListModel( &StudyListModel, BENCHMARK_LIST_COLUMNS, 0, TRUE ) );
+	QueryPerformanceCounter( &StartTime );
+	BeginStudyListUpdate( &StudyListModel );
+	ReportBenchmarkRows( &StudyListModel, BENCHMARK_STUDY_COUNT );
+	EndStudyListUpdate( &StudyListModel );
+	BuildMilliseconds = GetElapsedMilliseconds( &StartTime, &CounterFrequency );
+	TakeStudyListDirtyRows( &StudyListModel, &nFirstDirtyRow, &nLastDirtyRow );
+	bNoError = ( bNoError && StudyListModel.nRows == BENCHMARK_STUDY_COUNT * BENCHMARK_IMAGES_PER_STUDY );
+
+	// A study arrives each second.
+	bUpdatesAreCorrect = TRUE;
+	LongestUpdateMilliseconds = 0.0;
+	TotalUpdateMilliseconds = 0.0;
+	nExpectedRows = StudyListModel.nRows;
+	for ( nArrival = 0; nArrival < BENCHMARK_ARRIVAL_COUNT && bNoError; nArrival++ )
+		{
+		nStudies = BENCHMARK_STUDY_COUNT + nArrival + 1;
+		QueryPerformanceCounter( &StartTime );
+		BeginStudyListUpdate( &StudyListModel );
+		ReportBenchmarkRows( &StudyListModel, nStudies );
+		EndStudyListUpdate( &StudyListModel );
+		UpdateMilliseconds = GetElapsedMilliseconds( &StartTime, &CounterFrequency );
+		TotalUpdateMilliseconds += UpdateMilliseconds;
+		if ( UpdateMilliseconds > LongestUpdateMilliseconds )
+			LongestUpdateMilliseconds = UpdateMilliseconds;
+		nExpectedRows += BENCHMARK_IMAGES_PER_STUDY;
+		if ( nArrival % 10 == 0 && nArrival > 0 )
+			nExpectedRows -= BENCHMARK_IMAGES_PER_STUDY;
+		// Only the rows from the first one added or deleted onward are affected.
+		bUpdatesAreCorrect = ( bUpdatesAreCorrect && StudyListModel.nRows == nExpectedRows && StudyListModel.nRowsChanged == 0 &&
+								StudyListModel.nRowsAdded == BENCHMARK_IMAGES_PER_STUDY &&
+								TakeStudyListDirtyRows( &StudyListModel, &nFirstDirtyRow, &nLastDirtyRow ) && nFirstDirtyRow > 0 );
+		}
+	bUpdatesAreCorrect = ( bUpdatesAreCorrect && StudyListIsConsistent( &StudyListModel ) && StudyListIsBalanced( &StudyListModel ) );
+	CheckTestResult( bNoError && bUpdatesAreCorrect, "A list of 100,000 rows is kept up to date as 60 studies arrive and 5 are deleted." );
+
+	// The time the list takes to add and delete single rows.
+	QueryPerformanceCounter( &StartTime );
+	for ( nChange = 0; nChange < BENCHMARK_SINGLE_ROW_CHANGES && bNoError; nChange++ )
+		{
+		ComposeBenchmarkStudy( BENCHMARK_STUDY_COUNT * 2 + nChange, &NewStudy );
+		ComposeBenchmarkRow( &NewStudy, 0, Text, ppColumnText );
+		bNoError = AddStudyListRow( &StudyListModel, ppColumnText, FALSE );
+		bNoError = ( bNoError && DeleteStudyListRow( &StudyListModel, Text[ BENCHMARK_LIST_COLUMNS - 1 ] ) );
+		}
+	RowChangeMicroseconds = GetElapsedMilliseconds( &StartTime, &CounterFrequency ) * 1000.0 / ( 2.0 * BENCHMARK_SINGLE_ROW_CHANGES );
+	CheckTestResult( bNoError && StudyListModel.nRows == nExpectedRows, "Single rows are added to and deleted from the 100,000 row list." );
+
+	// For comparison, rebuilding the list from nothing, as each update did before.
+	RebuildMilliseconds = 0.0;
+	if ( bNoError )
+		{
+		QueryPerformanceCounter( &StartTime );
+		ClearStudyListModel( &StudyListModel );
+		BeginStudyListUpdate( &StudyListModel );
+		ReportBenchmarkRows( &StudyListModel, BENCHMARK_STUDY_COUNT + BENCHMARK_ARRIVAL_COUNT );
+		EndStudyListUpdate( &StudyListModel );
+		RebuildMilliseconds = GetElapsedMilliseconds( &StartTime, &CounterFrequency );
+		}
+	CheckTestResult( bNoError && StudyListModel.nRows == nExpectedRows, "The rebuilt list has the same rows." );
+	if ( bNoError )
+		{
+		printf( "    %d rows were listed in %.0f ms.  With a study arriving each second, each update took %.1f ms on average\n",
+					BENCHMARK_STUDY_COUNT * BENCHMARK_IMAGES_PER_STUDY, BuildMilliseconds, TotalUpdateMilliseconds / BENCHMARK_ARRIVAL_COUNT );
+		printf( "    (longest %.1f ms), against %.0f ms to rebuild the list.  A single row was added or deleted in %.2f microseconds.\n",
+					LongestUpdateMilliseconds, RebuildMilliseconds, RowChangeMicroseconds );
+		}
+	CloseStudyListModel( &StudyListModel );
+	if ( pBenchmarkStudies != 0 )
+		free( pBenchmarkStudies );
+	pBenchmarkStudies = 0;
+}
+
+
+void TestStudyListModel()
+{
+	TestStudyListOrder();
+	TestStudyListChanges();
+	TestStudyListUpdates();
+	TestStudyListThroughput();
+}
+
@@ -0,0 +1,469 @@
+// TestThumbnailCache.cpp : Implements the tests of the cache of image previews for the
+//	study selection list, in ThumbnailCache.cpp.
+//
+//	Written by agent
+//
+//	Copyright  2026 CDC
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+//
+#include "Module.h"
+#include "ThumbnailCache.h"
+#include "BViewerTest.h"
+
+
+#define TEST_THUMBNAIL_WAIT_TIMEOUT			20000
+
+// The benchmark previews are reduced from images of this size, with 16-bit pixels.
+#define BENCHMARK_IMAGE_WIDTH				1536
+#define BENCHMARK_IMAGE_HEIGHT				1920
+#define BENCHMARK_THUMBNAIL_COUNT			256
+
+
+// The stand-in for the image file reader records its calls, can be held at a gate to keep
+// the requests waiting, and fails for the UIDs that name missing images.
+static volatile LONG		nThumbnailReads = 0;
+static volatile LONG		nThumbnailNotifications = 0;
+static volatile BOOL		bThumbnailReaderGateClosed = FALSE;
+static HANDLE				hThumbnailReaderGate = 0;
+static unsigned short		*pBenchmarkImage = 0;
+
+
+static void MakeTestThumbnailUID( char *pSOPInstanceUID, unsigned long nImage )
+{
+	_snprintf_s( pSOPInstanceUID, THUMBNAIL_UID_STRING_LENGTH, _TRUNCATE, "2.25.4711.40.%lu", nImage );
+}
+
+
+// The expected preview of a test image is derived from its UID:  every third image is wider
+// than it is high, and the pixels count up from a value chosen by the UID.
+static void ComposeTestThumbnail( char *pSOPInstanceUID, unsigned char *pPixelData, unsigned long *pWidth, unsigned long *pHeight )
+{
+	unsigned long			Seed;
+	unsigned long			nPixel;
+	char					*pChar;
+
+	Seed = 0;
+	for ( pChar = pSOPInstanceUID; *pChar != '\0'; pChar++ )
+		Seed = Seed * 31 + (unsigned char)*pChar;
+	*pWidth = THUMBNAIL_DIMENSION;
+	*pHeight = ( Seed % 3 == 0 ) ? THUMBNAIL_DIMENSION * 3 / 4 : THUMBNAIL_DIMENSION;
+	for ( nPixel = 0; nPixel < *pWidth * *pHeight; nPixel++ )
+		pPixelData[ nPixel ] = (unsigned char)( Seed + nPixel );
+}
+
+
+static BOOL ReadTestThumbnail( char *pSOPInstanceUID, unsigned long MaxThumbnailDimension, unsigned char **ppThumbnailData,
+								unsigned long *pThumbnailWidth, unsigned long *pThumbnailHeight )
+{
+	BOOL					bNoError = TRUE;
+
+	InterlockedIncrement( &nThumbnailReads );
+	if ( bThumbnailReaderGateClosed )
+		WaitForSingleObject( hThumbnailReaderGate, TEST_THUMBNAIL_WAIT_TIMEOUT );
+	bNoError = ( strstr( pSOPInstanceUID, "missing" ) == 0 );
+	if ( bNoError )
+		{
+		*ppThumbnailData = (unsigned char*)malloc( MaxThumbnailDimension * MaxThumbnailDimension );
+		bNoError = ( *ppThumbnailData != 0 );
+		}
+	if ( bNoError )
+		ComposeTestThumbnail( pSOPInstanceUID, *ppThumbnailData, pThumbnailWidth, pThumbnailHeight );
+
+	return bNoError;
+}
+
+
+static void CountThumbnailNotification( void *pNotificationContext )
+{
+	InterlockedIncrement( (volatile LONG*)pNotificationContext );
+}
+
+
+static BOOL ThumbnailMatches( THUMBNAIL *pThumbnail, char *pSOPInstanceUID )
+{
+	unsigned char			ExpectedPixelData[ THUMBNAIL_DIMENSION * THUMBNAIL_DIMENSION ];
+	unsigned long			ExpectedWidth;
+	unsigned long			ExpectedHeight;
+
+	ComposeTestThumbnail( pSOPInstanceUID, ExpectedPixelData, &ExpectedWidth, &ExpectedHeight );
+
+	return ( pThumbnail -> ThumbnailState == THUMBNAIL_STATE_READY && pThumbnail -> ThumbnailWidth == ExpectedWidth &&
+				pThumbnail -> ThumbnailHeight == ExpectedHeight &&
+				memcmp( pThumbnail -> PixelData, ExpectedPixelData, ExpectedWidth * ExpectedHeight ) == 0 );
+}
+
+
+static BOOL StartTestThumbnailCache( THUMBNAIL_READER ReadThumbnail )
+{
+	nThumbnailReads = 0;
+	nThumbnailNotifications = 0;
+	bThumbnailReaderGateClosed = FALSE;
+
+	return InitThumbnailCache( ReadThumbnail, CountThumbnailNotification, (void*)&nThumbnailNotifications );
+}
+
+
+// Wait until the reader thread has taken its first request and is held at the gate.
+static BOOL WaitForReaderAtGate()
+{
+	ULONGLONG				StopTime;
+
+	StopTime = GetTickCount64() + TEST_THUMBNAIL_WAIT_TIMEOUT;
+	while ( nThumbnailReads == 0 && GetTickCount64() < StopTime )
+		Sleep( 1 );
+
+	return ( nThumbnailReads > 0 );
+}
+
+
+// A preview that hasn't been read is reported as pending at once, while the reader thread is
+// busy.  It is ready after the reader finishes, and the file isn't read again.
+static void TestThumbnailRequests()
+{
+	BOOL					bNoError = TRUE;
+	THUMBNAIL				Thumbnail;
+	THUMBNAIL				MissingThumbnail;
+	char					SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH ];
+	int						nFirstCacheEntry;
+	THUMBNAIL_CACHE_STATISTICS	Statistics;
+
+	hThumbnailReaderGate = CreateSemaphore( NULL, 0L, 1L, NULL );
+	bNoError = StartTestThumbnailCache( ReadTestThumbnail );
+	CheckTestResult( bNoError, "The thumbnail cache starts its reader thread." );
+	if ( bNoError )
+		{
+		bThumbnailReaderGateClosed = TRUE;
+		MakeTestThumbnailUID( SOPInstanceUID, 1 );
+		CheckTestResult( LookUpThumbnail( SOPInstanceUID, &Thumbnail ) == THUMBNAIL_STATE_PENDING && Thumbnail.nCacheEntry >= 0,
+							"A preview not yet read is reported as pending, for a placeholder to be shown." );
+		nFirstCacheEntry = Thumbnail.nCacheEntry;
+		bNoError = WaitForReaderAtGate();
+		CheckTestResult( bNoError && LookUpThumbnail( SOPInstanceUID, &Thumbnail ) == THUMBNAIL_STATE_PENDING &&
+							!WaitForThumbnailRequests( 50 ),
+							"The lookup returns without waiting while the reader thread is reading the image file." );
+		CheckTestResult( LookUpThumbnail( "2.25.4711.40.missing", &MissingThumbnail ) == THUMBNAIL_STATE_PENDING,
+							"A second preview is queued behind the one being read." );
+
+		bThumbnailReaderGateClosed = FALSE;
+		ReleaseSemaphore( hThumbnailReaderGate, 1L, NULL );
+		bNoError = WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT );
+		CheckTestResult( bNoError && nThumbnailNotifications == 2, "The reader thread reports each preview it reads." );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		CheckTestResult( ThumbnailMatches( &Thumbnail, SOPInstanceUID ) && Thumbnail.nCacheEntry == nFirstCacheEntry,
+							"The preview is ready in the same cache entry, with the pixels read." );
+		CheckTestResult( LookUpThumbnail( "2.25.4711.40.missing", &MissingThumbnail ) == THUMBNAIL_STATE_FAILED,
+							"An image that cannot be read is reported as failed." );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		LookUpThumbnail( "2.25.4711.40.missing", &MissingThumbnail );
+		GetThumbnailCacheStatistics( &Statistics );
+		CheckTestResult( nThumbnailReads == 2 && Statistics.nThumbnailsRead == 1 && Statistics.nReadFailures == 1 &&
+							Statistics.nLookups == 7 && Statistics.nHits == 4,
+							"Neither image file is read again once its outcome is cached." );
+		}
+	CloseThumbnailCache();
+	CloseHandle( hThumbnailReaderGate );
+	hThumbnailReaderGate = 0;
+}
+
+
+// More requests than the queue holds, as when the list is scrolled quickly, drop the oldest.
+// A dropped preview is requested again when its row is displayed again.
+static void TestDroppedThumbnailRequests()
+{
+	BOOL					bNoError = TRUE;
+	THUMBNAIL				Thumbnail;
+	char					SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH ];
+	unsigned long			nImage;
+	THUMBNAIL_CACHE_STATISTICS	Statistics;
+
+	hThumbnailReaderGate = CreateSemaphore( NULL, 0L, 1L, NULL );
+	bNoError = StartTestThumbnailCache( ReadTestThumbnail );
+	if ( bNoError )
+		{
+		bThumbnailReaderGateClosed = TRUE;
+		MakeTestThumbnailUID( SOPInstanceUID, 0 );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		bNoError = WaitForReaderAtGate();
+		for ( nImage = 1; bNoError && nImage <= 100; nImage++ )
+			{
+			MakeTestThumbnailUID( SOPInstanceUID, nImage );
+			bNoError = ( LookUpThumbnail( SOPInstanceUID, &Thumbnail ) == THUMBNAIL_STATE_PENDING );
+			}
+		bThumbnailReaderGateClosed = FALSE;
+		ReleaseSemaphore( hThumbnailReaderGate, 1L, NULL );
+		bNoError = ( bNoError && WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT ) );
+		GetThumbnailCacheStatistics( &Statistics );
+		CheckTestResult( bNoError && Statistics.nDroppedRequests == 100 - MAX_THUMBNAIL_REQUESTS &&
+							nThumbnailReads == 1 + MAX_THUMBNAIL_REQUESTS,
+							"The oldest of the waiting requests are dropped when the queue is full." );
+		MakeTestThumbnailUID( SOPInstanceUID, 100 );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		CheckTestResult( ThumbnailMatches( &Thumbnail, SOPInstanceUID ), "The most recent requests are read." );
+		MakeTestThumbnailUID( SOPInstanceUID, 1 );
+		bNoError = ( LookUpThumbnail( SOPInstanceUID, &Thumbnail ) == THUMBNAIL_STATE_PENDING &&
+						WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT ) );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		CheckTestResult( bNoError && ThumbnailMatches( &Thumbnail, SOPInstanceUID ),
+							"A dropped request is made again when its row is displayed again." );
+		}
+	CloseThumbnailCache();
+	CloseHandle( hThumbnailReaderGate );
+	hThumbnailReaderGate = 0;
+}
+
+
+// The cache holds no more than its capacity.  The previews that have gone unused the longest are
+// replaced, and the hit rate stays high while the reader scrolls back and forth through a list
+// that fits in the cache.
+static void TestThumbnailCacheCapacity()
+{
+	BOOL					bNoError = TRUE;
+	THUMBNAIL				Thumbnail;
+	char					SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH ];
+	unsigned long			nImage;
+	unsigned long			nImages;
+	unsigned long			nFirstVisibleRow;
+	unsigned long			nRow;
+	unsigned long			nPass;
+	BOOL					bEntryNumbersInRange;
+	THUMBNAIL_CACHE_STATISTICS	Statistics;
+	double					HitRate;
+	char					TestDescription[ MAX_LOGGING_STRING_LENGTH ];
+
+	bNoError = StartTestThumbnailCache( ReadTestThumbnail );
+	nImages = THUMBNAIL_CACHE_CAPACITY + THUMBNAIL_CACHE_CAPACITY / 2;
+	bEntryNumbersInRange = TRUE;
+	for ( nImage = 0; bNoError && nImage < nImages; nImage++ )
+		{
+		MakeTestThumbnailUID( SOPInstanceUID, nImage );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		if ( Thumbnail.nCacheEntry < 0 || Thumbnail.nCacheEntry >= THUMBNAIL_CACHE_CAPACITY )
+			bEntryNumbersInRange = FALSE;
+		// Let the reader keep up, as it would between screens of rows.
+		if ( nImage % 32 == 31 )
+			bNoError = WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT );
+		}
+	bNoError = ( bNoError && WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT ) );
+	GetThumbnailCacheStatistics( &Statistics );
+	CheckTestResult( bNoError && bEntryNumbersInRange && Statistics.nThumbnailsRead == nImages &&
+						Statistics.nEvictions == nImages - THUMBNAIL_CACHE_CAPACITY,
+						"The cache holds its capacity of previews, replacing the ones that have gone unused the longest." );
+	MakeTestThumbnailUID( SOPInstanceUID, nImages - 1 );
+	LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+	MakeTestThumbnailUID( SOPInstanceUID, 0 );
+	CheckTestResult( Thumbnail.ThumbnailState == THUMBNAIL_STATE_READY && LookUpThumbnail( SOPInstanceUID, &Thumbnail ) == THUMBNAIL_STATE_PENDING,
+						"A recent preview is kept, and the oldest one must be read again." );
+	CloseThumbnailCache();
+
+	// Scroll a 25-row window down and back up a list of 800 rows three times, looking up each
+	// visible row as it is painted.
+	bNoError = StartTestThumbnailCache( ReadTestThumbnail );
+	nImages = 800;
+	for ( nPass = 0; bNoError && nPass < 6; nPass++ )
+		for ( nFirstVisibleRow = 0; bNoError && nFirstVisibleRow + 25 <= nImages; nFirstVisibleRow += 5 )
+			{
+			for ( nRow = 0; nRow < 25; nRow++ )
+				{
+				nImage = ( nPass % 2 == 0 ) ? nFirstVisibleRow + nRow : nImages - 1 - nFirstVisibleRow - nRow;
+				MakeTestThumbnailUID( SOPInstanceUID, nImage );
+				LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+				}
+			bNoError = WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT );
+			}
+	GetThumbnailCacheStatistics( &Statistics );
+	HitRate = (double)Statistics.nHits / (double)( Statistics.nLookups > 0 ? Statistics.nLookups : 1 );
+	_snprintf_s( TestDescription, MAX_LOGGING_STRING_LENGTH, _TRUNCATE,
+					"Scrolling through 800 rows six times reads each preview once, for a hit rate of %.1f%%.", HitRate * 100.0 );
+	CheckTestResult( bNoError && Statistics.nThumbnailsRead == nImages && Statistics.nEvictions == 0 && HitRate > 0.95, TestDescription );
+	CloseThumbnailCache();
+}
+
+
+// The previews are saved for the next session, and are ready without reading the image files.
+static void TestThumbnailCacheFile()
+{
+	BOOL					bNoError = TRUE;
+	THUMBNAIL				Thumbnail;
+	char					SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH ];
+	unsigned long			nImage;
+	BOOL					bAllThumbnailsLoaded;
+	FILE					*pCacheFile;
+
+	bNoError = StartTestThumbnailCache( ReadTestThumbnail );
+	for ( nImage = 0; bNoError && nImage < 40; nImage++ )
+		{
+		MakeTestThumbnailUID( SOPInstanceUID, nImage );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		}
+	LookUpThumbnail( "2.25.4711.40.missing", &Thumbnail );
+	bNoError = ( bNoError && WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT ) );
+	CheckTestResult( bNoError && SaveThumbnailCache( TEST_THUMBNAIL_CACHE_FILE_SPEC ), "The previews are saved in the cache file." );
+	CloseThumbnailCache();
+
+	bNoError = StartTestThumbnailCache( ReadTestThumbnail );
+	bNoError = ( bNoError && LoadThumbnailCache( TEST_THUMBNAIL_CACHE_FILE_SPEC ) );
+	bAllThumbnailsLoaded = bNoError;
+	for ( nImage = 0; bNoError && nImage < 40; nImage++ )
+		{
+		MakeTestThumbnailUID( SOPInstanceUID, nImage );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		if ( !ThumbnailMatches( &Thumbnail, SOPInstanceUID ) )
+			bAllThumbnailsLoaded = FALSE;
+		}
+	CheckTestResult( bAllThumbnailsLoaded && nThumbnailReads == 0,
+						"The saved previews are ready in the next session without reading the image files." );
+	CheckTestResult( LookUpThumbnail( "2.25.4711.40.missing", &Thumbnail ) == THUMBNAIL_STATE_PENDING,
+						"An image that could not be read is tried again in the next session." );
+	WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT );
+	CloseThumbnailCache();
+
+	// A cache file saved for a different preview size is ignored.
+	pCacheFile = fopen( TEST_THUMBNAIL_CACHE_FILE_SPEC, "r+b" );
+	if ( pCacheFile != 0 )
+		{
+		fseek( pCacheFile, 8, SEEK_SET );
+		fputc( THUMBNAIL_DIMENSION + 8, pCacheFile );
+		fclose( pCacheFile );
+		}
+	bNoError = StartTestThumbnailCache( ReadTestThumbnail );
+	MakeTestThumbnailUID( SOPInstanceUID, 0 );
+	CheckTestResult( bNoError && !LoadThumbnailCache( TEST_THUMBNAIL_CACHE_FILE_SPEC ) &&
+						LookUpThumbnail( SOPInstanceUID, &Thumbnail ) == THUMBNAIL_STATE_PENDING,
+						"A cache file saved for a different preview size is ignored." );
+	WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT );
+	CloseThumbnailCache();
+	remove( TEST_THUMBNAIL_CACHE_FILE_SPEC );
+}
+
+
+// The benchmark reader reduces a full-size 16-bit image, summing each block of rows into the
+// preview as it goes and windowing the averages, as ReadPNGThumbnailImage() does with the rows
+// it reads from a PNG file.  The PNG decompression isn't included.
+static BOOL ReadBenchmarkThumbnail( char *pSOPInstanceUID, unsigned long MaxThumbnailDimension, unsigned char **ppThumbnailData,
+									unsigned long *pThumbnailWidth, unsigned long *pThumbnailHeight )
+{
+	BOOL					bNoError = TRUE;
+	unsigned long			DecimationFactor;
+	unsigned long			ThumbnailWidth;
+	unsigned long			ThumbnailHeight;
+	unsigned __int64		ColumnSums[ THUMBNAIL_DIMENSION ];
+	unsigned long			nRow;
+	unsigned long			nPixel;
+	unsigned short			*pImageRow;
+	double					ScaledValue;
+
+	InterlockedIncrement( &nThumbnailReads );
+	DecimationFactor = ( BENCHMARK_IMAGE_HEIGHT + MaxThumbnailDimension - 1 ) / MaxThumbnailDimension;
+	ThumbnailWidth = BENCHMARK_IMAGE_WIDTH / DecimationFactor;
+	ThumbnailHeight = BENCHMARK_IMAGE_HEIGHT / DecimationFactor;
+	*ppThumbnailData = (unsigned char*)malloc( ThumbnailWidth * ThumbnailHeight );
+	bNoError = ( *ppThumbnailData != 0 );
+	for ( nRow = 0; bNoError && nRow < ThumbnailHeight * DecimationFactor; nRow++ )
+		{
+		if ( nRow % DecimationFactor == 0 )
+			memset( ColumnSums, 0, sizeof(ColumnSums) );
+		pImageRow = &pBenchmarkImage[ nRow * BENCHMARK_IMAGE_WIDTH ];
+		for ( nPixel = 0; nPixel < ThumbnailWidth * DecimationFactor; nPixel++ )
+			ColumnSums[ nPixel / DecimationFactor ] += pImageRow[ nPixel ];
+		if ( nRow % DecimationFactor == DecimationFactor - 1 )
+			for ( nPixel = 0; nPixel < ThumbnailWidth; nPixel++ )
+				{
+				ScaledValue = ( (double)ColumnSums[ nPixel ] / (double)( DecimationFactor * DecimationFactor ) - 512.0 ) * 255.0 / 2048.0;
+				( *ppThumbnailData )[ ( nRow / DecimationFactor ) * ThumbnailWidth + nPixel ] =
+								(unsigned char)( ScaledValue < 0.0 ? 0.0 : ( ScaledValue > 255.0 ? 255.0 : ScaledValue ) );
+				}
+		}
+	*pThumbnailWidth = ThumbnailWidth;
+	*pThumbnailHeight = ThumbnailHeight;
+
+	return bNoError;
+}
+
+
+// Measure the previews read per second, and the longest time the user interface thread spends
+// looking up a preview while the reader thread is busy.
+static void TestThumbnailThroughput()
+{
+	BOOL					bNoError = TRUE;
+	THUMBNAIL				Thumbnail;
+	char					SOPInstanceUID[ THUMBNAIL_UID_STRING_LENGTH ];
+	unsigned long			nImage;
+	unsigned long			nPixel;
+	unsigned long			RandomValue;
+	LARGE_INTEGER			CounterFrequency;
+	LARGE_INTEGER			StartTime;
+	LARGE_INTEGER			LookupStartTime;
+	LARGE_INTEGER			EndTime;
+	double					ElapsedSeconds;
+	double					LookupSeconds;
+	double					LongestLookupSeconds;
+	THUMBNAIL_CACHE_STATISTICS	Statistics;
+
+	pBenchmarkImage = (unsigned short*)malloc( BENCHMARK_IMAGE_WIDTH * BENCHMARK_IMAGE_HEIGHT * sizeof(unsigned short) );
+	bNoError = ( pBenchmarkImage != 0 );
+	RandomValue = 12345;
+	for ( nPixel = 0; bNoError && nPixel < BENCHMARK_IMAGE_WIDTH * BENCHMARK_IMAGE_HEIGHT; nPixel++ )
+		{
+		RandomValue = ( RandomValue * 1103515245 + 12345 ) & 0x7FFFFFFF;
+		pBenchmarkImage[ nPixel ] = (unsigned short)( ( RandomValue >> 16 ) & 0x0fff );
+		}
+	bNoError = ( bNoError && StartTestThumbnailCache( ReadBenchmarkThumbnail ) );
+	QueryPerformanceFrequency( &CounterFrequency );
+	LongestLookupSeconds = 0.0;
+	QueryPerformanceCounter( &StartTime );
+	for ( nImage = 0; bNoError && nImage < BENCHMARK_THUMBNAIL_COUNT; nImage++ )
+		{
+		// Request a screen of rows at a time, then keep painting it until the previews are in.
+		MakeTestThumbnailUID( SOPInstanceUID, nImage );
+		QueryPerformanceCounter( &LookupStartTime );
+		LookUpThumbnail( SOPInstanceUID, &Thumbnail );
+		QueryPerformanceCounter( &EndTime );
+		LookupSeconds = (double)( EndTime.QuadPart - LookupStartTime.QuadPart ) / (double)CounterFrequency.QuadPart;
+		if ( LookupSeconds > LongestLookupSeconds )
+			LongestLookupSeconds = LookupSeconds;
+		if ( nImage % 32 == 31 )
+			bNoError = WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT * 3 );
+		}
+	bNoError = ( bNoError && WaitForThumbnailRequests( TEST_THUMBNAIL_WAIT_TIMEOUT * 3 ) );
+	QueryPerformanceCounter( &EndTime );
+	ElapsedSeconds = (double)( EndTime.QuadPart - StartTime.QuadPart ) / (double)CounterFrequency.QuadPart;
+	GetThumbnailCacheStatistics( &Statistics );
+	CheckTestResult( bNoError && Statistics.nThumbnailsRead == BENCHMARK_THUMBNAIL_COUNT,
+						"256 previews of 1536 x 1920 images are read on the reader thread." );
+	if ( bNoError )
+		printf( "    %d previews were read in %.0f ms (%.0f previews/s).  The longest lookup took %.3f ms.\n",
+					BENCHMARK_THUMBNAIL_COUNT, ElapsedSeconds * 1000.0, (double)BENCHMARK_THUMBNAIL_COUNT / ( ElapsedSeconds > 0.0 ? ElapsedSeconds : 1.0 ),
+					LongestLookupSeconds * 1000.0 );
+	CloseThumbnailCache();
+	if ( pBenchmarkImage != 0 )
+		free( pBenchmarkImage );
+	pBenchmarkImage = 0;
+}
+
+
+void TestThumbnailCache()
+{
+	TestThumbnailRequests();
+	TestDroppedThumbnailRequests();
+	TestThumbnailCacheCapacity();
+	TestThumbnailCacheFile();
+	TestThumbnailThroughput();
+}
+